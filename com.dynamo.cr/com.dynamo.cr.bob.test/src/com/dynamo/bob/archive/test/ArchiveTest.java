@@ -27,7 +27,11 @@ import java.nio.file.Files;
 import java.nio.file.Path;
 import java.nio.file.Paths;
 import java.util.ArrayList;
+import java.util.HashMap;
+import java.util.HashSet;
 import java.util.List;
+import java.util.Map;
+import java.util.Set;
 
 import org.apache.commons.io.FileUtils;
 import org.apache.commons.io.FilenameUtils;
@@ -472,5 +476,98 @@ public class ArchiveTest {
         assertEquals("/main.collectionc", instance.getArchiveEntry(1).getRelativeFilename());         // b32b3904944e63ed5a269caa47904645
     }
 
+    private ArchiveBuilder writeUncompressedArchive(List<String> files, List<String> loadOrder) throws IOException, CompileExceptionError {
+        ArchiveBuilder instance = new ArchiveBuilder(FilenameUtils.separatorsToSystem(contentRoot), manifestBuilder, 1);
+        if (loadOrder != null) {
+            instance.setLoadOrder(loadOrder);
+        }
+        for (String file : files) {
+            instance.add(file);
+        }
+        RandomAccessFile outFileIndex = new RandomAccessFile(outputIndex, "rw");
+        RandomAccessFile outFileData = new RandomAccessFile(outputData, "rw");
+        outFileIndex.setLength(0);
+        outFileData.setLength(0);
+        instance.write(outFileIndex, outFileData, resourcePackDir, new ArrayList<String>());
+        outFileIndex.close();
+        outFileData.close();
+        return instance;
+    }
+
+    // Replays the loads against the archive data layout. Returns the number of seeks and the number of bytes read
+    private long[] replayLoads(ArchiveBuilder instance, List<String> loads) {
+        Map<String, ArchiveEntry> entries = new HashMap<String, ArchiveEntry>();
+        for (int i = 0; i < instance.getArchiveEntrySize(); ++i) {
+            ArchiveEntry entry = instance.getArchiveEntry(i);
+            entries.put(entry.getRelativeFilename(), entry);
+        }
+
+        Set<String> loaded = new HashSet<String>();
+        long seeks = 0;
+        long bytesRead = 0;
+        long position = -1;
+        for (String path : loads) {
+            if (!loaded.add(path)) {
+                continue; // Resources are only loaded once
+            }
+            ArchiveEntry entry = entries.get(path);
+            if (entry.getResourceOffset() != position) {
+                ++seeks;
+            }
+            bytesRead += entry.getSize();
+            position = entry.getResourceOffset() + entry.getSize();
+        }
+        return new long[] { seeks, bytesRead };
+    }
+
+    @Test
+    public void testLoadOrder() throws Exception {
+        List<String> files = new ArrayList<String>();
+        for (int i = 0; i < 32; ++i) {
+            String content = "resource" + Integer.toString(i) + new String(new char[i * 13]).replace('\0', 'x');
+            files.add(FilenameUtils.separatorsToSystem(createDummyFile(contentRoot, String.format("level%d/res%02d.txt", i % 3, i), content.getBytes())));
+        }
+
+        // A load of the first level, followed by a load of the second level which shares some of the resources
+        List<String> loads = new ArrayList<String>();
+        loads.add("# level 1");
+        for (int i = 0; i < 20; ++i) {
+            loads.add(String.format("/level%d/res%02d.txt", ((i * 7) % 20) % 3, (i * 7) % 20));
+        }
+        loads.add("# level 2");
+        for (int i = 31; i >= 10; --i) {
+            loads.add(String.format("/level%d/res%02d.txt", i % 3, i));
+        }
+
+        List<String> replayed = new ArrayList<String>();
+        for (String load : loads) {
+            if (!load.startsWith("#")) {
+                replayed.add(load);
+            }
+        }
 
+        long[] defaultLayout = replayLoads(writeUncompressedArchive(files, null), replayed);
+        long[] loadOrderLayout = replayLoads(writeUncompressedArchive(files, loads), replayed);
+
+        System.out.printf("Replayed %d loads: default layout %d seeks, load order layout %d seeks, %d bytes read%n",
+            replayed.size(), defaultLayout[0], loadOrderLayout[0], loadOrderLayout[1]);
+
+        assertEquals(defaultLayout[1], loadOrderLayout[1]);
+        assertEquals(1, loadOrderLayout[0]);
+        assertTrue(defaultLayout[0] > loadOrderLayout[0]);
+
+        // Resources that aren't in the load order are written after the loaded ones
+        ArchiveBuilder instance = writeUncompressedArchive(files, loads.subList(0, 3));
+        int maxLoadedOffset = -1;
+        int minOtherOffset = Integer.MAX_VALUE;
+        for (int i = 0; i < instance.getArchiveEntrySize(); ++i) {
+            ArchiveEntry entry = instance.getArchiveEntry(i);
+            if (loads.subList(0, 3).contains(entry.getRelativeFilename())) {
+                maxLoadedOffset = Math.max(maxLoadedOffset, entry.getResourceOffset());
+            } else {
+                minOtherOffset = Math.min(minOtherOffset, entry.getResourceOffset());
+            }
+        }
+        assertTrue(maxLoadedOffset < minOtherOffset);
+    }
 }
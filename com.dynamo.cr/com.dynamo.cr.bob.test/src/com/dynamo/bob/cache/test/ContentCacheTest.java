@@ -0,0 +1,127 @@
+// Copyright 2020-2024 The Defold Foundation
+// Copyright 2014-2020 King
+// Copyright 2009-2014 Ragnar Svensson, Christian Murray
+// Licensed under the Defold License version 1.0 (the "License"); you may not use
+// this file except in compliance with the License.
+//
+// You may obtain a copy of the License, together with FAQs at
+// https://www.defold.com/license
+//
+// Unless required by applicable law or agreed to in writing, software distributed
+// under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+// CONDITIONS OF ANY KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations under the License.
+
+package com.dynamo.bob.cache.test;
+
+import static org.junit.Assert.assertArrayEquals;
+import static org.junit.Assert.assertEquals;
+import static org.junit.Assert.assertNotEquals;
+import static org.junit.Assert.assertTrue;
+
+import java.io.File;
+import java.io.IOException;
+import java.nio.file.Files;
+import java.nio.file.Path;
+import java.security.MessageDigest;
+
+import org.junit.Before;
+import org.junit.Test;
+
+import com.dynamo.bob.cache.ContentCache;
+
+
+public class ContentCacheTest {
+
+	private Path cacheDir;
+
+	@Before
+	public void setUp() throws Exception {
+		cacheDir = Files.createTempDirectory(null);
+	}
+
+	private static String key(String content) {
+		MessageDigest digest = ContentCache.createDigest("test", 1);
+		digest.update(content.getBytes());
+		return ContentCache.calculateKey(digest);
+	}
+
+	// keys depend on the content, the kind and the version
+	@Test
+	public void testKeys() {
+		assertEquals(key("a"), key("a"));
+		assertNotEquals(key("a"), key("b"));
+
+		MessageDigest digest = ContentCache.createDigest("test", 2);
+		digest.update("a".getBytes());
+		assertNotEquals(key("a"), ContentCache.calculateKey(digest));
+	}
+
+	// entries can be read back, and hits and misses are counted
+	@Test
+	public void testGetAndPut() throws IOException {
+		ContentCache cache = new ContentCache(cacheDir.toString(), 1024 * 1024);
+		final String key = key("somekey");
+		final byte[] data = "somedata".getBytes();
+
+		assertTrue(cache.get(key) == null);
+		cache.put(key, data);
+		assertArrayEquals(data, cache.get(key));
+		assertEquals(1, cache.getHits());
+		assertEquals(1, cache.getMisses());
+
+		// a rejected entry is removed and counted as a miss
+		cache.reject(key);
+		assertEquals(0, cache.getHits());
+		assertEquals(2, cache.getMisses());
+		assertTrue(cache.get(key) == null);
+	}
+
+	// entries are shared between cache instances using the same directory
+	@Test
+	public void testShared() throws IOException {
+		ContentCache cache1 = new ContentCache(cacheDir.toString(), 1024 * 1024);
+		ContentCache cache2 = new ContentCache(cacheDir.toString(), 1024 * 1024);
+		final String key = key("somekey");
+		final byte[] data = "somedata".getBytes();
+
+		cache1.put(key, data);
+		cache2.put(key, data);
+		assertArrayEquals(data, cache2.get(key));
+
+		// no temporary files are left behind
+		File[] dirs = cacheDir.toFile().listFiles();
+		for (File dir : dirs) {
+			if (dir.isDirectory()) {
+				for (File file : dir.listFiles()) {
+					assertEquals(key, file.getName());
+				}
+			}
+		}
+	}
+
+	// the least recently used entries are evicted when the cache is too large
+	@Test
+	public void testTrim() throws IOException {
+		ContentCache cache = new ContentCache(cacheDir.toString(), 3000);
+		final byte[] data = new byte[1000];
+		final String[] keys = { key("0"), key("1"), key("2"), key("3") };
+
+		long time = System.currentTimeMillis() - 100000;
+		for (int i = 0; i < keys.length; ++i) {
+			cache.put(keys[i], data);
+			File file = new File(new File(cacheDir.toFile(), keys[i].substring(0, 2)), keys[i]);
+			file.setLastModified(time + i * 1000);
+		}
+
+		// using an entry makes it the most recently used
+		assertArrayEquals(data, cache.get(keys[0]));
+
+		cache.trim();
+
+		assertTrue(cache.get(keys[1]) == null);
+		assertTrue(cache.get(keys[2]) == null);
+		assertArrayEquals(data, cache.get(keys[0]));
+		assertArrayEquals(data, cache.get(keys[3]));
+	}
+}
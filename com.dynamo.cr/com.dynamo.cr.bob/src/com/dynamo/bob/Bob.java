@@ -569,6 +569,7 @@ public class Bob {
                 opt(null, "use-uncompressed-lua-source", ZERO, "Use uncompressed and unencrypted Lua source code instead of byte code", true),
                 opt(null, "use-lua-bytecode-delta", ZERO, "Use byte code delta compression when building for multiple architectures", true),
                 opt(null, "archive-resource-padding", ONE, "The alignment of the resources in the game archive. Default is 4", true),
+                opt(null, "archive-load-order", ONE, ABS_OR_CWD_REL_PATH, "Path to a file with the resources in the order they are loaded, one path per line. The game archive data is written in this order", true),
 
                 opt("l", "liveupdate", ONE, "Yes if liveupdate content should be published", true),
 
@@ -587,6 +588,9 @@ public class Bob {
                 opt(null, "resource-cache-remote-user", ONE, "Username to authenticate access to the remote resource cache", false),
                 opt(null, "resource-cache-remote-pass", ONE, "Password/token to authenticate access to the remote resource cache", false),
 
+                opt(null, "content-cache", ONE, ABS_OR_CWD_REL_PATH, "Path to a local cache of compiled textures and models, which can be shared between projects and bob processes", false),
+                opt(null, "content-cache-max-size", ONE, "Max size in megabytes of the content cache. Default is 2048", false),
+
                 opt(null, "manifest-private-key", ONE, "Private key to use when signing manifest and archive", false),
                 opt(null, "manifest-public-key", ONE, "Public key to use when signing manifest and archive", false),
 
@@ -105,6 +105,7 @@ import com.dynamo.bob.util.TimeProfiler;
 import com.dynamo.bob.util.StringUtil;
 import com.dynamo.graphics.proto.Graphics.TextureProfiles;
 
+import com.dynamo.bob.cache.ContentCache;
 import com.dynamo.bob.cache.ResourceCache;
 import com.dynamo.bob.cache.ResourceCacheKey;
 import org.jagatoo.util.timing.Time;
@@ -131,6 +132,7 @@ public class Project {
 
     private ExecutorService executor = Executors.newCachedThreadPool();
     private ResourceCache resourceCache = new ResourceCache();
+    private ContentCache contentCache = null;
     private IFileSystem fileSystem;
     private Map<String, Class<? extends Builder>> extToBuilder = new HashMap<String, Class<? extends Builder>>();
     private Map<String, String> inextToOutext = new HashMap<>();
@@ -238,6 +240,23 @@ public class Project {
         return option("resource-cache-remote-pass", getSystemEnv("DM_BOB_RESOURCE_CACHE_REMOTE_PASS"));
     }
 
+    public String getContentCacheDirectory() {
+        return option("content-cache", null);
+    }
+
+    public long getContentCacheMaxSize() {
+        // In megabytes
+        return Long.parseLong(option("content-cache-max-size", "2048")) * 1024 * 1024;
+    }
+
+    /**
+     * Get the cache of texc and modelc outputs
+     * @return The cache, or null if no content cache directory was specified
+     */
+    public ContentCache getContentCache() {
+        return contentCache;
+    }
+
     public int getMaxCpuThreads() {
         String maxThreadsOpt = option("max-cpu-threads", null);
         if (maxThreadsOpt == null) {
@@ -1596,6 +1615,9 @@ public class Project {
         TimeProfiler.start("Prepare cache");
         resourceCache.init(getLocalResourceCacheDirectory(), getRemoteResourceCacheDirectory());
         resourceCache.setRemoteAuthentication(getRemoteResourceCacheUser(), getRemoteResourceCachePass());
+        String contentCacheDir = getContentCacheDirectory();
+        contentCache = contentCacheDir != null ? new ContentCache(contentCacheDir, getContentCacheMaxSize()) : null;
+        TextureGenerator.contentCache = contentCache;
         fileSystem.loadCache();
         IResource stateResource = fileSystem.get(FilenameUtils.concat(buildDirectory, "_BobBuildState_"));
         state = State.load(stateResource);
@@ -1718,6 +1740,10 @@ public class Project {
         TimeProfiler.start("Save cache");
         state.save(stateResource);
         fileSystem.saveCache();
+        if (contentCache != null) {
+            contentCache.logStatistics();
+            contentCache.trim();
+        }
         TimeProfiler.stop();
         return result;
     }
@@ -28,6 +28,7 @@ import java.security.NoSuchAlgorithmException;
 import java.util.ArrayList;
 import java.util.Arrays;
 import java.util.Collections;
+import java.util.Comparator;
 import java.util.List;
 import java.util.HashSet;
 import java.util.Set;
@@ -71,6 +72,7 @@ public class ArchiveBuilder {
     private byte[] archiveIndexMD5 = new byte[MD5_HASH_DIGEST_BYTE_LENGTH];
     private int resourcePadding = 4;
     private boolean forceCompression = false; // for building unit tests to create test content
+    private Map<String, Integer> loadOrder = null; // Relative path -> position of the first load
 
     public ArchiveBuilder(String root, ManifestBuilder manifestBuilder, int resourcePadding) {
         this.root = new File(root).getAbsolutePath();
@@ -155,6 +157,54 @@ public class ArchiveBuilder {
     }
 
 
+    /**
+     * Set the order in which the resources are loaded, e.g from a load trace
+     * recorded while playing the game. The archive data is written in this
+     * order, so that loading the resources reads the data file sequentially.
+     * Resources that aren't in the list are written after the listed ones.
+     * @param paths Relative paths of the resources, in the order they are loaded. Only the first occurrence of a path is used
+     */
+    public void setLoadOrder(List<String> paths) {
+        loadOrder = new HashMap<String, Integer>();
+        for (String path : paths) {
+            path = FilenameUtils.separatorsToUnix(path.trim());
+            if (path.isEmpty() || path.startsWith("#")) {
+                continue;
+            }
+            if (!path.startsWith("/")) {
+                path = "/" + path;
+            }
+            loadOrder.putIfAbsent(path, loadOrder.size());
+        }
+    }
+
+    /**
+     * Read a load order from a file with one path per line. Lines starting
+     * with '#' are ignored.
+     * @param file The file to read
+     */
+    public void setLoadOrder(File file) throws IOException {
+        setLoadOrder(Files.readAllLines(file.toPath()));
+    }
+
+    // The order to write the data in. By default the entries are written in reverse path order
+    private List<ArchiveEntry> getWriteOrder() {
+        List<ArchiveEntry> order = new ArrayList<ArchiveEntry>(entries);
+        Collections.reverse(order);
+        if (loadOrder != null) {
+            // The sort is stable, so the resources that were never loaded keep the default order
+            Collections.sort(order, new Comparator<ArchiveEntry>() {
+                @Override
+                public int compare(ArchiveEntry a, ArchiveEntry b) {
+                    int ia = loadOrder.getOrDefault(FilenameUtils.separatorsToUnix(a.getRelativeFilename()), Integer.MAX_VALUE);
+                    int ib = loadOrder.getOrDefault(FilenameUtils.separatorsToUnix(b.getRelativeFilename()), Integer.MAX_VALUE);
+                    return Integer.compare(ia, ib);
+                }
+            });
+        }
+        return order;
+    }
+
     public List<ArchiveEntry> getExcludedEntries() {
         return excludedEntries;
     }
@@ -174,9 +224,8 @@ public class ArchiveBuilder {
 
         Collections.sort(entries); // Since it has no hash, it sorts on path
 
-        for (int i = entries.size() - 1; i >= 0; --i) {
+        for (ArchiveEntry entry : getWriteOrder()) {
             TimeProfiler.start("Write file");
-            ArchiveEntry entry = entries.get(i);
             TimeProfiler.addData("res", entry.getFilename());
 
             byte[] buffer = this.loadResourceData(entry.getFilename());
@@ -230,7 +279,6 @@ public class ArchiveBuilder {
             // Write resource to resource pack or data archive
             if (excludedResources.contains(normalisedPath)) {
                 this.writeResourcePack(entry, resourcePackDirectory.toString(), buffer);
-                entries.remove(i);
                 excludedEntries.add(entry);
                 resourceEntryFlags |= ResourceEntryFlag.EXCLUDED.getNumber();
             } else {
@@ -245,6 +293,7 @@ public class ArchiveBuilder {
             TimeProfiler.stop();
         }
 
+        entries.removeAll(excludedEntries);
         Collections.sort(entries); // Since it has a hash, it sorts on hash
 
         // Write sorted hashes to index file
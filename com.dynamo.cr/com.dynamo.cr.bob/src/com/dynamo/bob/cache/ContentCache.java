@@ -0,0 +1,278 @@
+// Copyright 2020-2024 The Defold Foundation
+// Copyright 2014-2020 King
+// Copyright 2009-2014 Ragnar Svensson, Christian Murray
+// Licensed under the Defold License version 1.0 (the "License"); you may not use
+// this file except in compliance with the License.
+//
+// You may obtain a copy of the License, together with FAQs at
+// https://www.defold.com/license
+//
+// Unless required by applicable law or agreed to in writing, software distributed
+// under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+// CONDITIONS OF ANY KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations under the License.
+
+package com.dynamo.bob.cache;
+
+import java.io.File;
+import java.io.IOException;
+import java.math.BigInteger;
+import java.nio.channels.FileChannel;
+import java.nio.channels.FileLock;
+import java.nio.file.AtomicMoveNotSupportedException;
+import java.nio.file.Files;
+import java.nio.file.Path;
+import java.nio.file.StandardCopyOption;
+import java.nio.file.StandardOpenOption;
+import java.security.MessageDigest;
+import java.security.NoSuchAlgorithmException;
+import java.util.ArrayList;
+import java.util.Collections;
+import java.util.Comparator;
+import java.util.List;
+import java.util.concurrent.atomic.AtomicLong;
+
+import com.dynamo.bob.archive.EngineVersion;
+import com.dynamo.bob.logging.Logger;
+
+/**
+ * Local on-disk cache for the outputs of the native texture and model
+ * compilers (texc and modelc).
+ *
+ * Entries are keyed by a hash of the input bytes and all parameters that
+ * affect the output, so identical inputs share an entry regardless of
+ * which resource or project they come from. The cache directory may be
+ * shared by several bob processes on the same machine:
+ * - entries are written to a temporary file and atomically renamed
+ * - the size is bounded by evicting the least recently used entries,
+ *   while holding a lock file so that only one process evicts at a time
+ * A missing or unreadable entry is always treated as a cache miss.
+ */
+public class ContentCache {
+
+	private static Logger logger = Logger.getLogger(ContentCache.class.getName());
+
+	private static final String LOCK_FILE = ".lock";
+	private static final String TMP_SUFFIX = ".tmp";
+	// Temporary files older than this are left overs from crashed processes
+	private static final long STALE_TMP_AGE = 60 * 60 * 1000;
+
+	private File cacheDir;
+
+	private long maxSize;
+
+	private AtomicLong hits = new AtomicLong();
+	private AtomicLong misses = new AtomicLong();
+	private AtomicLong bytesWritten = new AtomicLong();
+
+	/**
+	 * Create a cache
+	 * @param cacheDir Directory of the cache. Created if it doesn't exist
+	 * @param maxSize Max size in bytes of all entries, enforced by trim()
+	 */
+	public ContentCache(String cacheDir, long maxSize) {
+		this.cacheDir = new File(cacheDir);
+		this.maxSize = maxSize;
+		this.cacheDir.mkdirs();
+		logger.fine("Initialising content cache in '%s' with max size %d bytes", cacheDir, maxSize);
+	}
+
+	/**
+	 * Create a digest to calculate an entry key with. The engine version is
+	 * included, so that a new version of a compiler never uses the outputs
+	 * of an older one.
+	 * @param kind The kind of entry, e.g "texc". Entries of different kinds never share keys
+	 * @param version Version of the entry format, bump it when the format or the output changes
+	 * @return The digest
+	 */
+	public static MessageDigest createDigest(String kind, int version) {
+		try {
+			MessageDigest digest = MessageDigest.getInstance("SHA-256");
+			digest.update(kind.getBytes());
+			digest.update(Integer.toString(version).getBytes());
+			digest.update(EngineVersion.sha1.getBytes());
+			return digest;
+		} catch (NoSuchAlgorithmException e) {
+			throw new RuntimeException(e);
+		}
+	}
+
+	/**
+	 * Calculate the entry key from a digest
+	 * @param digest Digest created with createDigest()
+	 * @return The key as a hex string
+	 */
+	public static String calculateKey(MessageDigest digest) {
+		return String.format("%064x", new BigInteger(1, digest.digest()));
+	}
+
+	private File fileFromKey(String key) {
+		// Spread the entries over a number of sub directories, to keep the directories small
+		return new File(new File(cacheDir, key.substring(0, 2)), key);
+	}
+
+	/**
+	 * Get an entry
+	 * @param key Key of the entry
+	 * @return The data of the entry or null if the entry doesn't exist
+	 */
+	public byte[] get(String key) {
+		File file = fileFromKey(key);
+		try {
+			byte[] data = Files.readAllBytes(file.toPath());
+			// Used as the access time when evicting entries
+			file.setLastModified(System.currentTimeMillis());
+			hits.incrementAndGet();
+			return data;
+		} catch (IOException e) {
+			// The entry doesn't exist, or was evicted by another process
+			misses.incrementAndGet();
+			return null;
+		}
+	}
+
+	/**
+	 * Report that an entry which was found couldn't be used (e.g it was
+	 * stale or corrupt), so that it's counted as a miss.
+	 */
+	public void reject(String key) {
+		hits.decrementAndGet();
+		misses.incrementAndGet();
+		fileFromKey(key).delete();
+	}
+
+	/**
+	 * Put an entry. The entry is written to a temporary file which is then
+	 * renamed, so other processes never see a partially written entry.
+	 * Errors are logged and otherwise ignored.
+	 * @param key Key of the entry
+	 * @param data The data to store
+	 */
+	public void put(String key, byte[] data) {
+		File file = fileFromKey(key);
+		Path tmp = null;
+		try {
+			File dir = file.getParentFile();
+			dir.mkdirs();
+			tmp = Files.createTempFile(dir.toPath(), key, TMP_SUFFIX);
+			Files.write(tmp, data);
+			try {
+				Files.move(tmp, file.toPath(), StandardCopyOption.ATOMIC_MOVE, StandardCopyOption.REPLACE_EXISTING);
+			} catch (AtomicMoveNotSupportedException e) {
+				Files.move(tmp, file.toPath(), StandardCopyOption.REPLACE_EXISTING);
+			}
+			tmp = null;
+			bytesWritten.addAndGet(data.length);
+		} catch (IOException e) {
+			logger.warning("Failed to write '%s' to the content cache: %s", file, e.getMessage());
+		} finally {
+			if (tmp != null) {
+				tmp.toFile().delete();
+			}
+		}
+	}
+
+	private static class Entry {
+		File file;
+		long size;
+		long lastModified;
+	}
+
+	/**
+	 * Evict the least recently used entries until the cache is within its
+	 * max size. Does nothing if another process is already trimming the cache.
+	 */
+	public void trim() {
+		File lockFile = new File(cacheDir, LOCK_FILE);
+		try (FileChannel channel = FileChannel.open(lockFile.toPath(), StandardOpenOption.CREATE, StandardOpenOption.WRITE)) {
+			FileLock lock = channel.tryLock();
+			if (lock == null) {
+				return;
+			}
+			try {
+				trimLocked();
+			} finally {
+				lock.release();
+			}
+		} catch (IOException e) {
+			logger.warning("Failed to trim the content cache '%s': %s", cacheDir, e.getMessage());
+		}
+	}
+
+	private void trimLocked() {
+		List<Entry> entries = new ArrayList<Entry>();
+		long totalSize = 0;
+		long now = System.currentTimeMillis();
+
+		File[] dirs = cacheDir.listFiles();
+		if (dirs == null) {
+			return;
+		}
+		for (File dir : dirs) {
+			File[] files = dir.isDirectory() ? dir.listFiles() : null;
+			if (files == null) {
+				continue;
+			}
+			for (File file : files) {
+				long lastModified = file.lastModified();
+				if (file.getName().endsWith(TMP_SUFFIX)) {
+					if (now - lastModified > STALE_TMP_AGE) {
+						file.delete();
+					}
+					continue;
+				}
+				Entry entry = new Entry();
+				entry.file = file;
+				entry.size = file.length();
+				entry.lastModified = lastModified;
+				entries.add(entry);
+				totalSize += entry.size;
+			}
+		}
+
+		if (totalSize <= maxSize) {
+			return;
+		}
+
+		// Evict down to a bit below the max size, so that we don't have to trim again after every build
+		long targetSize = maxSize - maxSize / 10;
+		Collections.sort(entries, new Comparator<Entry>() {
+			@Override
+			public int compare(Entry a, Entry b) {
+				return Long.compare(a.lastModified, b.lastModified);
+			}
+		});
+
+		int evicted = 0;
+		for (Entry entry : entries) {
+			if (totalSize <= targetSize) {
+				break;
+			}
+			if (entry.file.delete()) {
+				totalSize -= entry.size;
+				++evicted;
+			}
+		}
+		logger.fine("Evicted %d entries from the content cache, size is now %d bytes", evicted, totalSize);
+	}
+
+	public long getHits() {
+		return hits.get();
+	}
+
+	public long getMisses() {
+		return misses.get();
+	}
+
+	/**
+	 * Log the hit rate since the cache was created
+	 */
+	public void logStatistics() {
+		long h = hits.get();
+		long m = misses.get();
+		if (h + m == 0) {
+			return;
+		}
+		logger.info("Content cache: %d hits, %d misses (%.1f%% hit rate), %d KB written", h, m, 100.0 * h / (h + m), bytesWritten.get() / 1024);
+	}
+}
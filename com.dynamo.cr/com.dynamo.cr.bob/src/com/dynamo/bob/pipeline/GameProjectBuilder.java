@@ -452,6 +452,10 @@ public class GameProjectBuilder extends Builder {
                 // create the archive and manifest
                 ManifestBuilder manifestBuilder = createManifestBuilder(resourceGraph);
                 ArchiveBuilder archiveBuilder = new ArchiveBuilder(root, manifestBuilder, getResourcePadding());
+                String loadOrderPath = project.option("archive-load-order", null);
+                if (loadOrderPath != null) {
+                    archiveBuilder.setLoadOrder(new File(loadOrderPath));
+                }
                 createArchive(archiveBuilder, resources, archiveIndex, archiveData, excludedResources, resourcePackDirectory);
                 byte[] manifestFile = manifestBuilder.buildManifest();
 
@@ -16,8 +16,12 @@ package com.dynamo.bob.pipeline;
 
 import java.io.ByteArrayInputStream;
 import java.io.ByteArrayOutputStream;
+import java.io.DataInputStream;
+import java.io.DataOutputStream;
 import java.io.File;
+import java.security.MessageDigest;
 import java.util.ArrayList;
+import java.util.List;
 
 import javax.xml.stream.XMLStreamException;
 
@@ -30,6 +34,7 @@ import com.dynamo.bob.BuilderParams;
 import com.dynamo.bob.CompileExceptionError;
 import com.dynamo.bob.Project;
 import com.dynamo.bob.Task;
+import com.dynamo.bob.cache.ContentCache;
 import com.dynamo.bob.fs.IResource;
 
 import com.dynamo.rig.proto.Rig.AnimationSet;
@@ -64,6 +69,103 @@ public class MeshsetBuilder extends Builder  {
         }
     };
 
+    // Bump when the outputs of the builder change, to invalidate the cached outputs
+    private static final int CONTENT_CACHE_VERSION = 1;
+
+    private static byte[] hashData(byte[] data) {
+        MessageDigest digest = ContentCache.createDigest("modelc-data", CONTENT_CACHE_VERSION);
+        if (data != null) {
+            digest.update(data);
+        }
+        return digest.digest();
+    }
+
+    // Records the external data (e.g. .bin buffers) read while loading a model.
+    // The data isn't part of the cache key, so it's stored in the cache entry and verified when the entry is used.
+    private static class RecordingDataResolver implements ModelImporterJni.DataResolver {
+        ModelImporterJni.DataResolver resolver;
+        List<String> uris = new ArrayList<>();
+        List<byte[]> hashes = new ArrayList<>();
+
+        RecordingDataResolver(ModelImporterJni.DataResolver resolver) {
+            this.resolver = resolver;
+        }
+
+        public byte[] getData(String path, String uri) {
+            byte[] data = resolver.getData(path, uri);
+            uris.add(uri);
+            hashes.add(hashData(data));
+            return data;
+        }
+    }
+
+    private static String calculateCacheKey(Task task, String suffix, int split_meshes) throws IOException {
+        MessageDigest digest = ContentCache.createDigest("modelc", CONTENT_CACHE_VERSION);
+        digest.update(task.input(0).getContent());
+        digest.update(String.format("%s %d", suffix, split_meshes).getBytes());
+        return ContentCache.calculateKey(digest);
+    }
+
+    private static void putInContentCache(ContentCache cache, String key, Task task, RecordingDataResolver resolver) throws IOException {
+        ByteArrayOutputStream bytes = new ByteArrayOutputStream(64 * 1024);
+        DataOutputStream out = new DataOutputStream(bytes);
+        out.writeInt(resolver.uris.size());
+        for (int i = 0; i < resolver.uris.size(); ++i) {
+            out.writeUTF(resolver.uris.get(i));
+            out.writeInt(resolver.hashes.get(i).length);
+            out.write(resolver.hashes.get(i));
+        }
+        out.writeInt(task.getOutputs().size());
+        for (IResource output : task.getOutputs()) {
+            byte[] content = output.getContent();
+            out.writeInt(content.length);
+            out.write(content);
+        }
+        out.close();
+        cache.put(key, bytes.toByteArray());
+    }
+
+    // Returns true if the outputs were set from the cache
+    private static boolean getFromContentCache(ContentCache cache, String key, Task task, ModelImporterJni.DataResolver resolver) {
+        byte[] entry = cache.get(key);
+        if (entry == null) {
+            return false;
+        }
+
+        try {
+            DataInputStream in = new DataInputStream(new ByteArrayInputStream(entry));
+            int dataCount = in.readInt();
+            for (int i = 0; i < dataCount; ++i) {
+                String uri = in.readUTF();
+                byte[] hash = new byte[in.readInt()];
+                in.readFully(hash);
+                if (!MessageDigest.isEqual(hash, hashData(resolver.getData(task.input(0).getPath(), uri)))) {
+                    cache.reject(key);
+                    return false;
+                }
+            }
+
+            int outputCount = in.readInt();
+            if (outputCount != task.getOutputs().size()) {
+                cache.reject(key);
+                return false;
+            }
+            byte[][] contents = new byte[outputCount][];
+            for (int i = 0; i < outputCount; ++i) {
+                contents[i] = new byte[in.readInt()];
+                in.readFully(contents[i]);
+            }
+            for (int i = 0; i < outputCount; ++i) {
+                task.output(i).setContent(contents[i]);
+            }
+            return true;
+        } catch (IOException e) {
+            // Corrupt entry
+            cache.reject(key);
+            return false;
+        }
+    }
+
     @Override
     public Task create(IResource input) throws IOException, CompileExceptionError {
         Task.TaskBuilder taskBuilder = Task.newBuilder(this)
@@ -136,8 +238,20 @@ public class MeshsetBuilder extends Builder  {
             return;
         }
 
+        int split_meshes = this.project.getProjectProperties().getIntValue("model", "split_large_meshes", 0);
+
+        ResourceDataResolver resourceDataResolver = new ResourceDataResolver(this.project);
+        ContentCache contentCache = this.project.getContentCache();
+        String cacheKey = null;
+        if (contentCache != null) {
+            cacheKey = calculateCacheKey(task, suffix, split_meshes);
+            if (getFromContentCache(contentCache, cacheKey, task, resourceDataResolver)) {
+                return;
+            }
+        }
+
         Modelimporter.Options options = new Modelimporter.Options();
-        ResourceDataResolver dataResolver = new ResourceDataResolver(this.project);
+        RecordingDataResolver dataResolver = new RecordingDataResolver(resourceDataResolver);
         Modelimporter.Scene scene = ModelUtil.loadScene(task.input(0).getContent(), task.input(0).getPath(), options, dataResolver);
         if (scene == null) {
             throw new CompileExceptionError(task.input(0), -1, "Error loading model");
@@ -147,7 +261,6 @@ public class MeshsetBuilder extends Builder  {
         {
             MeshSet.Builder meshSetBuilder = MeshSet.newBuilder();
 
-            int split_meshes = this.project.getProjectProperties().getIntValue("model", "split_large_meshes", 0);
             if (split_meshes != 0) {
                 ModelUtil.splitMeshes(scene);
             }
@@ -191,5 +304,9 @@ public class MeshsetBuilder extends Builder  {
         }
 
         ModelUtil.unloadScene(scene);
+
+        if (cacheKey != null) {
+            putInContentCache(contentCache, cacheKey, task, dataResolver);
+        }
     }
 }
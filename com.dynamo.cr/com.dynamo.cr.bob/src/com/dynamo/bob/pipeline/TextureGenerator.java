@@ -34,6 +34,7 @@ import java.io.FileOutputStream;
 import java.io.IOException;
 import java.io.InputStream;
 import java.nio.ByteBuffer;
+import java.security.MessageDigest;
 import java.util.HashMap;
 import java.util.EnumSet;
 
@@ -45,6 +46,7 @@ import com.dynamo.bob.TexcLibrary.PixelFormat;
 import com.dynamo.bob.TexcLibrary.CompressionLevel;
 import com.dynamo.bob.TexcLibrary.CompressionType;
 import com.dynamo.bob.TexcLibrary.FlipAxis;
+import com.dynamo.bob.cache.ContentCache;
 import com.dynamo.bob.logging.Logger;
 import com.dynamo.bob.Project;
 import com.dynamo.bob.util.TextureUtil;
@@ -56,6 +58,7 @@ import com.dynamo.graphics.proto.Graphics.TextureFormatAlternative;
 import com.dynamo.graphics.proto.Graphics.TextureImage.Type;
 import com.dynamo.graphics.proto.Graphics.TextureProfile;
 import com.google.protobuf.ByteString;
+import com.google.protobuf.InvalidProtocolBufferException;
 import com.sun.jna.Pointer;
 
 
@@ -64,6 +67,12 @@ public class TextureGenerator {
     // specify what is maximum of threads TextureGenerator may use
     public static int maxThreads = Project.getDefaultMaxCpuThreads();
 
+    // optional cache of generated images, shared between builds
+    public static ContentCache contentCache = null;
+
+    // Bump when the output of the generator changes, to invalidate the cached images
+    private static final int CONTENT_CACHE_VERSION = 1;
+
     private static HashMap<TextureFormatAlternative.CompressionLevel, Integer> compressionLevelLUT = new HashMap<TextureFormatAlternative.CompressionLevel, Integer>();
     static {
         compressionLevelLUT.put(TextureFormatAlternative.CompressionLevel.FAST, CompressionLevel.CL_FAST);
@@ -223,8 +232,32 @@ public class TextureGenerator {
         return byteBuffer;
     }
 
+    private static String calculateCacheKey(BufferedImage image, ColorModel colorModel, TextureFormat textureFormat, TextureFormatAlternative.CompressionLevel compressionLevel, TextureImage.CompressionType compressionType, boolean generateMipMaps, int maxTextureSize, boolean compress, boolean premulAlpha, EnumSet<FlipAxis> flipAxis) {
+        MessageDigest digest = ContentCache.createDigest("texc", CONTENT_CACHE_VERSION);
+        digest.update(getByteBuffer(image).duplicate());
+        String params = String.format("%d %d %d %s %s %s %b %d %b %b %s",
+                image.getWidth(), image.getHeight(), colorModel.getNumComponents(),
+                textureFormat, compressionLevel, compressionType,
+                generateMipMaps, maxTextureSize, compress, premulAlpha, flipAxis);
+        digest.update(params.getBytes());
+        return ContentCache.calculateKey(digest);
+    }
+
     private static TextureImage.Image generateFromColorAndFormat(String name, BufferedImage image, ColorModel colorModel, TextureFormat textureFormat, TextureFormatAlternative.CompressionLevel compressionLevel, TextureImage.CompressionType compressionType, boolean generateMipMaps, int maxTextureSize, boolean compress, boolean premulAlpha, EnumSet<FlipAxis> flipAxis) throws TextureGeneratorException {
 
+        String cacheKey = null;
+        if (contentCache != null) {
+            cacheKey = calculateCacheKey(image, colorModel, textureFormat, compressionLevel, compressionType, generateMipMaps, maxTextureSize, compress, premulAlpha, flipAxis);
+            byte[] cached = contentCache.get(cacheKey);
+            if (cached != null) {
+                try {
+                    return TextureImage.Image.parseFrom(cached);
+                } catch (InvalidProtocolBufferException e) {
+                    contentCache.reject(cacheKey);
+                }
+            }
+        }
+
         int width = image.getWidth();
         int height = image.getHeight();
         int componentCount = colorModel.getNumComponents();
@@ -287,6 +320,7 @@ public class TextureGenerator {
         }
 
         try {
+            TexcLibrary.TEXC_SetMaxThreads(texture, maxThreads);
 
             int newWidth  = image.getWidth();
             int newHeight = image.getHeight();
@@ -408,7 +442,11 @@ public class TextureGenerator {
             raw.setCompressionType(compressionType);
             raw.setCompressionFlags(TexcLibrary.TEXC_GetCompressionFlags(texture));
 
-            return raw.build();
+            TextureImage.Image result = raw.build();
+            if (cacheKey != null) {
+                contentCache.put(cacheKey, result.toByteArray());
+            }
+            return result;
 
         } finally {
             TexcLibrary.TEXC_Destroy(texture);
@@ -17,4 +17,49 @@
 
 #include <dmsdk/dlib/atomic.h>
 
+/**
+ * Load a pointer, with acquire semantics. Reads of the data the pointer was published with
+ * (see dmAtomicStorePtr) are not reordered before the load.
+ * @param ptr Pointer to the pointer to load
+ * @return The current value
+ */
+inline void* dmAtomicGetPtr(void* volatile* ptr)
+{
+#if defined(_MSC_VER) && !defined(__clang__)
+    return InterlockedCompareExchangePointer(ptr, 0, 0);
+#else
+    return __atomic_load_n(ptr, __ATOMIC_ACQUIRE);
+#endif
+}
+
+/**
+ * Store a pointer, with release semantics. Writes made before the store are visible
+ * to a thread that loads the pointer with dmAtomicGetPtr.
+ * @param ptr Pointer to the pointer to store to
+ * @param value The new value
+ */
+inline void dmAtomicStorePtr(void* volatile* ptr, void* value)
+{
+#if defined(_MSC_VER) && !defined(__clang__)
+    InterlockedExchangePointer(ptr, value);
+#else
+    __atomic_store_n(ptr, value, __ATOMIC_RELEASE);
+#endif
+}
+
+/**
+ * Load a 32 bit value, sequentially consistent with the other atomic operations. Unlike dmAtomicGet32
+ * it doesn't write to the value, so threads that read the same value don't contend for it.
+ * @param ptr Pointer to the value to load
+ * @return The current value
+ */
+inline int32_t dmAtomicLoad32(int32_atomic_t* ptr)
+{
+#if defined(_MSC_VER) && !defined(__clang__)
+    return InterlockedCompareExchange((volatile long*) ptr, 0, 0);
+#else
+    return __atomic_load_n(ptr, __ATOMIC_SEQ_CST);
+#endif
+}
+
 #endif //DM_ATOMIC_H
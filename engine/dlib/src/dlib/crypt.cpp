@@ -171,6 +171,9 @@ namespace dmCrypt
 
     void HashSha1(const uint8_t* buf, uint32_t buflen, uint8_t* digest)
     {
+        if (HashSha1Accelerated(buf, buflen, digest))
+            return;
+
         mbedtls_sha1_context ctx;
         mbedtls_sha1_init(&ctx);
         mbedtls_sha1_starts_ret(&ctx);
@@ -184,6 +187,9 @@ namespace dmCrypt
 
     void HashSha256(const uint8_t* buf, uint32_t buflen, uint8_t* digest)
     {
+        if (HashSha256Accelerated(buf, buflen, digest))
+            return;
+
         int ret = mbedtls_sha256_ret((const unsigned char*)buf, (size_t)buflen, (unsigned char*)digest, 0);
         if (ret != 0) {
             memset(digest, 0, 20);
@@ -31,6 +31,24 @@ namespace dmCrypt
      * @return RESULT_OK if decrypting went ok.
      */
     Result Decrypt(const uint8_t* key, uint32_t keylen, const uint8_t* data, uint32_t datalen, uint8_t** output, uint32_t* outputlen);
+
+    /**
+     * Hash a buffer with SHA-1, using the CPU's SHA instructions (SHA-NI on x86, the ARMv8 crypto extensions on arm64)
+     * @param buf The input data
+     * @param buflen
+     * @param digest [out] The 20 byte digest
+     * @return false if the CPU doesn't support the instructions. The digest is then left untouched
+     */
+    bool HashSha1Accelerated(const uint8_t* buf, uint32_t buflen, uint8_t* digest);
+
+    /**
+     * Hash a buffer with SHA-256, using the CPU's SHA instructions (SHA-NI on x86, the ARMv8 crypto extensions on arm64)
+     * @param buf The input data
+     * @param buflen
+     * @param digest [out] The 32 byte digest
+     * @return false if the CPU doesn't support the instructions. The digest is then left untouched
+     */
+    bool HashSha256Accelerated(const uint8_t* buf, uint32_t buflen, uint8_t* digest);
 }
 
 #endif /* DM_CRYPT_H */
@@ -0,0 +1,377 @@
+// Copyright 2020-2024 The Defold Foundation
+// Copyright 2014-2020 King
+// Copyright 2009-2014 Ragnar Svensson, Christian Murray
+// Licensed under the Defold License version 1.0 (the "License"); you may not use
+// this file except in compliance with the License.
+//
+// You may obtain a copy of the License, together with FAQs at
+// https://www.defold.com/license
+//
+// Unless required by applicable law or agreed to in writing, software distributed
+// under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+// CONDITIONS OF ANY KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations under the License.
+
+// Hardware accelerated SHA-1 and SHA-256, used for the digest verification of resources.
+// x86: SHA-NI (detected at runtime)
+// arm64: ARMv8 crypto extensions (when enabled at compile time)
+// If no accelerated version is available, the functions return false and the caller falls back to mbedtls
+
+#include <string.h>
+#include <stdint.h>
+#include "crypt.h"
+
+#if (defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)) && !defined(__EMSCRIPTEN__)
+    #define DM_SHA_X86
+    #include <immintrin.h>
+    #if defined(_MSC_VER)
+        #include <intrin.h>
+    #else
+        #include <cpuid.h>
+    #endif
+    #if defined(__GNUC__) || defined(__clang__)
+        #define DM_SHA_TARGET __attribute__((target("sha,sse4.1,ssse3")))
+    #else
+        #define DM_SHA_TARGET
+    #endif
+#elif (defined(__aarch64__) || defined(_M_ARM64)) && (defined(__ARM_FEATURE_SHA2) || defined(__ARM_FEATURE_CRYPTO))
+    #define DM_SHA_ARM
+    #include <arm_neon.h>
+#endif
+
+namespace dmCrypt
+{
+
+#if defined(DM_SHA_X86) || defined(DM_SHA_ARM)
+
+    static const uint32_t SHA256_K[64] = {
+        0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+        0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+        0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+        0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+        0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+        0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+        0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+        0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2,
+    };
+
+    static const uint32_t SHA256_IV[8] = {
+        0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19,
+    };
+
+    static const uint32_t SHA1_IV[5] = {
+        0x67452301, 0xefcdab89, 0x98badcfe, 0x10325476, 0xc3d2e1f0,
+    };
+
+    typedef void (*ProcessBlocksFn)(uint32_t* state, const uint8_t* data, uint32_t blocks);
+
+    // Processes all full blocks, then pads the tail (0x80, zeros, big endian bit length) into one or two blocks
+    static void HashPadded(ProcessBlocksFn process, uint32_t* state, uint32_t state_count, const uint8_t* buf, uint32_t buflen, uint8_t* digest)
+    {
+        uint32_t full_blocks = buflen / 64;
+        if (full_blocks)
+            process(state, buf, full_blocks);
+
+        uint8_t tail[128];
+        uint32_t rest = buflen - full_blocks * 64;
+        memcpy(tail, buf + full_blocks * 64, rest);
+        tail[rest] = 0x80;
+        uint32_t tail_len = (rest + 9 <= 64) ? 64 : 128;
+        memset(tail + rest + 1, 0, tail_len - rest - 1);
+        uint64_t bit_len = (uint64_t)buflen * 8;
+        for (uint32_t i = 0; i < 8; ++i)
+        {
+            tail[tail_len - 1 - i] = (uint8_t)(bit_len >> (8 * i));
+        }
+        process(state, tail, tail_len / 64);
+
+        for (uint32_t i = 0; i < state_count; ++i)
+        {
+            digest[i * 4 + 0] = (uint8_t)(state[i] >> 24);
+            digest[i * 4 + 1] = (uint8_t)(state[i] >> 16);
+            digest[i * 4 + 2] = (uint8_t)(state[i] >> 8);
+            digest[i * 4 + 3] = (uint8_t)(state[i]);
+        }
+    }
+
+#endif
+
+#if defined(DM_SHA_X86)
+
+    static bool DetectShaExtensions()
+    {
+        uint32_t leaf1_ecx = 0;
+        uint32_t leaf7_ebx = 0;
+#if defined(_MSC_VER)
+        int regs[4];
+        __cpuid(regs, 0);
+        if (regs[0] < 7)
+            return false;
+        __cpuid(regs, 1);
+        leaf1_ecx = (uint32_t)regs[2];
+        __cpuidex(regs, 7, 0);
+        leaf7_ebx = (uint32_t)regs[1];
+#else
+        unsigned int eax, ebx, ecx, edx;
+        if (__get_cpuid_max(0, 0) < 7)
+            return false;
+        __cpuid(1, eax, ebx, ecx, edx);
+        leaf1_ecx = ecx;
+        __cpuid_count(7, 0, eax, ebx, ecx, edx);
+        leaf7_ebx = ebx;
+#endif
+        bool ssse3 = (leaf1_ecx & (1u << 9)) != 0;
+        bool sse41 = (leaf1_ecx & (1u << 19)) != 0;
+        bool sha   = (leaf7_ebx & (1u << 29)) != 0;
+        return ssse3 && sse41 && sha;
+    }
+
+    static bool HasShaExtensions()
+    {
+        // -1: not checked yet. Racing threads will all write the same value
+        static volatile int g_HasSha = -1;
+        if (g_HasSha < 0)
+            g_HasSha = DetectShaExtensions() ? 1 : 0;
+        return g_HasSha == 1;
+    }
+
+    DM_SHA_TARGET static void Sha256ProcessBlocks(uint32_t* state, const uint8_t* data, uint32_t blocks)
+    {
+        const __m128i shuffle_mask = _mm_set_epi64x(0x0c0d0e0f08090a0bULL, 0x0405060700010203ULL);
+
+        // The rounds instruction wants the state as ABEF and CDGH
+        __m128i tmp    = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i*)&state[0]), 0xB1); // CDAB
+        __m128i state1 = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i*)&state[4]), 0x1B); // EFGH
+        __m128i state0 = _mm_alignr_epi8(tmp, state1, 8);                                      // ABEF
+        state1 = _mm_blend_epi16(state1, tmp, 0xF0);                                           // CDGH
+
+        for (uint32_t b = 0; b < blocks; ++b, data += 64)
+        {
+            __m128i abef_save = state0;
+            __m128i cdgh_save = state1;
+
+            __m128i msg[4];
+            for (int i = 0; i < 4; ++i)
+            {
+                msg[i] = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(data + 16 * i)), shuffle_mask);
+            }
+
+            // 16 groups of 4 rounds. msg[i&3] holds W[4i..4i+3], and is replaced by W[4i+16..4i+19] after use
+            for (int i = 0; i < 16; ++i)
+            {
+                __m128i m = _mm_add_epi32(msg[i & 3], _mm_loadu_si128((const __m128i*)&SHA256_K[4 * i]));
+                state1 = _mm_sha256rnds2_epu32(state1, state0, m);
+                state0 = _mm_sha256rnds2_epu32(state0, state1, _mm_shuffle_epi32(m, 0x0E));
+
+                if (i < 12)
+                {
+                    __m128i w = _mm_sha256msg1_epu32(msg[i & 3], msg[(i + 1) & 3]);
+                    w = _mm_add_epi32(w, _mm_alignr_epi8(msg[(i + 3) & 3], msg[(i + 2) & 3], 4));
+                    msg[i & 3] = _mm_sha256msg2_epu32(w, msg[(i + 3) & 3]);
+                }
+            }
+
+            state0 = _mm_add_epi32(state0, abef_save);
+            state1 = _mm_add_epi32(state1, cdgh_save);
+        }
+
+        tmp    = _mm_shuffle_epi32(state0, 0x1B);      // FEBA
+        state1 = _mm_shuffle_epi32(state1, 0xB1);      // DCHG
+        state0 = _mm_blend_epi16(tmp, state1, 0xF0);   // DCBA
+        state1 = _mm_alignr_epi8(state1, tmp, 8);      // HGFE
+        _mm_storeu_si128((__m128i*)&state[0], state0);
+        _mm_storeu_si128((__m128i*)&state[4], state1);
+    }
+
+    // One group of 4 rounds. FUNC is the round function selector, which has to be an immediate.
+    // The E value alternates between e0 and e1, and msg[j&3] holds W[4j..4j+3]
+    template <int FUNC>
+    DM_SHA_TARGET static inline void Sha1Group(int j, __m128i& abcd, __m128i& e0, __m128i& e1, __m128i* msg)
+    {
+        __m128i w = msg[j & 3];
+        if (j & 1)
+        {
+            e1 = _mm_sha1nexte_epu32(e1, w);
+            e0 = abcd;
+            abcd = _mm_sha1rnds4_epu32(abcd, e1, FUNC);
+        }
+        else
+        {
+            e0 = (j == 0) ? _mm_add_epi32(e0, w) : _mm_sha1nexte_epu32(e0, w);
+            e1 = abcd;
+            abcd = _mm_sha1rnds4_epu32(abcd, e0, FUNC);
+        }
+
+        if (j >= 3 && j <= 18)
+            msg[(j + 1) & 3] = _mm_sha1msg2_epu32(msg[(j + 1) & 3], w);
+        if (j >= 1 && j <= 16)
+            msg[(j - 1) & 3] = _mm_sha1msg1_epu32(msg[(j - 1) & 3], w);
+        if (j >= 2 && j <= 17)
+            msg[(j - 2) & 3] = _mm_xor_si128(msg[(j - 2) & 3], w);
+    }
+
+    DM_SHA_TARGET static void Sha1ProcessBlocks(uint32_t* state, const uint8_t* data, uint32_t blocks)
+    {
+        const __m128i shuffle_mask = _mm_set_epi64x(0x0001020304050607ULL, 0x08090a0b0c0d0e0fULL);
+
+        __m128i abcd = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i*)state), 0x1B);
+        __m128i e0   = _mm_set_epi32((int)state[4], 0, 0, 0);
+        __m128i e1   = _mm_setzero_si128();
+
+        for (uint32_t b = 0; b < blocks; ++b, data += 64)
+        {
+            __m128i abcd_save = abcd;
+            __m128i e0_save = e0;
+
+            __m128i msg[4];
+            for (int i = 0; i < 4; ++i)
+            {
+                msg[i] = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(data + 16 * i)), shuffle_mask);
+            }
+
+            // Written out, so that all the conditions in Sha1Group are resolved at compile time
+            Sha1Group<0>(0, abcd, e0, e1, msg);  Sha1Group<0>(1, abcd, e0, e1, msg);
+            Sha1Group<0>(2, abcd, e0, e1, msg);  Sha1Group<0>(3, abcd, e0, e1, msg);
+            Sha1Group<0>(4, abcd, e0, e1, msg);  Sha1Group<1>(5, abcd, e0, e1, msg);
+            Sha1Group<1>(6, abcd, e0, e1, msg);  Sha1Group<1>(7, abcd, e0, e1, msg);
+            Sha1Group<1>(8, abcd, e0, e1, msg);  Sha1Group<1>(9, abcd, e0, e1, msg);
+            Sha1Group<2>(10, abcd, e0, e1, msg); Sha1Group<2>(11, abcd, e0, e1, msg);
+            Sha1Group<2>(12, abcd, e0, e1, msg); Sha1Group<2>(13, abcd, e0, e1, msg);
+            Sha1Group<2>(14, abcd, e0, e1, msg); Sha1Group<3>(15, abcd, e0, e1, msg);
+            Sha1Group<3>(16, abcd, e0, e1, msg); Sha1Group<3>(17, abcd, e0, e1, msg);
+            Sha1Group<3>(18, abcd, e0, e1, msg); Sha1Group<3>(19, abcd, e0, e1, msg);
+
+            e0 = _mm_sha1nexte_epu32(e0, e0_save);
+            abcd = _mm_add_epi32(abcd, abcd_save);
+        }
+
+        abcd = _mm_shuffle_epi32(abcd, 0x1B);
+        _mm_storeu_si128((__m128i*)state, abcd);
+        state[4] = (uint32_t)_mm_extract_epi32(e0, 3);
+    }
+
+#elif defined(DM_SHA_ARM)
+
+    static bool HasShaExtensions()
+    {
+        return true;
+    }
+
+    static void Sha256ProcessBlocks(uint32_t* state, const uint8_t* data, uint32_t blocks)
+    {
+        uint32x4_t state0 = vld1q_u32(&state[0]);
+        uint32x4_t state1 = vld1q_u32(&state[4]);
+
+        for (uint32_t b = 0; b < blocks; ++b, data += 64)
+        {
+            uint32x4_t abcd_save = state0;
+            uint32x4_t efgh_save = state1;
+
+            uint32x4_t msg[4];
+            for (int i = 0; i < 4; ++i)
+            {
+                msg[i] = vreinterpretq_u32_u8(vrev32q_u8(vld1q_u8(data + 16 * i)));
+            }
+
+            for (int i = 0; i < 16; ++i)
+            {
+                uint32x4_t m = vaddq_u32(msg[i & 3], vld1q_u32(&SHA256_K[4 * i]));
+                uint32x4_t tmp = state0;
+                state0 = vsha256hq_u32(state0, state1, m);
+                state1 = vsha256h2q_u32(state1, tmp, m);
+
+                if (i < 12)
+                    msg[i & 3] = vsha256su1q_u32(vsha256su0q_u32(msg[i & 3], msg[(i + 1) & 3]), msg[(i + 2) & 3], msg[(i + 3) & 3]);
+            }
+
+            state0 = vaddq_u32(state0, abcd_save);
+            state1 = vaddq_u32(state1, efgh_save);
+        }
+
+        vst1q_u32(&state[0], state0);
+        vst1q_u32(&state[4], state1);
+    }
+
+    static void Sha1ProcessBlocks(uint32_t* state, const uint8_t* data, uint32_t blocks)
+    {
+        static const uint32_t K[4] = { 0x5a827999, 0x6ed9eba1, 0x8f1bbcdc, 0xca62c1d6 };
+
+        uint32x4_t abcd = vld1q_u32(state);
+        uint32_t e0 = state[4];
+
+        for (uint32_t b = 0; b < blocks; ++b, data += 64)
+        {
+            uint32x4_t abcd_save = abcd;
+            uint32_t e0_save = e0;
+
+            uint32x4_t msg[4];
+            for (int i = 0; i < 4; ++i)
+            {
+                msg[i] = vreinterpretq_u32_u8(vrev32q_u8(vld1q_u8(data + 16 * i)));
+            }
+
+            for (int j = 0; j < 20; ++j)
+            {
+                uint32x4_t m = vaddq_u32(msg[j & 3], vdupq_n_u32(K[j / 5]));
+                uint32_t e1 = vsha1h_u32(vgetq_lane_u32(abcd, 0));
+                switch (j / 5)
+                {
+                    case 0:  abcd = vsha1cq_u32(abcd, e0, m); break;
+                    case 2:  abcd = vsha1mq_u32(abcd, e0, m); break;
+                    default: abcd = vsha1pq_u32(abcd, e0, m); break;
+                }
+                e0 = e1;
+
+                if (j < 16)
+                    msg[j & 3] = vsha1su1q_u32(vsha1su0q_u32(msg[j & 3], msg[(j + 1) & 3], msg[(j + 2) & 3]), msg[(j + 3) & 3]);
+            }
+
+            abcd = vaddq_u32(abcd, abcd_save);
+            e0 += e0_save;
+        }
+
+        vst1q_u32(state, abcd);
+        state[4] = e0;
+    }
+
+#endif
+
+#if defined(DM_SHA_X86) || defined(DM_SHA_ARM)
+
+    bool HashSha1Accelerated(const uint8_t* buf, uint32_t buflen, uint8_t* digest)
+    {
+        if (!HasShaExtensions())
+            return false;
+        uint32_t state[5];
+        memcpy(state, SHA1_IV, sizeof(state));
+        HashPadded(Sha1ProcessBlocks, state, 5, buf, buflen, digest);
+        return true;
+    }
+
+    bool HashSha256Accelerated(const uint8_t* buf, uint32_t buflen, uint8_t* digest)
+    {
+        if (!HasShaExtensions())
+            return false;
+        uint32_t state[8];
+        memcpy(state, SHA256_IV, sizeof(state));
+        HashPadded(Sha256ProcessBlocks, state, 8, buf, buflen, digest);
+        return true;
+    }
+
+#else
+
+    bool HashSha1Accelerated(const uint8_t* buf, uint32_t buflen, uint8_t* digest)
+    {
+        (void)buf; (void)buflen; (void)digest;
+        return false;
+    }
+
+    bool HashSha256Accelerated(const uint8_t* buf, uint32_t buflen, uint8_t* digest)
+    {
+        (void)buf; (void)buflen; (void)digest;
+        return false;
+    }
+
+#endif
+
+} // namespace dmCrypt
@@ -61,5 +61,31 @@ namespace dmEasing
         float diff = (t - index1 * (1.0f / (sample_count-1))) * (sample_count-1);
         return val1 * (1.0f - diff) + val2 * diff;
     }
-}
 
+    void GetValues(const Curve& curve, const float* t, float* out, uint32_t count)
+    {
+        if (curve.type == dmEasing::TYPE_FLOAT_VECTOR)
+        {
+            for (uint32_t i = 0; i < count; ++i)
+            {
+                out[i] = GetValue(curve, t[i]);
+            }
+            return;
+        }
+
+        // Built in curves all have the same sample count, and the last sample is duplicated,
+        // which means we can skip the upper bound check on the second index. The loop body is
+        // branch free so that the compiler can vectorize the clamp and interpolation.
+        const float* lookup = EASING_LOOKUP + curve.type * (EASING_SAMPLES + 1);
+        const float scale = (float) (EASING_SAMPLES - 1);
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            float x = dmMath::Clamp(t[i], 0.0f, 1.0f) * scale;
+            int index1 = (int) x;
+            float diff = x - (float) index1;
+            float val1 = lookup[index1];
+            float val2 = lookup[index1 + 1];
+            out[i] = val1 + (val2 - val1) * diff;
+        }
+    }
+}
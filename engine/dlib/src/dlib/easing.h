@@ -105,6 +105,16 @@ namespace dmEasing
      */
     float GetValue(Type type, float t);
     float GetValue(Curve curve, float t);
+
+    /**
+     * Batched easing-curve evaluation. Evaluates the same curve for a range of
+     * time values, which is considerably cheaper than calling GetValue() per value.
+     * @param curve curve
+     * @param t array of time values in the range [0,1]
+     * @param out array of curve values, may alias t
+     * @param count number of values
+     */
+    void GetValues(const Curve& curve, const float* t, float* out, uint32_t count);
 }
 
 #endif // DM_EASING
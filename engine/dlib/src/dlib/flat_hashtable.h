@@ -0,0 +1,508 @@
+// Copyright 2020-2024 The Defold Foundation
+// Copyright 2014-2020 King
+// Copyright 2009-2014 Ragnar Svensson, Christian Murray
+// Licensed under the Defold License version 1.0 (the "License"); you may not use
+// this file except in compliance with the License.
+//
+// You may obtain a copy of the License, together with FAQs at
+// https://www.defold.com/license
+//
+// Unless required by applicable law or agreed to in writing, software distributed
+// under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+// CONDITIONS OF ANY KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations under the License.
+
+#ifndef DM_FLAT_HASHTABLE_H
+#define DM_FLAT_HASHTABLE_H
+
+#include <assert.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #include <emmintrin.h>
+    #define DM_FLAT_HASHTABLE_SSE2
+#elif defined(__aarch64__) || defined(_M_ARM64)
+    #include <arm_neon.h>
+    #define DM_FLAT_HASHTABLE_NEON
+#endif
+
+#if defined(_MSC_VER)
+    #include <intrin.h>
+#endif
+
+/*
+ * Hash table with open addressing, for lookups on hot paths.
+ *
+ * The slots are split into groups of 16, with one control byte per slot. The control byte
+ * holds 7 bits of the key hash for used slots, or marks the slot as empty or deleted.
+ * A lookup compares the control bytes of a whole group at once (SSE2/NEON when available),
+ * and only compares the keys of the slots whose hash bits match. Keys and values are stored
+ * inline in the slots, so a lookup is usually one miss for the control bytes and one for the entry.
+ *
+ * Same API and memcpy-copy semantics (POD types) as dmHashTable. The key type needs to be
+ * convertible to uint64_t, and support ==.
+ */
+template <typename KEY, typename T>
+class dmFlatHashTable
+{
+    static const uint8_t  CTRL_EMPTY   = 0x80;
+    static const uint8_t  CTRL_DELETED = 0xFE;
+    static const uint32_t GROUP_SIZE   = 16;
+
+#if defined(DM_FLAT_HASHTABLE_NEON)
+    // The NEON match masks have 4 bits per slot
+    static const uint32_t MASK_SHIFT = 2;
+#else
+    static const uint32_t MASK_SHIFT = 0;
+#endif
+
+public:
+    struct Entry
+    {
+        KEY      m_Key;
+        T        m_Value;
+    };
+
+    dmFlatHashTable()
+    {
+        memset(this, 0, sizeof(*this));
+    }
+
+    ~dmFlatHashTable()
+    {
+        free(m_Entries);
+    }
+
+    /**
+     * Removes all the entries from the table.
+     */
+    void Clear()
+    {
+        if (m_Ctrl)
+            memset(m_Ctrl, CTRL_EMPTY, m_SlotCount);
+        m_Count = 0;
+        m_Deleted = 0;
+    }
+
+    /**
+     * Number of entries stored in table
+     */
+    uint32_t Size() const
+    {
+        return m_Count;
+    }
+
+    /**
+     * Maximum number of entries possible to store in table
+     */
+    uint32_t Capacity() const
+    {
+        return m_Capacity;
+    }
+
+    /**
+     * Number of bytes allocated for the table. The slot count is a power of two that keeps
+     * Capacity() entries within the max load, and each slot has an entry and a control byte
+     */
+    uint32_t GetAllocatedSize() const
+    {
+        return m_Entries ? m_SlotCount * (sizeof(Entry) + 1) : 0;
+    }
+
+    /**
+     * Set the capacity. New capacity must be greater or equal to current capacity
+     * @param capacity Capacity. capacity < 0x7fffffff
+     */
+    void SetCapacity(uint32_t capacity)
+    {
+        assert(capacity < 0x7fffffff);
+        assert(capacity >= Capacity());
+
+        uint32_t slot_count = GROUP_SIZE;
+        while (MaxLoad(slot_count) < capacity)
+            slot_count *= 2;
+
+        Rehash(slot_count);
+        m_Capacity = capacity;
+    }
+
+    /**
+     * Set the capacity. Same as SetCapacity(capacity), for drop-in compatibility with dmHashTable.
+     * @param table_size Ignored. The number of slots is derived from the capacity
+     * @param capacity Capacity. capacity < 0x7fffffff
+     */
+    void SetCapacity(uint32_t table_size, uint32_t capacity)
+    {
+        (void)table_size;
+        SetCapacity(capacity);
+    }
+
+    void Swap(dmFlatHashTable<KEY, T>& other)
+    {
+        char buf[sizeof(*this)];
+        memcpy(buf, &other, sizeof(buf));
+        memcpy(&other, this, sizeof(buf));
+        memcpy(this, buf, sizeof(buf));
+    }
+
+    bool Full() const
+    {
+        return m_Count == m_Capacity;
+    }
+
+    bool Empty() const
+    {
+        return m_Count == 0;
+    }
+
+    /**
+     * Put key/value pair in hash table. NOTE: The method will "assert" if the hashtable is full.
+     */
+    void Put(KEY key, const T& value)
+    {
+        assert(!Full());
+        Entry* entry = FindEntry(key);
+        if (entry != 0)
+        {
+            entry->m_Value = value;
+            return;
+        }
+
+        uint64_t hash = Hash(key);
+        uint32_t index = FindInsertSlot(hash);
+        if (m_Ctrl[index] == CTRL_EMPTY)
+        {
+            // Always keep some empty slots, or lookups of missing keys won't terminate
+            if (m_Count + m_Deleted + 1 > MaxLoad(m_SlotCount))
+            {
+                Rehash(m_SlotCount);
+                index = FindInsertSlot(hash);
+            }
+        }
+        else
+        {
+            --m_Deleted;
+        }
+
+        m_Ctrl[index] = (uint8_t)(hash & 0x7f);
+        m_Entries[index].m_Key = key;
+        m_Entries[index].m_Value = value;
+        ++m_Count;
+    }
+
+    /**
+     * Get pointer to value from key
+     * @return Pointer to value. NULL if the key/value pair doesn't exist.
+     */
+    T* Get(KEY key)
+    {
+        Entry* entry = FindEntry(key);
+        return entry ? &entry->m_Value : 0;
+    }
+
+    const T* Get(KEY key) const
+    {
+        Entry* entry = FindEntry(key);
+        return entry ? &entry->m_Value : 0;
+    }
+
+    /**
+     * Remove key/value pair.
+     * @note Only valid if key exists in table
+     */
+    void Erase(KEY key)
+    {
+        Entry* entry = FindEntry(key);
+        assert(entry && "Key not found (erase)");
+
+        uint32_t index = (uint32_t)(entry - m_Entries);
+        // If the group has an empty slot, no lookup has ever probed past it, and the slot can be made empty
+        // instead of being marked as deleted
+        const uint8_t* group = m_Ctrl + (index & ~(GROUP_SIZE - 1));
+        if (MatchEmpty(group))
+        {
+            m_Ctrl[index] = CTRL_EMPTY;
+        }
+        else
+        {
+            m_Ctrl[index] = CTRL_DELETED;
+            ++m_Deleted;
+        }
+        --m_Count;
+    }
+
+    /**
+     * Iterate over all entries in table
+     */
+    template <typename CONTEXT>
+    void Iterate(void (*call_back)(CONTEXT *context, const KEY* key, T* value), CONTEXT* context) const
+    {
+        for (uint32_t i = 0; i < m_SlotCount; ++i)
+        {
+            if (IsFull(m_Ctrl[i]))
+            {
+                Entry* e = &m_Entries[i];
+                call_back(context, &e->m_Key, &e->m_Value);
+            }
+        }
+    }
+
+    struct Iterator
+    {
+        const KEY&  GetKey()    { return m_Table.m_Entries[m_Index].m_Key; }
+        const T&    GetValue()  { return m_Table.m_Entries[m_Index].m_Value; }
+
+        Iterator(dmFlatHashTable<KEY, T>& table)
+            : m_Table(table)
+            , m_Index(0xFFFFFFFF)
+        {
+        }
+
+        bool Next()
+        {
+            while (++m_Index < m_Table.m_SlotCount)
+            {
+                if (IsFull(m_Table.m_Ctrl[m_Index]))
+                    return true;
+            }
+            m_Index = m_Table.m_SlotCount;
+            return false;
+        }
+
+        dmFlatHashTable<KEY, T>&    m_Table;
+        uint32_t                    m_Index;
+    };
+
+    Iterator GetIterator()
+    {
+        return Iterator(*this);
+    }
+
+    /**
+     * Verify internal structure. "assert" if invalid. For unit testing
+     */
+    void Verify()
+    {
+        uint32_t count = 0;
+        uint32_t deleted = 0;
+        for (uint32_t i = 0; i < m_SlotCount; ++i)
+        {
+            if (IsFull(m_Ctrl[i]))
+            {
+                ++count;
+                assert(m_Ctrl[i] == (Hash(m_Entries[i].m_Key) & 0x7f));
+                assert(FindEntry(m_Entries[i].m_Key) == &m_Entries[i]);
+            }
+            else if (m_Ctrl[i] == CTRL_DELETED)
+            {
+                ++deleted;
+            }
+            else
+            {
+                assert(m_Ctrl[i] == CTRL_EMPTY);
+            }
+        }
+        assert(count == m_Count);
+        assert(deleted == m_Deleted);
+    }
+
+private:
+    // Forbid assignment operator and copy-constructor
+    dmFlatHashTable(const dmFlatHashTable<KEY, T>&);
+    const dmFlatHashTable<KEY, T>& operator=(const dmFlatHashTable<KEY, T>&);
+
+    static uint32_t MaxLoad(uint32_t slot_count)
+    {
+        return slot_count - slot_count / 8;
+    }
+
+    static bool IsFull(uint8_t ctrl)
+    {
+        return (ctrl & 0x80) == 0;
+    }
+
+    // The keys are often hashes already, but may also be small integers or aligned pointers,
+    // so the bits are mixed to make both the group index and the control byte useful.
+    static uint64_t Hash(KEY key)
+    {
+        uint64_t h = (uint64_t)key * 0x9E3779B97F4A7C15ULL;
+        return h ^ (h >> 32);
+    }
+
+    static uint32_t CountTrailingZeros(uint64_t mask)
+    {
+#if defined(_MSC_VER)
+        unsigned long index;
+        if (_BitScanForward(&index, (unsigned long)(mask & 0xFFFFFFFF)))
+            return (uint32_t)index;
+        _BitScanForward(&index, (unsigned long)(mask >> 32));
+        return (uint32_t)index + 32;
+#else
+        return (uint32_t)__builtin_ctzll(mask);
+#endif
+    }
+
+#if !defined(DM_FLAT_HASHTABLE_SSE2) && !defined(DM_FLAT_HASHTABLE_NEON)
+    // Without SIMD, the group is handled as two 64 bit words (assumes little endian)
+    static const uint64_t SWAR_LSBS = 0x0101010101010101ULL;
+    static const uint64_t SWAR_MSBS = 0x8080808080808080ULL;
+
+    static void LoadGroup(const uint8_t* group, uint64_t* lo, uint64_t* hi)
+    {
+        memcpy(lo, group, sizeof(uint64_t));
+        memcpy(hi, group + sizeof(uint64_t), sizeof(uint64_t));
+    }
+
+    // Gathers the top bit of each byte into one bit per slot
+    static uint64_t CompressMask(uint64_t lo, uint64_t hi)
+    {
+        const uint64_t gather = 0x0102040810204080ULL;
+        return (((lo >> 7) * gather) >> 56) | ((((hi >> 7) * gather) >> 56) << 8);
+    }
+#endif
+
+    // Returns a mask with a bit set for each control byte in the group that equals `value`
+    static uint64_t MatchByte(const uint8_t* group, uint8_t value)
+    {
+#if defined(DM_FLAT_HASHTABLE_SSE2)
+        __m128i ctrl = _mm_loadu_si128((const __m128i*)group);
+        return (uint64_t)(uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(ctrl, _mm_set1_epi8((char)value)));
+#elif defined(DM_FLAT_HASHTABLE_NEON)
+        uint8x16_t eq = vceqq_u8(vld1q_u8(group), vdupq_n_u8(value));
+        uint64_t mask = vget_lane_u64(vreinterpret_u64_u8(vshrn_n_u16(vreinterpretq_u16_u8(eq), 4)), 0);
+        return mask & 0x8888888888888888ULL;
+#else
+        // May report false matches for slots after a real match, which is fine as the keys are compared
+        uint64_t lo, hi;
+        LoadGroup(group, &lo, &hi);
+        uint64_t pattern = SWAR_LSBS * value;
+        lo ^= pattern;
+        hi ^= pattern;
+        return CompressMask((lo - SWAR_LSBS) & ~lo & SWAR_MSBS, (hi - SWAR_LSBS) & ~hi & SWAR_MSBS);
+#endif
+    }
+
+    // Returns a mask with a bit set for each empty slot in the group
+    static uint64_t MatchEmpty(const uint8_t* group)
+    {
+#if defined(DM_FLAT_HASHTABLE_SSE2) || defined(DM_FLAT_HASHTABLE_NEON)
+        return MatchByte(group, CTRL_EMPTY);
+#else
+        // Empty and deleted slots have the top bit set, but only deleted slots have bit 1 set
+        uint64_t lo, hi;
+        LoadGroup(group, &lo, &hi);
+        return CompressMask(lo & ~(lo << 6) & SWAR_MSBS, hi & ~(hi << 6) & SWAR_MSBS);
+#endif
+    }
+
+    // Returns a mask with a bit set for each empty or deleted slot in the group
+    static uint64_t MatchEmptyOrDeleted(const uint8_t* group)
+    {
+#if defined(DM_FLAT_HASHTABLE_SSE2)
+        return (uint64_t)(uint32_t)_mm_movemask_epi8(_mm_loadu_si128((const __m128i*)group));
+#elif defined(DM_FLAT_HASHTABLE_NEON)
+        uint8x16_t free = vcltq_s8(vreinterpretq_s8_u8(vld1q_u8(group)), vdupq_n_s8(0));
+        uint64_t mask = vget_lane_u64(vreinterpret_u64_u8(vshrn_n_u16(vreinterpretq_u16_u8(free), 4)), 0);
+        return mask & 0x8888888888888888ULL;
+#else
+        uint64_t lo, hi;
+        LoadGroup(group, &lo, &hi);
+        return CompressMask(lo & SWAR_MSBS, hi & SWAR_MSBS);
+#endif
+    }
+
+    Entry* FindEntry(KEY key) const
+    {
+        if (!m_SlotCount)
+            return 0;
+
+        uint64_t hash = Hash(key);
+        uint8_t h2 = (uint8_t)(hash & 0x7f);
+        uint32_t group_mask = m_SlotCount / GROUP_SIZE - 1;
+        uint32_t group_index = (uint32_t)(hash >> 7) & group_mask;
+
+        // Triangular probing visits every group, as the number of groups is a power of two
+        for (uint32_t step = 1; ; ++step)
+        {
+            uint32_t first = group_index * GROUP_SIZE;
+            const uint8_t* group = m_Ctrl + first;
+            uint64_t mask = MatchByte(group, h2);
+            while (mask)
+            {
+                Entry* e = &m_Entries[first + (CountTrailingZeros(mask) >> MASK_SHIFT)];
+                if (e->m_Key == key)
+                    return e;
+                mask &= mask - 1;
+            }
+
+            if (MatchEmpty(group))
+                return 0;
+
+            group_index = (group_index + step) & group_mask;
+        }
+    }
+
+    // Returns the first empty or deleted slot in the probe sequence of the hash
+    uint32_t FindInsertSlot(uint64_t hash) const
+    {
+        uint32_t group_mask = m_SlotCount / GROUP_SIZE - 1;
+        uint32_t group_index = (uint32_t)(hash >> 7) & group_mask;
+        for (uint32_t step = 1; ; ++step)
+        {
+            uint32_t first = group_index * GROUP_SIZE;
+            uint64_t mask = MatchEmptyOrDeleted(m_Ctrl + first);
+            if (mask)
+                return first + (CountTrailingZeros(mask) >> MASK_SHIFT);
+            group_index = (group_index + step) & group_mask;
+        }
+    }
+
+    // Moves all entries to a new set of slots, which also drops the deleted markers
+    void Rehash(uint32_t slot_count)
+    {
+        Entry* old_entries = m_Entries;
+        uint8_t* old_ctrl = m_Ctrl;
+        uint32_t old_slot_count = m_SlotCount;
+
+        // One allocation, with the control bytes after the entries
+        m_Entries = (Entry*) malloc((sizeof(Entry) + 1) * slot_count);
+        m_Ctrl = (uint8_t*)(m_Entries + slot_count);
+        m_SlotCount = slot_count;
+        memset(m_Ctrl, CTRL_EMPTY, slot_count);
+        m_Deleted = 0;
+
+        for (uint32_t i = 0; i < old_slot_count; ++i)
+        {
+            if (IsFull(old_ctrl[i]))
+            {
+                uint64_t hash = Hash(old_entries[i].m_Key);
+                uint32_t index = FindInsertSlot(hash);
+                m_Ctrl[index] = (uint8_t)(hash & 0x7f);
+                memcpy(&m_Entries[index], &old_entries[i], sizeof(Entry));
+            }
+        }
+
+        free(old_entries);
+    }
+
+    // Entries of all slots
+    Entry*      m_Entries;
+    // Control byte of each slot. Points into the allocation of m_Entries
+    uint8_t*    m_Ctrl;
+    // Number of slots, a power of two, and at least GROUP_SIZE
+    uint32_t    m_SlotCount;
+    uint32_t    m_Capacity;
+    uint32_t    m_Count;
+    // Number of slots marked as deleted
+    uint32_t    m_Deleted;
+};
+
+template <typename T>
+class dmFlatHashTable32 : public dmFlatHashTable<uint32_t, T> {};
+
+template <typename T>
+class dmFlatHashTable64 : public dmFlatHashTable<uint64_t, T> {};
+
+#endif // DM_FLAT_HASHTABLE_H
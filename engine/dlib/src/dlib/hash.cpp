@@ -15,42 +15,144 @@
 #include <stdio.h>
 #include <stddef.h>
 #include <string.h>
+#include <algorithm>
 #include "dalloca.h"
 #include "dlib.h"
 #include "hash.h"
 #include "array.h"
 #include "index_pool.h"
 #include "align.h"
+#include <dlib/atomic.h>
 #include <dlib/dstrings.h>
+#include <dlib/endian.h>
 #include <dlib/mutex.h>
-#include <dlib/hashtable.h>
+#include <dlib/math.h>
 
+// Strings for reverse hashing are interned in an append only arena, and found through open addressed
+// tables (one for 32 bit and one for 64 bit hashes) that are read without taking any lock. Looking up a
+// string, or hashing a string that is already known, never blocks.
+// Adding, erasing and trimming strings is serialized by m_Mutex.
+//
+// The arena has a max size. When it's full, it's trimmed: the least recently used strings are evicted
+// and the rest are compacted into new pages. Strings that are kept (see dmHashKeepReverseHashStrings)
+// are never evicted, and live in their own pages.
+//
+// Pages and tables that are replaced are retired, and freed through epochs: a lookup counts itself as a
+// reader of the current epoch while it reads the tables and strings. Each trim tries to advance the epoch,
+// which it only can once the readers of the previous epoch are done. Memory that was retired in an epoch
+// is freed two epochs later, when no lookup can still be reading it. A string that was looked up therefore
+// stays valid until two more trims have been made, but it must still not be kept for long.
+
+struct ReverseHashString
+{
+    uint64_t       m_Hash;
+    int32_atomic_t m_LastUsed;  // Value of the clock when the string was last hashed or looked up
+    uint16_t       m_Length;    // At most DMHASH_MAX_REVERSE_LENGTH
+    uint16_t       m_Kept;      // Never evicted
+    char           m_Value[1];  // Null terminated
+};
+
+struct ReverseHashTable
+{
+    uint32_t        m_Capacity; // Power of two
+    uint32_t        m_Count;    // Number of strings
+    uint32_t        m_Used;     // Number of strings and erased slots
+    void* volatile* m_Slots;
+};
+
+struct ReverseHashPage
+{
+    ReverseHashPage* m_Next;
+    uint32_t         m_Used;
+};
+
+// Marks an erased slot. Lookups continue probing past it
+static ReverseHashString* const REVERSE_HASH_ERASED = (ReverseHashString*) 1;
+
+// The string of an incremental hash state, while it is being built
 struct ReverseHashEntry
 {
-    inline ReverseHashEntry(void* value, uint32_t length) : m_Value(value), m_Length (length) {}
     void*    m_Value;
     uint16_t m_Length;
 };
 
-struct ReverseHashContainer
+// A string and its table, sorted by age when trimming
+struct ReverseHashTrimEntry
+{
+    ReverseHashString* m_String;
+    uint32_t           m_Age;
+    uint32_t           m_Table;
+};
+
+// A page or a table that was replaced, and the epoch it was replaced in
+struct ReverseHashRetired
+{
+    void*   m_Memory;
+    int32_t m_Epoch;
+};
+
+// Number of lookups in progress, for the two most recent epochs (indexed by the lowest bit of the epoch).
+// There are a few of them, on separate cache lines, so that threads mostly don't share one
+struct ReverseHashReaders
+{
+    int32_atomic_t m_Count[2];
+    uint8_t        m_Padding[64 - 2 * sizeof(int32_atomic_t)];
+};
+
+static inline bool CompareReverseHashAge(const ReverseHashTrimEntry& a, const ReverseHashTrimEntry& b)
 {
-    static const size_t m_HashTableSize = 1024;
-    static const size_t m_HashTableCapacity = 512;
-    static const size_t m_HashTableCapacityIncrement = 256;
-    static const size_t m_HashStatesCapacity = 512;
-    static const size_t m_HashStatesCapacityIncrement = 256;
+    return a.m_Age < b.m_Age;
+}
 
-    dmMutex::HMutex                 m_Mutex;
-    bool                            m_Enabled;
-    dmHashTable32<ReverseHashEntry> m_HashTable32Entries;
-    dmHashTable64<ReverseHashEntry> m_HashTable64Entries;
-    dmArray<ReverseHashEntry>       m_HashStates;
-    dmIndexPool32                   m_HashStatesSlots;
+struct ReverseHashContainer
+{
+    static const uint32_t m_PageSize = 64 * 1024;
+    static const uint32_t m_PageHeaderSize = DM_ALIGN(sizeof(ReverseHashPage), 8);
+    static const uint32_t m_TableMinCapacity = 1024;
+    static const uint32_t m_DefaultMaxSize = 32 * 1024 * 1024;
+    static const uint32_t m_ReadersCount = 16;
+    static const size_t   m_HashStatesCapacity = 512;
+    static const size_t   m_HashStatesCapacityIncrement = 256;
+
+    dmMutex::HMutex             m_Mutex;
+    bool                        m_Enabled;
+    void* volatile              m_Tables[2];  // ReverseHashTable*, for 32 and 64 bit hashes
+    ReverseHashPage*            m_Pages;      // The page strings are allocated from is first
+    ReverseHashPage*            m_KeptPages;  // Pages of the kept strings, never trimmed
+    dmArray<ReverseHashRetired> m_Retired;    // Replaced pages and tables, freed two epochs later
+    ReverseHashReaders          m_Readers[m_ReadersCount];
+    int32_atomic_t              m_Epoch;
+    int32_atomic_t              m_Clock;      // Incremented for each new string
+    uint32_t                    m_MaxSize;
+    uint32_t                    m_ArenaSize;  // Bytes allocated from the pages, including erased strings
+    uint32_t                    m_KeptSize;   // Bytes allocated from the pages of the kept strings
+    uint32_t                    m_LiveSize;   // Bytes of the strings in the tables
+    uint32_t                    m_PageCount;
+    uint32_t                    m_KeptPageCount;
+    uint32_t                    m_TrimCount;
+    uint32_t                    m_EvictedCount;
+    dmArray<ReverseHashEntry>   m_HashStates;
+    dmIndexPool32               m_HashStatesSlots;
 
     ReverseHashContainer()
     {
         m_Mutex = dmMutex::New();
         m_Enabled = false;
+        m_Tables[0] = 0;
+        m_Tables[1] = 0;
+        m_Pages = 0;
+        m_KeptPages = 0;
+        memset(m_Readers, 0, sizeof(m_Readers));
+        m_Epoch = 0;
+        m_Clock = 0;
+        m_MaxSize = m_DefaultMaxSize;
+        m_ArenaSize = 0;
+        m_KeptSize = 0;
+        m_LiveSize = 0;
+        m_PageCount = 0;
+        m_KeptPageCount = 0;
+        m_TrimCount = 0;
+        m_EvictedCount = 0;
     }
 
     ~ReverseHashContainer()
@@ -59,12 +161,6 @@ struct ReverseHashContainer
         dmMutex::Delete(m_Mutex);
     }
 
-    template <typename KEY>
-    static inline void FreeEntryCallback(void* context, const KEY* key, ReverseHashEntry* value)
-    {
-        free(value->m_Value);
-    }
-
     template <typename INDEX>
     static inline void FreeStateCallback(void* context, const INDEX index)
     {
@@ -72,6 +168,396 @@ struct ReverseHashContainer
         states[index].m_Value = 0;
     }
 
+    static inline uint32_t StringSize(uint32_t length)
+    {
+        return DM_ALIGN((uint32_t) offsetof(ReverseHashString, m_Value) + length + 1, 8);
+    }
+
+    static inline ReverseHashTable* GetTable(void* volatile* table)
+    {
+        return (ReverseHashTable*) dmAtomicGetPtr(table);
+    }
+
+    // Lock free. Counts the calling thread as a reader of the current epoch, until Unpin is called
+    inline int32_atomic_t* Pin()
+    {
+        // Any counter is correct. The threads have separate stacks, which spreads them out
+        uint8_t local;
+        uintptr_t stack = (uintptr_t) &local;
+        ReverseHashReaders* readers = &m_Readers[((stack >> 12) ^ (stack >> 20)) % m_ReadersCount];
+        for (;;)
+        {
+            int32_t epoch = dmAtomicLoad32(&m_Epoch);
+            int32_atomic_t* count = &readers->m_Count[epoch & 1];
+            dmAtomicIncrement32(count);
+            // If the epoch was advanced meanwhile, its previous readers may already have been waited for
+            if (dmAtomicLoad32(&m_Epoch) == epoch)
+                return count;
+            dmAtomicDecrement32(count);
+        }
+    }
+
+    static inline void Unpin(int32_atomic_t* count)
+    {
+        dmAtomicDecrement32(count);
+    }
+
+    // Lock free
+    static ReverseHashString* Find(ReverseHashTable* table, uint64_t hash)
+    {
+        if (!table)
+            return 0;
+        uint32_t mask = table->m_Capacity - 1;
+        uint32_t index = (uint32_t) (hash ^ (hash >> 32)) & mask;
+        for (;;)
+        {
+            ReverseHashString* s = (ReverseHashString*) dmAtomicGetPtr(&table->m_Slots[index]);
+            if (s == 0)
+                return 0;
+            if (s != REVERSE_HASH_ERASED && s->m_Hash == hash)
+                return s;
+            index = (index + 1) & mask;
+        }
+    }
+
+    // Lock free. The caller must be pinned
+    inline ReverseHashString* FindAndTouch(uint32_t table_index, uint64_t hash)
+    {
+        ReverseHashString* s = Find(GetTable(&m_Tables[table_index]), hash);
+        if (s)
+        {
+            // Racy with other readers, but any recent value will do. Only written when it changed,
+            // so readers of a hot string don't keep bouncing its cache line
+            int32_t now = dmAtomicLoad32(&m_Clock);
+            if (dmAtomicLoad32(&s->m_LastUsed) != now)
+                dmAtomicStore32(&s->m_LastUsed, now);
+        }
+        return s;
+    }
+
+    static ReverseHashTable* NewTable(uint32_t capacity)
+    {
+        ReverseHashTable* table = (ReverseHashTable*) malloc(sizeof(ReverseHashTable) + sizeof(void*) * capacity);
+        table->m_Capacity = capacity;
+        table->m_Count = 0;
+        table->m_Used = 0;
+        table->m_Slots = (void* volatile*) (table + 1);
+        memset((void*) table->m_Slots, 0, sizeof(void*) * capacity);
+        return table;
+    }
+
+    // The table isn't published yet, or the caller holds the lock
+    static void Place(ReverseHashTable* table, ReverseHashString* s)
+    {
+        uint32_t mask = table->m_Capacity - 1;
+        uint32_t index = (uint32_t) (s->m_Hash ^ (s->m_Hash >> 32)) & mask;
+        while (table->m_Slots[index] != 0)
+        {
+            index = (index + 1) & mask;
+        }
+        dmAtomicStorePtr(&table->m_Slots[index], s);
+        table->m_Count++;
+        table->m_Used++;
+    }
+
+    static uint32_t TableCapacity(uint32_t count)
+    {
+        // At most a quarter full after a rebuild, so that there's room to grow to half full
+        uint32_t capacity = m_TableMinCapacity;
+        while (capacity < count * 4)
+            capacity *= 2;
+        return capacity;
+    }
+
+    void Retire(void* memory)
+    {
+        if (m_Retired.Full())
+            m_Retired.OffsetCapacity(dmMath::Max(16U, m_Retired.Size()));
+        ReverseHashRetired retired = { memory, m_Epoch };
+        m_Retired.Push(retired);
+    }
+
+    // Advances the epoch, unless there are lookups that started before the current one
+    void AdvanceEpoch()
+    {
+        int32_t epoch = m_Epoch;
+        for (uint32_t i = 0; i < m_ReadersCount; ++i)
+        {
+            if (dmAtomicLoad32(&m_Readers[i].m_Count[(epoch + 1) & 1]) != 0)
+                return;
+        }
+        dmAtomicStore32(&m_Epoch, epoch + 1);
+    }
+
+    // Frees the memory that no lookup can be reading anymore
+    void FreeRetired()
+    {
+        int32_t epoch = m_Epoch;
+        uint32_t size = 0;
+        for (uint32_t i = 0; i < m_Retired.Size(); ++i)
+        {
+            if (epoch - m_Retired[i].m_Epoch >= 2)
+                free(m_Retired[i].m_Memory);
+            else
+                m_Retired[size++] = m_Retired[i];
+        }
+        m_Retired.SetSize(size);
+    }
+
+    void FreeAllRetired()
+    {
+        for (uint32_t i = 0; i < m_Retired.Size(); ++i)
+        {
+            free(m_Retired[i].m_Memory);
+        }
+        m_Retired.SetSize(0);
+    }
+
+    static void FreePageList(ReverseHashPage* page)
+    {
+        while (page)
+        {
+            ReverseHashPage* next = page->m_Next;
+            free(page);
+            page = next;
+        }
+    }
+
+    void FreePages()
+    {
+        FreePageList(m_Pages);
+        FreePageList(m_KeptPages);
+        m_Pages = 0;
+        m_KeptPages = 0;
+        m_PageCount = 0;
+        m_KeptPageCount = 0;
+        m_ArenaSize = 0;
+        m_KeptSize = 0;
+        m_LiveSize = 0;
+    }
+
+    ReverseHashString* AllocRaw(uint32_t length)
+    {
+        uint32_t size = StringSize(length);
+        ReverseHashPage* page = m_Pages;
+        if (!page || page->m_Used + size > m_PageSize)
+        {
+            page = (ReverseHashPage*) malloc(m_PageSize);
+            page->m_Next = m_Pages;
+            page->m_Used = m_PageHeaderSize;
+            m_Pages = page;
+            m_PageCount++;
+        }
+        ReverseHashString* s = (ReverseHashString*) ((uint8_t*) page + page->m_Used);
+        page->m_Used += size;
+        m_ArenaSize += size;
+        m_LiveSize += size;
+        return s;
+    }
+
+    // Evicts the least recently used strings, and compacts the rest into new pages and tables
+    void Trim()
+    {
+        uint32_t count = 0;
+        for (uint32_t t = 0; t < 2; ++t)
+        {
+            ReverseHashTable* table = GetTable(&m_Tables[t]);
+            count += table ? table->m_Count : 0;
+        }
+
+        // Ages are relative to the clock, so that they are correct when it wraps
+        int32_t now = dmAtomicLoad32(&m_Clock);
+        dmArray<ReverseHashTrimEntry> entries;
+        entries.SetCapacity(count);
+        uint32_t kept_count[2] = {0, 0};
+        uint32_t kept_size = 0;
+        for (uint32_t t = 0; t < 2; ++t)
+        {
+            ReverseHashTable* table = GetTable(&m_Tables[t]);
+            for (uint32_t i = 0; table && i < table->m_Capacity; ++i)
+            {
+                ReverseHashString* s = (ReverseHashString*) table->m_Slots[i];
+                if (s && s != REVERSE_HASH_ERASED)
+                {
+                    if (s->m_Kept)
+                    {
+                        kept_count[t]++;
+                        kept_size += StringSize(s->m_Length);
+                        continue;
+                    }
+                    ReverseHashTrimEntry entry = { s, (uint32_t) (now - dmAtomicLoad32(&s->m_LastUsed)), t };
+                    entries.Push(entry);
+                }
+            }
+        }
+        std::sort(entries.Begin(), entries.End(), CompareReverseHashAge);
+
+        // Keep the most recently used strings, up to three quarters of the max size
+        uint32_t target = m_MaxSize - m_MaxSize / 4;
+        uint32_t keep_size = 0;
+        uint32_t keep = 0;
+        while (keep < entries.Size() && keep_size + StringSize(entries[keep].m_String->m_Length) <= target)
+        {
+            keep_size += StringSize(entries[keep].m_String->m_Length);
+            keep++;
+        }
+
+        ReverseHashPage* old_pages = m_Pages;
+        m_Pages = 0;
+        m_PageCount = 0;
+        m_ArenaSize = 0;
+        m_LiveSize = kept_size;
+
+        ReverseHashTable* tables[2];
+        uint32_t table_counts[2] = {kept_count[0], kept_count[1]};
+        for (uint32_t i = 0; i < keep; ++i)
+        {
+            table_counts[entries[i].m_Table]++;
+        }
+        for (uint32_t t = 0; t < 2; ++t)
+        {
+            tables[t] = NewTable(TableCapacity(table_counts[t]));
+
+            // The kept strings stay where they are
+            ReverseHashTable* table = GetTable(&m_Tables[t]);
+            for (uint32_t i = 0; table && i < table->m_Capacity; ++i)
+            {
+                ReverseHashString* s = (ReverseHashString*) table->m_Slots[i];
+                if (s && s != REVERSE_HASH_ERASED && s->m_Kept)
+                    Place(tables[t], s);
+            }
+        }
+
+        for (uint32_t i = 0; i < keep; ++i)
+        {
+            ReverseHashString* s = entries[i].m_String;
+            ReverseHashString* copy = AllocRaw(s->m_Length);
+            memcpy(copy, s, offsetof(ReverseHashString, m_Value) + s->m_Length + 1);
+            Place(tables[entries[i].m_Table], copy);
+        }
+
+        for (uint32_t t = 0; t < 2; ++t)
+        {
+            void* old_table = GetTable(&m_Tables[t]);
+            dmAtomicStorePtr(&m_Tables[t], tables[t]);
+            if (old_table)
+                Retire(old_table);
+        }
+
+        while (old_pages)
+        {
+            ReverseHashPage* next = old_pages->m_Next;
+            Retire(old_pages);
+            old_pages = next;
+        }
+
+        AdvanceEpoch();
+        FreeRetired();
+
+        m_TrimCount++;
+        m_EvictedCount += entries.Size() - keep;
+    }
+
+    // Replaces the table with a larger one (without the erased slots)
+    ReverseHashTable* Grow(uint32_t table_index)
+    {
+        ReverseHashTable* old_table = GetTable(&m_Tables[table_index]);
+        ReverseHashTable* table = NewTable(TableCapacity(old_table ? old_table->m_Count : 0));
+        if (old_table)
+        {
+            for (uint32_t i = 0; i < old_table->m_Capacity; ++i)
+            {
+                ReverseHashString* s = (ReverseHashString*) old_table->m_Slots[i];
+                if (s && s != REVERSE_HASH_ERASED)
+                    Place(table, s);
+            }
+        }
+
+        dmAtomicStorePtr(&m_Tables[table_index], table);
+        if (old_table)
+        {
+            // Only a trim advances the epoch, so until then (or until reverse hashing is disabled) it's kept
+            Retire(old_table);
+        }
+        return table;
+    }
+
+    // Called with the lock held
+    void Insert(uint32_t table_index, uint64_t hash, const void* value, uint32_t length)
+    {
+        if (Find(GetTable(&m_Tables[table_index]), hash))
+            return; // Added by another thread
+
+        if (m_ArenaSize + StringSize(length) > m_MaxSize)
+            Trim();
+
+        ReverseHashString* s = AllocRaw(length);
+        s->m_Hash = hash;
+        s->m_LastUsed = m_Clock;
+        s->m_Length = (uint16_t) length;
+        s->m_Kept = 0;
+        memcpy(s->m_Value, value, length);
+        s->m_Value[length] = '\0';
+        dmAtomicIncrement32(&m_Clock);
+
+        ReverseHashTable* table = GetTable(&m_Tables[table_index]);
+        if (!table || (table->m_Used + 1) * 2 > table->m_Capacity)
+            table = Grow(table_index);
+        Place(table, s);
+    }
+
+    // Called with the lock held
+    void Erase(uint32_t table_index, uint64_t hash)
+    {
+        ReverseHashTable* table = GetTable(&m_Tables[table_index]);
+        if (!table)
+            return;
+        uint32_t mask = table->m_Capacity - 1;
+        uint32_t index = (uint32_t) (hash ^ (hash >> 32)) & mask;
+        for (;;)
+        {
+            ReverseHashString* s = (ReverseHashString*) table->m_Slots[index];
+            if (s == 0)
+                return;
+            if (s != REVERSE_HASH_ERASED && s->m_Hash == hash)
+            {
+                // The string stays in the arena until the next trim
+                dmAtomicStorePtr(&table->m_Slots[index], REVERSE_HASH_ERASED);
+                table->m_Count--;
+                m_LiveSize -= StringSize(s->m_Length);
+                return;
+            }
+            index = (index + 1) & mask;
+        }
+    }
+
+    // Called with the lock held. Marks all current strings as kept, and moves their pages to the kept pages
+    void KeepAll()
+    {
+        for (uint32_t t = 0; t < 2; ++t)
+        {
+            ReverseHashTable* table = GetTable(&m_Tables[t]);
+            for (uint32_t i = 0; table && i < table->m_Capacity; ++i)
+            {
+                ReverseHashString* s = (ReverseHashString*) table->m_Slots[i];
+                if (s && s != REVERSE_HASH_ERASED)
+                    s->m_Kept = 1;
+            }
+        }
+
+        while (m_Pages)
+        {
+            ReverseHashPage* next = m_Pages->m_Next;
+            m_Pages->m_Next = m_KeptPages;
+            m_KeptPages = m_Pages;
+            m_Pages = next;
+        }
+        m_KeptPageCount += m_PageCount;
+        m_KeptSize += m_ArenaSize;
+        m_PageCount = 0;
+        m_ArenaSize = 0;
+    }
+
     void Enable(bool enable)
     {
         if(m_Enabled == enable)
@@ -81,13 +567,6 @@ struct ReverseHashContainer
 
         if(enable)
         {
-
-            if(m_HashTable32Entries.Capacity() < m_HashTableCapacity)
-                m_HashTable32Entries.SetCapacity(m_HashTableSize, m_HashTableCapacity);
-            m_HashTable32Entries.Clear();
-            if(m_HashTable64Entries.Capacity() < m_HashTableCapacity)
-                m_HashTable64Entries.SetCapacity(m_HashTableSize, m_HashTableCapacity);
-            m_HashTable64Entries.Clear();
             m_HashStates.SetCapacity(m_HashStatesCapacity);
             m_HashStates.SetSize(m_HashStatesCapacity);
             m_HashStatesSlots.SetCapacity(m_HashStatesCapacity);
@@ -97,10 +576,18 @@ struct ReverseHashContainer
         }
         else
         {
-            m_HashTable32Entries.Iterate(FreeEntryCallback, (void*) 0);
-            m_HashTable32Entries.Clear();
-            m_HashTable64Entries.Iterate(FreeEntryCallback, (void*) 0);
-            m_HashTable64Entries.Clear();
+            for (uint32_t t = 0; t < 2; ++t)
+            {
+                void* table = GetTable(&m_Tables[t]);
+                dmAtomicStorePtr(&m_Tables[t], 0);
+                free(table);
+            }
+            FreePages();
+            FreeAllRetired();
+            m_Clock = 0;
+            m_TrimCount = 0;
+            m_EvictedCount = 0;
+
             if(m_HashStatesSlots.Size() != 0)
             {
                 m_HashStatesSlots.Push(0);
@@ -131,6 +618,8 @@ struct ReverseHashContainer
     inline void FreeReverseHashStatesSlot(uint32_t slot_index)
     {
         assert(slot_index != 0);
+        free(m_HashStates[slot_index].m_Value);
+        m_HashStates[slot_index].m_Value = 0;
         m_HashStatesSlots.Push(slot_index);
     }
 
@@ -159,6 +648,24 @@ struct ReverseHashContainer
         entry.m_Length = length;
     }
 
+    // Called with the lock held. Inserts the string of an incremental hash state, and frees the state
+    inline void FinalizeReverseHashState(uint32_t table_index, uint32_t state_index, uint64_t hash, uint32_t size)
+    {
+        ReverseHashEntry& entry = m_HashStates[state_index];
+        if (size <= DMHASH_MAX_REVERSE_LENGTH)
+        {
+            Insert(table_index, hash, entry.m_Value ? entry.m_Value : "", entry.m_Length);
+        }
+        FreeReverseHashStatesSlot(state_index);
+    }
+};
+
+// Pins the calling thread while in scope, see ReverseHashContainer::Pin
+struct ReverseHashReadScope
+{
+    int32_atomic_t* m_Count;
+    ReverseHashReadScope(ReverseHashContainer& container) : m_Count(container.Pin()) {}
+    ~ReverseHashReadScope() { ReverseHashContainer::Unpin(m_Count); }
 };
 
 static inline ReverseHashContainer& dmHashContainer()
@@ -175,8 +682,72 @@ void dmHashEnableReverseHash(bool enable)
     dmHashContainer().Enable(enable);
 }
 
+void dmHashKeepReverseHashStrings()
+{
+    ReverseHashContainer& container = dmHashContainer();
+    if (container.m_Enabled)
+    {
+        DM_MUTEX_SCOPED_LOCK(container.m_Mutex);
+        container.KeepAll();
+    }
+}
+
+void dmHashSetReverseHashMaxSize(uint32_t max_size)
+{
+    ReverseHashContainer& container = dmHashContainer();
+    DM_MUTEX_SCOPED_LOCK(container.m_Mutex);
+    container.m_MaxSize = dmMath::Max(max_size, 4 * ReverseHashContainer::m_PageSize);
+}
+
+void dmHashGetReverseHashStats(dmHashReverseHashStats* stats)
+{
+    ReverseHashContainer& container = dmHashContainer();
+    DM_MUTEX_SCOPED_LOCK(container.m_Mutex);
+    memset(stats, 0, sizeof(*stats));
+    for (uint32_t t = 0; t < 2; ++t)
+    {
+        ReverseHashTable* table = ReverseHashContainer::GetTable(&container.m_Tables[t]);
+        if (table)
+        {
+            stats->m_Strings += table->m_Count;
+            stats->m_TableSize += sizeof(ReverseHashTable) + sizeof(void*) * table->m_Capacity;
+        }
+    }
+    stats->m_LiveSize    = container.m_LiveSize;
+    stats->m_ArenaSize   = container.m_ArenaSize + container.m_KeptSize;
+    stats->m_KeptSize    = container.m_KeptSize;
+    stats->m_PagesSize   = (container.m_PageCount + container.m_KeptPageCount) * ReverseHashContainer::m_PageSize;
+    stats->m_MaxSize     = container.m_MaxSize;
+    stats->m_TrimCount   = container.m_TrimCount;
+    stats->m_EvictedCount = container.m_EvictedCount;
+}
+
 #define mmix(h,k) { k *= m; k ^= k >> r; k *= m; h *= m; h ^= k; }
 
+// Unaligned little endian reads. The hashes are defined on the little endian value of each
+// word, so that they are the same on all platforms (and in bob)
+static inline uint32_t ReadLE32(const unsigned char* data)
+{
+#if DM_ENDIAN == DM_ENDIAN_LITTLE
+    uint32_t k;
+    memcpy(&k, data, sizeof(k));
+    return k;
+#else
+    return uint32_t(data[0]) | (uint32_t(data[1]) << 8) | (uint32_t(data[2]) << 16) | (uint32_t(data[3]) << 24);
+#endif
+}
+
+static inline uint64_t ReadLE64(const unsigned char* data)
+{
+#if DM_ENDIAN == DM_ENDIAN_LITTLE
+    uint64_t k;
+    memcpy(&k, data, sizeof(k));
+    return k;
+#else
+    return uint64_t(ReadLE32(data)) | (uint64_t(ReadLE32(data + 4)) << 32);
+#endif
+}
+
 // Based on MurmurHash2A but endian neutral
 uint32_t dmHashBufferNoReverse32(const void* key, uint32_t len)
 {
@@ -190,12 +761,7 @@ uint32_t dmHashBufferNoReverse32(const void* key, uint32_t len)
 
     while(len >= 4)
     {
-        uint32_t k;
-
-        k  = data[0];
-        k |= data[1] << 8;
-        k |= data[2] << 16;
-        k |= data[3] << 24;
+        uint32_t k = ReadLE32(data);
 
         mmix(h,k);
 
@@ -228,18 +794,15 @@ uint32_t dmHashBuffer32(const void * key, uint32_t len)
 
     if (dmHashContainer().m_Enabled && len <= DMHASH_MAX_REVERSE_LENGTH)
     {
-        DM_MUTEX_SCOPED_LOCK(dmHashContainer().m_Mutex);
-        dmHashTable32<ReverseHashEntry>* hash_table = &dmHashContainer().m_HashTable32Entries;
-        if (hash_table->Get(h) == 0)
+        bool found;
         {
-            if (hash_table->Full())
-            {
-                hash_table->SetCapacity(dmHashContainer().m_HashTableSize, hash_table->Capacity() + dmHashContainer().m_HashTableCapacityIncrement);
-            }
-            char* copy = (char*) malloc(len + 1);
-            memcpy(copy, key, len);
-            copy[len] = '\0';
-            hash_table->Put(h, ReverseHashEntry(copy, len));
+            ReverseHashReadScope read_scope(dmHashContainer());
+            found = dmHashContainer().FindAndTouch(0, h) != 0;
+        }
+        if (!found)
+        {
+            DM_MUTEX_SCOPED_LOCK(dmHashContainer().m_Mutex);
+            dmHashContainer().Insert(0, h, key, len);
         }
     }
 
@@ -259,16 +822,7 @@ uint64_t dmHashBufferNoReverse64(const void * key, uint32_t len)
 
     while(len >= 8)
     {
-        uint64_t k;
-
-        k  = uint64_t(data[0]);
-        k |= uint64_t(data[1]) << 8;
-        k |= uint64_t(data[2]) << 16;
-        k |= uint64_t(data[3]) << 24;
-        k |= uint64_t(data[4]) << 32;
-        k |= uint64_t(data[5]) << 40;
-        k |= uint64_t(data[6]) << 48;
-        k |= uint64_t(data[7]) << 56;
+        uint64_t k = ReadLE64(data);
 
         mmix(h,k);
 
@@ -305,18 +859,15 @@ uint64_t dmHashBuffer64(const void * key, uint32_t len)
 
     if (dmHashContainer().m_Enabled && len <= DMHASH_MAX_REVERSE_LENGTH)
     {
-        DM_MUTEX_SCOPED_LOCK(dmHashContainer().m_Mutex);
-        dmHashTable64<ReverseHashEntry>* hash_table = &dmHashContainer().m_HashTable64Entries;
-        if (hash_table->Get(h) == 0)
+        bool found;
         {
-            if (hash_table->Full())
-            {
-                hash_table->SetCapacity(dmHashContainer().m_HashTableSize, hash_table->Capacity() + dmHashContainer().m_HashTableCapacityIncrement);
-            }
-            char* copy = (char*) malloc(len + 1);
-            memcpy(copy, key, len);
-            copy[len] = '\0';
-            hash_table->Put(h, ReverseHashEntry(copy, len));
+            ReverseHashReadScope read_scope(dmHashContainer());
+            found = dmHashContainer().FindAndTouch(1, h) != 0;
+        }
+        if (!found)
+        {
+            DM_MUTEX_SCOPED_LOCK(dmHashContainer().m_Mutex);
+            dmHashContainer().Insert(1, h, key, len);
         }
     }
 
@@ -333,6 +884,329 @@ uint64_t DM_DLLEXPORT dmHashString64(const char* string)
     return dmHashBuffer64(string, strlen(string));
 }
 
+// XXH3 (64 bit, seed 0), as specified by xxHash 0.8.
+// Short buffers are hashed with a few multiplications, and buffers longer than 240 bytes
+// are processed in 64 byte stripes with eight independent accumulators (SSE2 or NEON when available)
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #include <emmintrin.h>
+    #define DM_XXH3_SSE2
+#elif defined(__aarch64__) || defined(_M_ARM64)
+    #include <arm_neon.h>
+    #define DM_XXH3_NEON
+#endif
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_ARM64))
+    #include <intrin.h>
+#endif
+
+static const uint32_t XXH_PRIME32_1 = 0x9E3779B1U;
+static const uint32_t XXH_PRIME32_2 = 0x85EBCA77U;
+static const uint32_t XXH_PRIME32_3 = 0xC2B2AE3DU;
+static const uint64_t XXH_PRIME64_1 = 0x9E3779B185EBCA87ULL;
+static const uint64_t XXH_PRIME64_2 = 0xC2B2AE3D27D4EB4FULL;
+static const uint64_t XXH_PRIME64_3 = 0x165667B19E3779F9ULL;
+static const uint64_t XXH_PRIME64_4 = 0x85EBCA77C2B2AE63ULL;
+static const uint64_t XXH_PRIME64_5 = 0x27D4EB2F165667C5ULL;
+static const uint64_t XXH_PRIME_MX1 = 0x165667919E3779F9ULL;
+static const uint64_t XXH_PRIME_MX2 = 0x9FB21C651E98DF25ULL;
+
+static const uint32_t XXH3_SECRET_SIZE   = 192;
+static const uint32_t XXH3_STRIPE_LEN    = 64;
+static const uint32_t XXH3_SECRET_CONSUME_RATE = 8;
+static const uint32_t XXH3_ACC_NB        = 8;
+
+// The default secret
+static const uint8_t XXH3_SECRET[XXH3_SECRET_SIZE] = {
+    0xb8, 0xfe, 0x6c, 0x39, 0x23, 0xa4, 0x4b, 0xbe, 0x7c, 0x01, 0x81, 0x2c, 0xf7, 0x21, 0xad, 0x1c,
+    0xde, 0xd4, 0x6d, 0xe9, 0x83, 0x90, 0x97, 0xdb, 0x72, 0x40, 0xa4, 0xa4, 0xb7, 0xb3, 0x67, 0x1f,
+    0xcb, 0x79, 0xe6, 0x4e, 0xcc, 0xc0, 0xe5, 0x78, 0x82, 0x5a, 0xd0, 0x7d, 0xcc, 0xff, 0x72, 0x21,
+    0xb8, 0x08, 0x46, 0x74, 0xf7, 0x43, 0x24, 0x8e, 0xe0, 0x35, 0x90, 0xe6, 0x81, 0x3a, 0x26, 0x4c,
+    0x3c, 0x28, 0x52, 0xbb, 0x91, 0xc3, 0x00, 0xcb, 0x88, 0xd0, 0x65, 0x8b, 0x1b, 0x53, 0x2e, 0xa3,
+    0x71, 0x64, 0x48, 0x97, 0xa2, 0x0d, 0xf9, 0x4e, 0x38, 0x19, 0xef, 0x46, 0xa9, 0xde, 0xac, 0xd8,
+    0xa8, 0xfa, 0x76, 0x3f, 0xe3, 0x9c, 0x34, 0x3f, 0xf9, 0xdc, 0xbb, 0xc7, 0xc7, 0x0b, 0x4f, 0x1d,
+    0x8a, 0x51, 0xe0, 0x4b, 0xcd, 0xb4, 0x59, 0x31, 0xc8, 0x9f, 0x7e, 0xc9, 0xd9, 0x78, 0x73, 0x64,
+    0xea, 0xc5, 0xac, 0x83, 0x34, 0xd3, 0xeb, 0xc3, 0xc5, 0x81, 0xa0, 0xff, 0xfa, 0x13, 0x63, 0xeb,
+    0x17, 0x0d, 0xdd, 0x51, 0xb7, 0xf0, 0xda, 0x49, 0xd3, 0x16, 0x55, 0x26, 0x29, 0xd4, 0x68, 0x9e,
+    0x2b, 0x16, 0xbe, 0x58, 0x7d, 0x47, 0xa1, 0xfc, 0x8f, 0xf8, 0xb8, 0xd1, 0x7a, 0xd0, 0x31, 0xce,
+    0x45, 0xcb, 0x3a, 0x8f, 0x95, 0x16, 0x04, 0x28, 0xaf, 0xd7, 0xfb, 0xca, 0xbb, 0x4b, 0x40, 0x7e,
+};
+
+static inline uint64_t XXH_Rotl64(uint64_t x, int r)
+{
+    return (x << r) | (x >> (64 - r));
+}
+
+static inline uint32_t XXH_Swap32(uint32_t x)
+{
+    return ((x << 24) & 0xff000000) | ((x << 8) & 0x00ff0000) | ((x >> 8) & 0x0000ff00) | ((x >> 24) & 0x000000ff);
+}
+
+static inline uint64_t XXH_Swap64(uint64_t x)
+{
+    return ((uint64_t)XXH_Swap32((uint32_t)x) << 32) | XXH_Swap32((uint32_t)(x >> 32));
+}
+
+// The low and high halves of the 128 bit product, xor:ed together
+static inline uint64_t XXH_Mul128Fold64(uint64_t a, uint64_t b)
+{
+#if defined(__SIZEOF_INT128__)
+    __uint128_t product = (__uint128_t)a * b;
+    return (uint64_t)product ^ (uint64_t)(product >> 64);
+#elif defined(_MSC_VER) && defined(_M_X64)
+    uint64_t hi;
+    uint64_t lo = _umul128(a, b, &hi);
+    return lo ^ hi;
+#elif defined(_MSC_VER) && defined(_M_ARM64)
+    return (a * b) ^ __umulh(a, b);
+#else
+    uint64_t lo_lo = (a & 0xFFFFFFFF) * (b & 0xFFFFFFFF);
+    uint64_t hi_lo = (a >> 32) * (b & 0xFFFFFFFF);
+    uint64_t lo_hi = (a & 0xFFFFFFFF) * (b >> 32);
+    uint64_t hi_hi = (a >> 32) * (b >> 32);
+    uint64_t cross = (lo_lo >> 32) + (hi_lo & 0xFFFFFFFF) + lo_hi;
+    uint64_t upper = (hi_lo >> 32) + (cross >> 32) + hi_hi;
+    uint64_t lower = (cross << 32) | (lo_lo & 0xFFFFFFFF);
+    return lower ^ upper;
+#endif
+}
+
+static inline uint64_t XXH64_Avalanche(uint64_t h)
+{
+    h ^= h >> 33;
+    h *= XXH_PRIME64_2;
+    h ^= h >> 29;
+    h *= XXH_PRIME64_3;
+    h ^= h >> 32;
+    return h;
+}
+
+static inline uint64_t XXH3_Avalanche(uint64_t h)
+{
+    h ^= h >> 37;
+    h *= XXH_PRIME_MX1;
+    h ^= h >> 32;
+    return h;
+}
+
+static inline uint64_t XXH3_rrmxmx(uint64_t h, uint64_t len)
+{
+    h ^= XXH_Rotl64(h, 49) ^ XXH_Rotl64(h, 24);
+    h *= XXH_PRIME_MX2;
+    h ^= (h >> 35) + len;
+    h *= XXH_PRIME_MX2;
+    return h ^ (h >> 28);
+}
+
+static inline uint64_t XXH3_Mix16B(const uint8_t* data, const uint8_t* secret)
+{
+    return XXH_Mul128Fold64(ReadLE64(data) ^ ReadLE64(secret), ReadLE64(data + 8) ^ ReadLE64(secret + 8));
+}
+
+static uint64_t XXH3_Len0To16(const uint8_t* data, uint32_t len)
+{
+    const uint8_t* secret = XXH3_SECRET;
+    if (len > 8)
+    {
+        uint64_t lo = ReadLE64(data) ^ (ReadLE64(secret + 24) ^ ReadLE64(secret + 32));
+        uint64_t hi = ReadLE64(data + len - 8) ^ (ReadLE64(secret + 40) ^ ReadLE64(secret + 48));
+        uint64_t acc = len + XXH_Swap64(lo) + hi + XXH_Mul128Fold64(lo, hi);
+        return XXH3_Avalanche(acc);
+    }
+    if (len >= 4)
+    {
+        uint32_t input1 = ReadLE32(data);
+        uint32_t input2 = ReadLE32(data + len - 4);
+        uint64_t bitflip = ReadLE64(secret + 8) ^ ReadLE64(secret + 16);
+        uint64_t input64 = input2 + ((uint64_t)input1 << 32);
+        return XXH3_rrmxmx(input64 ^ bitflip, len);
+    }
+    if (len > 0)
+    {
+        uint32_t combined = ((uint32_t)data[0] << 16) | ((uint32_t)data[len >> 1] << 24) | (uint32_t)data[len - 1] | (len << 8);
+        uint64_t bitflip = ReadLE32(secret) ^ ReadLE32(secret + 4);
+        return XXH64_Avalanche((uint64_t)combined ^ bitflip);
+    }
+    return XXH64_Avalanche(ReadLE64(secret + 56) ^ ReadLE64(secret + 64));
+}
+
+static uint64_t XXH3_Len17To128(const uint8_t* data, uint32_t len)
+{
+    const uint8_t* secret = XXH3_SECRET;
+    uint64_t acc = len * XXH_PRIME64_1;
+    if (len > 32)
+    {
+        if (len > 64)
+        {
+            if (len > 96)
+            {
+                acc += XXH3_Mix16B(data + 48, secret + 96);
+                acc += XXH3_Mix16B(data + len - 64, secret + 112);
+            }
+            acc += XXH3_Mix16B(data + 32, secret + 64);
+            acc += XXH3_Mix16B(data + len - 48, secret + 80);
+        }
+        acc += XXH3_Mix16B(data + 16, secret + 32);
+        acc += XXH3_Mix16B(data + len - 32, secret + 48);
+    }
+    acc += XXH3_Mix16B(data, secret);
+    acc += XXH3_Mix16B(data + len - 16, secret + 16);
+    return XXH3_Avalanche(acc);
+}
+
+static uint64_t XXH3_Len129To240(const uint8_t* data, uint32_t len)
+{
+    const uint8_t* secret = XXH3_SECRET;
+    const uint32_t secret_size_min = 136;
+    const uint32_t start_offset = 3;
+    const uint32_t last_offset = 17;
+
+    uint64_t acc = len * XXH_PRIME64_1;
+    uint32_t rounds = len / 16;
+    for (uint32_t i = 0; i < 8; ++i)
+    {
+        acc += XXH3_Mix16B(data + 16 * i, secret + 16 * i);
+    }
+    acc = XXH3_Avalanche(acc);
+    for (uint32_t i = 8; i < rounds; ++i)
+    {
+        acc += XXH3_Mix16B(data + 16 * i, secret + 16 * (i - 8) + start_offset);
+    }
+    acc += XXH3_Mix16B(data + len - 16, secret + secret_size_min - last_offset);
+    return XXH3_Avalanche(acc);
+}
+
+static inline void XXH3_Accumulate512(uint64_t* acc, const uint8_t* data, const uint8_t* secret)
+{
+#if defined(DM_XXH3_SSE2)
+    __m128i* xacc = (__m128i*)acc;
+    for (uint32_t i = 0; i < XXH3_STRIPE_LEN / 16; ++i)
+    {
+        __m128i data_vec = _mm_loadu_si128((const __m128i*)(data + 16 * i));
+        __m128i key_vec = _mm_loadu_si128((const __m128i*)(secret + 16 * i));
+        __m128i data_key = _mm_xor_si128(data_vec, key_vec);
+        // 32x32->64 bit products of the low and high halves of each lane
+        __m128i data_key_hi = _mm_shuffle_epi32(data_key, _MM_SHUFFLE(0, 3, 0, 1));
+        __m128i product = _mm_mul_epu32(data_key, data_key_hi);
+        // The data is added to the neighbouring lane
+        __m128i data_swap = _mm_shuffle_epi32(data_vec, _MM_SHUFFLE(1, 0, 3, 2));
+        __m128i sum = _mm_add_epi64(_mm_loadu_si128(xacc + i), data_swap);
+        _mm_storeu_si128(xacc + i, _mm_add_epi64(product, sum));
+    }
+#elif defined(DM_XXH3_NEON)
+    for (uint32_t i = 0; i < XXH3_STRIPE_LEN / 16; ++i)
+    {
+        uint64x2_t data_vec = vreinterpretq_u64_u8(vld1q_u8(data + 16 * i));
+        uint64x2_t key_vec = vreinterpretq_u64_u8(vld1q_u8(secret + 16 * i));
+        uint64x2_t data_key = veorq_u64(data_vec, key_vec);
+        uint64x2_t product = vmull_u32(vmovn_u64(data_key), vshrn_n_u64(data_key, 32));
+        uint64x2_t data_swap = vextq_u64(data_vec, data_vec, 1);
+        uint64x2_t sum = vaddq_u64(vld1q_u64(acc + 2 * i), data_swap);
+        vst1q_u64(acc + 2 * i, vaddq_u64(product, sum));
+    }
+#else
+    for (uint32_t i = 0; i < XXH3_ACC_NB; ++i)
+    {
+        uint64_t data_val = ReadLE64(data + 8 * i);
+        uint64_t data_key = data_val ^ ReadLE64(secret + 8 * i);
+        acc[i ^ 1] += data_val;
+        acc[i] += (data_key & 0xFFFFFFFF) * (data_key >> 32);
+    }
+#endif
+}
+
+static inline void XXH3_Scramble(uint64_t* acc, const uint8_t* secret)
+{
+#if defined(DM_XXH3_SSE2)
+    __m128i* xacc = (__m128i*)acc;
+    const __m128i prime32 = _mm_set1_epi32((int)XXH_PRIME32_1);
+    for (uint32_t i = 0; i < XXH3_STRIPE_LEN / 16; ++i)
+    {
+        __m128i acc_vec = _mm_loadu_si128(xacc + i);
+        acc_vec = _mm_xor_si128(acc_vec, _mm_srli_epi64(acc_vec, 47));
+        acc_vec = _mm_xor_si128(acc_vec, _mm_loadu_si128((const __m128i*)(secret + 16 * i)));
+        // 64x32 bit multiplication, from two 32x32->64 bit multiplications
+        __m128i acc_hi = _mm_shuffle_epi32(acc_vec, _MM_SHUFFLE(0, 3, 0, 1));
+        __m128i product_lo = _mm_mul_epu32(acc_vec, prime32);
+        __m128i product_hi = _mm_mul_epu32(acc_hi, prime32);
+        _mm_storeu_si128(xacc + i, _mm_add_epi64(product_lo, _mm_slli_epi64(product_hi, 32)));
+    }
+#else
+    for (uint32_t i = 0; i < XXH3_ACC_NB; ++i)
+    {
+        uint64_t a = acc[i];
+        a ^= a >> 47;
+        a ^= ReadLE64(secret + 8 * i);
+        acc[i] = a * XXH_PRIME32_1;
+    }
+#endif
+}
+
+static uint64_t XXH3_HashLong(const uint8_t* data, uint32_t len)
+{
+    const uint8_t* secret = XXH3_SECRET;
+    const uint32_t stripes_per_block = (XXH3_SECRET_SIZE - XXH3_STRIPE_LEN) / XXH3_SECRET_CONSUME_RATE;
+    const uint32_t block_len = XXH3_STRIPE_LEN * stripes_per_block;
+    const uint32_t last_stripe_offset = 7;
+    const uint32_t merge_accs_start = 11;
+
+    DM_ALIGNED(16) uint64_t acc[XXH3_ACC_NB] = {
+        XXH_PRIME32_3, XXH_PRIME64_1, XXH_PRIME64_2, XXH_PRIME64_3,
+        XXH_PRIME64_4, XXH_PRIME32_2, XXH_PRIME64_5, XXH_PRIME32_1
+    };
+
+    uint32_t blocks = (len - 1) / block_len;
+    for (uint32_t n = 0; n < blocks; ++n)
+    {
+        const uint8_t* block = data + n * block_len;
+        for (uint32_t s = 0; s < stripes_per_block; ++s)
+        {
+            XXH3_Accumulate512(acc, block + s * XXH3_STRIPE_LEN, secret + s * XXH3_SECRET_CONSUME_RATE);
+        }
+        XXH3_Scramble(acc, secret + XXH3_SECRET_SIZE - XXH3_STRIPE_LEN);
+    }
+
+    // The last partial block, and the last stripe (which may overlap the previous one)
+    uint32_t stripes = ((len - 1) - block_len * blocks) / XXH3_STRIPE_LEN;
+    const uint8_t* block = data + blocks * block_len;
+    for (uint32_t s = 0; s < stripes; ++s)
+    {
+        XXH3_Accumulate512(acc, block + s * XXH3_STRIPE_LEN, secret + s * XXH3_SECRET_CONSUME_RATE);
+    }
+    XXH3_Accumulate512(acc, data + len - XXH3_STRIPE_LEN, secret + XXH3_SECRET_SIZE - XXH3_STRIPE_LEN - last_stripe_offset);
+
+    uint64_t result = len * XXH_PRIME64_1;
+    for (uint32_t i = 0; i < 4; ++i)
+    {
+        const uint8_t* s = secret + merge_accs_start + 16 * i;
+        result += XXH_Mul128Fold64(acc[2 * i] ^ ReadLE64(s), acc[2 * i + 1] ^ ReadLE64(s + 8));
+    }
+    return XXH3_Avalanche(result);
+}
+
+static uint64_t dmHashXXH3_64(const void* buffer, uint32_t len)
+{
+    const uint8_t* data = (const uint8_t*)buffer;
+    if (len <= 16)
+        return XXH3_Len0To16(data, len);
+    if (len <= 128)
+        return XXH3_Len17To128(data, len);
+    if (len <= 240)
+        return XXH3_Len129To240(data, len);
+    return XXH3_HashLong(data, len);
+}
+
+uint64_t DM_DLLEXPORT dmHashBufferVersion64(dmHashVersion version, const void* buffer, uint32_t buffer_len)
+{
+    switch (version)
+    {
+        case DMHASH_VERSION_XXH3:   return dmHashXXH3_64(buffer, buffer_len);
+        case DMHASH_VERSION_MURMUR: return dmHashBufferNoReverse64(buffer, buffer_len);
+    }
+    assert(false && "Unknown hash version");
+    return 0;
+}
+
 // Based on CMurmurHash2A
 void dmHashInit32(HashState32* hash_state, bool reverse_hash)
 {
@@ -399,11 +1273,7 @@ void dmHashUpdateBuffer32(HashState32* hash_state, const void* buffer, uint32_t
 
     while(len >= 4)
     {
-        uint32_t k;
-        k  = data[0];
-        k |= data[1] << 8;
-        k |= data[2] << 16;
-        k |= data[3] << 24;
+        uint32_t k = ReadLE32(data);
 
         mmix(hash_state->m_Hash,k);
 
@@ -430,23 +1300,10 @@ uint32_t dmHashFinal32(HashState32* hash_state)
     hash_state->m_Hash *= m;
     hash_state->m_Hash ^= hash_state->m_Hash >> 15;
 
-    if (dmHashContainer().m_Enabled && hash_state->m_ReverseHashEntryIndex && hash_state->m_Size <= DMHASH_MAX_REVERSE_LENGTH)
+    if (dmHashContainer().m_Enabled && hash_state->m_ReverseHashEntryIndex)
     {
         DM_MUTEX_SCOPED_LOCK(dmHashContainer().m_Mutex);
-        dmHashTable32<ReverseHashEntry>* hash_table = &dmHashContainer().m_HashTable32Entries;
-        if (hash_table->Get(hash_state->m_Hash) == 0)
-        {
-            if (hash_table->Full())
-            {
-                hash_table->SetCapacity(dmHashContainer().m_HashTableSize, hash_table->Capacity() + dmHashContainer().m_HashTableCapacityIncrement);
-            }
-            hash_table->Put(hash_state->m_Hash, dmHashContainer().m_HashStates[hash_state->m_ReverseHashEntryIndex]);
-        }
-        else
-        {
-            free(dmHashContainer().m_HashStates[hash_state->m_ReverseHashEntryIndex].m_Value);
-        }
-        dmHashContainer().FreeReverseHashStatesSlot(hash_state->m_ReverseHashEntryIndex);
+        dmHashContainer().FinalizeReverseHashState(0, hash_state->m_ReverseHashEntryIndex, hash_state->m_Hash, hash_state->m_Size);
         hash_state->m_ReverseHashEntryIndex = 0;
     }
 
@@ -458,7 +1315,6 @@ void dmHashRelease32(HashState32* hash_state)
     if (dmHashContainer().m_Enabled && hash_state->m_ReverseHashEntryIndex)
     {
         DM_MUTEX_SCOPED_LOCK(dmHashContainer().m_Mutex);
-        free(dmHashContainer().m_HashStates[hash_state->m_ReverseHashEntryIndex].m_Value);
         dmHashContainer().FreeReverseHashStatesSlot(hash_state->m_ReverseHashEntryIndex);
         hash_state->m_ReverseHashEntryIndex = 0;
     }
@@ -530,15 +1386,7 @@ void dmHashUpdateBuffer64(HashState64* hash_state, const void* buffer, uint32_t
 
     while(len >= 8)
     {
-        uint64_t k;
-        k  = uint64_t(data[0]);
-        k |= uint64_t(data[1]) << 8;
-        k |= uint64_t(data[2]) << 16;
-        k |= uint64_t(data[3]) << 24;
-        k |= uint64_t(data[4]) << 32;
-        k |= uint64_t(data[5]) << 40;
-        k |= uint64_t(data[6]) << 48;
-        k |= uint64_t(data[7]) << 56;
+        uint64_t k = ReadLE64(data);
 
         mmix(hash_state->m_Hash, k);
 
@@ -566,23 +1414,10 @@ uint64_t dmHashFinal64(HashState64* hash_state)
     hash_state->m_Hash *= m;
     hash_state->m_Hash ^= hash_state->m_Hash >> r;
 
-    if (dmHashContainer().m_Enabled && hash_state->m_ReverseHashEntryIndex && hash_state->m_Size <= DMHASH_MAX_REVERSE_LENGTH)
+    if (dmHashContainer().m_Enabled && hash_state->m_ReverseHashEntryIndex)
     {
         DM_MUTEX_SCOPED_LOCK(dmHashContainer().m_Mutex);
-        dmHashTable64<ReverseHashEntry>* hash_table = &dmHashContainer().m_HashTable64Entries;
-        if (hash_table->Get(hash_state->m_Hash) == 0)
-        {
-            if (hash_table->Full())
-            {
-                hash_table->SetCapacity(dmHashContainer().m_HashTableSize, hash_table->Capacity() + dmHashContainer().m_HashTableCapacityIncrement);
-            }
-            hash_table->Put(hash_state->m_Hash, dmHashContainer().m_HashStates[hash_state->m_ReverseHashEntryIndex]);
-        }
-        else
-        {
-            free(dmHashContainer().m_HashStates[hash_state->m_ReverseHashEntryIndex].m_Value);
-        }
-        dmHashContainer().FreeReverseHashStatesSlot(hash_state->m_ReverseHashEntryIndex);
+        dmHashContainer().FinalizeReverseHashState(1, hash_state->m_ReverseHashEntryIndex, hash_state->m_Hash, hash_state->m_Size);
         hash_state->m_ReverseHashEntryIndex = 0;
     }
 
@@ -594,7 +1429,6 @@ void dmHashRelease64(HashState64* hash_state)
     if (dmHashContainer().m_Enabled && hash_state->m_ReverseHashEntryIndex)
     {
         DM_MUTEX_SCOPED_LOCK(dmHashContainer().m_Mutex);
-        free(dmHashContainer().m_HashStates[hash_state->m_ReverseHashEntryIndex].m_Value);
         dmHashContainer().FreeReverseHashStatesSlot(hash_state->m_ReverseHashEntryIndex);
         hash_state->m_ReverseHashEntryIndex = 0;
     }
@@ -604,8 +1438,8 @@ DM_DLLEXPORT const void* dmHashReverse32(uint32_t hash, uint32_t* length)
 {
     if (dmHashContainer().m_Enabled)
     {
-        DM_MUTEX_SCOPED_LOCK(dmHashContainer().m_Mutex);
-        ReverseHashEntry* reverse = dmHashContainer().m_HashTable32Entries.Get(hash);
+        ReverseHashReadScope read_scope(dmHashContainer());
+        ReverseHashString* reverse = dmHashContainer().FindAndTouch(0, hash);
         if (reverse)
         {
             if (length)
@@ -622,8 +1456,8 @@ DM_DLLEXPORT const void* dmHashReverse32Alloc(dmAllocator* allocator, uint32_t h
 {
     if (dmHashContainer().m_Enabled)
     {
-        DM_MUTEX_SCOPED_LOCK(dmHashContainer().m_Mutex);
-        ReverseHashEntry* reverse = dmHashContainer().m_HashTable32Entries.Get(hash);
+        ReverseHashReadScope read_scope(dmHashContainer());
+        ReverseHashString* reverse = dmHashContainer().FindAndTouch(0, hash);
         if (reverse)
         {
             if (length)
@@ -647,8 +1481,8 @@ DM_DLLEXPORT const void* dmHashReverse64(uint64_t hash, uint32_t* length)
 {
     if (dmHashContainer().m_Enabled)
     {
-        DM_MUTEX_SCOPED_LOCK(dmHashContainer().m_Mutex);
-        ReverseHashEntry* reverse = dmHashContainer().m_HashTable64Entries.Get(hash);
+        ReverseHashReadScope read_scope(dmHashContainer());
+        ReverseHashString* reverse = dmHashContainer().FindAndTouch(1, hash);
         if (reverse)
         {
             if (length)
@@ -665,8 +1499,8 @@ DM_DLLEXPORT const void* dmHashReverse64Alloc(dmAllocator* allocator, uint64_t h
 {
     if (dmHashContainer().m_Enabled)
     {
-        DM_MUTEX_SCOPED_LOCK(dmHashContainer().m_Mutex);
-        ReverseHashEntry* reverse = dmHashContainer().m_HashTable64Entries.Get(hash);
+        ReverseHashReadScope read_scope(dmHashContainer());
+        ReverseHashString* reverse = dmHashContainer().FindAndTouch(1, hash);
         if (reverse)
         {
             if (length)
@@ -691,12 +1525,7 @@ DM_DLLEXPORT void dmHashReverseErase32(uint32_t hash)
     if (dmHashContainer().m_Enabled)
     {
         DM_MUTEX_SCOPED_LOCK(dmHashContainer().m_Mutex);
-        ReverseHashEntry* reverse = dmHashContainer().m_HashTable32Entries.Get(hash);
-        if (reverse)
-        {
-            free(reverse->m_Value);
-            dmHashContainer().m_HashTable32Entries.Erase(hash);
-        }
+        dmHashContainer().Erase(0, hash);
     }
 }
 
@@ -705,12 +1534,7 @@ DM_DLLEXPORT void dmHashReverseErase64(uint64_t hash)
     if (dmHashContainer().m_Enabled)
     {
         DM_MUTEX_SCOPED_LOCK(dmHashContainer().m_Mutex);
-        ReverseHashEntry* reverse = dmHashContainer().m_HashTable64Entries.Get(hash);
-        if (reverse)
-        {
-            free(reverse->m_Value);
-            dmHashContainer().m_HashTable64Entries.Erase(hash);
-        }
+        dmHashContainer().Erase(1, hash);
     }
 }
 
@@ -22,6 +22,52 @@
  */
 const uint32_t DMHASH_MAX_REVERSE_LENGTH = 1024U;
 
+/**
+ * Hash function versions for dmHashBufferVersion64
+ * DMHASH_VERSION_MURMUR is the MurmurHash2 based function used by dmHashBuffer64 (and by the content pipeline)
+ * DMHASH_VERSION_XXH3 is XXH3-64 (seed 0). Much faster for large buffers, but not compatible with the dmHashBuffer64 values
+ */
+enum dmHashVersion
+{
+    DMHASH_VERSION_MURMUR = 1,
+    DMHASH_VERSION_XXH3   = 2,
+};
+
+/**
+ * The version to use for runtime only hashes (i.e. hashes that are never stored by the content pipeline)
+ * Define DM_HASH_COMPATIBILITY_MODE to keep using the Murmur hash everywhere
+ */
+#if defined(DM_HASH_COMPATIBILITY_MODE)
+const dmHashVersion DMHASH_VERSION_FAST = DMHASH_VERSION_MURMUR;
+#else
+const dmHashVersion DMHASH_VERSION_FAST = DMHASH_VERSION_XXH3;
+#endif
+
+/**
+ * Reverse hash counters, see dmHashGetReverseHashStats
+ */
+struct dmHashReverseHashStats
+{
+    /// Number of strings (for both 32 and 64 bit hashes)
+    uint32_t m_Strings;
+    /// Bytes used by the strings
+    uint32_t m_LiveSize;
+    /// Bytes allocated from the arena, including erased strings that are released on the next trim
+    uint32_t m_ArenaSize;
+    /// Bytes allocated from the arena for the kept strings (see dmHashKeepReverseHashStrings), included in m_ArenaSize
+    uint32_t m_KeptSize;
+    /// Bytes of the arena pages
+    uint32_t m_PagesSize;
+    /// Bytes of the lookup tables
+    uint32_t m_TableSize;
+    /// Max bytes allocated from the arena, before the least recently used strings are evicted
+    uint32_t m_MaxSize;
+    /// Number of times the arena has been trimmed
+    uint32_t m_TrimCount;
+    /// Number of strings evicted when trimming
+    uint32_t m_EvictedCount;
+};
+
 extern "C"
 {
 
@@ -43,6 +89,16 @@ DM_DLLEXPORT uint64_t dmHashBufferNoReverse64(const void* buffer, uint32_t buffe
  */
 DM_DLLEXPORT uint32_t dmHashBufferNoReverse32(const void* buffer, uint32_t buffer_len);
 
+/**
+ * Calculate 64-bit hash value from buffer, with a specific version of the hash function.
+ * The hash is never stored for reverse hashing.
+ * @param version Hash function version
+ * @param buffer Buffer
+ * @param buffer_len Length of buffer
+ * @return Hash value
+ */
+DM_DLLEXPORT uint64_t dmHashBufferVersion64(dmHashVersion version, const void* buffer, uint32_t buffer_len);
+
 /**
  * Enable/disable support for reverse hash lookup
  * @param enable true for enable
@@ -50,6 +106,26 @@ DM_DLLEXPORT uint32_t dmHashBufferNoReverse32(const void* buffer, uint32_t buffe
 DM_DLLEXPORT void dmHashEnableReverseHash(bool enable);
 
 
+/**
+ * Set the max size of the reverse hash strings. When it's reached, the least recently used
+ * (hashed or reverse hashed) strings are evicted. The default is 32mb. The kept strings
+ * (see dmHashKeepReverseHashStrings) aren't evicted, and don't count towards the max size.
+ * @param max_size Max size in bytes
+ */
+DM_DLLEXPORT void dmHashSetReverseHashMaxSize(uint32_t max_size);
+
+/**
+ * Keep the reverse hash strings that are currently known, i.e. never evict them. Called by the
+ * engine once it has started, for the strings it registered during startup.
+ */
+DM_DLLEXPORT void dmHashKeepReverseHashStrings();
+
+/**
+ * Get the reverse hash counters
+ * @param stats [out] The counters
+ */
+DM_DLLEXPORT void dmHashGetReverseHashStats(dmHashReverseHashStats* stats);
+
 /**
  * Reverse hash key entry removal.
  * @param hash hash key to erase
@@ -30,6 +30,7 @@
 #include <dlib/mutex.h>
 #include <dlib/socket.h>
 #include <dlib/sslsocket.h>
+#include <dlib/thread.h>
 
 namespace dmHttpClient
 {
@@ -47,6 +48,17 @@ namespace dmHttpClient
     // See https://tools.ietf.org/html/rfc8446, chapter 5.1
     const uint32_t MAX_HTTPS_POST_CHUNK_SIZE = 16384;
 
+    // Maximum number of requests in flight on a pipelined connection. The requests are sent
+    // before any response is read, so keep the total size well below the socket send buffer.
+    const uint32_t MAX_PIPELINE_DEPTH = 16;
+
+    // GetRanges() first requests the leading RANGE_PROBE_SIZE bytes, to learn the resource size
+    // and whether the server supports ranges, before splitting the rest over several connections.
+    const uint32_t RANGE_PROBE_SIZE = 256 * 1024;
+    const uint32_t RANGE_MIN_SIZE = 256 * 1024;
+    const uint32_t MAX_RANGE_CONNECTIONS = 8;
+    const uint32_t RANGE_THREAD_STACK_SIZE = 0x80000;
+
     // TODO: This is not good. Singleton like stuff
     // that requires a lock for initialization
     // See comment in GetPool()
@@ -104,6 +116,7 @@ namespace dmHttpClient
         int m_Major;
         int m_Minor;
         int m_Status;
+        uint32_t m_RequestIndex;
 
         // Offset to actual content in Client.m_Buffer,
         // ie after meta-data such as http-headers or chunk-size for transferring data with chunked encoding.
@@ -133,6 +146,7 @@ namespace dmHttpClient
             m_Major = 0;
             m_Minor = 0;
             m_Status = 0;
+            m_RequestIndex = 0;
             m_ContentLength = -1;
             m_ETag[0] = '\0';
             m_ContentOffset = -1;
@@ -186,6 +200,12 @@ namespace dmHttpClient
         uint16_t            m_ChunkedTransfer:1;
         int*                m_CancelFlag;
 
+        // Byte range of the current request. m_RangeSize is 0 when requesting the whole resource
+        uint32_t            m_RangeOffset;
+        uint32_t            m_RangeSize;
+        // Index of the current request, see GetPipelined()
+        uint32_t            m_RequestIndex;
+
         // Used both for reading header and content. NOTE: Extra byte for null-termination
         char                m_Buffer[BUFFER_SIZE + 1];
     };
@@ -242,14 +262,8 @@ namespace dmHttpClient
         params->m_RequestTimeout = 0;
     }
 
-    HClient New(const NewParams* params, const char* hostname, uint16_t port, bool secure, int* cancelflag)
+    static HClient CreateClient(const NewParams* params, const char* hostname, uint16_t port, bool secure, int* cancelflag)
     {
-        dmSocket::Address address;
-        if (dmSocket::GetHostByNameT(hostname, &address, params->m_RequestTimeout, cancelflag) != dmSocket::RESULT_OK)
-        {
-            return 0;
-        }
-
         Client* client = new Client();
 
         client->m_Hostname = strdup(hostname);
@@ -270,10 +284,24 @@ namespace dmHttpClient
         client->m_Port = port;
         client->m_IgnoreCache = params->m_HttpCache != 0 ? 0 : 1;
         client->m_CancelFlag = cancelflag;
+        client->m_RangeOffset = 0;
+        client->m_RangeSize = 0;
+        client->m_RequestIndex = 0;
 
         return client;
     }
 
+    HClient New(const NewParams* params, const char* hostname, uint16_t port, bool secure, int* cancelflag)
+    {
+        dmSocket::Address address;
+        if (dmSocket::GetHostByNameT(hostname, &address, params->m_RequestTimeout, cancelflag) != dmSocket::RESULT_OK)
+        {
+            return 0;
+        }
+
+        return CreateClient(params, hostname, port, secure, cancelflag);
+    }
+
     HClient New(const NewParams* params, const char* hostname, uint16_t port)
     {
         return New(params, hostname, port, false, 0);
@@ -323,6 +351,17 @@ namespace dmHttpClient
         return int(currenttime - client->m_RequestStart) >= client->m_RequestTimeout;
     }
 
+    static bool UseCache(HClient client)
+    {
+        // Partial responses are never cached
+        return !client->m_IgnoreCache && client->m_HttpCache && client->m_RangeSize == 0;
+    }
+
+    static void SetURI(HClient client, const char* path)
+    {
+        dmSnPrintf(client->m_URI, sizeof(client->m_URI), "%s://%s:%d/%s", client->m_Secure ? "https" : "http", client->m_Hostname, (int) client->m_Port, path);
+    }
+
     static dmSocket::Result SendAll(Response* response, const char* buffer, int length)
     {
         int total_sent_bytes = 0;
@@ -428,48 +467,55 @@ namespace dmHttpClient
 
     static Result RecvAndParseHeaders(HClient client, Response* response)
     {
-        response->m_TotalReceived = 0;
+        // With pipelined requests the start of the response might already be in the buffer
+        bool buffered = response->m_TotalReceived > 0;
 
         while (1)
         {
-            int max_to_recv = BUFFER_SIZE - response->m_TotalReceived;
-
-            if (max_to_recv <= 0)
+            bool eof = false;
+            if (!buffered)
             {
-                return RESULT_HTTP_HEADERS_ERROR;
-            }
+                int max_to_recv = BUFFER_SIZE - response->m_TotalReceived;
+
+                if (max_to_recv <= 0)
+                {
+                    return RESULT_HTTP_HEADERS_ERROR;
+                }
 
-            int recv_bytes = 0;
-            dmSocket::Result r = Receive(response, client->m_Buffer + response->m_TotalReceived, max_to_recv, &recv_bytes);
+                int recv_bytes = 0;
+                dmSocket::Result r = Receive(response, client->m_Buffer + response->m_TotalReceived, max_to_recv, &recv_bytes);
 
-            if( r == dmSocket::RESULT_WOULDBLOCK )
-            {
-                r = dmSocket::RESULT_TRY_AGAIN;
-            }
-            if( (r == dmSocket::RESULT_OK || r == dmSocket::RESULT_TRY_AGAIN) && HasRequestTimedOut(client) )
-            {
-                r = dmSocket::RESULT_WOULDBLOCK;
-            }
+                if( r == dmSocket::RESULT_WOULDBLOCK )
+                {
+                    r = dmSocket::RESULT_TRY_AGAIN;
+                }
+                if( (r == dmSocket::RESULT_OK || r == dmSocket::RESULT_TRY_AGAIN) && HasRequestTimedOut(client) )
+                {
+                    r = dmSocket::RESULT_WOULDBLOCK;
+                }
 
-            if (r == dmSocket::RESULT_TRY_AGAIN)
-                continue;
+                if (r == dmSocket::RESULT_TRY_AGAIN)
+                    continue;
 
-            if (r != dmSocket::RESULT_OK)
-            {
-                client->m_SocketResult = r;
-                return RESULT_SOCKET_ERROR;
-            }
+                if (r != dmSocket::RESULT_OK)
+                {
+                    client->m_SocketResult = r;
+                    return RESULT_SOCKET_ERROR;
+                }
 
-            response->m_TotalReceived += recv_bytes;
+                response->m_TotalReceived += recv_bytes;
+                eof = recv_bytes == 0;
+            }
+            buffered = false;
 
             // NOTE: We have an extra byte for null-termination so no buffer overrun here.
             client->m_Buffer[response->m_TotalReceived] = '\0';
 
             dmHttpClient::ParseResult parse_res;
-            parse_res = dmHttpClient::ParseHeader(client->m_Buffer, response, recv_bytes == 0, &HandleVersion, &HandleHeader, &HandleContent);
+            parse_res = dmHttpClient::ParseHeader(client->m_Buffer, response, eof, &HandleVersion, &HandleHeader, &HandleContent);
             if (parse_res == dmHttpClient::PARSE_RESULT_NEED_MORE_DATA)
             {
-                if (recv_bytes == 0)
+                if (eof)
                 {
                     dmLogWarning("Unexpected eof for socket connection.");
                     return RESULT_UNEXPECTED_EOF;
@@ -560,7 +606,7 @@ if (sock_res != dmSocket::RESULT_OK)\
                 goto bail;
             }
         }
-        if (!client->m_IgnoreCache && client->m_HttpCache)
+        if (UseCache(client))
         {
             char etag[64];
             dmHttpCache::Result cache_result = dmHttpCache::GetETag(client->m_HttpCache, client->m_URI, etag, sizeof(etag));
@@ -571,6 +617,12 @@ if (sock_res != dmSocket::RESULT_OK)\
                 HTTP_CLIENT_SENDALL_AND_BAIL("\r\n");
             }
         }
+        if (client->m_RangeSize > 0)
+        {
+            char buf[64];
+            dmSnPrintf(buf, sizeof(buf), "Range: bytes=%u-%u\r\n", client->m_RangeOffset, client->m_RangeOffset + client->m_RangeSize - 1);
+            HTTP_CLIENT_SENDALL_AND_BAIL(buf);
+        }
 
         if (strcmp(method, "POST") == 0 || strcmp(method, "PUT") == 0 || strcmp(method, "PATCH") == 0) {
             send_content_length = client->m_HttpSendContentLength(response, client->m_Userdata);
@@ -901,17 +953,9 @@ bail:
         return r;
     }
 
-    static Result DoDoRequest(HClient client, Response& response, const char* path, const char* method)
+    // more_responses is set when the buffer may hold the start of following pipelined responses
+    static Result ReceiveResponse(HClient client, Response& response, const char* path, const char* method, bool more_responses)
     {
-        dmSocket::Result sock_res;
-
-        sock_res = SendRequest(client, &response, path, method);
-
-        if (sock_res != dmSocket::RESULT_OK)
-        {
-            return RESULT_SOCKET_ERROR;
-        }
-
         Result r = RecvAndParseHeaders(client, &response);
         if (r != RESULT_OK)
         {
@@ -942,8 +986,26 @@ bail:
             // Use cached version
             if (response.m_ContentLength == 0 || response.m_ContentLength == -1)
             {
+                // HandleCached reads the cached content into the buffer, so keep any data that
+                // belongs to the following responses aside
+                int extra = more_responses ? response.m_TotalReceived - response.m_ContentOffset : 0;
+                char* extra_data = 0;
+                if (extra > 0)
+                {
+                    extra_data = (char*) malloc(extra);
+                    memcpy(extra_data, client->m_Buffer + response.m_ContentOffset, extra);
+                }
+
                 r = HandleCached(client, path, &response);
+
+                response.m_ContentOffset = 0;
                 response.m_TotalReceived = 0;
+                if (extra_data)
+                {
+                    memcpy(client->m_Buffer, extra_data, extra);
+                    response.m_TotalReceived = extra;
+                    free(extra_data);
+                }
             }
             else
             {
@@ -956,7 +1018,7 @@ bail:
         else
         {
             // Non-cached response
-            if (!client->m_IgnoreCache && client->m_HttpCache && response.m_Status == 200 /* OK */)
+            if (UseCache(client) && response.m_Status == 200 /* OK */)
             {
                 dmHttpCache::Begin(client->m_HttpCache, client->m_URI, response.m_ETag, response.m_MaxAge, &response.m_CacheCreator);
             }
@@ -976,7 +1038,7 @@ bail:
 
         // Removed an assert here, in favor of returning an error instead
         // which should allow the user to detect this and act accordingly
-        if (response.m_TotalReceived != 0)
+        if (response.m_TotalReceived != 0 && !more_responses)
         {
             dmLogError("Not all bytes were handled during the response (%d bytes left). Method: %s Status: %d", response.m_TotalReceived, method, response.m_Status);
             r = RESULT_INVALID_RESPONSE;
@@ -984,7 +1046,7 @@ bail:
 
         if (r == RESULT_OK)
         {
-            if (response.m_Status == 200)
+            if (response.m_Status == 200 || (response.m_Status == 206 /* PARTIAL CONTENT */ && client->m_RangeSize > 0))
                 return RESULT_OK;
             else
                 return RESULT_NOT_200_OK;
@@ -992,6 +1054,20 @@ bail:
         return r;
     }
 
+    static Result DoDoRequest(HClient client, Response& response, const char* path, const char* method)
+    {
+        dmSocket::Result sock_res;
+
+        sock_res = SendRequest(client, &response, path, method);
+
+        if (sock_res != dmSocket::RESULT_OK)
+        {
+            return RESULT_SOCKET_ERROR;
+        }
+
+        return ReceiveResponse(client, response, path, method, false);
+    }
+
     static Result DoRequest(HClient client, const char* path, const char* method)
     {
         // Theoretically we can be in a state where every
@@ -1003,6 +1079,7 @@ bail:
         // "good enough".
         for (uint32_t i = 0; i < MAX_POOL_CONNECTIONS + 1; ++i) {
             Response response(client);
+            response.m_RequestIndex = client->m_RequestIndex;
             client->m_Statistics.m_Responses++;
 
             client->m_SocketResult = dmSocket::RESULT_OK;
@@ -1054,6 +1131,7 @@ bail:
     static Result HandleCachedVerified(HClient client, const dmHttpCache::EntryInfo* info)
     {
         Response response(client);
+        response.m_RequestIndex = client->m_RequestIndex;
         client->m_Statistics.m_DirectFromCache++;
 
         FILE* file = 0;
@@ -1081,30 +1159,39 @@ bail:
         }
     }
 
+    // Returns true if the request for client->m_URI was served directly from the cache
+    static bool GetDirectFromCache(HClient client)
+    {
+        if (!UseCache(client))
+        {
+            return false;
+        }
+
+        dmHttpCache::ConsistencyPolicy policy = dmHttpCache::GetConsistencyPolicy(client->m_HttpCache);
+        dmHttpCache::EntryInfo info;
+        dmHttpCache::Result cache_r = dmHttpCache::GetInfo(client->m_HttpCache, client->m_URI, &info);
+        if (cache_r == dmHttpCache::RESULT_OK) {
+            bool ok_etag = info.m_Verified && policy == dmHttpCache::CONSISTENCY_POLICY_TRUST_CACHE;
+            if ((ok_etag || info.m_Valid)) {
+                // We have a cache and trust the content of the cache
+                // OR
+                // the entry is valid in terms of max-age
+                return HandleCachedVerified(client, &info) == RESULT_NOT_200_OK;
+            }
+        }
+        return false;
+    }
+
     Result Get(HClient client, const char* path)
     {
-        dmSnPrintf(client->m_URI, sizeof(client->m_URI), "%s://%s:%d/%s", client->m_Secure ? "https" : "http", client->m_Hostname, (int) client->m_Port, path);
+        SetURI(client, path);
         client->m_RequestStart = dmTime::GetTime();
 
-        Result r;
-
-        if (!client->m_IgnoreCache && client->m_HttpCache)
-        {
-            dmHttpCache::ConsistencyPolicy policy = dmHttpCache::GetConsistencyPolicy(client->m_HttpCache);
-            dmHttpCache::EntryInfo info;
-            dmHttpCache::Result cache_r = dmHttpCache::GetInfo(client->m_HttpCache, client->m_URI, &info);
-            if (cache_r == dmHttpCache::RESULT_OK) {
-                bool ok_etag = info.m_Verified && policy == dmHttpCache::CONSISTENCY_POLICY_TRUST_CACHE;
-                if ((ok_etag || info.m_Valid)) {
-                    // We have a cache and trust the content of the cache
-                    // OR
-                    // the entry is valid in terms of max-age
-                    r = HandleCachedVerified(client, &info);
-                    if (r == RESULT_NOT_200_OK) {
-                        return r;
-                    }
-                }
-            }
+        Result r = RESULT_UNKNOWN;
+
+        if (GetDirectFromCache(client))
+        {
+            return RESULT_NOT_200_OK;
         }
 
         for (int i = 0; i < client->m_MaxGetRetries; ++i)
@@ -1134,6 +1221,386 @@ bail:
         return r;
     }
 
+    // Sends the requests on one connection before reading the responses.
+    // Returns the number of requests that got a complete response in *completed. *stale is set if
+    // the pooled connection turned out to be closed by the server before any response was read.
+    static Result DoPipelinedRequests(HClient client, const char** paths, const uint32_t* indices, uint32_t count, HttpPipelinedResponse callback, uint32_t* completed, bool* stale)
+    {
+        *completed = 0;
+        *stale = false;
+
+        client->m_SocketResult = dmSocket::RESULT_OK;
+        client->m_RequestStart = dmTime::GetTime();
+
+        // Owns the pooled connection. The responses below only borrow its socket
+        Response connection(client);
+        Result r = connection.Connect(client->m_Hostname, client->m_Port, client->m_Secure, client->m_RequestTimeout, client->m_CancelFlag);
+        if (r != RESULT_OK) {
+            return r;
+        }
+
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            const char* path = paths[indices[i]];
+            SetURI(client, path);
+
+            Response request(client);
+            request.m_RequestIndex = indices[i];
+            request.m_Socket = connection.m_Socket;
+            request.m_SSLSocket = connection.m_SSLSocket;
+            if (SendRequest(client, &request, path, "GET") != dmSocket::RESULT_OK)
+            {
+                connection.m_CloseConnection = 1;
+                *stale = dmConnectionPool::GetReuseCount(connection.m_Pool, connection.m_Connection) > 0;
+                return RESULT_SOCKET_ERROR;
+            }
+        }
+
+        int extra = 0;
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            const char* path = paths[indices[i]];
+            SetURI(client, path);
+            client->m_RequestIndex = indices[i];
+            client->m_RequestStart = dmTime::GetTime();
+            client->m_Statistics.m_Responses++;
+
+            Response response(client);
+            response.m_RequestIndex = indices[i];
+            response.m_Socket = connection.m_Socket;
+            response.m_SSLSocket = connection.m_SSLSocket;
+            // Data received after the previous response belongs to this one
+            response.m_TotalReceived = extra;
+
+            r = ReceiveResponse(client, response, path, "GET", i < count - 1);
+            if (r != RESULT_OK && r != RESULT_NOT_200_OK)
+            {
+                connection.m_CloseConnection = 1;
+                *stale = i == 0 && response.m_TotalReceived == 0 && dmConnectionPool::GetReuseCount(connection.m_Pool, connection.m_Connection) > 0;
+                return r;
+            }
+
+            callback(client, client->m_Userdata, indices[i], r);
+            *completed = i + 1;
+            extra = response.m_TotalReceived;
+
+            if (response.m_CloseConnection)
+            {
+                // The server won't respond to the remaining requests
+                connection.m_CloseConnection = 1;
+                break;
+            }
+        }
+        return RESULT_OK;
+    }
+
+    Result GetPipelined(HClient client, const char** paths, uint32_t count, HttpPipelinedResponse callback)
+    {
+        Result result = RESULT_OK;
+        uint32_t indices[MAX_PIPELINE_DEPTH];
+
+        uint32_t i = 0;
+        while (i < count)
+        {
+            uint32_t n = 0;
+            for (; i < count && n < MAX_PIPELINE_DEPTH; ++i)
+            {
+                SetURI(client, paths[i]);
+                client->m_RequestIndex = i;
+                if (GetDirectFromCache(client))
+                {
+                    callback(client, client->m_Userdata, i, RESULT_NOT_200_OK);
+                }
+                else
+                {
+                    indices[n++] = i;
+                }
+            }
+
+            uint32_t completed = 0;
+            if (n > 1)
+            {
+                // A pooled connection might have been closed by the server, see DoRequest()
+                for (uint32_t attempt = 0; attempt < MAX_POOL_CONNECTIONS + 1; ++attempt)
+                {
+                    bool stale;
+                    DoPipelinedRequests(client, paths, indices, n, callback, &completed, &stale);
+                    if (!stale || HasRequestTimedOut(client))
+                        break;
+                    client->m_Statistics.m_Reconnections++;
+                }
+            }
+
+            // Requests without a response are retried one at a time
+            for (uint32_t j = completed; j < n; ++j)
+            {
+                client->m_RequestIndex = indices[j];
+                Result r = Get(client, paths[indices[j]]);
+                if (r != RESULT_OK && r != RESULT_NOT_200_OK && result == RESULT_OK)
+                {
+                    result = r;
+                }
+                callback(client, client->m_Userdata, indices[j], r);
+            }
+        }
+
+        client->m_RequestIndex = 0;
+        return result;
+    }
+
+    uint32_t GetRequestIndex(HResponse response)
+    {
+        return response->m_RequestIndex;
+    }
+
+    Result GetRange(HClient client, const char* path, uint32_t offset, uint32_t size)
+    {
+        if (size == 0)
+        {
+            return RESULT_INVAL;
+        }
+
+        client->m_RangeOffset = offset;
+        client->m_RangeSize = size;
+        Result r = Get(client, path);
+        client->m_RangeOffset = 0;
+        client->m_RangeSize = 0;
+        return r;
+    }
+
+    struct RangeDownload
+    {
+        uint8_t*    m_Buffer;
+        uint32_t    m_BufferSize;
+        int*        m_ParentCancelFlag;
+        // Cancels all ranges. Used as cancel flag for the range clients
+        int         m_Cancel;
+    };
+
+    struct Range
+    {
+        RangeDownload*      m_Download;
+        HClient             m_Client;
+        const char*         m_Path;
+        uint32_t            m_Offset;
+        uint32_t            m_Size;
+        uint32_t            m_Received;
+        // Size of the whole resource, from Content-Range or Content-Length. -1 if unknown
+        int64_t             m_ResourceSize;
+        int                 m_Status;
+        Result              m_Result;
+        dmThread::Thread    m_Thread;
+        // Accept a 200 response with the whole resource, ie when the server doesn't support ranges
+        uint8_t             m_AcceptWhole : 1;
+        uint8_t             m_Overflow : 1;
+    };
+
+    static void RangeHeader(HResponse response, void* user_data, int status_code, const char* key, const char* value)
+    {
+        Range* range = (Range*) user_data;
+        if (status_code == 206 && dmStrCaseCmp(key, "Content-Range") == 0)
+        {
+            // E.g. "bytes 0-1023/146515". The size is "*" if unknown
+            const char* size = strchr(value, '/');
+            if (size && size[1] != '*')
+            {
+                range->m_ResourceSize = strtoll(size + 1, 0, 10);
+            }
+        }
+        else if (status_code == 200 && dmStrCaseCmp(key, "Content-Length") == 0)
+        {
+            range->m_ResourceSize = strtoll(value, 0, 10);
+        }
+    }
+
+    static void RangeContent(HResponse response, void* user_data, int status_code, const void* content_data, uint32_t content_data_size, int32_t content_length)
+    {
+        Range* range = (Range*) user_data;
+        RangeDownload* download = range->m_Download;
+        range->m_Status = status_code;
+
+        if (download->m_ParentCancelFlag && *download->m_ParentCancelFlag)
+        {
+            download->m_Cancel = 1;
+        }
+
+        if (!content_data && !content_data_size)
+        {
+            // (Re)start of the response
+            range->m_Received = 0;
+            return;
+        }
+
+        uint32_t begin;
+        uint32_t end;
+        if (status_code == 206)
+        {
+            begin = range->m_Offset;
+            end = range->m_Offset + range->m_Size;
+        }
+        else if (status_code == 200 && range->m_AcceptWhole)
+        {
+            begin = 0;
+            end = download->m_BufferSize;
+        }
+        else
+        {
+            return;
+        }
+
+        if (end - begin - range->m_Received < content_data_size)
+        {
+            range->m_Overflow = 1;
+            download->m_Cancel = 1;
+            return;
+        }
+        memcpy(download->m_Buffer + begin + range->m_Received, content_data, content_data_size);
+        range->m_Received += content_data_size;
+    }
+
+    static bool IsRangeComplete(const Range* range)
+    {
+        return range->m_Result == RESULT_OK && range->m_Status == 206 && range->m_Received == range->m_Size;
+    }
+
+    static void RangeThread(void* arg)
+    {
+        Range* range = (Range*) arg;
+        range->m_Result = GetRange(range->m_Client, range->m_Path, range->m_Offset, range->m_Size);
+        if (!IsRangeComplete(range))
+        {
+            // No point in continuing with the other ranges
+            range->m_Download->m_Cancel = 1;
+        }
+    }
+
+    Result GetRanges(HClient client, const char* path, void* buffer, uint32_t buffer_size, uint32_t max_connections, uint32_t* size)
+    {
+        if (buffer_size == 0 || max_connections == 0)
+        {
+            return RESULT_INVAL;
+        }
+        uint32_t num_connections = dmMath::Min(max_connections, MAX_RANGE_CONNECTIONS);
+
+        RangeDownload download;
+        download.m_Buffer = (uint8_t*) buffer;
+        download.m_BufferSize = buffer_size;
+        download.m_ParentCancelFlag = client->m_CancelFlag;
+        download.m_Cancel = 0;
+
+        Range ranges[MAX_RANGE_CONNECTIONS];
+        memset(ranges, 0, sizeof(ranges));
+
+        NewParams params;
+        params.m_HttpContent = &RangeContent;
+        params.m_HttpHeader = &RangeHeader;
+        params.m_MaxGetRetries = client->m_MaxGetRetries;
+        params.m_RequestTimeout = client->m_RequestTimeout;
+        for (uint32_t i = 0; i < num_connections; ++i)
+        {
+            params.m_Userdata = &ranges[i];
+            ranges[i].m_Download = &download;
+            // The host name is already resolved, so skip the lookup in New()
+            ranges[i].m_Client = CreateClient(&params, client->m_Hostname, client->m_Port, client->m_Secure, &download.m_Cancel);
+            ranges[i].m_Path = path;
+            ranges[i].m_ResourceSize = -1;
+        }
+
+        // Probe with the leading bytes to learn the size of the resource
+        Range* probe = &ranges[0];
+        probe->m_Offset = 0;
+        probe->m_Size = dmMath::Min(RANGE_PROBE_SIZE, buffer_size);
+        probe->m_AcceptWhole = 1;
+        Result r = GetRange(probe->m_Client, path, probe->m_Offset, probe->m_Size);
+        probe->m_AcceptWhole = 0;
+
+        int64_t resource_size = probe->m_ResourceSize;
+        if (probe->m_Overflow || resource_size > (int64_t) buffer_size)
+        {
+            r = RESULT_INVAL;
+        }
+        else if (r == RESULT_OK && probe->m_Status == 200)
+        {
+            // The server doesn't support ranges and sent the whole resource
+            if (resource_size != -1 && resource_size != probe->m_Received)
+                r = RESULT_PARTIAL_CONTENT;
+            resource_size = probe->m_Received;
+        }
+        else if (r == RESULT_OK)
+        {
+            if (resource_size == -1)
+            {
+                dmLogWarning("No resource size in range response for '%s'", path);
+                r = RESULT_INVALID_RESPONSE;
+            }
+            else if (probe->m_Received != dmMath::Min((int64_t) probe->m_Size, resource_size))
+            {
+                r = RESULT_PARTIAL_CONTENT;
+            }
+        }
+
+        if (r == RESULT_OK && resource_size > probe->m_Size && probe->m_Status == 206)
+        {
+            uint32_t offset = probe->m_Size;
+            uint32_t remaining = (uint32_t) resource_size - offset;
+            uint32_t count = dmMath::Max(1U, dmMath::Min(num_connections, remaining / RANGE_MIN_SIZE));
+            uint32_t range_size = remaining / count;
+
+            for (uint32_t i = 0; i < count; ++i)
+            {
+                Range* range = &ranges[i];
+                range->m_Offset = offset;
+                range->m_Size = i == count - 1 ? remaining : range_size;
+                offset += range->m_Size;
+                remaining -= range->m_Size;
+            }
+
+            // The first range is downloaded on this thread
+            for (uint32_t i = 1; i < count; ++i)
+            {
+                if (dmThread::PlatformHasThreadSupport())
+                    ranges[i].m_Thread = dmThread::New(RangeThread, RANGE_THREAD_STACK_SIZE, &ranges[i], "http_range");
+                else
+                    RangeThread(&ranges[i]);
+            }
+            RangeThread(&ranges[0]);
+
+            for (uint32_t i = 0; i < count; ++i)
+            {
+                if (ranges[i].m_Thread)
+                    dmThread::Join(ranges[i].m_Thread);
+
+                if (r == RESULT_OK && !IsRangeComplete(&ranges[i]))
+                {
+                    if (ranges[i].m_Overflow)
+                        r = RESULT_INVALID_RESPONSE;
+                    else if (ranges[i].m_Result != RESULT_OK)
+                        r = ranges[i].m_Result;
+                    else if (ranges[i].m_Status != 206 || ranges[i].m_ResourceSize != resource_size)
+                        r = RESULT_INVALID_RESPONSE;
+                    else
+                        r = RESULT_PARTIAL_CONTENT;
+                }
+            }
+        }
+
+        for (uint32_t i = 0; i < num_connections; ++i)
+        {
+            const Statistics& stats = ranges[i].m_Client->m_Statistics;
+            client->m_Statistics.m_Responses += stats.m_Responses;
+            client->m_Statistics.m_Reconnections += stats.m_Reconnections;
+            if (client->m_SocketResult == dmSocket::RESULT_OK)
+                client->m_SocketResult = ranges[i].m_Client->m_SocketResult;
+            Delete(ranges[i].m_Client);
+        }
+
+        if (r == RESULT_OK)
+        {
+            *size = (uint32_t) resource_size;
+        }
+        return r;
+    }
+
     Result Post(HClient client, const char* path)
     {
         return Request(client, "POST", path);
@@ -1144,7 +1611,7 @@ bail:
         if (strcmp(method, "GET") == 0) {
             return Get(client, path);
         } else {
-            dmSnPrintf(client->m_URI, sizeof(client->m_URI), "%s://%s:%d/%s", client->m_Secure ? "https" : "http", client->m_Hostname, (int) client->m_Port, path);
+            SetURI(client, path);
             client->m_RequestStart = dmTime::GetTime();
             Result r = DoRequest(client, path, method);
             return r;
@@ -96,6 +96,16 @@ namespace dmHttpClient
      */
     typedef Result (*HttpWriteHeaders)(HResponse response, void* user_data);
 
+    /**
+     * HTTP pipelined request callback. Invoked once for each request passed to GetPipelined(),
+     * after the content of the response has been delivered.
+     * @param client Client handle
+     * @param user_data User data
+     * @param index Index of the request in the paths passed to GetPipelined()
+     * @param result Result of the request, same as for Get()
+     */
+    typedef void (*HttpPipelinedResponse)(HClient client, void* user_data, uint32_t index, Result result);
+
     /**
      * HTTP-client options
      */
@@ -216,6 +226,53 @@ namespace dmHttpClient
      */
     Result Get(HClient client, const char* path);
 
+    /**
+     * HTTP GET-requests pipelined on a single connection, ie the requests are sent without
+     * waiting for the previous responses. The responses are delivered in order through the regular
+     * callbacks, use GetRequestIndex() to tell which request a response belongs to.
+     * Requests that can't be completed on the pipelined connection, e.g. when the server closes it,
+     * are retried one at a time as with Get().
+     * @param client Client handle
+     * @param paths Path parts of the URIs
+     * @param count Number of paths
+     * @param callback Invoked with the result of each request
+     * @return RESULT_OK if all requests got a response, otherwise the first error
+     */
+    Result GetPipelined(HClient client, const char** paths, uint32_t count, HttpPipelinedResponse callback);
+
+    /**
+     * HTTP GET-request for a byte range. The response status is 206 (Partial Content), or 200 with
+     * the whole resource if the server doesn't support range requests. The http-cache isn't used.
+     * @param client Client handle
+     * @param path Path part of URI
+     * @param offset Offset of the first byte
+     * @param size Number of bytes
+     * @return RESULT_OK on success
+     */
+    Result GetRange(HClient client, const char* path, uint32_t offset, uint32_t size);
+
+    /**
+     * Download a resource into a buffer. Large resources are split into byte ranges that are downloaded
+     * in parallel, on one thread and connection per range. If the server doesn't support range requests
+     * the resource is downloaded with a single request.
+     * The content and header callbacks of the client aren't invoked, and the http-cache isn't used.
+     * @param client Client handle
+     * @param path Path part of URI
+     * @param buffer Buffer
+     * @param buffer_size Buffer size
+     * @param max_connections Maximum number of parallel connections
+     * @param size Size of the resource [out]
+     * @return RESULT_OK on success. RESULT_INVAL if the resource doesn't fit in the buffer
+     */
+    Result GetRanges(HClient client, const char* path, void* buffer, uint32_t buffer_size, uint32_t max_connections, uint32_t* size);
+
+    /**
+     * Get the index of the request that a response belongs to
+     * @param response Response handle
+     * @return Index into the paths passed to GetPipelined(). 0 for other requests
+     */
+    uint32_t GetRequestIndex(HResponse response);
+
     /**
      * HTTP POST-request
      * @param client Client handle
@@ -16,8 +16,11 @@
 #include <stdlib.h>
 #include <string.h>
 #include "array.h"
+#include "atomic.h"
 #include "log.h"
 #include "math.h"
+#include "mutex.h"
+#include "thread.h"
 #include "time.h"
 #include "dstrings.h"
 #include "http_server.h"
@@ -25,15 +28,44 @@
 #include "network_constants.h"
 #include <dlib/socket.h>
 
+#if defined(__linux__) && !defined(__EMSCRIPTEN__)
+    #define DM_HTTP_SERVER_EPOLL
+    #include <errno.h>
+    #include <unistd.h>
+    #include <sys/epoll.h>
+    #include <sys/sendfile.h>
+#elif defined(__MACH__)
+    #define DM_HTTP_SERVER_KQUEUE
+    #include <errno.h>
+    #include <unistd.h>
+    #include <sys/types.h>
+    #include <sys/event.h>
+    #include <sys/socket.h>
+    #include <sys/uio.h>
+#endif
+
+#if defined(DM_HTTP_SERVER_EPOLL) || defined(DM_HTTP_SERVER_KQUEUE)
+    #define DM_HTTP_SERVER_POLLER
+#endif
 
 namespace dmHttpServer
 {
     const uint32_t BUFFER_SIZE = 64 * 1024;
 
+    // The states are only used in threaded mode
+    enum ConnectionState
+    {
+        CONNECTION_STATE_FREE  = 0, // Unused connection slot
+        CONNECTION_STATE_IDLE  = 1, // Waiting for a request, owned by the server thread
+        CONNECTION_STATE_READY = 2, // A request is pending or being handled
+    };
+
     struct Connection
     {
         dmSocket::Socket m_Socket;
         uint16_t         m_RequestCount;
+        uint16_t         m_State;
+        uint16_t         m_Generation; // Incremented when the slot is freed, see ConnectionToken()
         uint64_t         m_ConnectionTimeStart;
     };
 
@@ -43,6 +75,8 @@ namespace dmHttpServer
         {
             m_ServerSocket = dmSocket::INVALID_SOCKET_HANDLE;
             m_Reconnect = 0;
+            m_Threaded = 0;
+            m_RespondOnServerThread = 0;
         }
         dmSocket::Address   m_Address;
         uint16_t            m_Port;
@@ -57,7 +91,23 @@ namespace dmHttpServer
         // Receive and send buffer
         char                m_Buffer[BUFFER_SIZE];
 
+#if defined(DM_HTTP_SERVER_POLLER)
+        // Threaded mode. m_Connections is a fixed array of slots, and the slot index and generation is the poller token.
+        // m_Mutex protects the connection states, m_FreeConnections and m_Ready
+        dmThread::Thread    m_Thread;
+        dmMutex::HMutex     m_Mutex;
+        int                 m_Poller;
+        int                 m_WakeupPipe[2];
+        dmArray<uint16_t>   m_FreeConnections;
+        // Connections with a pending request, handled in Update()
+        dmArray<uint16_t>   m_Ready;
+        dmArray<uint16_t>   m_Handling;
+        int32_atomic_t      m_Quit;
+#endif
+
         uint32_t            m_Reconnect : 1;
+        uint32_t            m_Threaded : 1;
+        uint32_t            m_RespondOnServerThread : 1;
     };
 
     struct InternalRequest
@@ -96,6 +146,10 @@ namespace dmHttpServer
     };
 
     static void FlushSendBuffer(const Request* request);
+#if defined(DM_HTTP_SERVER_POLLER)
+    static bool StartServerThread(Server* server, const NewParams* params);
+    static void StopServerThread(Server* server);
+#endif
 
     void SetDefaultParams(struct NewParams* params)
     {
@@ -183,7 +237,17 @@ namespace dmHttpServer
         ret->m_HttpResponse = params->m_HttpResponse;
         ret->m_Userdata = params->m_Userdata;
         ret->m_ConnectionTimeout = params->m_ConnectionTimeout * 1000000U;
-        ret->m_Connections.SetCapacity(params->m_MaxConnections);
+
+#if defined(DM_HTTP_SERVER_POLLER)
+        if (params->m_Threaded && !StartServerThread(ret, params))
+        {
+            dmLogWarning("Unable to start http server thread, falling back to polling in Update");
+        }
+#endif
+        if (!ret->m_Threaded)
+        {
+            ret->m_Connections.SetCapacity(params->m_MaxConnections);
+        }
 
         *server = ret;
         return RESULT_OK;
@@ -191,6 +255,12 @@ namespace dmHttpServer
 
     void Delete(HServer server)
     {
+#if defined(DM_HTTP_SERVER_POLLER)
+        if (server->m_Threaded)
+        {
+            StopServerThread(server);
+        }
+#endif
         // TODO: Shutdown connections
         dmSocket::Delete(server->m_ServerSocket);
         delete server;
@@ -431,6 +501,103 @@ bail:
         return internal_req->m_Result;
     }
 
+    // Send size bytes of file as the body of the current chunk
+    static bool SendFileData(InternalRequest* internal_req, FILE* file, uint32_t size)
+    {
+        uint32_t offset = 0;
+#if defined(DM_HTTP_SERVER_EPOLL)
+        int fd = fileno(file);
+        off_t file_offset = 0;
+        while (offset < size)
+        {
+            ssize_t sent = sendfile(internal_req->m_Socket, fd, &file_offset, size - offset);
+            if (sent < 0 && (errno == EINTR || errno == EAGAIN))
+                continue;
+            if (sent < 0 && offset == 0 && (errno == EINVAL || errno == ENOSYS))
+                break; // Not supported for this file, use the fallback below
+            if (sent <= 0)
+                return false;
+            offset = (uint32_t) file_offset;
+        }
+#elif defined(DM_HTTP_SERVER_KQUEUE)
+        int fd = fileno(file);
+        while (offset < size)
+        {
+            off_t len = size - offset;
+            int r = sendfile(fd, internal_req->m_Socket, offset, &len, 0, 0);
+            offset += (uint32_t) len;
+            if (r < 0 && (errno == EINTR || errno == EAGAIN))
+                continue;
+            if (r < 0 && offset == 0 && (errno == ENOTSUP || errno == EOPNOTSUPP))
+                break; // Not supported for this file, use the fallback below
+            if (r < 0 || len == 0)
+                return offset == size;
+        }
+#endif
+        if (offset < size && fseek(file, offset, SEEK_SET) != 0)
+            return false;
+
+        // The request content is already received, so the buffer is free to use
+        char* buffer = internal_req->m_Server->m_Buffer;
+        while (offset < size)
+        {
+            size_t n = fread(buffer, 1, dmMath::Min(BUFFER_SIZE, size - offset), file);
+            if (n == 0)
+                return false;
+            if (SendAll(internal_req->m_Socket, buffer, (int) n) != dmSocket::RESULT_OK)
+                return false;
+            offset += (uint32_t) n;
+        }
+        return true;
+    }
+
+    Result SendFile(const Request* request, const char* path)
+    {
+        InternalRequest* internal_req = (InternalRequest*) request->m_Internal;
+        if (internal_req->m_Result != RESULT_OK)
+            return internal_req->m_Result;
+
+        FILE* file = fopen(path, "rb");
+        if (!file)
+            return RESULT_ERROR_INVAL;
+
+        long size = -1;
+        if (fseek(file, 0, SEEK_END) == 0)
+        {
+            size = ftell(file);
+            fseek(file, 0, SEEK_SET);
+        }
+        if (size < 0)
+        {
+            fclose(file);
+            return RESULT_ERROR_INVAL;
+        }
+
+        if (!internal_req->m_HeaderSent)
+            SendHeader(internal_req);
+
+        if (!internal_req->m_AttributesSent)
+            SendAttributes(internal_req);
+
+        FlushSendBuffer(request);
+
+        // Empty chunks terminate the response, see Send()
+        if (internal_req->m_Result == RESULT_OK && size > 0)
+        {
+            char buf[16];
+            dmSnPrintf(buf, sizeof(buf), "%lx\r\n", size);
+            if (SendAll(internal_req->m_Socket, buf, strlen(buf)) != dmSocket::RESULT_OK ||
+                !SendFileData(internal_req, file, (uint32_t) size) ||
+                SendAll(internal_req->m_Socket, "\r\n", 2) != dmSocket::RESULT_OK)
+            {
+                internal_req->m_Result = RESULT_SOCKET_ERROR;
+            }
+        }
+
+        fclose(file);
+        return internal_req->m_Result;
+    }
+
     Result SendAttribute(const Request* request, const char* key, const char* value)
     {
         dmSocket::Result r;
@@ -581,8 +748,350 @@ bail:
         }
     }
 
+#if defined(DM_HTTP_SERVER_POLLER)
+    static const uint32_t TOKEN_LISTEN = 0xffffffff;
+    static const uint32_t TOKEN_WAKEUP = 0xfffffffe;
+    static const int      POLLER_MAX_EVENTS = 64;
+    static const int      POLLER_TIMEOUT_MS = 250;
+
+#if defined(DM_HTTP_SERVER_EPOLL)
+    static int PollerNew()
+    {
+        return epoll_create1(EPOLL_CLOEXEC);
+    }
+
+    // Arm fd to be reported once when it becomes readable. It must be armed again to be reported again
+    static bool PollerArm(int poller, int fd, uint32_t token, bool add)
+    {
+        struct epoll_event event;
+        memset(&event, 0, sizeof(event));
+        event.events = EPOLLIN | EPOLLONESHOT;
+        event.data.u32 = token;
+        return epoll_ctl(poller, add ? EPOLL_CTL_ADD : EPOLL_CTL_MOD, fd, &event) == 0;
+    }
+
+    static void PollerRemove(int poller, int fd)
+    {
+        struct epoll_event event;
+        epoll_ctl(poller, EPOLL_CTL_DEL, fd, &event);
+    }
+
+    static int PollerWait(int poller, uint32_t* tokens, int max_tokens, int timeout_ms)
+    {
+        struct epoll_event events[POLLER_MAX_EVENTS];
+        int n = epoll_wait(poller, events, dmMath::Min(max_tokens, POLLER_MAX_EVENTS), timeout_ms);
+        for (int i = 0; i < n; ++i)
+        {
+            tokens[i] = events[i].data.u32;
+        }
+        return dmMath::Max(n, 0);
+    }
+#elif defined(DM_HTTP_SERVER_KQUEUE)
+    static int PollerNew()
+    {
+        return kqueue();
+    }
+
+    // Arm fd to be reported once when it becomes readable. It must be armed again to be reported again
+    static bool PollerArm(int poller, int fd, uint32_t token, bool add)
+    {
+        (void) add;
+        struct kevent event;
+        EV_SET(&event, fd, EVFILT_READ, EV_ADD | EV_ONESHOT, 0, 0, (void*) (uintptr_t) token);
+        return kevent(poller, &event, 1, 0, 0, 0) == 0;
+    }
+
+    static void PollerRemove(int poller, int fd)
+    {
+        // Fails if the one-shot event already fired, which is fine
+        struct kevent event;
+        EV_SET(&event, fd, EVFILT_READ, EV_DELETE, 0, 0, 0);
+        kevent(poller, &event, 1, 0, 0, 0);
+    }
+
+    static int PollerWait(int poller, uint32_t* tokens, int max_tokens, int timeout_ms)
+    {
+        struct kevent events[POLLER_MAX_EVENTS];
+        struct timespec timeout;
+        timeout.tv_sec = timeout_ms / 1000;
+        timeout.tv_nsec = (timeout_ms % 1000) * 1000000;
+        int n = kevent(poller, 0, 0, events, dmMath::Min(max_tokens, POLLER_MAX_EVENTS), &timeout);
+        for (int i = 0; i < n; ++i)
+        {
+            tokens[i] = (uint32_t) (uintptr_t) events[i].udata;
+        }
+        return dmMath::Max(n, 0);
+    }
+#endif
+
+    // A slot can be freed and reused while an event for its previous socket is in the same batch of
+    // events. The generation in the token tells the events of the previous socket apart.
+    // The top bit is never set, so it can't be mistaken for TOKEN_LISTEN or TOKEN_WAKEUP
+    static inline uint32_t ConnectionToken(Server* server, uint16_t index)
+    {
+        return ((uint32_t) (server->m_Connections[index].m_Generation & 0x7fff) << 16) | index;
+    }
+
+    static void CloseSocket(dmSocket::Socket socket)
+    {
+        dmSocket::Shutdown(socket, dmSocket::SHUTDOWNTYPE_READWRITE);
+        dmSocket::Delete(socket);
+    }
+
+    // The mutex must be held
+    static void FreeConnection(Server* server, uint16_t index)
+    {
+        Connection* connection = &server->m_Connections[index];
+        PollerRemove(server->m_Poller, connection->m_Socket);
+        CloseSocket(connection->m_Socket);
+        connection->m_Socket = dmSocket::INVALID_SOCKET_HANDLE;
+        connection->m_State = CONNECTION_STATE_FREE;
+        connection->m_Generation++;
+        server->m_FreeConnections.Push(index);
+    }
+
+    // Make room in a full keep-alive pool by closing the connection that has been idle the longest.
+    // The mutex must be held
+    static bool EvictIdleConnection(Server* server)
+    {
+        uint32_t oldest = server->m_Connections.Size();
+        for (uint32_t i = 0; i < server->m_Connections.Size(); ++i)
+        {
+            Connection* connection = &server->m_Connections[i];
+            if (connection->m_State == CONNECTION_STATE_IDLE &&
+                (oldest == server->m_Connections.Size() || connection->m_ConnectionTimeStart < server->m_Connections[oldest].m_ConnectionTimeStart))
+            {
+                oldest = i;
+            }
+        }
+        if (oldest == server->m_Connections.Size())
+            return false;
+
+        FreeConnection(server, (uint16_t) oldest);
+        return true;
+    }
+
+    static void CloseIdleConnections(Server* server, uint64_t current_time)
+    {
+        DM_MUTEX_SCOPED_LOCK(server->m_Mutex);
+        for (uint32_t i = 0; i < server->m_Connections.Size(); ++i)
+        {
+            Connection* connection = &server->m_Connections[i];
+            if (connection->m_State == CONNECTION_STATE_IDLE &&
+                current_time - connection->m_ConnectionTimeStart > server->m_ConnectionTimeout)
+            {
+                FreeConnection(server, (uint16_t) i);
+            }
+        }
+    }
+
+    static void AcceptConnection(Server* server)
+    {
+        dmSocket::Address address;
+        dmSocket::Socket client_socket;
+        dmSocket::Result r = dmSocket::Accept(server->m_ServerSocket, &address, &client_socket);
+        if (r == dmSocket::RESULT_CONNABORTED || r == dmSocket::RESULT_NOTCONN)
+        {
+            dmLogWarning("Reconnecting http server (%d)", server->m_Port);
+            PollerRemove(server->m_Poller, server->m_ServerSocket);
+            if (Connect(server, server->m_Port) != RESULT_OK ||
+                !PollerArm(server->m_Poller, server->m_ServerSocket, TOKEN_LISTEN, true))
+            {
+                dmLogError("Unable to reconnect http server (%d)", server->m_Port);
+            }
+            return;
+        }
+
+        if (r == dmSocket::RESULT_OK)
+        {
+            dmSocket::SetNoDelay(client_socket, true);
+
+            DM_MUTEX_SCOPED_LOCK(server->m_Mutex);
+            if (server->m_FreeConnections.Empty() && !EvictIdleConnection(server))
+            {
+                dmLogWarning("Out of client connections in http server (max: %d)", server->m_Connections.Size());
+                CloseSocket(client_socket);
+            }
+            else
+            {
+                uint16_t index = server->m_FreeConnections.Back();
+                server->m_FreeConnections.Pop();
+                Connection* connection = &server->m_Connections[index];
+                connection->m_Socket = client_socket;
+                connection->m_RequestCount = 0;
+                connection->m_State = CONNECTION_STATE_IDLE;
+                connection->m_ConnectionTimeStart = dmTime::GetTime();
+                if (!PollerArm(server->m_Poller, client_socket, ConnectionToken(server, index), true))
+                {
+                    FreeConnection(server, index);
+                }
+            }
+        }
+
+        PollerArm(server->m_Poller, server->m_ServerSocket, TOKEN_LISTEN, false);
+    }
+
+    // Handle the pending request of a connection in the ready state, and hand it back to the server thread
+    static void HandleReadyConnection(Server* server, uint16_t index)
+    {
+        Connection* connection = &server->m_Connections[index];
+        bool keep_connection = HandleConnection(server, connection);
+
+        DM_MUTEX_SCOPED_LOCK(server->m_Mutex);
+        if (keep_connection)
+        {
+            connection->m_RequestCount++;
+            connection->m_State = CONNECTION_STATE_IDLE;
+            connection->m_ConnectionTimeStart = dmTime::GetTime();
+            if (PollerArm(server->m_Poller, connection->m_Socket, ConnectionToken(server, index), false))
+                return;
+        }
+        FreeConnection(server, index);
+    }
+
+    static void ServerThread(void* arg)
+    {
+        Server* server = (Server*) arg;
+        uint32_t tokens[POLLER_MAX_EVENTS];
+        uint64_t last_timeout_check = dmTime::GetTime();
+
+        while (!dmAtomicGet32(&server->m_Quit))
+        {
+            int n = PollerWait(server->m_Poller, tokens, POLLER_MAX_EVENTS, POLLER_TIMEOUT_MS);
+            for (int i = 0; i < n; ++i)
+            {
+                uint32_t token = tokens[i];
+                if (token == TOKEN_WAKEUP)
+                {
+                    continue;
+                }
+                else if (token == TOKEN_LISTEN)
+                {
+                    AcceptConnection(server);
+                    continue;
+                }
+
+                uint16_t index = (uint16_t) token;
+                {
+                    DM_MUTEX_SCOPED_LOCK(server->m_Mutex);
+                    Connection* connection = &server->m_Connections[index];
+                    // The event is stale if the connection was closed, e.g. evicted, earlier in the batch
+                    if (connection->m_State != CONNECTION_STATE_IDLE || ConnectionToken(server, index) != token)
+                        continue;
+                    connection->m_State = CONNECTION_STATE_READY;
+                    if (!server->m_RespondOnServerThread)
+                    {
+                        server->m_Ready.Push(index);
+                        continue;
+                    }
+                }
+                HandleReadyConnection(server, index);
+            }
+
+            uint64_t current_time = dmTime::GetTime();
+            if (current_time - last_timeout_check > POLLER_TIMEOUT_MS * 1000U)
+            {
+                CloseIdleConnections(server, current_time);
+                last_timeout_check = current_time;
+            }
+        }
+    }
+
+    static bool StartServerThread(Server* server, const NewParams* params)
+    {
+        server->m_Poller = PollerNew();
+        if (server->m_Poller < 0)
+            return false;
+
+        if (pipe(server->m_WakeupPipe) != 0)
+        {
+            close(server->m_Poller);
+            return false;
+        }
+
+        if (!PollerArm(server->m_Poller, server->m_ServerSocket, TOKEN_LISTEN, true) ||
+            !PollerArm(server->m_Poller, server->m_WakeupPipe[0], TOKEN_WAKEUP, true))
+        {
+            close(server->m_WakeupPipe[0]);
+            close(server->m_WakeupPipe[1]);
+            close(server->m_Poller);
+            return false;
+        }
+
+        uint32_t max_connections = params->m_MaxConnections;
+        server->m_Connections.SetCapacity(max_connections);
+        server->m_Connections.SetSize(max_connections);
+        server->m_FreeConnections.SetCapacity(max_connections);
+        for (uint32_t i = 0; i < max_connections; ++i)
+        {
+            Connection* connection = &server->m_Connections[i];
+            memset(connection, 0, sizeof(*connection));
+            connection->m_Socket = dmSocket::INVALID_SOCKET_HANDLE;
+            server->m_FreeConnections.Push((uint16_t) (max_connections - 1 - i));
+        }
+        server->m_Ready.SetCapacity(max_connections);
+        server->m_Handling.SetCapacity(max_connections);
+
+        server->m_Mutex = dmMutex::New();
+        server->m_Quit = 0;
+        server->m_Threaded = 1;
+        server->m_RespondOnServerThread = params->m_RespondOnServerThread;
+        server->m_Thread = dmThread::New(ServerThread, 0x80000, server, "httpserver");
+        return true;
+    }
+
+    static void StopServerThread(Server* server)
+    {
+        dmAtomicStore32(&server->m_Quit, 1);
+        char c = 0;
+        ssize_t written = write(server->m_WakeupPipe[1], &c, 1);
+        (void) written;
+        dmThread::Join(server->m_Thread);
+
+        for (uint32_t i = 0; i < server->m_Connections.Size(); ++i)
+        {
+            Connection* connection = &server->m_Connections[i];
+            if (connection->m_State != CONNECTION_STATE_FREE)
+            {
+                CloseSocket(connection->m_Socket);
+            }
+        }
+
+        close(server->m_WakeupPipe[0]);
+        close(server->m_WakeupPipe[1]);
+        close(server->m_Poller);
+        dmMutex::Delete(server->m_Mutex);
+    }
+
+    // Threaded mode. Only the connections with a pending request are touched
+    static Result UpdateThreaded(Server* server)
+    {
+        if (server->m_RespondOnServerThread)
+            return RESULT_OK;
+
+        {
+            DM_MUTEX_SCOPED_LOCK(server->m_Mutex);
+            server->m_Handling.Swap(server->m_Ready);
+        }
+
+        for (uint32_t i = 0; i < server->m_Handling.Size(); ++i)
+        {
+            HandleReadyConnection(server, server->m_Handling[i]);
+        }
+        server->m_Handling.SetSize(0);
+        return RESULT_OK;
+    }
+#endif
+
     Result Update(HServer server)
     {
+#if defined(DM_HTTP_SERVER_POLLER)
+        if (server->m_Threaded)
+        {
+            return UpdateThreaded(server);
+        }
+#endif
+
         if (server->m_Reconnect)
         {
             dmLogWarning("Reconnecting http server (%d)", server->m_Port);
@@ -21,8 +21,13 @@ namespace dmHttpServer
 {
     /**
      * @file
-     * Simple single-threaded HTTP server with multiple persistent clients supported.
+     * Simple HTTP server with multiple persistent clients supported.
      * Http methods sending data, eg put and post, are not supported.
+     *
+     * By default all work is done in #Update. In threaded mode (see NewParams::m_Threaded)
+     * a server thread accepts connections and waits on the idle keep-alive connections with
+     * epoll (Linux, Android) or kqueue (macOS, iOS), and #Update only handles the connections
+     * with a pending request.
      */
 
     /**
@@ -100,9 +105,16 @@ namespace dmHttpServer
         /// Max persistent client connections
         uint16_t    m_MaxConnections;
 
-        /// Connection timeout in seconds
+        /// Connection timeout in seconds. In threaded mode it's the time a connection may stay idle
         uint16_t    m_ConnectionTimeout;
 
+        /// Accept and wait for requests on a server thread. Ignored on platforms without epoll or kqueue
+        uint16_t    m_Threaded : 1;
+
+        /// In threaded mode, call m_HttpHeader and m_HttpResponse on the server thread instead of in #Update.
+        /// The callbacks must then be thread safe
+        uint16_t    m_RespondOnServerThread : 1;
+
         NewParams()
         {
             SetDefaultParams(this);
@@ -136,6 +148,16 @@ namespace dmHttpServer
      */
     Result Send(const Request* request, const void* data, uint32_t data_length);
 
+    /**
+     * Send the content of a file. Uses sendfile() where available, so that the data
+     * isn't copied through user space
+     * @note Any request content must be received before the file is sent
+     * @param request Request
+     * @param path Path of the file to send
+     * @return RESULT_OK on success, RESULT_ERROR_INVAL if the file can't be opened (nothing is sent)
+     */
+    Result SendFile(const Request* request, const char* path);
+
     /**
      * Send attribute
      * @note Only valid to invoke before #Send is invoked
@@ -17,6 +17,7 @@
 #include "message.h"
 #include "atomic.h"
 #include "hash.h"
+#include "flat_hashtable.h"
 #include "hashtable.h"
 #include "array.h"
 #include "condition_variable.h"
@@ -129,7 +130,9 @@ namespace dmMessage
 
     struct MessageContext
     {
-        dmHashTable64<MessageSocket> m_Sockets;
+        // The sockets are allocated separately. The table moves its entries when it rehashes and reuses
+        // the slots of erased entries, while an acquired socket is used outside of the lock
+        dmFlatHashTable64<MessageSocket*> m_Sockets;
     };
 
     MessageContext* g_MessageContext = 0;
@@ -201,14 +204,14 @@ namespace dmMessage
             return RESULT_SOCKET_EXISTS;
         }
 
-        MessageSocket s;
-        s.m_RefCount = 1;
-        s.m_Header = 0;
-        s.m_Tail = 0;
-        s.m_NameHash = name_hash;
-        s.m_Name = strdup(name);
-        s.m_Mutex = dmMutex::New();
-        s.m_Condition = dmConditionVariable::New();
+        MessageSocket* s = new MessageSocket;
+        s->m_RefCount = 1;
+        s->m_Header = 0;
+        s->m_Tail = 0;
+        s->m_NameHash = name_hash;
+        s->m_Name = strdup(name);
+        s->m_Mutex = dmMutex::New();
+        s->m_Condition = dmConditionVariable::New();
 
         g_MessageContext->m_Sockets.Put(name_hash, s);
         *socket = name_hash;
@@ -253,7 +256,7 @@ namespace dmMessage
 
         dmMutex::Delete(s->m_Mutex);
 
-        memset(s, 0, sizeof(*s));
+        delete s;
     }
 
     static void ReleaseSocket(MessageSocket* s)
@@ -279,13 +282,15 @@ namespace dmMessage
 
         DM_SPINLOCK_SCOPED_LOCK(g_MessageSpinlock);
 
-        MessageSocket* s = g_MessageContext->m_Sockets.Get(socket);
+        MessageSocket** socket_ptr = g_MessageContext->m_Sockets.Get(socket);
 
-        if (s == 0x0)
+        if (socket_ptr == 0x0)
         {
             return 0x0;
         }
 
+        MessageSocket* s = *socket_ptr;
+
         assert(s->m_RefCount >= 1);
 
         ++s->m_RefCount;
@@ -298,11 +303,12 @@ namespace dmMessage
         MessageSocket* s = 0x0;
         {
             DM_SPINLOCK_SCOPED_LOCK(g_MessageSpinlock);
-            s = g_MessageContext->m_Sockets.Get(socket);
-            if (s == 0x0)
+            MessageSocket** socket_ptr = g_MessageContext->m_Sockets.Get(socket);
+            if (socket_ptr == 0x0)
             {
                 return RESULT_SOCKET_NOT_FOUND;
             }
+            s = *socket_ptr;
 
             g_MessageContext->m_Sockets.Erase(s->m_NameHash);
             --s->m_RefCount;
@@ -321,7 +327,7 @@ namespace dmMessage
     {
         *out_socket = name_hash; // to silence an existing test
 
-        MessageSocket* message_socket = g_MessageContext->m_Sockets.Get(name_hash);
+        MessageSocket** message_socket = g_MessageContext->m_Sockets.Get(name_hash);
         if (!message_socket)
         {
             return RESULT_NAME_OK_SOCKET_NOT_FOUND;
@@ -349,10 +355,10 @@ namespace dmMessage
     {
         DM_SPINLOCK_SCOPED_LOCK(g_MessageSpinlock);
 
-        MessageSocket* message_socket = g_MessageContext->m_Sockets.Get(socket);
+        MessageSocket** message_socket = g_MessageContext->m_Sockets.Get(socket);
         if (message_socket != 0x0)
         {
-            return message_socket->m_Name;
+            return (*message_socket)->m_Name;
         }
         else
         {
@@ -364,10 +370,10 @@ namespace dmMessage
     {
         DM_SPINLOCK_SCOPED_LOCK(g_MessageSpinlock);
 
-        MessageSocket* message_socket = g_MessageContext->m_Sockets.Get(socket);
+        MessageSocket** message_socket = g_MessageContext->m_Sockets.Get(socket);
         if (message_socket != 0x0)
         {
-            return message_socket->m_NameHash;
+            return (*message_socket)->m_NameHash;
         }
         else
         {
@@ -380,7 +386,7 @@ namespace dmMessage
         if (socket != 0)
         {
             DM_SPINLOCK_SCOPED_LOCK(g_MessageSpinlock);
-            MessageSocket* message_socket = g_MessageContext->m_Sockets.Get(socket);
+            MessageSocket** message_socket = g_MessageContext->m_Sockets.Get(socket);
             return message_socket != 0;
         }
         return false;
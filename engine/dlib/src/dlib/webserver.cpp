@@ -169,6 +169,7 @@ namespace dmWebServer
         http_params.m_HttpResponse = HttpResponse;
         http_params.m_MaxConnections = params->m_MaxConnections;
         http_params.m_ConnectionTimeout = params->m_ConnectionTimeout;
+        http_params.m_Threaded = params->m_Threaded;
 
         dmHttpServer::HServer http_server = 0;
         dmHttpServer::Result http_result;
@@ -273,6 +274,13 @@ namespace dmWebServer
         return TranslateResult(r);
     }
 
+    Result SendFile(Request* request, const char* path)
+    {
+        InternalRequest* internal_request = (InternalRequest*) request->m_Internal;
+        dmHttpServer::Result r = dmHttpServer::SendFile(internal_request->m_Request, path);
+        return TranslateResult(r);
+    }
+
     Result Receive(Request* request, void* buffer, uint32_t buffer_size, uint32_t* received_bytes)
     {
         InternalRequest* internal_request = (InternalRequest*) request->m_Internal;
@@ -40,6 +40,10 @@ namespace dmWebServer
         /// Connection timeout in seconds
         uint16_t    m_ConnectionTimeout;
 
+        /// Accept and wait for requests on a server thread, see dmHttpServer::NewParams::m_Threaded.
+        /// Handlers are still called from #Update
+        uint16_t    m_Threaded : 1;
+
         NewParams()
         {
             SetDefaultParams(this);
@@ -66,6 +70,14 @@ namespace dmWebServer
      */
     Result Update(HServer server);
 
+    /**
+     * Send the content of a file, see dmHttpServer::SendFile
+     * @param request Request
+     * @param path Path of the file to send
+     * @return RESULT_OK on success, RESULT_ERROR_INVAL if the file can't be opened (nothing is sent)
+     */
+    Result SendFile(Request* request, const char* path);
+
     /**
      * Get name for socket, ie address and port
      * @param server Web server
@@ -70,6 +70,8 @@ public class TestHttpServer extends AbstractHandler
 
     Pattern m_AddPattern = Pattern.compile("/add/(\\d+)/(\\d+)");
     Pattern m_ArbPattern = Pattern.compile("/arb/(\\d+)");
+    Pattern m_RangePattern = Pattern.compile("/range/(\\d+)");
+    Pattern m_BytesRangePattern = Pattern.compile("bytes=(\\d+)-(\\d+)");
     Pattern m_CachedPattern = Pattern.compile("/cached/(\\d+)");
     Pattern m_EchoPattern = Pattern.compile("/echo/(.*)");
     Pattern m_ClosePattern = Pattern.compile("/close");
@@ -148,6 +150,7 @@ public class TestHttpServer extends AbstractHandler
     {
         Matcher addm = m_AddPattern.matcher(target);
         Matcher arbm = m_ArbPattern.matcher(target);
+        Matcher rangem = m_RangePattern.matcher(target);
         Matcher cachedm = m_CachedPattern.matcher(target);
         Matcher echom = m_EchoPattern.matcher(target);
         Matcher closem = m_ClosePattern.matcher(target);
@@ -271,6 +274,41 @@ public class TestHttpServer extends AbstractHandler
                 buffer[i] = (byte) ((i % 255) & 0xff);
             response.getOutputStream().write(buffer);
         }
+        else if (rangem.matches())
+        {
+            // Same content as /arb, with support for a single byte range, e.g. "Range: bytes=0-1023"
+            baseRequest.setHandled(true);
+
+            int n = Integer.parseInt(rangem.group(1));
+            int start = 0;
+            int end = n - 1;
+            response.setStatus(HttpServletResponse.SC_OK);
+
+            String range = request.getHeader("Range");
+            if (range != null)
+            {
+                Matcher bytesm = m_BytesRangePattern.matcher(range);
+                if (!bytesm.matches() || Integer.parseInt(bytesm.group(1)) >= n)
+                {
+                    response.setStatus(HttpServletResponse.SC_REQUESTED_RANGE_NOT_SATISFIABLE);
+                    response.setHeader("Content-Range", String.format("bytes */%d", n));
+                    response.setContentLength(0);
+                    return;
+                }
+                start = Integer.parseInt(bytesm.group(1));
+                end = Math.min(Integer.parseInt(bytesm.group(2)), n - 1);
+                response.setStatus(HttpServletResponse.SC_PARTIAL_CONTENT);
+                response.setHeader("Content-Range", String.format("bytes %d-%d/%d", start, end, n));
+            }
+
+            int length = end - start + 1;
+            response.setContentLength(length);
+
+            byte[] buffer = new byte[length];
+            for (int i = 0; i < length; ++i)
+                buffer[i] = (byte) (((start + i) % 255) & 0xff);
+            response.getOutputStream().write(buffer);
+        }
         else if (target.equals("/src/test/data/test.config")) {
             // For dmConfigFile test
             response.setStatus(HttpServletResponse.SC_OK);
@@ -14,10 +14,12 @@
 
 #include <stdint.h>
 #include <stdlib.h>
+#include <stdio.h>
 #include <string.h>
 #define JC_TEST_IMPLEMENTATION
 #include <jc_test/jc_test.h>
 #include "../dlib/crypt.h"
+#include "../dlib/time.h"
 
 
 TEST(dmCrypt, XTea)
@@ -125,6 +127,104 @@ TEST(dmCrypt, SHA512)
     ASSERT_ARRAY_EQ(expected, digest);
 }
 
+static void ToHex(const uint8_t* digest, uint32_t len, char* out)
+{
+    for (uint32_t i = 0; i < len; ++i)
+    {
+        sprintf(out + i * 2, "%02x", digest[i]);
+    }
+}
+
+// Lengths around the padding boundaries (55/56 and 63/64/65 bytes), and multi block buffers.
+// Checks both the public functions and the accelerated path (when supported by the cpu)
+TEST(dmCrypt, SHALengths)
+{
+    uint8_t buffer[4096];
+    for (uint32_t i = 0; i < sizeof(buffer); ++i)
+    {
+        buffer[i] = (uint8_t)(i * 131 + 7);
+    }
+
+    const uint32_t lengths[] = {0, 3, 55, 56, 63, 64, 65, 119, 128, 1000, 4096};
+    const char* expected[][2] = {
+        {"da39a3ee5e6b4b0d3255bfef95601890afd80709", "e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855"},
+        {"09182f082afc61e78585bdfb60501dfe876ccf62", "17aef23a39d753e713c203c152454d29fa8e39a98e83a69b39a5094dba9ae951"},
+        {"9e5a20c2604688df0b1eecf4474b58bfe7227881", "16ed9c4697ca11d5f6fb25ea7900252dd4cb97215d7f6d0b2bb3e2a86ac0ec72"},
+        {"bd367cf3b85dc2cac8f6b4827cb850e4c83c521c", "939ada93b2fe1e9c596d767bb408567c83e253667f0b25e5be8e16f35f2cbac9"},
+        {"a8f606c343b26fa851dfd149f7b12fc2dbf1af34", "6073f83b09ae82016cdbe24c18996c48f0eaa08ca675d0f6b90b807fc29e0149"},
+        {"1abec92bfbde4197236cfba30b6b61c69d605d88", "b337ba9b0c69c391364e985fdcb23a889887e59800832c92fbfa22b8a3c40304"},
+        {"362ce7bc4bc2b47979741db349c65fd550840dc3", "9d6a3fb113b586b4ab97bc11c993a27bd9b7bbcb756e0646083dc47a679600e6"},
+        {"e7ceee9817914eef9ec7001a43033f16a086b7c7", "9773fbac8194c3d789af101b49b6a26073076895ef6e0f658432849dd477a43f"},
+        {"8abf03d87a20327b0a0dfbee98f04a881350d8f4", "485a94e53eba9717a5d8b7b4489cad92a752f1c5722e7dfd29dd164b7c438d11"},
+        {"425b5f2d2d344f4f6467cda9065cdc840619dc2d", "533b698850849b7908b20a22658f639c0b2a476f1791f85f50188287c31a9aba"},
+        {"f09054955405e3854e8153b8aef2a159a0319d24", "edc9983a5f8a590052203d12c58e8d367f7c694a8746b7b9ef87bcc8f5af9e9f"},
+    };
+
+    for (uint32_t i = 0; i < sizeof(lengths) / sizeof(lengths[0]); ++i)
+    {
+        uint8_t digest[32];
+        char hex[65];
+
+        dmCrypt::HashSha1(buffer, lengths[i], digest);
+        ToHex(digest, 20, hex);
+        ASSERT_STREQ(expected[i][0], hex);
+
+        dmCrypt::HashSha256(buffer, lengths[i], digest);
+        ToHex(digest, 32, hex);
+        ASSERT_STREQ(expected[i][1], hex);
+
+        if (dmCrypt::HashSha1Accelerated(buffer, lengths[i], digest))
+        {
+            ToHex(digest, 20, hex);
+            ASSERT_STREQ(expected[i][0], hex);
+        }
+
+        if (dmCrypt::HashSha256Accelerated(buffer, lengths[i], digest))
+        {
+            ToHex(digest, 32, hex);
+            ASSERT_STREQ(expected[i][1], hex);
+        }
+    }
+}
+
+// Only built with DM_TEST_BENCHMARKS, it measures rather than tests
+#if defined(DM_TEST_BENCHMARKS)
+// Throughput of the digest functions used when verifying resources
+TEST(dmCrypt, SHABenchmark)
+{
+    const uint32_t size = 1024 * 1024;
+    const uint32_t iterations = 32;
+    uint8_t* buffer = (uint8_t*)malloc(size);
+    for (uint32_t i = 0; i < size; ++i)
+    {
+        buffer[i] = (uint8_t)rand();
+    }
+
+    uint8_t digest[32];
+    bool accelerated = dmCrypt::HashSha256Accelerated(buffer, 1, digest);
+
+    uint64_t start = dmTime::GetTime();
+    for (uint32_t i = 0; i < iterations; ++i)
+    {
+        dmCrypt::HashSha1(buffer, size, digest);
+    }
+    uint64_t sha1_time = dmTime::GetTime() - start;
+
+    start = dmTime::GetTime();
+    for (uint32_t i = 0; i < iterations; ++i)
+    {
+        dmCrypt::HashSha256(buffer, size, digest);
+    }
+    uint64_t sha256_time = dmTime::GetTime() - start;
+
+    printf("SHA-1: %.1f MB/s  SHA-256: %.1f MB/s  (%s)\n",
+            (double)size * iterations / (sha1_time + 1), (double)size * iterations / (sha256_time + 1),
+            accelerated ? "cpu instructions" : "mbedtls");
+
+    free(buffer);
+}
+#endif
+
 
 TEST(dmCrypt, Base64Encode)
 {
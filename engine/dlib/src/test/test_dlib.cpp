@@ -20,6 +20,10 @@
 #include <jc_test/jc_test.h>
 #include "../dlib/hash.h"
 #include "../dlib/log.h"
+#include "../dlib/time.h"
+#include "../dlib/thread.h"
+#include "../dlib/atomic.h"
+#include "../dlib/dstrings.h"
 
 class dlib : public jc_test_base_class
 {
@@ -639,6 +643,258 @@ TEST_F(dlib, HashReverseEnable)
     dmHashEnableReverseHash(true);
 }
 
+TEST_F(dlib, HashReverseStats)
+{
+    dmHashReverseHashStats stats;
+    dmHashGetReverseHashStats(&stats);
+    uint32_t strings = stats.m_Strings;
+    uint32_t live_size = stats.m_LiveSize;
+
+    uint64_t h1 = dmHashString64("reverse_stats_1");
+    uint32_t h2 = dmHashString32("reverse_stats_2");
+    dmHashString64("reverse_stats_1"); // Already known
+
+    dmHashGetReverseHashStats(&stats);
+    ASSERT_EQ(strings + 2, stats.m_Strings);
+    ASSERT_LT(live_size, stats.m_LiveSize);
+    ASSERT_LE(stats.m_LiveSize, stats.m_ArenaSize);
+    ASSERT_LE(stats.m_ArenaSize, stats.m_PagesSize);
+
+    dmHashReverseErase64(h1);
+    dmHashReverseErase32(h2);
+    dmHashGetReverseHashStats(&stats);
+    ASSERT_EQ(strings, stats.m_Strings);
+    ASSERT_EQ(live_size, stats.m_LiveSize);
+    ASSERT_EQ((const void*) 0, dmHashReverse64(h1, 0));
+    ASSERT_EQ((const void*) 0, dmHashReverse32(h2, 0));
+}
+
+TEST_F(dlib, HashReverseTrim)
+{
+    const uint32_t max_size = 256 * 1024;
+    dmHashEnableReverseHash(false);
+    dmHashEnableReverseHash(true);
+    dmHashSetReverseHashMaxSize(max_size);
+
+    // Far more transient strings than fit, while a few strings are in use all the time
+    char buffer[64];
+    uint64_t first = 0;
+    uint64_t last = 0;
+    for (uint32_t i = 0; i < 20000; ++i)
+    {
+        dmSnPrintf(buffer, sizeof(buffer), "/transient_instance_%u", i);
+        last = dmHashString64(buffer);
+        if (i == 0)
+            first = last;
+        dmHashString64("/persistent_64");
+        ASSERT_STREQ("/persistent_32", (const char*) dmHashReverse32(dmHashString32("/persistent_32"), 0));
+    }
+
+    dmHashReverseHashStats stats;
+    dmHashGetReverseHashStats(&stats);
+    ASSERT_LT(0U, stats.m_TrimCount);
+    ASSERT_LT(0U, stats.m_EvictedCount);
+    ASSERT_LE(stats.m_ArenaSize, max_size);
+
+    ASSERT_STREQ("/persistent_64", (const char*) dmHashReverse64(dmHashString64("/persistent_64"), 0));
+    ASSERT_STREQ("/transient_instance_19999", (const char*) dmHashReverse64(last, 0));
+    ASSERT_EQ((const void*) 0, dmHashReverse64(first, 0));
+
+    // Incremental hashes are kept as well
+    HashState64 hs;
+    dmHashInit64(&hs, true);
+    dmHashUpdateBuffer64(&hs, "/persistent", 11);
+    dmHashUpdateBuffer64(&hs, "_incremental", 12);
+    ASSERT_STREQ("/persistent_incremental", (const char*) dmHashReverse64(dmHashFinal64(&hs), 0));
+
+    dmHashSetReverseHashMaxSize(32 * 1024 * 1024);
+    dmHashEnableReverseHash(false);
+    dmHashEnableReverseHash(true);
+}
+
+TEST_F(dlib, HashReverseKeep)
+{
+    const uint32_t max_size = 256 * 1024;
+    dmHashEnableReverseHash(false);
+    dmHashEnableReverseHash(true);
+    dmHashSetReverseHashMaxSize(max_size);
+
+    uint64_t kept_64 = dmHashString64("/kept_64");
+    uint32_t kept_32 = dmHashString32("/kept_32");
+    dmHashKeepReverseHashStrings();
+
+    dmHashReverseHashStats stats;
+    dmHashGetReverseHashStats(&stats);
+    ASSERT_LT(0U, stats.m_KeptSize);
+
+    // The kept strings are the least recently used ones, but aren't evicted
+    char buffer[64];
+    for (uint32_t i = 0; i < 20000; ++i)
+    {
+        dmSnPrintf(buffer, sizeof(buffer), "/transient_instance_%u", i);
+        dmHashString64(buffer);
+    }
+
+    dmHashGetReverseHashStats(&stats);
+    ASSERT_LT(1U, stats.m_TrimCount);
+    ASSERT_LE(stats.m_ArenaSize - stats.m_KeptSize, max_size);
+    ASSERT_STREQ("/kept_64", (const char*) dmHashReverse64(kept_64, 0));
+    ASSERT_STREQ("/kept_32", (const char*) dmHashReverse32(kept_32, 0));
+
+    dmHashReverseErase64(kept_64);
+    ASSERT_EQ((const void*) 0, dmHashReverse64(kept_64, 0));
+
+    dmHashSetReverseHashMaxSize(32 * 1024 * 1024);
+    dmHashEnableReverseHash(false);
+    dmHashEnableReverseHash(true);
+}
+
+TEST_F(dlib, HashReverseTrimGracePeriod)
+{
+    const uint32_t max_size = 256 * 1024;
+    dmHashEnableReverseHash(false);
+    dmHashEnableReverseHash(true);
+    dmHashSetReverseHashMaxSize(max_size);
+
+    uint64_t hash = dmHashString64("/grace_period");
+    const char* reverse = (const char*) dmHashReverse64(hash, 0);
+
+    // The string is evicted by the first trim, but the memory is only freed after the second one
+    dmHashReverseHashStats stats;
+    dmHashGetReverseHashStats(&stats);
+    char buffer[64];
+    for (uint32_t i = 0; stats.m_TrimCount == 0; ++i)
+    {
+        dmSnPrintf(buffer, sizeof(buffer), "/transient_instance_%u", i);
+        dmHashString64(buffer);
+        dmHashGetReverseHashStats(&stats);
+    }
+    ASSERT_EQ((const void*) 0, dmHashReverse64(hash, 0));
+    ASSERT_STREQ("/grace_period", reverse);
+
+    dmHashSetReverseHashMaxSize(32 * 1024 * 1024);
+    dmHashEnableReverseHash(false);
+    dmHashEnableReverseHash(true);
+}
+
+struct ReverseHashThreadContext
+{
+    uint32_t       m_Index;
+    int32_atomic_t m_Errors;
+};
+
+static void ReverseHashThread(void* arg)
+{
+    ReverseHashThreadContext* ctx = (ReverseHashThreadContext*) arg;
+    char buffer[64];
+    for (uint32_t i = 0; i < 20000; ++i)
+    {
+        // Half of the strings are shared between the threads
+        uint32_t n = (i & 1) ? i : (i + ctx->m_Index * 100000);
+        dmSnPrintf(buffer, sizeof(buffer), "thread_string_%u", n);
+        uint64_t h = dmHashString64(buffer);
+        const char* reverse = (const char*) dmHashReverse64(h, 0);
+        if (reverse == 0 || strcmp(reverse, buffer) != 0)
+            dmAtomicIncrement32(&ctx->m_Errors);
+    }
+}
+
+TEST_F(dlib, HashReverseThreads)
+{
+    const uint32_t thread_count = 4;
+    dmHashSetReverseHashMaxSize(1024 * 1024);
+
+    ReverseHashThreadContext contexts[thread_count];
+    dmThread::Thread threads[thread_count];
+    for (uint32_t i = 0; i < thread_count; ++i)
+    {
+        contexts[i].m_Index = i;
+        contexts[i].m_Errors = 0;
+        threads[i] = dmThread::New(ReverseHashThread, 0x80000, &contexts[i], "reverse_hash");
+    }
+    for (uint32_t i = 0; i < thread_count; ++i)
+    {
+        dmThread::Join(threads[i]);
+        ASSERT_EQ(0, contexts[i].m_Errors);
+    }
+
+    dmHashSetReverseHashMaxSize(32 * 1024 * 1024);
+}
+
+TEST_F(dlib, HashVersionXXH3)
+{
+    // Reference values from the xxHash library (XXH3_64bits)
+    ASSERT_EQ(0x2d06800538d394c2ULL, dmHashBufferVersion64(DMHASH_VERSION_XXH3, "", 0));
+    ASSERT_EQ(0xe6c632b61e964e1fULL, dmHashBufferVersion64(DMHASH_VERSION_XXH3, "a", 1));
+    ASSERT_EQ(0xab6e5f64077e7d8aULL, dmHashBufferVersion64(DMHASH_VERSION_XXH3, "foo", 3));
+    ASSERT_EQ(0xe155d613728f4b18ULL, dmHashBufferVersion64(DMHASH_VERSION_XXH3, "hello world!", 12));
+
+    uint8_t buffer[5000];
+    for (uint32_t i = 0; i < sizeof(buffer); ++i)
+    {
+        buffer[i] = (uint8_t)(i * 131 + 7);
+    }
+
+    // One or two lengths around each of the size classes of the algorithm
+    const uint32_t lengths[] = {3, 8, 16, 17, 100, 128, 129, 240, 241, 1024, 1025, 5000};
+    const uint64_t expected[] = {0x6e3e2670e61106acULL, 0xf9fd4dd0b04d78f5ULL, 0x86abf6baccea0858ULL, 0xb58bf5dc5022d071ULL,
+                                 0x5da67eac6d4093d5ULL, 0x10d17f72c0ccba41ULL, 0x1648bdc3db49d1a2ULL, 0xb6cfaf343fab81e6ULL,
+                                 0x956cae592c67279eULL, 0x70bd377d9574f4bbULL, 0x66c4487c41e127a7ULL, 0xe4007929540f095cULL};
+    for (uint32_t i = 0; i < sizeof(lengths) / sizeof(lengths[0]); ++i)
+    {
+        ASSERT_EQ(expected[i], dmHashBufferVersion64(DMHASH_VERSION_XXH3, buffer, lengths[i]));
+    }
+
+    // The Murmur version is the regular hash, but never stored for reverse hashing
+    uint64_t h = dmHashBufferVersion64(DMHASH_VERSION_MURMUR, "version_murmur", 14);
+    ASSERT_EQ(dmHashBufferNoReverse64("version_murmur", 14), h);
+    ASSERT_EQ((const void*) 0, dmHashReverse64(h, 0));
+}
+
+// Not part of the regular run (the timings are noise on CI), build with DM_TEST_BENCHMARKS to print them
+#if defined(DM_TEST_BENCHMARKS)
+// Throughput of the Murmur and XXH3 versions, for a range of buffer sizes
+TEST_F(dlib, HashVersionBenchmark)
+{
+    const uint32_t sizes[] = {8, 64, 256, 4096, 65536, 1024 * 1024};
+    const uint32_t total = 64 * 1024 * 1024;
+
+    uint32_t max_size = sizes[sizeof(sizes) / sizeof(sizes[0]) - 1];
+    uint8_t* buffer = (uint8_t*) malloc(max_size);
+    for (uint32_t i = 0; i < max_size; ++i)
+    {
+        buffer[i] = (uint8_t)rand();
+    }
+
+    for (uint32_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); ++s)
+    {
+        uint32_t size = sizes[s];
+        uint32_t iterations = total / size;
+        uint64_t sum = 0;
+
+        uint64_t start = dmTime::GetTime();
+        for (uint32_t i = 0; i < iterations; ++i)
+        {
+            sum += dmHashBufferVersion64(DMHASH_VERSION_MURMUR, buffer, size - (i & 1));
+        }
+        uint64_t murmur_time = dmTime::GetTime() - start;
+
+        start = dmTime::GetTime();
+        for (uint32_t i = 0; i < iterations; ++i)
+        {
+            sum += dmHashBufferVersion64(DMHASH_VERSION_XXH3, buffer, size - (i & 1));
+        }
+        uint64_t xxh3_time = dmTime::GetTime() - start;
+
+        ASSERT_NE((uint64_t)0, sum); // Keep the hashing from being optimized away
+        printf("%8u bytes: %8.1f / %8.1f MB/s  (Murmur / XXH3)\n", size,
+                total / (murmur_time + 1.0), total / (xxh3_time + 1.0));
+    }
+
+    free(buffer);
+}
+#endif
+
 int main(int argc, char **argv)
 {
     jc_test_init(&argc, argv);
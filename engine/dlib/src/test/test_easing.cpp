@@ -108,6 +108,47 @@ TEST(dmEasing, CurstomCurve)
     }
 }
 
+TEST(dmEasing, Batched)
+{
+    const uint32_t count = 257;
+    float t[count];
+    float values[count];
+    for (uint32_t i = 0; i < count; ++i) {
+        // Include values outside [0,1] to test clamping
+        t[i] = -0.25f + 1.5f * i / (count - 1);
+    }
+
+    for (int type = 0; type < dmEasing::TYPE_FLOAT_VECTOR; ++type) {
+        dmEasing::Curve curve((dmEasing::Type) type);
+        dmEasing::GetValues(curve, t, values, count);
+        for (uint32_t i = 0; i < count; ++i) {
+            ASSERT_NEAR(dmEasing::GetValue(curve, t[i]), values[i], 0.0001f);
+        }
+    }
+
+    dmVMath::FloatVector vector(64);
+    for (int i = 0; i < 64; ++i) {
+        float x = i / 63.0f;
+        vector.values[i] = x * x;
+    }
+    dmEasing::Curve curve(dmEasing::TYPE_FLOAT_VECTOR);
+    curve.vector = &vector;
+    dmEasing::GetValues(curve, t, values, count);
+    for (uint32_t i = 0; i < count; ++i) {
+        ASSERT_NEAR(dmEasing::GetValue(curve, t[i]), values[i], 0.0001f);
+    }
+
+    // In place evaluation
+    dmEasing::Curve inquad(dmEasing::TYPE_INQUAD);
+    for (uint32_t i = 0; i < count; ++i) {
+        values[i] = dmEasing::GetValue(inquad, t[i]);
+    }
+    dmEasing::GetValues(inquad, t, t, count);
+    for (uint32_t i = 0; i < count; ++i) {
+        ASSERT_NEAR(values[i], t[i], 0.0001f);
+    }
+}
+
 int main(int argc, char **argv)
 {
     jc_test_init(&argc, argv);
@@ -22,6 +22,9 @@
 #include <jc_test/jc_test.h>
 
 #include "dlib/hashtable.h"
+#include "dlib/flat_hashtable.h"
+#include "dlib/math.h"
+#include "dlib/time.h"
 
 TEST(dmHashTable, EmtpyConstructor)
 {
@@ -524,6 +527,283 @@ TEST(dmHashTable, Swap)
     ASSERT_EQ(300, *h1.Get(30));
 }
 
+TEST(dmFlatHashTable, EmptyConstructor)
+{
+    dmFlatHashTable32<int> ht;
+
+    EXPECT_EQ(0U, ht.Size());
+    EXPECT_EQ(0U, ht.Capacity());
+    EXPECT_EQ(true, ht.Full());
+    EXPECT_EQ(true, ht.Empty());
+    EXPECT_EQ((uintptr_t) 0, (uintptr_t) ht.Get(1));
+}
+
+TEST(dmFlatHashTable, SimplePut)
+{
+    dmFlatHashTable<uint32_t, uint32_t> ht;
+    ht.SetCapacity(10, 10);
+    ht.Put(12, 23);
+
+    uint32_t* val = ht.Get(12);
+    ASSERT_NE((uintptr_t) 0, (uintptr_t) val);
+    EXPECT_EQ((uint32_t) 23, *val);
+
+    ht.Put(12, 24);
+    EXPECT_EQ((uint32_t) 24, *ht.Get(12));
+    EXPECT_EQ(1U, ht.Size());
+    ht.Verify();
+}
+
+TEST(dmFlatHashTable, FillEraseFill)
+{
+    dmFlatHashTable<uint32_t, uint32_t> ht;
+    ht.SetCapacity(10, 2);
+    ht.Put(1, 10);
+    ht.Put(2, 20);
+    ASSERT_TRUE(ht.Full());
+    ASSERT_EQ((uint32_t) 10, *ht.Get(1));
+    ASSERT_EQ((uint32_t) 20, *ht.Get(2));
+
+    ht.Erase(1);
+    ht.Verify();
+    ht.Erase(2);
+    ht.Verify();
+    ASSERT_EQ((uintptr_t) 0, (uintptr_t) ht.Get(1));
+    ASSERT_EQ((uintptr_t) 0, (uintptr_t) ht.Get(2));
+
+    ht.Put(1, 100);
+    ht.Put(2, 200);
+    ht.Verify();
+    ASSERT_EQ((uint32_t) 100, *ht.Get(1));
+    ASSERT_EQ((uint32_t) 200, *ht.Get(2));
+}
+
+// Random puts and erases in a full table, which exercises the deleted slot markers
+TEST(dmFlatHashTable, Exhaustive)
+{
+    const uint32_t capacities[] = {1, 14, 15, 100, 1000};
+    for (uint32_t c = 0; c < sizeof(capacities) / sizeof(capacities[0]); ++c)
+    {
+        uint32_t capacity = capacities[c];
+        dmFlatHashTable64<uint32_t> ht;
+        ht.SetCapacity(capacity);
+        std::map<uint64_t, uint32_t> map;
+
+        for (uint32_t i = 0; i < capacity * 20; ++i)
+        {
+            // Few distinct keys, so that puts also replace values
+            uint64_t key = (uint64_t)(rand() % (capacity * 2));
+            if (map.find(key) != map.end())
+            {
+                ht.Erase(key);
+                map.erase(key);
+            }
+            else if (!ht.Full())
+            {
+                uint32_t value = (uint32_t)rand();
+                ht.Put(key, value);
+                map[key] = value;
+            }
+            ASSERT_EQ(map.size(), ht.Size());
+        }
+        ht.Verify();
+
+        for (uint64_t key = 0; key < capacity * 2; ++key)
+        {
+            std::map<uint64_t, uint32_t>::iterator it = map.find(key);
+            uint32_t* value = ht.Get(key);
+            if (it == map.end())
+            {
+                ASSERT_EQ((uintptr_t) 0, (uintptr_t) value);
+            }
+            else
+            {
+                ASSERT_NE((uintptr_t) 0, (uintptr_t) value);
+                ASSERT_EQ(it->second, *value);
+            }
+        }
+    }
+}
+
+TEST(dmFlatHashTable, Grow)
+{
+    dmFlatHashTable<uint32_t, int> ht;
+    std::map<uint32_t, int> map;
+
+    for (uint32_t i = 0; i < 1000; ++i)
+    {
+        if (ht.Full())
+        {
+            ht.SetCapacity(ht.Capacity() + (rand() % 4) + 1);
+        }
+        uint32_t key = rand();
+        int val = rand();
+        ht.Put(key, val);
+        map[key] = val;
+    }
+
+    ht.Verify();
+    ASSERT_EQ(map.size(), ht.Size());
+    for (std::map<uint32_t, int>::iterator iter = map.begin(); iter != map.end(); ++iter)
+    {
+        ASSERT_EQ(iter->second, *ht.Get(iter->first));
+    }
+}
+
+TEST(dmFlatHashTable, Iterator)
+{
+    dmFlatHashTable<uint32_t, int> ht;
+    ht.SetCapacity(100);
+
+    int sum = 0;
+    uint32_t key_sum = 0;
+    for (uint32_t i = 0; i < 100; ++i)
+    {
+        int x = rand() % 1000;
+        ht.Put(i, x);
+        sum += x;
+        key_sum += i;
+    }
+    sum -= *ht.Get(50);
+    key_sum -= 50;
+    ht.Erase(50);
+
+    int result = 0;
+    uint32_t key_result = 0;
+    dmFlatHashTable<uint32_t, int>::Iterator iter = ht.GetIterator();
+    while (iter.Next())
+    {
+        key_result += iter.GetKey();
+        result += iter.GetValue();
+    }
+    ASSERT_EQ(sum, result);
+    ASSERT_EQ(key_sum, key_result);
+
+    int context = 0;
+    ht.Iterate(IterateCallback, &context);
+    ASSERT_EQ(result, context);
+}
+
+TEST(dmFlatHashTable, Clear)
+{
+    dmFlatHashTable<uint32_t, int> ht;
+    ht.SetCapacity(64);
+    for (uint32_t i = 0; i < 64; ++i)
+        ht.Put(i, i);
+    ht.Clear();
+    ht.Verify();
+    ASSERT_TRUE(ht.Empty());
+    ASSERT_EQ((uintptr_t) 0, (uintptr_t) ht.Get(1));
+
+    g_ClearCount = 0;
+    ht.Iterate(ClearCallback, (int*) 0);
+    ASSERT_EQ(0U, g_ClearCount);
+}
+
+TEST(dmFlatHashTable, AllocatedSize)
+{
+    typedef dmFlatHashTable<uint64_t, void*> Table;
+    const uint32_t slot_size = sizeof(Table::Entry) + 1;
+
+    Table ht;
+    ASSERT_EQ(0U, ht.GetAllocatedSize());
+
+    // 16 slots hold at most 14 entries (7/8 load)
+    ht.SetCapacity(14);
+    ASSERT_EQ(16 * slot_size, ht.GetAllocatedSize());
+    ht.SetCapacity(15);
+    ASSERT_EQ(32 * slot_size, ht.GetAllocatedSize());
+
+    ht.SetCapacity(1000);
+    ASSERT_EQ(2048 * slot_size, ht.GetAllocatedSize());
+    ASSERT_LT(ht.Capacity() * (sizeof(uint64_t) + sizeof(void*)), ht.GetAllocatedSize());
+}
+
+TEST(dmFlatHashTable, Swap)
+{
+    dmFlatHashTable<int, int> h1;
+    dmFlatHashTable<int, int> h2;
+    h1.SetCapacity(10);
+    h2.SetCapacity(10);
+
+    h1.Put(1, 10);
+    h2.Put(10, 100);
+
+    h1.Swap(h2);
+
+    ASSERT_EQ(10, *h2.Get(1));
+    ASSERT_EQ(100, *h1.Get(10));
+    ASSERT_EQ((uintptr_t) 0, (uintptr_t) h1.Get(1));
+}
+
+// Timing only, so it's left out of the regular test run. Define DM_TEST_BENCHMARKS to build it
+#if defined(DM_TEST_BENCHMARKS)
+// Benchmark of dmHashTable and dmFlatHashTable, with 64 bit hashes as keys.
+// The chained table uses the table size most call sites use (capacity * 2/3)
+template <typename TABLE>
+static void BenchmarkTable(const uint64_t* keys, uint32_t count, uint32_t lookups, uint64_t* insert_time, uint64_t* hit_time, uint64_t* miss_time)
+{
+    TABLE* ht = new TABLE;
+    ht->SetCapacity(dmMath::Max(1U, (count * 2) / 3), count);
+
+    uint64_t start = dmTime::GetTime();
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        ht->Put(keys[i], i);
+    }
+    *insert_time = dmTime::GetTime() - start;
+
+    uint32_t sum = 0;
+    start = dmTime::GetTime();
+    for (uint32_t i = 0; i < lookups; ++i)
+    {
+        sum += *ht->Get(keys[(i * 7919) % count]);
+    }
+    *hit_time = dmTime::GetTime() - start;
+
+    uint32_t misses = 0;
+    start = dmTime::GetTime();
+    for (uint32_t i = 0; i < lookups; ++i)
+    {
+        misses += ht->Get(keys[(i * 7919) % count] + 1) == 0;
+    }
+    *miss_time = dmTime::GetTime() - start;
+
+    ASSERT_EQ(lookups, misses);
+    ASSERT_NE(0xFFFFFFFF, sum); // Keep the lookups from being optimized away
+    delete ht;
+}
+
+TEST(dmFlatHashTable, Benchmark)
+{
+    const uint32_t counts[] = {1000, 10000, 100000, 1000000};
+    const uint32_t lookups = 1000000;
+
+    for (uint32_t c = 0; c < sizeof(counts) / sizeof(counts[0]); ++c)
+    {
+        uint32_t count = counts[c];
+        uint64_t* keys = new uint64_t[count];
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            // Even "hashes", so that key + 1 is never in the table
+            keys[i] = (((uint64_t)rand() << 48) ^ ((uint64_t)rand() << 24) ^ (uint64_t)rand() ^ ((uint64_t)i << 20)) & ~1ULL;
+        }
+
+        uint64_t chained[3];
+        uint64_t flat[3];
+        BenchmarkTable<dmHashTable64<uint32_t> >(keys, count, lookups, &chained[0], &chained[1], &chained[2]);
+        BenchmarkTable<dmFlatHashTable64<uint32_t> >(keys, count, lookups, &flat[0], &flat[1], &flat[2]);
+
+        printf("%7u entries: insert %6.2f / %6.2f ns  hit %6.2f / %6.2f ns  miss %6.2f / %6.2f ns  (dmHashTable / dmFlatHashTable)\n", count,
+                chained[0] * 1000.0 / count, flat[0] * 1000.0 / count,
+                chained[1] * 1000.0 / lookups, flat[1] * 1000.0 / lookups,
+                chained[2] * 1000.0 / lookups, flat[2] * 1000.0 / lookups);
+
+        delete[] keys;
+    }
+}
+#endif
+
 int main(int argc, char **argv)
 {
     jc_test_init(&argc, argv);
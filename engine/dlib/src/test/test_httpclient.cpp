@@ -752,6 +752,153 @@ TEST_P(dmHttpClientTest, LargeFile)
     }
 }
 
+struct HttpPipelineHelper
+{
+    dmHttpClient::HClient m_Client;
+    std::string m_Content[64];
+    int m_StatusCode[64];
+    dmHttpClient::Result m_Result[64];
+    uint32_t m_Responses;
+
+    HttpPipelineHelper(const dmURI::Parts& uri)
+    {
+        bool secure = strcmp(uri.m_Scheme, "https") == 0;
+        m_Responses = 0;
+        for (uint32_t i = 0; i < 64; ++i)
+        {
+            m_StatusCode[i] = 0;
+            m_Result[i] = dmHttpClient::RESULT_UNKNOWN;
+        }
+        dmHttpClient::NewParams params;
+        params.m_Userdata = this;
+        params.m_HttpContent = HttpPipelineHelper::HttpContent;
+        m_Client = dmHttpClient::New(&params, uri.m_Hostname, uri.m_Port, secure, 0);
+    }
+
+    ~HttpPipelineHelper()
+    {
+        dmHttpClient::Delete(m_Client);
+    }
+
+    static void HttpContent(dmHttpClient::HResponse response, void* user_data, int status_code, const void* content_data, uint32_t content_data_size, int32_t content_length)
+    {
+        HttpPipelineHelper* self = (HttpPipelineHelper*) user_data;
+        uint32_t index = dmHttpClient::GetRequestIndex(response);
+        self->m_StatusCode[index] = status_code;
+        if (!content_data && !content_data_size)
+        {
+            self->m_Content[index] = "";
+            return;
+        }
+        self->m_Content[index].append((const char*) content_data, content_data_size);
+    }
+
+    static void HttpPipelinedResponse(dmHttpClient::HClient client, void* user_data, uint32_t index, dmHttpClient::Result result)
+    {
+        HttpPipelineHelper* self = (HttpPipelineHelper*) user_data;
+        self->m_Result[index] = result;
+        self->m_Responses++;
+    }
+};
+
+TEST_P(dmHttpClientTest, Pipelined)
+{
+    const uint32_t count = 40;
+    char paths[count][64];
+    const char* path_ptrs[count];
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        // The server closes the connection after /no-keep-alive, the following requests must still get a response
+        if (i == 20)
+            dmSnPrintf(paths[i], sizeof(paths[i]), "/no-keep-alive");
+        else
+            dmSnPrintf(paths[i], sizeof(paths[i]), "/add/%d/1000", i);
+        path_ptrs[i] = paths[i];
+    }
+
+    HttpPipelineHelper h(m_URI);
+    ASSERT_NE((void*) 0, h.m_Client);
+
+    dmHttpClient::Result r = dmHttpClient::GetPipelined(h.m_Client, path_ptrs, count, HttpPipelineHelper::HttpPipelinedResponse);
+    ASSERT_EQ(dmHttpClient::RESULT_OK, r);
+    ASSERT_EQ(count, h.m_Responses);
+
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        ASSERT_EQ(dmHttpClient::RESULT_OK, h.m_Result[i]);
+        ASSERT_EQ(200, h.m_StatusCode[i]);
+        if (i == 20)
+            ASSERT_STREQ("will close connection now.", h.m_Content[i].c_str());
+        else
+            ASSERT_EQ(1000 + (int) i, strtol(h.m_Content[i].c_str(), 0, 10));
+    }
+
+    dmHttpClient::Statistics stats;
+    dmHttpClient::GetStatistics(h.m_Client, &stats);
+    ASSERT_EQ(count, stats.m_Responses - stats.m_Reconnections);
+}
+
+TEST_P(dmHttpClientTest, Range)
+{
+    m_Content = "";
+    dmHttpClient::Result r = dmHttpClient::GetRange(m_Client, "/range/1000", 100, 200);
+    ASSERT_EQ(dmHttpClient::RESULT_OK, r);
+    ASSERT_EQ(206, m_StatusCode);
+    ASSERT_EQ(200U, m_Content.size());
+    for (uint32_t i = 0; i < 200; ++i)
+    {
+        ASSERT_EQ((100 + i) % 255, (uint32_t) (m_Content[i] & 0xff));
+    }
+
+    // The range is clamped to the end of the resource
+    m_Content = "";
+    r = dmHttpClient::GetRange(m_Client, "/range/1000", 900, 200);
+    ASSERT_EQ(dmHttpClient::RESULT_OK, r);
+    ASSERT_EQ(206, m_StatusCode);
+    ASSERT_EQ(100U, m_Content.size());
+
+    // Regular requests on the same client aren't affected
+    m_Content = "";
+    r = dmHttpClient::Get(m_Client, "/range/1000");
+    ASSERT_EQ(dmHttpClient::RESULT_OK, r);
+    ASSERT_EQ(200, m_StatusCode);
+    ASSERT_EQ(1000U, m_Content.size());
+}
+
+static void CheckRanges(dmHttpClient::HClient client, const char* path, uint32_t n)
+{
+    uint32_t buffer_size = n + 1000;
+    uint8_t* buffer = (uint8_t*) malloc(buffer_size);
+    uint32_t size = 0;
+    dmHttpClient::Result r = dmHttpClient::GetRanges(client, path, buffer, buffer_size, 4, &size);
+    ASSERT_EQ(dmHttpClient::RESULT_OK, r);
+    ASSERT_EQ(n, size);
+    for (uint32_t i = 0; i < n; ++i)
+    {
+        ASSERT_EQ(i % 255, (uint32_t) buffer[i]);
+    }
+
+    // Too small buffer
+    r = dmHttpClient::GetRanges(client, path, buffer, n - 1, 4, &size);
+    ASSERT_EQ(dmHttpClient::RESULT_INVAL, r);
+    free(buffer);
+}
+
+TEST_P(dmHttpClientTest, ParallelRanges)
+{
+    char buf[128];
+    const uint32_t sizes[] = { 17, 256 * 1024, 256 * 1024 + 1, 3 * 1024 * 1024 + 59 };
+    for (uint32_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); ++i)
+    {
+        dmSnPrintf(buf, sizeof(buf), "/range/%u", sizes[i]);
+        CheckRanges(m_Client, buf, sizes[i]);
+
+        // Without range support on the server, the resource is downloaded with a single request
+        dmSnPrintf(buf, sizeof(buf), "/arb/%u", sizes[i]);
+        CheckRanges(m_Client, buf, sizes[i]);
+    }
+}
+
 TEST_P(dmHttpClientTest, TestHeaders)
 {
     char buf[128];
@@ -27,6 +27,8 @@
 #include "../dlib/http_client.h"
 #include "../dlib/hash.h"
 #include "../dlib/network_constants.h"
+#include "../dlib/sys.h"
+#include "../dlib/testutil.h"
 
 #define JC_TEST_IMPLEMENTATION
 #include <jc_test/jc_test.h>
@@ -42,6 +44,7 @@ public:
     std::string m_RequestMethod, m_Resource;
     std::string m_Content;
     std::string m_ClientData;
+    char m_SendFilePath[1024];
     int32_atomic_t m_Quit;
     int32_atomic_t m_ServerStarted;
 
@@ -97,6 +100,13 @@ public:
             dmHttpServer::SendAttribute(request, "Content-Type", "text/html");
             dmHttpServer::Send(request, html, strlen(html));
         }
+        else if (strstr(self->m_Resource.c_str(), "/sendfile"))
+        {
+            if (dmHttpServer::SendFile(request, self->m_SendFilePath) != dmHttpServer::RESULT_OK)
+            {
+                dmHttpServer::SetStatusCode(request, 404);
+            }
+        }
         else if (strstr(self->m_Resource.c_str(), "/quit"))
         {
             dmAtomicStore32(&self->m_Quit, 1);
@@ -157,20 +167,77 @@ public:
         T_ASSERT_LE(iter, 10000);
     }
 
-    virtual void SetUp()
+    void CreateServer(bool threaded)
     {
-        m_Quit = 0;
-        m_ServerStarted = 0;
-        m_ClientData = "";
+        if (m_Server)
+            dmHttpServer::Delete(m_Server);
+
         dmHttpServer::NewParams params;
         params.m_ConnectionTimeout = 30;
         params.m_Userdata = this;
         params.m_HttpHeader = dmHttpServerTest::HttpHeader;
         params.m_HttpResponse = dmHttpServerTest::HttpResponse;
+        params.m_Threaded = threaded;
         dmHttpServer::Result result_server = dmHttpServer::New(&params, 8500, &m_Server);
         ASSERT_EQ(dmHttpServer::RESULT_OK, result_server);
     }
 
+    void RunClient()
+    {
+        dmThread::Thread thread = dmThread::New(&ServerThread, 0x8000, this, "test");
+
+        while (!dmAtomicGet32(&m_ServerStarted))
+        {
+            dmTime::Sleep(10 * 1000);
+        }
+
+        dmHttpClient::NewParams client_params;
+        client_params.m_HttpContent = &ClientHttpContent;
+        client_params.m_Userdata = this;
+        dmHttpClient::HClient client = dmHttpClient::New(&client_params, DM_LOOPBACK_ADDRESS_IPV4, 8500);
+
+        dmHttpClient::Result r;
+        m_ClientData = "";
+        r = dmHttpClient::Get(client, "/mul/10/20");
+        ASSERT_EQ(dmHttpClient::RESULT_OK, r);
+        ASSERT_STREQ("30", m_ClientData.c_str());
+
+        for (int i = 0; i < 5000; i += 97)
+        {
+            char uri[64];
+            dmSnPrintf(uri, sizeof(uri), "/respond_with_n/%d", i);
+            m_ClientData = "";
+
+            r = dmHttpClient::Get(client, uri);
+            ASSERT_EQ(dmHttpClient::RESULT_OK, r);
+
+            ASSERT_EQ(i, (int) m_ClientData.size());
+
+            for (int j = 0; j < i; ++j)
+            {
+                int c = 'a' + ((i + j*97) % ('z' - 'a'));
+                ASSERT_EQ((char) c, m_ClientData[j]);
+            }
+        }
+
+        r = dmHttpClient::Get(client, "/quit");
+        ASSERT_EQ(dmHttpClient::RESULT_OK, r);
+
+        dmHttpClient::Delete(client);
+
+        dmThread::Join(thread);
+    }
+
+    virtual void SetUp()
+    {
+        m_Quit = 0;
+        m_ServerStarted = 0;
+        m_ClientData = "";
+        m_Server = 0;
+        dmTestUtil::MakeHostPath(m_SendFilePath, sizeof(m_SendFilePath), "tmp/sendfile");
+        CreateServer(false);
+    }
+
     virtual void TearDown()
     {
         if (m_Server)
@@ -309,50 +376,202 @@ TEST_F(dmHttpServerTest, TestServer)
 
 TEST_F(dmHttpServerTest, TestServerClient)
 {
-    dmThread::Thread thread = dmThread::New(&ServerThread, 0x8000, this, "test");
+    RunClient();
+}
 
-    while (!dmAtomicGet32(&m_ServerStarted))
+TEST_F(dmHttpServerTest, TestServerClientThreaded)
+{
+    CreateServer(true);
+    RunClient();
+}
+
+TEST_F(dmHttpServerTest, TestSendFile)
+{
+    char path[1024];
+    dmTestUtil::MakeHostPath(path, sizeof(path), "tmp");
+    dmSys::Mkdir(path, 0755);
+
+    // Larger than the send buffer, to test the fallback path as well
+    std::string content;
+    for (int i = 0; i < 200 * 1024; ++i)
     {
-        dmTime::Sleep(10 * 1000);
+        content += (char) ('a' + (i * 7) % 26);
     }
+    FILE* f = fopen(m_SendFilePath, "wb");
+    ASSERT_NE((FILE*) 0, f);
+    fwrite(content.c_str(), 1, content.size(), f);
+    fclose(f);
+
+    dmThread::Thread thread = dmThread::New(&ServerThread, 0x8000, this, "test");
 
     dmHttpClient::NewParams client_params;
     client_params.m_HttpContent = &ClientHttpContent;
     client_params.m_Userdata = this;
     dmHttpClient::HClient client = dmHttpClient::New(&client_params, DM_LOOPBACK_ADDRESS_IPV4, 8500);
 
-    dmHttpClient::Result r;
-    m_ClientData = "";
-    r = dmHttpClient::Get(client, "/mul/10/20");
-    ASSERT_EQ(dmHttpClient::RESULT_OK, r);
-    ASSERT_STREQ("30", m_ClientData.c_str());
-
-    for (int i = 0; i < 5000; i += 97)
+    // Twice, to make sure the connection is reusable after the file is sent
+    for (int i = 0; i < 2; ++i)
     {
-        char uri[64];
-        dmSnPrintf(uri, sizeof(uri), "/respond_with_n/%d", i);
         m_ClientData = "";
+        ASSERT_EQ(dmHttpClient::RESULT_OK, dmHttpClient::Get(client, "/sendfile"));
+        ASSERT_EQ(content.size(), m_ClientData.size());
+        ASSERT_TRUE(content == m_ClientData);
+    }
 
-        r = dmHttpClient::Get(client, uri);
-        ASSERT_EQ(dmHttpClient::RESULT_OK, r);
+    dmSys::Unlink(m_SendFilePath);
+    ASSERT_EQ(dmHttpClient::RESULT_NOT_200_OK, dmHttpClient::Get(client, "/sendfile"));
+
+    ASSERT_EQ(dmHttpClient::RESULT_OK, dmHttpClient::Get(client, "/quit"));
+    dmHttpClient::Delete(client);
+    dmThread::Join(thread);
+}
+
+// Throughput numbers, not a pass/fail test. Only built with DM_TEST_BENCHMARKS
+#if defined(DM_TEST_BENCHMARKS)
+
+// A load generator for the benchmark below. Each client sends requests on a keep-alive connection
+struct BenchmarkClient
+{
+    uint16_t m_Port;
+    uint32_t m_Requests;
+    int32_atomic_t m_Completed;
+};
 
-        ASSERT_EQ(i, (int) m_ClientData.size());
+static bool BenchmarkRequest(dmSocket::Socket socket)
+{
+    const char* request = "GET /bench HTTP/1.1\r\nHost: localhost\r\n\r\n";
+    int sent = 0;
+    if (dmSocket::Send(socket, request, strlen(request), &sent) != dmSocket::RESULT_OK || sent != (int) strlen(request))
+        return false;
+
+    // Read until the terminating chunk
+    char buffer[1024];
+    int total = 0;
+    while (total < 5 || memcmp(buffer + total - 5, "0\r\n\r\n", 5) != 0)
+    {
+        int received = 0;
+        if (dmSocket::Receive(socket, buffer + total, sizeof(buffer) - total, &received) != dmSocket::RESULT_OK || received == 0)
+            return false;
+        total += received;
+        if (total == sizeof(buffer))
+            return false;
+    }
+    return true;
+}
 
-        for (int j = 0; j < i; ++j)
+static void BenchmarkClientThread(void* arg)
+{
+    BenchmarkClient* client = (BenchmarkClient*) arg;
+    dmSocket::Address address;
+    dmSocket::GetHostByName(DM_LOOPBACK_ADDRESS_IPV4, &address);
+    dmSocket::Socket socket;
+    dmSocket::New(address.m_family, dmSocket::TYPE_STREAM, dmSocket::PROTOCOL_TCP, &socket);
+    if (dmSocket::Connect(socket, address, client->m_Port) == dmSocket::RESULT_OK)
+    {
+        dmSocket::SetNoDelay(socket, true);
+        while ((uint32_t) client->m_Completed < client->m_Requests && BenchmarkRequest(socket))
         {
-            int c = 'a' + ((i + j*97) % ('z' - 'a'));
-            ASSERT_EQ((char) c, m_ClientData[j]);
+            dmAtomicIncrement32(&client->m_Completed);
         }
     }
+    dmSocket::Delete(socket);
+}
 
-    r = dmHttpClient::Get(client, "/quit");
-    ASSERT_EQ(dmHttpClient::RESULT_OK, r);
+static void BenchmarkResponse(void* user_data, const dmHttpServer::Request* request)
+{
+    dmHttpServer::Send(request, "ok", 2);
+}
 
-    dmHttpClient::Delete(client);
+static void RunBenchmark(const char* name, bool threaded, bool respond_on_server_thread)
+{
+    const uint32_t idle_connection_count = 64;
+    const uint32_t client_count = 4;
+    const uint32_t request_count = 500;
+
+    dmHttpServer::NewParams params;
+    params.m_HttpResponse = BenchmarkResponse;
+    params.m_MaxConnections = idle_connection_count + client_count;
+    params.m_Threaded = threaded;
+    params.m_RespondOnServerThread = respond_on_server_thread;
+    dmHttpServer::HServer server;
+    ASSERT_EQ(dmHttpServer::RESULT_OK, dmHttpServer::New(&params, 0, &server));
+
+    dmSocket::Address address;
+    uint16_t port;
+    dmHttpServer::GetName(server, &address, &port);
+    dmSocket::GetHostByName(DM_LOOPBACK_ADDRESS_IPV4, &address);
+
+    // Idle connections, e.g. tools that are connected but currently not sending requests.
+    // The server accepts one connection per update in the polled mode
+    dmSocket::Socket idle_sockets[idle_connection_count];
+    for (uint32_t i = 0; i < idle_connection_count; ++i)
+    {
+        dmSocket::New(address.m_family, dmSocket::TYPE_STREAM, dmSocket::PROTOCOL_TCP, &idle_sockets[i]);
+        ASSERT_EQ(dmSocket::RESULT_OK, dmSocket::Connect(idle_sockets[i], address, port));
+        dmHttpServer::Update(server);
+    }
 
-    dmThread::Join(thread);
+    // Cost of an update when no requests are pending
+    const uint32_t idle_updates = 1000;
+    uint64_t start = dmTime::GetTime();
+    for (uint32_t i = 0; i < idle_updates; ++i)
+    {
+        dmHttpServer::Update(server);
+    }
+    float idle_update_us = (dmTime::GetTime() - start) / (float) idle_updates;
+
+    BenchmarkClient clients[client_count];
+    dmThread::Thread threads[client_count];
+    start = dmTime::GetTime();
+    for (uint32_t i = 0; i < client_count; ++i)
+    {
+        clients[i].m_Port = port;
+        clients[i].m_Requests = request_count;
+        clients[i].m_Completed = 0;
+        threads[i] = dmThread::New(BenchmarkClientThread, 0x80000, &clients[i], "bench");
+    }
+
+    // The engine loop, updating the server once per frame
+    uint32_t frames = 0;
+    uint32_t completed = 0;
+    while (completed < client_count * request_count && frames < 100000)
+    {
+        dmHttpServer::Update(server);
+        dmTime::Sleep(1000);
+        ++frames;
+
+        completed = 0;
+        for (uint32_t i = 0; i < client_count; ++i)
+        {
+            completed += dmAtomicGet32(&clients[i].m_Completed);
+        }
+    }
+    uint64_t elapsed = dmTime::GetTime() - start;
+
+    for (uint32_t i = 0; i < client_count; ++i)
+    {
+        dmThread::Join(threads[i]);
+    }
+    for (uint32_t i = 0; i < idle_connection_count; ++i)
+    {
+        dmSocket::Delete(idle_sockets[i]);
+    }
+    dmHttpServer::Delete(server);
+
+    ASSERT_EQ(client_count * request_count, completed);
+    printf("%-28s idle update: %6.2f us  requests: %7.0f/s (%u frames)\n", name, idle_update_us,
+           completed / (elapsed / 1000000.0f), frames);
 }
 
+TEST(dmHttpServerBenchmark, KeepAlive)
+{
+    RunBenchmark("Update", false, false);
+    RunBenchmark("Threaded", true, false);
+    RunBenchmark("Threaded, respond on thread", true, true);
+}
+
+#endif // DM_TEST_BENCHMARKS
+
 int main(int argc, char **argv)
 {
     dmSocket::Initialize();
@@ -20,6 +20,7 @@
 #include "../../src/dlib/hash.h"
 #include "../../src/dlib/message.h"
 #include "../../src/dlib/dstrings.h"
+#include "../../src/dlib/array.h"
 #include "../../src/dlib/thread.h"
 #include "../../src/dlib/time.h"
 #include "../../src/dlib/profile/profile.h"
@@ -280,6 +281,57 @@ TEST(dmMessage, PostDuringDispatch)
     ASSERT_EQ(dmMessage::RESULT_OK, dmMessage::DeleteSocket(receiver.m_Socket));
 }
 
+struct DeleteDuringDispatchContext
+{
+    dmMessage::URL     m_Receiver;
+    dmMessage::HSocket m_Sockets[200];
+    uint32_t           m_SocketCount;
+};
+
+void HandleMessageDeleteSocket(dmMessage::Message *message_object, void *user_ptr)
+{
+    DeleteDuringDispatchContext* ctx = (DeleteDuringDispatchContext*) user_ptr;
+    if (ctx->m_SocketCount > 0)
+    {
+        return;
+    }
+
+    // The socket is deleted once the dispatch is done, and the new sockets must not reuse it meanwhile
+    ASSERT_EQ(dmMessage::RESULT_OK, dmMessage::DeleteSocket(ctx->m_Receiver.m_Socket));
+    for (uint32_t i = 0; i < DM_ARRAY_SIZE(ctx->m_Sockets); ++i)
+    {
+        char name[32];
+        dmSnPrintf(name, sizeof(name), "new_socket_%u", i);
+        ASSERT_EQ(dmMessage::RESULT_OK, dmMessage::NewSocket(name, &ctx->m_Sockets[i]));
+    }
+    ctx->m_SocketCount = DM_ARRAY_SIZE(ctx->m_Sockets);
+}
+
+TEST(dmMessage, DeleteSocketDuringDispatch)
+{
+    const uint32_t max_message_count = 4;
+    DeleteDuringDispatchContext ctx;
+    ctx.m_SocketCount = 0;
+    dmMessage::ResetURL(&ctx.m_Receiver);
+    ASSERT_EQ(dmMessage::RESULT_OK, dmMessage::NewSocket("my_socket", &ctx.m_Receiver.m_Socket));
+
+    for (uint32_t i = 0; i < max_message_count; ++i)
+    {
+        ASSERT_EQ(dmMessage::RESULT_OK, dmMessage::Post(0x0, &ctx.m_Receiver, m_HashMessage1, 0, 0x0, 0x0, 0, 0));
+    }
+
+    ASSERT_EQ(max_message_count, dmMessage::Dispatch(ctx.m_Receiver.m_Socket, HandleMessageDeleteSocket, &ctx));
+    ASSERT_FALSE(dmMessage::IsSocketValid(ctx.m_Receiver.m_Socket));
+
+    for (uint32_t i = 0; i < ctx.m_SocketCount; ++i)
+    {
+        char name[32];
+        dmSnPrintf(name, sizeof(name), "new_socket_%u", i);
+        ASSERT_STREQ(name, dmMessage::GetSocketName(ctx.m_Sockets[i]));
+        ASSERT_EQ(dmMessage::RESULT_OK, dmMessage::DeleteSocket(ctx.m_Sockets[i]));
+    }
+}
+
 #if !defined(DM_NO_THREAD_SUPPORT)
 #define T_ASSERT_EQ(_A, _B) \
     if ( (_A) != (_B) ) { \
@@ -58,6 +58,7 @@
 #include <platform/platform_window.h>
 #include <script/sys_ddf.h>
 #include <liveupdate/liveupdate.h>
+#include <resource/resource_trace.h>
 
 #include "extension.h"
 #include "engine_service.h"
@@ -101,6 +102,10 @@ extern "C" {
 DM_PROPERTY_EXTERN(rmtp_Script);
 DM_PROPERTY_U32(rmtp_LuaMem, 0, FrameReset, "kb", &rmtp_Script); // kilo bytes
 DM_PROPERTY_U32(rmtp_LuaRefs, 0, FrameReset, "# Lua references", &rmtp_Script);
+DM_PROPERTY_GROUP(rmtp_ReverseHash, "Reverse hash");
+DM_PROPERTY_U32(rmtp_ReverseHashStrings, 0, FrameReset, "# strings", &rmtp_ReverseHash);
+DM_PROPERTY_U32(rmtp_ReverseHashMem, 0, FrameReset, "kb", &rmtp_ReverseHash); // kilo bytes
+DM_PROPERTY_U32(rmtp_ReverseHashEvicted, 0, FrameReset, "# evicted strings", &rmtp_ReverseHash);
 
 namespace dmEngine
 {
@@ -359,10 +364,17 @@ namespace dmEngine
             }
         }
 
+        // Waits for the mipmap levels being loaded from the factory
+        dmGameSystem::FinalizeTextureStreaming();
+
         if (engine->m_Factory)
         {
             dmResource::DeleteFactory(engine->m_Factory);
         }
+        dmResourceTrace::Close();
+
+        // The resource loader thread is stopped, so no textures are being transcoded
+        dmGraphics::FinalizeTranscoder();
 
 // TODO: Temporarily disabled as it hangs the shutdown procedure
         // // Stop processing graphics requests before deleting the graphics context
@@ -932,6 +944,8 @@ namespace dmEngine
         graphics_context_params.m_VerifyGraphicsCalls     = verify_graphics_calls;
         graphics_context_params.m_RenderDocSupport        = renderdoc_support || dmConfigFile::GetInt(engine->m_Config, "graphics.use_renderdoc", 0) != 0;
         graphics_context_params.m_UseValidationLayers     = use_validation_layers || dmConfigFile::GetInt(engine->m_Config, "graphics.use_validationlayers", 0) != 0;
+        graphics_context_params.m_CommandRecordThreadCount = (uint8_t) dmMath::Clamp(dmConfigFile::GetInt(engine->m_Config, "graphics.command_record_threads", 0), 0, 255);
+        graphics_context_params.m_ValidateCommandRecording = dmConfigFile::GetInt(engine->m_Config, "graphics.validate_command_recording", 0) != 0;
         graphics_context_params.m_GraphicsMemorySize      = dmConfigFile::GetInt(engine->m_Config, "graphics.memory_size", 0) * 1024*1024; // MB -> bytes
         graphics_context_params.m_Window                  = engine->m_Window;
         graphics_context_params.m_Width                   = engine->m_Width;
@@ -939,6 +953,18 @@ namespace dmEngine
         graphics_context_params.m_PrintDeviceInfo         = dmConfigFile::GetInt(engine->m_Config, "display.display_device_info", 0);
         graphics_context_params.m_JobThread               = engine->m_JobThreadContext;
         graphics_context_params.m_SwapInterval            = swap_interval;
+        graphics_context_params.m_AsyncPipelineCompile    = dmConfigFile::GetInt(engine->m_Config, "graphics.async_pipeline_compile", 0) != 0;
+
+        // Pipelines created this run are stored, and created up front on the pipeline compiler thread when
+        // their shaders are loaded next time (with graphics.async_pipeline_compile)
+        char pipeline_cache_dir[DMPATH_MAX_PATH];
+        char pipeline_cache_path[DMPATH_MAX_PATH];
+        if (dmConfigFile::GetInt(engine->m_Config, "graphics.pipeline_cache", 0) &&
+            dmSys::GetApplicationSupportPath(dmConfigFile::GetString(engine->m_Config, "project.title_as_file_name", "defold"), pipeline_cache_dir, sizeof(pipeline_cache_dir)) == dmSys::RESULT_OK)
+        {
+            dmPath::Concat(pipeline_cache_dir, "vulkan_pipelines.cache", pipeline_cache_path, sizeof(pipeline_cache_path));
+            graphics_context_params.m_PipelineCachePath = pipeline_cache_path;
+        }
 
         engine->m_GraphicsContext = dmGraphics::NewContext(graphics_context_params);
         if (engine->m_GraphicsContext == 0x0)
@@ -947,6 +973,9 @@ namespace dmEngine
             return false;
         }
 
+        // Basis textures are transcoded in the resource preload step, with the mipmap levels spread over these threads
+        dmGraphics::InitializeTranscoder((uint8_t) dmMath::Clamp(dmConfigFile::GetInt(engine->m_Config, "graphics.transcode_threads", 2), 0, (int) dmJobThread::DM_MAX_JOB_THREAD_COUNT));
+
         SetSwapInterval(engine, swap_interval);
 
         uint32_t physical_dpi = dmGraphics::GetDisplayDpi(engine->m_GraphicsContext);
@@ -966,6 +995,12 @@ namespace dmEngine
 
         SetUpdateFrequency(engine, dmConfigFile::GetInt(engine->m_Config, "display.update_frequency", 0));
 
+        const char* load_trace = dmConfigFile::GetString(engine->m_Config, "resource.load_trace", 0);
+        if (load_trace && load_trace[0])
+        {
+            dmResourceTrace::Open(load_trace);
+        }
+
         const uint32_t max_resources = dmConfigFile::GetInt(engine->m_Config, dmResource::MAX_RESOURCES_KEY, 1024);
         dmResource::NewFactoryParams params;
         params.m_MaxResources = max_resources;
@@ -1012,6 +1047,9 @@ namespace dmEngine
         script_params.m_Factory         = engine->m_Factory;
         script_params.m_ConfigFile      = engine->m_Config;
         script_params.m_GraphicsContext = engine->m_GraphicsContext;
+#if !defined(DM_RELEASE)
+        script_params.m_EnableBytecodeCache = 1;
+#endif
 
         bool shared = dmConfigFile::GetInt(engine->m_Config, "script.shared_state", 0);
         if (shared)
@@ -1264,6 +1302,17 @@ namespace dmEngine
         if (fact_result != dmResource::RESULT_OK)
             goto bail;
 
+        if (dmConfigFile::GetInt(engine->m_Config, "graphics.texture_streaming", 0))
+        {
+            dmGameSystem::TextureStreamingParams texture_streaming_params;
+            texture_streaming_params.m_Factory         = engine->m_Factory;
+            texture_streaming_params.m_GraphicsContext = engine->m_GraphicsContext;
+            texture_streaming_params.m_JobThread       = engine->m_JobThreadContext;
+            texture_streaming_params.m_Budget          = dmConfigFile::GetInt(engine->m_Config, "graphics.texture_streaming_budget", 128) * 1024*1024; // MB -> bytes
+            texture_streaming_params.m_InitialSize     = (uint16_t) dmMath::Clamp(dmConfigFile::GetInt(engine->m_Config, "graphics.texture_streaming_initial_size", 64), 1, 0xFFFF);
+            dmGameSystem::InitializeTextureStreaming(texture_streaming_params);
+        }
+
         go_result = dmGameSystem::RegisterComponentTypes(engine->m_Factory, engine->m_Register, engine->m_RenderContext, &engine->m_PhysicsContext, &engine->m_ParticleFXContext, &engine->m_SpriteContext,
                                                                                                 &engine->m_CollectionProxyContext, &engine->m_FactoryContext, &engine->m_CollectionFactoryContext,
                                                                                                 &engine->m_ModelContext, &engine->m_LabelContext, &engine->m_TilemapContext,
@@ -1380,7 +1429,9 @@ namespace dmEngine
                 goto bail;
         }
 
+        dmResourceTrace::Write(dmResourceTrace::EVENT_GROUP_BEGIN, "bootstrap.main_collection", 0);
         fact_result = dmResource::Get(engine->m_Factory, dmConfigFile::GetString(engine->m_Config, "bootstrap.main_collection", "/logic/main.collectionc"), (void**) &engine->m_MainCollection);
+        dmResourceTrace::Write(dmResourceTrace::EVENT_GROUP_END, "bootstrap.main_collection", 0);
         if (fact_result != dmResource::RESULT_OK)
             goto bail;
         dmGameObject::Init(engine->m_MainCollection);
@@ -1467,6 +1518,9 @@ namespace dmEngine
             dmExtension::DispatchEvent( &params, &event );
         }
 
+        // The ids registered during startup are never evicted from the reverse hash strings
+        dmHashKeepReverseHashStrings();
+
         engine->m_PreviousFrameTime = dmTime::GetTime();
 
         return true;
@@ -1635,6 +1689,8 @@ bail:
 
                 dmJobThread::Update(engine->m_JobThreadContext);
 
+                dmGameSystem::UpdateTextureStreaming();
+
                 {
                     DM_PROFILE("Script");
 
@@ -1777,6 +1833,12 @@ bail:
 
             if (dLib::IsDebugMode())
             {
+                dmHashReverseHashStats reverse_hash_stats;
+                dmHashGetReverseHashStats(&reverse_hash_stats);
+                DM_PROPERTY_SET_U32(rmtp_ReverseHashStrings, reverse_hash_stats.m_Strings);
+                DM_PROPERTY_SET_U32(rmtp_ReverseHashMem, (reverse_hash_stats.m_PagesSize + reverse_hash_stats.m_TableSize) / 1024);
+                DM_PROPERTY_SET_U32(rmtp_ReverseHashEvicted, reverse_hash_stats.m_EvictedCount);
+
                 // We had buffering problems with the output when running the engine inside the editor
                 // Flushing stdout/stderr solves this problem.
                 fflush(stdout);
@@ -2094,7 +2156,7 @@ bail:
         }
     }
 
-    bool LoadBootstrapContent(HEngine engine, dmConfigFile::HConfig config)
+    static bool DoLoadBootstrapContent(HEngine engine, dmConfigFile::HConfig config)
     {
         dmResource::Result fact_error;
 #if !defined(DM_RELEASE)
@@ -2147,6 +2209,14 @@ bail:
         return true;
     }
 
+    bool LoadBootstrapContent(HEngine engine, dmConfigFile::HConfig config)
+    {
+        dmResourceTrace::Write(dmResourceTrace::EVENT_GROUP_BEGIN, "LoadBootstrapContent", 0);
+        bool result = DoLoadBootstrapContent(engine, config);
+        dmResourceTrace::Write(dmResourceTrace::EVENT_GROUP_END, "LoadBootstrapContent", 0);
+        return result;
+    }
+
     void UnloadBootstrapContent(HEngine engine)
     {
         if (engine->m_RenderScriptPrototype)
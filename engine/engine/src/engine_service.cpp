@@ -352,6 +352,8 @@ namespace dmEngineService
 
             dmWebServer::NewParams params;
             params.m_Port = port;
+            // Accept and wait for requests on a thread, so that idle tool connections don't cost anything per frame
+            params.m_Threaded = 1;
             dmWebServer::HServer web_server;
             dmWebServer::Result r = dmWebServer::New(&params, &web_server);
             if (r != dmWebServer::RESULT_OK)
@@ -65,11 +65,29 @@ namespace dmGameObject
         uint16_t            m_Composite : 1;
         uint16_t            m_Backwards : 1;
         uint16_t            m_FirstUpdate : 1;
+        uint16_t            m_Evaluate : 1;
+    };
+
+    /*
+     * Dense arrays of the animations to evaluate in a frame, sorted by easing curve type.
+     * Keeping the hot data in separate contiguous arrays lets us evaluate the easing of a
+     * whole group of animations in one call, and lets the compiler vectorize the interpolation.
+     */
+    struct AnimEvalBuffer
+    {
+        dmArray<float>      m_T;
+        dmArray<float>      m_From;
+        dmArray<float>      m_To;
+        dmArray<float*>     m_Value;
+        dmArray<uint16_t>   m_Animation;
+        uint32_t            m_Counts[dmEasing::TYPE_COUNT];
+        uint32_t            m_Offsets[dmEasing::TYPE_COUNT];
     };
 
     struct AnimWorld
     {
         dmArray<Animation>                  m_Animations;
+        AnimEvalBuffer                      m_EvalBuffer;
         dmArray<uint16_t>                   m_AnimMap;
         dmIndexPool<uint16_t>               m_AnimMapIndexPool;
         dmHashTable<uintptr_t, uint16_t>    m_InstanceToIndex;
@@ -77,6 +95,17 @@ namespace dmGameObject
         uint32_t                            m_InUpdate : 1;
     };
 
+    static void ReserveEvalBuffer(AnimEvalBuffer* buffer, uint32_t capacity)
+    {
+        if (buffer->m_T.Capacity() >= capacity)
+            return;
+        buffer->m_T.SetCapacity(capacity);
+        buffer->m_From.SetCapacity(capacity);
+        buffer->m_To.SetCapacity(capacity);
+        buffer->m_Value.SetCapacity(capacity);
+        buffer->m_Animation.SetCapacity(capacity);
+    }
+
     CreateResult CompAnimNewWorld(const ComponentNewWorldParams& params)
     {
         if (params.m_World != 0x0)
@@ -85,6 +114,7 @@ namespace dmGameObject
             *params.m_World = world;
             const uint32_t anim_count = 512;
             world->m_Animations.SetCapacity(anim_count);
+            ReserveEvalBuffer(&world->m_EvalBuffer, anim_count);
             world->m_AnimMap.SetCapacity(MAX_CAPACITY);
             world->m_AnimMap.SetSize(MAX_CAPACITY);
             world->m_AnimMapIndexPool.SetCapacity(MAX_CAPACITY);
@@ -159,6 +189,114 @@ namespace dmGameObject
         return CREATE_RESULT_OK;
     }
 
+    static inline uint32_t GetEvalGroup(const dmEasing::Curve& curve)
+    {
+        return (uint32_t)curve.type;
+    }
+
+    static inline float GetCursorValue(const Animation& anim)
+    {
+        float t = 1.0f;
+        if (anim.m_Cursor < anim.m_Duration)
+            t = dmMath::Clamp(anim.m_Cursor * anim.m_InvDuration, 0.0f, 1.0f);
+        if (anim.m_Backwards)
+            t = 1.0f - t;
+        if (anim.m_Playback == PLAYBACK_ONCE_PINGPONG || anim.m_Playback == PLAYBACK_LOOP_PINGPONG) {
+            t *= 2.0f;
+            if (t > 1.0f) {
+                t = 2.0f - t;
+            }
+        }
+        return t;
+    }
+
+    static void EvaluateAnimations(AnimWorld* world, uint32_t eval_count)
+    {
+        DM_PROFILE("Evaluate");
+
+        if (eval_count == 0)
+            return;
+
+        AnimEvalBuffer& buffer = world->m_EvalBuffer;
+        ReserveEvalBuffer(&buffer, world->m_Animations.Capacity());
+        buffer.m_T.SetSize(eval_count);
+        buffer.m_From.SetSize(eval_count);
+        buffer.m_To.SetSize(eval_count);
+        buffer.m_Value.SetSize(eval_count);
+        buffer.m_Animation.SetSize(eval_count);
+
+        uint32_t offset = 0;
+        for (uint32_t type = 0; type < dmEasing::TYPE_COUNT; ++type)
+        {
+            buffer.m_Offsets[type] = offset;
+            offset += buffer.m_Counts[type];
+        }
+
+        // Gather the hot data into the dense arrays, grouped by easing type
+        uint32_t size = world->m_Animations.Size();
+        for (uint32_t i = 0; i < size; ++i)
+        {
+            Animation& anim = world->m_Animations[i];
+            if (!anim.m_Evaluate)
+                continue;
+            anim.m_Evaluate = 0;
+            uint32_t index = buffer.m_Offsets[GetEvalGroup(anim.m_Easing)]++;
+            buffer.m_T[index] = GetCursorValue(anim);
+            buffer.m_From[index] = anim.m_From;
+            buffer.m_To[index] = anim.m_To;
+            buffer.m_Value[index] = anim.m_Value;
+            buffer.m_Animation[index] = (uint16_t)i;
+        }
+
+        // Evaluate the easing curves, one call per built in curve type.
+        // Custom curves each have their own sample vector and are evaluated one by one.
+        float* t = buffer.m_T.Begin();
+        offset = 0;
+        for (uint32_t type = 0; type < dmEasing::TYPE_COUNT; ++type)
+        {
+            uint32_t count = buffer.m_Counts[type];
+            if (count == 0)
+                continue;
+            if (type == dmEasing::TYPE_FLOAT_VECTOR)
+            {
+                for (uint32_t i = offset; i < offset + count; ++i)
+                {
+                    t[i] = dmEasing::GetValue(world->m_Animations[buffer.m_Animation[i]].m_Easing, t[i]);
+                }
+            }
+            else
+            {
+                dmEasing::GetValues(dmEasing::Curve((dmEasing::Type)type), t + offset, t + offset, count);
+            }
+            offset += count;
+        }
+
+        // Interpolate, the result is stored in place of t
+        const float* from = buffer.m_From.Begin();
+        const float* to = buffer.m_To.Begin();
+        for (uint32_t i = 0; i < eval_count; ++i)
+        {
+            t[i] = from[i] + (to[i] - from[i]) * t[i];
+        }
+
+        // Write the values, directly when the property exposes a value pointer (e.g. position, rotation and scale)
+        float** values = buffer.m_Value.Begin();
+        for (uint32_t i = 0; i < eval_count; ++i)
+        {
+            if (values[i] != 0x0)
+            {
+                *values[i] = t[i];
+            }
+            else
+            {
+                Animation& anim = world->m_Animations[buffer.m_Animation[i]];
+                PropertyOptions property_opt;
+                property_opt.m_Index = 0;
+                SetProperty(anim.m_Instance, anim.m_ComponentId, anim.m_PropertyId, property_opt, PropertyVar(t[i]));
+            }
+        }
+    }
+
     UpdateResult CompAnimUpdate(const ComponentsUpdateParams& params, ComponentsUpdateResult& update_result)
     {
         DM_PROFILE("Update");
@@ -173,7 +311,8 @@ namespace dmGameObject
          * have an incorrect value when read by the newly started animation to
          * retrieve the from-value.
          *
-         * The second pass advances and evaluates the animations.
+         * The second pass advances the animations, and queues them for evaluation. The queued
+         * animations are then evaluated in batches grouped by easing curve (see EvaluateAnimations).
          *
          * The third pass prunes stopped animations and call callbacks.
          *
@@ -235,6 +374,9 @@ namespace dmGameObject
                 }
             }
         }
+        AnimEvalBuffer& eval_buffer = world->m_EvalBuffer;
+        memset(eval_buffer.m_Counts, 0, sizeof(eval_buffer.m_Counts));
+        uint32_t eval_count = 0;
         i = 0;
         for (i = 0; i < size; ++i)
         {
@@ -294,38 +436,21 @@ namespace dmGameObject
                 break;
             }
 
-            // Evaluate animation
+            // Queue animation for evaluation
             if (!anim.m_Composite)
             {
-                float t = 1.0f;
-                if (anim.m_Cursor < anim.m_Duration)
-                    t = dmMath::Clamp(anim.m_Cursor * anim.m_InvDuration, 0.0f, 1.0f);
-                if (anim.m_Backwards)
-                    t = 1.0f - t;
-                if (anim.m_Playback == PLAYBACK_ONCE_PINGPONG || anim.m_Playback == PLAYBACK_LOOP_PINGPONG) {
-                    t *= 2.0f;
-                    if (t > 1.0f) {
-                        t = 2.0f - t;
-                    }
-                }
-                t = dmEasing::GetValue(anim.m_Easing, t);
-                float v = anim.m_From + (anim.m_To - anim.m_From) * t;
-                if (anim.m_Value != 0x0)
-                {
-                    *anim.m_Value = v;
-                }
-                else
-                {
-                    PropertyOptions property_opt;
-                    property_opt.m_Index = 0;
-                    SetProperty(anim.m_Instance, anim.m_ComponentId, anim.m_PropertyId, property_opt, PropertyVar(v));
-                }
+                anim.m_Evaluate = 1;
+                ++eval_buffer.m_Counts[GetEvalGroup(anim.m_Easing)];
+                ++eval_count;
             }
             if (completed)
             {
                 StopAnimation(&anim, true);
             }
         }
+
+        EvaluateAnimations(world, eval_count);
+
         i = 0;
         // Prune canceled animations and call callbacks
         while (i < size)
@@ -16,6 +16,7 @@
 #define GAMEOBJECT_COMMON_H
 
 #include <dlib/hash.h>
+#include <dlib/flat_hashtable.h>
 #include <dlib/hashtable.h>
 #include <dlib/index_pool.h>
 #include <dlib/math.h>
@@ -251,7 +252,7 @@ namespace dmGameObject
         dmArray<Matrix4>         m_WorldTransforms;
 
         // Identifier to Instance mapping
-        dmHashTable64<Instance*> m_IDToInstance;
+        dmFlatHashTable64<Instance*> m_IDToInstance;
 
         // Stack keeping track of which instance has the input focus
         dmArray<Instance*>       m_InputFocusStack;
@@ -246,7 +246,7 @@ bail:
         size_t size = sizeof(Collection) + sizeof(CollectionHandle);
         size += collection->m_InstanceIndices.Capacity()*sizeof(uint16_t);
         size += collection->m_WorldTransforms.Capacity()*sizeof(Matrix4);
-        size += collection->m_IDToInstance.Capacity()*(sizeof(Instance*)+sizeof(dmhash_t));
+        size += collection->m_IDToInstance.GetAllocatedSize();
         size += collection->m_InputFocusStack.Capacity()*sizeof(Instance*);
         size += collection->m_Instances.Capacity()*sizeof(Instance*);
         return size;
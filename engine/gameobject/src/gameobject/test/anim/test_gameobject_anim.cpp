@@ -508,6 +508,55 @@ TEST_F(AnimTest, LoadTest)
     }
 }
 
+// Many concurrent tweens of transform properties, using a mix of easing curves
+TEST_F(AnimTest, MixedCurves)
+{
+    const uint32_t instance_count = 2 * dmEasing::TYPE_FLOAT_VECTOR;
+    const uint32_t tweens_per_instance = 4;
+    const uint32_t frame_count = 30;
+    dmGameObject::HCollection collection = dmGameObject::NewCollection("mixed_curves", m_Factory, m_Register, instance_count, 0x0);
+    ASSERT_NE((dmGameObject::HCollection)0, collection);
+
+    m_UpdateContext.m_DT = 1.0f / 60.0f;
+    dmhash_t ids[tweens_per_instance] = {hash("position.x"), hash("position.y"), hash("scale.x"), hash("euler.z")};
+    dmGameObject::PropertyVar var(10.0f);
+    float duration = 2.0f;
+    float delay = 0.0f;
+
+    dmArray<dmGameObject::HInstance> gos;
+    gos.SetCapacity(instance_count);
+    for (uint32_t i = 0; i < instance_count; ++i)
+    {
+        dmGameObject::HInstance go = dmGameObject::New(collection, "/dummy.goc");
+        ASSERT_NE((dmGameObject::HInstance)0, go);
+        gos.Push(go);
+        for (uint32_t j = 0; j < tweens_per_instance; ++j)
+        {
+            dmEasing::Curve curve((dmEasing::Type)((i + j) % dmEasing::TYPE_FLOAT_VECTOR));
+            dmGameObject::PropertyResult result = Animate(collection, go, 0, ids[j], dmGameObject::PLAYBACK_LOOP_PINGPONG, var, curve, duration, delay, 0x0, 0x0, 0x0);
+            ASSERT_EQ(dmGameObject::PROPERTY_RESULT_OK, result);
+        }
+    }
+
+    for (uint32_t i = 0; i < frame_count + 1; ++i)
+    {
+        dmGameObject::Update(collection, &m_UpdateContext);
+    }
+
+    // Instance i animates position.x with easing curve i
+    float t = 2.0f * (frame_count + 1) * m_UpdateContext.m_DT / duration;
+    if (t > 1.0f)
+        t = 2.0f - t;
+    for (uint32_t i = 0; i < instance_count; ++i)
+    {
+        dmEasing::Curve curve((dmEasing::Type)(i % dmEasing::TYPE_FLOAT_VECTOR));
+        ASSERT_NEAR(10.0f * dmEasing::GetValue(curve, t), X(gos[i]), 0.001f);
+    }
+
+    dmGameObject::DeleteCollection(collection);
+    dmGameObject::PostUpdate(m_Register);
+}
+
 TEST_F(AnimTest, LinkedList)
 {
     m_UpdateContext.m_DT = 0.25f;
@@ -2465,6 +2465,13 @@ namespace dmGameSystem
         }
     }
 
+    // The vertex data is uploaded while rendering the scenes, so the render objects are all there is to it
+    static void RenderListContentHash(void* user_data, const dmRender::RenderListEntry& entry, HashState64* state)
+    {
+        const dmRender::RenderObject* ro = (dmRender::RenderObject*) entry.m_UserData;
+        dmHashUpdateBuffer64(state, ro, sizeof(*ro));
+    }
+
     static dmGameObject::UpdateResult CompGuiRender(const dmGameObject::ComponentsRenderParams& params)
     {
         GuiWorld* gui_world = (GuiWorld*)params.m_World;
@@ -2517,6 +2524,7 @@ namespace dmGameSystem
 
             dmRender::RenderListEntry* render_list = dmRender::RenderListAlloc(gui_context->m_RenderContext, count);
             dmRender::HRenderListDispatch dispatch = dmRender::RenderListMakeDispatch(gui_context->m_RenderContext, &RenderListDispatch, gui_world);
+            dmRender::RenderListSetContentHashFn(gui_context->m_RenderContext, dispatch, &RenderListContentHash);
             dmRender::RenderListEntry* write_ptr = render_list;
 
             uint32_t render_order = dmGui::GetRenderOrder(c->m_Scene);
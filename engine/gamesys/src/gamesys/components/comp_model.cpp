@@ -34,6 +34,7 @@
 
 #include "../gamesys.h"
 #include "../gamesys_private.h"
+#include "../texture_streaming.h"
 #include "../resources/res_animationset.h"
 #include "../resources/res_material.h"
 #include "../resources/res_meshset.h"
@@ -53,6 +54,8 @@ DM_PROPERTY_U32(rmtp_Model, 0, FrameReset, "# components", &rmtp_Components);
 DM_PROPERTY_U32(rmtp_ModelIndexCount, 0, FrameReset, "# indices", &rmtp_Model);
 DM_PROPERTY_U32(rmtp_ModelVertexCount, 0, FrameReset, "# vertices", &rmtp_Model);
 DM_PROPERTY_U32(rmtp_ModelVertexSize, 0, FrameReset, "size of vertices in bytes", &rmtp_Model);
+DM_PROPERTY_U32(rmtp_ModelInstancedDrawCount, 0, FrameReset, "# instanced render objects", &rmtp_Model);
+DM_PROPERTY_U32(rmtp_ModelInstanceCount, 0, FrameReset, "# meshes drawn with instancing", &rmtp_Model);
 
 namespace dmGameSystem
 {
@@ -105,6 +108,7 @@ namespace dmGameSystem
         HComponentRenderConstants   m_RenderConstants;
         TextureResource*            m_Textures[dmRender::RenderObject::MAX_TEXTURE_COUNT];
         MaterialResource*           m_Material; // Override material
+        uint32_t                    m_DynamicVertexAttributeIndex;
 
         /// Node instances corresponding to the bones
         dmArray<dmGameObject::HInstance> m_NodeInstances;
@@ -132,6 +136,7 @@ namespace dmGameSystem
         uint32_t*                        m_VertexBufferDispatchCounts;
         // Temporary scratch array for instances, only used during the creation phase of components
         dmArray<dmGameObject::HInstance> m_ScratchInstances;
+        DynamicAttributePool             m_DynamicVertexAttributePool;
         dmRig::HRigContext               m_RigContext;
         uint32_t                         m_MaxElementsVertices;
         uint32_t                         m_MaxBatchIndex;
@@ -168,6 +173,7 @@ namespace dmGameSystem
 
         world->m_Components.SetCapacity(comp_count);
         world->m_RenderObjects.SetCapacity(comp_count);
+        InitializeMaterialAttributeInfos(world->m_DynamicVertexAttributePool, 8);
         // position, normal, tangent, color, texcoord0, texcoord1 * sizeof(float)
         DM_STATIC_ASSERT( sizeof(dmRig::RigModelVertex) == ((3+3+4+4+2+2)*4), Invalid_Struct_Size);
 
@@ -225,6 +231,8 @@ namespace dmGameSystem
 
         dmRig::DeleteContext(world->m_RigContext);
 
+        DestroyMaterialAttributeInfos(world->m_DynamicVertexAttributePool);
+
         delete [] world->m_VertexBufferData;
         delete [] world->m_VertexBufferVertexCounts;
         delete [] world->m_VertexBufferDispatchCounts;
@@ -442,7 +450,7 @@ namespace dmGameSystem
         FillMaterialAttributeInfos(material, instance_vx_decl, &material_infos, GetRenderMaterialCoordinateSpace(material));
 
         dmGraphics::VertexAttributeInfos attribute_infos;
-        FillAttributeInfos(0, INVALID_DYNAMIC_ATTRIBUTE_INDEX, // Dynamic vertex attributes are not supported yet
+        FillAttributeInfos(0, INVALID_DYNAMIC_ATTRIBUTE_INDEX, // Only instance attributes can be overridden, and those aren't hashed
                     component->m_Resource->m_Materials[item.m_MaterialIndex].m_Attributes,
                     component->m_Resource->m_Materials[item.m_MaterialIndex].m_AttributeCount,
                     &material_infos,
@@ -874,6 +882,7 @@ namespace dmGameSystem
         component->m_DoRender = 0;
         component->m_FunctionRef = 0;
         component->m_RenderConstants = 0;
+        component->m_DynamicVertexAttributeIndex = INVALID_DYNAMIC_ATTRIBUTE_INDEX;
 
         // Create GO<->bone representation
         // We need to make sure that bone GOs are created before we start the default animation.
@@ -924,6 +933,8 @@ namespace dmGameSystem
             dmGameSystem::DestroyRenderConstants(component->m_RenderConstants);
         }
 
+        FreeMaterialAttribute(world->m_DynamicVertexAttributePool, component->m_DynamicVertexAttributeIndex);
+
         delete component;
         world->m_Components.Free(index, true);
     }
@@ -1060,7 +1071,8 @@ namespace dmGameSystem
                 }
 
                 FillMaterialAttributeInfos(render_material, attribute_rd->m_InstanceVertexDeclaration, &material_infos, GetRenderMaterialCoordinateSpace(render_material));
-                FillAttributeInfos(0, INVALID_DYNAMIC_ATTRIBUTE_INDEX, // Dynamic vertex attributes are not supported yet
+                FillAttributeInfos(&world->m_DynamicVertexAttributePool,
+                            instance_component->m_DynamicVertexAttributeIndex,
                             instance_component->m_Resource->m_Materials[material_index].m_Attributes,
                             instance_component->m_Resource->m_Materials[material_index].m_AttributeCount,
                             &material_infos,
@@ -1120,6 +1132,9 @@ namespace dmGameSystem
         dmRender::AddToRender(render_context, &ro);
 
         world->m_InstanceBufferDataLocalSpace.SetSize(instance_write_ptr - world->m_InstanceBufferDataLocalSpace.Begin());
+
+        DM_PROPERTY_ADD_U32(rmtp_ModelInstancedDrawCount, 1);
+        DM_PROPERTY_ADD_U32(rmtp_ModelInstanceCount, instance_count);
     }
 
     static void RenderBatchLocalVSUninstanced(ModelWorld* world, dmRender::HRenderContext render_context,
@@ -1256,7 +1271,7 @@ namespace dmGameSystem
         return true;
     }
 
-    static void PrepareWorldSpaceBatchBuffers(ModelWorld* world, uint32_t batch_index, dmRender::HMaterial material,
+    static void PrepareWorldSpaceBatchBuffers(ModelWorld* world, uint32_t batch_index, dmRender::HMaterial material, bool has_dynamic_attributes,
         dmGraphics::HVertexDeclaration* vx_decl_in_out, uint32_t* vertex_stride_out,
         dmGraphics::VertexAttributeInfos* material_infos_vertex, uint32_t vertex_count, uint8_t** vb_begin)
     {
@@ -1265,7 +1280,8 @@ namespace dmGameSystem
 
         dmGraphics::HVertexDeclaration vx_decl = *vx_decl_in_out;
 
-        if (CanUseDefaultVertexDeclaration(material))
+        // The default vertex format is written without the attribute values, so attribute overrides need the material format
+        if (!has_dynamic_attributes && CanUseDefaultVertexDeclaration(material))
         {
             vx_decl = world->m_VertexDeclaration;
         }
@@ -1311,7 +1327,8 @@ namespace dmGameSystem
         if (has_custom_attributes)
         {
             dmGraphics::VertexAttributeInfos attribute_infos;
-            FillAttributeInfos(0, INVALID_DYNAMIC_ATTRIBUTE_INDEX, // Not supported yet
+            FillAttributeInfos(&world->m_DynamicVertexAttributePool,
+                c->m_DynamicVertexAttributeIndex,
                 c->m_Resource->m_Model->m_Materials[material_index].m_Attributes.m_Data,
                 c->m_Resource->m_Model->m_Materials[material_index].m_Attributes.m_Count,
                 material_infos,
@@ -1342,11 +1359,13 @@ namespace dmGameSystem
 
         world->m_MaxBatchIndex = dmMath::Max(batch_index, world->m_MaxBatchIndex);
 
+        bool has_dynamic_attributes = false;
         for (uint32_t *i=begin;i!=end;i++)
         {
             const MeshRenderItem* render_item = (MeshRenderItem*) buf[*i].m_UserData;
             vertex_count += render_item->m_Buffers->m_VertexCount;
             index_count += render_item->m_Buffers->m_IndexCount;
+            has_dynamic_attributes |= render_item->m_Component->m_DynamicVertexAttributeIndex != INVALID_DYNAMIC_ATTRIBUTE_INDEX;
         }
 
         // Early exit if there is nothing to render
@@ -1364,7 +1383,7 @@ namespace dmGameSystem
         dmGraphics::VertexAttributeInfos material_infos_vertex;
         uint8_t* vb_begin;
 
-        PrepareWorldSpaceBatchBuffers(world, batch_index, material,
+        PrepareWorldSpaceBatchBuffers(world, batch_index, material, has_dynamic_attributes,
             &vx_decl, &vertex_stride, &material_infos_vertex,
             required_vertex_count, &vb_begin);
 
@@ -1454,10 +1473,56 @@ namespace dmGameSystem
         return material_vertex_space;
     }
 
+    // Requests the mipmap levels sampled when drawing the meshes of the batch, from the size of their bounding boxes on screen.
+    // The textures are assumed to be mapped once over the largest side of the box.
+    static void RequestTextureMipMaps(dmRender::HRenderContext render_context, dmRender::RenderListEntry* buf, uint32_t* begin, uint32_t* end)
+    {
+        DM_PROFILE(__FUNCTION__);
+
+        dmGraphics::HContext graphics_context = dmRender::GetGraphicsContext(render_context);
+        const Matrix4& view_proj              = dmRender::GetViewProjectionMatrix(render_context);
+        float viewport_width                  = (float) dmGraphics::GetWidth(graphics_context);
+        float viewport_height                 = (float) dmGraphics::GetHeight(graphics_context);
+
+        for (uint32_t* i = begin; i != end; ++i)
+        {
+            const MeshRenderItem* render_item = (MeshRenderItem*) buf[*i].m_UserData;
+            const ModelComponent* component   = render_item->m_Component;
+            const Matrix4& world              = render_item->m_World;
+            Vector3 extents                   = render_item->m_AabbMax - render_item->m_AabbMin;
+            Point3 center                     = Point3((world * Point3((render_item->m_AabbMin + render_item->m_AabbMax) * 0.5f)).getXYZ());
+
+            float pixels = GetProjectedSize(view_proj, center, world.getCol0().getXYZ() * extents.getX(), viewport_width, viewport_height);
+            pixels = dmMath::Max(pixels, GetProjectedSize(view_proj, center, world.getCol1().getXYZ() * extents.getY(), viewport_width, viewport_height));
+            pixels = dmMath::Max(pixels, GetProjectedSize(view_proj, center, world.getCol2().getXYZ() * extents.getZ(), viewport_width, viewport_height));
+
+            MaterialResource* material = GetMaterialResource(component, component->m_Resource, render_item->m_MaterialIndex);
+            for (uint32_t j = 0; j < material->m_NumTextures; ++j)
+            {
+                TextureResource* texture_res = component->m_Textures[j];
+                if (!texture_res)
+                {
+                    texture_res = GetTextureFromSamplerNameHash(&component->m_Resource->m_Materials[render_item->m_MaterialIndex], material, j, material->m_SamplerNames[j]);
+                }
+                if (!texture_res || !texture_res->m_Texture)
+                    continue;
+
+                uint16_t width, height;
+                GetTextureFullSize(texture_res->m_Texture, &width, &height);
+                RequestTextureMipMap(texture_res->m_Texture, GetSampledMipMap(dmMath::Max(width, height), pixels));
+            }
+        }
+    }
+
     static void RenderBatch(ModelWorld* world, dmRender::HRenderContext render_context, dmRender::RenderListEntry *buf, uint32_t* begin, uint32_t* end)
     {
         DM_PROFILE("ModelRenderBatch");
 
+        if (IsTextureStreamingEnabled())
+        {
+            RequestTextureMipMaps(render_context, buf, begin, end);
+        }
+
         const MeshRenderItem* render_item = (MeshRenderItem*) buf[*begin].m_UserData;
         const ModelComponent* component = render_item->m_Component;
 
@@ -1612,6 +1677,32 @@ namespace dmGameSystem
         }
     }
 
+    // Everything the vertex and instance data of a mesh is written from, that isn't part of its render list entry
+    static void RenderListContentHash(void* user_data, const dmRender::RenderListEntry& entry, HashState64* state)
+    {
+        ModelWorld* world = (ModelWorld*) user_data;
+        const MeshRenderItem* render_item = (MeshRenderItem*) entry.m_UserData;
+        const ModelComponent* component = render_item->m_Component;
+
+        dmHashUpdateBuffer64(state, &render_item->m_World, sizeof(render_item->m_World));
+        if (component->m_RigInstance)
+        {
+            // Skinned meshes are written from the whole pose
+            const dmArray<dmRig::BonePose>& pose = *dmRig::GetPose(component->m_RigInstance);
+            dmHashUpdateBuffer64(state, pose.Begin(), pose.Size() * sizeof(dmRig::BonePose));
+        }
+        HashMaterialAttributes(world->m_DynamicVertexAttributePool, component->m_DynamicVertexAttributeIndex, state);
+    }
+
+    // Recorded meshes aren't batched, but their textures are still drawn
+    static void RenderListReplay(dmRender::HRenderContext render_context, void* user_data, dmRender::RenderListEntry* buf, uint32_t* begin, uint32_t* end)
+    {
+        if (IsTextureStreamingEnabled())
+        {
+            RequestTextureMipMaps(render_context, buf, begin, end);
+        }
+    }
+
     static void RenderListDispatch(dmRender::RenderListDispatchParams const &params)
     {
         ModelWorld *world = (ModelWorld *) params.m_UserData;
@@ -1691,6 +1782,8 @@ namespace dmGameSystem
         // Prepare list submit
         dmRender::RenderListEntry* render_list = dmRender::RenderListAlloc(render_context, mesh_count);
         dmRender::HRenderListDispatch dispatch = dmRender::RenderListMakeDispatch(render_context, &RenderListDispatch, &RenderListFrustumCulling, world);
+        dmRender::RenderListSetContentHashFn(render_context, dispatch, &RenderListContentHash);
+        dmRender::RenderListSetReplayFn(render_context, dispatch, &RenderListReplay);
         dmRender::RenderListEntry* write_ptr = render_list;
 
         const uint32_t max_elements_vertices = world->m_MaxElementsVertices;
@@ -1766,6 +1859,20 @@ namespace dmGameSystem
         component->m_ReHash = 1;
     }
 
+    static bool CompModelGetMaterialAttributeCallback(void* user_data, dmhash_t name_hash, const dmGraphics::VertexAttribute** attribute)
+    {
+        ModelComponent* component         = (ModelComponent*) user_data;
+        const MaterialInfo& material_info = component->m_Resource->m_Materials[0];
+
+        int model_attribute_index = FindAttributeIndex(material_info.m_Attributes, material_info.m_AttributeCount, name_hash);
+        if (model_attribute_index >= 0)
+        {
+            *attribute = &material_info.m_Attributes[model_attribute_index];
+            return true;
+        }
+        return false;
+    }
+
     dmGameObject::UpdateResult CompModelOnMessage(const dmGameObject::ComponentOnMessageParams& params)
     {
         ModelWorld* world = (ModelWorld*)params.m_World;
@@ -1912,7 +2019,13 @@ namespace dmGameSystem
                 return GetResourceProperty(dmGameObject::GetFactory(params.m_Instance), GetTextureResource(component, 0, i), out_value);
             }
         }
-        return GetMaterialConstant(GetComponentMaterial(component, component->m_Resource, 0), params.m_PropertyId, params.m_Options.m_Index, out_value, true, CompModelGetConstantCallback, component);
+        dmRender::HMaterial material = GetComponentMaterial(component, component->m_Resource, 0);
+        dmGameObject::PropertyResult res = GetMaterialConstant(material, params.m_PropertyId, params.m_Options.m_Index, out_value, true, CompModelGetConstantCallback, component);
+        if (res == dmGameObject::PROPERTY_RESULT_NOT_FOUND)
+        {
+            return GetMaterialAttribute(world->m_DynamicVertexAttributePool, component->m_DynamicVertexAttributeIndex, material, params.m_PropertyId, out_value, CompModelGetMaterialAttributeCallback, component);
+        }
+        return res;
     }
 
     dmGameObject::PropertyResult CompModelSetProperty(const dmGameObject::ComponentSetPropertyParams& params)
@@ -1974,7 +2087,25 @@ namespace dmGameSystem
                 return res;
             }
         }
-        return SetMaterialConstant(GetComponentMaterial(component, component->m_Resource, 0), params.m_PropertyId, params.m_Value, params.m_Options.m_Index, CompModelSetConstantCallback, component);
+        dmRender::HMaterial material = GetComponentMaterial(component, component->m_Resource, 0);
+        dmGameObject::PropertyResult res = SetMaterialConstant(material, params.m_PropertyId, params.m_Value, params.m_Options.m_Index, CompModelSetConstantCallback, component);
+
+        // Only check attributes if the constant property was not found
+        if (res == dmGameObject::PROPERTY_RESULT_NOT_FOUND)
+        {
+            // Per vertex attribute data of local space models lives in static vertex buffers,
+            // so only the instance attributes (written each frame) can be overridden.
+            // World space models write all their vertices each frame.
+            dmRender::MaterialProgramAttributeInfo info;
+            if (GetRenderMaterialVertexSpace(material) == dmRenderDDF::MaterialDesc::VERTEX_SPACE_LOCAL &&
+                dmRender::GetMaterialProgramAttributeInfo(material, params.m_PropertyId, info) &&
+                info.m_Attribute->m_StepFunction != dmGraphics::VERTEX_STEP_FUNCTION_INSTANCE)
+            {
+                return dmGameObject::PROPERTY_RESULT_UNSUPPORTED_OPERATION;
+            }
+            return SetMaterialAttribute(world->m_DynamicVertexAttributePool, &component->m_DynamicVertexAttributeIndex, material, params.m_PropertyId, params.m_Value, CompModelGetMaterialAttributeCallback, component);
+        }
+        return res;
     }
 
     static void ResourceReloadedCallback(const dmResource::ResourceReloadedParams* params)
@@ -2125,4 +2256,11 @@ namespace dmGameSystem
         *vx_buffers       = world->m_VertexBuffers;
         *vx_buffers_count = VERTEX_BUFFER_MAX_BATCHES;
     }
+
+    void GetModelWorldInstanceData(void* model_world, dmArray<uint8_t>** instance_data, dmArray<dmRender::RenderObject>** render_objects)
+    {
+        ModelWorld* world = (ModelWorld*) model_world;
+        *instance_data    = &world->m_InstanceBufferDataLocalSpace;
+        *render_objects   = &world->m_RenderObjects;
+    }
 }
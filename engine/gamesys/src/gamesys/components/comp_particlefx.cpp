@@ -77,11 +77,9 @@ namespace dmGameSystem
         dmIndexPool32                           m_PrototypeIndices;
         ParticleFXContext*                      m_Context;
         dmParticle::HParticleContext            m_ParticleContext;
-        dmRender::HBufferedRenderBuffer         m_VertexBuffer;
-        dmArray<uint8_t>                        m_VertexBufferData;
         uint32_t                                m_VerticesWritten;
+        uint32_t                                m_VertexBytesWritten;
         uint32_t                                m_EmitterCount;
-        uint32_t                                m_DispatchCount;
         float                                   m_DT;
         uint32_t                                m_WarnOutOfROs : 1;
     };
@@ -106,15 +104,7 @@ namespace dmGameSystem
         world->m_ConstantBuffers.SetSize(max_emitter_count);
         memset(world->m_ConstantBuffers.Begin(), 0, sizeof(dmRender::HNamedConstantBuffer)*max_emitter_count);
 
-        // position   : 3
-        // color      : 4
-        // texcoord0  : 2
-        // page_index : 1
-        const uint32_t default_vx_size = sizeof(float) * (3 + 4 + 2 + 1);
-        const uint32_t buffer_size     = ctx->m_MaxParticleCount * 6 * default_vx_size;
-        world->m_VertexBufferData.SetCapacity(buffer_size);
-        world->m_VertexBuffer = dmRender::NewBufferedRenderBuffer(ctx->m_RenderContext, dmRender::RENDER_BUFFER_TYPE_VERTEX_BUFFER);
-
+        // Vertex data is written straight into the render context frame ring, see RenderBatch
         world->m_WarnOutOfROs = 0;
         world->m_EmitterCount = 0;
 
@@ -124,7 +114,6 @@ namespace dmGameSystem
 
     dmGameObject::CreateResult CompParticleFXDeleteWorld(const dmGameObject::ComponentDeleteWorldParams& params)
     {
-        ParticleFXContext* ctx = (ParticleFXContext*)params.m_Context;
         ParticleFXWorld* pfx_world = (ParticleFXWorld*)params.m_World;
         for (uint32_t i = 0; i < pfx_world->m_Components.Size(); ++i)
         {
@@ -142,7 +131,6 @@ namespace dmGameSystem
         }
 
         dmParticle::DestroyContext(pfx_world->m_ParticleContext);
-        dmRender::DeleteBufferedRenderBuffer(ctx->m_RenderContext, pfx_world->m_VertexBuffer);
 
         delete pfx_world;
         return dmGameObject::CREATE_RESULT_OK;
@@ -204,8 +192,6 @@ namespace dmGameSystem
     {
         ParticleFXWorld* w   = (ParticleFXWorld*)params.m_World;
         w->m_DT              = params.m_UpdateContext->m_DT;
-        w->m_VerticesWritten = 0;
-        w->m_DispatchCount   = 0;
 
         dmArray<ParticleFXComponent>& components = w->m_Components;
         if (components.Empty())
@@ -257,9 +243,6 @@ namespace dmGameSystem
             }
         }
 
-        dmRender::TrimBuffer(ctx->m_RenderContext, w->m_VertexBuffer);
-        dmRender::RewindBuffer(ctx->m_RenderContext, w->m_VertexBuffer);
-
         return dmGameObject::UPDATE_RESULT_OK;
     }
 
@@ -288,28 +271,39 @@ namespace dmGameSystem
         uint32_t vx_stride = dmGraphics::GetVertexDeclarationStride(vx_decl);
         uint32_t max_size = pfx_context->m_MaxParticleCount * 6 * vx_stride;
 
-        if (pfx_world->m_VertexBufferData.Capacity() < max_size)
+        uint32_t batch_size = 0;
+        for (uint32_t *i = begin; i != end; ++i)
         {
-            pfx_world->m_VertexBufferData.SetCapacity(max_size);
+            const dmParticle::EmitterRenderData* emitter_render_data = (dmParticle::EmitterRenderData*) buf[*i].m_UserData;
+            if (emitter_render_data->m_Instance == dmParticle::INVALID_INSTANCE)
+                continue;
+            batch_size += dmParticle::GetEmitterVertexCount(particle_context, emitter_render_data->m_Instance, emitter_render_data->m_EmitterIndex) * vx_stride;
         }
 
-        dmArray<uint8_t> &vertex_buffer = pfx_world->m_VertexBufferData;
-        uint8_t* vb_begin = vertex_buffer.End();
+        if (batch_size == 0)
+        {
+            return;
+        }
 
-        // We need to pad the buffer if the vertex stride doesn't start at an even byte offset from the start
-        const uint32_t vb_buffer_offset = vertex_buffer.Size();
-        uint32_t vertex_offset = vb_buffer_offset / vx_stride;
+        // The particle limit applies to all batches in a dispatch, as it did when each world had a buffer of its own.
+        // A batch that doesn't fit in what is left is reported by GenerateVertexData below.
+        if (pfx_world->m_VertexBytesWritten >= max_size)
+        {
+            dmLogWarning("Maximum number of particles (%d) exceeded, particles will not be rendered. Change \"%s\" in the config file.",
+                pfx_context->m_MaxParticleCount, dmParticle::MAX_PARTICLE_COUNT_KEY);
+            return;
+        }
+        batch_size = dmMath::Min(batch_size, max_size - pfx_world->m_VertexBytesWritten);
 
-        if (vb_buffer_offset % vx_stride != 0)
+        // The frame ring pads the allocation so that it starts at a whole vertex
+        dmRender::FrameRingAllocation allocation;
+        if (dmRender::ReserveFrameRing(render_context, dmRender::RENDER_BUFFER_TYPE_VERTEX_BUFFER, batch_size, vx_stride, &allocation) != dmRender::RESULT_OK)
         {
-            vb_begin += vx_stride - vb_buffer_offset % vx_stride;
-            vertex_offset++;
-            pfx_world->m_VerticesWritten++;
+            return;
         }
 
-        uint32_t vb_size_init = vb_begin - vertex_buffer.Begin();
-        uint32_t vb_size      = vb_size_init;
-        uint32_t vb_max_size  = pfx_world->m_VertexBufferData.Capacity();
+        uint32_t vertex_offset = allocation.m_Offset / vx_stride;
+        uint32_t vb_size       = 0;
 
         dmGraphics::VertexAttributeInfos emitter_attribute_info = {};
         dmGraphics::VertexAttributeInfos material_attribute_info;
@@ -328,7 +322,7 @@ namespace dmGameSystem
 
             dmParticle::GenerateVertexDataResult res = dmParticle::GenerateVertexData(particle_context,
                 pfx_world->m_DT, emitter_render_data->m_Instance, emitter_render_data->m_EmitterIndex,
-                emitter_attribute_info, Vector4(1,1,1,1), (void*) vertex_buffer.Begin(), vb_max_size, &vb_size);
+                emitter_attribute_info, Vector4(1,1,1,1), allocation.m_Data, allocation.m_Size, &vb_size);
 
             if (res != dmParticle::GENERATE_VERTEX_DATA_OK)
             {
@@ -344,19 +338,14 @@ namespace dmGameSystem
             }
         }
 
-        uint32_t ro_vertex_count = (vb_size - vb_size_init) / material_attribute_info.m_VertexStride;
+        dmRender::CommitFrameRing(render_context, dmRender::RENDER_BUFFER_TYPE_VERTEX_BUFFER, vb_size);
 
-        vertex_buffer.SetSize(vb_size);
+        uint32_t ro_vertex_count = vb_size / material_attribute_info.m_VertexStride;
 
         // In place writing of render object
         uint32_t ro_index = pfx_world->m_RenderObjects.Size();
         pfx_world->m_RenderObjects.SetSize(ro_index+1);
 
-        if (dmRender::GetBufferIndex(render_context, pfx_world->m_VertexBuffer) < pfx_world->m_DispatchCount)
-        {
-            dmRender::AddRenderBuffer(render_context, pfx_world->m_VertexBuffer);
-        }
-
         TextureResource* texture_res = (TextureResource*) first->m_Texture;
         dmGraphics::HTexture texture = texture_res ? texture_res->m_Texture : 0;
 
@@ -367,7 +356,7 @@ namespace dmGameSystem
         ro.m_Textures[0]       = texture;
         ro.m_VertexStart       = vertex_offset;
         ro.m_VertexCount       = ro_vertex_count;
-        ro.m_VertexBuffer      = (dmGraphics::HVertexBuffer) dmRender::GetBuffer(render_context, pfx_world->m_VertexBuffer);
+        ro.m_VertexBuffer      = (dmGraphics::HVertexBuffer) allocation.m_Buffer;
         ro.m_PrimitiveType     = dmGraphics::PRIMITIVE_TRIANGLES;
         ro.m_SetBlendFactors   = 1;
 
@@ -384,7 +373,8 @@ namespace dmGameSystem
 
         dmRender::AddToRender(render_context, &ro);
 
-        pfx_world->m_VerticesWritten += ro_vertex_count;
+        pfx_world->m_VerticesWritten    += ro_vertex_count;
+        pfx_world->m_VertexBytesWritten += vb_size;
     }
 
     static void RenderListDispatch(dmRender::RenderListDispatchParams const &params)
@@ -393,20 +383,17 @@ namespace dmGameSystem
         switch(params.m_Operation)
         {
             case dmRender::RENDER_LIST_OPERATION_BEGIN:
-                pfx_world->m_VertexBufferData.SetSize(0);
+                pfx_world->m_VerticesWritten    = 0;
+                pfx_world->m_VertexBytesWritten = 0;
                 pfx_world->m_RenderObjects.SetSize(0);
                 break;
             case dmRender::RENDER_LIST_OPERATION_BATCH:
                 RenderBatch(pfx_world, params.m_Context, params.m_Buf, params.m_Begin, params.m_End);
                 break;
             case dmRender::RENDER_LIST_OPERATION_END:
-                if (pfx_world->m_VertexBufferData.Size() > 0)
-                {
-                    dmRender::SetBufferData(params.m_Context, pfx_world->m_VertexBuffer, pfx_world->m_VertexBufferData.Size(), pfx_world->m_VertexBufferData.Begin(), dmGraphics::BUFFER_USAGE_STREAM_DRAW);
-                    DM_PROPERTY_ADD_U32(rmtp_ParticleVertexCount, pfx_world->m_VerticesWritten);
-                    DM_PROPERTY_ADD_U32(rmtp_ParticleVertexSize, pfx_world->m_VertexBufferData.Size());
-                    pfx_world->m_DispatchCount++;
-                }
+                // The vertex data is uploaded by the render context once all dispatches have ended
+                DM_PROPERTY_ADD_U32(rmtp_ParticleVertexCount, pfx_world->m_VerticesWritten);
+                DM_PROPERTY_ADD_U32(rmtp_ParticleVertexSize, pfx_world->m_VertexBytesWritten);
                 break;
             default:break;
         }
@@ -715,10 +702,4 @@ namespace dmGameSystem
             return dmParticle::FETCH_ANIMATION_NOT_FOUND;
         }
     }
-
-    void GetParticleFXWorldRenderBuffers(void* pfx_world, dmRender::HBufferedRenderBuffer* vx_buffer)
-    {
-        ParticleFXWorld* world = (ParticleFXWorld*) pfx_world;
-        *vx_buffer = world->m_VertexBuffer;
-    }
 }
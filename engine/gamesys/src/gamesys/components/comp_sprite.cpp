@@ -35,6 +35,7 @@
 #include "../resources/res_sprite.h"
 #include "../gamesys.h"
 #include "../gamesys_private.h"
+#include "../texture_streaming.h"
 #include "comp_private.h"
 
 #include <gamesys/sprite_ddf.h>
@@ -1402,6 +1403,45 @@ namespace dmGameSystem
         *ib_where = indices;
     }
 
+    // The mipmap level sampled when drawing the sprite, from the size of its frame on screen
+    static uint8_t GetSampledMipMap(const SpriteComponent* component, const Matrix4& view_proj, float viewport_width, float viewport_height)
+    {
+        const Matrix4& world = component->m_World;
+        Point3 position      = Point3(world.getCol3().getXYZ());
+
+        // The world matrix is scaled by the sprite size
+        float width  = GetProjectedSize(view_proj, position, world.getCol0().getXYZ(), viewport_width, viewport_height);
+        float height = GetProjectedSize(view_proj, position, world.getCol1().getXYZ(), viewport_width, viewport_height);
+
+        // The level is picked from the axis with the most texels per pixel
+        return dmMath::Max(GetSampledMipMap(component->m_Size.getX(), width), GetSampledMipMap(component->m_Size.getY(), height));
+    }
+
+    // Requests the mipmap levels sampled when drawing the sprites of the batch
+    static void RequestTextureMipMaps(SpriteWorld* sprite_world, dmRender::HRenderContext render_context, const dmRender::RenderObject& ro, uint32_t num_textures,
+        dmRender::RenderListEntry* buf, uint32_t* begin, uint32_t* end)
+    {
+        DM_PROFILE(__FUNCTION__);
+
+        dmGraphics::HContext graphics_context = dmRender::GetGraphicsContext(render_context);
+        const Matrix4& view_proj              = dmRender::GetViewProjectionMatrix(render_context);
+        float viewport_width                  = (float) dmGraphics::GetWidth(graphics_context);
+        float viewport_height                 = (float) dmGraphics::GetHeight(graphics_context);
+        const dmArray<SpriteComponent>& components = sprite_world->m_Components.GetRawObjects();
+
+        uint8_t mipmap = 0xFF;
+        for (uint32_t* i = begin; i != end; ++i)
+        {
+            const SpriteComponent* component = &components[(uint32_t) buf[*i].m_UserData];
+            mipmap = dmMath::Min(mipmap, GetSampledMipMap(component, view_proj, viewport_width, viewport_height));
+        }
+
+        for (uint32_t i = 0; i < num_textures; ++i)
+        {
+            RequestTextureMipMap(ro.m_Textures[i], mipmap);
+        }
+    }
+
     static void RenderBatch(SpriteWorld* sprite_world, dmRender::HRenderContext render_context, dmRender::RenderListEntry *buf, uint32_t* begin, uint32_t* end)
     {
         DM_PROFILE("SpriteRenderBatch");
@@ -1461,6 +1501,11 @@ namespace dmGameSystem
             ro.m_Textures[i] = GetMaterialTexture(first, i);
         }
 
+        if (IsTextureStreamingEnabled())
+        {
+            RequestTextureMipMaps(sprite_world, render_context, ro, resource->m_NumTextures, buf, begin, end);
+        }
+
         ro.m_PrimitiveType = dmGraphics::PRIMITIVE_TRIANGLES;
         ro.m_IndexType = sprite_world->m_Is16BitIndex ? dmGraphics::TYPE_UNSIGNED_SHORT : dmGraphics::TYPE_UNSIGNED_INT;
 
@@ -1839,6 +1884,47 @@ namespace dmGameSystem
         }
     }
 
+    // Everything the vertex data of a sprite is written from, that isn't part of its render list entry
+    static void RenderListContentHash(void* user_data, const dmRender::RenderListEntry& entry, HashState64* state)
+    {
+        SpriteWorld* sprite_world = (SpriteWorld*) user_data;
+        const SpriteComponent& component = sprite_world->m_Components.GetRawObjects()[entry.m_UserData];
+
+        float size[] = { component.m_Size.getX(), component.m_Size.getY(),
+                         component.m_Slice9.getX(), component.m_Slice9.getY(), component.m_Slice9.getZ(), component.m_Slice9.getW() };
+        uint32_t bits[] = { component.m_AnimationID, component.m_CurrentAnimationFrame,
+                            component.m_FlipHorizontal, component.m_FlipVertical, component.m_UseSlice9 };
+        dmHashUpdateBuffer64(state, &component.m_World, sizeof(component.m_World));
+        dmHashUpdateBuffer64(state, size, sizeof(size));
+        dmHashUpdateBuffer64(state, bits, sizeof(bits));
+        HashMaterialAttributes(sprite_world->m_DynamicVertexAttributePool, component.m_DynamicVertexAttributeIndex, state);
+    }
+
+    // Recorded sprites aren't batched, but their textures are still drawn
+    static void RenderListReplay(dmRender::HRenderContext render_context, void* user_data, dmRender::RenderListEntry* buf, uint32_t* begin, uint32_t* end)
+    {
+        if (!IsTextureStreamingEnabled())
+            return;
+
+        SpriteWorld* sprite_world = (SpriteWorld*) user_data;
+        const dmArray<SpriteComponent>& components = sprite_world->m_Components.GetRawObjects();
+
+        dmGraphics::HContext graphics_context = dmRender::GetGraphicsContext(render_context);
+        const Matrix4& view_proj              = dmRender::GetViewProjectionMatrix(render_context);
+        float viewport_width                  = (float) dmGraphics::GetWidth(graphics_context);
+        float viewport_height                 = (float) dmGraphics::GetHeight(graphics_context);
+
+        for (uint32_t* i = begin; i != end; ++i)
+        {
+            const SpriteComponent* component = &components[(uint32_t) buf[*i].m_UserData];
+            uint8_t mipmap = GetSampledMipMap(component, view_proj, viewport_width, viewport_height);
+            for (uint32_t j = 0; j < component->m_Resource->m_NumTextures; ++j)
+            {
+                RequestTextureMipMap(GetMaterialTexture(component, j), mipmap);
+            }
+        }
+    }
+
     static void RenderListDispatch(dmRender::RenderListDispatchParams const &params)
     {
         SpriteWorld* world = (SpriteWorld*) params.m_UserData;
@@ -1904,6 +1990,8 @@ namespace dmGameSystem
         // Submit all sprites as entries in the render list for sorting.
         dmRender::RenderListEntry* render_list = dmRender::RenderListAlloc(render_context, sprite_count);
         dmRender::HRenderListDispatch sprite_dispatch = dmRender::RenderListMakeDispatch(render_context, &RenderListDispatch, &RenderListFrustumCulling, sprite_world);
+        dmRender::RenderListSetContentHashFn(render_context, sprite_dispatch, &RenderListContentHash);
+        dmRender::RenderListSetReplayFn(render_context, sprite_dispatch, &RenderListReplay);
         dmRender::RenderListEntry* write_ptr = render_list;
 
         for (uint32_t i = 0; i < sprite_count; ++i)
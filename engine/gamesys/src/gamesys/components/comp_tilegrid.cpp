@@ -756,6 +756,33 @@ namespace dmGameSystem
         dmRender::AddToRender(render_context, &ro);
     }
 
+    // Everything the vertex data of a region is written from, that isn't part of its render list entry
+    static void RenderListContentHash(void* user_data, const dmRender::RenderListEntry& entry, HashState64* state)
+    {
+        TileGridWorld* world = (TileGridWorld*) user_data;
+
+        uint32_t index, layer, region_x, region_y;
+        DecodeGridAndLayer(entry.m_UserData, index, layer, region_x, region_y);
+
+        const TileGridComponent* component = world->m_Components[index];
+        const TileGridResource* resource = component->m_Resource;
+        uint32_t column_count = resource->m_ColumnCount;
+        uint32_t row_count = resource->m_RowCount;
+
+        uint32_t min_x = region_x * TILEGRID_REGION_SIZE;
+        uint32_t min_y = region_y * TILEGRID_REGION_SIZE;
+        uint32_t max_x = dmMath::Min(min_x + TILEGRID_REGION_SIZE, column_count);
+        uint32_t max_y = dmMath::Min(min_y + TILEGRID_REGION_SIZE, row_count);
+
+        dmHashUpdateBuffer64(state, &component->m_World, sizeof(component->m_World));
+        for (uint32_t y = min_y; y < max_y; ++y)
+        {
+            uint32_t cell = CalculateCellIndex(layer, min_x, y, column_count, row_count);
+            dmHashUpdateBuffer64(state, &component->m_Cells[cell], (max_x - min_x) * sizeof(component->m_Cells[0]));
+            dmHashUpdateBuffer64(state, &component->m_CellFlags[cell], (max_x - min_x) * sizeof(component->m_CellFlags[0]));
+        }
+    }
+
     static void RenderListDispatch(dmRender::RenderListDispatchParams const &params)
     {
         TileGridWorld* world = (TileGridWorld*) params.m_UserData;
@@ -833,6 +860,7 @@ namespace dmGameSystem
         dmRender::HRenderContext render_context = context->m_RenderContext;
         dmRender::RenderListEntry* render_list = dmRender::RenderListAlloc(render_context, num_render_entries);
         dmRender::HRenderListDispatch dispatch = dmRender::RenderListMakeDispatch(render_context, &RenderListDispatch, &RenderListFrustumCulling, world);
+        dmRender::RenderListSetContentHashFn(render_context, dispatch, &RenderListContentHash);
         dmRender::RenderListEntry* write_ptr = render_list;
 
         for (uint32_t i = 0; i < n; ++i)
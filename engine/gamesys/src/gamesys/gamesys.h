@@ -192,6 +192,25 @@ namespace dmGameSystem
         uint32_t m_MaxCollectionFactoryCount;
     };
 
+    struct TextureStreamingParams
+    {
+        TextureStreamingParams();
+
+        dmResource::HFactory    m_Factory;
+        dmGraphics::HContext    m_GraphicsContext;
+        dmJobThread::HContext   m_JobThread;
+        uint32_t                m_Budget;       // Max size (bytes) of the resident mipmap levels of all streamed textures
+        uint16_t                m_InitialSize;  // Textures are created with a base level of at most this size
+    };
+
+    /*#
+     * Enables streaming of the mipmap levels of 2D textures. Textures are created with only their smallest levels,
+     * the levels needed by the sprites and models on screen are then loaded on the job thread and uploaded by UpdateTextureStreaming.
+     */
+    void InitializeTextureStreaming(const TextureStreamingParams& params);
+    void FinalizeTextureStreaming();
+    void UpdateTextureStreaming();
+
     bool InitializeScriptLibs(const ScriptLibContext& context);
     void FinalizeScriptLibs(const ScriptLibContext& context);
     void UpdateScriptLibs(const ScriptLibContext& context);
@@ -413,6 +413,17 @@ namespace dmGameSystem
         pool.Free(dynamic_attribute_index, true);
     }
 
+    void HashMaterialAttributes(DynamicAttributePool& pool, uint32_t dynamic_attribute_index, HashState64* state)
+    {
+        if (dynamic_attribute_index == INVALID_DYNAMIC_ATTRIBUTE_INDEX)
+        {
+            return;
+        }
+
+        const DynamicAttributeInfo& dynamic_info = pool.Get(dynamic_attribute_index);
+        dmHashUpdateBuffer64(state, dynamic_info.m_Infos, dynamic_info.m_NumInfos * sizeof(DynamicAttributeInfo::Info));
+    }
+
     dmGameObject::PropertyResult ClearMaterialAttribute(
         DynamicAttributePool& pool,
         uint32_t              dynamic_attribute_index,
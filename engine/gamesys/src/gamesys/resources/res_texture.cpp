@@ -14,6 +14,7 @@
 
 #include "res_texture.h"
 #include "gamesys_private.h"
+#include "../texture_streaming.h"
 
 #include <dmsdk/gamesys/resources/res_texture.h>
 
@@ -27,11 +28,29 @@ namespace dmGameSystem
 {
     static const uint32_t MAX_MIPMAP_COUNT = 15; // 2^14 => 16384 (+1 for base mipmap)
 
+    // Max time spent uploading mipmap levels per create/post-create call. At least one level is uploaded
+    // per call, the rest is picked up by the next post-create call, which the preloader schedules within its own time limit.
+    static const uint64_t TEXTURE_UPLOAD_TIME_BUDGET = 2000; // us
+
     struct ImageDesc
     {
-        dmGraphics::TextureImage* m_DDFImage;
-        uint8_t*                  m_DecompressedData[MAX_MIPMAP_COUNT];
-        uint32_t                  m_DecompressedDataSize[MAX_MIPMAP_COUNT];
+        dmGraphics::TextureImage*        m_DDFImage;
+        uint8_t*                         m_DecompressedData[MAX_MIPMAP_COUNT];
+        uint32_t                         m_DecompressedDataSize[MAX_MIPMAP_COUNT];
+
+        // Set if the image was transcoded in the preload step
+        dmGraphics::TextureImage::Image* m_TranscodedImage;
+        dmGraphics::TextureFormat        m_TranscodedFormat;
+        uint32_t                         m_TranscodedMipCount;
+
+        // Mipmap levels left to upload. Streamed textures are created from m_UploadBaseMip, which becomes level 0.
+        dmGraphics::TextureParams        m_UploadParams;
+        dmGraphics::TextureImage::Image* m_UploadImage;
+        uint32_t                         m_UploadMipCount;
+        uint32_t                         m_UploadNextMip;
+        uint32_t                         m_UploadBaseMip;
+
+        uint8_t                          m_TranscodeAttempted : 1;
     };
 
 #define CASE_TT(_X, _T) case dmGraphics::TextureImage::_X: return dmGraphics::TEXTURE_ ## _T
@@ -109,8 +128,47 @@ namespace dmGameSystem
         dmGraphics::SetTextureAsync(texture, params, 0, (void*) 0);
     }
 
+    // Uploads the pending mipmap levels, from the base level and down. Returns false if there are levels left.
+    static bool UploadMipMaps(dmGraphics::HTexture texture, ImageDesc* image_desc, uint64_t time_budget)
+    {
+        DM_PROFILE(__FUNCTION__);
+        uint64_t start                         = dmTime::GetTime();
+        uint32_t num_uploaded                  = 0;
+        dmGraphics::TextureImage::Image* image = image_desc->m_UploadImage;
+        dmGraphics::TextureParams params       = image_desc->m_UploadParams;
+
+        while (image_desc->m_UploadNextMip < image_desc->m_UploadMipCount)
+        {
+            if (time_budget > 0 && num_uploaded > 0 && (dmTime::GetTime() - start) >= time_budget)
+            {
+                return false;
+            }
+
+            uint32_t i = image_desc->m_UploadNextMip + image_desc->m_UploadBaseMip;
+            if (image_desc->m_DecompressedData[i] == 0)
+            {
+                params.m_Data     = &image->m_Data[image->m_MipMapOffset[i]];
+                params.m_DataSize = image->m_MipMapSize[i];
+            }
+            else
+            {
+                params.m_Data     = image_desc->m_DecompressedData[i];
+                params.m_DataSize = image_desc->m_DecompressedDataSize[i];
+            }
+
+            params.m_MipMap = image_desc->m_UploadNextMip;
+            params.m_Width  = (uint16_t) dmMath::Max((uint32_t) image_desc->m_UploadParams.m_Width >> i, 1U);
+            params.m_Height = (uint16_t) dmMath::Max((uint32_t) image_desc->m_UploadParams.m_Height >> i, 1U);
+            dmGraphics::SetTextureAsync(texture, params, 0, 0);
+
+            image_desc->m_UploadNextMip++;
+            num_uploaded++;
+        }
+        return true;
+    }
+
     static dmResource::Result AcquireResources(const char* path, dmGraphics::HContext context, ImageDesc* image_desc,
-        ResTextureUploadParams upload_params, dmGraphics::HTexture texture, dmGraphics::HTexture* texture_out)
+        ResTextureUploadParams upload_params, dmGraphics::HTexture texture, uint64_t upload_time_budget, dmGraphics::HTexture* texture_out)
     {
         DM_PROFILE_DYN(path, 0);
 
@@ -123,7 +181,17 @@ namespace dmGameSystem
             uint32_t num_mips                         = image->m_MipMapOffset.m_Count;
             bool specific_mip_requested               = upload_params.m_UploadSpecificMipmap;
 
-            if (dmGraphics::IsFormatTranscoded(image->m_CompressionType))
+            if (dmGraphics::IsFormatTranscoded(image->m_CompressionType) && image_desc->m_TranscodeAttempted)
+            {
+                // Already transcoded in the preload step
+                if (image != image_desc->m_TranscodedImage)
+                {
+                    continue;
+                }
+                output_format = image_desc->m_TranscodedFormat;
+                num_mips      = image_desc->m_TranscodedMipCount;
+            }
+            else if (dmGraphics::IsFormatTranscoded(image->m_CompressionType))
             {
                 num_mips = MAX_MIPMAP_COUNT;
                 output_format = dmGraphics::GetSupportedCompressionFormat(context, output_format, image->m_Width, image->m_Height);
@@ -144,6 +212,14 @@ namespace dmGameSystem
             dmGraphics::TextureParams params;
             dmGraphics::GetDefaultTextureFilters(context, params.m_MinFilter, params.m_MagFilter);
 
+            uint32_t max_size   = dmGraphics::GetMaxTextureSize(context);
+            uint8_t base_mipmap = 0;
+            if (!texture && !specific_mip_requested && image->m_Width <= max_size && image->m_Height <= max_size)
+            {
+                base_mipmap = GetTextureStreamingBaseMipMap(TextureImageToTextureType(image_desc->m_DDFImage->m_Type),
+                    image->m_Width, image->m_Height, image_desc->m_DDFImage->m_Count, num_mips);
+            }
+
             params.m_Format    = output_format;
             params.m_Width     = image->m_Width;
             params.m_Height    = image->m_Height;
@@ -158,12 +234,12 @@ namespace dmGameSystem
                 dmGraphics::TextureCreationParams creation_params;
 
                 creation_params.m_Type           = TextureImageToTextureType(image_desc->m_DDFImage->m_Type);
-                creation_params.m_Width          = image->m_Width;
-                creation_params.m_Height         = image->m_Height;
+                creation_params.m_Width          = (uint16_t) dmMath::Max((uint32_t) image->m_Width >> base_mipmap, 1U);
+                creation_params.m_Height         = (uint16_t) dmMath::Max((uint32_t) image->m_Height >> base_mipmap, 1U);
                 creation_params.m_Depth          = image_desc->m_DDFImage->m_Count;
                 creation_params.m_OriginalWidth  = image->m_OriginalWidth;
                 creation_params.m_OriginalHeight = image->m_OriginalHeight;
-                creation_params.m_MipMapCount    = num_mips;
+                creation_params.m_MipMapCount    = num_mips - base_mipmap;
 
                 if (image_desc->m_DDFImage->m_UsageFlags != 0)
                 {
@@ -204,7 +280,6 @@ namespace dmGameSystem
                 }
             }
 
-            uint32_t max_size = dmGraphics::GetMaxTextureSize(context);
             if (params.m_Width > max_size || params.m_Height > max_size) {
                 // dmGraphics::SetTextureAsync will fail if texture is too big; fall back to 1x1 texture.
                 dmLogError("Texture size %ux%u exceeds maximum supported texture size (%ux%u). Using blank texture.", params.m_Width, params.m_Height, max_size, max_size);
@@ -234,32 +309,16 @@ namespace dmGameSystem
             }
             else
             {
-                for (uint32_t i = 0; i < num_mips; ++i)
+                image_desc->m_UploadParams   = params;
+                image_desc->m_UploadImage    = image;
+                image_desc->m_UploadMipCount = num_mips - base_mipmap;
+                image_desc->m_UploadNextMip  = 0;
+                image_desc->m_UploadBaseMip  = base_mipmap;
+                UploadMipMaps(texture, image_desc, upload_time_budget);
+
+                if (base_mipmap > 0)
                 {
-                    if (image_desc->m_DecompressedData[i] == 0)
-                    {
-                        params.m_Data     = &image->m_Data[image->m_MipMapOffset[i]];
-                        params.m_DataSize = image->m_MipMapSize[i];
-                    }
-                    else
-                    {
-                        params.m_Data     = image_desc->m_DecompressedData[i];
-                        params.m_DataSize = image_desc->m_DecompressedDataSize[i];
-                    }
-
-                    params.m_MipMap   = i;
-                    dmGraphics::SetTextureAsync(texture, params, 0, 0);
-
-                    params.m_Width >>= 1;
-                    params.m_Height >>= 1;
-                    if (params.m_Width == 0)
-                    {
-                        params.m_Width = 1;
-                    }
-                    if (params.m_Height == 0)
-                    {
-                        params.m_Height = 1;
-                    }
+                    AddStreamingTexture(texture, path, i, image, image_desc->m_DecompressedData, image_desc->m_DecompressedDataSize, params, num_mips, base_mipmap);
                 }
             }
             break;
@@ -298,6 +357,41 @@ namespace dmGameSystem
         return result;
     }
 
+    // Transcodes the first usable alternative of the image. This runs in the preload step, i.e on the
+    // resource loader thread when loading is threaded, so that only the upload is left for the main thread.
+    static void TranscodeImage(const char* path, dmGraphics::HContext context, ImageDesc* image_desc)
+    {
+        DM_PROFILE_DYN(path, 0);
+        image_desc->m_TranscodeAttempted = 1;
+
+        for (uint32_t i = 0; i < image_desc->m_DDFImage->m_Alternatives.m_Count; ++i)
+        {
+            dmGraphics::TextureImage::Image* image    = &image_desc->m_DDFImage->m_Alternatives[i];
+            dmGraphics::TextureFormat original_format = TextureImageToTextureFormat(image->m_Format);
+
+            if (!dmGraphics::IsFormatTranscoded(image->m_CompressionType))
+            {
+                if (dmGraphics::IsTextureFormatSupported(context, original_format))
+                {
+                    // This alternative is used as is
+                    return;
+                }
+                continue;
+            }
+
+            uint32_t num_mips = MAX_MIPMAP_COUNT;
+            dmGraphics::TextureFormat output_format = dmGraphics::GetSupportedCompressionFormat(context, original_format, image->m_Width, image->m_Height);
+            if (dmGraphics::Transcode(path, image, image_desc->m_DDFImage->m_Count, output_format, image_desc->m_DecompressedData, image_desc->m_DecompressedDataSize, &num_mips))
+            {
+                image_desc->m_TranscodedImage    = image;
+                image_desc->m_TranscodedFormat   = output_format;
+                image_desc->m_TranscodedMipCount = num_mips;
+                return;
+            }
+            dmLogError("Failed to transcode %s", path);
+        }
+    }
+
     static ImageDesc* CreateImage(dmGraphics::HContext context, dmGraphics::TextureImage* texture_image)
     {
         ImageDesc* image_desc = new ImageDesc;
@@ -330,21 +424,28 @@ namespace dmGameSystem
         }
 
         ImageDesc* image_desc = CreateImage((dmGraphics::HContext) params->m_Context, texture_image);
+        TranscodeImage(params->m_Filename, (dmGraphics::HContext) params->m_Context, image_desc);
         *params->m_PreloadData = image_desc;
         return dmResource::RESULT_OK;
     }
 
     dmResource::Result ResTexturePostCreate(const dmResource::ResourcePostCreateParams* params)
     {
-        // Poll state of texture async texture processing and return state. RESULT_PENDING indicates we need to poll again.
+        // Upload the remaining mipmap levels and poll state of texture async texture processing and return state.
+        // RESULT_PENDING indicates we need to poll again.
         TextureResource* texture_res = (TextureResource*) dmResource::GetResource(params->m_Resource);
+        ImageDesc* image_desc        = (ImageDesc*) params->m_PreloadData;
+
+        if (!UploadMipMaps(texture_res->m_Texture, image_desc, TEXTURE_UPLOAD_TIME_BUDGET))
+        {
+            return dmResource::RESULT_PENDING;
+        }
 
         if(!SynchronizeTexture(texture_res->m_Texture, false))
         {
             return dmResource::RESULT_PENDING;
         }
 
-        ImageDesc* image_desc = (ImageDesc*) params->m_PreloadData;
         dmDDF::FreeMessage(image_desc->m_DDFImage);
         DestroyImage(image_desc);
         dmResource::SetResourceSize(params->m_Resource, dmGraphics::GetTextureResourceSize(texture_res->m_Texture));
@@ -361,7 +462,7 @@ namespace dmGameSystem
 
         if (image_desc->m_DDFImage->m_Alternatives.m_Count > 0)
         {
-            dmResource::Result r = AcquireResources(params->m_Filename, graphics_context, image_desc, upload_params, 0, &texture);
+            dmResource::Result r = AcquireResources(params->m_Filename, graphics_context, image_desc, upload_params, 0, TEXTURE_UPLOAD_TIME_BUDGET, &texture);
             if (r == dmResource::RESULT_OK)
             {
                 TextureResource* texture_res = new TextureResource();
@@ -386,6 +487,7 @@ namespace dmGameSystem
     dmResource::Result ResTextureDestroy(const dmResource::ResourceDestroyParams* params)
     {
         TextureResource* texture_res = (TextureResource*) dmResource::GetResource(params->m_Resource);
+        RemoveStreamingTexture(texture_res->m_Texture, false);
         dmGraphics::DeleteTexture(texture_res->m_Texture);
         delete texture_res;
         return dmResource::RESULT_OK;
@@ -428,7 +530,10 @@ namespace dmGameSystem
 
         // Set up the new texture (version), wait for it to finish before issuing new requests
         SynchronizeTexture(texture, true);
-        dmResource::Result r = AcquireResources(params->m_Filename, graphics_context, image_desc, upload_params, texture, &texture);
+
+        // A recreated texture isn't streamed. Partial updates need all levels to be resident first.
+        RemoveStreamingTexture(texture, upload_params.m_SubUpdate);
+        dmResource::Result r = AcquireResources(params->m_Filename, graphics_context, image_desc, upload_params, texture, 0, &texture);
 
         // Texture might have changed
         texture_res->m_Texture = texture;
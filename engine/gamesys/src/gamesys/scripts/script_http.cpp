@@ -301,6 +301,7 @@ namespace dmGameSystem
             {
                 params.m_ThreadCount = dmConfigFile::GetInt(config_file, "network.http_thread_count", params.m_ThreadCount);
                 params.m_UseHttpCache = dmConfigFile::GetInt(config_file, "network.http_cache_enabled", params.m_UseHttpCache);
+                params.m_Pipelining = dmConfigFile::GetInt(config_file, "network.http_pipelining", params.m_Pipelining);
             }
 
         #if defined(DM_NO_HTTP_CACHE)
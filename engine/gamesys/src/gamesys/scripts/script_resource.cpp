@@ -31,6 +31,7 @@
 
 #include "../gamesys.h"
 #include "../gamesys_private.h"
+#include "../texture_streaming.h"
 #include "../resources/res_buffer.h"
 #include "../resources/res_font.h"
 #include "../resources/res_texture.h"
@@ -1427,8 +1428,9 @@ static int SetTexture(lua_State* L)
 
 static void PushTextureInfo(lua_State* L, dmGraphics::HTexture texture_handle)
 {
-    uint32_t texture_width               = dmGraphics::GetTextureWidth(texture_handle);
-    uint32_t texture_height              = dmGraphics::GetTextureHeight(texture_handle);
+    // Streamed textures might not have all levels resident, but report their full size
+    uint16_t texture_width, texture_height;
+    GetTextureFullSize(texture_handle, &texture_width, &texture_height);
     uint32_t texture_depth               = dmGraphics::GetTextureDepth(texture_handle);
     uint32_t texture_mipmaps             = dmGraphics::GetTextureMipmapCount(texture_handle);
     dmGraphics::TextureType texture_type = dmGraphics::GetTextureType(texture_handle);
@@ -1855,8 +1857,10 @@ static void MakeTextureSetFromLua(lua_State* L, dmhash_t texture_path_hash, dmGr
     texture_set_ddf->m_Texture     = 0;
     texture_set_ddf->m_TextureHash = texture_path_hash;
 
-    float tex_width            = dmGraphics::GetTextureWidth(texture);
-    float tex_height           = dmGraphics::GetTextureHeight(texture);
+    uint16_t full_width, full_height;
+    GetTextureFullSize(texture, &full_width, &full_height);
+    float tex_width            = full_width;
+    float tex_height           = full_height;
     uint32_t frame_index_count = 0;
 
     texture_set_ddf->m_Geometries.m_Data  = new dmGameSystemDDF::SpriteGeometry[num_geometries];
@@ -2466,8 +2470,10 @@ static int GetAtlas(lua_State* L)
     dmGameSystemDDF::TextureSet* texture_set = texture_set_res->m_TextureSet;
     assert(texture_set);
 
-    float tex_width  = (float) dmGraphics::GetTextureWidth(texture_set_res->m_Texture->m_Texture);
-    float tex_height = (float) dmGraphics::GetTextureHeight(texture_set_res->m_Texture->m_Texture);
+    uint16_t full_width, full_height;
+    GetTextureFullSize(texture_set_res->m_Texture->m_Texture, &full_width, &full_height);
+    float tex_width  = (float) full_width;
+    float tex_height = (float) full_height;
 
     #define SET_LUA_TABLE_FIELD(set_fn, key, val) \
         set_fn(L, val); \
@@ -0,0 +1,19 @@
+components {
+  id: "model_0"
+  component: "/misc/dispatch_buffers_instancing_test/model_material_local_instance.model"
+  position {
+    x: 0.0
+    y: 0.0
+    z: 0.0
+  }
+}
+
+components {
+  id: "model_1"
+  component: "/misc/dispatch_buffers_instancing_test/model_material_local_instance.model"
+  position {
+    x: 0.0
+    y: 0.0
+    z: -1.0
+  }
+}
@@ -0,0 +1,9 @@
+components {
+  id: "sprite_a"
+  component: "/misc/dispatch_buffers_test/sprite_material_a.sprite"
+  position {
+    x: 0.0
+    y: 0.0
+    z: 0.0
+  }
+}
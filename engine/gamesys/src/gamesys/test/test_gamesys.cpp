@@ -14,6 +14,7 @@
 
 #include "test_gamesys.h"
 #include "../gamesys_private.h"
+#include "../texture_streaming.h"
 
 #include "../../../../graphics/src/graphics_private.h"
 #include "../../../../graphics/src/null/graphics_null_private.h"
@@ -29,6 +30,7 @@
 #include "gamesys/resources/res_textureset.h"
 
 #include <stdio.h>
+#include <float.h>
 
 #include <dlib/dstrings.h>
 #include <dlib/time.h>
@@ -70,7 +72,7 @@ namespace dmGameSystem
     extern void GetSpriteWorldRenderBuffers(void* world, dmRender::HBufferedRenderBuffer* vx_buffer, dmRender::HBufferedRenderBuffer* ix_buffer);
     extern void GetSpriteWorldDynamicAttributePool(void* sprite_world, DynamicAttributePool** pool_out);
     extern void GetModelWorldRenderBuffers(void* world, dmRender::HBufferedRenderBuffer** vx_buffers, uint32_t* vx_buffers_count);
-    extern void GetParticleFXWorldRenderBuffers(void* world, dmRender::HBufferedRenderBuffer* vx_buffer);
+    extern void GetModelWorldInstanceData(void* world, dmArray<uint8_t>** instance_data, dmArray<dmRender::RenderObject>** render_objects);
     extern void GetTileGridWorldRenderBuffers(void* world, dmRender::HBufferedRenderBuffer* vx_buffer);
 }
 
@@ -292,6 +294,219 @@ static bool UpdateAndWaitUntilDone(
     return tests_done;
 }
 
+TEST(TextureStreaming, SampledMipMap)
+{
+    // Drawn at full size, or magnified
+    ASSERT_EQ(0, dmGameSystem::GetSampledMipMap(256.0f, 256.0f));
+    ASSERT_EQ(0, dmGameSystem::GetSampledMipMap(256.0f, 512.0f));
+    ASSERT_EQ(0, dmGameSystem::GetSampledMipMap(256.0f, 200.0f));
+
+    ASSERT_EQ(1, dmGameSystem::GetSampledMipMap(256.0f, 128.0f));
+    ASSERT_EQ(1, dmGameSystem::GetSampledMipMap(256.0f, 100.0f));
+    ASSERT_EQ(2, dmGameSystem::GetSampledMipMap(256.0f, 64.0f));
+    ASSERT_EQ(8, dmGameSystem::GetSampledMipMap(256.0f, 1.0f));
+
+    // Not visible, no level is needed
+    ASSERT_EQ(0xFF, dmGameSystem::GetSampledMipMap(256.0f, 0.0f));
+}
+
+TEST(TextureStreaming, ProjectedSize)
+{
+    // One unit per pixel
+    Matrix4 ortho = Matrix4::orthographic(0.0f, 960.0f, 0.0f, 640.0f, -1.0f, 1.0f);
+    ASSERT_NEAR(100.0f, dmGameSystem::GetProjectedSize(ortho, Point3(480.0f, 320.0f, 0.0f), Vector3(100.0f, 0.0f, 0.0f), 960.0f, 640.0f), 0.01f);
+    ASSERT_NEAR(50.0f, dmGameSystem::GetProjectedSize(ortho, Point3(10.0f, 10.0f, 0.0f), Vector3(0.0f, 50.0f, 0.0f), 960.0f, 640.0f), 0.01f);
+
+    // Twice as far away is half the size
+    Matrix4 persp = Matrix4::perspective(1.5707964f, 1.0f, 0.1f, 100.0f); // 90 degrees fov
+    ASSERT_NEAR(50.0f, dmGameSystem::GetProjectedSize(persp, Point3(0.0f, 0.0f, -10.0f), Vector3(1.0f, 0.0f, 0.0f), 1000.0f, 1000.0f), 0.01f);
+    ASSERT_NEAR(25.0f, dmGameSystem::GetProjectedSize(persp, Point3(0.0f, 0.0f, -20.0f), Vector3(1.0f, 0.0f, 0.0f), 1000.0f, 1000.0f), 0.01f);
+
+    // Behind the camera
+    ASSERT_EQ(FLT_MAX, dmGameSystem::GetProjectedSize(persp, Point3(0.0f, 0.0f, 10.0f), Vector3(1.0f, 0.0f, 0.0f), 1000.0f, 1000.0f));
+}
+
+// A 64x64 rgba texture with a full mipmap chain, also written to disc for the streamer to load its levels from
+struct StreamingTestTexture
+{
+    static const uint32_t SIZE         = 64;
+    static const uint32_t MIPMAP_COUNT = 7;
+
+    dmGraphics::TextureImage::Image m_Image;
+    uint32_t                        m_Offsets[MIPMAP_COUNT];
+    uint32_t                        m_Sizes[MIPMAP_COUNT];
+    uint8_t*                        m_Data;
+    dmGraphics::TextureParams       m_Params;
+    dmGraphics::HTexture            m_Texture;
+};
+
+static void CreateStreamingTestTexture(dmGraphics::HContext context, const char* path, uint8_t base_mipmap, StreamingTestTexture* t)
+{
+    uint32_t data_size = 0;
+    for (uint32_t i = 0; i < StreamingTestTexture::MIPMAP_COUNT; ++i)
+    {
+        uint32_t size = StreamingTestTexture::SIZE >> i;
+        t->m_Offsets[i] = data_size;
+        t->m_Sizes[i]   = size * size * 4;
+        data_size += t->m_Sizes[i];
+    }
+    t->m_Data = new uint8_t[data_size];
+    memset(t->m_Data, 0xFF, data_size);
+
+    memset(&t->m_Image, 0, sizeof(t->m_Image));
+    t->m_Image.m_Width                = StreamingTestTexture::SIZE;
+    t->m_Image.m_Height               = StreamingTestTexture::SIZE;
+    t->m_Image.m_OriginalWidth        = StreamingTestTexture::SIZE;
+    t->m_Image.m_OriginalHeight       = StreamingTestTexture::SIZE;
+    t->m_Image.m_Format               = dmGraphics::TextureImage::TEXTURE_FORMAT_RGBA;
+    t->m_Image.m_MipMapOffset.m_Data  = t->m_Offsets;
+    t->m_Image.m_MipMapOffset.m_Count = StreamingTestTexture::MIPMAP_COUNT;
+    t->m_Image.m_MipMapSize.m_Data    = t->m_Sizes;
+    t->m_Image.m_MipMapSize.m_Count   = StreamingTestTexture::MIPMAP_COUNT;
+    t->m_Image.m_Data.m_Data          = t->m_Data;
+    t->m_Image.m_Data.m_Count         = data_size;
+
+    dmGraphics::TextureImage texture_image;
+    memset(&texture_image, 0, sizeof(texture_image));
+    texture_image.m_Alternatives.m_Data  = &t->m_Image;
+    texture_image.m_Alternatives.m_Count = 1;
+    texture_image.m_Type                 = dmGraphics::TextureImage::TYPE_2D;
+    texture_image.m_Count                = 1;
+
+    char host_path[256];
+    dmTestUtil::MakeHostPathf(host_path, sizeof(host_path), "build/src/gamesys/test%s", path);
+    ASSERT_EQ(dmDDF::RESULT_OK, dmDDF::SaveMessageToFile(&texture_image, dmGraphics::TextureImage::m_DDFDescriptor, host_path));
+
+    t->m_Params.m_Format = dmGraphics::TEXTURE_FORMAT_RGBA;
+    t->m_Params.m_Width  = StreamingTestTexture::SIZE;
+    t->m_Params.m_Height = StreamingTestTexture::SIZE;
+    t->m_Params.m_Depth  = 1;
+
+    dmGraphics::TextureCreationParams creation_params;
+    creation_params.m_Width       = StreamingTestTexture::SIZE >> base_mipmap;
+    creation_params.m_Height      = StreamingTestTexture::SIZE >> base_mipmap;
+    creation_params.m_MipMapCount = StreamingTestTexture::MIPMAP_COUNT - base_mipmap;
+    t->m_Texture = dmGraphics::NewTexture(context, creation_params);
+
+    uint8_t* data[StreamingTestTexture::MIPMAP_COUNT] = {};
+    dmGameSystem::AddStreamingTexture(t->m_Texture, path, 0, &t->m_Image, data, 0, t->m_Params, StreamingTestTexture::MIPMAP_COUNT, base_mipmap);
+}
+
+static void DeleteStreamingTestTexture(StreamingTestTexture* t)
+{
+    dmGameSystem::RemoveStreamingTexture(t->m_Texture, false);
+    dmGraphics::DeleteTexture(t->m_Texture);
+    delete[] t->m_Data;
+}
+
+// Resident size of a 64x64 rgba texture with levels from `mipmap` and down
+static uint32_t GetStreamingTestResidentSize(uint8_t mipmap)
+{
+    uint32_t size = 0;
+    for (uint32_t i = mipmap; i < StreamingTestTexture::MIPMAP_COUNT; ++i)
+    {
+        uint32_t level_size = StreamingTestTexture::SIZE >> i;
+        size += level_size * level_size * 4;
+    }
+    return size;
+}
+
+// Updates the streamer, requesting `mipmap` of `drawn` each frame, until `texture` has `width` as its largest level
+static bool WaitForStreamingTexture(dmJobThread::HContext job_thread, dmGraphics::HTexture drawn, uint8_t mipmap, dmGraphics::HTexture texture, uint16_t width)
+{
+    for (uint32_t i = 0; i < 500; ++i)
+    {
+        dmGameSystem::RequestTextureMipMap(drawn, mipmap);
+        dmGameSystem::UpdateTextureStreaming();
+        dmJobThread::Update(job_thread);
+        if (dmGraphics::GetTextureWidth(texture) == width)
+            return true;
+        dmTime::Sleep(1000);
+    }
+    return false;
+}
+
+TEST_F(TextureStreamingTest, RequestAndRelease)
+{
+    dmGameSystem::TextureStreamingParams params;
+    params.m_Factory         = m_Factory;
+    params.m_GraphicsContext = m_GraphicsContext;
+    params.m_JobThread       = m_JobThread;
+    params.m_InitialSize     = 16;
+    dmGameSystem::InitializeTextureStreaming(params);
+
+    uint8_t base_mipmap = dmGameSystem::GetTextureStreamingBaseMipMap(dmGraphics::TEXTURE_TYPE_2D, 64, 64, 1, StreamingTestTexture::MIPMAP_COUNT);
+    ASSERT_EQ(2, base_mipmap);
+
+    StreamingTestTexture t;
+    CreateStreamingTestTexture(m_GraphicsContext, "/texture/streaming_test.texturec", base_mipmap, &t);
+
+    uint16_t width, height;
+    dmGameSystem::GetTextureFullSize(t.m_Texture, &width, &height);
+    ASSERT_EQ(64, width);
+    ASSERT_EQ(64, height);
+
+    // Smaller levels than the ones created are already resident
+    dmGameSystem::RequestTextureMipMap(t.m_Texture, 4);
+    dmGameSystem::UpdateTextureStreaming();
+    ASSERT_EQ(16, dmGraphics::GetTextureWidth(t.m_Texture));
+
+    // Larger levels are loaded on the job thread
+    ASSERT_TRUE(WaitForStreamingTexture(m_JobThread, t.m_Texture, 1, t.m_Texture, 32));
+    ASSERT_TRUE(WaitForStreamingTexture(m_JobThread, t.m_Texture, 0, t.m_Texture, 64));
+
+    // Levels that aren't drawn are kept for a while, then dropped back to the levels it was created with
+    for (uint32_t i = 0; i < 10; ++i)
+    {
+        dmGameSystem::UpdateTextureStreaming();
+    }
+    ASSERT_EQ(64, dmGraphics::GetTextureWidth(t.m_Texture));
+    ASSERT_TRUE(WaitForStreamingTexture(m_JobThread, t.m_Texture, 0xFF, t.m_Texture, 16));
+
+    DeleteStreamingTestTexture(&t);
+    dmGameSystem::FinalizeTextureStreaming();
+}
+
+TEST_F(TextureStreamingTest, Budget)
+{
+    // Room for one texture with all its levels, and one without its largest level
+    dmGameSystem::TextureStreamingParams params;
+    params.m_Factory         = m_Factory;
+    params.m_GraphicsContext = m_GraphicsContext;
+    params.m_JobThread       = m_JobThread;
+    params.m_InitialSize     = 16;
+    params.m_Budget          = GetStreamingTestResidentSize(0) + GetStreamingTestResidentSize(1);
+    dmGameSystem::InitializeTextureStreaming(params);
+
+    StreamingTestTexture a;
+    StreamingTestTexture b;
+    CreateStreamingTestTexture(m_GraphicsContext, "/texture/streaming_test_a.texturec", 2, &a);
+    CreateStreamingTestTexture(m_GraphicsContext, "/texture/streaming_test_b.texturec", 2, &b);
+
+    // Both drawn at full size, one of them has to do without its largest level
+    bool settled = false;
+    for (uint32_t i = 0; i < 500 && !settled; ++i)
+    {
+        dmGameSystem::RequestTextureMipMap(a.m_Texture, 0);
+        dmGameSystem::RequestTextureMipMap(b.m_Texture, 0);
+        dmGameSystem::UpdateTextureStreaming();
+        dmJobThread::Update(m_JobThread);
+        settled = dmGraphics::GetTextureWidth(a.m_Texture) + dmGraphics::GetTextureWidth(b.m_Texture) == 64 + 32;
+        dmTime::Sleep(1000);
+    }
+    ASSERT_TRUE(settled);
+
+    // The one drawn least recently gives up its largest level when the other one needs it
+    StreamingTestTexture* evicted  = dmGraphics::GetTextureWidth(a.m_Texture) == 32 ? &a : &b;
+    StreamingTestTexture* resident = evicted == &a ? &b : &a;
+    ASSERT_TRUE(WaitForStreamingTexture(m_JobThread, evicted->m_Texture, 0, evicted->m_Texture, 64));
+    ASSERT_TRUE(WaitForStreamingTexture(m_JobThread, evicted->m_Texture, 0, resident->m_Texture, 32));
+
+    DeleteStreamingTestTexture(&a);
+    DeleteStreamingTestTexture(&b);
+    dmGameSystem::FinalizeTextureStreaming();
+}
+
 TEST_F(ResourceTest, TestCreateTextureFromScript)
 {
     dmGameSystem::ScriptLibContext scriptlibcontext;
@@ -3036,8 +3251,8 @@ TEST_F(ComponentTest, DispatchBuffersTest)
     // Particle
     ///////////////////////////////////////
     {
-        dmRender::BufferedRenderBuffer* vx_buffer;
-        dmGameSystem::GetParticleFXWorldRenderBuffers(particlefx_world, &vx_buffer);
+        // Particles are written to the render context frame ring, which uses a segment per draw when multi-buffering
+        dmRender::FrameRing* vx_buffer = &m_RenderContext->m_FrameRings[dmRender::RENDER_BUFFER_TYPE_VERTEX_BUFFER];
         ASSERT_EQ(num_draws, vx_buffer->m_Buffers.Size());
         ASSERT_EQ(dmRender::RENDER_BUFFER_TYPE_VERTEX_BUFFER, vx_buffer->m_Type);
 
@@ -3191,6 +3406,185 @@ TEST_F(ComponentTest, DispatchBuffersInstancingTest)
     ASSERT_TRUE(dmGameObject::Final(m_Collection));
 }
 
+TEST_F(ComponentTest, DispatchBuffersInstanceAttributesTest)
+{
+    void* model_world = dmGameObject::GetWorld(m_Collection, dmGameObject::GetComponentTypeIndex(m_Collection, dmHashString64("modelc")));
+    ASSERT_NE((void*) 0, model_world);
+
+    ASSERT_TRUE(dmGameObject::Init(m_Collection));
+    dmGameObject::HInstance go = Spawn(m_Factory, m_Collection, "/misc/dispatch_buffers_instancing_test/instance_attributes_test.goc", dmHashString64("/go"), 0, Point3(0, 0, 0), Quat(0, 0, 0, 1), Vector3(1, 1, 1));
+    ASSERT_NE((void*)0, go);
+
+    dmhash_t model_0               = dmHashString64("model_0");
+    dmhash_t model_1               = dmHashString64("model_1");
+    dmhash_t instance_attribute_id = dmHashString64("my_custom_instance_attribute");
+    dmGameObject::PropertyOptions opt;
+    opt.m_Index = 0;
+
+    ASSERT_EQ(dmGameObject::PROPERTY_RESULT_OK, dmGameObject::SetProperty(go, model_0, instance_attribute_id, opt, dmGameObject::PropertyVar(Vector4(10.0f, 20.0f, 30.0f, 40.0f))));
+    ASSERT_EQ(dmGameObject::PROPERTY_RESULT_OK, dmGameObject::SetProperty(go, model_1, instance_attribute_id, opt, dmGameObject::PropertyVar(Vector4(50.0f, 60.0f, 70.0f, 80.0f))));
+
+    dmGameObject::PropertyDesc desc;
+    ASSERT_EQ(dmGameObject::PROPERTY_RESULT_OK, dmGameObject::GetProperty(go, model_1, instance_attribute_id, opt, desc));
+    ASSERT_EQ(dmGameObject::PROPERTY_TYPE_VECTOR4, desc.m_Variant.m_Type);
+    ASSERT_NEAR(50.0f, desc.m_Variant.m_V4[0], EPSILON);
+
+    // Per vertex attributes of local space models are stored in static vertex buffers
+    ASSERT_EQ(dmGameObject::PROPERTY_RESULT_UNSUPPORTED_OPERATION, dmGameObject::SetProperty(go, model_0, dmHashString64("my_custom_vertex_attribute"), opt, dmGameObject::PropertyVar(Vector3(1.0f, 2.0f, 0.0f))));
+
+    ASSERT_TRUE(dmGameObject::Update(m_Collection, &m_UpdateContext));
+
+    dmRender::RenderListBegin(m_RenderContext);
+    dmGameObject::Render(m_Collection);
+    dmRender::RenderListEnd(m_RenderContext);
+    dmRender::DrawRenderList(m_RenderContext, 0x0, 0x0, 0x0);
+
+    struct inst_format
+    {
+        float mtx_world[16];
+        float my_custom_instance_attribute[4];
+    };
+
+    dmArray<uint8_t>* instance_data;
+    dmArray<dmRender::RenderObject>* render_objects;
+    dmGameSystem::GetModelWorldInstanceData(model_world, &instance_data, &render_objects);
+
+    // The different attribute values don't break the instancing
+    ASSERT_EQ(1, render_objects->Size());
+    ASSERT_EQ(2, (*render_objects)[0].m_InstanceCount);
+    ASSERT_EQ(2 * sizeof(inst_format), instance_data->Size());
+
+    // The instances are sorted by depth, so use the translation to tell them apart
+    inst_format* instances = (inst_format*) instance_data->Begin();
+    inst_format* instance_0 = instances[0].mtx_world[14] == 0.0f ? &instances[0] : &instances[1];
+    inst_format* instance_1 = instances[0].mtx_world[14] == 0.0f ? &instances[1] : &instances[0];
+    ASSERT_NEAR(-1.0f, instance_1->mtx_world[14], EPSILON);
+
+    const float expected_0[] = { 10.0f, 20.0f, 30.0f, 40.0f };
+    const float expected_1[] = { 50.0f, 60.0f, 70.0f, 80.0f };
+    for (int i = 0; i < 4; ++i)
+    {
+        ASSERT_NEAR(expected_0[i], instance_0->my_custom_instance_attribute[i], EPSILON);
+        ASSERT_NEAR(expected_1[i], instance_1->my_custom_instance_attribute[i], EPSILON);
+    }
+
+    ASSERT_TRUE(dmGameObject::Final(m_Collection));
+}
+
+static void DrawRecordedFrame(dmGameObject::HCollection collection, dmGameObject::UpdateContext* update_context, dmRender::HRenderContext render_context, dmRender::HRenderRecording recording)
+{
+    ASSERT_TRUE(dmGameObject::Update(collection, update_context));
+    dmRender::RenderListBegin(render_context);
+    dmGameObject::Render(collection);
+    dmRender::RenderListEnd(render_context);
+    ASSERT_EQ(dmRender::RESULT_OK, dmRender::DrawRenderList(render_context, 0x0, 0x0, 0x0, recording));
+}
+
+TEST_F(ComponentTest, RenderRecordingSpriteRotation)
+{
+    void* sprite_world = dmGameObject::GetWorld(m_Collection, dmGameObject::GetComponentTypeIndex(m_Collection, dmHashString64("spritec")));
+    ASSERT_NE((void*) 0, sprite_world);
+
+    ASSERT_TRUE(dmGameObject::Init(m_Collection));
+    dmGameObject::HInstance go = Spawn(m_Factory, m_Collection, "/misc/dispatch_buffers_test/render_recording_test.goc", dmHashString64("/go"), 0, Point3(0, 0, 0), Quat(0, 0, 0, 1), Vector3(1, 1, 1));
+    ASSERT_NE((void*)0, go);
+
+    // Vertex format for /misc/dispatch_buffers_test/vs_format_a.vp
+    struct vs_format_a
+    {
+        float position[3];
+        float page_index;
+    };
+
+    dmRender::HRenderRecording recording = dmRender::NewRenderRecording();
+
+    // Recorded, then replayed
+    DrawRecordedFrame(m_Collection, &m_UpdateContext, m_RenderContext, recording);
+    ASSERT_TRUE(dmRender::IsRenderRecordingValid(recording));
+    DrawRecordedFrame(m_Collection, &m_UpdateContext, m_RenderContext, recording);
+    ASSERT_TRUE(dmRender::IsRenderRecordingValid(recording));
+
+    dmRender::BufferedRenderBuffer* vx_buffer;
+    dmRender::BufferedRenderBuffer* ix_buffer;
+    dmGameSystem::GetSpriteWorldRenderBuffers(sprite_world, &vx_buffer, &ix_buffer);
+    ASSERT_EQ(1, vx_buffer->m_Buffers.Size());
+
+    dmGraphics::VertexBuffer* gfx_vx_buffer = (dmGraphics::VertexBuffer*) vx_buffer->m_Buffers[0];
+    vs_format_a* written = (vs_format_a*) gfx_vx_buffer->m_Buffer;
+    ASSERT_NEAR(-16.0f, written[0].position[0], EPSILON);
+    ASSERT_NEAR(-16.0f, written[0].position[1], EPSILON);
+
+    // Rotating the sprite doesn't change its render list entry, only the vertex data
+    dmGameObject::SetRotation(go, Quat::rotationZ(1.5707964f));
+    DrawRecordedFrame(m_Collection, &m_UpdateContext, m_RenderContext, recording);
+    ASSERT_TRUE(dmRender::IsRenderRecordingValid(recording));
+
+    gfx_vx_buffer = (dmGraphics::VertexBuffer*) vx_buffer->m_Buffers[0];
+    written = (vs_format_a*) gfx_vx_buffer->m_Buffer;
+    ASSERT_NEAR( 16.0f, written[0].position[0], EPSILON);
+    ASSERT_NEAR(-16.0f, written[0].position[1], EPSILON);
+
+    dmRender::DeleteRenderRecording(recording);
+    ASSERT_TRUE(dmGameObject::Final(m_Collection));
+}
+
+TEST_F(ComponentTest, DispatchBuffersWorldSpaceAttributesTest)
+{
+    void* model_world = dmGameObject::GetWorld(m_Collection, dmGameObject::GetComponentTypeIndex(m_Collection, dmHashString64("modelc")));
+    ASSERT_NE((void*) 0, model_world);
+
+    ASSERT_TRUE(dmGameObject::Init(m_Collection));
+    dmGameObject::HInstance go = Spawn(m_Factory, m_Collection, "/misc/dispatch_buffers_test/attribute_overrides_test.goc", dmHashString64("/go"), 0, Point3(0, 0, 0), Quat(0, 0, 0, 1), Vector3(1, 1, 1));
+    ASSERT_NE((void*)0, go);
+
+    dmhash_t attribute_id = dmHashString64("my_custom_attribute");
+    dmGameObject::PropertyOptions opt;
+    opt.m_Index = 0;
+
+    // World space models write their vertices each frame, so per vertex attributes can be overridden
+    ASSERT_EQ(dmGameObject::PROPERTY_RESULT_OK, dmGameObject::SetProperty(go, dmHashString64("model_0"), attribute_id, opt, dmGameObject::PropertyVar(Vector4(10.0f, 20.0f, 30.0f, 40.0f))));
+    ASSERT_EQ(dmGameObject::PROPERTY_RESULT_OK, dmGameObject::SetProperty(go, dmHashString64("model_1"), attribute_id, opt, dmGameObject::PropertyVar(Vector4(50.0f, 60.0f, 70.0f, 80.0f))));
+
+    ASSERT_TRUE(dmGameObject::Update(m_Collection, &m_UpdateContext));
+
+    dmRender::RenderListBegin(m_RenderContext);
+    dmGameObject::Render(m_Collection);
+    dmRender::RenderListEnd(m_RenderContext);
+    dmRender::DrawRenderList(m_RenderContext, 0x0, 0x0, 0x0);
+
+    // Vertex format for /misc/dispatch_buffers_test/vs_format_b.vp
+    struct vs_format_b
+    {
+        float position[3];
+        float my_custom_attribute[4];
+    };
+
+    uint32_t vx_buffers_count;
+    dmRender::BufferedRenderBuffer** vx_buffers;
+    dmGameSystem::GetModelWorldRenderBuffers(model_world, &vx_buffers, &vx_buffers_count);
+    ASSERT_TRUE(vx_buffers_count > 0);
+
+    // Both models are drawn in the same batch, each with its own values
+    const uint32_t vertex_count = 6;
+    dmGraphics::VertexBuffer* gfx_vx_buffer = (dmGraphics::VertexBuffer*) vx_buffers[0]->m_Buffers[0];
+    ASSERT_EQ(2 * vertex_count * sizeof(vs_format_b), gfx_vx_buffer->m_Size);
+
+    const float expected_0[] = { 10.0f, 20.0f, 30.0f, 40.0f };
+    const float expected_1[] = { 50.0f, 60.0f, 70.0f, 80.0f };
+    vs_format_b* vertices = (vs_format_b*) gfx_vx_buffer->m_Buffer;
+    for (uint32_t i = 0; i < 2 * vertex_count; ++i)
+    {
+        // The models are sorted by depth, so use the position to tell them apart
+        const float* expected = vertices[i].position[2] == 0.0f ? expected_0 : expected_1;
+        for (int j = 0; j < 4; ++j)
+        {
+            ASSERT_NEAR(expected[j], vertices[i].my_custom_attribute[j], EPSILON);
+        }
+    }
+
+    ASSERT_TRUE(dmGameObject::Final(m_Collection));
+}
+
 /* Camera */
 
 const char* valid_camera_resources[] = {"/camera/valid.camerac"};
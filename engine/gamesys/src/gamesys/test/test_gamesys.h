@@ -267,6 +267,12 @@ public:
     virtual ~ComponentTest() {}
 };
 
+class TextureStreamingTest : public GamesysTest<const char*>
+{
+public:
+    virtual ~TextureStreamingTest() {}
+};
+
 class ComponentFailTest : public GamesysTest<const char*>
 {
 public:
@@ -513,6 +519,9 @@ void GamesysTest<T>::SetUp()
 
     m_GraphicsContext = dmGraphics::NewContext(graphics_context_params);
 
+    // Transcode the mipmap levels of the basis textures on worker threads, as the engine does
+    dmGraphics::InitializeTranscoder(2);
+
     dmScript::ContextParams script_context_params = {};
     script_context_params.m_Factory = m_Factory;
     script_context_params.m_GraphicsContext = m_GraphicsContext;
@@ -653,6 +662,7 @@ void GamesysTest<T>::TearDown()
     dmScript::Finalize(m_ScriptContext);
     dmScript::DeleteContext(m_ScriptContext);
     dmResource::DeleteFactory(m_Factory);
+    dmGraphics::FinalizeTranscoder();
     dmGameObject::DeleteRegister(m_Register);
     dmSound::Finalize();
     dmInput::DeleteContext(m_InputContext);
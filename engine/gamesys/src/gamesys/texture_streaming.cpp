@@ -0,0 +1,602 @@
+// Copyright 2020-2024 The Defold Foundation
+// Copyright 2014-2020 King
+// Copyright 2009-2014 Ragnar Svensson, Christian Murray
+// Licensed under the Defold License version 1.0 (the "License"); you may not use
+// this file except in compliance with the License.
+//
+// You may obtain a copy of the License, together with FAQs at
+// https://www.defold.com/license
+//
+// Unless required by applicable law or agreed to in writing, software distributed
+// under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+// CONDITIONS OF ANY KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations under the License.
+
+#include "texture_streaming.h"
+#include "gamesys.h"
+
+#include <float.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+
+#include <dlib/array.h>
+#include <dlib/hashtable.h>
+#include <dlib/job_thread.h>
+#include <dlib/log.h>
+#include <dlib/math.h>
+#include <dlib/profile.h>
+#include <dlib/time.h>
+#include <ddf/ddf.h>
+#include <resource/resource.h>
+
+DM_PROPERTY_GROUP(rmtp_TextureStreaming, "Texture Streaming");
+DM_PROPERTY_U32(rmtp_TextureStreamingTextures, 0, NoFlags, "# streamed textures", &rmtp_TextureStreaming);
+DM_PROPERTY_U32(rmtp_TextureStreamingResident, 0, NoFlags, "size of the resident mipmap levels in kb", &rmtp_TextureStreaming);
+DM_PROPERTY_U32(rmtp_TextureStreamingBudget, 0, NoFlags, "budget for the resident mipmap levels in kb", &rmtp_TextureStreaming);
+DM_PROPERTY_U32(rmtp_TextureStreamingLoading, 0, NoFlags, "# textures loading mipmap levels", &rmtp_TextureStreaming);
+DM_PROPERTY_U32(rmtp_TextureStreamingUploaded, 0, FrameReset, "size of the mipmap levels uploaded in kb", &rmtp_TextureStreaming);
+DM_PROPERTY_U32(rmtp_TextureStreamingEvicted, 0, FrameReset, "# textures that dropped mipmap levels", &rmtp_TextureStreaming);
+
+namespace dmGameSystem
+{
+    static const uint32_t MAX_MIPMAP_COUNT        = 15;
+    static const uint8_t  NO_REQUEST              = 0xFF;
+    // Levels that haven't been drawn for this many frames are released
+    static const uint32_t RELEASE_DELAY_FRAMES    = 60;
+    static const uint32_t MAX_PENDING_LOADS       = 2;
+    // Max size of the levels uploaded per frame. At least one texture is updated per frame.
+    static const uint32_t FRAME_UPLOAD_BUDGET     = 4 * 1024 * 1024;
+
+    struct StreamingLevels
+    {
+        uint8_t* m_Data;
+        uint32_t m_Offsets[MAX_MIPMAP_COUNT];
+        uint32_t m_Sizes[MAX_MIPMAP_COUNT];
+        uint8_t  m_BaseMipMap;
+    };
+
+    struct StreamingTexture
+    {
+        dmGraphics::HTexture      m_Texture;
+        char*                     m_Path;
+        // Upload params of the full size base level
+        dmGraphics::TextureParams m_Params;
+        uint32_t                  m_LevelSizes[MAX_MIPMAP_COUNT];
+        // The smallest levels are kept in memory, so that the texture can drop levels without loading anything
+        StreamingLevels           m_Tail;
+        // Written by the load job
+        StreamingLevels           m_Loaded;
+        uint32_t                  m_Index;
+        uint32_t                  m_LastUsedFrame;
+        uint32_t                  m_WantedFrame;
+        uint32_t                  m_AlternativeIndex;
+        uint8_t                   m_MipMapCount;
+        uint8_t                   m_TailMipMap;
+        uint8_t                   m_ResidentMipMap;
+        uint8_t                   m_WantedMipMap;
+        uint8_t                   m_RequestedMipMap;
+        uint8_t                   m_LoadMipMap;
+        uint8_t                   m_Loading    : 1;
+        uint8_t                   m_LoadReady  : 1;
+        uint8_t                   m_LoadFailed : 1;
+        uint8_t                   m_Removed    : 1;
+        uint8_t                              : 4;
+    };
+
+    struct TextureStreamer
+    {
+        dmResource::HFactory                m_Factory;
+        dmGraphics::HContext                m_GraphicsContext;
+        dmJobThread::HContext               m_JobThread;
+        dmHashTable64<StreamingTexture*>    m_TextureMap;
+        dmArray<StreamingTexture*>          m_Textures;
+        dmArray<StreamingTexture*>          m_Scratch;
+        uint64_t                            m_Budget;
+        uint64_t                            m_ResidentSize;
+        uint32_t                            m_Frame;
+        uint32_t                            m_PendingLoads;
+        uint16_t                            m_InitialSize;
+    };
+
+    static TextureStreamer* g_TextureStreamer = 0;
+
+    TextureStreamingParams::TextureStreamingParams()
+    {
+        memset(this, 0, sizeof(*this));
+        m_Budget      = 128 * 1024 * 1024;
+        m_InitialSize = 64;
+    }
+
+    static uint16_t GetLevelSize(uint16_t size, uint8_t mipmap)
+    {
+        return (uint16_t) dmMath::Max((uint32_t) size >> mipmap, 1U);
+    }
+
+    static uint64_t GetResidentSize(const StreamingTexture* t, uint8_t mipmap)
+    {
+        uint64_t size = 0;
+        for (uint32_t i = mipmap; i < t->m_MipMapCount; ++i)
+        {
+            size += t->m_LevelSizes[i];
+        }
+        return size;
+    }
+
+    static void FreeLevels(StreamingLevels* levels)
+    {
+        free(levels->m_Data);
+        memset(levels, 0, sizeof(StreamingLevels));
+    }
+
+    // Copies the levels from `base_mipmap` and down, from the transcoded `data` or else from the image itself
+    static void CopyLevels(dmGraphics::TextureImage::Image* image, uint8_t** data, uint32_t* data_sizes, uint32_t mipmap_count, uint8_t base_mipmap, StreamingLevels* out)
+    {
+        uint32_t total_size = 0;
+        for (uint32_t i = base_mipmap; i < mipmap_count; ++i)
+        {
+            total_size += data[i] ? data_sizes[i] : image->m_MipMapSize[i];
+        }
+
+        out->m_Data       = (uint8_t*) malloc(total_size);
+        out->m_BaseMipMap = base_mipmap;
+
+        uint32_t offset = 0;
+        for (uint32_t i = base_mipmap; i < mipmap_count; ++i)
+        {
+            const uint8_t* src = data[i] ? data[i] : &image->m_Data[image->m_MipMapOffset[i]];
+            uint32_t size      = data[i] ? data_sizes[i] : image->m_MipMapSize[i];
+            memcpy(out->m_Data + offset, src, size);
+            out->m_Offsets[i - base_mipmap] = offset;
+            out->m_Sizes[i - base_mipmap]   = size;
+            offset += size;
+        }
+    }
+
+    // Reads the texture file and extracts the levels from `base_mipmap` and down. Called from the job thread.
+    static bool LoadLevels(dmResource::HFactory factory, const StreamingTexture* t, uint8_t base_mipmap, StreamingLevels* out)
+    {
+        DM_PROFILE_DYN(t->m_Path, 0);
+
+        void* buffer;
+        uint32_t buffer_size;
+        if (dmResource::GetRaw(factory, t->m_Path, &buffer, &buffer_size) != dmResource::RESULT_OK)
+        {
+            return false;
+        }
+
+        dmGraphics::TextureImage* texture_image;
+        dmDDF::Result e = dmDDF::LoadMessage<dmGraphics::TextureImage>(buffer, buffer_size, &texture_image);
+        free(buffer);
+        if (e != dmDDF::RESULT_OK)
+        {
+            return false;
+        }
+
+        bool result = false;
+        if (t->m_AlternativeIndex < texture_image->m_Alternatives.m_Count)
+        {
+            dmGraphics::TextureImage::Image* image = &texture_image->m_Alternatives[t->m_AlternativeIndex];
+            uint8_t* data[MAX_MIPMAP_COUNT]        = {};
+            uint32_t data_sizes[MAX_MIPMAP_COUNT]  = {};
+            uint32_t num_mips                      = image->m_MipMapOffset.m_Count;
+
+            if (dmGraphics::IsFormatTranscoded(image->m_CompressionType))
+            {
+                num_mips = MAX_MIPMAP_COUNT;
+                if (!dmGraphics::Transcode(t->m_Path, image, 1, t->m_Params.m_Format, data, data_sizes, &num_mips))
+                {
+                    num_mips = 0;
+                }
+            }
+
+            // The file might have changed on disc, in which case the texture is left as it is
+            if (num_mips == t->m_MipMapCount && image->m_Width == t->m_Params.m_Width && image->m_Height == t->m_Params.m_Height)
+            {
+                CopyLevels(image, data, data_sizes, num_mips, base_mipmap, out);
+                result = true;
+            }
+
+            for (uint32_t i = 0; i < MAX_MIPMAP_COUNT; ++i)
+            {
+                delete[] data[i];
+            }
+        }
+
+        dmDDF::FreeMessage(texture_image);
+        return result;
+    }
+
+    // Recreates the texture with `base_mipmap` as its largest level
+    static uint32_t UploadLevels(TextureStreamer* s, StreamingTexture* t, const StreamingLevels* levels, uint8_t base_mipmap)
+    {
+        DM_PROFILE(__FUNCTION__);
+        assert(base_mipmap >= levels->m_BaseMipMap);
+
+        uint32_t uploaded = 0;
+        dmGraphics::TextureParams params = t->m_Params;
+        for (uint32_t i = base_mipmap; i < t->m_MipMapCount; ++i)
+        {
+            uint32_t level    = i - levels->m_BaseMipMap;
+            params.m_MipMap   = i - base_mipmap;
+            params.m_Width    = GetLevelSize(t->m_Params.m_Width, i);
+            params.m_Height   = GetLevelSize(t->m_Params.m_Height, i);
+            params.m_Data     = levels->m_Data + levels->m_Offsets[level];
+            params.m_DataSize = levels->m_Sizes[level];
+            dmGraphics::SetTexture(t->m_Texture, params);
+            uploaded += params.m_DataSize;
+        }
+
+        if (base_mipmap > t->m_ResidentMipMap)
+        {
+            DM_PROPERTY_ADD_U32(rmtp_TextureStreamingEvicted, 1);
+        }
+
+        s->m_ResidentSize -= GetResidentSize(t, t->m_ResidentMipMap);
+        s->m_ResidentSize += GetResidentSize(t, base_mipmap);
+        t->m_ResidentMipMap = base_mipmap;
+        return uploaded;
+    }
+
+    static void DeleteStreamingTexture(StreamingTexture* t)
+    {
+        FreeLevels(&t->m_Tail);
+        FreeLevels(&t->m_Loaded);
+        free(t->m_Path);
+        delete t;
+    }
+
+    static int LoadJob(void* context, void* data)
+    {
+        TextureStreamer* s  = (TextureStreamer*) context;
+        StreamingTexture* t = (StreamingTexture*) data;
+        return LoadLevels(s->m_Factory, t, t->m_LoadMipMap, &t->m_Loaded) ? 1 : 0;
+    }
+
+    static void LoadJobComplete(void* context, void* data, int result)
+    {
+        TextureStreamer* s  = (TextureStreamer*) context;
+        StreamingTexture* t = (StreamingTexture*) data;
+        s->m_PendingLoads--;
+        t->m_Loading = 0;
+
+        if (t->m_Removed)
+        {
+            DeleteStreamingTexture(t);
+            return;
+        }
+
+        if (result)
+        {
+            t->m_LoadReady = 1;
+        }
+        else
+        {
+            // Keep the levels that are already resident and stop streaming the texture
+            dmLogWarning("Unable to stream mipmap levels of '%s'", t->m_Path);
+            FreeLevels(&t->m_Loaded);
+            t->m_LoadFailed = 1;
+        }
+    }
+
+    // Least recently drawn first, then largest first
+    struct StreamingTextureEvictionPred
+    {
+        bool operator()(const StreamingTexture* a, const StreamingTexture* b) const
+        {
+            if (a->m_LastUsedFrame != b->m_LastUsedFrame)
+                return a->m_LastUsedFrame < b->m_LastUsedFrame;
+            return a->m_LevelSizes[a->m_WantedMipMap] > b->m_LevelSizes[b->m_WantedMipMap];
+        }
+    };
+
+    static void ApplyBudget(TextureStreamer* s, uint64_t wanted_size)
+    {
+        DM_PROFILE(__FUNCTION__);
+        s->m_Scratch.SetSize(0);
+        if (s->m_Scratch.Capacity() < s->m_Textures.Size())
+        {
+            s->m_Scratch.SetCapacity(s->m_Textures.Size());
+        }
+        for (uint32_t i = 0; i < s->m_Textures.Size(); ++i)
+        {
+            s->m_Scratch.Push(s->m_Textures[i]);
+        }
+        std::sort(s->m_Scratch.Begin(), s->m_Scratch.End(), StreamingTextureEvictionPred());
+
+        for (uint32_t i = 0; i < s->m_Scratch.Size() && wanted_size > s->m_Budget; ++i)
+        {
+            StreamingTexture* t = s->m_Scratch[i];
+            while (wanted_size > s->m_Budget && t->m_WantedMipMap < t->m_TailMipMap)
+            {
+                wanted_size -= t->m_LevelSizes[t->m_WantedMipMap];
+                t->m_WantedMipMap++;
+            }
+        }
+    }
+
+    void InitializeTextureStreaming(const TextureStreamingParams& params)
+    {
+        assert(g_TextureStreamer == 0);
+        TextureStreamer* s     = new TextureStreamer;
+        s->m_Factory           = params.m_Factory;
+        s->m_GraphicsContext   = params.m_GraphicsContext;
+        s->m_JobThread         = params.m_JobThread;
+        s->m_Budget            = params.m_Budget;
+        s->m_InitialSize       = dmMath::Max(params.m_InitialSize, (uint16_t) 1);
+        s->m_ResidentSize      = 0;
+        s->m_Frame             = 0;
+        s->m_PendingLoads      = 0;
+        g_TextureStreamer      = s;
+
+        DM_PROPERTY_SET_U32(rmtp_TextureStreamingBudget, (uint32_t) (s->m_Budget / 1024));
+    }
+
+    void FinalizeTextureStreaming()
+    {
+        TextureStreamer* s = g_TextureStreamer;
+        if (!s)
+            return;
+
+        // The load jobs reference the textures
+        while (s->m_PendingLoads > 0)
+        {
+            dmJobThread::Update(s->m_JobThread);
+            if (s->m_PendingLoads > 0)
+            {
+                dmTime::Sleep(1000);
+            }
+        }
+
+        for (uint32_t i = 0; i < s->m_Textures.Size(); ++i)
+        {
+            DeleteStreamingTexture(s->m_Textures[i]);
+        }
+        delete s;
+        g_TextureStreamer = 0;
+    }
+
+    bool IsTextureStreamingEnabled()
+    {
+        return g_TextureStreamer != 0;
+    }
+
+    uint8_t GetTextureStreamingBaseMipMap(dmGraphics::TextureType type, uint16_t width, uint16_t height, uint16_t depth, uint32_t mipmap_count)
+    {
+        TextureStreamer* s = g_TextureStreamer;
+        if (!s || type != dmGraphics::TEXTURE_TYPE_2D || depth > 1 || mipmap_count > MAX_MIPMAP_COUNT)
+            return 0;
+
+        // Only textures with a full mipmap chain, so that each level can be recreated as a base level
+        if (mipmap_count != dmGraphics::GetMipmapCount(dmMath::Max(width, height)))
+            return 0;
+
+        uint8_t base_mipmap = 0;
+        while (base_mipmap < mipmap_count - 1 && dmMath::Max(GetLevelSize(width, base_mipmap), GetLevelSize(height, base_mipmap)) > s->m_InitialSize)
+        {
+            base_mipmap++;
+        }
+        return base_mipmap;
+    }
+
+    void AddStreamingTexture(dmGraphics::HTexture texture, const char* path, uint32_t alternative_index, dmGraphics::TextureImage::Image* image,
+        uint8_t** data, uint32_t* data_sizes, const dmGraphics::TextureParams& params, uint32_t mipmap_count, uint8_t base_mipmap)
+    {
+        TextureStreamer* s = g_TextureStreamer;
+        assert(s);
+        assert(mipmap_count <= MAX_MIPMAP_COUNT);
+
+        StreamingTexture* t = new StreamingTexture;
+        memset(t, 0, sizeof(StreamingTexture));
+        t->m_Texture          = texture;
+        t->m_Path             = strdup(path);
+        t->m_Params           = params;
+        t->m_AlternativeIndex = alternative_index;
+        t->m_MipMapCount      = (uint8_t) mipmap_count;
+        t->m_TailMipMap       = base_mipmap;
+        t->m_ResidentMipMap   = base_mipmap;
+        t->m_WantedMipMap     = base_mipmap;
+        t->m_RequestedMipMap  = NO_REQUEST;
+        t->m_LastUsedFrame    = s->m_Frame;
+        t->m_WantedFrame      = s->m_Frame;
+
+        for (uint32_t i = 0; i < mipmap_count; ++i)
+        {
+            t->m_LevelSizes[i] = data[i] ? data_sizes[i] : image->m_MipMapSize[i];
+        }
+        CopyLevels(image, data, data_sizes, mipmap_count, base_mipmap, &t->m_Tail);
+
+        if (s->m_TextureMap.Full())
+        {
+            uint32_t capacity = s->m_TextureMap.Capacity() + 64;
+            s->m_TextureMap.SetCapacity(dmMath::Max(1U, (capacity*2)/3), capacity);
+        }
+        if (s->m_Textures.Full())
+        {
+            s->m_Textures.OffsetCapacity(64);
+        }
+
+        t->m_Index = s->m_Textures.Size();
+        s->m_Textures.Push(t);
+        s->m_TextureMap.Put(texture, t);
+        s->m_ResidentSize += GetResidentSize(t, base_mipmap);
+    }
+
+    void RemoveStreamingTexture(dmGraphics::HTexture texture, bool restore)
+    {
+        TextureStreamer* s = g_TextureStreamer;
+        if (!s)
+            return;
+        StreamingTexture** tp = s->m_TextureMap.Get(texture);
+        if (!tp)
+            return;
+        StreamingTexture* t = *tp;
+
+        if (restore && t->m_ResidentMipMap > 0)
+        {
+            StreamingLevels levels = {};
+            if (LoadLevels(s->m_Factory, t, 0, &levels))
+            {
+                UploadLevels(s, t, &levels, 0);
+            }
+            else
+            {
+                dmLogWarning("Unable to load all mipmap levels of '%s'", t->m_Path);
+            }
+            FreeLevels(&levels);
+        }
+
+        s->m_ResidentSize -= GetResidentSize(t, t->m_ResidentMipMap);
+        s->m_TextureMap.Erase(texture);
+
+        StreamingTexture* last = s->m_Textures.Back();
+        last->m_Index = t->m_Index;
+        s->m_Textures.EraseSwap(t->m_Index);
+
+        if (t->m_Loading)
+        {
+            // Deleted when the load job is done
+            t->m_Removed = 1;
+        }
+        else
+        {
+            DeleteStreamingTexture(t);
+        }
+    }
+
+    void GetTextureFullSize(dmGraphics::HTexture texture, uint16_t* width, uint16_t* height)
+    {
+        StreamingTexture** tp = g_TextureStreamer ? g_TextureStreamer->m_TextureMap.Get(texture) : 0;
+        if (tp)
+        {
+            *width  = (*tp)->m_Params.m_Width;
+            *height = (*tp)->m_Params.m_Height;
+            return;
+        }
+        *width  = dmGraphics::GetTextureWidth(texture);
+        *height = dmGraphics::GetTextureHeight(texture);
+    }
+
+    float GetProjectedSize(const dmVMath::Matrix4& view_proj, const dmVMath::Point3& position, const dmVMath::Vector3& v, float viewport_width, float viewport_height)
+    {
+        dmVMath::Vector4 p = view_proj * position;
+        dmVMath::Vector4 d = view_proj * v;
+        float w = p.getW();
+        if (w <= FLT_EPSILON)
+        {
+            // At or behind the camera, assume it covers the screen
+            return FLT_MAX;
+        }
+
+        // Change of the normalized device coordinates along v, to first order
+        float inv_w = 1.0f / w;
+        float dx    = (d.getX() - p.getX() * inv_w * d.getW()) * inv_w * 0.5f * viewport_width;
+        float dy    = (d.getY() - p.getY() * inv_w * d.getW()) * inv_w * 0.5f * viewport_height;
+        return sqrtf(dx*dx + dy*dy);
+    }
+
+    uint8_t GetSampledMipMap(float texels, float pixels)
+    {
+        if (pixels <= 0.0f)
+            return NO_REQUEST;
+        float ratio = texels / pixels;
+        if (ratio <= 1.0f)
+            return 0;
+        return (uint8_t) dmMath::Min(floorf(log2f(ratio)), (float) (MAX_MIPMAP_COUNT - 1));
+    }
+
+    void RequestTextureMipMap(dmGraphics::HTexture texture, uint8_t mipmap)
+    {
+        TextureStreamer* s = g_TextureStreamer;
+        if (!s || !texture)
+            return;
+        StreamingTexture** tp = s->m_TextureMap.Get(texture);
+        if (!tp)
+            return;
+        StreamingTexture* t   = *tp;
+        t->m_RequestedMipMap  = dmMath::Min(t->m_RequestedMipMap, mipmap);
+        t->m_LastUsedFrame    = s->m_Frame;
+    }
+
+    void UpdateTextureStreaming()
+    {
+        TextureStreamer* s = g_TextureStreamer;
+        if (!s)
+            return;
+
+        DM_PROFILE("TextureStreaming");
+
+        // Pick the levels wanted from what was drawn last frame. Levels are added right away, and released
+        // once they haven't been needed for a while.
+        uint64_t wanted_size = 0;
+        uint32_t num_textures = s->m_Textures.Size();
+        for (uint32_t i = 0; i < num_textures; ++i)
+        {
+            StreamingTexture* t = s->m_Textures[i];
+            uint8_t requested   = dmMath::Min(t->m_RequestedMipMap, t->m_TailMipMap);
+
+            if (t->m_RequestedMipMap != NO_REQUEST && requested <= t->m_WantedMipMap)
+            {
+                t->m_WantedMipMap = requested;
+                t->m_WantedFrame  = s->m_Frame;
+            }
+            else if (s->m_Frame - t->m_WantedFrame > RELEASE_DELAY_FRAMES)
+            {
+                t->m_WantedMipMap = requested;
+                t->m_WantedFrame  = s->m_Frame;
+            }
+
+            t->m_RequestedMipMap = NO_REQUEST;
+            wanted_size += GetResidentSize(t, t->m_WantedMipMap);
+        }
+
+        if (wanted_size > s->m_Budget)
+        {
+            ApplyBudget(s, wanted_size);
+        }
+
+        uint32_t uploaded = 0;
+        for (uint32_t i = 0; i < num_textures; ++i)
+        {
+            StreamingTexture* t = s->m_Textures[i];
+            bool can_upload     = uploaded < FRAME_UPLOAD_BUDGET;
+
+            if (t->m_LoadReady && can_upload)
+            {
+                // The wanted level might have changed while loading
+                if (t->m_Loaded.m_BaseMipMap == t->m_WantedMipMap)
+                {
+                    uploaded += UploadLevels(s, t, &t->m_Loaded, t->m_WantedMipMap);
+                }
+                FreeLevels(&t->m_Loaded);
+                t->m_LoadReady = 0;
+            }
+
+            if (t->m_Loading || t->m_LoadReady || t->m_LoadFailed || t->m_WantedMipMap == t->m_ResidentMipMap)
+                continue;
+
+            if (t->m_WantedMipMap >= t->m_TailMipMap)
+            {
+                if (can_upload)
+                {
+                    uploaded += UploadLevels(s, t, &t->m_Tail, t->m_WantedMipMap);
+                }
+            }
+            else if (s->m_PendingLoads < MAX_PENDING_LOADS)
+            {
+                t->m_Loading    = 1;
+                t->m_LoadMipMap = t->m_WantedMipMap;
+                s->m_PendingLoads++;
+                dmJobThread::PushJob(s->m_JobThread, LoadJob, LoadJobComplete, s, t);
+            }
+        }
+
+        s->m_Frame++;
+
+        DM_PROPERTY_SET_U32(rmtp_TextureStreamingTextures, num_textures);
+        DM_PROPERTY_SET_U32(rmtp_TextureStreamingResident, (uint32_t) (s->m_ResidentSize / 1024));
+        DM_PROPERTY_SET_U32(rmtp_TextureStreamingLoading, s->m_PendingLoads);
+        DM_PROPERTY_ADD_U32(rmtp_TextureStreamingUploaded, uploaded / 1024);
+    }
+}
@@ -0,0 +1,51 @@
+// Copyright 2020-2024 The Defold Foundation
+// Copyright 2014-2020 King
+// Copyright 2009-2014 Ragnar Svensson, Christian Murray
+// Licensed under the Defold License version 1.0 (the "License"); you may not use
+// this file except in compliance with the License.
+//
+// You may obtain a copy of the License, together with FAQs at
+// https://www.defold.com/license
+//
+// Unless required by applicable law or agreed to in writing, software distributed
+// under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+// CONDITIONS OF ANY KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations under the License.
+
+#ifndef DM_GAMESYS_TEXTURE_STREAMING_H
+#define DM_GAMESYS_TEXTURE_STREAMING_H
+
+#include <stdint.h>
+#include <dmsdk/dlib/vmath.h>
+#include <graphics/graphics.h>
+
+namespace dmGameSystem
+{
+    bool IsTextureStreamingEnabled();
+
+    // Returns the mipmap level a new texture should be created from, or 0 if the texture isn't streamed
+    uint8_t GetTextureStreamingBaseMipMap(dmGraphics::TextureType type, uint16_t width, uint16_t height, uint16_t depth, uint32_t mipmap_count);
+
+    // Starts streaming a texture created from `base_mipmap`. The levels from `base_mipmap` and down are copied from
+    // `image` (or from `data`, if the image was transcoded), and are always kept resident.
+    // `params` are the upload params of the full size base level.
+    void AddStreamingTexture(dmGraphics::HTexture texture, const char* path, uint32_t alternative_index, dmGraphics::TextureImage::Image* image,
+        uint8_t** data, uint32_t* data_sizes, const dmGraphics::TextureParams& params, uint32_t mipmap_count, uint8_t base_mipmap);
+
+    // Stops streaming the texture. If `restore` is set, all mipmap levels are loaded and uploaded before returning.
+    void RemoveStreamingTexture(dmGraphics::HTexture texture, bool restore);
+
+    // Size of the full base level of the texture, also for streamed textures that currently have fewer levels resident
+    void GetTextureFullSize(dmGraphics::HTexture texture, uint16_t* width, uint16_t* height);
+
+    // Size in pixels of the world space vector `v` at `position`, as projected by `view_proj` on a viewport of the given size
+    float GetProjectedSize(const dmVMath::Matrix4& view_proj, const dmVMath::Point3& position, const dmVMath::Vector3& v, float viewport_width, float viewport_height);
+
+    // The mipmap level sampled when `texels` texels are drawn over `pixels` pixels
+    uint8_t GetSampledMipMap(float texels, float pixels);
+
+    // Requests the texture to have `mipmap` and the smaller levels resident. Called when the texture is drawn.
+    void RequestTextureMipMap(dmGraphics::HTexture texture, uint8_t mipmap);
+}
+
+#endif // DM_GAMESYS_TEXTURE_STREAMING_H
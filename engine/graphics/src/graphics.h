@@ -270,6 +270,7 @@ namespace dmGraphics
 
         dmPlatform::HWindow   m_Window;
         dmJobThread::HContext m_JobThread;
+        const char*           m_PipelineCachePath;              // Vulkan only, file used to store created pipelines between runs (default 0)
         TextureFilter         m_DefaultTextureMinFilter;
         TextureFilter         m_DefaultTextureMagFilter;
         uint32_t              m_Width;
@@ -280,7 +281,10 @@ namespace dmGraphics
         uint8_t               m_PrintDeviceInfo : 1;
         uint8_t               m_RenderDocSupport : 1;           // Vulkan only
         uint8_t               m_UseValidationLayers : 1;        // Vulkan only
-        uint8_t               : 4;
+        uint8_t               m_ValidateCommandRecording : 1;   // Vulkan only
+        uint8_t               m_AsyncPipelineCompile : 1;       // Vulkan only, create new pipelines on a job thread and skip draws until they are ready
+        uint8_t               : 2;
+        uint8_t               m_CommandRecordThreadCount;       // Vulkan only, number of threads used to record render passes (default 0)
     };
 
     struct PipelineState
@@ -887,6 +891,18 @@ namespace dmGraphics
      */
     bool Transcode(const char* path, TextureImage::Image* image, uint8_t image_count, TextureFormat format, uint8_t** images, uint32_t* sizes, uint32_t* num_transcoded_mips);
 
+    /** initializes the transcoder and creates the threads used to transcode the mipmap levels of a texture in parallel
+     * Transcode can be called from any thread, also without initializing the transcoder, but then all levels are transcoded on the calling thread.
+     * @name InitializeTranscoder
+     * @param thread_count The number of worker threads. The thread calling Transcode also transcodes levels.
+     */
+    void InitializeTranscoder(uint8_t thread_count);
+
+    /** destroys the transcoder threads
+     * @name FinalizeTranscoder
+     */
+    void FinalizeTranscoder();
+
     /**
      * Read frame buffer pixels in BGRA format
      * @param buffer buffer to read to
@@ -12,8 +12,12 @@
 // CONDITIONS OF ANY KIND, either express or implied. See the License for the
 // specific language governing permissions and limitations under the License.
 
+#include <dlib/atomic.h>
+#include <dlib/condition_variable.h>
+#include <dlib/job_thread.h>
 #include <dlib/log.h>
 #include <dlib/math.h>
+#include <dlib/mutex.h>
 #include <dlib/profile.h>
 #include "graphics.h"
 #include <basis/transcoder/basisu_transcoder.h>
@@ -215,7 +219,12 @@ namespace dmGraphics
         return true;
     }
 
-    static bool TranscodeLevel(const char* path, ImageTranscodeState& state, uint8_t* level_data, uint8_t level_index,  basist::transcoder_texture_format transcoder_format, dmGraphics::TextureFormat graphics_format)
+    // Worker threads used to transcode the mipmap levels of a texture in parallel (see InitializeTranscoder)
+    static dmJobThread::HContext g_TranscodeJobThread = 0;
+
+    // The transcoder_state holds the per thread decoding state, which is what makes it safe
+    // to transcode levels from the same basisu_transcoder on several threads.
+    static bool TranscodeLevel(const char* path, ImageTranscodeState& state, basist::basisu_transcoder_state& transcoder_state, uint8_t* level_data, uint8_t level_index,  basist::transcoder_texture_format transcoder_format, dmGraphics::TextureFormat graphics_format)
     {
         int image_index = 0;
         uint32_t flags = 0;
@@ -232,7 +241,7 @@ namespace dmGraphics
                     transcoder_format,
                     flags,
                     state.m_LevelData[level_index].m_OriginalWidth,
-                    nullptr,
+                    &transcoder_state,
                     state.m_LevelData[level_index].m_OriginalHeight))
             {
                 return false;
@@ -281,12 +290,94 @@ namespace dmGraphics
                 level_data,
                 state.m_LevelData[level_index].m_Size / state.m_LevelData[level_index].m_BytesPerBlock,
                 transcoder_format,
-                flags);
+                flags,
+                0,
+                &transcoder_state);
         }
 
         return true;
     }
 
+    // Work shared by the calling thread and the transcode workers. The items (one per level and slice)
+    // are claimed in order, so the large levels are started first.
+    struct TranscodeJobContext
+    {
+        const char*                             m_Path;
+        ImageTranscodeState*                    m_States;
+        uint8_t**                               m_Images;
+        uint32_t*                               m_Sizes;
+        basist::transcoder_texture_format       m_TranscoderFormat;
+        dmGraphics::TextureFormat               m_Format;
+        uint32_t                                m_ImageCount;
+        uint32_t                                m_ItemCount;
+        int32_atomic_t                          m_NextItem;
+        int32_atomic_t                          m_Failed;
+        dmMutex::HMutex                         m_Mutex;
+        dmConditionVariable::HConditionVariable m_WorkersDone;
+        uint32_t                                m_WorkersPending;
+    };
+
+    static void TranscodeItems(TranscodeJobContext* ctx)
+    {
+        basist::basisu_transcoder_state transcoder_state;
+
+        while (!dmAtomicGet32(&ctx->m_Failed))
+        {
+            uint32_t item = (uint32_t) dmAtomicIncrement32(&ctx->m_NextItem);
+            if (item >= ctx->m_ItemCount)
+            {
+                break;
+            }
+
+            uint32_t level_index = item / ctx->m_ImageCount;
+            uint32_t slice_index = item % ctx->m_ImageCount;
+            uint8_t* level_data  = ctx->m_Images[level_index] + slice_index * ctx->m_Sizes[level_index];
+
+            if (!TranscodeLevel(ctx->m_Path, ctx->m_States[slice_index], transcoder_state, level_data, level_index, ctx->m_TranscoderFormat, ctx->m_Format))
+            {
+                dmLogError("Transcoding failed on level %u for %s", level_index, ctx->m_Path);
+                dmAtomicStore32(&ctx->m_Failed, 1);
+            }
+        }
+    }
+
+    static int TranscodeJob(void* context, void* data)
+    {
+        DM_PROFILE("TranscodeJob");
+        TranscodeJobContext* ctx = (TranscodeJobContext*) data;
+        TranscodeItems(ctx);
+
+        DM_MUTEX_SCOPED_LOCK(ctx->m_Mutex);
+        ctx->m_WorkersPending--;
+        dmConditionVariable::Signal(ctx->m_WorkersDone);
+        return 0;
+    }
+
+    void InitializeTranscoder(uint8_t thread_count)
+    {
+        basist::basisu_transcoder_init();
+
+        if (g_TranscodeJobThread == 0 && thread_count > 0 && dmJobThread::PlatformHasThreadSupport())
+        {
+            dmJobThread::JobThreadCreationParams job_thread_create_param;
+            job_thread_create_param.m_ThreadCount = dmMath::Min(thread_count, dmJobThread::DM_MAX_JOB_THREAD_COUNT);
+            for (uint32_t i = 0; i < job_thread_create_param.m_ThreadCount; ++i)
+            {
+                job_thread_create_param.m_ThreadNames[i] = "TranscodeThread";
+            }
+            g_TranscodeJobThread = dmJobThread::Create(job_thread_create_param);
+        }
+    }
+
+    void FinalizeTranscoder()
+    {
+        if (g_TranscodeJobThread)
+        {
+            dmJobThread::Destroy(g_TranscodeJobThread);
+            g_TranscodeJobThread = 0;
+        }
+    }
+
     bool Transcode(const char* path, dmGraphics::TextureImage::Image* image, uint8_t image_count, dmGraphics::TextureFormat format,
                     uint8_t** images, uint32_t* sizes, uint32_t* num_transcoded_mips)
     {
@@ -294,6 +385,7 @@ namespace dmGraphics
 
         assert(image_count > 0);
 
+        // Done by InitializeTranscoder, unless the transcoder is used without it (e.g in tests)
         static int first = 1;
         if (first)
         {
@@ -324,6 +416,7 @@ namespace dmGraphics
 
             if (!TranscodeInitializeState(path, image_transcoders[i], ptr, size, transcoder_format))
             {
+                TranscoderDeleteStateArray(image_transcoders, image_count);
                 return false;
             }
 
@@ -333,32 +426,82 @@ namespace dmGraphics
         uint32_t num_levels = dmMath::Min(image_transcoders[0].m_Info.m_total_levels, max_num_images);
         for (uint32_t level_index = 0; level_index < num_levels; ++level_index)
         {
-            uint32_t data_size      = image_transcoders[0].m_LevelData[level_index].m_Size;
-            uint8_t* data_write_ptr = new uint8_t[data_size * image_count];
-
-            images[level_index] = data_write_ptr;
+            uint32_t data_size  = image_transcoders[0].m_LevelData[level_index].m_Size;
+            images[level_index] = new uint8_t[data_size * image_count];
             sizes[level_index]  = data_size;
 
-            bool level_result = true;
-            for (int i = 0; i < image_count && level_result; ++i)
+            for (int i = 0; i < image_count; ++i)
             {
-                assert(image_transcoders[i].m_Info.m_total_levels == num_levels);
-                level_result = TranscodeLevel(path, image_transcoders[i], data_write_ptr, level_index, transcoder_format, format);
-                data_write_ptr += data_size;
+                assert(image_transcoders[i].m_Info.m_total_levels == image_transcoders[0].m_Info.m_total_levels);
             }
+        }
+
+        TranscodeJobContext ctx;
+        ctx.m_Path             = path;
+        ctx.m_States           = image_transcoders;
+        ctx.m_Images           = images;
+        ctx.m_Sizes            = sizes;
+        ctx.m_TranscoderFormat = transcoder_format;
+        ctx.m_Format           = format;
+        ctx.m_ImageCount       = image_count;
+        ctx.m_ItemCount        = num_levels * image_count;
+        ctx.m_NextItem         = 0;
+        ctx.m_Failed           = 0;
+        ctx.m_WorkersPending   = 0;
+
+        // The calling thread transcodes as well, so only use workers if there is more than one item
+        uint32_t num_workers = 0;
+        if (g_TranscodeJobThread)
+        {
+            num_workers = dmMath::Min(dmJobThread::GetWorkerCount(g_TranscodeJobThread), ctx.m_ItemCount - 1);
+        }
 
-            if (!level_result)
+        if (num_workers > 0)
+        {
+            ctx.m_Mutex          = dmMutex::New();
+            ctx.m_WorkersDone    = dmConditionVariable::New();
+            ctx.m_WorkersPending = num_workers;
+
+            for (uint32_t i = 0; i < num_workers; ++i)
             {
-                dmLogError("Transcoding failed on level %d for %s\n", level_index, path);
-                delete[] data_write_ptr;
-                TranscoderDeleteStateArray(image_transcoders, image_count);
-                return false;
+                dmJobThread::PushJob(g_TranscodeJobThread, TranscodeJob, 0, 0, &ctx);
             }
         }
 
-        *num_transcoded_mips = num_levels;
+        TranscodeItems(&ctx);
+
+        if (num_workers > 0)
+        {
+            {
+                DM_PROFILE("WaitForTranscodeJobs");
+                DM_MUTEX_SCOPED_LOCK(ctx.m_Mutex);
+                while (ctx.m_WorkersPending > 0)
+                {
+                    dmConditionVariable::Wait(ctx.m_WorkersDone, ctx.m_Mutex);
+                }
+            }
+
+            // Drains the finished job items, there are no callbacks to run
+            dmJobThread::Update(g_TranscodeJobThread);
+
+            dmConditionVariable::Delete(ctx.m_WorkersDone);
+            dmMutex::Delete(ctx.m_Mutex);
+        }
 
         TranscoderDeleteStateArray(image_transcoders, image_count);
+
+        if (ctx.m_Failed)
+        {
+            for (uint32_t level_index = 0; level_index < num_levels; ++level_index)
+            {
+                delete[] images[level_index];
+                images[level_index] = 0;
+                sizes[level_index]  = 0;
+            }
+            return false;
+        }
+
+        *num_transcoded_mips = num_levels;
         return true;
     }
 }
@@ -33,4 +33,13 @@ namespace dmGraphics
         (void)num_transcoded_mips;
         return false;
     }
+
+    void InitializeTranscoder(uint8_t thread_count)
+    {
+        (void)thread_count;
+    }
+
+    void FinalizeTranscoder()
+    {
+    }
 }
\ No newline at end of file
@@ -73,6 +73,7 @@ PFN_vkWaitForFences vkWaitForFences;
 PFN_vkResetFences vkResetFences;
 PFN_vkCreateCommandPool vkCreateCommandPool;
 PFN_vkDestroyCommandPool vkDestroyCommandPool;
+PFN_vkResetCommandPool vkResetCommandPool;
 PFN_vkAllocateCommandBuffers vkAllocateCommandBuffers;
 PFN_vkBeginCommandBuffer vkBeginCommandBuffer;
 PFN_vkEndCommandBuffer vkEndCommandBuffer;
@@ -115,6 +116,7 @@ PFN_vkDestroyRenderPass vkDestroyRenderPass;
 PFN_vkDestroyFramebuffer vkDestroyFramebuffer;
 PFN_vkDestroyShaderModule vkDestroyShaderModule;
 PFN_vkDestroyPipelineCache vkDestroyPipelineCache;
+PFN_vkGetPipelineCacheData vkGetPipelineCacheData;
 PFN_vkCreateQueryPool vkCreateQueryPool;
 PFN_vkDestroyQueryPool vkDestroyQueryPool;
 PFN_vkGetQueryPoolResults vkGetQueryPoolResults;
@@ -223,6 +225,7 @@ namespace dmGraphics
         vkResetFences = (PFN_vkResetFences) vkGetInstanceProcAddr(vk_instance, "vkResetFences");
         vkCreateCommandPool = (PFN_vkCreateCommandPool) vkGetInstanceProcAddr(vk_instance, "vkCreateCommandPool");
         vkDestroyCommandPool = (PFN_vkDestroyCommandPool) vkGetInstanceProcAddr(vk_instance, "vkDestroyCommandPool");
+        vkResetCommandPool = (PFN_vkResetCommandPool) vkGetInstanceProcAddr(vk_instance, "vkResetCommandPool");
         vkAllocateCommandBuffers = (PFN_vkAllocateCommandBuffers) vkGetInstanceProcAddr(vk_instance, "vkAllocateCommandBuffers");
         vkBeginCommandBuffer = (PFN_vkBeginCommandBuffer) vkGetInstanceProcAddr(vk_instance, "vkBeginCommandBuffer");
         vkEndCommandBuffer = (PFN_vkEndCommandBuffer) vkGetInstanceProcAddr(vk_instance, "vkEndCommandBuffer");
@@ -265,6 +268,7 @@ namespace dmGraphics
         vkDestroyFramebuffer = (PFN_vkDestroyFramebuffer) vkGetInstanceProcAddr(vk_instance, "vkDestroyFramebuffer");
         vkDestroyShaderModule = (PFN_vkDestroyShaderModule) vkGetInstanceProcAddr(vk_instance, "vkDestroyShaderModule");
         vkDestroyPipelineCache = (PFN_vkDestroyPipelineCache) vkGetInstanceProcAddr(vk_instance, "vkDestroyPipelineCache");
+        vkGetPipelineCacheData = (PFN_vkGetPipelineCacheData) vkGetInstanceProcAddr(vk_instance, "vkGetPipelineCacheData");
         vkCreateQueryPool = (PFN_vkCreateQueryPool) vkGetInstanceProcAddr(vk_instance, "vkCreateQueryPool");
         vkDestroyQueryPool = (PFN_vkDestroyQueryPool) vkGetInstanceProcAddr(vk_instance, "vkDestroyQueryPool");
         vkGetQueryPoolResults = (PFN_vkGetQueryPoolResults) vkGetInstanceProcAddr(vk_instance, "vkGetQueryPoolResults");
@@ -12,6 +12,9 @@
 // CONDITIONS OF ANY KIND, either express or implied. See the License for the
 // specific language governing permissions and limitations under the License.
 
+#include <stdlib.h>
+#include <string.h>
+
 #include <dlib/math.h>
 #include <dlib/array.h>
 #include <dlib/profile.h>
@@ -30,6 +33,9 @@
 
 DM_PROPERTY_EXTERN(rmtp_DrawCalls);
 DM_PROPERTY_EXTERN(rmtp_DispatchCalls);
+DM_PROPERTY_EXTERN(rmtp_Graphics);
+DM_PROPERTY_U32(rmtp_VulkanPipelineCreations, 0, FrameReset, "# pipelines created while rendering the frame", &rmtp_Graphics);
+DM_PROPERTY_U32(rmtp_VulkanPipelinePendingDraws, 0, FrameReset, "# draw calls skipped while waiting for a pipeline", &rmtp_Graphics);
 
 namespace dmGraphics
 {
@@ -113,6 +119,10 @@ namespace dmGraphics
         m_VerifyGraphicsCalls     = params.m_VerifyGraphicsCalls;
         m_UseValidationLayers     = params.m_UseValidationLayers;
         m_RenderDocSupport        = params.m_RenderDocSupport;
+        m_ValidateCommandRecording  = params.m_ValidateCommandRecording;
+        m_CommandRecordThreadCount  = params.m_CommandRecordThreadCount;
+        m_AsyncPipelineCompile      = params.m_AsyncPipelineCompile;
+        m_PipelineCachePath         = params.m_PipelineCachePath ? strdup(params.m_PipelineCachePath) : 0;
         m_Window                  = params.m_Window;
         m_Width                   = params.m_Width;
         m_Height                  = params.m_Height;
@@ -335,7 +345,15 @@ namespace dmGraphics
             return false;
         }
 
-        vkCmdEndRenderPass(context->m_MainCommandBuffers[context->m_SwapChain->m_ImageIndex]);
+        if (context->m_CommandRecorder)
+        {
+            VkResult res = FlushDeferredRenderPass(context, context->m_CommandRecorder);
+            CHECK_VK_ERROR(res);
+        }
+        else
+        {
+            vkCmdEndRenderPass(context->m_MainCommandBuffers[context->m_SwapChain->m_ImageIndex]);
+        }
         current_rt->m_IsBound = 0;
         return true;
     }
@@ -386,7 +404,18 @@ namespace dmGraphics
         vk_render_pass_begin_info.clearValueCount     = rt->m_ColorAttachmentCount + 1;
         vk_render_pass_begin_info.pClearValues        = vk_clear_values;
 
-        vkCmdBeginRenderPass(context->m_MainCommandBuffers[context->m_SwapChain->m_ImageIndex], &vk_render_pass_begin_info, VK_SUBPASS_CONTENTS_INLINE);
+        if (context->m_CommandRecorder)
+        {
+            // The pass is begun when it is flushed, since the subpass contents depend on how it is recorded
+            DeferredRenderPass& pass = context->m_CommandRecorder->m_Pass;
+            pass.m_BeginInfo = vk_render_pass_begin_info;
+            memcpy(pass.m_ClearValues, vk_clear_values, sizeof(vk_clear_values));
+            pass.m_Active = 1;
+        }
+        else
+        {
+            vkCmdBeginRenderPass(context->m_MainCommandBuffers[context->m_SwapChain->m_ImageIndex], &vk_render_pass_begin_info, VK_SUBPASS_CONTENTS_INLINE);
+        }
 
         rt->m_IsBound          = 1;
         rt->m_SubPassIndex     = 0;
@@ -730,6 +759,8 @@ namespace dmGraphics
         // Flush all current commands
         SynchronizeDevice(vk_device);
 
+        WaitForPipelineCompiler(context->m_PipelineCompiler);
+
         DestroyMainFrameBuffers(context);
 
         // Destroy main Depth/Stencil buffer
@@ -816,16 +847,14 @@ namespace dmGraphics
         }
     }
 
-    static inline void SetViewportHelper(VkCommandBuffer vk_command_buffer, int32_t x, int32_t y, int32_t width, int32_t height)
+    static inline void GetViewportHelper(VkViewport* vk_viewport, int32_t x, int32_t y, int32_t width, int32_t height)
     {
-        VkViewport vk_viewport;
-        vk_viewport.x        = (float) x;
-        vk_viewport.y        = (float) y;
-        vk_viewport.width    = (float) width;
-        vk_viewport.height   = (float) height;
-        vk_viewport.minDepth = 0.0f;
-        vk_viewport.maxDepth = 1.0f;
-        vkCmdSetViewport(vk_command_buffer, 0, 1, &vk_viewport);
+        vk_viewport->x        = (float) x;
+        vk_viewport->y        = (float) y;
+        vk_viewport->width    = (float) width;
+        vk_viewport->height   = (float) height;
+        vk_viewport->minDepth = 0.0f;
+        vk_viewport->maxDepth = 1.0f;
     }
 
     static bool IsDeviceExtensionSupported(PhysicalDevice* device, const char* ext_name)
@@ -1117,6 +1146,25 @@ namespace dmGraphics
             goto bail;
         }
 
+        if (context->m_CommandRecordThreadCount > 0 || context->m_ValidateCommandRecording)
+        {
+            res = CreateCommandRecorder(context, context->m_CommandRecordThreadCount, context->m_ValidateCommandRecording, &context->m_CommandRecorder);
+            if (res != VK_SUCCESS)
+            {
+                dmLogError("Could not create the Vulkan command recorder, reason: %s", VkResultToStr(res));
+                goto bail;
+            }
+        }
+
+        res = CreatePipelineCompiler(context, context->m_PipelineCachePath, context->m_AsyncPipelineCompile, &context->m_PipelineCompiler);
+        if (res != VK_SUCCESS)
+        {
+            dmLogError("Could not create the Vulkan pipeline cache, reason: %s", VkResultToStr(res));
+            DestroyPipelineCompiler(context, context->m_PipelineCompiler);
+            context->m_PipelineCompiler = 0;
+            goto bail;
+        }
+
         return true;
 bail:
         if (context->m_SwapChain)
@@ -1228,6 +1276,7 @@ bail:
                 context->m_Instance = VK_NULL_HANDLE;
             }
 
+            free(context->m_PipelineCachePath);
             delete context;
             g_VulkanContext = 0x0;
         }
@@ -1296,6 +1345,15 @@ bail:
         res = scratchBuffer->m_DeviceBuffer.MapMemory(vk_device);
         CHECK_VK_ERROR(res);
 
+        if (context->m_CommandRecorder)
+        {
+            res = ResetCommandRecorder(context, context->m_CommandRecorder, frame_ix);
+            CHECK_VK_ERROR(res);
+        }
+
+        // Make the pipelines that finished on the pipeline job thread available for this frame
+        UpdatePipelineCompiler(context->m_PipelineCompiler);
+
         VkCommandBufferBeginInfo vk_command_buffer_begin_info;
 
         vk_command_buffer_begin_info.sType            = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
@@ -1355,6 +1413,13 @@ bail:
         res = vkQueueSubmit(context->m_LogicalDevice.m_GraphicsQueue, 1, &vk_submit_info, current_frame_resource.m_SubmitFence);
         CHECK_VK_ERROR(res);
 
+        if (context->m_ValidateCommandRecording)
+        {
+            // Surface any device errors from the recorded frame before the next one is started
+            res = vkQueueWaitIdle(context->m_LogicalDevice.m_GraphicsQueue);
+            CHECK_VK_ERROR(res);
+        }
+
         VkPresentInfoKHR vk_present_info;
         vk_present_info.sType              = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
         vk_present_info.pNext              = 0;
@@ -1456,6 +1521,25 @@ bail:
             vk_depth_attachment.clearValue.depthStencil.depth   = depth;
         }
 
+        if (context->m_CommandRecorder)
+        {
+            DeferredRenderPass& pass = context->m_CommandRecorder->m_Pass;
+            if (pass.m_Clears.Full())
+            {
+                pass.m_Clears.OffsetCapacity(8);
+            }
+            pass.m_Clears.SetSize(pass.m_Clears.Size() + 1);
+
+            DeferredClear& clear = pass.m_Clears.Back();
+            memcpy(clear.m_Attachments, vk_clear_attachments, sizeof(vk_clear_attachments));
+            clear.m_Rect            = vk_clear_rect;
+            clear.m_AttachmentCount = attachment_count;
+
+            DeferredCommand* command = DeferCommand(context->m_CommandRecorder, DEFERRED_COMMAND_CLEAR);
+            command->m_DataIndex     = pass.m_Clears.Size() - 1;
+            return;
+        }
+
         vkCmdClearAttachments(context->m_MainCommandBuffers[context->m_SwapChain->m_ImageIndex],
             attachment_count, vk_clear_attachments, 1, &vk_clear_rect);
 
@@ -1540,7 +1624,7 @@ bail:
         resource->m_Destroyed = 1;
     }
 
-    static Pipeline* GetOrCreateComputePipeline(VkDevice vk_device, PipelineCache& pipelineCache, Program* program)
+    static Pipeline* GetOrCreateComputePipeline(VkDevice vk_device, VkPipelineCache vk_pipeline_cache, PipelineCache& pipelineCache, Program* program)
     {
         HashState64 pipeline_hash_state;
         dmHashInit64(&pipeline_hash_state, false);
@@ -1553,16 +1637,10 @@ bail:
         {
             Pipeline new_pipeline = {};
 
-            VkResult res = CreateComputePipeline(vk_device, program, &new_pipeline);
+            VkResult res = CreateComputePipeline(vk_device, vk_pipeline_cache, program, &new_pipeline);
             CHECK_VK_ERROR(res);
 
-            if (pipelineCache.Full())
-            {
-                pipelineCache.SetCapacity(32, pipelineCache.Capacity() + 4);
-            }
-
-            pipelineCache.Put(pipeline_hash, new_pipeline);
-            cached_pipeline = pipelineCache.Get(pipeline_hash);
+            cached_pipeline = AddPipelineToCache(pipelineCache, pipeline_hash, new_pipeline);
 
             dmLogDebug("Created new VK Compute Pipeline with hash %llu", (unsigned long long) pipeline_hash);
         }
@@ -1570,29 +1648,33 @@ bail:
         return cached_pipeline;
     }
 
-    static Pipeline* GetOrCreatePipeline(VkDevice vk_device, VkSampleCountFlagBits vk_sample_count,
-        const PipelineState pipelineState, PipelineCache& pipelineCache,
-        Program* program, RenderTarget* rt, VertexDeclaration** vertexDeclaration, uint32_t vertexDeclarationCount)
+    // Returns 0 if the pipeline is being created on the pipeline job thread
+    static Pipeline* GetOrCreatePipeline(VulkanContext* context, VkSampleCountFlagBits vk_sample_count,
+        const PipelineState pipelineState, Program* program, RenderTarget* rt, VertexDeclaration** vertexDeclaration, uint32_t vertexDeclarationCount)
     {
-        HashState64 pipeline_hash_state;
-        dmHashInit64(&pipeline_hash_state, false);
-        dmHashUpdateBuffer64(&pipeline_hash_state, &program->m_Hash, sizeof(program->m_Hash));
-        dmHashUpdateBuffer64(&pipeline_hash_state, &pipelineState, sizeof(pipelineState));
-        dmHashUpdateBuffer64(&pipeline_hash_state, &rt->m_Id, sizeof(rt->m_Id));
-        dmHashUpdateBuffer64(&pipeline_hash_state, &vk_sample_count, sizeof(vk_sample_count));
-
-        for (int i = 0; i < vertexDeclarationCount; ++i)
-        {
-            dmHashUpdateBuffer64(&pipeline_hash_state, &vertexDeclaration[i]->m_PipelineHash, sizeof(vertexDeclaration[i]->m_PipelineHash));
-            dmHashUpdateBuffer64(&pipeline_hash_state, &vertexDeclaration[i]->m_StepFunction, sizeof(vertexDeclaration[i]->m_StepFunction));
-        }
-
-        uint64_t pipeline_hash = dmHashFinal64(&pipeline_hash_state);
+        PipelineCache& pipelineCache = context->m_PipelineCache;
+        PipelineCompiler* compiler   = context->m_PipelineCompiler;
+        uint64_t pipeline_hash       = GetPipelineHash(program->m_Hash, pipelineState, rt->m_Id, vk_sample_count, vertexDeclaration, vertexDeclarationCount);
 
         Pipeline* cached_pipeline = pipelineCache.Get(pipeline_hash);
 
         if (!cached_pipeline)
         {
+            // Only pipelines for the backbuffer are stored, render target ids are not stable between runs
+            if (rt->m_Id == DM_RENDERTARGET_BACKBUFFER_ID)
+            {
+                RecordPipeline(compiler, pipeline_hash, program, pipelineState, vk_sample_count, vertexDeclaration, vertexDeclarationCount);
+            }
+
+            if (CompilePipelineAsync(context, compiler, pipeline_hash, program, pipelineState, vk_sample_count, vertexDeclaration, vertexDeclarationCount, rt))
+            {
+                DM_PROPERTY_ADD_U32(rmtp_VulkanPipelinePendingDraws, 1);
+                return 0;
+            }
+
+            DM_PROFILE("VulkanCreatePipeline");
+            DM_PROPERTY_ADD_U32(rmtp_VulkanPipelineCreations, 1);
+
             Pipeline new_pipeline;
             memset(&new_pipeline, 0, sizeof(new_pipeline));
 
@@ -1601,16 +1683,10 @@ bail:
             vk_scissor.offset.x = 0;
             vk_scissor.offset.y = 0;
 
-            VkResult res = CreateGraphicsPipeline(vk_device, vk_scissor, vk_sample_count, pipelineState, program, vertexDeclaration, vertexDeclarationCount, rt, &new_pipeline);
+            VkResult res = CreateGraphicsPipeline(context->m_LogicalDevice.m_Device, compiler->m_Cache, vk_scissor, vk_sample_count, pipelineState, program, vertexDeclaration, vertexDeclarationCount, rt, &new_pipeline);
             CHECK_VK_ERROR(res);
 
-            if (pipelineCache.Full())
-            {
-                pipelineCache.SetCapacity(32, pipelineCache.Capacity() + 4);
-            }
-
-            pipelineCache.Put(pipeline_hash, new_pipeline);
-            cached_pipeline = pipelineCache.Get(pipeline_hash);
+            cached_pipeline = AddPipelineToCache(pipelineCache, pipeline_hash, new_pipeline);
 
             dmLogDebug("Created new VK Pipeline with hash %llu", (unsigned long long) pipeline_hash);
         }
@@ -2194,11 +2270,60 @@ bail:
         VkResult res               = CommitUniforms(context, vk_command_buffer, vk_device, program_ptr, VK_PIPELINE_BIND_POINT_COMPUTE, scratchBuffer, context->m_DynamicOffsetBuffer, dynamic_alignment);
         CHECK_VK_ERROR(res);
 
-        Pipeline* pipeline = GetOrCreateComputePipeline(vk_device, context->m_PipelineCache, program_ptr);
+        Pipeline* pipeline = GetOrCreateComputePipeline(vk_device, context->m_PipelineCompiler->m_Cache, context->m_PipelineCache, program_ptr);
         vkCmdBindPipeline(vk_command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE, *pipeline);
     }
 
-    static void DrawSetup(VulkanContext* context, VkCommandBuffer vk_command_buffer, ScratchBuffer* scratchBuffer, DeviceBuffer* indexBuffer, Type indexBufferType)
+    static PipelineState GetDrawPipelineState(VulkanContext* context, RenderTarget* current_rt)
+    {
+        PipelineState pipeline_state_draw = context->m_PipelineState;
+
+        // If the culling, or viewport has changed, make sure to flip the
+        // culling flag if we are rendering to the backbuffer.
+        // This is needed because we are rendering with a negative viewport
+        // which means that the face direction is inverted.
+        if (current_rt->m_Id != DM_RENDERTARGET_BACKBUFFER_ID)
+        {
+            if (pipeline_state_draw.m_CullFaceType == FACE_TYPE_BACK)
+            {
+                pipeline_state_draw.m_CullFaceType = FACE_TYPE_FRONT;
+            }
+            else if (pipeline_state_draw.m_CullFaceType == FACE_TYPE_FRONT)
+            {
+                pipeline_state_draw.m_CullFaceType = FACE_TYPE_BACK;
+            }
+        }
+        return pipeline_state_draw;
+    }
+
+    static void GetViewport(VulkanContext* context, RenderTarget* current_rt, VkViewport* vk_viewport)
+    {
+        Viewport& vp = context->m_MainViewport;
+
+        // If we are rendering to the backbuffer, we must invert the viewport on
+        // the y axis. Otherwise we just use the values as-is.
+        // If we don't, all FBO rendering will be upside down.
+        if (current_rt->m_Id == DM_RENDERTARGET_BACKBUFFER_ID)
+        {
+            GetViewportHelper(vk_viewport, vp.m_X, (context->m_WindowHeight - vp.m_Y), vp.m_W, -vp.m_H);
+        }
+        else
+        {
+            GetViewportHelper(vk_viewport, vp.m_X, vp.m_Y, vp.m_W, vp.m_H);
+        }
+    }
+
+    static VkSampleCountFlagBits GetDrawSampleCount(VulkanContext* context, RenderTarget* current_rt)
+    {
+        if (current_rt->m_Id == DM_RENDERTARGET_BACKBUFFER_ID)
+        {
+            return context->m_SwapChain->m_SampleCountFlag;
+        }
+        return VK_SAMPLE_COUNT_1_BIT;
+    }
+
+    // Returns false if the draw call should be skipped, i.e the pipeline for it isn't ready yet
+    static bool DrawSetup(VulkanContext* context, VkCommandBuffer vk_command_buffer, ScratchBuffer* scratchBuffer, DeviceBuffer* indexBuffer, Type indexBufferType)
     {
         RenderTarget* current_rt = GetAssetFromContainer<RenderTarget>(context->m_AssetHandleContainer, context->m_CurrentRenderTarget);
         BeginRenderPass(context, context->m_CurrentRenderTarget);
@@ -2222,6 +2347,15 @@ bail:
             }
         }
 
+        // Get the pipeline for the active draw state
+        Pipeline* pipeline = GetOrCreatePipeline(context, GetDrawSampleCount(context, current_rt),
+            GetDrawPipelineState(context, current_rt), program_ptr, current_rt, vx_declarations, num_vx_buffers);
+
+        if (pipeline == 0x0)
+        {
+            return false;
+        }
+
         PrepareScatchBuffer(context, scratchBuffer, program_ptr);
 
         // Write the uniform data to the descriptors
@@ -2229,59 +2363,17 @@ bail:
         VkResult res = CommitUniforms(context, vk_command_buffer, vk_device, program_ptr, VK_PIPELINE_BIND_POINT_GRAPHICS, scratchBuffer, context->m_DynamicOffsetBuffer, dynamic_alignment);
         CHECK_VK_ERROR(res);
 
-        PipelineState pipeline_state_draw = context->m_PipelineState;
-
-        // If the culling, or viewport has changed, make sure to flip the
-        // culling flag if we are rendering to the backbuffer.
-        // This is needed because we are rendering with a negative viewport
-        // which means that the face direction is inverted.
-        if (current_rt->m_Id != DM_RENDERTARGET_BACKBUFFER_ID)
-        {
-            if (pipeline_state_draw.m_CullFaceType == FACE_TYPE_BACK)
-            {
-                pipeline_state_draw.m_CullFaceType = FACE_TYPE_FRONT;
-            }
-            else if (pipeline_state_draw.m_CullFaceType == FACE_TYPE_FRONT)
-            {
-                pipeline_state_draw.m_CullFaceType = FACE_TYPE_BACK;
-            }
-        }
-
         // Update the viewport
         if (context->m_ViewportChanged)
         {
-            Viewport& vp = context->m_MainViewport;
-
-            // If we are rendering to the backbuffer, we must invert the viewport on
-            // the y axis. Otherwise we just use the values as-is.
-            // If we don't, all FBO rendering will be upside down.
-            if (current_rt->m_Id == DM_RENDERTARGET_BACKBUFFER_ID)
-            {
-                SetViewportHelper(context->m_MainCommandBuffers[context->m_SwapChain->m_ImageIndex],
-                    vp.m_X, (context->m_WindowHeight - vp.m_Y), vp.m_W, -vp.m_H);
-            }
-            else
-            {
-                SetViewportHelper(context->m_MainCommandBuffers[context->m_SwapChain->m_ImageIndex],
-                    vp.m_X, vp.m_Y, vp.m_W, vp.m_H);
-            }
-
+            VkViewport vk_viewport;
+            GetViewport(context, current_rt, &vk_viewport);
+            vkCmdSetViewport(context->m_MainCommandBuffers[context->m_SwapChain->m_ImageIndex], 0, 1, &vk_viewport);
             vkCmdSetScissor(context->m_MainCommandBuffers[context->m_SwapChain->m_ImageIndex], 0, 1, &current_rt->m_Scissor);
 
             context->m_ViewportChanged = 0;
         }
 
-        // Get the pipeline for the active draw state
-        VkSampleCountFlagBits vk_sample_count = VK_SAMPLE_COUNT_1_BIT;
-        if (current_rt->m_Id == DM_RENDERTARGET_BACKBUFFER_ID)
-        {
-            vk_sample_count = context->m_SwapChain->m_SampleCountFlag;
-        }
-
-        Pipeline* pipeline = GetOrCreatePipeline(vk_device, vk_sample_count,
-            pipeline_state_draw, context->m_PipelineCache,
-            program_ptr, current_rt, vx_declarations, num_vx_buffers);
-
         if (pipeline != context->m_CurrentPipeline)
         {
             vkCmdBindPipeline(vk_command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, *pipeline);
@@ -2303,6 +2395,146 @@ bail:
         }
 
         vkCmdBindVertexBuffers(vk_command_buffer, 0, num_vx_buffers, vk_buffers, vk_buffer_offsets);
+        return true;
+    }
+
+    // Captures a draw call into the deferred render pass. Everything that touches shared state (the pipeline cache,
+    // texture layouts and the program uniform data) is resolved here, so the recording threads only read the captured data.
+    static void DeferDraw(VulkanContext* context, DeviceBuffer* index_buffer, Type index_buffer_type, uint32_t first, uint32_t count, uint32_t instance_count, uint32_t base_instance)
+    {
+        BeginRenderPass(context, context->m_CurrentRenderTarget);
+
+        CommandRecorder* recorder = context->m_CommandRecorder;
+        DeferredRenderPass& pass  = recorder->m_Pass;
+        RenderTarget* current_rt  = GetAssetFromContainer<RenderTarget>(context->m_AssetHandleContainer, context->m_CurrentRenderTarget);
+        Program* program_ptr      = context->m_CurrentProgram;
+
+        VertexDeclaration* vx_declarations[MAX_VERTEX_BUFFERS] = {};
+        uint32_t num_vx_declarations                           = 0;
+        for (int i = 0; i < MAX_VERTEX_BUFFERS; ++i)
+        {
+            if (context->m_CurrentVertexBuffer[i] && context->m_CurrentVertexDeclaration[i])
+            {
+                vx_declarations[num_vx_declarations++] = context->m_CurrentVertexDeclaration[i];
+            }
+        }
+
+        Pipeline* pipeline = GetOrCreatePipeline(context, GetDrawSampleCount(context, current_rt),
+            GetDrawPipelineState(context, current_rt), program_ptr, current_rt, vx_declarations, num_vx_declarations);
+
+        if (pipeline == 0x0)
+        {
+            return;
+        }
+
+        DeferredCommand* command = DeferCommand(recorder, index_buffer ? DEFERRED_COMMAND_DRAW_INDEXED : DEFERRED_COMMAND_DRAW);
+        command->m_Pipeline      = *pipeline;
+
+        for (int i = 0; i < MAX_VERTEX_BUFFERS; ++i)
+        {
+            if (context->m_CurrentVertexBuffer[i] && context->m_CurrentVertexDeclaration[i])
+            {
+                command->m_VertexBuffers[command->m_VertexBufferCount]       = context->m_CurrentVertexBuffer[i]->m_Handle.m_Buffer;
+                command->m_VertexBufferOffsets[command->m_VertexBufferCount] = context->m_CurrentVertexBufferOffset[i];
+                command->m_VertexBufferCount++;
+            }
+        }
+
+        if (index_buffer)
+        {
+            assert(index_buffer_type == TYPE_UNSIGNED_SHORT || index_buffer_type == TYPE_UNSIGNED_INT);
+            command->m_IndexBuffer = index_buffer->m_Handle.m_Buffer;
+            command->m_IndexType   = (uint8_t) (index_buffer_type == TYPE_UNSIGNED_INT ? VK_INDEX_TYPE_UINT32 : VK_INDEX_TYPE_UINT16);
+        }
+
+        if (context->m_ViewportChanged)
+        {
+            GetViewport(context, current_rt, &recorder->m_Viewport);
+            recorder->m_Scissor        = current_rt->m_Scissor;
+            context->m_ViewportChanged = 0;
+        }
+
+        command->m_Viewport      = recorder->m_Viewport;
+        command->m_Scissor       = recorder->m_Scissor;
+        command->m_Program       = program_ptr;
+        command->m_First         = first;
+        command->m_Count         = count;
+        command->m_InstanceCount = instance_count;
+        command->m_BaseInstance  = base_instance;
+        command->m_DataIndex     = pass.m_Descriptors.Size();
+
+        if (program_ptr->m_TotalResourcesCount == 0)
+        {
+            return;
+        }
+
+        const uint32_t dynamic_alignment = (uint32_t) context->m_PhysicalDevice.m_Properties.limits.minUniformBufferOffsetAlignment;
+        VkWriteDescriptorSet vk_write_desc_info;
+
+        for (int set = 0; set < program_ptr->m_MaxSet; ++set)
+        {
+            for (int binding = 0; binding < program_ptr->m_MaxBinding; ++binding)
+            {
+                ProgramResourceBinding& pgm_res = program_ptr->m_ResourceBindings[set][binding];
+
+                if (pgm_res.m_Res == 0x0)
+                    continue;
+
+                DeferredDescriptor descriptor;
+                memset(&descriptor, 0, sizeof(descriptor));
+                descriptor.m_Set     = set;
+                descriptor.m_Binding = binding;
+
+                switch(pgm_res.m_Res->m_BindingFamily)
+                {
+                    case ShaderResourceBinding::BINDING_FAMILY_TEXTURE:
+                        UpdateImageDescriptor(context,
+                            context->m_TextureUnits[pgm_res.m_TextureUnit],
+                            pgm_res.m_Res,
+                            descriptor.m_ImageInfo,
+                            vk_write_desc_info);
+                        descriptor.m_Type = vk_write_desc_info.descriptorType;
+                        break;
+                    case ShaderResourceBinding::BINDING_FAMILY_STORAGE_BUFFER:
+                    {
+                        const StorageBufferBinding storage_binding = context->m_CurrentStorageBuffers[pgm_res.m_StorageBufferUnit];
+                        descriptor.m_Type              = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+                        descriptor.m_BufferInfo.buffer = ((DeviceBuffer*) storage_binding.m_Buffer)->m_Handle.m_Buffer;
+                        descriptor.m_BufferInfo.offset = storage_binding.m_BufferOffset;
+                        descriptor.m_BufferInfo.range  = VK_WHOLE_SIZE;
+                    } break;
+                    case ShaderResourceBinding::BINDING_FAMILY_UNIFORM_BUFFER:
+                    {
+                        // The program uniform data changes with the next draw, so keep a copy of it
+                        const uint32_t uniform_size = pgm_res.m_Res->m_BindingInfo.m_BlockSize;
+                        assert(uniform_size > 0);
+
+                        const uint32_t data_offset = pass.m_UniformData.Size();
+                        if (pass.m_UniformData.Remaining() < uniform_size)
+                        {
+                            pass.m_UniformData.OffsetCapacity(dmMath::Max(uniform_size, pass.m_UniformData.Capacity()));
+                        }
+                        pass.m_UniformData.SetSize(data_offset + uniform_size);
+                        memcpy(&pass.m_UniformData[data_offset], &program_ptr->m_UniformData[pgm_res.m_DataOffset], uniform_size);
+
+                        descriptor.m_Type                         = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+                        descriptor.m_Uniform.m_DataOffset         = data_offset;
+                        descriptor.m_Uniform.m_DataSize           = uniform_size;
+                        descriptor.m_Uniform.m_DynamicOffsetIndex = pgm_res.m_DynamicOffsetIndex;
+                        command->m_UniformSize                   += DM_ALIGN(uniform_size, dynamic_alignment);
+                    } break;
+                    case ShaderResourceBinding::BINDING_FAMILY_GENERIC:
+                    default: continue;
+                }
+
+                if (pass.m_Descriptors.Full())
+                {
+                    pass.m_Descriptors.OffsetCapacity(dmMath::Max(64U, pass.m_Descriptors.Capacity()));
+                }
+                pass.m_Descriptors.Push(descriptor);
+                command->m_DescriptorCount++;
+            }
+        }
     }
 
     static void VulkanDrawElements(HContext _context, PrimitiveType prim_type, uint32_t first, uint32_t count, Type type, HIndexBuffer index_buffer, uint32_t instance_count)
@@ -2313,14 +2545,24 @@ bail:
         VulkanContext* context = (VulkanContext*) _context;
 
         assert(context->m_FrameBegun);
-        const uint8_t image_ix = context->m_SwapChain->m_ImageIndex;
-        VkCommandBuffer vk_command_buffer = context->m_MainCommandBuffers[image_ix];
         context->m_PipelineState.m_PrimtiveType = prim_type;
-        DrawSetup(context, vk_command_buffer, &context->m_MainScratchBuffers[image_ix], (DeviceBuffer*) index_buffer, type);
 
         // The 'first' value that comes in is intended to be a byte offset,
         // but vkCmdDrawIndexed only operates with actual offset values into the index buffer
         uint32_t index_offset = first / (type == TYPE_UNSIGNED_SHORT ? 2 : 4);
+
+        if (context->m_CommandRecorder)
+        {
+            DeferDraw(context, (DeviceBuffer*) index_buffer, type, index_offset, count, dmMath::Max((uint32_t) 1, instance_count), 0);
+            return;
+        }
+
+        const uint8_t image_ix = context->m_SwapChain->m_ImageIndex;
+        VkCommandBuffer vk_command_buffer = context->m_MainCommandBuffers[image_ix];
+        if (!DrawSetup(context, vk_command_buffer, &context->m_MainScratchBuffers[image_ix], (DeviceBuffer*) index_buffer, type))
+        {
+            return;
+        }
         vkCmdDrawIndexed(vk_command_buffer, count, dmMath::Max((uint32_t) 1, instance_count), index_offset, 0, 0);
     }
 
@@ -2330,10 +2572,20 @@ bail:
         DM_PROPERTY_ADD_U32(rmtp_DrawCalls, 1);
         VulkanContext* context = (VulkanContext*) _context;
         assert(context->m_FrameBegun);
+        context->m_PipelineState.m_PrimtiveType = prim_type;
+
+        if (context->m_CommandRecorder)
+        {
+            DeferDraw(context, 0, TYPE_BYTE, first, count, dmMath::Max((uint32_t) 1, instance_count), 0);
+            return;
+        }
+
         const uint8_t image_ix = context->m_SwapChain->m_ImageIndex;
         VkCommandBuffer vk_command_buffer = context->m_MainCommandBuffers[image_ix];
-        context->m_PipelineState.m_PrimtiveType = prim_type;
-        DrawSetup(context, vk_command_buffer, &context->m_MainScratchBuffers[image_ix], 0, TYPE_BYTE);
+        if (!DrawSetup(context, vk_command_buffer, &context->m_MainScratchBuffers[image_ix], 0, TYPE_BYTE))
+        {
+            return;
+        }
         vkCmdDraw(vk_command_buffer, count, dmMath::Max((uint32_t) 1, instance_count), first, 0);
     }
 
@@ -2670,10 +2922,18 @@ bail:
         CreateProgramResourceBindings(context, program);
     }
 
-    static HProgram VulkanNewProgram(HContext context, HVertexProgram vertex_program, HFragmentProgram fragment_program)
+    static HProgram VulkanNewProgram(HContext _context, HVertexProgram vertex_program, HFragmentProgram fragment_program)
     {
+        VulkanContext* context = (VulkanContext*) _context;
         Program* program = new Program;
-        CreateGraphicsProgram((VulkanContext*) context, program, (ShaderModule*) vertex_program, (ShaderModule*) fragment_program);
+        CreateGraphicsProgram(context, program, (ShaderModule*) vertex_program, (ShaderModule*) fragment_program);
+
+        // Create the pipelines this program was used with in previous runs, so they don't have to be created mid-frame
+        VkResult res = PrewarmPipelines(context, context->m_PipelineCompiler, program);
+        if (res != VK_SUCCESS)
+        {
+            dmLogWarning("Unable to create cached pipelines for program, reason: %s", VkResultToStr(res));
+        }
         return (HProgram) program;
     }
 
@@ -2691,6 +2951,7 @@ bail:
     {
         assert(program);
         Program* program_ptr = (Program*) program;
+        WaitForPipelineCompiler(g_VulkanContext->m_PipelineCompiler);
         DestroyProgram(context, program_ptr);
         delete program_ptr;
     }
@@ -2702,6 +2963,7 @@ bail:
             return;
         }
 
+        WaitForPipelineCompiler(g_VulkanContext->m_PipelineCompiler);
         DestroyShaderModule(g_VulkanContext->m_LogicalDevice.m_Device, shader);
         DestroyShaderMeta(shader->m_ShaderMeta);
     }
@@ -3438,6 +3700,7 @@ bail:
     {
         RenderTarget* rt = GetAssetFromContainer<RenderTarget>(g_VulkanContext->m_AssetHandleContainer, render_target);
         g_VulkanContext->m_AssetHandleContainer.Release(render_target);
+        WaitForPipelineCompiler(g_VulkanContext->m_PipelineCompiler);
 
         for (int i = 0; i < MAX_BUFFER_COLOR_ATTACHMENTS; ++i)
         {
@@ -3957,6 +4220,13 @@ bail:
         VulkanContext* context = (VulkanContext*)_context;
         VkDevice vk_device = context->m_LogicalDevice.m_Device;
 
+        DestroyCommandRecorder(context, context->m_CommandRecorder);
+        context->m_CommandRecorder = 0;
+
+        // Any pipelines still being created end up in the pipeline cache, so this must happen before it is destroyed
+        DestroyPipelineCompiler(context, context->m_PipelineCompiler);
+        context->m_PipelineCompiler = 0;
+
         context->m_PipelineCache.Iterate(DestroyPipelineCacheCb, context);
 
         DestroyDeviceBuffer(vk_device, &context->m_MainTextureDepthStencil.m_DeviceBuffer.m_Handle);
@@ -4492,9 +4762,16 @@ bail:
         RenderTarget* rt       = GetAssetFromContainer<RenderTarget>(context->m_AssetHandleContainer, render_target);
         if (rt->m_SubPasses != 0)
         {
-            const uint8_t image_ix            = context->m_SwapChain->m_ImageIndex;
-            VkCommandBuffer vk_command_buffer = context->m_MainCommandBuffers[image_ix];
-            vkCmdNextSubpass(vk_command_buffer, VK_SUBPASS_CONTENTS_INLINE);
+            if (context->m_CommandRecorder && context->m_CommandRecorder->m_Pass.m_Active)
+            {
+                DeferCommand(context->m_CommandRecorder, DEFERRED_COMMAND_NEXT_SUBPASS);
+            }
+            else
+            {
+                const uint8_t image_ix            = context->m_SwapChain->m_ImageIndex;
+                VkCommandBuffer vk_command_buffer = context->m_MainCommandBuffers[image_ix];
+                vkCmdNextSubpass(vk_command_buffer, VK_SUBPASS_CONTENTS_INLINE);
+            }
             rt->m_SubPassIndex++;
         }
     }
@@ -4737,14 +5014,24 @@ bail:
         VulkanContext* context = (VulkanContext*) _context;
 
         assert(context->m_FrameBegun);
-        const uint8_t image_ix = context->m_SwapChain->m_ImageIndex;
-        VkCommandBuffer vk_command_buffer = context->m_MainCommandBuffers[image_ix];
         context->m_PipelineState.m_PrimtiveType = prim_type;
-        DrawSetup(context, vk_command_buffer, &context->m_MainScratchBuffers[image_ix], (DeviceBuffer*) index_buffer, type);
 
         // The 'first' value that comes in is intended to be a byte offset,
         // but vkCmdDrawIndexed only operates with actual offset values into the index buffer
         uint32_t index_offset = first / (type == TYPE_UNSIGNED_SHORT ? 2 : 4);
+
+        if (context->m_CommandRecorder)
+        {
+            DeferDraw(context, (DeviceBuffer*) index_buffer, type, index_offset, count, instance_count, base_instance);
+            return;
+        }
+
+        const uint8_t image_ix = context->m_SwapChain->m_ImageIndex;
+        VkCommandBuffer vk_command_buffer = context->m_MainCommandBuffers[image_ix];
+        if (!DrawSetup(context, vk_command_buffer, &context->m_MainScratchBuffers[image_ix], (DeviceBuffer*) index_buffer, type))
+        {
+            return;
+        }
         vkCmdDrawIndexed(vk_command_buffer, count, instance_count, index_offset, 0, base_instance);
     }
 
@@ -4754,10 +5041,20 @@ bail:
         DM_PROPERTY_ADD_U32(rmtp_DrawCalls, 1);
         VulkanContext* context = (VulkanContext*) _context;
         assert(context->m_FrameBegun);
+        context->m_PipelineState.m_PrimtiveType = prim_type;
+
+        if (context->m_CommandRecorder)
+        {
+            DeferDraw(context, 0, TYPE_BYTE, first, count, instance_count, base_instance);
+            return;
+        }
+
         const uint8_t image_ix = context->m_SwapChain->m_ImageIndex;
         VkCommandBuffer vk_command_buffer = context->m_MainCommandBuffers[image_ix];
-        context->m_PipelineState.m_PrimtiveType = prim_type;
-        DrawSetup(context, vk_command_buffer, &context->m_MainScratchBuffers[image_ix], 0, TYPE_BYTE);
+        if (!DrawSetup(context, vk_command_buffer, &context->m_MainScratchBuffers[image_ix], 0, TYPE_BYTE))
+        {
+            return;
+        }
         vkCmdDraw(vk_command_buffer, count, instance_count, first, base_instance);
     }
 
@@ -4909,6 +5206,25 @@ bail:
         memoryBarrier.srcAccessMask   = GetAccessFlags(src_access_flags);
         memoryBarrier.dstAccessMask   = GetAccessFlags(dst_access_flags);
 
+        if (context->m_CommandRecorder && context->m_CommandRecorder->m_Pass.m_Active)
+        {
+            DeferredRenderPass& pass = context->m_CommandRecorder->m_Pass;
+            if (pass.m_Barriers.Full())
+            {
+                pass.m_Barriers.OffsetCapacity(8);
+            }
+
+            DeferredBarrier barrier;
+            barrier.m_Barrier      = memoryBarrier;
+            barrier.m_SrcStageMask = GetPipelineStageFlags(src_stage_flags);
+            barrier.m_DstStageMask = GetPipelineStageFlags(dst_stage_flags);
+            pass.m_Barriers.Push(barrier);
+
+            DeferredCommand* command = DeferCommand(context->m_CommandRecorder, DEFERRED_COMMAND_BARRIER);
+            command->m_DataIndex     = pass.m_Barriers.Size() - 1;
+            return;
+        }
+
         vkCmdPipelineBarrier(
             vk_command_buffer,
             GetPipelineStageFlags(src_stage_flags),
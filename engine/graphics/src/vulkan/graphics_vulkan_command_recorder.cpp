@@ -0,0 +1,606 @@
+// Copyright 2020-2024 The Defold Foundation
+// Copyright 2014-2020 King
+// Copyright 2009-2014 Ragnar Svensson, Christian Murray
+// Licensed under the Defold License version 1.0 (the "License"); you may not use
+// this file except in compliance with the License.
+//
+// You may obtain a copy of the License, together with FAQs at
+// https://www.defold.com/license
+//
+// Unless required by applicable law or agreed to in writing, software distributed
+// under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+// CONDITIONS OF ANY KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations under the License.
+
+#include <assert.h>
+#include <string.h>
+
+#include <dlib/math.h>
+#include <dlib/array.h>
+#include <dlib/align.h>
+#include <dlib/log.h>
+#include <dlib/profile.h>
+
+#include "graphics_vulkan_defines.h"
+#include "graphics_vulkan_private.h"
+
+DM_PROPERTY_EXTERN(rmtp_Graphics);
+DM_PROPERTY_U32(rmtp_VulkanDeferredCommands, 0, FrameReset, "# commands recorded from deferred render passes", &rmtp_Graphics);
+DM_PROPERTY_U32(rmtp_VulkanSecondaryCommandBuffers, 0, FrameReset, "# secondary command buffers recorded", &rmtp_Graphics);
+
+namespace dmGraphics
+{
+    // Render passes with fewer commands than this per thread are recorded on fewer threads,
+    // and passes that would only use one thread are recorded directly into the main command buffer.
+    static const uint32_t MIN_COMMANDS_PER_THREAD = 64;
+
+    // Same initial sizes as the main scratch buffers
+    static const uint16_t RECORDER_DESCRIPTOR_COUNT_PER_POOL = 512;
+    static const uint32_t RECORDER_SCRATCH_BUFFER_SIZE       = 256 * RECORDER_DESCRIPTOR_COUNT_PER_POOL;
+
+    static inline CommandRecorderFrame* GetRecorderFrame(CommandRecorder* recorder, uint32_t thread_ix, uint32_t frame_ix)
+    {
+        return &recorder->m_Frames[thread_ix * recorder->m_FrameCount + frame_ix];
+    }
+
+    VkResult CreateCommandRecorder(VulkanContext* context, uint32_t thread_count, bool validate, CommandRecorder** recorder_out)
+    {
+        VkDevice vk_device = context->m_LogicalDevice.m_Device;
+
+        uint32_t worker_count = dmMath::Min(thread_count, (uint32_t) dmJobThread::DM_MAX_JOB_THREAD_COUNT);
+        if (!dmJobThread::PlatformHasThreadSupport())
+        {
+            worker_count = 0;
+        }
+
+        CommandRecorder* recorder        = new CommandRecorder;
+        recorder->m_JobThread            = 0;
+        recorder->m_Mutex                = dmMutex::New();
+        recorder->m_JobsDone             = dmConditionVariable::New();
+        recorder->m_ThreadCount          = worker_count + 1;
+        recorder->m_FrameCount           = context->m_SwapChain->m_Images.Size();
+        recorder->m_MinCommandsPerThread = validate ? 1 : MIN_COMMANDS_PER_THREAD;
+        recorder->m_JobsPending          = 0;
+        recorder->m_Validate             = validate;
+        memset(&recorder->m_Pass.m_BeginInfo, 0, sizeof(recorder->m_Pass.m_BeginInfo));
+        recorder->m_Pass.m_Active        = 0;
+        memset(&recorder->m_Viewport, 0, sizeof(recorder->m_Viewport));
+        memset(&recorder->m_Scissor, 0, sizeof(recorder->m_Scissor));
+
+        if (worker_count > 0)
+        {
+            dmJobThread::JobThreadCreationParams job_thread_create_param;
+            for (uint32_t i = 0; i < worker_count; ++i)
+            {
+                job_thread_create_param.m_ThreadNames[i] = "VulkanCommandRecorder";
+            }
+            job_thread_create_param.m_ThreadCount = worker_count;
+            recorder->m_JobThread = dmJobThread::Create(job_thread_create_param);
+        }
+
+        recorder->m_Jobs.SetCapacity(recorder->m_ThreadCount);
+        recorder->m_ExecuteList.SetCapacity(recorder->m_ThreadCount);
+
+        const uint32_t num_frames = recorder->m_ThreadCount * recorder->m_FrameCount;
+        recorder->m_Frames.SetCapacity(num_frames);
+        recorder->m_Frames.SetSize(num_frames);
+        memset(recorder->m_Frames.Begin(), 0, sizeof(CommandRecorderFrame) * num_frames);
+
+        VkResult res = VK_SUCCESS;
+        for (uint32_t i = 0; i < num_frames && res == VK_SUCCESS; ++i)
+        {
+            CommandRecorderFrame* frame = &recorder->m_Frames[i];
+
+            // Command pools can only be used from one thread at a time, so each thread gets its own
+            VkCommandPoolCreateInfo vk_create_pool_info;
+            memset(&vk_create_pool_info, 0, sizeof(vk_create_pool_info));
+            vk_create_pool_info.sType            = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+            vk_create_pool_info.queueFamilyIndex = (uint32_t) context->m_SwapChain->m_QueueFamily.m_GraphicsQueueIx;
+            vk_create_pool_info.flags            = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+
+            res = vkCreateCommandPool(vk_device, &vk_create_pool_info, 0, &frame->m_CommandPool);
+            if (res == VK_SUCCESS)
+            {
+                res = CreateDescriptorAllocator(vk_device, RECORDER_DESCRIPTOR_COUNT_PER_POOL, &frame->m_DescriptorAllocator);
+            }
+            if (res == VK_SUCCESS)
+            {
+                res = CreateScratchBuffer(context->m_PhysicalDevice.m_Device, vk_device, RECORDER_SCRATCH_BUFFER_SIZE, true, &frame->m_DescriptorAllocator, &frame->m_ScratchBuffer);
+            }
+        }
+
+        if (res != VK_SUCCESS)
+        {
+            // The frames are zero initialized, so the ones that weren't created yet are skipped
+            DestroyCommandRecorder(context, recorder);
+            return res;
+        }
+
+        *recorder_out = recorder;
+        return VK_SUCCESS;
+    }
+
+    void DestroyCommandRecorder(VulkanContext* context, CommandRecorder* recorder)
+    {
+        if (recorder == 0x0)
+        {
+            return;
+        }
+
+        VkDevice vk_device = context->m_LogicalDevice.m_Device;
+
+        if (recorder->m_JobThread)
+        {
+            dmJobThread::Destroy(recorder->m_JobThread);
+        }
+
+        for (uint32_t i = 0; i < recorder->m_Frames.Size(); ++i)
+        {
+            CommandRecorderFrame* frame = &recorder->m_Frames[i];
+            if (frame->m_CommandPool != VK_NULL_HANDLE)
+            {
+                // Destroying the pool frees the command buffers allocated from it
+                vkDestroyCommandPool(vk_device, frame->m_CommandPool, 0);
+            }
+            frame->m_CommandBuffers.SetCapacity(0);
+            frame->m_ScratchBuffer.m_DeviceBuffer.UnmapMemory(vk_device);
+            DestroyDeviceBuffer(vk_device, &frame->m_ScratchBuffer.m_DeviceBuffer.m_Handle);
+            DestroyDescriptorAllocator(vk_device, &frame->m_DescriptorAllocator);
+        }
+
+        dmConditionVariable::Delete(recorder->m_JobsDone);
+        dmMutex::Delete(recorder->m_Mutex);
+        delete recorder;
+    }
+
+    VkResult ResetCommandRecorder(VulkanContext* context, CommandRecorder* recorder, uint32_t frame_ix)
+    {
+        VkDevice vk_device = context->m_LogicalDevice.m_Device;
+        for (uint32_t i = 0; i < recorder->m_ThreadCount; ++i)
+        {
+            CommandRecorderFrame* frame = GetRecorderFrame(recorder, i, frame_ix);
+            VkResult res = vkResetCommandPool(vk_device, frame->m_CommandPool, 0);
+            if (res != VK_SUCCESS)
+            {
+                return res;
+            }
+            frame->m_CommandBufferIndex = 0;
+
+            ResetScratchBuffer(vk_device, &frame->m_ScratchBuffer);
+            res = frame->m_ScratchBuffer.m_DeviceBuffer.MapMemory(vk_device);
+            if (res != VK_SUCCESS)
+            {
+                return res;
+            }
+        }
+        return VK_SUCCESS;
+    }
+
+    DeferredCommand* DeferCommand(CommandRecorder* recorder, DeferredCommandType type)
+    {
+        dmArray<DeferredCommand>& commands = recorder->m_Pass.m_Commands;
+        if (commands.Full())
+        {
+            commands.OffsetCapacity(dmMath::Max(64U, commands.Capacity()));
+        }
+        commands.SetSize(commands.Size() + 1);
+
+        DeferredCommand* command = &commands.Back();
+        memset(command, 0, sizeof(DeferredCommand));
+        command->m_Type = (uint8_t) type;
+        return command;
+    }
+
+    // Makes sure the scratch buffer can hold 'size' more bytes of uniform data, before any thread starts writing to it.
+    static VkResult PrepareRecorderScratchBuffer(VulkanContext* context, ScratchBuffer* scratch_buffer, uint32_t size)
+    {
+        DeviceBuffer& device_buffer = scratch_buffer->m_DeviceBuffer;
+        if (device_buffer.m_MemorySize - scratch_buffer->m_MappedDataCursor >= size)
+        {
+            return VK_SUCCESS;
+        }
+
+        VkDevice vk_device = context->m_LogicalDevice.m_Device;
+
+        // Descriptors written earlier this frame still reference the old buffer,
+        // so it is destroyed when the frame has been processed.
+        ResourcesToDestroyList* resource_list = context->m_MainResourcesToDestroy[context->m_SwapChain->m_ImageIndex];
+        ResourceToDestroy resource_to_destroy;
+        resource_to_destroy.m_ResourceType = RESOURCE_TYPE_DEVICE_BUFFER;
+        resource_to_destroy.m_DeviceBuffer = device_buffer.m_Handle;
+        device_buffer.UnmapMemory(vk_device);
+
+        if (resource_list->Full())
+        {
+            resource_list->OffsetCapacity(8);
+        }
+        resource_list->Push(resource_to_destroy);
+
+        const uint32_t new_size = dmMath::Max((uint32_t) device_buffer.m_MemorySize * 2, size);
+        VkResult res = CreateScratchBuffer(context->m_PhysicalDevice.m_Device, vk_device, new_size, false, scratch_buffer->m_DescriptorAllocator, scratch_buffer);
+        if (res != VK_SUCCESS)
+        {
+            return res;
+        }
+
+        scratch_buffer->m_MappedDataCursor = 0;
+        return device_buffer.MapMemory(vk_device);
+    }
+
+    static VkResult RecordDeferredCommands(VulkanContext* context, const DeferredRenderPass& pass, VkCommandBuffer vk_command_buffer,
+        ScratchBuffer* scratch_buffer, uint32_t begin, uint32_t end)
+    {
+        const uint32_t max_write_descriptors = MAX_SET_COUNT * MAX_BINDINGS_PER_SET_COUNT;
+        VkWriteDescriptorSet vk_write_descriptors[max_write_descriptors];
+        VkDescriptorBufferInfo vk_write_buffer_descriptors[max_write_descriptors];
+        uint32_t dynamic_offsets[max_write_descriptors];
+
+        VkDevice vk_device               = context->m_LogicalDevice.m_Device;
+        const uint32_t dynamic_alignment = (uint32_t) context->m_PhysicalDevice.m_Properties.limits.minUniformBufferOffsetAlignment;
+        uint8_t* scratch_data            = (uint8_t*) scratch_buffer->m_DeviceBuffer.m_MappedDataPtr;
+
+        // Command buffers don't inherit any dynamic state, so the first draw always sets it
+        VkPipeline bound_pipeline = VK_NULL_HANDLE;
+        const DeferredCommand* last_draw = 0;
+
+        for (uint32_t i = begin; i < end; ++i)
+        {
+            const DeferredCommand& command = pass.m_Commands[i];
+
+            switch(command.m_Type)
+            {
+                case DEFERRED_COMMAND_CLEAR:
+                {
+                    const DeferredClear& clear = pass.m_Clears[command.m_DataIndex];
+                    vkCmdClearAttachments(vk_command_buffer, clear.m_AttachmentCount, clear.m_Attachments, 1, &clear.m_Rect);
+                } break;
+                case DEFERRED_COMMAND_BARRIER:
+                {
+                    const DeferredBarrier& barrier = pass.m_Barriers[command.m_DataIndex];
+                    vkCmdPipelineBarrier(vk_command_buffer, barrier.m_SrcStageMask, barrier.m_DstStageMask, 0, 1, &barrier.m_Barrier, 0, 0, 0, 0);
+                } break;
+                case DEFERRED_COMMAND_DRAW:
+                case DEFERRED_COMMAND_DRAW_INDEXED:
+                {
+                    if (last_draw == 0 || memcmp(&last_draw->m_Viewport, &command.m_Viewport, sizeof(VkViewport)) != 0)
+                    {
+                        vkCmdSetViewport(vk_command_buffer, 0, 1, &command.m_Viewport);
+                    }
+                    if (last_draw == 0 || memcmp(&last_draw->m_Scissor, &command.m_Scissor, sizeof(VkRect2D)) != 0)
+                    {
+                        vkCmdSetScissor(vk_command_buffer, 0, 1, &command.m_Scissor);
+                    }
+                    last_draw = &command;
+
+                    Program* program = command.m_Program;
+                    if (program->m_TotalResourcesCount > 0)
+                    {
+                        VkDescriptorSet* vk_descriptor_sets = 0x0;
+                        VkResult res = scratch_buffer->m_DescriptorAllocator->Allocate(vk_device, program->m_Handle.m_DescriptorSetLayouts,
+                            program->m_Handle.m_DescriptorSetLayoutsCount, program->m_TotalResourcesCount, &vk_descriptor_sets);
+                        if (res != VK_SUCCESS)
+                        {
+                            return res;
+                        }
+
+                        uint32_t buffer_to_write_index = 0;
+                        for (uint32_t j = 0; j < command.m_DescriptorCount; ++j)
+                        {
+                            const DeferredDescriptor& descriptor = pass.m_Descriptors[command.m_DataIndex + j];
+
+                            VkWriteDescriptorSet& vk_write_desc_info = vk_write_descriptors[j];
+                            vk_write_desc_info.sType            = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+                            vk_write_desc_info.pNext            = 0;
+                            vk_write_desc_info.dstSet           = vk_descriptor_sets[descriptor.m_Set];
+                            vk_write_desc_info.dstBinding       = descriptor.m_Binding;
+                            vk_write_desc_info.dstArrayElement  = 0;
+                            vk_write_desc_info.descriptorCount  = 1;
+                            vk_write_desc_info.descriptorType   = descriptor.m_Type;
+                            vk_write_desc_info.pImageInfo       = 0;
+                            vk_write_desc_info.pBufferInfo      = 0;
+                            vk_write_desc_info.pTexelBufferView = 0;
+
+                            if (descriptor.m_Type == VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC)
+                            {
+                                const uint32_t uniform_size_align = DM_ALIGN(descriptor.m_Uniform.m_DataSize, dynamic_alignment);
+                                dynamic_offsets[descriptor.m_Uniform.m_DynamicOffsetIndex] = scratch_buffer->m_MappedDataCursor;
+
+                                memcpy(&scratch_data[scratch_buffer->m_MappedDataCursor], &pass.m_UniformData[descriptor.m_Uniform.m_DataOffset], descriptor.m_Uniform.m_DataSize);
+
+                                VkDescriptorBufferInfo& vk_buffer_info = vk_write_buffer_descriptors[buffer_to_write_index++];
+                                vk_buffer_info.buffer = scratch_buffer->m_DeviceBuffer.m_Handle.m_Buffer;
+                                vk_buffer_info.offset = 0;
+                                vk_buffer_info.range  = uniform_size_align;
+
+                                vk_write_desc_info.pBufferInfo      = &vk_buffer_info;
+                                scratch_buffer->m_MappedDataCursor += uniform_size_align;
+                            }
+                            else if (descriptor.m_Type == VK_DESCRIPTOR_TYPE_STORAGE_BUFFER)
+                            {
+                                vk_write_desc_info.pBufferInfo = &descriptor.m_BufferInfo;
+                            }
+                            else
+                            {
+                                vk_write_desc_info.pImageInfo = &descriptor.m_ImageInfo;
+                            }
+                        }
+
+                        vkUpdateDescriptorSets(vk_device, command.m_DescriptorCount, vk_write_descriptors, 0, 0);
+
+                        vkCmdBindDescriptorSets(vk_command_buffer,
+                            VK_PIPELINE_BIND_POINT_GRAPHICS,
+                            program->m_Handle.m_PipelineLayout,
+                            0,
+                            program->m_Handle.m_DescriptorSetLayoutsCount,
+                            vk_descriptor_sets,
+                            program->m_UniformBufferCount,
+                            dynamic_offsets);
+                    }
+
+                    if (command.m_Pipeline != bound_pipeline)
+                    {
+                        vkCmdBindPipeline(vk_command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, command.m_Pipeline);
+                        bound_pipeline = command.m_Pipeline;
+                    }
+
+                    if (command.m_Type == DEFERRED_COMMAND_DRAW_INDEXED)
+                    {
+                        vkCmdBindIndexBuffer(vk_command_buffer, command.m_IndexBuffer, 0, (VkIndexType) command.m_IndexType);
+                    }
+
+                    vkCmdBindVertexBuffers(vk_command_buffer, 0, command.m_VertexBufferCount, command.m_VertexBuffers, command.m_VertexBufferOffsets);
+
+                    if (command.m_Type == DEFERRED_COMMAND_DRAW_INDEXED)
+                    {
+                        vkCmdDrawIndexed(vk_command_buffer, command.m_Count, command.m_InstanceCount, command.m_First, 0, command.m_BaseInstance);
+                    }
+                    else
+                    {
+                        vkCmdDraw(vk_command_buffer, command.m_Count, command.m_InstanceCount, command.m_First, command.m_BaseInstance);
+                    }
+                } break;
+                default:
+                    assert(0 && "Unexpected deferred command");
+                    break;
+            }
+        }
+
+        return VK_SUCCESS;
+    }
+
+    static VkResult RecordSecondaryCommandBuffer(CommandRecorderJob* job)
+    {
+        const DeferredRenderPass& pass = job->m_Recorder->m_Pass;
+
+        VkCommandBufferInheritanceInfo vk_inheritance_info;
+        memset(&vk_inheritance_info, 0, sizeof(vk_inheritance_info));
+        vk_inheritance_info.sType       = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+        vk_inheritance_info.renderPass  = pass.m_BeginInfo.renderPass;
+        vk_inheritance_info.subpass     = job->m_SubPass;
+        vk_inheritance_info.framebuffer = pass.m_BeginInfo.framebuffer;
+
+        VkCommandBufferBeginInfo vk_command_buffer_begin_info;
+        memset(&vk_command_buffer_begin_info, 0, sizeof(vk_command_buffer_begin_info));
+        vk_command_buffer_begin_info.sType            = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+        vk_command_buffer_begin_info.flags            = VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT | VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+        vk_command_buffer_begin_info.pInheritanceInfo = &vk_inheritance_info;
+
+        VkResult res = vkBeginCommandBuffer(job->m_CommandBuffer, &vk_command_buffer_begin_info);
+        if (res != VK_SUCCESS)
+        {
+            return res;
+        }
+
+        res = RecordDeferredCommands(job->m_Context, pass, job->m_CommandBuffer, job->m_ScratchBuffer, job->m_Begin, job->m_End);
+        VkResult end_res = vkEndCommandBuffer(job->m_CommandBuffer);
+        return res != VK_SUCCESS ? res : end_res;
+    }
+
+    static int RecordCommandsJob(void* context, void* data)
+    {
+        DM_PROFILE("VulkanRecordCommands");
+        CommandRecorderJob* job = (CommandRecorderJob*) data;
+        job->m_Result = RecordSecondaryCommandBuffer(job);
+
+        CommandRecorder* recorder = job->m_Recorder;
+        DM_MUTEX_SCOPED_LOCK(recorder->m_Mutex);
+        if (--recorder->m_JobsPending == 0)
+        {
+            dmConditionVariable::Signal(recorder->m_JobsDone);
+        }
+        return 0;
+    }
+
+    static VkResult GetSecondaryCommandBuffer(VulkanContext* context, CommandRecorderFrame* frame, VkCommandBuffer* vk_command_buffer_out)
+    {
+        if (frame->m_CommandBufferIndex == frame->m_CommandBuffers.Size())
+        {
+            VkCommandBuffer vk_command_buffer;
+            VkResult res = CreateCommandBuffers(context->m_LogicalDevice.m_Device, frame->m_CommandPool, 1, &vk_command_buffer, VK_COMMAND_BUFFER_LEVEL_SECONDARY);
+            if (res != VK_SUCCESS)
+            {
+                return res;
+            }
+
+            if (frame->m_CommandBuffers.Full())
+            {
+                frame->m_CommandBuffers.OffsetCapacity(4);
+            }
+            frame->m_CommandBuffers.Push(vk_command_buffer);
+        }
+        *vk_command_buffer_out = frame->m_CommandBuffers[frame->m_CommandBufferIndex++];
+        return VK_SUCCESS;
+    }
+
+    static uint32_t GetUniformSize(const DeferredRenderPass& pass, uint32_t begin, uint32_t end)
+    {
+        uint32_t size = 0;
+        for (uint32_t i = begin; i < end; ++i)
+        {
+            size += pass.m_Commands[i].m_UniformSize;
+        }
+        return size;
+    }
+
+    // Records the commands of one subpass, either directly into the main command buffer or split
+    // over the recording threads. The secondary command buffers are executed in the order of the
+    // commands they hold, so the result doesn't depend on which thread finishes first.
+    static VkResult RecordSubPass(VulkanContext* context, CommandRecorder* recorder, VkCommandBuffer vk_command_buffer, uint32_t begin, uint32_t end, uint32_t subpass)
+    {
+        DeferredRenderPass& pass = recorder->m_Pass;
+        const uint32_t frame_ix  = context->m_SwapChain->m_ImageIndex;
+        const uint32_t count     = end - begin;
+
+        uint32_t num_threads = dmMath::Min(recorder->m_ThreadCount, count / recorder->m_MinCommandsPerThread);
+        bool use_secondary   = num_threads > 1 || (recorder->m_Validate && count > 0);
+        num_threads          = dmMath::Max(num_threads, 1U);
+
+        VkSubpassContents vk_contents = use_secondary ? VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS : VK_SUBPASS_CONTENTS_INLINE;
+        if (subpass == 0)
+        {
+            pass.m_BeginInfo.pClearValues = pass.m_ClearValues;
+            vkCmdBeginRenderPass(vk_command_buffer, &pass.m_BeginInfo, vk_contents);
+        }
+        else
+        {
+            vkCmdNextSubpass(vk_command_buffer, vk_contents);
+        }
+
+        VkResult res;
+        if (!use_secondary)
+        {
+            ScratchBuffer* scratch_buffer = &context->m_MainScratchBuffers[frame_ix];
+            res = PrepareRecorderScratchBuffer(context, scratch_buffer, GetUniformSize(pass, begin, end));
+            if (res != VK_SUCCESS)
+            {
+                return res;
+            }
+
+            return RecordDeferredCommands(context, pass, vk_command_buffer, scratch_buffer, begin, end);
+        }
+
+        // Split the commands into contiguous chunks, one per thread
+        recorder->m_Jobs.SetSize(num_threads);
+        const uint32_t chunk_size = (count + num_threads - 1) / num_threads;
+        uint32_t chunk_begin = begin;
+        for (uint32_t i = 0; i < num_threads; ++i)
+        {
+            CommandRecorderFrame* frame = GetRecorderFrame(recorder, i, frame_ix);
+            CommandRecorderJob& job     = recorder->m_Jobs[i];
+            job.m_Recorder      = recorder;
+            job.m_Context       = context;
+            job.m_ScratchBuffer = &frame->m_ScratchBuffer;
+            job.m_Result        = VK_SUCCESS;
+            job.m_Begin         = chunk_begin;
+            job.m_End           = dmMath::Min(chunk_begin + chunk_size, end);
+            job.m_UniformSize   = GetUniformSize(pass, job.m_Begin, job.m_End);
+            job.m_SubPass       = subpass;
+            chunk_begin         = job.m_End;
+
+            res = GetSecondaryCommandBuffer(context, frame, &job.m_CommandBuffer);
+            if (res != VK_SUCCESS)
+            {
+                return res;
+            }
+
+            // Grow the scratch buffers up front, the threads only write to them
+            res = PrepareRecorderScratchBuffer(context, job.m_ScratchBuffer, job.m_UniformSize);
+            if (res != VK_SUCCESS)
+            {
+                return res;
+            }
+            job.m_ScratchCursor = job.m_ScratchBuffer->m_MappedDataCursor;
+        }
+
+        recorder->m_JobsPending = num_threads - 1;
+        for (uint32_t i = 1; i < num_threads; ++i)
+        {
+            dmJobThread::PushJob(recorder->m_JobThread, RecordCommandsJob, 0, 0, &recorder->m_Jobs[i]);
+        }
+
+        recorder->m_Jobs[0].m_Result = RecordSecondaryCommandBuffer(&recorder->m_Jobs[0]);
+
+        {
+            DM_PROFILE("VulkanWaitForRecording");
+            DM_MUTEX_SCOPED_LOCK(recorder->m_Mutex);
+            while (recorder->m_JobsPending > 0)
+            {
+                dmConditionVariable::Wait(recorder->m_JobsDone, recorder->m_Mutex);
+            }
+        }
+
+        if (recorder->m_JobThread)
+        {
+            // Drains the finished job items, there are no callbacks to run
+            dmJobThread::Update(recorder->m_JobThread);
+        }
+
+        recorder->m_ExecuteList.SetSize(0);
+        for (uint32_t i = 0; i < num_threads; ++i)
+        {
+            const CommandRecorderJob& job = recorder->m_Jobs[i];
+            if (job.m_Result != VK_SUCCESS)
+            {
+                return job.m_Result;
+            }
+
+            if (recorder->m_Validate)
+            {
+                // The scratch buffers can't grow while the threads are recording, so a thread writing more
+                // uniform data than was reserved for its chunk has written past the end of the buffer.
+                const uint32_t written = job.m_ScratchBuffer->m_MappedDataCursor - job.m_ScratchCursor;
+                if (written > job.m_UniformSize || job.m_ScratchBuffer->m_MappedDataCursor > job.m_ScratchBuffer->m_DeviceBuffer.m_MemorySize)
+                {
+                    dmLogError("Vulkan command recording: commands [%u, %u) wrote %u bytes of uniform data, %u bytes were reserved.",
+                        job.m_Begin, job.m_End, written, job.m_UniformSize);
+                }
+            }
+
+            recorder->m_ExecuteList.Push(job.m_CommandBuffer);
+        }
+
+        vkCmdExecuteCommands(vk_command_buffer, recorder->m_ExecuteList.Size(), recorder->m_ExecuteList.Begin());
+        DM_PROPERTY_ADD_U32(rmtp_VulkanSecondaryCommandBuffers, num_threads);
+        return VK_SUCCESS;
+    }
+
+    VkResult FlushDeferredRenderPass(VulkanContext* context, CommandRecorder* recorder)
+    {
+        DeferredRenderPass& pass = recorder->m_Pass;
+        if (!pass.m_Active)
+        {
+            return VK_SUCCESS;
+        }
+
+        DM_PROFILE(__FUNCTION__);
+
+        VkCommandBuffer vk_command_buffer = context->m_MainCommandBuffers[context->m_SwapChain->m_ImageIndex];
+        const uint32_t num_commands       = pass.m_Commands.Size();
+
+        // The pass is always ended and cleared, so a failed subpass doesn't leak into the next pass
+        VkResult res     = VK_SUCCESS;
+        uint32_t begin   = 0;
+        uint32_t subpass = 0;
+        for (uint32_t i = 0; i <= num_commands && res == VK_SUCCESS; ++i)
+        {
+            if (i == num_commands || pass.m_Commands[i].m_Type == DEFERRED_COMMAND_NEXT_SUBPASS)
+            {
+                res     = RecordSubPass(context, recorder, vk_command_buffer, begin, i, subpass);
+                begin   = i + 1;
+                subpass++;
+            }
+        }
+
+        vkCmdEndRenderPass(vk_command_buffer);
+
+        DM_PROPERTY_ADD_U32(rmtp_VulkanDeferredCommands, num_commands);
+
+        pass.m_Commands.SetSize(0);
+        pass.m_Descriptors.SetSize(0);
+        pass.m_Clears.SetSize(0);
+        pass.m_Barriers.SetSize(0);
+        pass.m_UniformData.SetSize(0);
+        pass.m_Active = 0;
+        return res;
+    }
+}
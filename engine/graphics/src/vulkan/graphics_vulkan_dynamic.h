@@ -70,6 +70,7 @@ extern PFN_vkWaitForFences vkWaitForFences;
 extern PFN_vkResetFences vkResetFences;
 extern PFN_vkCreateCommandPool vkCreateCommandPool;
 extern PFN_vkDestroyCommandPool vkDestroyCommandPool;
+extern PFN_vkResetCommandPool vkResetCommandPool;
 extern PFN_vkAllocateCommandBuffers vkAllocateCommandBuffers;
 extern PFN_vkBeginCommandBuffer vkBeginCommandBuffer;
 extern PFN_vkEndCommandBuffer vkEndCommandBuffer;
@@ -112,6 +113,7 @@ extern PFN_vkDestroyRenderPass vkDestroyRenderPass;
 extern PFN_vkDestroyFramebuffer vkDestroyFramebuffer;
 extern PFN_vkDestroyShaderModule vkDestroyShaderModule;
 extern PFN_vkDestroyPipelineCache vkDestroyPipelineCache;
+extern PFN_vkGetPipelineCacheData vkGetPipelineCacheData;
 extern PFN_vkCreateQueryPool vkCreateQueryPool;
 extern PFN_vkDestroyQueryPool vkDestroyQueryPool;
 extern PFN_vkGetQueryPoolResults vkGetQueryPoolResults;
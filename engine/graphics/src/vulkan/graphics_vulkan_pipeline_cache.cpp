@@ -0,0 +1,516 @@
+// Copyright 2020-2024 The Defold Foundation
+// Copyright 2014-2020 King
+// Copyright 2009-2014 Ragnar Svensson, Christian Murray
+// Licensed under the Defold License version 1.0 (the "License"); you may not use
+// this file except in compliance with the License.
+//
+// You may obtain a copy of the License, together with FAQs at
+// https://www.defold.com/license
+//
+// Unless required by applicable law or agreed to in writing, software distributed
+// under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+// CONDITIONS OF ANY KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations under the License.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <dlib/math.h>
+#include <dlib/array.h>
+#include <dlib/hash.h>
+#include <dlib/log.h>
+#include <dlib/profile.h>
+#include <dlib/dstrings.h>
+#include <dlib/sys.h>
+#include <dlib/time.h>
+
+#include "graphics_vulkan_defines.h"
+#include "graphics_vulkan_private.h"
+
+DM_PROPERTY_EXTERN(rmtp_Graphics);
+DM_PROPERTY_U32(rmtp_VulkanPipelinesCompiled, 0, FrameReset, "# pipelines finished on the pipeline job thread", &rmtp_Graphics);
+
+namespace dmGraphics
+{
+    // Pipeline cache file layout:
+    //   PipelineCacheFileHeader
+    //   PipelineManifestEntry[m_EntryCount]
+    //   uint8_t[m_CacheDataSize]  (data from vkGetPipelineCacheData)
+    const static uint32_t PIPELINE_CACHE_MAGIC   = 0x43505644; // 'DVPC'
+    const static uint32_t PIPELINE_CACHE_VERSION = 1;
+
+    // Upper bound of stored pipelines, so the file can't grow without limits
+    const static uint32_t MAX_MANIFEST_ENTRIES = 4096;
+
+    struct PipelineCacheFileHeader
+    {
+        uint32_t m_Magic;
+        uint32_t m_Version;
+        // Checksum of the payload, i.e the data that follows the header
+        uint64_t m_Checksum;
+        uint32_t m_SizeOfEntry;
+        uint32_t m_EntryCount;
+        uint32_t m_CacheDataSize;
+        // The driver cache is only valid for the device that created it
+        uint32_t m_VendorID;
+        uint32_t m_DeviceID;
+        uint32_t m_DriverVersion;
+        uint8_t  m_PipelineCacheUUID[VK_UUID_SIZE];
+    };
+
+    static void GetVertexDeclarationPointers(PipelineManifestEntry* entry, VertexDeclaration** vertex_declarations)
+    {
+        for (uint32_t i = 0; i < entry->m_VertexDeclarationCount; ++i)
+        {
+            vertex_declarations[i] = &entry->m_VertexDeclarations[i];
+        }
+    }
+
+    static void FillManifestEntry(PipelineManifestEntry* entry, Program* program, const PipelineState& state, VkSampleCountFlagBits vk_sample_count,
+        VertexDeclaration** vertex_declarations, uint32_t vertex_declaration_count)
+    {
+        memset(entry, 0, sizeof(PipelineManifestEntry));
+        entry->m_ProgramHash            = program->m_Hash;
+        entry->m_State                  = state;
+        entry->m_SampleCount            = (uint32_t) vk_sample_count;
+        entry->m_VertexDeclarationCount = vertex_declaration_count;
+
+        for (uint32_t i = 0; i < vertex_declaration_count; ++i)
+        {
+            entry->m_VertexDeclarations[i] = *vertex_declarations[i];
+            // Runtime only (OpenGL) state
+            entry->m_VertexDeclarations[i].m_BoundForProgram     = 0;
+            entry->m_VertexDeclarations[i].m_ModificationVersion = 0;
+        }
+    }
+
+    static bool IsSameDevice(VulkanContext* context, const PipelineCacheFileHeader* header)
+    {
+        const VkPhysicalDeviceProperties& props = context->m_PhysicalDevice.m_Properties;
+        return header->m_VendorID      == props.vendorID &&
+               header->m_DeviceID      == props.deviceID &&
+               header->m_DriverVersion == props.driverVersion &&
+               memcmp(header->m_PipelineCacheUUID, props.pipelineCacheUUID, VK_UUID_SIZE) == 0;
+    }
+
+    static void AddManifestEntry(PipelineCompiler* compiler, uint64_t pipeline_hash, const PipelineManifestEntry& entry)
+    {
+        if (compiler->m_Manifest.Size() >= MAX_MANIFEST_ENTRIES)
+        {
+            return;
+        }
+
+        if (compiler->m_Manifest.Full())
+        {
+            compiler->m_Manifest.OffsetCapacity(64);
+        }
+
+        if (compiler->m_ManifestIndex.Full())
+        {
+            const uint32_t capacity = compiler->m_ManifestIndex.Capacity() + 64;
+            compiler->m_ManifestIndex.SetCapacity(dmMath::Max(2 * capacity / 3, 1U), capacity);
+        }
+
+        compiler->m_ManifestIndex.Put(pipeline_hash, compiler->m_Manifest.Size());
+        compiler->m_Manifest.Push(entry);
+    }
+
+    // Reads the manifest and the driver cache data from disk. Any error just means we start with an empty cache.
+    static void LoadPipelineCacheFile(VulkanContext* context, PipelineCompiler* compiler, dmArray<uint8_t>& cache_data)
+    {
+        FILE* f = fopen(compiler->m_Path, "rb");
+        if (!f)
+        {
+            return;
+        }
+
+        fseek(f, 0, SEEK_END);
+        long file_size = ftell(f);
+        fseek(f, 0, SEEK_SET);
+
+        // Treat a file we can't get the size of as a missing cache
+        if (file_size <= 0)
+        {
+            fclose(f);
+            return;
+        }
+
+        size_t size = (size_t) file_size;
+
+        uint8_t* buffer = (uint8_t*) malloc(size);
+        size_t n_read   = fread(buffer, 1, size, f);
+        fclose(f);
+
+        PipelineCacheFileHeader* header = (PipelineCacheFileHeader*) buffer;
+        const uint8_t* payload          = buffer + sizeof(PipelineCacheFileHeader);
+
+        if (n_read != size || size < sizeof(PipelineCacheFileHeader) ||
+            header->m_Magic != PIPELINE_CACHE_MAGIC ||
+            header->m_Version != PIPELINE_CACHE_VERSION ||
+            header->m_SizeOfEntry != sizeof(PipelineManifestEntry) ||
+            size != sizeof(PipelineCacheFileHeader) + header->m_EntryCount * sizeof(PipelineManifestEntry) + header->m_CacheDataSize)
+        {
+            dmLogWarning("Invalid Vulkan pipeline cache file '%s', it will be recreated.", compiler->m_Path);
+            free(buffer);
+            return;
+        }
+
+        if (dmHashBuffer64(payload, size - sizeof(PipelineCacheFileHeader)) != header->m_Checksum)
+        {
+            dmLogWarning("Corrupt Vulkan pipeline cache file '%s', it will be recreated.", compiler->m_Path);
+            free(buffer);
+            return;
+        }
+
+        PipelineManifestEntry* entries = (PipelineManifestEntry*) payload;
+        VertexDeclaration* vertex_declarations[MAX_VERTEX_BUFFERS];
+        for (uint32_t i = 0; i < header->m_EntryCount; ++i)
+        {
+            PipelineManifestEntry& entry = entries[i];
+            if (entry.m_VertexDeclarationCount > MAX_VERTEX_BUFFERS)
+            {
+                continue;
+            }
+
+            GetVertexDeclarationPointers(&entry, vertex_declarations);
+            uint64_t pipeline_hash = GetPipelineHash(entry.m_ProgramHash, entry.m_State, DM_RENDERTARGET_BACKBUFFER_ID,
+                (VkSampleCountFlagBits) entry.m_SampleCount, vertex_declarations, entry.m_VertexDeclarationCount);
+            if (compiler->m_ManifestIndex.Get(pipeline_hash) == 0)
+            {
+                AddManifestEntry(compiler, pipeline_hash, entry);
+            }
+        }
+
+        // The driver validates the data as well, but there is no point handing it data from another device
+        if (header->m_CacheDataSize > 0 && IsSameDevice(context, header))
+        {
+            cache_data.SetCapacity(header->m_CacheDataSize);
+            cache_data.SetSize(header->m_CacheDataSize);
+            memcpy(cache_data.Begin(), payload + header->m_EntryCount * sizeof(PipelineManifestEntry), header->m_CacheDataSize);
+        }
+
+        free(buffer);
+    }
+
+    static bool WritePipelineCacheFile(VulkanContext* context, PipelineCompiler* compiler, FILE* f, const uint8_t* cache_data, uint32_t cache_data_size)
+    {
+        const VkPhysicalDeviceProperties& props = context->m_PhysicalDevice.m_Properties;
+        const uint32_t entries_size             = compiler->m_Manifest.Size() * sizeof(PipelineManifestEntry);
+
+        HashState64 checksum_state;
+        dmHashInit64(&checksum_state, false);
+        dmHashUpdateBuffer64(&checksum_state, compiler->m_Manifest.Begin(), entries_size);
+        dmHashUpdateBuffer64(&checksum_state, cache_data, cache_data_size);
+
+        PipelineCacheFileHeader header;
+        memset(&header, 0, sizeof(header));
+        header.m_Magic         = PIPELINE_CACHE_MAGIC;
+        header.m_Version       = PIPELINE_CACHE_VERSION;
+        header.m_Checksum      = dmHashFinal64(&checksum_state);
+        header.m_SizeOfEntry   = sizeof(PipelineManifestEntry);
+        header.m_EntryCount    = compiler->m_Manifest.Size();
+        header.m_CacheDataSize = cache_data_size;
+        header.m_VendorID      = props.vendorID;
+        header.m_DeviceID      = props.deviceID;
+        header.m_DriverVersion = props.driverVersion;
+        memcpy(header.m_PipelineCacheUUID, props.pipelineCacheUUID, VK_UUID_SIZE);
+
+        return fwrite(&header, 1, sizeof(header), f) == sizeof(header) &&
+               fwrite(compiler->m_Manifest.Begin(), 1, entries_size, f) == entries_size &&
+               fwrite(cache_data, 1, cache_data_size, f) == cache_data_size;
+    }
+
+    static void SavePipelineCacheFile(VulkanContext* context, PipelineCompiler* compiler)
+    {
+        DM_PROFILE(__FUNCTION__);
+        VkDevice vk_device = context->m_LogicalDevice.m_Device;
+
+        size_t cache_data_size = 0;
+        VkResult res = vkGetPipelineCacheData(vk_device, compiler->m_Cache, &cache_data_size, 0);
+        if (res != VK_SUCCESS)
+        {
+            return;
+        }
+
+        uint8_t* cache_data = (uint8_t*) malloc(dmMath::Max(cache_data_size, (size_t) 1));
+        res = vkGetPipelineCacheData(vk_device, compiler->m_Cache, &cache_data_size, cache_data);
+        if (res != VK_SUCCESS && res != VK_INCOMPLETE)
+        {
+            free(cache_data);
+            return;
+        }
+
+        // Write to a temporary file first, so a crash while writing doesn't leave a broken cache behind
+        char tmp_path[1024];
+        dmSnPrintf(tmp_path, sizeof(tmp_path), "%s.tmp", compiler->m_Path);
+
+        FILE* f = fopen(tmp_path, "wb");
+        if (!f)
+        {
+            dmLogWarning("Unable to write Vulkan pipeline cache file '%s'.", tmp_path);
+            free(cache_data);
+            return;
+        }
+
+        bool written = WritePipelineCacheFile(context, compiler, f, cache_data, (uint32_t) cache_data_size);
+        fclose(f);
+        free(cache_data);
+
+        if (!written || dmSys::Rename(compiler->m_Path, tmp_path) != dmSys::RESULT_OK)
+        {
+            dmLogWarning("Unable to write Vulkan pipeline cache file '%s'.", compiler->m_Path);
+            dmSys::Unlink(tmp_path);
+        }
+    }
+
+    VkResult CreatePipelineCompiler(VulkanContext* context, const char* path, bool async, PipelineCompiler** compiler_out)
+    {
+        PipelineCompiler* compiler = new PipelineCompiler;
+        compiler->m_JobThread      = 0;
+        compiler->m_Cache          = VK_NULL_HANDLE;
+        compiler->m_Path           = path ? strdup(path) : 0;
+        *compiler_out              = compiler;
+
+        dmArray<uint8_t> cache_data;
+        if (compiler->m_Path)
+        {
+            LoadPipelineCacheFile(context, compiler, cache_data);
+        }
+
+        VkPipelineCacheCreateInfo vk_pipeline_cache_create_info;
+        memset(&vk_pipeline_cache_create_info, 0, sizeof(vk_pipeline_cache_create_info));
+        vk_pipeline_cache_create_info.sType           = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+        vk_pipeline_cache_create_info.initialDataSize = cache_data.Size();
+        vk_pipeline_cache_create_info.pInitialData    = cache_data.Begin();
+
+        VkResult res = vkCreatePipelineCache(context->m_LogicalDevice.m_Device, &vk_pipeline_cache_create_info, 0, &compiler->m_Cache);
+        if (res != VK_SUCCESS && cache_data.Size() > 0)
+        {
+            // Don't fail because of stale data, start over with an empty cache
+            vk_pipeline_cache_create_info.initialDataSize = 0;
+            vk_pipeline_cache_create_info.pInitialData    = 0;
+            res = vkCreatePipelineCache(context->m_LogicalDevice.m_Device, &vk_pipeline_cache_create_info, 0, &compiler->m_Cache);
+        }
+
+        if (res != VK_SUCCESS)
+        {
+            return res;
+        }
+
+        if (async && dmJobThread::PlatformHasThreadSupport())
+        {
+            dmJobThread::JobThreadCreationParams job_thread_create_param;
+            job_thread_create_param.m_ThreadNames[0] = "VulkanPipelineCompiler";
+            job_thread_create_param.m_ThreadCount    = 1;
+            compiler->m_JobThread = dmJobThread::Create(job_thread_create_param);
+        }
+
+        return VK_SUCCESS;
+    }
+
+    void DestroyPipelineCompiler(VulkanContext* context, PipelineCompiler* compiler)
+    {
+        if (compiler == 0x0)
+        {
+            return;
+        }
+
+        WaitForPipelineCompiler(compiler);
+
+        if (compiler->m_JobThread)
+        {
+            dmJobThread::Destroy(compiler->m_JobThread);
+        }
+
+        if (compiler->m_Cache != VK_NULL_HANDLE)
+        {
+            if (compiler->m_Path)
+            {
+                SavePipelineCacheFile(context, compiler);
+            }
+            vkDestroyPipelineCache(context->m_LogicalDevice.m_Device, compiler->m_Cache, 0);
+        }
+
+        free(compiler->m_Path);
+        delete compiler;
+    }
+
+    uint64_t GetPipelineHash(uint64_t program_hash, const PipelineState& state, uint16_t render_target_id, VkSampleCountFlagBits vk_sample_count, VertexDeclaration** vertex_declarations, uint32_t vertex_declaration_count)
+    {
+        HashState64 pipeline_hash_state;
+        dmHashInit64(&pipeline_hash_state, false);
+        dmHashUpdateBuffer64(&pipeline_hash_state, &program_hash, sizeof(program_hash));
+        dmHashUpdateBuffer64(&pipeline_hash_state, &state, sizeof(state));
+        dmHashUpdateBuffer64(&pipeline_hash_state, &render_target_id, sizeof(render_target_id));
+        dmHashUpdateBuffer64(&pipeline_hash_state, &vk_sample_count, sizeof(vk_sample_count));
+
+        for (int i = 0; i < vertex_declaration_count; ++i)
+        {
+            dmHashUpdateBuffer64(&pipeline_hash_state, &vertex_declarations[i]->m_PipelineHash, sizeof(vertex_declarations[i]->m_PipelineHash));
+            dmHashUpdateBuffer64(&pipeline_hash_state, &vertex_declarations[i]->m_StepFunction, sizeof(vertex_declarations[i]->m_StepFunction));
+        }
+
+        return dmHashFinal64(&pipeline_hash_state);
+    }
+
+    Pipeline* AddPipelineToCache(PipelineCache& pipeline_cache, uint64_t pipeline_hash, Pipeline pipeline)
+    {
+        if (pipeline_cache.Full())
+        {
+            pipeline_cache.SetCapacity(32, pipeline_cache.Capacity() + 4);
+        }
+
+        pipeline_cache.Put(pipeline_hash, pipeline);
+        return pipeline_cache.Get(pipeline_hash);
+    }
+
+    void RecordPipeline(PipelineCompiler* compiler, uint64_t pipeline_hash, Program* program, const PipelineState& state, VkSampleCountFlagBits vk_sample_count,
+        VertexDeclaration** vertex_declarations, uint32_t vertex_declaration_count)
+    {
+        if (compiler->m_Path == 0 || compiler->m_ManifestIndex.Get(pipeline_hash) != 0)
+        {
+            return;
+        }
+
+        PipelineManifestEntry entry;
+        FillManifestEntry(&entry, program, state, vk_sample_count, vertex_declarations, vertex_declaration_count);
+        AddManifestEntry(compiler, pipeline_hash, entry);
+    }
+
+    static int CompilePipelineJob(void* context, void* data)
+    {
+        DM_PROFILE("VulkanCompilePipeline");
+        PipelineCompileJob* job = (PipelineCompileJob*) data;
+
+        VertexDeclaration* vertex_declarations[MAX_VERTEX_BUFFERS];
+        GetVertexDeclarationPointers(&job->m_Entry, vertex_declarations);
+
+        VkRect2D vk_scissor;
+        vk_scissor.extent   = job->m_RenderTarget->m_Extent;
+        vk_scissor.offset.x = 0;
+        vk_scissor.offset.y = 0;
+
+        job->m_Result = CreateGraphicsPipeline(job->m_Context->m_LogicalDevice.m_Device, job->m_Compiler->m_Cache, vk_scissor,
+            (VkSampleCountFlagBits) job->m_Entry.m_SampleCount, job->m_Entry.m_State, job->m_Program,
+            vertex_declarations, job->m_Entry.m_VertexDeclarationCount, job->m_RenderTarget, &job->m_Pipeline);
+        return 0;
+    }
+
+    static void CompilePipelineJobComplete(void* context, void* data, int result)
+    {
+        PipelineCompileJob* job = (PipelineCompileJob*) data;
+        job->m_Compiler->m_Pending.Erase(job->m_Hash);
+
+        if (job->m_Result == VK_SUCCESS)
+        {
+            AddPipelineToCache(job->m_Context->m_PipelineCache, job->m_Hash, job->m_Pipeline);
+            DM_PROPERTY_ADD_U32(rmtp_VulkanPipelinesCompiled, 1);
+            dmLogDebug("Created new VK Pipeline with hash %llu on the pipeline job thread", (unsigned long long) job->m_Hash);
+        }
+        else
+        {
+            dmLogError("Unable to create Vulkan pipeline with hash %llu (error %d)", (unsigned long long) job->m_Hash, (int) job->m_Result);
+        }
+
+        delete job;
+    }
+
+    bool CompilePipelineAsync(VulkanContext* context, PipelineCompiler* compiler, uint64_t pipeline_hash, Program* program, const PipelineState& state,
+        VkSampleCountFlagBits vk_sample_count, VertexDeclaration** vertex_declarations, uint32_t vertex_declaration_count, RenderTarget* render_target)
+    {
+        if (compiler->m_JobThread == 0)
+        {
+            return false;
+        }
+
+        if (compiler->m_Pending.Get(pipeline_hash))
+        {
+            return true;
+        }
+
+        PipelineCompileJob* job = new PipelineCompileJob;
+        job->m_Compiler     = compiler;
+        job->m_Context      = context;
+        job->m_Program      = program;
+        job->m_RenderTarget = render_target;
+        job->m_Hash         = pipeline_hash;
+        job->m_Pipeline     = VK_NULL_HANDLE;
+        job->m_Result       = VK_SUCCESS;
+        FillManifestEntry(&job->m_Entry, program, state, vk_sample_count, vertex_declarations, vertex_declaration_count);
+
+        if (compiler->m_Pending.Full())
+        {
+            compiler->m_Pending.SetCapacity(32, compiler->m_Pending.Capacity() + 16);
+        }
+        compiler->m_Pending.Put(pipeline_hash, job);
+
+        dmJobThread::PushJob(compiler->m_JobThread, CompilePipelineJob, CompilePipelineJobComplete, 0, job);
+        return true;
+    }
+
+    void UpdatePipelineCompiler(PipelineCompiler* compiler)
+    {
+        if (compiler && compiler->m_JobThread)
+        {
+            dmJobThread::Update(compiler->m_JobThread);
+        }
+    }
+
+    void WaitForPipelineCompiler(PipelineCompiler* compiler)
+    {
+        if (compiler == 0x0 || compiler->m_JobThread == 0 || compiler->m_Pending.Empty())
+        {
+            return;
+        }
+
+        DM_PROFILE(__FUNCTION__);
+        while (!compiler->m_Pending.Empty())
+        {
+            dmJobThread::Update(compiler->m_JobThread);
+            if (!compiler->m_Pending.Empty())
+            {
+                dmTime::Sleep(100);
+            }
+        }
+    }
+
+    VkResult PrewarmPipelines(VulkanContext* context, PipelineCompiler* compiler, Program* program)
+    {
+        // Without the compiler thread the pipelines would be created on the loading thread, which can stall
+        // for a long time on big manifests. The pipeline cache data still makes creating them on first use cheaper.
+        if (compiler->m_JobThread == 0 || compiler->m_Manifest.Empty())
+        {
+            return VK_SUCCESS;
+        }
+
+        DM_PROFILE(__FUNCTION__);
+
+        RenderTarget* main_rt = GetAssetFromContainer<RenderTarget>(context->m_AssetHandleContainer, context->m_MainRenderTarget);
+        VertexDeclaration* vertex_declarations[MAX_VERTEX_BUFFERS];
+
+        for (uint32_t i = 0; i < compiler->m_Manifest.Size(); ++i)
+        {
+            PipelineManifestEntry& entry = compiler->m_Manifest[i];
+
+            // Pipelines recorded with another multisampling setup will never be used
+            if (entry.m_ProgramHash != program->m_Hash || entry.m_SampleCount != (uint32_t) context->m_SwapChain->m_SampleCountFlag)
+            {
+                continue;
+            }
+
+            GetVertexDeclarationPointers(&entry, vertex_declarations);
+            VkSampleCountFlagBits vk_sample_count = (VkSampleCountFlagBits) entry.m_SampleCount;
+            uint64_t pipeline_hash = GetPipelineHash(entry.m_ProgramHash, entry.m_State, main_rt->m_Id, vk_sample_count, vertex_declarations, entry.m_VertexDeclarationCount);
+
+            if (context->m_PipelineCache.Get(pipeline_hash))
+            {
+                continue;
+            }
+
+            CompilePipelineAsync(context, compiler, pipeline_hash, program, entry.m_State, vk_sample_count, vertex_declarations, entry.m_VertexDeclarationCount, main_rt);
+        }
+
+        return VK_SUCCESS;
+    }
+}
@@ -18,6 +18,9 @@
 #include <stdint.h>
 #include <dlib/hashtable.h>
 #include <dlib/opaque_handle_container.h>
+#include <dlib/mutex.h>
+#include <dlib/condition_variable.h>
+#include <dlib/job_thread.h>
 
 #include "../graphics_private.h"
 
@@ -153,6 +156,127 @@ namespace dmGraphics
         uint32_t             m_MappedDataCursor;
     };
 
+    enum DeferredCommandType
+    {
+        DEFERRED_COMMAND_DRAW         = 0,
+        DEFERRED_COMMAND_DRAW_INDEXED = 1,
+        DEFERRED_COMMAND_CLEAR        = 2,
+        DEFERRED_COMMAND_BARRIER      = 3,
+        DEFERRED_COMMAND_NEXT_SUBPASS = 4,
+    };
+
+    // A resource binding captured when the draw was issued. Uniform buffers keep a copy
+    // of the program uniform data, which is written to a scratch buffer when recorded.
+    struct DeferredDescriptor
+    {
+        union
+        {
+            VkDescriptorImageInfo  m_ImageInfo;
+            VkDescriptorBufferInfo m_BufferInfo;
+            struct
+            {
+                uint32_t m_DataOffset;
+                uint32_t m_DataSize;
+                uint32_t m_DynamicOffsetIndex;
+            } m_Uniform;
+        };
+        VkDescriptorType m_Type;
+        uint16_t         m_Set;
+        uint16_t         m_Binding;
+    };
+
+    struct DeferredClear
+    {
+        VkClearAttachment m_Attachments[MAX_BUFFER_COLOR_ATTACHMENTS + 1];
+        VkClearRect       m_Rect;
+        uint32_t          m_AttachmentCount;
+    };
+
+    struct DeferredBarrier
+    {
+        VkMemoryBarrier      m_Barrier;
+        VkPipelineStageFlags m_SrcStageMask;
+        VkPipelineStageFlags m_DstStageMask;
+    };
+
+    struct DeferredCommand
+    {
+        struct Program* m_Program;
+        VkPipeline      m_Pipeline;
+        VkBuffer        m_VertexBuffers[MAX_VERTEX_BUFFERS];
+        VkDeviceSize    m_VertexBufferOffsets[MAX_VERTEX_BUFFERS];
+        VkBuffer        m_IndexBuffer;
+        VkViewport      m_Viewport;
+        VkRect2D        m_Scissor;
+        uint32_t        m_DataIndex;         // First descriptor for draws, index into the clear or barrier lists otherwise
+        uint32_t        m_DescriptorCount;
+        uint32_t        m_UniformSize;       // Aligned scratch buffer size needed by the uniform buffers
+        uint32_t        m_First;
+        uint32_t        m_Count;
+        uint32_t        m_InstanceCount;
+        uint32_t        m_BaseInstance;
+        uint8_t         m_Type;
+        uint8_t         m_VertexBufferCount;
+        uint8_t         m_IndexType;
+    };
+
+    // Everything issued between beginning and ending a render pass when commands are recorded on threads
+    struct DeferredRenderPass
+    {
+        dmArray<DeferredCommand>    m_Commands;
+        dmArray<DeferredDescriptor> m_Descriptors;
+        dmArray<DeferredClear>      m_Clears;
+        dmArray<DeferredBarrier>    m_Barriers;
+        dmArray<uint8_t>            m_UniformData;
+        VkRenderPassBeginInfo       m_BeginInfo;
+        VkClearValue                m_ClearValues[MAX_BUFFER_COLOR_ATTACHMENTS + 1];
+        uint32_t                    m_Active : 1;
+    };
+
+    // Per swap chain image resources of a recording thread
+    struct CommandRecorderFrame
+    {
+        VkCommandPool            m_CommandPool;
+        dmArray<VkCommandBuffer> m_CommandBuffers;
+        uint32_t                 m_CommandBufferIndex;
+        DescriptorAllocator      m_DescriptorAllocator;
+        ScratchBuffer            m_ScratchBuffer;
+    };
+
+    struct CommandRecorderJob
+    {
+        struct CommandRecorder* m_Recorder;
+        struct VulkanContext*   m_Context;
+        ScratchBuffer*          m_ScratchBuffer;
+        VkCommandBuffer         m_CommandBuffer;
+        VkResult                m_Result;
+        uint32_t                m_Begin;
+        uint32_t                m_End;
+        uint32_t                m_UniformSize;   // Scratch buffer bytes reserved for the chunk
+        uint32_t                m_ScratchCursor; // Scratch buffer cursor before recording
+        uint32_t                m_SubPass;
+    };
+
+    struct CommandRecorder
+    {
+        dmJobThread::HContext                   m_JobThread;
+        dmMutex::HMutex                         m_Mutex;
+        dmConditionVariable::HConditionVariable m_JobsDone;
+        // One entry per thread and swap chain image, the main thread records the first chunk of each pass
+        dmArray<CommandRecorderFrame>           m_Frames;
+        dmArray<CommandRecorderJob>             m_Jobs;
+        dmArray<VkCommandBuffer>                m_ExecuteList;
+        DeferredRenderPass                      m_Pass;
+        // Dynamic state captured for the next draw, since it is no longer set on the main command buffer
+        VkViewport                              m_Viewport;
+        VkRect2D                                m_Scissor;
+        uint32_t                                m_ThreadCount;
+        uint32_t                                m_FrameCount;
+        uint32_t                                m_MinCommandsPerThread;
+        int32_t                                 m_JobsPending;
+        uint32_t                                m_Validate : 1;
+    };
+
     struct SubPass
     {
         dmArray<uint8_t> m_ColorAttachments;
@@ -303,6 +427,39 @@ namespace dmGraphics
         const VulkanResourceType GetType();
     };
 
+    // The inputs of a pipeline created for the main render target. These are stored
+    // on disk so the pipeline can be created when its program is loaded next run.
+    struct PipelineManifestEntry
+    {
+        uint64_t          m_ProgramHash;
+        PipelineState     m_State;
+        uint32_t          m_SampleCount;
+        uint32_t          m_VertexDeclarationCount;
+        VertexDeclaration m_VertexDeclarations[MAX_VERTEX_BUFFERS];
+    };
+
+    struct PipelineCompileJob
+    {
+        struct PipelineCompiler* m_Compiler;
+        struct VulkanContext*    m_Context;
+        Program*                 m_Program;
+        struct RenderTarget*     m_RenderTarget;
+        PipelineManifestEntry    m_Entry;
+        uint64_t                 m_Hash;
+        Pipeline                 m_Pipeline;
+        VkResult                 m_Result;
+    };
+
+    struct PipelineCompiler
+    {
+        dmJobThread::HContext               m_JobThread;
+        VkPipelineCache                     m_Cache;
+        char*                               m_Path;
+        dmArray<PipelineManifestEntry>      m_Manifest;
+        dmHashTable64<uint32_t>             m_ManifestIndex; // Pipeline hash -> index into m_Manifest
+        dmHashTable64<PipelineCompileJob*>  m_Pending;       // Pipeline hash -> job, for pipelines being created on the job thread
+    };
+
     struct ResourceToDestroy
     {
         union
@@ -378,6 +535,9 @@ namespace dmGraphics
         dmArray<TextureSampler>            m_TextureSamplers;
         uint32_t*                          m_DynamicOffsetBuffer;
         uint16_t                           m_DynamicOffsetBufferSize;
+        CommandRecorder*                   m_CommandRecorder;
+        PipelineCompiler*                  m_PipelineCompiler;
+        char*                              m_PipelineCachePath;
 
         VkPhysicalDeviceFragmentShaderInterlockFeaturesEXT m_FragmentShaderInterlockFeatures;
 
@@ -428,6 +588,9 @@ namespace dmGraphics
         uint32_t                        m_CullFaceChanged      : 1;
         uint32_t                        m_UseValidationLayers  : 1;
         uint32_t                        m_RenderDocSupport     : 1;
+        uint32_t                        m_ValidateCommandRecording : 1;
+        uint32_t                        m_AsyncPipelineCompile : 1;
+        uint8_t                         m_CommandRecordThreadCount;
     };
 
     // Implemented in graphics_vulkan_context.cpp
@@ -448,7 +611,7 @@ namespace dmGraphics
     // Implemented in graphics_vulkan_device.cpp
     // Create functions
     VkResult CreateFramebuffer(VkDevice vk_device, VkRenderPass vk_render_pass, uint32_t width, uint32_t height, VkImageView* vk_attachments, uint8_t attachmentCount, VkFramebuffer* vk_framebuffer_out);
-    VkResult CreateCommandBuffers(VkDevice vk_device, VkCommandPool vk_command_pool, uint32_t numBuffersToCreate, VkCommandBuffer* vk_command_buffers_out);
+    VkResult CreateCommandBuffers(VkDevice vk_device, VkCommandPool vk_command_pool, uint32_t numBuffersToCreate, VkCommandBuffer* vk_command_buffers_out, VkCommandBufferLevel vk_level = VK_COMMAND_BUFFER_LEVEL_PRIMARY);
     VkResult CreateDescriptorPool(VkDevice vk_device, uint16_t maxDescriptors, VkDescriptorPool* vk_descriptor_pool_out);
     VkResult CreateLogicalDevice(PhysicalDevice* device, const VkSurfaceKHR surface, const QueueFamily queueFamily, const char** deviceExtensions, const uint8_t deviceExtensionCount, const char** validationLayers, const uint8_t validationLayerCount, void* pNext, LogicalDevice* logicalDeviceOut);
     VkResult CreateDescriptorAllocator(VkDevice vk_device, uint32_t descriptor_count, DescriptorAllocator* descriptorAllocator);
@@ -458,8 +621,8 @@ namespace dmGraphics
     VkResult CreateRenderPass(VkDevice vk_device, VkSampleCountFlagBits vk_sample_flags, RenderPassAttachment* colorAttachments, uint8_t numColorAttachments, RenderPassAttachment* depthStencilAttachment, RenderPassAttachment* resolveAttachment, VkRenderPass* renderPassOut);
     VkResult CreateDeviceBuffer(VkPhysicalDevice vk_physical_device, VkDevice vk_device, VkDeviceSize vk_size, VkMemoryPropertyFlags vk_memory_flags, DeviceBuffer* bufferOut);
     VkResult CreateShaderModule(VkDevice vk_device, const void* source, uint32_t sourceSize, VkShaderStageFlagBits stage_flag, ShaderModule* shaderModuleOut);
-    VkResult CreateGraphicsPipeline(VkDevice vk_device, VkRect2D vk_scissor, VkSampleCountFlagBits vk_sample_count, const PipelineState pipelineState, Program* program, VertexDeclaration** vertexDeclarations, uint32_t vertexDeclarationCount, RenderTarget* render_target, Pipeline* pipelineOut);
-    VkResult CreateComputePipeline(VkDevice vk_device, Program* program, Pipeline* pipelineOut);
+    VkResult CreateGraphicsPipeline(VkDevice vk_device, VkPipelineCache vk_pipeline_cache, VkRect2D vk_scissor, VkSampleCountFlagBits vk_sample_count, const PipelineState pipelineState, Program* program, VertexDeclaration** vertexDeclarations, uint32_t vertexDeclarationCount, RenderTarget* render_target, Pipeline* pipelineOut);
+    VkResult CreateComputePipeline(VkDevice vk_device, VkPipelineCache vk_pipeline_cache, Program* program, Pipeline* pipelineOut);
 
     // Destroy functions
     void DestroyDeviceBuffer(VkDevice vk_device, DeviceBuffer::VulkanHandle* handle);
@@ -492,6 +655,28 @@ namespace dmGraphics
     void     FlushResourcesToDestroy(VkDevice vk_device, ResourcesToDestroyList* resource_list);
     void     ResetScratchBuffer(VkDevice vk_device, ScratchBuffer* scratchBuffer);
 
+    // Implemented in graphics_vulkan_command_recorder.cpp
+    //   When enabled, draw calls issued inside a render pass are captured and recorded
+    //   into secondary command buffers on job threads when the render pass ends.
+    VkResult         CreateCommandRecorder(VulkanContext* context, uint32_t thread_count, bool validate, CommandRecorder** recorder_out);
+    void             DestroyCommandRecorder(VulkanContext* context, CommandRecorder* recorder);
+    VkResult         ResetCommandRecorder(VulkanContext* context, CommandRecorder* recorder, uint32_t frame_ix);
+    DeferredCommand* DeferCommand(CommandRecorder* recorder, DeferredCommandType type);
+    VkResult         FlushDeferredRenderPass(VulkanContext* context, CommandRecorder* recorder);
+
+    // Implemented in graphics_vulkan_pipeline_cache.cpp
+    //   Keeps the driver pipeline cache and a manifest of the pipelines used with the main render target on disk,
+    //   and optionally creates new pipelines on a job thread instead of stalling the frame.
+    VkResult  CreatePipelineCompiler(VulkanContext* context, const char* path, bool async, PipelineCompiler** compiler_out);
+    void      DestroyPipelineCompiler(VulkanContext* context, PipelineCompiler* compiler);
+    uint64_t  GetPipelineHash(uint64_t program_hash, const PipelineState& state, uint16_t render_target_id, VkSampleCountFlagBits vk_sample_count, VertexDeclaration** vertex_declarations, uint32_t vertex_declaration_count);
+    Pipeline* AddPipelineToCache(PipelineCache& pipeline_cache, uint64_t pipeline_hash, Pipeline pipeline);
+    void      RecordPipeline(PipelineCompiler* compiler, uint64_t pipeline_hash, Program* program, const PipelineState& state, VkSampleCountFlagBits vk_sample_count, VertexDeclaration** vertex_declarations, uint32_t vertex_declaration_count);
+    bool      CompilePipelineAsync(VulkanContext* context, PipelineCompiler* compiler, uint64_t pipeline_hash, Program* program, const PipelineState& state, VkSampleCountFlagBits vk_sample_count, VertexDeclaration** vertex_declarations, uint32_t vertex_declaration_count, RenderTarget* render_target);
+    void      UpdatePipelineCompiler(PipelineCompiler* compiler);
+    void      WaitForPipelineCompiler(PipelineCompiler* compiler);
+    VkResult  PrewarmPipelines(VulkanContext* context, PipelineCompiler* compiler, Program* program);
+
     // Implemented in graphics_vulkan_swap_chain.cpp
     //   wantedWidth and wantedHeight might be written to, we might not get the
     //   dimensions we wanted from Vulkan.
@@ -23,6 +23,7 @@
 
 #include <ddf/ddf.h>
 
+#include <dlib/array.h>
 #include <dlib/dstrings.h>
 #include <dlib/endian.h>
 #include <dlib/log.h>
@@ -101,6 +102,8 @@ namespace dmLiveUpdate
         return "RESULT_UNDEFINED";
     }
 
+    struct StoreArchiveInfo;
+
     struct LiveUpdateCtx
     {
         LiveUpdateCtx()
@@ -113,6 +116,7 @@ namespace dmLiveUpdate
         dmResourceProvider::HArchive    m_ResourceBaseArchive;  // The "game.arcd" archive
 
         dmJobThread::HContext           m_JobThread;
+        dmArray<StoreArchiveInfo*>      m_VerifyingArchives;    // Archives being stored, for progress reports (main thread only)
 
         // Legacy functionality
         dmResource::HFactory            m_ResourceFactory;      // Resource system factory
@@ -631,7 +635,10 @@ namespace dmLiveUpdate
         const char*                     m_Path; // The path to the zip file
         const char*                     m_Name; // The name of the mount
         void                            (*m_Callback)(const char*, int, void*);
+        void                            (*m_ProgressCallback)(const char*, uint64_t, uint64_t, void*);
         void*                           m_CallbackData;
+        VerifyProgress                  m_Progress;
+        uint64_t                        m_ReportedBytes; // The verified bytes last reported to the progress callback
         int                             m_Priority;
         uint8_t                         m_Verify:1;
     };
@@ -642,7 +649,7 @@ namespace dmLiveUpdate
         if (job->m_Verify)
         {
             const char* public_key_path = dmResource::GetPublicKeyPath(g_LiveUpdate.m_ResourceFactory);
-            dmResource::Result result = dmLiveUpdate::VerifyZipArchive(job->m_Path, public_key_path);
+            dmResource::Result result = dmLiveUpdate::VerifyZipArchive(job->m_Path, public_key_path, &job->m_Progress);
             if (dmResource::RESULT_OK != result)
             {
                 dmLogError("Zip archive verification failed. Archive was not stored. %d %s", result, dmResource::ResultToString(result));
@@ -695,14 +702,39 @@ namespace dmLiveUpdate
     static void StoreArchiveFinished(LiveUpdateCtx* jobctx, StoreArchiveInfo* job, int result)
     {
         dmLogInfo("Finishing archive job: %d", result);
+        for (uint32_t i = 0; i < jobctx->m_VerifyingArchives.Size(); ++i)
+        {
+            if (jobctx->m_VerifyingArchives[i] == job)
+            {
+                jobctx->m_VerifyingArchives.EraseSwap(i);
+                break;
+            }
+        }
         if (job->m_Callback)
             job->m_Callback(job->m_Path, result, job->m_CallbackData);
+        DestroyVerifyProgress(&job->m_Progress);
         free((void*)job->m_Name);
         free((void*)job->m_Path);
         delete job;
     }
 
-    Result StoreArchiveAsync(const char* path, void (*callback)(const char*, int, void*), void* callback_data, const char* mountname, int priority, bool verify_archive)
+    // Called on the main thread, reports the progress of the archives being verified
+    static void UpdateStoreArchiveProgress(LiveUpdateCtx* ctx)
+    {
+        for (uint32_t i = 0; i < ctx->m_VerifyingArchives.Size(); ++i)
+        {
+            StoreArchiveInfo* job = ctx->m_VerifyingArchives[i];
+            uint64_t verified_bytes, total_bytes;
+            GetVerifyProgress(&job->m_Progress, &verified_bytes, &total_bytes);
+            if (total_bytes == 0 || verified_bytes == job->m_ReportedBytes)
+                continue;
+            job->m_ReportedBytes = verified_bytes;
+            job->m_ProgressCallback(job->m_Path, verified_bytes, total_bytes, job->m_CallbackData);
+        }
+    }
+
+    Result StoreArchiveAsync(const char* path, void (*callback)(const char*, int, void*), void (*progress_callback)(const char*, uint64_t, uint64_t, void*),
+                                void* callback_data, const char* mountname, int priority, bool verify_archive)
     {
         if (!IsLiveupdateEnabled())
             return RESULT_NOT_INITIALIZED;
@@ -723,8 +755,18 @@ namespace dmLiveUpdate
         info->m_Name = strdup(mountname);
         info->m_Path = strdup(path);
         info->m_Callback = callback;
+        info->m_ProgressCallback = progress_callback;
         info->m_CallbackData = callback_data;
-        info->m_Verify = true;
+        info->m_Verify = verify_archive;
+        InitVerifyProgress(&info->m_Progress);
+
+        // Added before the job is pushed, as the job may finish immediately (e.g. when there are no threads)
+        if (verify_archive && progress_callback)
+        {
+            if (g_LiveUpdate.m_VerifyingArchives.Full())
+                g_LiveUpdate.m_VerifyingArchives.OffsetCapacity(4);
+            g_LiveUpdate.m_VerifyingArchives.Push(info);
+        }
 
         bool res = dmLiveUpdate::PushAsyncJob((dmJobThread::FProcess)StoreArchiveProcess, (dmJobThread::FCallback)StoreArchiveFinished, (void*)&g_LiveUpdate, info);
         return res == true ? RESULT_OK : RESULT_INVALID_RESOURCE;
@@ -986,6 +1028,7 @@ namespace dmLiveUpdate
             return dmExtension::RESULT_OK;
 
         DM_PROFILE("LiveUpdate");
+        UpdateStoreArchiveProgress(&g_LiveUpdate);
         dmJobThread::Update(g_LiveUpdate.m_JobThread); // Flushes finished async jobs', and calls any Lua callbacks
         return dmExtension::RESULT_OK;
     }
@@ -68,7 +68,9 @@ namespace dmLiveUpdate
 
     // For .zip storage using the "zip" provider
     // Registers an archive (.zip) on disc
-    Result StoreArchiveAsync(const char* path, void (*callback)(const char*, int, void*), void* callback_data, const char* mountname, int priority, bool verify_archive);
+    // The progress callback is optional, and is called with the verified and total bytes while the archive is verified
+    Result StoreArchiveAsync(const char* path, void (*callback)(const char*, int, void*), void (*progress_callback)(const char*, uint64_t, uint64_t, void*),
+                                void* callback_data, const char* mountname, int priority, bool verify_archive);
 
 
     // The new api
@@ -14,11 +14,16 @@
 
 #include "liveupdate_verify.h"
 #include "liveupdate_private.h"
-#include <resource/resource_manifest.h>
 #include <resource/resource_verify.h>
 
+#include <stdlib.h>
+#include <string.h>
+
+#include <dlib/array.h>
+#include <dlib/atomic.h>
 #include <dlib/log.h>
 #include <dlib/memory.h>
+#include <dlib/thread.h>
 #include <dlib/zip.h>
 
 namespace dmLiveUpdate
@@ -59,62 +64,197 @@ namespace dmLiveUpdate
         return data;
     }
 
-    static dmResource::Result VerifyZipEntries(dmResource::Manifest* manifest, dmZip::HZip zip)
+    // The number of threads that verify the resources of an archive. Verification is bound by the hashing,
+    // which runs on one core per thread.
+    static const uint32_t VERIFY_THREAD_COUNT = 4;
+
+    struct VerifyEntriesContext
     {
-        dmResource::Result result = dmResource::RESULT_OK;
-        uint32_t num_entries = dmZip::GetNumEntries(zip);
-        uint32_t entry_data_capacity = 0;
+        dmResource::Manifest* m_Manifest;
+        const char*           m_Path;
+        VerifyProgress*       m_Progress;
+        uint32_t              m_EntryCount;
+        int32_atomic_t        m_NextEntry;
+        int32_atomic_t        m_Result; // The first error, if any
+    };
+
+    void InitVerifyProgress(VerifyProgress* progress)
+    {
+        dmSpinlock::Create(&progress->m_Lock);
+        progress->m_VerifiedBytes = 0;
+        progress->m_TotalBytes    = 0;
+    }
+
+    void DestroyVerifyProgress(VerifyProgress* progress)
+    {
+        dmSpinlock::Destroy(&progress->m_Lock);
+    }
+
+    void GetVerifyProgress(VerifyProgress* progress, uint64_t* verified_bytes, uint64_t* total_bytes)
+    {
+        DM_SPINLOCK_SCOPED_LOCK(progress->m_Lock);
+        *verified_bytes = progress->m_VerifiedBytes;
+        *total_bytes    = progress->m_TotalBytes;
+    }
+
+    static bool IsVerifiedEntry(dmZip::HZip zip)
+    {
+        return !dmZip::IsEntryDir(zip) && strcmp(LIVEUPDATE_ARCHIVE_MANIFEST_FILENAME, dmZip::GetEntryName(zip)) != 0;
+    }
+
+    // Assumes the entry is open
+    static dmResource::Result VerifyZipEntry(dmResource::Manifest* manifest, dmZip::HZip zip, uint8_t** entry_data, uint32_t* entry_data_capacity, uint32_t* entry_size)
+    {
+        const char* entry_name = dmZip::GetEntryName(zip);
+
+        dmZip::Result zr = dmZip::GetEntrySize(zip, entry_size);
+        if (dmZip::RESULT_OK != zr)
+        {
+            dmLogError("Could not get entry size '%s'", entry_name);
+            return dmResource::RESULT_INVALID_DATA;
+        }
+
+        if (*entry_data_capacity < *entry_size)
+        {
+            *entry_data = (uint8_t*)realloc(*entry_data, *entry_size);
+            *entry_data_capacity = *entry_size;
+        }
+
+        zr = dmZip::GetEntryData(zip, *entry_data, *entry_size);
+        if (dmZip::RESULT_OK != zr)
+        {
+            dmLogError("Could not read entry '%s'", entry_name);
+            return dmResource::RESULT_INVALID_DATA;
+        }
+
+        if (*entry_size < sizeof(dmResourceArchive::LiveUpdateResourceHeader))
+        {
+            dmLogError("Skipping resource %s from archive", entry_name);
+            return dmResource::RESULT_OK;
+        }
+
+        // NOTE: The entry "name" is the actual checksum of the contents of that file. It is not a url.
+        // NOTE: We probably need to handle custom files existing in the .zip file that _aren't_ part of the manifest
+        dmResourceArchive::LiveUpdateResource resource(*entry_data, *entry_size);
+        dmResource::Result result = dmResource::VerifyResource(manifest, (const uint8_t*)entry_name, strlen(entry_name), resource.m_Data, resource.m_Count);
+        if (dmResource::RESULT_OK != result)
+        {
+            dmLogError("Failed to verify resource '%s' in archive", entry_name);
+        }
+        return result;
+    }
+
+    // Each thread opens the archive itself, and takes the next unverified entry until all are verified, or one has failed
+    static void VerifyEntriesThread(void* _ctx)
+    {
+        VerifyEntriesContext* ctx = (VerifyEntriesContext*)_ctx;
+
+        dmZip::HZip zip;
+        if (dmZip::RESULT_OK != dmZip::Open(ctx->m_Path, &zip))
+        {
+            dmLogError("Could not open zip file '%s'", ctx->m_Path);
+            dmAtomicCompareStore32(&ctx->m_Result, dmResource::RESULT_IO_ERROR, dmResource::RESULT_OK);
+            return;
+        }
+
         uint8_t* entry_data = 0;
-        for( uint32_t i = 0; i < num_entries && dmResource::RESULT_OK == result; ++i)
+        uint32_t entry_data_capacity = 0;
+        while (dmAtomicGet32(&ctx->m_Result) == dmResource::RESULT_OK)
         {
-            dmZip::Result zr = dmZip::OpenEntry(zip, i);
+            uint32_t i = (uint32_t)dmAtomicIncrement32(&ctx->m_NextEntry);
+            if (i >= ctx->m_EntryCount)
+                break;
 
-            const char* entry_name = dmZip::GetEntryName(zip);
-            if (!dmZip::IsEntryDir(zip) && !(strcmp(LIVEUPDATE_ARCHIVE_MANIFEST_FILENAME, entry_name) == 0))
+            if (dmZip::RESULT_OK != dmZip::OpenEntry(zip, i))
             {
-                // verify resource
-                uint32_t entry_size;
-                zr = dmZip::GetEntrySize(zip, &entry_size);
-                if (dmZip::RESULT_OK != zr)
-                {
-                    dmLogError("Could not get entry size '%s'", entry_name);
-                    dmZip::Close(zip);
-                    free((void*)entry_data);
-                    return dmResource::RESULT_INVALID_DATA;
-                }
+                dmAtomicCompareStore32(&ctx->m_Result, dmResource::RESULT_INVALID_DATA, dmResource::RESULT_OK);
+                break;
+            }
 
-                if (entry_data_capacity < entry_size)
-                {
-                    entry_data = (uint8_t*)realloc(entry_data, entry_size);
-                    entry_data_capacity = entry_size;
-                }
+            uint32_t entry_size = 0;
+            dmResource::Result result = dmResource::RESULT_OK;
+            if (IsVerifiedEntry(zip))
+            {
+                result = VerifyZipEntry(ctx->m_Manifest, zip, &entry_data, &entry_data_capacity, &entry_size);
+            }
+            dmZip::CloseEntry(zip);
 
-                zr = dmZip::GetEntryData(zip, entry_data, entry_size);
+            if (dmResource::RESULT_OK != result)
+            {
+                dmAtomicCompareStore32(&ctx->m_Result, result, dmResource::RESULT_OK);
+                break;
+            }
+
+            if (ctx->m_Progress && entry_size)
+            {
+                DM_SPINLOCK_SCOPED_LOCK(ctx->m_Progress->m_Lock);
+                ctx->m_Progress->m_VerifiedBytes += entry_size;
+            }
+        }
+
+        free((void*)entry_data);
+        dmZip::Close(zip);
+    }
 
-                dmResourceArchive::LiveUpdateResource resource(entry_data, entry_size);
-                if (entry_size >= sizeof(dmResourceArchive::LiveUpdateResourceHeader))
+    dmResource::Result VerifyZipEntries(dmResource::Manifest* manifest, const char* path, VerifyProgress* progress)
+    {
+        dmZip::HZip zip;
+        if (dmZip::RESULT_OK != dmZip::Open(path, &zip))
+        {
+            dmLogError("Could not open zip file '%s'", path);
+            return dmResource::RESULT_RESOURCE_NOT_FOUND;
+        }
+
+        VerifyEntriesContext ctx;
+        ctx.m_Manifest   = manifest;
+        ctx.m_Path       = path;
+        ctx.m_Progress   = progress;
+        ctx.m_EntryCount = dmZip::GetNumEntries(zip);
+        ctx.m_NextEntry  = 0;
+        ctx.m_Result     = dmResource::RESULT_OK;
+
+        if (progress)
+        {
+            // Only the central directory is read here, so this is quick compared to the verification
+            uint64_t total_bytes = 0;
+            for (uint32_t i = 0; i < ctx.m_EntryCount; ++i)
+            {
+                uint32_t entry_size = 0;
+                if (dmZip::RESULT_OK == dmZip::OpenEntry(zip, i))
                 {
-                    // NOTE: The entry "name" is the actual checksum of the contents of that file. It is not a url.
-                    // NOTE: We probably need to handle custom files existing in the .zip file that _aren't_ part of the manifest
-                    result = dmResource::VerifyResource(manifest, (const uint8_t*)entry_name, strlen(entry_name), resource.m_Data, resource.m_Count);
-
-                    if (dmResource::RESULT_OK != result)
-                    {
-                        dmLogError("Failed to verify resource '%s' in archive", entry_name);
-                    }
-                }
-                else {
-                    dmLogError("Skipping resource %s from archive", entry_name);
+                    if (IsVerifiedEntry(zip))
+                        dmZip::GetEntrySize(zip, &entry_size);
+                    dmZip::CloseEntry(zip);
                 }
+                total_bytes += entry_size;
             }
 
-            dmZip::CloseEntry(zip);
+            DM_SPINLOCK_SCOPED_LOCK(progress->m_Lock);
+            progress->m_VerifiedBytes = 0;
+            progress->m_TotalBytes    = total_bytes;
         }
-        free((void*)entry_data);
-        return dmResource::RESULT_OK;
+        dmZip::Close(zip);
+
+#if defined(DM_HAS_THREADS)
+        // The calling thread verifies entries as well
+        dmThread::Thread threads[VERIFY_THREAD_COUNT - 1];
+        for (uint32_t i = 0; i < DM_ARRAY_SIZE(threads); ++i)
+        {
+            threads[i] = dmThread::New(VerifyEntriesThread, 0x20000, &ctx, "lu_verify");
+        }
+        VerifyEntriesThread(&ctx);
+        for (uint32_t i = 0; i < DM_ARRAY_SIZE(threads); ++i)
+        {
+            dmThread::Join(threads[i]);
+        }
+#else
+        VerifyEntriesThread(&ctx);
+#endif
+
+        return (dmResource::Result)dmAtomicGet32(&ctx.m_Result);
     }
 
-    dmResource::Result VerifyZipArchive(const char* path, const char* public_key_path)
+    dmResource::Result VerifyZipArchive(const char* path, const char* public_key_path, VerifyProgress* progress)
     {
         dmLogInfo("Verifying archive '%s'", path);
 
@@ -161,7 +301,7 @@ namespace dmLiveUpdate
 
         // TODO: What to do here. It is now ok for a liveupdate manifest/archive to not contain all the resources
         //      * We can require the manifest to only contain entries for the files in the archive
-        result = VerifyZipEntries(manifest, zip);
+        result = VerifyZipEntries(manifest, path, progress);
         if (dmResource::RESULT_OK != result)
         {
             dmLogError("Manifest references non existing resources");
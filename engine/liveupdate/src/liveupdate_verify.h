@@ -17,10 +17,28 @@
 
 #include "liveupdate.h"
 #include <resource/resource.h>
+#include <resource/resource_manifest.h>
+#include <dlib/spinlock.h>
 
 namespace dmLiveUpdate
 {
-    dmResource::Result VerifyZipArchive(const char* path, const char* public_key_path);
+    // The progress of a verification, updated by the verifying threads
+    struct VerifyProgress
+    {
+        dmSpinlock::Spinlock m_Lock;
+        uint64_t             m_VerifiedBytes;
+        uint64_t             m_TotalBytes;    // 0 until the archive has been opened
+    };
+
+    void InitVerifyProgress(VerifyProgress* progress);
+    void DestroyVerifyProgress(VerifyProgress* progress);
+    void GetVerifyProgress(VerifyProgress* progress, uint64_t* verified_bytes, uint64_t* total_bytes);
+
+    // The progress may be 0
+    dmResource::Result VerifyZipArchive(const char* path, const char* public_key_path, VerifyProgress* progress);
+
+    // Verifies the resources in the archive on several threads. Used by VerifyZipArchive, and in unit tests
+    dmResource::Result VerifyZipEntries(dmResource::HManifest manifest, const char* path, VerifyProgress* progress);
 }
 
 #endif // DM_LIVEUPDATE_VERIFY_H
@@ -195,12 +195,56 @@ namespace dmLiveUpdate
 
     //  ************************************
 
-    static void Callback_StoreArchive(const char* path, int result, void* _cbk)
+    struct StoreArchiveCallbacks
     {
-        dmScript::LuaCallbackInfo* cbk = (dmScript::LuaCallbackInfo*)_cbk;
+        dmScript::LuaCallbackInfo* m_Callback;
+        dmScript::LuaCallbackInfo* m_ProgressCallback; // May be 0
+    };
+
+    static void DestroyStoreArchiveCallbacks(StoreArchiveCallbacks* cbks)
+    {
+        dmScript::DestroyCallback(cbks->m_Callback);
+        if (cbks->m_ProgressCallback)
+            dmScript::DestroyCallback(cbks->m_ProgressCallback);
+        delete cbks;
+    }
+
+    static void Callback_StoreArchiveProgress(const char* path, uint64_t verified_bytes, uint64_t total_bytes, void* _cbks)
+    {
+        StoreArchiveCallbacks* cbks = (StoreArchiveCallbacks*)_cbks;
+        dmScript::LuaCallbackInfo* cbk = cbks->m_ProgressCallback;
+
+        if (!cbk || !dmScript::IsCallbackValid(cbk))
+            return;
+
+        lua_State* L = dmScript::GetCallbackLuaContext(cbk);
+        DM_LUA_STACK_CHECK(L, 0)
+
+        if (!dmScript::SetupCallback(cbk))
+        {
+            dmLogError("Failed to setup callback");
+            return;
+        }
+
+        lua_pushstring(L, path);
+        lua_pushnumber(L, (lua_Number)verified_bytes);
+        lua_pushnumber(L, (lua_Number)total_bytes);
+
+        dmScript::PCall(L, 4, 0); // instance + 3
+
+        dmScript::TeardownCallback(cbk);
+    }
+
+    static void Callback_StoreArchive(const char* path, int result, void* _cbks)
+    {
+        StoreArchiveCallbacks* cbks = (StoreArchiveCallbacks*)_cbks;
+        dmScript::LuaCallbackInfo* cbk = cbks->m_Callback;
 
         if (!dmScript::IsCallbackValid(cbk))
+        {
+            DestroyStoreArchiveCallbacks(cbks);
             return;
+        }
 
         lua_State* L = dmScript::GetCallbackLuaContext(cbk);
         DM_LUA_STACK_CHECK(L, 0)
@@ -208,6 +252,7 @@ namespace dmLiveUpdate
         if (!dmScript::SetupCallback(cbk))
         {
             dmLogError("Failed to setup callback");
+            DestroyStoreArchiveCallbacks(cbks);
             return;
         }
 
@@ -217,7 +262,7 @@ namespace dmLiveUpdate
         dmScript::PCall(L, 3, 0); // instance + 2
 
         dmScript::TeardownCallback(cbk);
-        dmScript::DestroyCallback(cbk);
+        DestroyStoreArchiveCallbacks(cbks);
     }
 
     static int Resource_StoreArchive(lua_State* L)
@@ -227,7 +272,9 @@ namespace dmLiveUpdate
 
         const char* path = luaL_checkstring(L, 1);
 
-        dmScript::LuaCallbackInfo* cbk = dmScript::CreateCallback(L, 2);
+        StoreArchiveCallbacks* cbks = new StoreArchiveCallbacks;
+        cbks->m_Callback = dmScript::CreateCallback(L, 2);
+        cbks->m_ProgressCallback = 0;
 
         bool verify_archive = true;
         if (top > 2 && !lua_isnil(L, 3)) {
@@ -240,6 +287,10 @@ namespace dmLiveUpdate
                 {
                     verify_archive = lua_toboolean(L, -1);
                 }
+                else if (strcmp(attr, "progress") == 0 && lua_isfunction(L, -1) && !cbks->m_ProgressCallback)
+                {
+                    cbks->m_ProgressCallback = dmScript::CreateCallback(L, lua_gettop(L));
+                }
                 lua_pop(L, 1);
             }
             lua_pop(L, 1);
@@ -248,11 +299,12 @@ namespace dmLiveUpdate
         const char* name = LIVEUPDATE_LEGACY_MOUNT_NAME;
         int priority = LIVEUPDATE_LEGACY_MOUNT_PRIORITY;
 
-        dmLiveUpdate::Result res = dmLiveUpdate::StoreArchiveAsync(path, Callback_StoreArchive, cbk, name, priority, verify_archive);
+        dmLiveUpdate::Result res = dmLiveUpdate::StoreArchiveAsync(path, Callback_StoreArchive, cbks->m_ProgressCallback ? Callback_StoreArchiveProgress : 0,
+                                                                    cbks, name, priority, verify_archive);
         if (dmLiveUpdate::RESULT_OK != res)
         {
             dmLogError("The liveupdate archive '%s' could not be stored: %s", path, dmLiveUpdate::ResultToString(res));
-            dmScript::DestroyCallback(cbk);
+            DestroyStoreArchiveCallbacks(cbks);
         }
         return 0;
     }
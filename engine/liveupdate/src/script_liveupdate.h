@@ -158,6 +158,8 @@ namespace dmLiveUpdate
  *
  * Stores a zip file and uses it for live update content. The contents of the
  * zip file will be verified against the manifest to ensure file integrity.
+ * If any resource doesn't match its hash in the manifest, the archive is not stored
+ * and the callback gets a failed status.
  * It is possible to opt out of the resource verification using an option passed
  * to this function.
  * The path is stored in the (internal) live update location.
@@ -176,7 +178,8 @@ namespace dmLiveUpdate
  *
  * @param [options] [type:table] optional table with extra parameters. Supported entries:
  *
- * - [type:boolean] `verify`: if archive should be verified as well as stored (defaults to true)
+ * - [type:boolean] `verify`: if archive should be verified as well as stored (defaults to true). If false, neither the manifest signature nor the resources are checked
+ * - [type:function(self, path, verified_bytes, total_bytes)] `progress`: called once per frame while the archive is being verified, if more of it has been verified since the last call
  *
  * @examples
  *
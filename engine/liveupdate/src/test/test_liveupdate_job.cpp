@@ -22,6 +22,12 @@
 #include <dlib/log.h>
 #include <dlib/time.h>
 #include <dlib/job_thread.h>
+#include <dlib/memory.h>
+#include <dlib/testutil.h>
+#include <dlib/zip.h>
+#include <resource/resource_manifest.h>
+
+#include "../liveupdate_verify.h"
 
 #if defined(DM_USE_SINGLE_THREAD)
 class AsyncTestMultiThread : public jc_test_base_class
@@ -128,6 +134,74 @@ TEST_F(AsyncTestSingleThread, TestJobs)
     delete[] contexts;
 }
 
+static dmResource::HManifest LoadZipManifest(const char* path)
+{
+    dmZip::HZip zip;
+    if (dmZip::RESULT_OK != dmZip::Open(path, &zip))
+        return 0;
+
+    dmResource::HManifest manifest = 0;
+    uint32_t size = 0;
+    if (dmZip::RESULT_OK == dmZip::OpenEntry(zip, "liveupdate.game.dmanifest") && dmZip::RESULT_OK == dmZip::GetEntrySize(zip, &size))
+    {
+        uint8_t* data = 0;
+        dmMemory::AlignedMalloc((void**)&data, 16, size);
+        if (dmZip::RESULT_OK == dmZip::GetEntryData(zip, data, size))
+            dmResource::LoadManifestFromBuffer(data, size, &manifest);
+        dmMemory::AlignedFree(data);
+        dmZip::CloseEntry(zip);
+    }
+    dmZip::Close(zip);
+    return manifest;
+}
+
+TEST(LiveUpdateVerify, VerifyZipEntries)
+{
+    char path[1024];
+    dmTestUtil::MakeHostPath(path, sizeof(path), "src/test/data/defold.resourcepack.zip");
+
+    dmResource::HManifest manifest = LoadZipManifest(path);
+    ASSERT_NE((dmResource::HManifest)0, manifest);
+
+    dmLiveUpdate::VerifyProgress progress;
+    dmLiveUpdate::InitVerifyProgress(&progress);
+
+    ASSERT_EQ(dmResource::RESULT_OK, dmLiveUpdate::VerifyZipEntries(manifest, path, &progress));
+
+    // All resources are verified, but not the manifest itself
+    uint64_t verified_bytes, total_bytes;
+    dmLiveUpdate::GetVerifyProgress(&progress, &verified_bytes, &total_bytes);
+    ASSERT_EQ(1969U, total_bytes);
+    ASSERT_EQ(total_bytes, verified_bytes);
+
+    // The progress is optional
+    ASSERT_EQ(dmResource::RESULT_OK, dmLiveUpdate::VerifyZipEntries(manifest, path, 0));
+
+    ASSERT_EQ(dmResource::RESULT_RESOURCE_NOT_FOUND, dmLiveUpdate::VerifyZipEntries(manifest, "src/test/data/does_not_exist.zip", &progress));
+
+    dmLiveUpdate::DestroyVerifyProgress(&progress);
+    dmResource::DeleteManifest(manifest);
+}
+
+TEST(LiveUpdateVerify, VerifyZipEntriesCorrupted)
+{
+    // Same archive, but the data of one resource doesn't match the hash it is named after
+    char path[1024];
+    dmTestUtil::MakeHostPath(path, sizeof(path), "src/test/data/corrupt.resourcepack.zip");
+
+    dmResource::HManifest manifest = LoadZipManifest(path);
+    ASSERT_NE((dmResource::HManifest)0, manifest);
+
+    dmLiveUpdate::VerifyProgress progress;
+    dmLiveUpdate::InitVerifyProgress(&progress);
+
+    ASSERT_EQ(dmResource::RESULT_SIGNATURE_MISMATCH, dmLiveUpdate::VerifyZipEntries(manifest, path, &progress));
+    ASSERT_EQ(dmResource::RESULT_SIGNATURE_MISMATCH, dmLiveUpdate::VerifyZipEntries(manifest, path, 0));
+
+    dmLiveUpdate::DestroyVerifyProgress(&progress);
+    dmResource::DeleteManifest(manifest);
+}
+
 #endif // DM_LU_NULL_IMPLEMENTATION
 
 int main(int argc, char **argv)
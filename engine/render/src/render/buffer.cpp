@@ -12,8 +12,17 @@
 // CONDITIONS OF ANY KIND, either express or implied. See the License for the
 // specific language governing permissions and limitations under the License.
 
+#include <assert.h>
+
+#include <dlib/math.h>
+#include <dlib/profile.h>
+
 #include "render_private.h"
 
+DM_PROPERTY_EXTERN(rmtp_Render);
+DM_PROPERTY_U32(rmtp_FrameRingBytes, 0, FrameReset, "bytes written to the frame ring buffers", &rmtp_Render);
+DM_PROPERTY_U32(rmtp_FrameRingWraps, 0, FrameReset, "# frame ring reservations that needed another buffer", &rmtp_Render);
+
 namespace dmRender
 {
     static HRenderBuffer NewRenderBuffer(dmGraphics::HContext graphics_context, RenderBufferType type)
@@ -144,4 +153,234 @@ namespace dmRender
             return;
         buffer->m_BufferIndex = 0;
     }
+
+    // Initial segment sizes, indexed by RenderBufferType. The rings grow to fit a whole frame if needed.
+    static const uint32_t FRAME_RING_INITIAL_SIZE[] = { 256 * 1024, 64 * 1024 };
+
+    static void SetRenderBufferData(HRenderBuffer buffer, RenderBufferType type, uint32_t size, const void* data)
+    {
+        switch(type)
+        {
+            case RENDER_BUFFER_TYPE_VERTEX_BUFFER:
+                dmGraphics::SetVertexBufferData((dmGraphics::HVertexBuffer) buffer, size, data, dmGraphics::BUFFER_USAGE_STREAM_DRAW);
+                break;
+            case RENDER_BUFFER_TYPE_INDEX_BUFFER:
+                dmGraphics::SetIndexBufferData((dmGraphics::HIndexBuffer) buffer, size, data, dmGraphics::BUFFER_USAGE_STREAM_DRAW);
+                break;
+            default:break;
+        }
+    }
+
+    static void SetRenderBufferSubData(HRenderBuffer buffer, RenderBufferType type, uint32_t offset, uint32_t size, const void* data)
+    {
+        switch(type)
+        {
+            case RENDER_BUFFER_TYPE_VERTEX_BUFFER:
+                dmGraphics::SetVertexBufferSubData((dmGraphics::HVertexBuffer) buffer, offset, size, data);
+                break;
+            case RENDER_BUFFER_TYPE_INDEX_BUFFER:
+                dmGraphics::SetIndexBufferSubData((dmGraphics::HIndexBuffer) buffer, offset, size, data);
+                break;
+            default:break;
+        }
+    }
+
+    void NewFrameRings(HRenderContext render_context)
+    {
+        for (uint32_t i = 0; i < DM_ARRAY_SIZE(render_context->m_FrameRings); ++i)
+        {
+            FrameRing* ring = &render_context->m_FrameRings[i];
+            ring->m_Type         = (RenderBufferType) i;
+            ring->m_SegmentSize  = FRAME_RING_INITIAL_SIZE[i];
+            ring->m_UploadSerial = 0;
+            ring->m_Data.SetCapacity(ring->m_SegmentSize);
+            memset(&ring->m_Stats, 0, sizeof(ring->m_Stats));
+        }
+        RewindFrameRings(render_context);
+    }
+
+    void DeleteFrameRings(HRenderContext render_context)
+    {
+        for (uint32_t i = 0; i < DM_ARRAY_SIZE(render_context->m_FrameRings); ++i)
+        {
+            FrameRing* ring = &render_context->m_FrameRings[i];
+            for (uint32_t j = 0; j < ring->m_Buffers.Size(); ++j)
+            {
+                DeleteRenderBuffer(ring->m_Buffers[j], ring->m_Type);
+            }
+            ring->m_Buffers.SetSize(0);
+        }
+    }
+
+    // Uploads the data committed since the last upload to the current segment
+    static void UploadFrameRing(HRenderContext render_context, FrameRing* ring)
+    {
+        if (ring->m_Head == ring->m_Flushed)
+            return;
+
+        HRenderBuffer buffer = ring->m_Buffers[ring->m_BufferIndex];
+        if (render_context->m_MultiBufferingRequired)
+        {
+            // Every upload gets a segment of its own, see FlushFrameRings
+            assert(ring->m_Flushed == 0);
+            SetRenderBufferData(buffer, ring->m_Type, ring->m_Head, ring->m_Data.Begin());
+        }
+        else
+        {
+            if (!ring->m_Specified)
+            {
+                // Orphan the storage used by the previous frame, so that the driver doesn't have to wait for it
+                SetRenderBufferData(buffer, ring->m_Type, ring->m_SegmentSize, 0);
+                ring->m_Specified = 1;
+            }
+            SetRenderBufferSubData(buffer, ring->m_Type, ring->m_Flushed, ring->m_Head - ring->m_Flushed, ring->m_Data.Begin() + ring->m_Flushed);
+        }
+
+        ring->m_Flushed = ring->m_Head;
+        ring->m_Stats.m_Uploads++;
+        ring->m_UploadSerial++;
+    }
+
+    static void NextFrameRingSegment(FrameRing* ring)
+    {
+        ring->m_BufferIndex++;
+        ring->m_Head      = 0;
+        ring->m_Flushed   = 0;
+        ring->m_Specified = 0;
+    }
+
+    void FlushFrameRings(HRenderContext render_context)
+    {
+        for (uint32_t i = 0; i < DM_ARRAY_SIZE(render_context->m_FrameRings); ++i)
+        {
+            FrameRing* ring = &render_context->m_FrameRings[i];
+            assert(!ring->m_Reserved);
+            if (ring->m_Head == ring->m_Flushed)
+                continue;
+
+            UploadFrameRing(render_context, ring);
+            if (render_context->m_MultiBufferingRequired)
+            {
+                NextFrameRingSegment(ring);
+            }
+        }
+    }
+
+    void RewindFrameRings(HRenderContext render_context)
+    {
+        for (uint32_t i = 0; i < DM_ARRAY_SIZE(render_context->m_FrameRings); ++i)
+        {
+            FrameRing* ring = &render_context->m_FrameRings[i];
+            assert(!ring->m_Reserved);
+
+            if (ring->m_Stats.m_Wraps > 0)
+            {
+                // Grow so that the next frame fits in one segment. The extra segments are released, and
+                // the upload serial bumped since any data still referenced from them is gone.
+                ring->m_SegmentSize = dmMath::Max(ring->m_SegmentSize, ring->m_Stats.m_Bytes + ring->m_MaxReservation);
+                ring->m_Data.SetCapacity(ring->m_SegmentSize);
+
+                for (uint32_t j = 1; j < ring->m_Buffers.Size(); ++j)
+                {
+                    DeleteRenderBuffer(ring->m_Buffers[j], ring->m_Type);
+                }
+                ring->m_Buffers.SetSize(dmMath::Min(1U, ring->m_Buffers.Size()));
+                ring->m_UploadSerial++;
+            }
+
+            ring->m_BufferIndex    = 0;
+            ring->m_Head           = 0;
+            ring->m_Flushed        = 0;
+            ring->m_ReservedOffset = 0;
+            ring->m_MaxReservation = 0;
+            ring->m_Reserved       = 0;
+            ring->m_Specified      = 0;
+            memset(&ring->m_Stats, 0, sizeof(ring->m_Stats));
+        }
+    }
+
+    Result ReserveFrameRing(HRenderContext render_context, RenderBufferType type, uint32_t size, uint32_t alignment, FrameRingAllocation* allocation)
+    {
+        if (size == 0 || (uint32_t) type >= DM_ARRAY_SIZE(render_context->m_FrameRings))
+            return RESULT_INVALID_PARAMETER;
+
+        FrameRing* ring = &render_context->m_FrameRings[type];
+        assert(!ring->m_Reserved);
+
+        // Alignments are often vertex strides, so they don't have to be powers of two
+        alignment = dmMath::Max(1U, alignment);
+        uint32_t offset = ((ring->m_Head + alignment - 1) / alignment) * alignment;
+
+        if (offset + size > ring->m_SegmentSize)
+        {
+            if (ring->m_Head > 0)
+            {
+                // Render objects already pointing at the current segment are unaffected
+                UploadFrameRing(render_context, ring);
+                NextFrameRingSegment(ring);
+
+                ring->m_Stats.m_Wraps++;
+                DM_PROPERTY_ADD_U32(rmtp_FrameRingWraps, 1);
+            }
+
+            if (size > ring->m_SegmentSize)
+            {
+                // Nothing is pending in the staging memory at this point
+                ring->m_SegmentSize = size;
+                ring->m_Data.SetCapacity(size);
+                ring->m_Specified = 0;
+            }
+            offset = 0;
+        }
+
+        if (ring->m_BufferIndex == ring->m_Buffers.Size())
+        {
+            if (ring->m_Buffers.Full())
+            {
+                ring->m_Buffers.OffsetCapacity(4);
+            }
+            ring->m_Buffers.Push(NewRenderBuffer(render_context->m_GraphicsContext, ring->m_Type));
+        }
+
+        ring->m_ReservedOffset = offset;
+        ring->m_MaxReservation = dmMath::Max(ring->m_MaxReservation, size);
+        ring->m_Reserved       = 1;
+
+        allocation->m_Data   = ring->m_Data.Begin() + offset;
+        allocation->m_Buffer = ring->m_Buffers[ring->m_BufferIndex];
+        allocation->m_Offset = offset;
+        allocation->m_Size   = size;
+        return RESULT_OK;
+    }
+
+    void CommitFrameRing(HRenderContext render_context, RenderBufferType type, uint32_t size)
+    {
+        FrameRing* ring = &render_context->m_FrameRings[type];
+        assert(ring->m_Reserved);
+        assert(ring->m_ReservedOffset + size <= ring->m_SegmentSize);
+        ring->m_Reserved = 0;
+
+        if (size == 0)
+            return;
+
+        uint32_t end = ring->m_ReservedOffset + size;
+        ring->m_Stats.m_Bytes += end - ring->m_Head;
+        DM_PROPERTY_ADD_U32(rmtp_FrameRingBytes, end - ring->m_Head);
+        ring->m_Head = end;
+    }
+
+    void GetFrameRingStats(HRenderContext render_context, RenderBufferType type, FrameRingStats* stats)
+    {
+        *stats = render_context->m_FrameRings[type].m_Stats;
+    }
+
+    uint32_t GetFrameRingUploadSerial(HRenderContext render_context)
+    {
+        uint32_t serial = 0;
+        for (uint32_t i = 0; i < DM_ARRAY_SIZE(render_context->m_FrameRings); ++i)
+        {
+            serial += render_context->m_FrameRings[i].m_UploadSerial;
+        }
+        return serial;
+    }
 }
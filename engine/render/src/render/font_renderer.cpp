@@ -128,6 +128,7 @@ namespace dmRender
         , m_Cache(0)
         , m_CacheIndices(0)
         , m_CacheCursor(0)
+        , m_CacheVersion(0)
         , m_CacheWidth(0)
         , m_CacheHeight(0)
         , m_CacheCellWidth(0)
@@ -183,6 +184,7 @@ namespace dmRender
         CacheGlyph*                 m_Cache;        // The data (i.e. the pool)
         uint16_t*                   m_CacheIndices; // Indices into the cache array
         uint32_t                    m_CacheCursor;
+        uint32_t                    m_CacheVersion; // Bumped whenever a glyph is (re)placed in the cache
 
         dmGraphics::TextureFormat m_CacheFormat;
         dmGraphics::TextureFilter m_MinFilter;
@@ -800,6 +802,7 @@ namespace dmRender
             font_map->m_GlyphCache.Erase(cache_glyph->m_Glyph->m_Character);
         }
         cache_glyph->m_Glyph = g;
+        font_map->m_CacheVersion++;
 
         font_map->m_GlyphCache.Put(g->m_Character, cache_glyph);
 
@@ -1194,6 +1197,23 @@ namespace dmRender
         dmRender::AddToRender(render_context, ro);
     }
 
+    // Everything the glyph vertices of a text are written from, that isn't part of its render list entry
+    static void FontRenderListContentHash(void* user_data, const dmRender::RenderListEntry& entry, HashState64* state)
+    {
+        HRenderContext render_context = (HRenderContext) user_data;
+        const TextEntry* te = (TextEntry*) entry.m_UserData;
+        const char* text = &render_context->m_TextContext.m_TextBuffer[te->m_StringOffset];
+
+        float metrics[] = { te->m_Width, te->m_Height, te->m_Leading, te->m_Tracking };
+        // Glyphs are evicted from the cache as new glyphs are added
+        uint32_t bits[] = { te->m_FaceColor, te->m_OutlineColor, te->m_ShadowColor, te->m_LineBreak, te->m_Align, te->m_VAlign, te->m_FontMap->m_CacheVersion };
+        dmHashUpdateBuffer64(state, &te->m_Transform, sizeof(te->m_Transform));
+        dmHashUpdateBuffer64(state, &te->m_FontMap, sizeof(te->m_FontMap));
+        dmHashUpdateBuffer64(state, metrics, sizeof(metrics));
+        dmHashUpdateBuffer64(state, bits, sizeof(bits));
+        dmHashUpdateBuffer64(state, text, strlen(text));
+    }
+
     static void FontRenderListDispatch(dmRender::RenderListDispatchParams const &params)
     {
         HRenderContext render_context = (HRenderContext)params.m_UserData;
@@ -1268,6 +1288,7 @@ namespace dmRender
             if (count > 0) {
                 dmRender::RenderListEntry* render_list = dmRender::RenderListAlloc(render_context, count);
                 dmRender::HRenderListDispatch dispatch = dmRender::RenderListMakeDispatch(render_context, &FontRenderListDispatch, &RenderListFrustumCulling, render_context);
+                dmRender::RenderListSetContentHashFn(render_context, dispatch, &FontRenderListContentHash);
                 dmRender::RenderListEntry* write_ptr = render_list;
 
                 for( uint32_t i = 0; i < count; ++i )
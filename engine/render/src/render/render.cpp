@@ -32,6 +32,10 @@
 #include "font_renderer.h"
 
 DM_PROPERTY_GROUP(rmtp_Render, "Renderer");
+DM_PROPERTY_U32(rmtp_DrawBindsIssued, 0, FrameReset, "# texture, vertex and constant binds issued", &rmtp_Render);
+DM_PROPERTY_U32(rmtp_DrawBindsSkipped, 0, FrameReset, "# redundant binds skipped", &rmtp_Render);
+DM_PROPERTY_U32(rmtp_DrawListsRecorded, 0, FrameReset, "# render lists dispatched into a recording", &rmtp_Render);
+DM_PROPERTY_U32(rmtp_DrawListsReplayed, 0, FrameReset, "# render lists replayed from a recording", &rmtp_Render);
 
 namespace dmRender
 {
@@ -130,6 +134,13 @@ namespace dmRender
 
         context->m_OutOfResources = 0;
 
+        memset(&context->m_DrawStateStats, 0, sizeof(context->m_DrawStateStats));
+
+        context->m_DispatchBatchSerials.SetCapacity(127, 255);
+        context->m_DrawRenderListSerial = 0;
+
+        NewFrameRings(context);
+
         context->m_StencilBufferCleared = 0;
 
         context->m_MultiBufferingRequired = 0;
@@ -157,6 +168,7 @@ namespace dmRender
         dmScript::DeleteScriptWorld(render_context->m_ScriptWorld);
         FinalizeDebugRenderer(render_context);
         FinalizeTextContext(render_context);
+        DeleteFrameRings(render_context);
         dmMessage::DeleteSocket(render_context->m_Socket);
         delete render_context;
 
@@ -175,6 +187,8 @@ namespace dmRender
         render_context->m_RenderListDispatch.SetSize(0);
         render_context->m_RenderListRanges.SetSize(0);
         render_context->m_FrustumHash = 0xFFFFFFFF; // trigger a first recalculation each frame
+        memset(&render_context->m_DrawStateStats, 0, sizeof(render_context->m_DrawStateStats));
+        RewindFrameRings(render_context);
     }
 
     HRenderListDispatch RenderListMakeDispatch(HRenderContext render_context, RenderListDispatchFn dispatch_fn, RenderListVisibilityFn visibility_fn, void* user_data)
@@ -189,6 +203,8 @@ namespace dmRender
         RenderListDispatch d;
         d.m_DispatchFn = dispatch_fn;
         d.m_VisibilityFn = visibility_fn;
+        d.m_ContentHashFn = 0;
+        d.m_ReplayFn = 0;
         d.m_UserData = user_data;
         render_context->m_RenderListDispatch.Push(d);
 
@@ -200,6 +216,20 @@ namespace dmRender
         return RenderListMakeDispatch(render_context, dispatch_fn, 0, user_data);
     }
 
+    void RenderListSetContentHashFn(HRenderContext render_context, HRenderListDispatch dispatch, RenderListContentHashFn content_hash_fn)
+    {
+        if (dispatch == RENDERLIST_INVALID_DISPATCH)
+            return;
+        render_context->m_RenderListDispatch[dispatch].m_ContentHashFn = content_hash_fn;
+    }
+
+    void RenderListSetReplayFn(HRenderContext render_context, HRenderListDispatch dispatch, RenderListReplayFn replay_fn)
+    {
+        if (dispatch == RENDERLIST_INVALID_DISPATCH)
+            return;
+        render_context->m_RenderListDispatch[dispatch].m_ReplayFn = replay_fn;
+    }
+
     // Allocate a buffer (from the array) with room for 'entries' entries.
     //
     // NOTE: Pointer might go invalid after a consecutive call to RenderListAlloc if reallocation
@@ -815,7 +845,154 @@ namespace dmRender
         }
     }
 
+    // Returns false if the list contains entries whose content can't be hashed
+    static bool HashRecordingKey(HRenderContext context, dmhash_t* out_key)
+    {
+        DM_PROFILE("HashRecordingKey");
+
+        // Covers what decides the render objects the dispatch functions produce: the matching
+        // entries (in submission order), their visibility, the state the dispatch functions write
+        // their vertex data from and the view projection used for sorting.
+        HashState64 state;
+        dmHashInit64(&state, false);
+        dmHashUpdateBuffer64(&state, &context->m_ViewProj, sizeof(context->m_ViewProj));
+
+        const RenderListEntry* entries = context->m_RenderList.Begin();
+        const RenderListRange* ranges = context->m_RenderListRanges.Begin();
+        uint32_t num_ranges = context->m_RenderListRanges.Size();
+        for (uint32_t r = 0; r < num_ranges; ++r)
+        {
+            const RenderListRange& range = ranges[r];
+            if (range.m_Skip)
+                continue;
+
+            for (uint32_t i = range.m_Start; i < range.m_Start+range.m_Count; ++i)
+            {
+                const RenderListEntry* entry = &entries[context->m_RenderListSortIndices[i]];
+                float position[] = { entry->m_WorldPosition.getX(), entry->m_WorldPosition.getY(), entry->m_WorldPosition.getZ() };
+                uint32_t bits[] = { entry->m_Order, entry->m_BatchKey, entry->m_TagListKey,
+                                    entry->m_MinorOrder, entry->m_MajorOrder, entry->m_Dispatch, entry->m_Visibility };
+                dmHashUpdateBuffer64(&state, position, sizeof(position));
+                dmHashUpdateBuffer64(&state, &entry->m_UserData, sizeof(entry->m_UserData));
+                dmHashUpdateBuffer64(&state, bits, sizeof(bits));
+
+                if (entry->m_Dispatch == RENDERLIST_INVALID_DISPATCH)
+                    continue;
+
+                const RenderListDispatch& d = context->m_RenderListDispatch[entry->m_Dispatch];
+                if (!d.m_ContentHashFn)
+                    return false;
+                d.m_ContentHashFn(d.m_UserData, *entry, &state);
+            }
+        }
+        *out_key = dmHashFinal64(&state);
+        return true;
+    }
+
+    static void StampDispatchBatch(HRenderContext context, uint64_t user_data, uint32_t serial)
+    {
+        uint32_t* stamp = context->m_DispatchBatchSerials.Get(user_data);
+        if (stamp)
+        {
+            *stamp = serial;
+            return;
+        }
+        if (context->m_DispatchBatchSerials.Full())
+        {
+            // Worlds come and go, so start over. Recordings that miss their stamps are simply recorded again.
+            context->m_DispatchBatchSerials.Clear();
+        }
+        context->m_DispatchBatchSerials.Put(user_data, serial);
+    }
+
+    static bool CanReplayRecording(HRenderContext context, HRenderRecording recording, dmhash_t key)
+    {
+        if (!recording->m_Valid || recording->m_Key != key)
+            return false;
+
+        if (recording->m_UsesFrameRing && recording->m_FrameRingSerial != GetFrameRingUploadSerial(context))
+            return false;
+
+        // If any other draw has batched one of the recorded worlds, it has rewritten the vertex data
+        // the recorded render objects point to
+        for (uint32_t i = 0; i < recording->m_Dispatches.Size(); ++i)
+        {
+            uint32_t* stamp = context->m_DispatchBatchSerials.Get(recording->m_Dispatches[i]);
+            if (!stamp || *stamp != recording->m_Serial)
+                return false;
+        }
+        return true;
+    }
+
+    // Passes the visible, matching entries to the replay functions of their dispatches, in runs of the same dispatch
+    static void ReplayDispatches(HRenderContext context)
+    {
+        DM_PROFILE("ReplayDispatches");
+
+        RenderListEntry* base = context->m_RenderList.Begin();
+        uint32_t* begin       = context->m_RenderListSortBuffer.Begin();
+        uint32_t* end         = context->m_RenderListSortBuffer.End();
+        while (begin != end)
+        {
+            uint32_t dispatch = base[*begin].m_Dispatch;
+            uint32_t* run_end = begin + 1;
+            while (run_end != end && base[*run_end].m_Dispatch == dispatch)
+            {
+                ++run_end;
+            }
+
+            if (dispatch != RENDERLIST_INVALID_DISPATCH)
+            {
+                const RenderListDispatch& d = context->m_RenderListDispatch[dispatch];
+                if (d.m_ReplayFn)
+                {
+                    d.m_ReplayFn(context, d.m_UserData, base, begin, run_end);
+                }
+            }
+            begin = run_end;
+        }
+    }
+
+    static void StoreRecording(HRenderContext context, HRenderRecording recording, dmhash_t key, const uint8_t* batched_dispatches, uint32_t frame_ring_serial)
+    {
+        uint32_t num_render_objects = context->m_RenderObjects.Size();
+        if (recording->m_RenderObjects.Capacity() < num_render_objects)
+        {
+            recording->m_RenderObjects.SetCapacity(num_render_objects);
+        }
+        recording->m_RenderObjects.SetSize(num_render_objects);
+        for (uint32_t i = 0; i < num_render_objects; ++i)
+        {
+            recording->m_RenderObjects[i] = *context->m_RenderObjects[i];
+        }
+
+        recording->m_Dispatches.SetSize(0);
+        for (uint32_t i = 0; i < context->m_RenderListDispatch.Size(); ++i)
+        {
+            if (!batched_dispatches[i])
+                continue;
+            if (recording->m_Dispatches.Full())
+            {
+                recording->m_Dispatches.OffsetCapacity(8);
+            }
+            recording->m_Dispatches.Push((uint64_t) (uintptr_t) context->m_RenderListDispatch[i].m_UserData);
+        }
+
+        // Data written to the frame rings is only kept until the rings are uploaded to again
+        recording->m_FrameRingSerial = GetFrameRingUploadSerial(context);
+        recording->m_UsesFrameRing   = recording->m_FrameRingSerial != frame_ring_serial;
+
+        recording->m_Key    = key;
+        recording->m_Serial = context->m_DrawRenderListSerial;
+        recording->m_Valid  = 1;
+    }
+
     Result DrawRenderList(HRenderContext context, HPredicate predicate, HNamedConstantBuffer constant_buffer, const FrustumOptions* frustum_options)
+    {
+        return DrawRenderList(context, predicate, constant_buffer, frustum_options, 0);
+    }
+
+    Result DrawRenderList(HRenderContext context, HPredicate predicate, HNamedConstantBuffer constant_buffer, const FrustumOptions* frustum_options, HRenderRecording recording)
     {
         DM_PROFILE("DrawRenderList");
 
@@ -861,7 +1038,7 @@ namespace dmRender
             SortRenderList(context);
         }
 
-        dmhash_t frustum_hash = frustum_matrix ? dmHashBuffer64((const void*) frustum_matrix, 16*sizeof(float)) : 0;
+        dmhash_t frustum_hash = frustum_matrix ? dmHashBufferVersion64(DMHASH_VERSION_FAST, (const void*) frustum_matrix, 16*sizeof(float)) : 0;
 
         if (context->m_FrustumHash != frustum_hash)
         {
@@ -884,7 +1061,45 @@ namespace dmRender
         MakeSortBuffer(context, predicate?predicate->m_TagCount:0, predicate?predicate->m_Tags:0);
 
         if (context->m_RenderListSortBuffer.Empty())
+        {
+            if (recording)
+            {
+                InvalidateRenderRecording(recording);
+            }
             return RESULT_OK;
+        }
+
+        // The recorded vertex data lives in buffers that are recycled each frame when multi-buffering
+        if (context->m_MultiBufferingRequired)
+        {
+            recording = 0;
+        }
+
+        context->m_DrawRenderListSerial++;
+
+        dmhash_t recording_key = 0;
+        if (recording && !HashRecordingKey(context, &recording_key))
+        {
+            InvalidateRenderRecording(recording);
+            recording = 0;
+        }
+
+        if (recording)
+        {
+            if (CanReplayRecording(context, recording, recording_key))
+            {
+                DM_PROPERTY_ADD_U32(rmtp_DrawListsReplayed, 1);
+
+                ReplayDispatches(context);
+
+                context->m_RenderObjects.SetSize(0);
+                for (uint32_t i = 0; i < recording->m_RenderObjects.Size(); ++i)
+                {
+                    context->m_RenderObjects.Push(&recording->m_RenderObjects[i]);
+                }
+                return Draw(context, predicate, constant_buffer);
+            }
+        }
 
         {
             DM_PROFILE("DrawRenderList_SORT");
@@ -901,6 +1116,8 @@ namespace dmRender
         params.m_Operation = RENDER_LIST_OPERATION_BEGIN;
         params.m_Context = context;
 
+        uint32_t frame_ring_serial = GetFrameRingUploadSerial(context);
+
         {
             DM_PROFILE("Dispatch_Begin");
 
@@ -922,6 +1139,9 @@ namespace dmRender
         uint32_t *last = context->m_RenderListSortBuffer.Begin();
         uint32_t count = context->m_RenderListSortBuffer.Size();
 
+        uint8_t batched_dispatches[RENDERLIST_INVALID_DISPATCH];
+        memset(batched_dispatches, 0, sizeof(batched_dispatches));
+
         {
             DM_PROFILE("Dispatch_Batch");
 
@@ -943,11 +1163,20 @@ namespace dmRender
                     params.m_Begin = last;
                     params.m_End = idx;
                     d->m_DispatchFn(params);
+
+                    batched_dispatches[last_entry->m_Dispatch] = 1;
                 }
 
                 last = idx;
             }
 
+            for (uint32_t i = 0; i < context->m_RenderListDispatch.Size(); ++i)
+            {
+                if (batched_dispatches[i])
+                {
+                    StampDispatchBatch(context, (uint64_t) (uintptr_t) context->m_RenderListDispatch[i].m_UserData, context->m_DrawRenderListSerial);
+                }
+            }
         }
 
         params.m_Operation = RENDER_LIST_OPERATION_END;
@@ -966,6 +1195,15 @@ namespace dmRender
             }
         }
 
+        // Upload everything the dispatch functions wrote to the frame rings before drawing
+        FlushFrameRings(context);
+
+        if (recording)
+        {
+            DM_PROPERTY_ADD_U32(rmtp_DrawListsRecorded, 1);
+            StoreRecording(context, recording, recording_key, batched_dispatches, frame_ring_serial);
+        }
+
         return Draw(context, predicate, constant_buffer);
     }
 
@@ -1032,6 +1270,237 @@ namespace dmRender
         TrimTextureBindingTable(render_context);
     }
 
+    static const uint32_t DRAW_STATE_MAX_TEXTURE_UNITS = 32;
+
+    // The bindings dmRender::Draw has left on the graphics context. Consecutive render objects
+    // that share textures, vertex buffers or constants reuse them instead of rebinding, and
+    // unbinding is deferred until a slot changes or the draw ends.
+    struct DrawStateCache
+    {
+        struct TextureSlot
+        {
+            dmGraphics::HTexture m_Texture;
+            HSampler             m_Sampler;
+            uint8_t              m_SubHandle;
+            // The texture is bound to more than one unit, so its sampler parameters
+            // depend on the bind order and the slot is always rebound.
+            uint8_t              m_Shared;
+        };
+
+        struct VertexSlot
+        {
+            dmGraphics::HVertexBuffer      m_VertexBuffer;
+            dmGraphics::HVertexDeclaration m_VertexDeclaration;
+            uint32_t                       m_Offset;
+        };
+
+        TextureSlot         m_Textures[DRAW_STATE_MAX_TEXTURE_UNITS];
+        VertexSlot          m_VertexSlots[RenderObject::MAX_VERTEX_BUFFER_COUNT];
+        const RenderObject* m_ConstantsObject; // Last object whose constants were uploaded
+        HMaterial           m_ConstantsMaterial;
+        uint32_t            m_TextureUnitCount;
+        uint32_t            m_Issued;
+        uint32_t            m_Skipped;
+    };
+
+    static void DisableVertexSlot(dmGraphics::HContext context, DrawStateCache::VertexSlot* slot)
+    {
+        if (slot->m_VertexBuffer)
+        {
+            dmGraphics::DisableVertexBuffer(context, slot->m_VertexBuffer);
+        }
+        if (slot->m_VertexDeclaration)
+        {
+            dmGraphics::DisableVertexDeclaration(context, slot->m_VertexDeclaration);
+        }
+        memset(slot, 0, sizeof(*slot));
+    }
+
+    static void DisableTextureSlot(dmGraphics::HContext context, DrawStateCache::TextureSlot* slot, uint32_t unit)
+    {
+        if (slot->m_Texture)
+        {
+            dmGraphics::DisableTexture(context, unit, slot->m_Texture);
+        }
+        memset(slot, 0, sizeof(*slot));
+    }
+
+    // Unbinds everything the cache holds, e.g before switching program or when the draw ends
+    static void FlushDrawStateCache(dmGraphics::HContext context, DrawStateCache* cache)
+    {
+        for (uint32_t i = 0; i < RenderObject::MAX_VERTEX_BUFFER_COUNT; ++i)
+        {
+            DisableVertexSlot(context, &cache->m_VertexSlots[i]);
+        }
+        for (uint32_t i = 0; i < cache->m_TextureUnitCount; ++i)
+        {
+            DisableTextureSlot(context, &cache->m_Textures[i], i);
+        }
+        cache->m_TextureUnitCount  = 0;
+        cache->m_ConstantsObject   = 0;
+        cache->m_ConstantsMaterial = 0;
+    }
+
+    static bool CanReuseConstants(const DrawStateCache* cache, HMaterial material, const RenderObject* ro)
+    {
+        const RenderObject* prev = cache->m_ConstantsObject;
+        if (!prev || cache->m_ConstantsMaterial != material || prev->m_ConstantBuffer != ro->m_ConstantBuffer)
+        {
+            return false;
+        }
+        // Transform based constants (world, normal, texture etc) are derived from these
+        return memcmp(&prev->m_WorldTransform, &ro->m_WorldTransform, sizeof(ro->m_WorldTransform)) == 0 &&
+               memcmp(&prev->m_TextureTransform, &ro->m_TextureTransform, sizeof(ro->m_TextureTransform)) == 0;
+    }
+
+    static void BindDrawTextures(HRenderContext render_context, DrawStateCache* cache, HMaterial material, const RenderObject* ro, const dmGraphics::HTexture* render_context_textures)
+    {
+        dmGraphics::HContext context = dmRender::GetGraphicsContext(render_context);
+        DrawStateCache::TextureSlot slots[DRAW_STATE_MAX_TEXTURE_UNITS];
+        uint32_t unit_count = 0;
+
+        for (uint32_t i = 0; i < RenderObject::MAX_TEXTURE_COUNT; ++i)
+        {
+            dmGraphics::HTexture texture = ro->m_Textures[i];
+            if (render_context_textures[i])
+            {
+                texture = render_context_textures[i];
+            }
+
+            if (texture)
+            {
+                uint32_t num_texture_handles = dmGraphics::GetNumTextureHandles(texture);
+                for (int sub_handle = 0; sub_handle < num_texture_handles; ++sub_handle)
+                {
+                    assert(unit_count < DRAW_STATE_MAX_TEXTURE_UNITS);
+                    DrawStateCache::TextureSlot& slot = slots[unit_count];
+                    slot.m_Texture   = texture;
+                    slot.m_Sampler   = GetProgramSampler(material->m_Samplers, unit_count);
+                    slot.m_SubHandle = (uint8_t) sub_handle;
+                    slot.m_Shared    = 0;
+                    for (uint32_t j = 0; j < unit_count; ++j)
+                    {
+                        if (slots[j].m_Texture == texture)
+                        {
+                            slots[j].m_Shared = 1;
+                            slot.m_Shared     = 1;
+                        }
+                    }
+                    unit_count++;
+                }
+            }
+        }
+
+        for (uint32_t unit = 0; unit < unit_count; ++unit)
+        {
+            const DrawStateCache::TextureSlot& slot = slots[unit];
+            DrawStateCache::TextureSlot* bound      = &cache->m_Textures[unit];
+
+            if (unit < cache->m_TextureUnitCount && !bound->m_Shared && !slot.m_Shared &&
+                bound->m_Texture == slot.m_Texture && bound->m_Sampler == slot.m_Sampler && bound->m_SubHandle == slot.m_SubHandle)
+            {
+                cache->m_Skipped++;
+                render_context->m_DrawStateStats.m_TexturesSkipped++;
+                continue;
+            }
+
+            if (unit < cache->m_TextureUnitCount)
+            {
+                DisableTextureSlot(context, bound, unit);
+            }
+
+            dmGraphics::EnableTexture(context, unit, slot.m_SubHandle, slot.m_Texture);
+            ApplyProgramSampler(render_context, slot.m_Sampler, unit, slot.m_Texture);
+            *bound = slot;
+
+            cache->m_Issued++;
+            render_context->m_DrawStateStats.m_TexturesIssued++;
+        }
+
+        for (uint32_t unit = unit_count; unit < cache->m_TextureUnitCount; ++unit)
+        {
+            DisableTextureSlot(context, &cache->m_Textures[unit], unit);
+        }
+        cache->m_TextureUnitCount = unit_count;
+    }
+
+    static void BindDrawVertexBuffers(HRenderContext render_context, DrawStateCache* cache, dmGraphics::HProgram program, const RenderObject* ro)
+    {
+        dmGraphics::HContext context = dmRender::GetGraphicsContext(render_context);
+        DrawStateStats& stats        = render_context->m_DrawStateStats;
+        bool changed[RenderObject::MAX_VERTEX_BUFFER_COUNT];
+
+        for (uint32_t i = 0; i < RenderObject::MAX_VERTEX_BUFFER_COUNT; ++i)
+        {
+            const DrawStateCache::VertexSlot& bound = cache->m_VertexSlots[i];
+            changed[i] = bound.m_VertexBuffer != ro->m_VertexBuffers[i] ||
+                         bound.m_VertexDeclaration != ro->m_VertexDeclarations[i] ||
+                         (ro->m_VertexDeclarations[i] && bound.m_Offset != ro->m_VertexBufferOffsets[i]);
+        }
+
+        // The adapters unbind by handle, so unbinding a buffer or declaration that is also
+        // bound to another slot clears that slot too. Rebind those as well.
+        bool propagate = true;
+        while (propagate)
+        {
+            propagate = false;
+            for (uint32_t i = 0; i < RenderObject::MAX_VERTEX_BUFFER_COUNT; ++i)
+            {
+                if (!changed[i])
+                    continue;
+                const DrawStateCache::VertexSlot& a = cache->m_VertexSlots[i];
+                for (uint32_t j = 0; j < RenderObject::MAX_VERTEX_BUFFER_COUNT; ++j)
+                {
+                    const DrawStateCache::VertexSlot& b = cache->m_VertexSlots[j];
+                    if (!changed[j] && ((a.m_VertexBuffer && a.m_VertexBuffer == b.m_VertexBuffer) ||
+                                        (a.m_VertexDeclaration && a.m_VertexDeclaration == b.m_VertexDeclaration)))
+                    {
+                        changed[j] = true;
+                        propagate  = true;
+                    }
+                }
+            }
+        }
+
+        for (uint32_t i = 0; i < RenderObject::MAX_VERTEX_BUFFER_COUNT; ++i)
+        {
+            if (changed[i])
+            {
+                DisableVertexSlot(context, &cache->m_VertexSlots[i]);
+            }
+        }
+
+        for (uint32_t i = 0; i < RenderObject::MAX_VERTEX_BUFFER_COUNT; ++i)
+        {
+            if (!changed[i])
+            {
+                uint32_t buffer_skipped = ro->m_VertexBuffers[i] ? 1 : 0;
+                uint32_t decl_skipped   = ro->m_VertexDeclarations[i] ? 1 : 0;
+                stats.m_VertexBuffersSkipped      += buffer_skipped;
+                stats.m_VertexDeclarationsSkipped += decl_skipped;
+                cache->m_Skipped                  += buffer_skipped + decl_skipped;
+                continue;
+            }
+
+            DrawStateCache::VertexSlot* bound = &cache->m_VertexSlots[i];
+            if (ro->m_VertexBuffers[i])
+            {
+                dmGraphics::EnableVertexBuffer(context, ro->m_VertexBuffers[i], i);
+                bound->m_VertexBuffer = ro->m_VertexBuffers[i];
+                stats.m_VertexBuffersIssued++;
+                cache->m_Issued++;
+            }
+            if (ro->m_VertexDeclarations[i])
+            {
+                dmGraphics::EnableVertexDeclaration(context, ro->m_VertexDeclarations[i], i, ro->m_VertexBufferOffsets[i], program);
+                bound->m_VertexDeclaration = ro->m_VertexDeclarations[i];
+                bound->m_Offset            = ro->m_VertexBufferOffsets[i];
+                stats.m_VertexDeclarationsIssued++;
+                cache->m_Issued++;
+            }
+        }
+    }
+
     // NOTE: Currently only used externally in 1 test (fontview.cpp)
     // TODO: Replace that occurrance with DrawRenderList
     Result Draw(HRenderContext render_context, HPredicate predicate, HNamedConstantBuffer constant_buffer)
@@ -1053,6 +1522,9 @@ namespace dmRender
 
         dmGraphics::PipelineState ps_orig = dmGraphics::GetPipelineState(context);
 
+        DrawStateCache cache;
+        memset(&cache, 0, sizeof(cache));
+
         for (uint32_t i = 0; i < render_context->m_RenderObjects.Size(); ++i)
         {
             RenderObject* ro = render_context->m_RenderObjects[i];
@@ -1072,6 +1544,9 @@ namespace dmRender
             {
                 if(material != ro->m_Material)
                 {
+                    // Bindings and sampler locations belong to the previous program
+                    FlushDrawStateCache(context, &cache);
+
                     material = ro->m_Material;
                     dmGraphics::EnableProgram(context, GetMaterialProgram(material));
 
@@ -1082,87 +1557,42 @@ namespace dmRender
                 }
             }
 
-            ApplyMaterialConstants(render_context, material, ro);
-
-            if (ro->m_ConstantBuffer) // from components/scripts
-                ApplyNamedConstantBuffer(render_context, material, ro->m_ConstantBuffer);
-
-            if (constant_buffer) // from render script
-                ApplyNamedConstantBuffer(render_context, material, constant_buffer);
-
-            ApplyRenderState(render_context, render_context->m_GraphicsContext, dmGraphics::GetPipelineState(context), ro);
-
-            uint8_t next_texture_unit = 0;
-            for (uint32_t i = 0; i < RenderObject::MAX_TEXTURE_COUNT; ++i)
+            if (CanReuseConstants(&cache, material, ro))
             {
-                dmGraphics::HTexture texture = ro->m_Textures[i];
-                if (render_context_textures[i])
-                {
-                    texture = render_context_textures[i];
-                }
+                cache.m_Skipped++;
+                render_context->m_DrawStateStats.m_ConstantsSkipped++;
+            }
+            else
+            {
+                ApplyMaterialConstants(render_context, material, ro);
 
-                if (texture)
-                {
-                    uint32_t num_texture_handles = dmGraphics::GetNumTextureHandles(texture);
-                    for (int sub_handle = 0; sub_handle < num_texture_handles; ++sub_handle)
-                    {
-                        HSampler sampler = GetProgramSampler(material->m_Samplers, next_texture_unit);
-                        dmGraphics::EnableTexture(context, next_texture_unit, sub_handle, texture);
-                        ApplyProgramSampler(render_context, sampler, next_texture_unit, texture);
+                if (ro->m_ConstantBuffer) // from components/scripts
+                    ApplyNamedConstantBuffer(render_context, material, ro->m_ConstantBuffer);
 
-                        next_texture_unit++;
-                    }
-                }
+                if (constant_buffer) // from render script
+                    ApplyNamedConstantBuffer(render_context, material, constant_buffer);
+
+                cache.m_ConstantsObject   = ro;
+                cache.m_ConstantsMaterial = material;
+                cache.m_Issued++;
+                render_context->m_DrawStateStats.m_ConstantsIssued++;
             }
 
-            dmGraphics::HProgram material_program = GetMaterialProgram(material);
+            ApplyRenderState(render_context, render_context->m_GraphicsContext, dmGraphics::GetPipelineState(context), ro);
 
-            for (int i = 0; i < RenderObject::MAX_VERTEX_BUFFER_COUNT; ++i)
-            {
-                if (ro->m_VertexBuffers[i])
-                {
-                    dmGraphics::EnableVertexBuffer(context, ro->m_VertexBuffers[i], i);
-                }
-                if (ro->m_VertexDeclarations[i])
-                {
-                    dmGraphics::EnableVertexDeclaration(context, ro->m_VertexDeclarations[i], i, ro->m_VertexBufferOffsets[i], material_program);
-                }
-            }
+            BindDrawTextures(render_context, &cache, material, ro, render_context_textures);
+            BindDrawVertexBuffers(render_context, &cache, GetMaterialProgram(material), ro);
 
             if (ro->m_IndexBuffer)
                 dmGraphics::DrawElements(context, ro->m_PrimitiveType, ro->m_VertexStart, ro->m_VertexCount, ro->m_IndexType, ro->m_IndexBuffer, ro->m_InstanceCount);
             else
                 dmGraphics::Draw(context, ro->m_PrimitiveType, ro->m_VertexStart, ro->m_VertexCount, ro->m_InstanceCount);
+        }
 
-            for (int i = 0; i < RenderObject::MAX_VERTEX_BUFFER_COUNT; ++i)
-            {
-                if (ro->m_VertexBuffers[i])
-                {
-                    dmGraphics::DisableVertexBuffer(context, ro->m_VertexBuffers[i]);
-                }
+        FlushDrawStateCache(context, &cache);
 
-                if (ro->m_VertexDeclarations[i])
-                {
-                    dmGraphics::DisableVertexDeclaration(context, ro->m_VertexDeclarations[i]);
-                }
-            }
-
-            next_texture_unit = 0;
-            for (uint32_t i = 0; i < RenderObject::MAX_TEXTURE_COUNT; ++i)
-            {
-                dmGraphics::HTexture texture = ro->m_Textures[i];
-                if (render_context_textures[i])
-                    texture = render_context_textures[i];
-                if (texture)
-                {
-                    for (int sub_handle = 0; sub_handle < dmGraphics::GetNumTextureHandles(texture); ++sub_handle)
-                    {
-                        dmGraphics::DisableTexture(context, next_texture_unit, texture);
-                        next_texture_unit++;
-                    }
-                }
-            }
-        }
+        DM_PROPERTY_ADD_U32(rmtp_DrawBindsIssued, cache.m_Issued);
+        DM_PROPERTY_ADD_U32(rmtp_DrawBindsSkipped, cache.m_Skipped);
 
         ResetRenderStateIfChanged(context, ps_orig, dmGraphics::GetPipelineState(context));
 
@@ -1198,6 +1628,32 @@ namespace dmRender
         delete predicate;
     }
 
+    HRenderRecording NewRenderRecording()
+    {
+        HRenderRecording recording = new RenderRecording();
+        recording->m_Key = 0;
+        recording->m_Serial = 0;
+        recording->m_FrameRingSerial = 0;
+        recording->m_Valid = 0;
+        recording->m_UsesFrameRing = 0;
+        return recording;
+    }
+
+    void DeleteRenderRecording(HRenderRecording recording)
+    {
+        delete recording;
+    }
+
+    void InvalidateRenderRecording(HRenderRecording recording)
+    {
+        recording->m_Valid = 0;
+    }
+
+    bool IsRenderRecordingValid(HRenderRecording recording)
+    {
+        return recording->m_Valid;
+    }
+
     Result AddPredicateTag(HPredicate predicate, dmhash_t tag)
     {
         if (predicate->m_TagCount == dmRender::Predicate::MAX_TAG_COUNT)
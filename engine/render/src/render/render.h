@@ -48,6 +48,7 @@ namespace dmRender
     typedef struct RenderScript*            HRenderScript;
     typedef struct RenderScriptInstance*    HRenderScriptInstance;
     typedef struct Predicate*               HPredicate;
+    typedef struct RenderRecording*         HRenderRecording;
     typedef struct ComputeProgram*          HComputeProgram;
     typedef uintptr_t                       HRenderBuffer;
     typedef struct BufferedRenderBuffer*    HBufferedRenderBuffer;
@@ -192,6 +193,15 @@ namespace dmRender
     // render list, unless they already are in place from a previous call.
     Result DrawRenderList(HRenderContext context, HPredicate predicate, HNamedConstantBuffer constant_buffer, const FrustumOptions* frustum_options);
 
+    // Same as above, but the render objects produced by the dispatch functions are stored in the recording.
+    // On later calls the recorded objects are drawn directly, skipping sorting and dispatch, as long as the
+    // matching render list entries, their visibility and the view projection are unchanged and no other draw
+    // has dispatched the same component worlds since. The state the components write vertex data from is
+    // covered by the content hash functions of the dispatches (see RenderListSetContentHashFn), and lists
+    // containing entries from a dispatch without one are never recorded. Adapters that multi-buffer their
+    // render buffers (e.g. Vulkan) recycle the recorded buffers every frame, so they always dispatch.
+    Result DrawRenderList(HRenderContext context, HPredicate predicate, HNamedConstantBuffer constant_buffer, const FrustumOptions* frustum_options, HRenderRecording recording);
+
     Result Draw(HRenderContext context, HPredicate predicate, HNamedConstantBuffer constant_buffer);
     Result DrawDebug3d(HRenderContext context, const FrustumOptions* frustum_options);
     Result DrawDebug2d(HRenderContext context);
@@ -327,6 +337,23 @@ namespace dmRender
     void                            DeletePredicate(HPredicate predicate);
     Result                          AddPredicateTag(HPredicate predicate, dmhash_t tag);
 
+    // Hashes the state a dispatch function writes the vertex data of a render list entry from, e.g. world
+    // transform, animation frame and vertex attributes. Only called when drawing with a recording.
+    typedef void (*RenderListContentHashFn)(void* user_data, const RenderListEntry& entry, HashState64* state);
+
+    void                            RenderListSetContentHashFn(HRenderContext context, HRenderListDispatch dispatch, RenderListContentHashFn content_hash_fn);
+
+    // Called with the matching entries of a dispatch when a recording is replayed instead of dispatched, for work
+    // that has to be done each time the entries are drawn, e.g. requesting the mipmap levels of streamed textures.
+    typedef void (*RenderListReplayFn)(HRenderContext context, void* user_data, RenderListEntry* buf, uint32_t* begin, uint32_t* end);
+
+    void                            RenderListSetReplayFn(HRenderContext context, HRenderListDispatch dispatch, RenderListReplayFn replay_fn);
+
+    HRenderRecording                NewRenderRecording();
+    void                            DeleteRenderRecording(HRenderRecording recording);
+    void                            InvalidateRenderRecording(HRenderRecording recording);
+    bool                            IsRenderRecordingValid(HRenderRecording recording);
+
     /** Buffered render buffers
      * A render buffer is a thin wrapper around vertex and index buffers that, depending on graphics context,
      * can allocate more backing storage if needed. E.g for Vulkan and vendor adapters, we cannot reuse the same
@@ -359,6 +386,47 @@ namespace dmRender
     void                            TrimBuffer(HRenderContext render_context, HBufferedRenderBuffer buffer);
     void                            RewindBuffer(HRenderContext render_context, HBufferedRenderBuffer buffer);
 
+    /** Frame ring buffers
+     * A frame scoped allocator for dynamic vertex and index data, shared by all components of a render context.
+     * Instead of keeping a client side copy and a buffered render buffer each, a component reserves a range in
+     * the ring, writes its data straight into the returned memory and commits the number of bytes it used.
+     * Everything committed during a DrawRenderList is uploaded with one call per ring before the render objects
+     * are drawn, and the rings start over at the next RenderListBegin.
+     *
+     * On OpenGL the ring buffer storage is orphaned on the first upload of each frame and then filled with
+     * sub data uploads. On multi-buffered adapters (e.g. Vulkan) each DrawRenderList is uploaded to its own buffer.
+     * If a reservation does not fit in the current buffer, the ring continues in a new buffer (a wrap) and grows
+     * to fit the whole frame next frame.
+     *
+     * // In a dispatch batch callback
+     * FrameRingAllocation alloc;
+     * if (RESULT_OK == ReserveFrameRing(ctx, RENDER_BUFFER_TYPE_VERTEX_BUFFER, max_size, vertex_stride, &alloc))
+     * {
+     *     uint32_t size = WriteVertices(alloc.m_Data, alloc.m_Size);
+     *     CommitFrameRing(ctx, RENDER_BUFFER_TYPE_VERTEX_BUFFER, size);
+     *     ro.m_VertexBuffer = (dmGraphics::HVertexBuffer) alloc.m_Buffer;
+     *     ro.m_VertexStart  = alloc.m_Offset / vertex_stride;
+     * }
+     */
+    struct FrameRingAllocation
+    {
+        void*           m_Data;     // Memory to write to. Valid until the reservation is committed
+        HRenderBuffer   m_Buffer;   // The graphics buffer the data ends up in
+        uint32_t        m_Offset;   // Byte offset of the data in m_Buffer, a multiple of the requested alignment
+        uint32_t        m_Size;     // Number of bytes reserved
+    };
+
+    struct FrameRingStats
+    {
+        uint32_t        m_Bytes;    // Bytes committed this frame, including alignment padding
+        uint32_t        m_Uploads;  // Upload calls issued this frame
+        uint32_t        m_Wraps;    // Reservations this frame that did not fit in the current buffer
+    };
+
+    Result                          ReserveFrameRing(HRenderContext render_context, RenderBufferType type, uint32_t size, uint32_t alignment, FrameRingAllocation* allocation);
+    void                            CommitFrameRing(HRenderContext render_context, RenderBufferType type, uint32_t size);
+    void                            GetFrameRingStats(HRenderContext render_context, RenderBufferType type, FrameRingStats* stats);
+
     /** Render cameras
      * A render camera is a wrapper around common camera properties such as fov, near and far planes, viewport and aspect ratio.
      * Within the engine, the render cameras are "owned" by the renderer, but they can be manipulated elsewhere.
@@ -179,7 +179,8 @@ namespace dmRender
                     FrustumOptions* frustum_options = (FrustumOptions*)c->m_Operands[2];
                     dmRender::DrawRenderList(render_context, (dmRender::Predicate*)c->m_Operands[0],
                                                              (dmRender::HNamedConstantBuffer)c->m_Operands[1],
-                                                             frustum_options);
+                                                             frustum_options,
+                                                             (dmRender::HRenderRecording)c->m_Operands[3]);
                     delete frustum_options;
                     break;
                 }
@@ -205,9 +205,24 @@ namespace dmRender
     {
         RenderListDispatchFn        m_DispatchFn;
         RenderListVisibilityFn      m_VisibilityFn;
+        RenderListContentHashFn     m_ContentHashFn;
+        RenderListReplayFn          m_ReplayFn;
         void*                       m_UserData;
     };
 
+    // The render objects produced by one DrawRenderList call, replayed while the entries
+    // that produced them are unchanged. See DrawRenderList.
+    struct RenderRecording
+    {
+        dmArray<RenderObject>       m_RenderObjects;
+        dmArray<uint64_t>           m_Dispatches;   // User data of the dispatches that produced the render objects
+        dmhash_t                    m_Key;          // Hash of the matching render list entries and the view projection
+        uint32_t                    m_Serial;       // DrawRenderList serial at the time of recording
+        uint32_t                    m_FrameRingSerial;
+        uint32_t                    m_Valid : 1;
+        uint32_t                    m_UsesFrameRing : 1;
+    };
+
     struct RenderListSortValue
     {
         union
@@ -266,6 +281,37 @@ namespace dmRender
         uint8_t          m_Dirty : 1;
     };
 
+    // Binding and constant updates issued to (or skipped by) dmRender::Draw.
+    // Reset each frame in RenderListBegin.
+    struct DrawStateStats
+    {
+        uint32_t m_TexturesIssued;
+        uint32_t m_TexturesSkipped;
+        uint32_t m_VertexBuffersIssued;
+        uint32_t m_VertexBuffersSkipped;
+        uint32_t m_VertexDeclarationsIssued;
+        uint32_t m_VertexDeclarationsSkipped;
+        uint32_t m_ConstantsIssued;
+        uint32_t m_ConstantsSkipped;
+    };
+
+    struct FrameRing
+    {
+        dmArray<HRenderBuffer>      m_Buffers;          // One per segment used in a frame
+        dmArray<uint8_t>            m_Data;             // Staging memory for the current segment
+        FrameRingStats              m_Stats;
+        RenderBufferType            m_Type;
+        uint32_t                    m_BufferIndex;      // Segment currently written to
+        uint32_t                    m_SegmentSize;      // Storage size of each segment buffer
+        uint32_t                    m_Head;             // End of the committed data in the segment
+        uint32_t                    m_Flushed;          // End of the uploaded data in the segment
+        uint32_t                    m_ReservedOffset;   // Start of the open reservation
+        uint32_t                    m_MaxReservation;   // Largest reservation this frame
+        uint32_t                    m_UploadSerial;     // Incremented on each upload, so that recordings can tell if their data was replaced
+        uint32_t                    m_Reserved      : 1;
+        uint32_t                    m_Specified     : 1; // The current segment's storage has been (re)specified this frame
+    };
+
     struct RenderContext
     {
         DebugRenderer               m_DebugRenderer;
@@ -283,6 +329,10 @@ namespace dmRender
         dmArray<RenderListRange>    m_RenderListRanges;         // Maps tagmask to a range in the (sorted) render list
         dmArray<TextureBinding>     m_TextureBindTable;
         dmhash_t                    m_FrustumHash;
+        DrawStateStats              m_DrawStateStats;
+        FrameRing                   m_FrameRings[2];            // Indexed by RenderBufferType
+        dmHashTable64<uint32_t>     m_DispatchBatchSerials;     // Last DrawRenderList serial that batched a dispatch (keyed by user data)
+        uint32_t                    m_DrawRenderListSerial;
 
         dmHashTable32<MaterialTagList>  m_MaterialTagLists;
 
@@ -310,6 +360,12 @@ namespace dmRender
         uint16_t               m_BufferIndex;
     };
 
+    void NewFrameRings(HRenderContext render_context);
+    void DeleteFrameRings(HRenderContext render_context);
+    void RewindFrameRings(HRenderContext render_context);
+    void FlushFrameRings(HRenderContext render_context);
+    uint32_t GetFrameRingUploadSerial(HRenderContext render_context);
+
     void RenderTypeTextBegin(HRenderContext rendercontext, void* user_context);
     void RenderTypeTextDraw(HRenderContext rendercontext, void* user_context, RenderObject* ro_, uint32_t count);
 
@@ -56,6 +56,8 @@ namespace dmRender
 
     #define RENDER_SCRIPT_PREDICATE "RenderScriptPredicate"
 
+    #define RENDER_SCRIPT_RECORDING "RenderScriptRecording"
+
     #define RENDER_SCRIPT_LIB_NAME "render"
     #define RENDER_SCRIPT_FORMAT_NAME "format"
     #define RENDER_SCRIPT_WIDTH_NAME "width"
@@ -70,6 +72,7 @@ namespace dmRender
     static uint32_t RENDER_SCRIPT_INSTANCE_TYPE_HASH = 0;
     static uint32_t RENDER_SCRIPT_CONSTANTBUFFER_TYPE_HASH = 0;
     static uint32_t RENDER_SCRIPT_PREDICATE_TYPE_HASH = 0;
+    static uint32_t RENDER_SCRIPT_RECORDING_TYPE_HASH = 0;
     static uint32_t RENDER_SCRIPT_CONSTANTBUFFER_ARRAY_TYPE_HASH = 0;
 
     static uint32_t RENDER_SCRIPT_FLAG_TEXTURE_BIT = 1;
@@ -360,6 +363,37 @@ namespace dmRender
         {0, 0}
     };
 
+    static HRenderRecording* RenderScriptRecording_Check(lua_State *L, int index)
+    {
+        return (HRenderRecording*)dmScript::CheckUserType(L, index, RENDER_SCRIPT_RECORDING_TYPE_HASH, "Expected a render recording (acquired from the render.recording function)");
+    }
+
+    static int RenderScriptRecording_gc (lua_State *L)
+    {
+        HRenderRecording* r = (HRenderRecording*)lua_touserdata(L, 1);
+        DeleteRenderRecording(*r);
+        *r = 0;
+        return 0;
+    }
+
+    static int RenderScriptRecording_tostring (lua_State *L)
+    {
+        lua_pushfstring(L, "Recording: %p", lua_touserdata(L, 1));
+        return 1;
+    }
+
+    static const luaL_reg RenderScriptRecording_methods[] =
+    {
+        {0,0}
+    };
+
+    static const luaL_reg RenderScriptRecording_meta[] =
+    {
+        {"__gc",        RenderScriptRecording_gc},
+        {"__tostring",  RenderScriptRecording_tostring},
+        {0, 0}
+    };
+
     /*# create a new constant buffer.
      *
      * Constant buffers are used to set shader program variables and are optionally passed to the `render.draw()` function.
@@ -1709,6 +1743,11 @@ namespace dmRender
      * `constants`
      * : [type:constant_buffer] optional constants to use while rendering
      *
+     * `recording`
+     * : [type:recording] optional recording (see [ref:render.recording]). The draw calls produced for the predicate are
+     *   stored in the recording and replayed on later frames, skipping sorting and batching, until the matching render
+     *   list entries, their content, their visibility or the view projection change. Constants are applied as usual when replaying.
+     *
      * @examples
      *
      * ```lua
@@ -1744,6 +1783,12 @@ namespace dmRender
      * local frustum = self.proj * self.view
      * render.draw(self.my_pred, {frustum = frustum, frustum_planes = render.FRUSTUM_PLANES_ALL})
      * ```
+     *
+     * Draw a static menu from a recording:
+     *
+     * ```lua
+     * render.draw(self.menu_pred, {recording = self.menu_recording})
+     * ```
      */
     int RenderScript_Draw(lua_State* L)
     {
@@ -1762,6 +1807,7 @@ namespace dmRender
         dmVMath::Matrix4* frustum_matrix = 0;
         dmRender::FrustumPlanes frustum_num_planes = dmRender::FRUSTUM_PLANES_SIDES;
         HNamedConstantBuffer constant_buffer = 0;
+        HRenderRecording recording = 0;
 
         if (lua_istable(L, 2))
         {
@@ -1780,6 +1826,10 @@ namespace dmRender
             constant_buffer = lua_isnil(L, -1) ? 0 : *RenderScriptConstantBuffer_Check(L, -1);
             lua_pop(L, 1);
 
+            lua_getfield(L, -1, "recording");
+            recording = lua_isnil(L, -1) ? 0 : *RenderScriptRecording_Check(L, -1);
+            lua_pop(L, 1);
+
             lua_pop(L, 1);
         }
         else if (lua_isuserdata(L, 2)) // Deprecated
@@ -1798,7 +1848,7 @@ namespace dmRender
             frustum_options->m_NumPlanes = frustum_num_planes;
         }
 
-        if (InsertCommand(i, Command(COMMAND_TYPE_DRAW, (uint64_t)predicate, (uint64_t) constant_buffer, (uint64_t) frustum_options)))
+        if (InsertCommand(i, Command(COMMAND_TYPE_DRAW, (uint64_t)predicate, (uint64_t) constant_buffer, (uint64_t) frustum_options, (uint64_t) recording)))
             return 0;
         else
             return luaL_error(L, "Command buffer is full (%d).", i->m_CommandBuffer.Capacity());
@@ -2587,6 +2637,74 @@ namespace dmRender
         return 1;
     }
 
+    /*# creates a new render recording
+     *
+     * A recording stores the draw calls that [ref:render.draw] produces for a predicate, so that
+     * static content such as menus or pause screens can be drawn on later frames without sorting
+     * and batching it again. The recording is replayed for as long as the render list entries
+     * matching the predicate, their visibility and the view projection are unchanged, and no other
+     * draw has batched the same components in the meantime.
+     *
+     * Changes to the content of sprites, models, tile maps, gui nodes and texts, such as
+     * transforms, animation frames, tiles and vertex attributes, are detected and make the next
+     * draw record the predicate again. Predicates matching other components, such as particle
+     * effects or meshes, are never recorded. Adapters that multi-buffer their vertex data
+     * (e.g. Vulkan) always draw as if no recording was passed.
+     *
+     * @name render.recording
+     * @return recording [type:recording] new recording
+     * @examples
+     *
+     * ```lua
+     * function init(self)
+     *     self.menu_pred = render.predicate({"menu"})
+     *     self.menu_recording = render.recording()
+     * end
+     *
+     * function update(self)
+     *     render.draw(self.menu_pred, {recording = self.menu_recording})
+     * end
+     *
+     * function on_message(self, message_id)
+     *     if message_id == hash("menu_changed") then
+     *         render.invalidate_recording(self.menu_recording)
+     *     end
+     * end
+     * ```
+     */
+    static int RenderScript_Recording(lua_State* L)
+    {
+        RenderScriptInstance* i = RenderScriptInstance_Check(L);
+        (void)i;
+
+        HRenderRecording* p_recording = (HRenderRecording*) lua_newuserdata(L, sizeof(HRenderRecording*));
+        *p_recording = NewRenderRecording();
+
+        luaL_getmetatable(L, RENDER_SCRIPT_RECORDING);
+        lua_setmetatable(L, -2);
+        return 1;
+    }
+
+    /*# invalidates a render recording
+     * The next [ref:render.draw] using the recording draws the predicate as usual and records it again.
+     *
+     * @name render.invalidate_recording
+     * @param recording [type:recording] recording to invalidate
+     * @examples
+     *
+     * ```lua
+     * render.invalidate_recording(self.menu_recording)
+     * ```
+     */
+    static int RenderScript_InvalidateRecording(lua_State* L)
+    {
+        RenderScriptInstance* i = RenderScriptInstance_Check(L);
+        (void)i;
+        HRenderRecording* p_recording = RenderScriptRecording_Check(L, 1);
+        InvalidateRenderRecording(*p_recording);
+        return 0;
+    }
+
     /*# enables a material
      * If another material was already enabled, it will be automatically disabled
      * and the specified material is used instead.
@@ -2905,6 +3023,8 @@ namespace dmRender
         {"get_window_width",                RenderScript_GetWindowWidth},
         {"get_window_height",               RenderScript_GetWindowHeight},
         {"predicate",                       RenderScript_Predicate},
+        {"recording",                       RenderScript_Recording},
+        {"invalidate_recording",            RenderScript_InvalidateRecording},
         {"constant_buffer",                 RenderScript_ConstantBuffer},
         {"enable_material",                 RenderScript_EnableMaterial},
         {"disable_material",                RenderScript_DisableMaterial},
@@ -2932,6 +3052,8 @@ namespace dmRender
 
         RENDER_SCRIPT_PREDICATE_TYPE_HASH = dmScript::RegisterUserType(L, RENDER_SCRIPT_PREDICATE, RenderScriptPredicate_methods, RenderScriptPredicate_meta);
 
+        RENDER_SCRIPT_RECORDING_TYPE_HASH = dmScript::RegisterUserType(L, RENDER_SCRIPT_RECORDING, RenderScriptRecording_methods, RenderScriptRecording_meta);
+
         RENDER_SCRIPT_CONSTANTBUFFER_ARRAY_TYPE_HASH = dmScript::RegisterUserType(L, RENDER_SCRIPT_CONSTANTBUFFER_ARRAY, RenderScriptConstantBuffer_methods, RenderScriptConstantBufferArray_meta);
 
         luaL_register(L, RENDER_SCRIPT_LIB_NAME, Render_methods);
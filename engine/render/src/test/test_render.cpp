@@ -20,6 +20,7 @@
 #include <testmain/testmain.h>
 #include <dlib/hash.h>
 #include <dlib/math.h>
+#include <dlib/time.h>
 
 #include <script/script.h>
 #include <algorithm> // std::stable_sort
@@ -982,6 +983,127 @@ TEST_F(dmRenderTest, TestDefaultSamplerFilters)
 }
 
 
+TEST_F(dmRenderTest, TestDrawStateCache)
+{
+    dmGraphics::ShaderDesc::ResourceBinding uniforms[2] = {};
+    FillResourceBinding(&uniforms[0], "tint", dmGraphics::ShaderDesc::SHADER_TYPE_VEC4);
+    FillResourceBinding(&uniforms[1], "texture_sampler", dmGraphics::ShaderDesc::SHADER_TYPE_SAMPLER2D);
+
+    const char* shader_src = "uniform vec4 tint;\nuniform lowp sampler2D texture_sampler;\n";
+    dmGraphics::ShaderDesc::Shader shader = MakeDDFShader(dmGraphics::ShaderDesc::LANGUAGE_GLSL_SM140, shader_src, strlen(shader_src));
+    dmGraphics::ShaderDesc vs_desc        = MakeDDFShaderDesc(&shader, dmGraphics::ShaderDesc::SHADER_TYPE_VERTEX, 0, 0, uniforms, 2);
+    dmGraphics::ShaderDesc fs_desc        = MakeDDFShaderDesc(&shader, dmGraphics::ShaderDesc::SHADER_TYPE_FRAGMENT, 0, 0, 0, 0);
+    dmGraphics::HVertexProgram vp         = dmGraphics::NewVertexProgram(m_GraphicsContext, &vs_desc, 0, 0);
+    dmGraphics::HFragmentProgram fp       = dmGraphics::NewFragmentProgram(m_GraphicsContext, &fs_desc, 0, 0);
+    dmRender::HMaterial material          = dmRender::NewMaterial(m_Context, vp, fp);
+    dmGraphics::HProgram program          = dmRender::GetMaterialProgram(material);
+
+    dmGraphics::TextureCreationParams creation_params;
+    creation_params.m_Width          = 2;
+    creation_params.m_Height         = 2;
+    creation_params.m_OriginalWidth  = 2;
+    creation_params.m_OriginalHeight = 2;
+
+    uint8_t tex_data[2 * 2];
+    dmGraphics::TextureParams params;
+    params.m_DataSize = sizeof(tex_data);
+    params.m_Data     = tex_data;
+    params.m_Width    = creation_params.m_Width;
+    params.m_Height   = creation_params.m_Height;
+    params.m_Format   = dmGraphics::TEXTURE_FORMAT_LUMINANCE;
+
+    dmGraphics::HTexture textures[2];
+    for (uint32_t i = 0; i < DM_ARRAY_SIZE(textures); ++i)
+    {
+        textures[i] = dmGraphics::NewTexture(m_GraphicsContext, creation_params);
+        dmGraphics::SetTexture(textures[i], params);
+    }
+
+    dmGraphics::HVertexDeclaration vx_decl = dmGraphics::NewVertexDeclaration(m_GraphicsContext, 0, 0);
+    dmGraphics::HVertexBuffer vx_buffer    = dmGraphics::NewVertexBuffer(m_GraphicsContext, 0, 0, dmGraphics::BUFFER_USAGE_STATIC_DRAW);
+
+    Vector4 tints[2] = { Vector4(1.0f, 2.0f, 3.0f, 4.0f), Vector4(5.0f, 6.0f, 7.0f, 8.0f) };
+    dmRender::HNamedConstantBuffer constants[2];
+    for (uint32_t i = 0; i < DM_ARRAY_SIZE(constants); ++i)
+    {
+        constants[i] = dmRender::NewNamedConstantBuffer();
+        dmRender::SetNamedConstant(constants[i], dmHashString64("tint"), &tints[i], 1);
+    }
+
+    // Objects 0 and 1 share all state, object 2 changes texture and constants
+    // and object 3 only changes constants.
+    const uint32_t texture_index[]  = { 0, 0, 1, 1 };
+    const uint32_t constant_index[] = { 0, 0, 1, 0 };
+
+    dmRender::RenderObject ros[4];
+
+    // The fixture only has room for two render objects
+    m_Context->m_RenderObjects.SetCapacity(DM_ARRAY_SIZE(ros));
+
+    for (uint32_t i = 0; i < DM_ARRAY_SIZE(ros); ++i)
+    {
+        ros[i].Init();
+        ros[i].m_Material          = material;
+        ros[i].m_VertexCount       = 1;
+        ros[i].m_VertexDeclaration = vx_decl;
+        ros[i].m_VertexBuffer      = vx_buffer;
+        ros[i].m_Textures[0]       = textures[texture_index[i]];
+        ros[i].m_ConstantBuffer    = constants[constant_index[i]];
+        ASSERT_EQ(dmRender::RESULT_OK, dmRender::AddToRender(m_Context, &ros[i]));
+    }
+
+    dmGraphics::NullContext* null_context = (dmGraphics::NullContext*) m_GraphicsContext;
+    dmGraphics::HUniformLocation tint_loc = dmGraphics::GetUniformLocation(program, "tint");
+
+    dmRender::RenderListBegin(m_Context);
+    dmGraphics::ResetDrawCount();
+    ASSERT_EQ(dmRender::RESULT_OK, dmRender::Draw(m_Context, 0, 0));
+
+    // Every object is still drawn
+    ASSERT_EQ(4, dmGraphics::GetDrawCount());
+
+    const dmRender::DrawStateStats& stats = m_Context->m_DrawStateStats;
+    ASSERT_EQ(2, stats.m_TexturesIssued);
+    ASSERT_EQ(2, stats.m_TexturesSkipped);
+    ASSERT_EQ(1, stats.m_VertexBuffersIssued);
+    ASSERT_EQ(3, stats.m_VertexBuffersSkipped);
+    ASSERT_EQ(1, stats.m_VertexDeclarationsIssued);
+    ASSERT_EQ(3, stats.m_VertexDeclarationsSkipped);
+    ASSERT_EQ(3, stats.m_ConstantsIssued);
+    ASSERT_EQ(1, stats.m_ConstantsSkipped);
+
+    // The last object's constants are uploaded even though its other state was reused
+    ASSERT_VEC4(tints[0], null_context->m_ProgramRegisters[tint_loc]);
+
+    // Same as drawing without the cache, nothing is left bound after the draw
+    ASSERT_EQ(0, null_context->m_Textures[0]);
+    ASSERT_EQ(0, null_context->m_VertexBuffers[0]);
+
+    // Bindings are not reused across draw calls
+    dmRender::RenderListBegin(m_Context);
+    ASSERT_EQ(dmRender::RESULT_OK, dmRender::Draw(m_Context, 0, 0));
+    ASSERT_EQ(2, stats.m_TexturesIssued);
+    ASSERT_EQ(1, stats.m_VertexBuffersIssued);
+    ASSERT_EQ(3, stats.m_ConstantsIssued);
+
+    ASSERT_EQ(dmRender::RESULT_OK, dmRender::ClearRenderObjects(m_Context));
+
+    for (uint32_t i = 0; i < DM_ARRAY_SIZE(constants); ++i)
+    {
+        dmRender::DeleteNamedConstantBuffer(constants[i]);
+    }
+    for (uint32_t i = 0; i < DM_ARRAY_SIZE(textures); ++i)
+    {
+        dmGraphics::DeleteTexture(textures[i]);
+    }
+
+    dmGraphics::DeleteVertexProgram(vp);
+    dmGraphics::DeleteFragmentProgram(fp);
+    dmRender::DeleteMaterial(m_Context, material);
+    dmGraphics::DeleteVertexBuffer(vx_buffer);
+    dmGraphics::DeleteVertexDeclaration(vx_decl);
+}
+
 static void TestDrawVisibilityDispatch(dmRender::RenderListDispatchParams const & params)
 {
     TestDrawDispatchCtx *ctx = (TestDrawDispatchCtx*) params.m_UserData;
@@ -1257,6 +1379,274 @@ TEST_F(dmRenderTest, TestRenderListOrder)
     ASSERT_EQ(ctx.m_Z, orders[2]);
 }
 
+struct TestRecordingDispatchCtx
+{
+    dmRender::RenderObject*     m_RenderObjects;
+    dmGraphics::HVertexBuffer   m_VertexBuffer;
+    float*                      m_Vertices;
+    uint32_t                    m_VertexCount;
+    uint32_t                    m_BatchCalls;
+    uint32_t                    m_ReplayedEntries;
+    float                       m_Height;       // Stand-in for component state that isn't part of the entries
+    uint8_t                     m_HashContent:1;
+};
+
+static const uint32_t RECORDING_VERTICES_PER_OBJECT = 6;
+
+static void TestRecordingDispatch(dmRender::RenderListDispatchParams const & params)
+{
+    TestRecordingDispatchCtx* ctx = (TestRecordingDispatchCtx*) params.m_UserData;
+
+    switch (params.m_Operation)
+    {
+        case dmRender::RENDER_LIST_OPERATION_BEGIN:
+            ctx->m_VertexCount = 0;
+            break;
+        case dmRender::RENDER_LIST_OPERATION_BATCH:
+            ctx->m_BatchCalls++;
+            // Stand-in for a component writing the vertices of each object in the batch
+            for (uint32_t* i = params.m_Begin; i != params.m_End; ++i)
+            {
+                const dmRender::RenderListEntry& entry = params.m_Buf[*i];
+                dmRender::RenderObject* ro = &ctx->m_RenderObjects[entry.m_UserData];
+                ro->m_VertexStart = ctx->m_VertexCount;
+                ro->m_VertexCount = RECORDING_VERTICES_PER_OBJECT;
+
+                float* v = ctx->m_Vertices + ctx->m_VertexCount * 3;
+                for (uint32_t j = 0; j < RECORDING_VERTICES_PER_OBJECT; ++j)
+                {
+                    v[j * 3 + 0] = entry.m_WorldPosition.getX() + (j & 1);
+                    v[j * 3 + 1] = entry.m_WorldPosition.getY() + (j >> 1) * ctx->m_Height;
+                    v[j * 3 + 2] = entry.m_WorldPosition.getZ();
+                }
+                ctx->m_VertexCount += RECORDING_VERTICES_PER_OBJECT;
+
+                dmRender::AddToRender(params.m_Context, ro);
+            }
+            break;
+        case dmRender::RENDER_LIST_OPERATION_END:
+            if (ctx->m_VertexCount)
+            {
+                dmGraphics::SetVertexBufferData(ctx->m_VertexBuffer, ctx->m_VertexCount * 3 * sizeof(float), ctx->m_Vertices, dmGraphics::BUFFER_USAGE_STREAM_DRAW);
+            }
+            break;
+        default:
+            break;
+    }
+}
+
+static void TestRecordingContentHash(void* user_data, const dmRender::RenderListEntry& entry, HashState64* state)
+{
+    TestRecordingDispatchCtx* ctx = (TestRecordingDispatchCtx*) user_data;
+    dmHashUpdateBuffer64(state, &ctx->m_Height, sizeof(ctx->m_Height));
+}
+
+static void TestRecordingReplay(dmRender::HRenderContext context, void* user_data, dmRender::RenderListEntry* buf, uint32_t* begin, uint32_t* end)
+{
+    TestRecordingDispatchCtx* ctx = (TestRecordingDispatchCtx*) user_data;
+    ctx->m_ReplayedEntries += end - begin;
+}
+
+static void SubmitRecordingFrame(dmRender::HRenderContext context, TestRecordingDispatchCtx* ctx, uint32_t count, float offset)
+{
+    dmRender::RenderListBegin(context);
+    uint8_t dispatch = dmRender::RenderListMakeDispatch(context, TestRecordingDispatch, 0, ctx);
+    if (ctx->m_HashContent)
+    {
+        dmRender::RenderListSetContentHashFn(context, dispatch, TestRecordingContentHash);
+    }
+    dmRender::RenderListSetReplayFn(context, dispatch, TestRecordingReplay);
+
+    dmRender::RenderListEntry* out = dmRender::RenderListAlloc(context, count);
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        dmRender::RenderListEntry& entry = out[i];
+        entry.m_WorldPosition = Point3(i + offset, 0.0f, 0.5f);
+        entry.m_MajorOrder    = dmRender::RENDER_ORDER_WORLD;
+        entry.m_MinorOrder    = 0;
+        entry.m_TagListKey    = 0;
+        entry.m_Order         = 0;
+        entry.m_BatchKey      = i;
+        entry.m_Dispatch      = dispatch;
+        entry.m_UserData      = i;
+    }
+
+    dmRender::RenderListSubmit(context, out, out + count);
+    dmRender::RenderListEnd(context);
+}
+
+class dmRenderRecordingTest : public dmRenderTest
+{
+protected:
+    dmGraphics::HVertexProgram      m_VertexProgram;
+    dmGraphics::HFragmentProgram    m_FragmentProgram;
+    dmRender::HMaterial             m_Material;
+    dmGraphics::HVertexDeclaration  m_VertexDeclaration;
+    TestRecordingDispatchCtx        m_DispatchCtx;
+
+    void SetUpScene(uint32_t count)
+    {
+        const char* shader_src = "foo";
+        dmGraphics::ShaderDesc::Shader shader = MakeDDFShader(dmGraphics::ShaderDesc::LANGUAGE_GLSL_SM140, shader_src, strlen(shader_src));
+        dmGraphics::ShaderDesc vs_desc        = MakeDDFShaderDesc(&shader, dmGraphics::ShaderDesc::SHADER_TYPE_VERTEX, 0, 0, 0, 0);
+        dmGraphics::ShaderDesc fs_desc        = MakeDDFShaderDesc(&shader, dmGraphics::ShaderDesc::SHADER_TYPE_FRAGMENT, 0, 0, 0, 0);
+        m_VertexProgram     = dmGraphics::NewVertexProgram(m_GraphicsContext, &vs_desc, 0, 0);
+        m_FragmentProgram   = dmGraphics::NewFragmentProgram(m_GraphicsContext, &fs_desc, 0, 0);
+        m_Material          = dmRender::NewMaterial(m_Context, m_VertexProgram, m_FragmentProgram);
+        m_VertexDeclaration = dmGraphics::NewVertexDeclaration(m_GraphicsContext, 0, 0);
+
+        memset(&m_DispatchCtx, 0, sizeof(m_DispatchCtx));
+        m_DispatchCtx.m_Height        = 1.0f;
+        m_DispatchCtx.m_HashContent   = 1;
+        m_DispatchCtx.m_VertexBuffer  = dmGraphics::NewVertexBuffer(m_GraphicsContext, 0, 0, dmGraphics::BUFFER_USAGE_STREAM_DRAW);
+        m_DispatchCtx.m_Vertices      = new float[count * RECORDING_VERTICES_PER_OBJECT * 3];
+        m_DispatchCtx.m_RenderObjects = new dmRender::RenderObject[count];
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            dmRender::RenderObject& ro = m_DispatchCtx.m_RenderObjects[i];
+            ro.Init();
+            ro.m_Material          = m_Material;
+            ro.m_VertexDeclaration = m_VertexDeclaration;
+            ro.m_VertexBuffer      = m_DispatchCtx.m_VertexBuffer;
+        }
+
+        // The fixture only has room for two render objects
+        m_Context->m_RenderObjects.SetCapacity(count);
+    }
+
+    void TearDownScene()
+    {
+        delete[] m_DispatchCtx.m_RenderObjects;
+        delete[] m_DispatchCtx.m_Vertices;
+        dmGraphics::DeleteVertexBuffer(m_DispatchCtx.m_VertexBuffer);
+        dmGraphics::DeleteVertexDeclaration(m_VertexDeclaration);
+        dmRender::DeleteMaterial(m_Context, m_Material);
+        dmGraphics::DeleteVertexProgram(m_VertexProgram);
+        dmGraphics::DeleteFragmentProgram(m_FragmentProgram);
+    }
+};
+
+TEST_F(dmRenderRecordingTest, TestRenderListRecording)
+{
+    const uint32_t n = 8;
+    SetUpScene(n);
+
+    dmRender::HRenderRecording recording = dmRender::NewRenderRecording();
+    ASSERT_FALSE(dmRender::IsRenderRecordingValid(recording));
+
+    // First draw dispatches and records
+    SubmitRecordingFrame(m_Context, &m_DispatchCtx, n, 0.0f);
+    dmGraphics::ResetDrawCount();
+    ASSERT_EQ(dmRender::RESULT_OK, dmRender::DrawRenderList(m_Context, 0, 0, 0, recording));
+    ASSERT_EQ(n, m_DispatchCtx.m_BatchCalls);
+    ASSERT_EQ(n, dmGraphics::GetDrawCount());
+    ASSERT_TRUE(dmRender::IsRenderRecordingValid(recording));
+
+    ASSERT_EQ(0, m_DispatchCtx.m_ReplayedEntries);
+
+    // Unchanged render list, the recording is replayed
+    SubmitRecordingFrame(m_Context, &m_DispatchCtx, n, 0.0f);
+    dmGraphics::ResetDrawCount();
+    ASSERT_EQ(dmRender::RESULT_OK, dmRender::DrawRenderList(m_Context, 0, 0, 0, recording));
+    ASSERT_EQ(n, m_DispatchCtx.m_BatchCalls);
+    ASSERT_EQ(n, dmGraphics::GetDrawCount());
+    ASSERT_EQ(n, m_DispatchCtx.m_ReplayedEntries);
+
+    // A moved entry changes the render list
+    SubmitRecordingFrame(m_Context, &m_DispatchCtx, n, 1.0f);
+    ASSERT_EQ(dmRender::RESULT_OK, dmRender::DrawRenderList(m_Context, 0, 0, 0, recording));
+    ASSERT_EQ(2 * n, m_DispatchCtx.m_BatchCalls);
+
+    // Another draw batching the same world rewrites the recorded vertex data
+    SubmitRecordingFrame(m_Context, &m_DispatchCtx, n, 1.0f);
+    ASSERT_EQ(dmRender::RESULT_OK, dmRender::DrawRenderList(m_Context, 0, 0, 0));
+    ASSERT_EQ(dmRender::RESULT_OK, dmRender::DrawRenderList(m_Context, 0, 0, 0, recording));
+    ASSERT_EQ(4 * n, m_DispatchCtx.m_BatchCalls);
+
+    SubmitRecordingFrame(m_Context, &m_DispatchCtx, n, 1.0f);
+    ASSERT_EQ(dmRender::RESULT_OK, dmRender::DrawRenderList(m_Context, 0, 0, 0, recording));
+    ASSERT_EQ(4 * n, m_DispatchCtx.m_BatchCalls);
+
+    // Explicit invalidation
+    dmRender::InvalidateRenderRecording(recording);
+    ASSERT_FALSE(dmRender::IsRenderRecordingValid(recording));
+    SubmitRecordingFrame(m_Context, &m_DispatchCtx, n, 1.0f);
+    ASSERT_EQ(dmRender::RESULT_OK, dmRender::DrawRenderList(m_Context, 0, 0, 0, recording));
+    ASSERT_EQ(5 * n, m_DispatchCtx.m_BatchCalls);
+    ASSERT_TRUE(dmRender::IsRenderRecordingValid(recording));
+
+    // Changed content behind unchanged entries is dispatched again
+    m_DispatchCtx.m_Height = 2.0f;
+    SubmitRecordingFrame(m_Context, &m_DispatchCtx, n, 1.0f);
+    ASSERT_EQ(dmRender::RESULT_OK, dmRender::DrawRenderList(m_Context, 0, 0, 0, recording));
+    ASSERT_EQ(6 * n, m_DispatchCtx.m_BatchCalls);
+    ASSERT_EQ(2.0f, m_DispatchCtx.m_Vertices[2 * 3 + 1]);
+
+    SubmitRecordingFrame(m_Context, &m_DispatchCtx, n, 1.0f);
+    ASSERT_EQ(dmRender::RESULT_OK, dmRender::DrawRenderList(m_Context, 0, 0, 0, recording));
+    ASSERT_EQ(6 * n, m_DispatchCtx.m_BatchCalls);
+
+    // Content that can't be hashed is never recorded
+    m_DispatchCtx.m_HashContent = 0;
+    SubmitRecordingFrame(m_Context, &m_DispatchCtx, n, 1.0f);
+    ASSERT_EQ(dmRender::RESULT_OK, dmRender::DrawRenderList(m_Context, 0, 0, 0, recording));
+    ASSERT_EQ(7 * n, m_DispatchCtx.m_BatchCalls);
+    ASSERT_FALSE(dmRender::IsRenderRecordingValid(recording));
+
+    SubmitRecordingFrame(m_Context, &m_DispatchCtx, n, 1.0f);
+    ASSERT_EQ(dmRender::RESULT_OK, dmRender::DrawRenderList(m_Context, 0, 0, 0, recording));
+    ASSERT_EQ(8 * n, m_DispatchCtx.m_BatchCalls);
+    m_DispatchCtx.m_HashContent = 1;
+
+    // Nothing left to draw
+    SubmitRecordingFrame(m_Context, &m_DispatchCtx, 0, 1.0f);
+    ASSERT_EQ(dmRender::RESULT_OK, dmRender::DrawRenderList(m_Context, 0, 0, 0, recording));
+    ASSERT_FALSE(dmRender::IsRenderRecordingValid(recording));
+
+    dmRender::DeleteRenderRecording(recording);
+    TearDownScene();
+}
+
+// Timing only, enable with DM_TEST_BENCHMARKS
+#if defined(DM_TEST_BENCHMARKS)
+TEST_F(dmRenderRecordingTest, BenchmarkRenderListRecording)
+{
+    const uint32_t n = 2048;
+    const uint32_t num_frames = 100;
+    SetUpScene(n);
+
+    uint64_t dispatch_time = 0;
+    for (uint32_t i = 0; i < num_frames; ++i)
+    {
+        SubmitRecordingFrame(m_Context, &m_DispatchCtx, n, 0.0f);
+        uint64_t start = dmTime::GetTime();
+        dmRender::DrawRenderList(m_Context, 0, 0, 0);
+        dispatch_time += dmTime::GetTime() - start;
+    }
+    ASSERT_EQ(n * num_frames, m_DispatchCtx.m_BatchCalls);
+
+    dmRender::HRenderRecording recording = dmRender::NewRenderRecording();
+
+    m_DispatchCtx.m_BatchCalls = 0;
+    uint64_t replay_time = 0;
+    for (uint32_t i = 0; i < num_frames; ++i)
+    {
+        SubmitRecordingFrame(m_Context, &m_DispatchCtx, n, 0.0f);
+        uint64_t start = dmTime::GetTime();
+        dmRender::DrawRenderList(m_Context, 0, 0, 0, recording);
+        replay_time += dmTime::GetTime() - start;
+    }
+    // Only the first frame was dispatched
+    ASSERT_EQ(n, m_DispatchCtx.m_BatchCalls);
+
+    printf("DrawRenderList, %u static objects: dispatched %.3f ms/frame, replayed %.3f ms/frame\n",
+        n, dispatch_time / (1000.0 * num_frames), replay_time / (1000.0 * num_frames));
+
+    dmRender::DeleteRenderRecording(recording);
+    TearDownScene();
+}
+#endif
+
 TEST_F(dmRenderTest, TestRenderListDebug)
 {
     // Test submitting debug drawing when there is no other drawing going on
@@ -1280,6 +1670,81 @@ TEST_F(dmRenderTest, TestRenderListDebug)
     dmRender::DrawDebug3d(m_Context, 0);
 }
 
+static void WriteFrameRing(dmRender::HRenderContext context, uint32_t size, uint32_t alignment, uint8_t value, dmRender::FrameRingAllocation* allocation)
+{
+    ASSERT_EQ(dmRender::RESULT_OK, dmRender::ReserveFrameRing(context, dmRender::RENDER_BUFFER_TYPE_VERTEX_BUFFER, size, alignment, allocation));
+    memset(allocation->m_Data, value, size);
+    dmRender::CommitFrameRing(context, dmRender::RENDER_BUFFER_TYPE_VERTEX_BUFFER, size);
+}
+
+TEST_F(dmRenderTest, TestFrameRing)
+{
+    dmRender::FrameRing* ring = &m_Context->m_FrameRings[dmRender::RENDER_BUFFER_TYPE_VERTEX_BUFFER];
+    const uint32_t segment_size = ring->m_SegmentSize;
+
+    dmRender::FrameRingAllocation a, b;
+    ASSERT_EQ(dmRender::RESULT_INVALID_PARAMETER, dmRender::ReserveFrameRing(m_Context, dmRender::RENDER_BUFFER_TYPE_VERTEX_BUFFER, 0, 4, &a));
+
+    // Allocations are padded to the alignment, which doesn't have to be a power of two
+    dmRender::RenderListBegin(m_Context);
+    WriteFrameRing(m_Context, 10, 12, 1, &a);
+    WriteFrameRing(m_Context, 24, 12, 2, &b);
+    ASSERT_EQ(0u, a.m_Offset);
+    ASSERT_EQ(12u, b.m_Offset);
+    ASSERT_EQ(a.m_Buffer, b.m_Buffer);
+
+    dmRender::FlushFrameRings(m_Context);
+
+    dmGraphics::VertexBuffer* vx_buffer = (dmGraphics::VertexBuffer*) a.m_Buffer;
+    ASSERT_EQ(segment_size, vx_buffer->m_Size);
+    ASSERT_EQ(1, vx_buffer->m_Buffer[9]);
+    ASSERT_EQ(2, vx_buffer->m_Buffer[12]);
+    ASSERT_EQ(2, vx_buffer->m_Buffer[35]);
+
+    dmRender::FrameRingStats stats;
+    dmRender::GetFrameRingStats(m_Context, dmRender::RENDER_BUFFER_TYPE_VERTEX_BUFFER, &stats);
+    ASSERT_EQ(36u, stats.m_Bytes);
+    ASSERT_EQ(1u, stats.m_Uploads);
+    ASSERT_EQ(0u, stats.m_Wraps);
+
+    // Flushing without new data doesn't upload again
+    dmRender::FlushFrameRings(m_Context);
+    dmRender::GetFrameRingStats(m_Context, dmRender::RENDER_BUFFER_TYPE_VERTEX_BUFFER, &stats);
+    ASSERT_EQ(1u, stats.m_Uploads);
+
+    // Running out of space moves on to another buffer, and the ring grows to fit the frame on the next rewind
+    WriteFrameRing(m_Context, segment_size - 12, 4, 3, &a);
+    ASSERT_EQ(0u, a.m_Offset);
+    ASSERT_NE(b.m_Buffer, a.m_Buffer);
+    ASSERT_EQ(2u, ring->m_Buffers.Size());
+
+    dmRender::GetFrameRingStats(m_Context, dmRender::RENDER_BUFFER_TYPE_VERTEX_BUFFER, &stats);
+    ASSERT_EQ(1u, stats.m_Wraps);
+
+    dmRender::FlushFrameRings(m_Context);
+    dmRender::RenderListBegin(m_Context);
+    ASSERT_LE(segment_size + 36, ring->m_SegmentSize);
+    ASSERT_EQ(1u, ring->m_Buffers.Size());
+
+    dmRender::GetFrameRingStats(m_Context, dmRender::RENDER_BUFFER_TYPE_VERTEX_BUFFER, &stats);
+    ASSERT_EQ(0u, stats.m_Bytes);
+    ASSERT_EQ(0u, stats.m_Wraps);
+
+    // Multi-buffered adapters get a buffer per flush, sized to what was written
+    m_Context->m_MultiBufferingRequired = 1;
+    WriteFrameRing(m_Context, 16, 4, 4, &a);
+    dmRender::FlushFrameRings(m_Context);
+    WriteFrameRing(m_Context, 8, 4, 5, &b);
+    dmRender::FlushFrameRings(m_Context);
+    m_Context->m_MultiBufferingRequired = 0;
+
+    ASSERT_NE(a.m_Buffer, b.m_Buffer);
+    ASSERT_EQ(0u, b.m_Offset);
+    ASSERT_EQ(16u, ((dmGraphics::VertexBuffer*) a.m_Buffer)->m_Size);
+    ASSERT_EQ(8u, ((dmGraphics::VertexBuffer*) b.m_Buffer)->m_Size);
+    ASSERT_EQ(5, ((dmGraphics::VertexBuffer*) b.m_Buffer)->m_Buffer[7]);
+}
+
 static float Metric(const char* text, int n, bool measure_trailing_space)
 {
     return n * 4;
@@ -59,6 +59,17 @@ namespace dmLoadQueue
 
     // Free once completed.
     void FreeLoad(HQueue queue, HRequest request);
+
+    // Reads the file ahead of time, while the queue has no requests to load, so that a later BeginLoad of the
+    // same path doesn't have to wait for the read. Files are read in the order they are added. The path is copied.
+    void Prefetch(HQueue queue, const char* canonical_path);
+
+    // Drops all files added with Prefetch, and frees the data read for them. A file that is being read
+    // is freed by the load thread once the read is done.
+    void CancelPrefetch(HQueue queue);
+
+    // Size of the prefetched data that hasn't been picked up by a request
+    uint64_t GetPrefetchedSize(HQueue queue);
 } // namespace dmLoadQueue
 
 #endif // DM_RESOURCE_LOAD_QUEUE_H
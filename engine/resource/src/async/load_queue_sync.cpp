@@ -15,6 +15,7 @@
 #include "resource.h"
 #include "resource_private.h"
 #include "load_queue.h"
+#include "resource_trace.h"
 
 #include <dlib/dstrings.h>
 #include <dlib/log.h>
@@ -63,6 +64,7 @@ namespace dmLoadQueue
         queue->m_ActiveRequest->m_Name          = name;
         queue->m_ActiveRequest->m_CanonicalPath = canonical_path;
         queue->m_ActiveRequest->m_PreloadInfo   = *info;
+        dmResourceTrace::Write(dmResourceTrace::EVENT_QUEUED, canonical_path, 0);
         return queue->m_ActiveRequest;
     }
 
@@ -86,7 +88,9 @@ namespace dmLoadQueue
             params.m_BufferSize          = *size;
             params.m_HintInfo            = &request->m_PreloadInfo.m_HintInfo;
             params.m_PreloadData         = &load_result->m_PreloadData;
+            dmResourceTrace::Write(dmResourceTrace::EVENT_PRELOAD_BEGIN, request->m_CanonicalPath, *size);
             load_result->m_PreloadResult = (dmResource::Result)request->m_PreloadInfo.m_CompleteFunction(&params);
+            dmResourceTrace::Write(dmResourceTrace::EVENT_PRELOAD_END, request->m_CanonicalPath, *size);
         }
         return RESULT_OK;
     }
@@ -97,4 +101,22 @@ namespace dmLoadQueue
         request->m_Name          = 0x0;
         request->m_CanonicalPath = 0x0;
     }
+
+    void Prefetch(HQueue queue, const char* canonical_path)
+    {
+        // Everything is loaded synchronously anyway, so there is nothing to gain from reading ahead
+        (void)queue;
+        (void)canonical_path;
+    }
+
+    void CancelPrefetch(HQueue queue)
+    {
+        (void)queue;
+    }
+
+    uint64_t GetPrefetchedSize(HQueue queue)
+    {
+        (void)queue;
+        return 0;
+    }
 } // namespace dmLoadQueue
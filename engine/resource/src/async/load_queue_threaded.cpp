@@ -15,10 +15,16 @@
 #include "resource.h"
 #include "resource_private.h"
 #include "load_queue.h"
+#include "resource_trace.h"
+
+#include <stdlib.h>
+#include <string.h>
 
 #include <dlib/dstrings.h>
 #include <dlib/log.h>
 #include <dlib/array.h>
+#include <dlib/hash.h>
+#include <dlib/hashtable.h>
 #include <dlib/thread.h>
 #include <dlib/mutex.h>
 #include <dlib/time.h>
@@ -37,6 +43,9 @@ namespace dmLoadQueue
     const uint64_t MAX_PENDING_DATA = 4 * 1024 * 1024;
     const uint32_t QUEUE_SLOTS      = 16;
 
+    // Once this amount of prefetched data hasn't been picked up by a request, it will stop prefetching more.
+    const uint64_t MAX_PREFETCH_DATA = 8 * 1024 * 1024;
+
     struct Request
     {
         const char*                m_Name;
@@ -46,6 +55,15 @@ namespace dmLoadQueue
         LoadResult                 m_Result;
     };
 
+    struct PrefetchItem
+    {
+        char*                      m_CanonicalPath;
+        dmResource::LoadBufferType m_Buffer;
+        dmResource::Result         m_LoadResult; // RESULT_PENDING until the file has been read
+        uint32_t                   m_Index;      // Index in Queue::m_Prefetch
+        bool                       m_Cancelled;  // Cancelled while being read, the load thread deletes it
+    };
+
     struct Queue
     {
         Request                                 m_Request[QUEUE_SLOTS];
@@ -59,6 +77,14 @@ namespace dmLoadQueue
         uint64_t                                m_BytesWaiting;
         bool                                    m_Shutdown;
 
+        // Files to read ahead of time, in order. An item is removed (and its slot set to 0) once a
+        // request for the same path picks it up. Only the load thread touches the items themselves.
+        dmArray<PrefetchItem*>                  m_Prefetch;
+        dmHashTable64<PrefetchItem*>            m_PrefetchLookup; // canonical path hash -> item
+        uint32_t                                m_PrefetchNext;   // Next item in m_Prefetch to read
+        uint64_t                                m_PrefetchBytes;  // Size of the read items
+        PrefetchItem*                           m_PrefetchReading; // Item the load thread is reading
+
         // Circular queue with indexing as follow (exclusive end)
         //
         //          m_Back           m_Loaded   m_Front
@@ -85,10 +111,72 @@ namespace dmLoadQueue
         return &queue->m_Request[queue->m_Loaded % QUEUE_SLOTS];
     }
 
+    // Assumes the mutex is held
+    static PrefetchItem* GetNextPrefetch(Queue* queue)
+    {
+        if (queue->m_PrefetchBytes >= MAX_PREFETCH_DATA)
+        {
+            return 0x0;
+        }
+
+        while (queue->m_PrefetchNext < queue->m_Prefetch.Size())
+        {
+            PrefetchItem* item = queue->m_Prefetch[queue->m_PrefetchNext++];
+            if (item)
+            {
+                queue->m_PrefetchReading = item;
+                return item;
+            }
+        }
+        return 0x0;
+    }
+
+    // Removes any prefetch item of the request's path. If the file has already been read, the data is
+    // handed over to the request and true is returned. Assumes the mutex is held
+    static bool TakePrefetched(Queue* queue, Request* request)
+    {
+        if (queue->m_PrefetchLookup.Empty())
+        {
+            return false;
+        }
+
+        dmhash_t path_hash = dmHashString64(request->m_CanonicalPath);
+        PrefetchItem** lookup = queue->m_PrefetchLookup.Get(path_hash);
+        if (!lookup)
+        {
+            return false;
+        }
+
+        PrefetchItem* item = *lookup;
+        queue->m_PrefetchLookup.Erase(path_hash);
+        queue->m_Prefetch[item->m_Index] = 0x0;
+        if (queue->m_PrefetchLookup.Empty())
+        {
+            queue->m_Prefetch.SetSize(0);
+            queue->m_PrefetchNext = 0;
+        }
+
+        bool prefetched = item->m_LoadResult == dmResource::RESULT_OK;
+        if (item->m_LoadResult != dmResource::RESULT_PENDING)
+        {
+            queue->m_PrefetchBytes -= item->m_Buffer.Capacity();
+        }
+        if (prefetched)
+        {
+            request->m_Buffer.Swap(item->m_Buffer);
+        }
+
+        free(item->m_CanonicalPath);
+        delete item;
+        return prefetched;
+    }
+
     static void LoadThread(void* arg)
     {
         Queue* queue     = (Queue*)arg;
         Request* current = 0;
+        PrefetchItem* prefetch = 0;
+        bool prefetched = false;
         LoadResult result;
         while (true)
         {
@@ -102,6 +190,20 @@ namespace dmLoadQueue
                     current->m_Result = result;
                     current           = 0;
                 }
+                if (prefetch != 0)
+                {
+                    if (prefetch->m_Cancelled)
+                    {
+                        free(prefetch->m_CanonicalPath);
+                        delete prefetch;
+                    }
+                    else
+                    {
+                        queue->m_PrefetchBytes += prefetch->m_Buffer.Capacity();
+                    }
+                    queue->m_PrefetchReading = 0;
+                    prefetch = 0;
+                }
                 if (queue->m_Shutdown)
                 {
                     return;
@@ -109,6 +211,10 @@ namespace dmLoadQueue
 
                 current = GetNextRequest(queue);
                 if (current == 0x0)
+                {
+                    prefetch = GetNextPrefetch(queue);
+                }
+                if (current == 0x0 && prefetch == 0x0)
                 {
                     // Nothing to do, reset any buffers of inactive requests that are not at default capacity
                     for (uint32_t i = 0; i < QUEUE_SLOTS; ++i)
@@ -125,21 +231,44 @@ namespace dmLoadQueue
                     }
                     dmConditionVariable::Wait(queue->m_WakeupCond, queue->m_Mutex);
                     current = GetNextRequest(queue);
+                    if (current == 0x0)
+                    {
+                        prefetch = GetNextPrefetch(queue);
+                    }
+                }
+
+                if (current)
+                {
+                    assert(current->m_Buffer.Size() == 0);
+                    prefetched = TakePrefetched(queue, current);
                 }
             }
 
+            if (prefetch)
+            {
+                uint32_t size = 0;
+                prefetch->m_LoadResult = dmResource::LoadResourceFromBuffer(queue->m_Factory, prefetch->m_CanonicalPath, prefetch->m_CanonicalPath, &size, &prefetch->m_Buffer);
+            }
+
             if (current)
             {
                 // We use the temporary result object here to fill in the data so it can be written with the mutex held.
                 uint32_t size = 0;
 
-                assert(current->m_Buffer.Size() == 0);
-                if (current->m_Buffer.Capacity() != DEFAULT_CAPACITY)
+                if (prefetched)
                 {
-                    current->m_Buffer.SetCapacity(DEFAULT_CAPACITY);
+                    size = current->m_Buffer.Size();
+                    result.m_LoadResult = dmResource::RESULT_OK;
                 }
+                else
+                {
+                    if (current->m_Buffer.Capacity() != DEFAULT_CAPACITY)
+                    {
+                        current->m_Buffer.SetCapacity(DEFAULT_CAPACITY);
+                    }
 
-                result.m_LoadResult = dmResource::LoadResourceFromBuffer(queue->m_Factory, current->m_CanonicalPath, current->m_Name, &size, &current->m_Buffer);
+                    result.m_LoadResult = dmResource::LoadResourceFromBuffer(queue->m_Factory, current->m_CanonicalPath, current->m_Name, &size, &current->m_Buffer);
+                }
                 result.m_PreloadResult = dmResource::RESULT_PENDING;
                 result.m_PreloadData   = 0;
 
@@ -155,7 +284,9 @@ namespace dmLoadQueue
                         params.m_BufferSize    = current->m_Buffer.Size();
                         params.m_HintInfo      = &current->m_PreloadInfo.m_HintInfo;
                         params.m_PreloadData   = &result.m_PreloadData;
+                        dmResourceTrace::Write(dmResourceTrace::EVENT_PRELOAD_BEGIN, current->m_CanonicalPath, params.m_BufferSize);
                         result.m_PreloadResult = (dmResource::Result)current->m_PreloadInfo.m_CompleteFunction(&params);
+                        dmResourceTrace::Write(dmResourceTrace::EVENT_PRELOAD_END, current->m_CanonicalPath, params.m_BufferSize);
                     }
                     else
                     {
@@ -175,6 +306,9 @@ namespace dmLoadQueue
         q->m_Loaded       = 0;
         q->m_Shutdown     = false;
         q->m_BytesWaiting = 0;
+        q->m_PrefetchNext  = 0;
+        q->m_PrefetchBytes = 0;
+        q->m_PrefetchReading = 0;
         q->m_Mutex        = dmMutex::New();
         q->m_WakeupCond   = dmConditionVariable::New();
         q->m_Thread       = dmThread::New(&LoadThread, 128 * 1024, q, "AsyncLoad");
@@ -191,6 +325,15 @@ namespace dmLoadQueue
             dmConditionVariable::Signal(queue->m_WakeupCond);
         }
         dmThread::Join(queue->m_Thread);
+        for (uint32_t i = 0; i < queue->m_Prefetch.Size(); ++i)
+        {
+            PrefetchItem* item = queue->m_Prefetch[i];
+            if (item)
+            {
+                free(item->m_CanonicalPath);
+                delete item;
+            }
+        }
         dmConditionVariable::Delete(queue->m_WakeupCond);
         dmMutex::Delete(queue->m_Mutex);
         delete queue;
@@ -222,6 +365,7 @@ namespace dmLoadQueue
         req->m_PreloadInfo         = *info;
         req->m_Result.m_LoadResult = dmResource::RESULT_PENDING;
 
+        dmResourceTrace::Write(dmResourceTrace::EVENT_QUEUED, canonical_path, 0);
         return req;
     }
 
@@ -266,4 +410,79 @@ namespace dmLoadQueue
             queue->m_Back++;
         }
     }
+
+    void Prefetch(HQueue queue, const char* canonical_path)
+    {
+        dmhash_t path_hash = dmHashString64(canonical_path);
+
+        dmMutex::ScopedLock lk(queue->m_Mutex);
+
+        if (queue->m_PrefetchLookup.Get(path_hash))
+        {
+            return;
+        }
+
+        if (queue->m_PrefetchLookup.Full())
+        {
+            uint32_t capacity = queue->m_PrefetchLookup.Capacity() + 256;
+            queue->m_PrefetchLookup.SetCapacity((capacity * 2) / 3, capacity);
+        }
+        if (queue->m_Prefetch.Full())
+        {
+            queue->m_Prefetch.OffsetCapacity(256);
+        }
+
+        PrefetchItem* item    = new PrefetchItem;
+        item->m_CanonicalPath = strdup(canonical_path);
+        item->m_LoadResult    = dmResource::RESULT_PENDING;
+        item->m_Index         = queue->m_Prefetch.Size();
+        item->m_Cancelled     = false;
+        queue->m_Prefetch.Push(item);
+        queue->m_PrefetchLookup.Put(path_hash, item);
+
+        if (queue->m_Loaded == queue->m_Front)
+        {
+            // The worker might be sleeping waiting for requests, wake it up
+            dmConditionVariable::Signal(queue->m_WakeupCond);
+        }
+    }
+
+    void CancelPrefetch(HQueue queue)
+    {
+        dmMutex::ScopedLock lk(queue->m_Mutex);
+
+        for (uint32_t i = 0; i < queue->m_Prefetch.Size(); ++i)
+        {
+            PrefetchItem* item = queue->m_Prefetch[i];
+            if (item == 0x0)
+            {
+                continue;
+            }
+
+            if (item == queue->m_PrefetchReading)
+            {
+                // The load thread is reading into it without the mutex held
+                item->m_Cancelled = true;
+                continue;
+            }
+
+            if (item->m_LoadResult != dmResource::RESULT_PENDING)
+            {
+                queue->m_PrefetchBytes -= item->m_Buffer.Capacity();
+            }
+            free(item->m_CanonicalPath);
+            delete item;
+        }
+
+        assert(queue->m_PrefetchBytes == 0);
+        queue->m_Prefetch.SetSize(0);
+        queue->m_PrefetchLookup.Clear();
+        queue->m_PrefetchNext = 0;
+    }
+
+    uint64_t GetPrefetchedSize(HQueue queue)
+    {
+        dmMutex::ScopedLock lk(queue->m_Mutex);
+        return queue->m_PrefetchBytes;
+    }
 } // namespace dmLoadQueue
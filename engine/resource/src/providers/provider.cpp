@@ -130,6 +130,13 @@ Result GetFileSize(HArchive archive, dmhash_t path_hash, const char* path, uint3
     return archive->m_Loader->m_GetFileSize(archive->m_Internal, path_hash, path, file_size);
 }
 
+Result GetFileOffset(HArchive archive, dmhash_t path_hash, const char* path, uint32_t* file_offset)
+{
+    if (archive->m_Loader->m_GetFileOffset)
+        return archive->m_Loader->m_GetFileOffset(archive->m_Internal, path_hash, path, file_offset);
+    return RESULT_NOT_SUPPORTED;
+}
+
 Result ReadFile(HArchive archive, dmhash_t path_hash, const char* path, uint8_t* buffer, uint32_t buffer_len)
 {
     return archive->m_Loader->m_ReadFile(archive->m_Internal, path_hash, path, buffer, buffer_len);
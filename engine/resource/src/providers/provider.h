@@ -49,6 +49,7 @@ namespace dmResourceProvider
     typedef Result (*FUnmount)(HArchiveInternal archive);
 
     typedef Result (*FGetFileSize)(HArchiveInternal archive, dmhash_t path_hash, const char* path, uint32_t* file_size);
+    typedef Result (*FGetFileOffset)(HArchiveInternal archive, dmhash_t path_hash, const char* path, uint32_t* file_offset); // Optional. Where the data is stored in the archive, for read ordering
     typedef Result (*FReadFile)(HArchiveInternal archive, dmhash_t path_hash, const char* path, uint8_t* buffer, uint32_t buffer_len);
     typedef Result (*FWriteFile)(HArchiveInternal archive, dmhash_t path_hash, const char* path, const uint8_t* buffer, uint32_t buffer_len);
     typedef Result (*FGetManifest)(HArchiveInternal, dmResource::HManifest*); // In order for other providers to get the base manifest
@@ -70,6 +71,7 @@ namespace dmResourceProvider
     Result SetManifest(HArchive archive, dmResource::HManifest manifest);
 
     Result GetFileSize(HArchive archive, dmhash_t path_hash, const char* path, uint32_t* file_size);
+    Result GetFileOffset(HArchive archive, dmhash_t path_hash, const char* path, uint32_t* file_offset);
     Result ReadFile(HArchive archive, dmhash_t path_hash, const char* path, uint8_t* buffer, uint32_t buffer_len);
     Result WriteFile(HArchive archive, dmhash_t path_hash, const char* path, const uint8_t* buffer, uint32_t buffer_len);
 
@@ -219,6 +219,19 @@ namespace dmResourceProviderArchive
         return dmResourceProvider::RESULT_NOT_FOUND;
     }
 
+    static dmResourceProvider::Result GetFileOffset(dmResourceProvider::HArchiveInternal internal, dmhash_t path_hash, const char* path, uint32_t* file_offset)
+    {
+        GameArchiveFile* archive = (GameArchiveFile*)internal;
+        EntryInfo* entry = archive->m_EntryMap.Get(path_hash);
+        if (entry)
+        {
+            *file_offset = dmEndian::ToNetwork(entry->m_ArchiveInfo->m_ResourceDataOffset);
+            return dmResourceProvider::RESULT_OK;
+        }
+
+        return dmResourceProvider::RESULT_NOT_FOUND;
+    }
+
     static dmResourceProvider::Result ReadFile(dmResourceProvider::HArchiveInternal internal, dmhash_t path_hash, const char* path, uint8_t* buffer, uint32_t buffer_len)
     {
         GameArchiveFile* archive = (GameArchiveFile*)internal;
@@ -252,6 +265,7 @@ namespace dmResourceProviderArchive
         loader->m_Unmount       = Unmount;
         loader->m_GetManifest   = GetManifest;
         loader->m_GetFileSize   = GetFileSize;
+        loader->m_GetFileOffset = GetFileOffset;
         loader->m_ReadFile      = ReadFile;
     }
 
@@ -31,6 +31,10 @@
 namespace dmResourceProviderHttp
 {
 
+// Files at least this large are downloaded as byte ranges over several connections
+const uint32_t PARALLEL_DOWNLOAD_MIN_SIZE = 4 * 1024 * 1024;
+const uint32_t PARALLEL_DOWNLOAD_CONNECTIONS = 4;
+
 struct HttpProviderContext
 {
     dmURI::Parts            m_BaseUri;
@@ -231,6 +235,21 @@ static dmResourceProvider::Result ReadFile(dmResourceProvider::HArchiveInternal
     HttpProviderContext* archive = (HttpProviderContext*)_archive;
     (void)path_hash;
 
+    // The range downloads bypass the http cache
+    if (_buffer_len >= PARALLEL_DOWNLOAD_MIN_SIZE && archive->m_HttpCache == 0)
+    {
+        char encoded_uri[dmResource::RESOURCE_PATH_MAX*2];
+        CreateEncodedUri(&archive->m_BaseUri, path, encoded_uri, sizeof(encoded_uri));
+
+        uint32_t size;
+        dmHttpClient::Result http_result = dmHttpClient::GetRanges(archive->m_HttpClient, encoded_uri, buffer, _buffer_len, PARALLEL_DOWNLOAD_CONNECTIONS, &size);
+        if (http_result == dmHttpClient::RESULT_OK)
+        {
+            return dmResourceProvider::RESULT_OK;
+        }
+        // Fall back to a regular request, which also reports the error properly
+    }
+
     uint32_t buffer_len = _buffer_len;
     dmResourceProvider::Result result = GetRequestFromUri((HttpProviderContext*)archive, "GET", path, &buffer_len, buffer);
     if (result != dmResourceProvider::RESULT_OK)
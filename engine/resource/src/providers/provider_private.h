@@ -37,6 +37,7 @@ namespace dmResourceProvider
         FSetManifest            m_SetManifest;      // For mutable archive
 
         FGetFileSize            m_GetFileSize;
+        FGetFileOffset          m_GetFileOffset;    // For archives with a data file
         FReadFile               m_ReadFile;
         FWriteFile              m_WriteFile;        // For writeable archives
 
@@ -19,6 +19,7 @@
 #include "../resource_manifest.h"
 #include "../resource_manifest_private.h"
 #include "../resource_private.h"
+#include "../resource_trace.h"
 
 #include <dlib/dstrings.h>
 #include <dlib/endian.h>
@@ -271,7 +272,9 @@ static dmResourceProvider::Result UnpackData(const char* path, dmLiveUpdateDDF::
     if (compressed)
     {
         int decompressed_size;
+        dmResourceTrace::Write(dmResourceTrace::EVENT_DECOMPRESS_BEGIN, path, compressed_size);
         dmLZ4::Result r = dmLZ4::DecompressBuffer((const uint8_t*)resource.m_Data, compressed_size, out_buffer, resource_size, &decompressed_size);
+        dmResourceTrace::Write(dmResourceTrace::EVENT_DECOMPRESS_END, path, resource_size);
         if (dmLZ4::RESULT_OK != r)
         {
             dmLogError("Failed to decompress resource: '%s", path);
@@ -28,6 +28,7 @@
 #include <dlib/dalloca.h>
 #include <dlib/dstrings.h>
 #include <dlib/hash.h>
+#include <dlib/flat_hashtable.h>
 #include <dlib/hashtable.h>
 #include <dlib/log.h>
 #include <dlib/math.h>
@@ -36,6 +37,7 @@
 #include <dlib/mutex.h>
 #include <dlib/path.h>
 #include <dlib/profile.h>
+#include <dlib/spinlock.h>
 #include <dlib/sys.h>
 #include <dlib/time.h>
 #include <dlib/uri.h>
@@ -44,6 +46,7 @@
 #include "resource_manifest.h"
 #include "resource_mounts.h"
 #include "resource_private.h"
+#include "resource_trace.h"
 #include "resource_util.h"
 #include <resource/resource_ddf.h>
 #include <dmsdk/resource/resource.h>
@@ -73,12 +76,29 @@ struct ResourceReloadedCallbackPair
 };
 
 const uint32_t MAX_RESOURCE_TYPES = 128;
+const uint32_t RESOURCE_SHARD_COUNT = 16; // Must be a power of two
+
+// The lookup tables of the loaded resources are split into shards, each with its own lock,
+// so that getting and releasing already loaded resources from several threads doesn't
+// serialize on the load mutex. The tables map to indices in ResourceFactory::m_Descriptors,
+// which means that a shard table may grow without moving any descriptors.
+struct ResourceShard
+{
+    dmSpinlock::Spinlock                         m_Lock;
+    // Keyed on the canonical path hash
+    dmFlatHashTable64<uint32_t>                  m_PathToDescriptor;
+    // Keyed on the resource pointer. Lives in the shard of the pointer, not the path hash
+    dmFlatHashTable<uintptr_t, uint32_t>         m_ResourceToDescriptor;
+};
 
 struct ResourceFactory
 {
-    // TODO: Arg... budget. Two hash-maps. Really necessary?
-    dmHashTable64<ResourceDescriptor>*          m_Resources;
-    dmHashTable<uintptr_t, uint64_t>*            m_ResourceToHash;
+    ResourceShard                                m_Shards[RESOURCE_SHARD_COUNT];
+    // All descriptors, allocated up front (one per "resource.max_resources"). Unused ones have m_Resource == 0
+    ResourceDescriptor*                          m_Descriptors;
+    // Indices of the unused descriptors. Guarded by m_LoadMutex
+    dmArray<uint32_t>                            m_FreeDescriptors;
+    uint32_t                                     m_MaxResources;
     // Only valid if RESOURCE_FACTORY_FLAGS_RELOAD_SUPPORT is set
     // Used for reloading of resources
     dmHashTable64<const char*>*                  m_ResourceHashToFilename;
@@ -90,6 +110,8 @@ struct ResourceFactory
     // Guard for anything that touches anything that could be shared
     // with GetRaw (used for async threaded loading). Liveupdate, HttpClient, m_Buffer
     // m_BuiltinsManifest, m_Manifest
+    // Also held while creating and inserting resources and while removing destroyed ones, but not
+    // when getting or releasing a loaded resource (see ResourceShard) or calling a destroy function
     dmMutex::HMutex                              m_LoadMutex;
 
     // dmResource::Get recursion depth
@@ -140,6 +162,112 @@ static inline uint16_t IncreaseVersion(HResourceFactory factory)
     return next_version;
 }
 
+static inline ResourceShard* GetShard(HFactory factory, uint64_t key)
+{
+    // The keys are either hashes or (aligned) pointers, so mix all the bits into the shard index
+    key ^= key >> 33;
+    key *= 0xff51afd7ed558ccdULL;
+    key ^= key >> 33;
+    return &factory->m_Shards[key & (RESOURCE_SHARD_COUNT - 1)];
+}
+
+// Assumes the shard lock is held
+template <typename KEY>
+static void PutDescriptorIndex(dmFlatHashTable<KEY, uint32_t>* table, KEY key, uint32_t index)
+{
+    if (table->Full())
+    {
+        uint32_t capacity = table->Capacity() + dmMath::Max(16u, table->Capacity() / 2);
+        table->SetCapacity(dmMath::Max(1u, (3 * capacity) / 4), capacity);
+    }
+    table->Put(key, index);
+}
+
+// Returns the descriptor of a loaded resource, without adding a reference
+static ResourceDescriptor* FindDescriptor(HFactory factory, uint64_t canonical_path_hash)
+{
+    ResourceShard* shard = GetShard(factory, canonical_path_hash);
+    DM_SPINLOCK_SCOPED_LOCK(shard->m_Lock);
+    uint32_t* index = shard->m_PathToDescriptor.Get(canonical_path_hash);
+    return index ? &factory->m_Descriptors[*index] : 0;
+}
+
+static ResourceDescriptor* FindDescriptorByResource(HFactory factory, const void* resource)
+{
+    ResourceShard* shard = GetShard(factory, (uintptr_t) resource);
+    DM_SPINLOCK_SCOPED_LOCK(shard->m_Lock);
+    uint32_t* index = shard->m_ResourceToDescriptor.Get((uintptr_t) resource);
+    return index ? &factory->m_Descriptors[*index] : 0;
+}
+
+// Adds a reference to a loaded resource and returns its descriptor.
+// A resource whose last reference has been released is destroyed by the releasing thread, once
+// it gets hold of m_LoadMutex and has checked that the resource is still unreferenced. Until then
+// the resource may be revived, but only by a caller that holds m_LoadMutex (`revive`).
+static ResourceDescriptor* AcquireDescriptor(HFactory factory, uint64_t canonical_path_hash, bool revive)
+{
+    ResourceShard* shard = GetShard(factory, canonical_path_hash);
+    DM_SPINLOCK_SCOPED_LOCK(shard->m_Lock);
+    uint32_t* index = shard->m_PathToDescriptor.Get(canonical_path_hash);
+    if (!index)
+        return 0;
+
+    ResourceDescriptor* rd = &factory->m_Descriptors[*index];
+    if (rd->m_ReferenceCount == 0 && !revive)
+        return 0;
+    ++rd->m_ReferenceCount;
+    return rd;
+}
+
+// Makes an unreferenced resource impossible to get by path, so that it can be destroyed without
+// holding m_LoadMutex. Returns false if the resource has been revived.
+// Assumes m_LoadMutex is already held
+static bool UnlinkDescriptorPath(HFactory factory, ResourceDescriptor* rd)
+{
+    uint64_t canonical_path_hash = rd->m_NameHash;
+    {
+        ResourceShard* shard = GetShard(factory, canonical_path_hash);
+        DM_SPINLOCK_SCOPED_LOCK(shard->m_Lock);
+        if (rd->m_ReferenceCount != 0)
+            return false;
+        shard->m_PathToDescriptor.Erase(canonical_path_hash);
+    }
+
+    if (factory->m_ResourceHashToFilename)
+    {
+        const char** s = factory->m_ResourceHashToFilename->Get(canonical_path_hash);
+        factory->m_ResourceHashToFilename->Erase(canonical_path_hash);
+        assert(s);
+        free((void*) *s);
+    }
+    return true;
+}
+
+// Frees a descriptor unlinked with UnlinkDescriptorPath, once its resource has been destroyed
+// Assumes m_LoadMutex is already held
+static void RemoveDescriptor(HFactory factory, ResourceDescriptor* rd)
+{
+    uint32_t index = (uint32_t)(rd - factory->m_Descriptors);
+    {
+        // The memory of the destroyed resource may already have been reused by a new resource
+        ResourceShard* shard = GetShard(factory, (uintptr_t) rd->m_Resource);
+        DM_SPINLOCK_SCOPED_LOCK(shard->m_Lock);
+        uint32_t* resource_index = shard->m_ResourceToDescriptor.Get((uintptr_t) rd->m_Resource);
+        if (resource_index && *resource_index == index)
+        {
+            shard->m_ResourceToDescriptor.Erase((uintptr_t) rd->m_Resource);
+        }
+    }
+
+    memset(rd, 0, sizeof(*rd));
+    factory->m_FreeDescriptors.Push(index);
+}
+
+static uint32_t GetResourceCount(HFactory factory)
+{
+    return factory->m_MaxResources - factory->m_FreeDescriptors.Size();
+}
+
 Result CheckSuppliedResourcePath(const char* name)
 {
     if (name[0] == 0)
@@ -328,11 +456,25 @@ HFactory NewFactory(NewFactoryParams* params, const char* uri)
     factory->m_ResourceTypesCount = 0;
 
     const uint32_t table_size = dmMath::Max(1u, (3 * params->m_MaxResources) / 4);
-    factory->m_Resources = new dmHashTable64<ResourceDescriptor>();
-    factory->m_Resources->SetCapacity(table_size, params->m_MaxResources);
+    factory->m_MaxResources = params->m_MaxResources;
+    factory->m_Descriptors = (ResourceDescriptor*) calloc(factory->m_MaxResources, sizeof(ResourceDescriptor));
+    factory->m_FreeDescriptors.SetCapacity(factory->m_MaxResources);
+    for (uint32_t i = 0; i < factory->m_MaxResources; ++i)
+    {
+        // Reversed, so that the descriptors are used in order
+        factory->m_FreeDescriptors.Push(factory->m_MaxResources - 1 - i);
+    }
 
-    factory->m_ResourceToHash = new dmHashTable<uintptr_t, uint64_t>();
-    factory->m_ResourceToHash->SetCapacity(table_size, params->m_MaxResources);
+    // The shard tables start out with room for twice their share, and grow if needed
+    const uint32_t shard_capacity = dmMath::Max(16u, (2 * params->m_MaxResources) / RESOURCE_SHARD_COUNT);
+    const uint32_t shard_table_size = dmMath::Max(1u, (3 * shard_capacity) / 4);
+    for (uint32_t i = 0; i < RESOURCE_SHARD_COUNT; ++i)
+    {
+        ResourceShard* shard = &factory->m_Shards[i];
+        dmSpinlock::Create(&shard->m_Lock);
+        shard->m_PathToDescriptor.SetCapacity(shard_table_size, shard_capacity);
+        shard->m_ResourceToDescriptor.SetCapacity(shard_table_size, shard_capacity);
+    }
 
     if (params->m_Flags & RESOURCE_FACTORY_FLAGS_RELOAD_SUPPORT)
     {
@@ -358,11 +500,6 @@ HFactory NewFactory(NewFactoryParams* params, const char* uri)
     return factory;
 }
 
-static void ResourceIteratorCallback(void*, const dmhash_t* id, ResourceDescriptor* resource)
-{
-    dmLogError("Resource: %s  ref count: %u", dmHashReverseSafe64(*id), resource->m_ReferenceCount);
-}
-
 void DeleteFactory(HFactory factory)
 {
     if (factory->m_Socket)
@@ -379,15 +516,28 @@ void DeleteFactory(HFactory factory)
     if (factory->m_Mounts)
         dmResourceMounts::Destroy(factory->m_Mounts);
 
-    if (factory->m_Resources && !factory->m_Resources->Empty())
+    if (factory->m_Descriptors && GetResourceCount(factory) != 0)
     {
         dmLogError("Leaked resources:");
-        factory->m_Resources->Iterate<>(&ResourceIteratorCallback, (void*)0);
+        for (uint32_t i = 0; i < factory->m_MaxResources; ++i)
+        {
+            ResourceDescriptor* rd = &factory->m_Descriptors[i];
+            if (rd->m_Resource)
+            {
+                dmLogError("Resource: %s  ref count: %u", dmHashReverseSafe64(rd->m_NameHash), rd->m_ReferenceCount);
+            }
+        }
     }
 
     free((void*)factory->m_PublicKeyPath);
-    delete factory->m_Resources;
-    delete factory->m_ResourceToHash;
+    if (factory->m_Descriptors)
+    {
+        free(factory->m_Descriptors);
+        for (uint32_t i = 0; i < RESOURCE_SHARD_COUNT; ++i)
+        {
+            dmSpinlock::Destroy(&factory->m_Shards[i].m_Lock);
+        }
+    }
     if (factory->m_ResourceHashToFilename)
         delete factory->m_ResourceHashToFilename;
     if (factory->m_ResourceReloadedCallbacks)
@@ -431,7 +581,7 @@ void UpdateFactory(HFactory factory)
 {
     DM_PROFILE(__FUNCTION__);
     dmMessage::Dispatch(factory->m_Socket, &Dispatch, factory);
-    DM_PROPERTY_ADD_U32(rmtp_Resource, factory->m_Resources->Size());
+    DM_PROPERTY_ADD_U32(rmtp_Resource, GetResourceCount(factory));
 }
 
 HResourceType AllocateResourceType(HFactory factory, const char* extension)
@@ -575,6 +725,7 @@ static void ResourceDependencyCallback(void* _context, const dmResourceMounts::S
 
     dmResource::SGetDependenciesResult out;
     out.m_UrlHash           = result->m_UrlHash;
+    out.m_Url               = result->m_Url;
     out.m_HashDigest        = result->m_HashDigest;
     out.m_HashDigestLength  = result->m_HashDigestLength;
     out.m_Missing           = result->m_Missing;
@@ -626,7 +777,9 @@ static Result LoadResourceFromBufferLocked(HFactory factory, const char* path, c
         }
         buffer->SetSize(0);
 
+        dmResourceTrace::Write(dmResourceTrace::EVENT_READ_BEGIN, normalized_path, 0);
         r = dmResourceMounts::ReadResource(factory->m_Mounts, normalized_path_hash, normalized_path, (uint8_t*)buffer->Begin(), file_size);
+        dmResourceTrace::Write(dmResourceTrace::EVENT_READ_END, normalized_path, file_size);
         if (r == dmResource::RESULT_OK)
         {
             buffer->SetSize(file_size);
@@ -695,7 +848,9 @@ static Result DoCreateResource(HFactory factory, ResourceType* resource_type, co
         params.m_PreloadData = &preload_data;
         params.m_Filename    = name;
         params.m_HintInfo    = 0; // No hinting now
+        dmResourceTrace::Write(dmResourceTrace::EVENT_PRELOAD_BEGIN, canonical_path, buffer_size);
         create_error         = (Result)resource_type->m_PreloadFunction(&params);
+        dmResourceTrace::Write(dmResourceTrace::EVENT_PRELOAD_END, canonical_path, buffer_size);
     }
 
     if (create_error == RESULT_OK)
@@ -712,7 +867,9 @@ static Result DoCreateResource(HFactory factory, ResourceType* resource_type, co
         params.m_PreloadData = preload_data;
         params.m_Resource    = &tmp_resource;
         params.m_Filename    = name;
+        dmResourceTrace::Write(dmResourceTrace::EVENT_CREATE_BEGIN, canonical_path, buffer_size);
         create_error         = (Result)resource_type->m_CreateFunction(&params);
+        dmResourceTrace::Write(dmResourceTrace::EVENT_CREATE_END, canonical_path, buffer_size);
     }
 
     if (create_error == RESULT_OK && resource_type->m_PostCreateFunction)
@@ -725,7 +882,9 @@ static Result DoCreateResource(HFactory factory, ResourceType* resource_type, co
         params.m_Resource    = &tmp_resource;
         for(;;)
         {
+            dmResourceTrace::Write(dmResourceTrace::EVENT_POST_CREATE_BEGIN, canonical_path, 0);
             create_error = (Result)resource_type->m_PostCreateFunction(&params);
+            dmResourceTrace::Write(dmResourceTrace::EVENT_POST_CREATE_END, canonical_path, 0);
             if(create_error != RESULT_PENDING)
                 break;
             dmTime::Sleep(1000);
@@ -770,18 +929,16 @@ static Result PrepareResourceCreation(HFactory factory, const char* canonical_pa
     *resource_out = 0;
 
     // Try to get from already loaded resources
-    ResourceDescriptor* rd = factory->m_Resources->Get(canonical_path_hash);
+    ResourceDescriptor* rd = AcquireDescriptor(factory, canonical_path_hash, true);
     if (rd)
     {
-        assert(factory->m_ResourceToHash->Get((uintptr_t) rd->m_Resource));
-        rd->m_ReferenceCount++;
         *resource_out = rd->m_Resource;
         return RESULT_OK;
     }
 
-    if (factory->m_Resources->Full())
+    if (factory->m_FreeDescriptors.Empty())
     {
-        dmLogError("The max number of resources (%d) has been passed, tweak \"%s\" in the config file.", factory->m_Resources->Capacity(), MAX_RESOURCES_KEY);
+        dmLogError("The max number of resources (%d) has been passed, tweak \"%s\" in the config file.", factory->m_MaxResources, MAX_RESOURCES_KEY);
         return RESULT_OUT_OF_RESOURCES;
     }
 
@@ -883,6 +1040,19 @@ Result Get(HFactory factory, const char* name, void** resource)
     if (chk != RESULT_OK)
         return chk;
 
+    // Fast path for resources that are already loaded, which doesn't need the load mutex
+    {
+        char canonical_path[RESOURCE_PATH_MAX];
+        GetCanonicalPath(name, canonical_path);
+        dmhash_t canonical_path_hash = dmHashBuffer64(canonical_path, strlen(canonical_path));
+        ResourceDescriptor* rd = AcquireDescriptor(factory, canonical_path_hash, false);
+        if (rd)
+        {
+            *resource = rd->m_Resource;
+            return RESULT_OK;
+        }
+    }
+
     dmMutex::ScopedLock lk(factory->m_LoadMutex);
 
     dmArray<const char*>& stack = factory->m_GetResourceStack;
@@ -923,34 +1093,61 @@ Result Get(HFactory factory, const char* name, void** resource)
 
 ResourceDescriptor* FindByHash(HFactory factory, uint64_t canonical_path_hash)
 {
-    return factory->m_Resources->Get(canonical_path_hash);
+    return FindDescriptor(factory, canonical_path_hash);
+}
+
+ResourceDescriptor* AcquireByHash(HFactory factory, uint64_t canonical_path_hash)
+{
+    ResourceDescriptor* rd = AcquireDescriptor(factory, canonical_path_hash, false);
+    if (!rd && FindDescriptor(factory, canonical_path_hash))
+    {
+        // The last reference was just released, revive it unless it's destroyed first
+        dmMutex::ScopedLock lk(factory->m_LoadMutex);
+        rd = AcquireDescriptor(factory, canonical_path_hash, true);
+    }
+    return rd;
 }
 
 Result Get(HFactory factory, dmhash_t name, void** resource)
 {
-    ResourceDescriptor* rd = FindByHash(factory, name);
+    ResourceDescriptor* rd = AcquireByHash(factory, name);
     if (!rd)
     {
         return RESULT_RESOURCE_NOT_FOUND;
     }
-    dmResource::IncRef(factory, rd->m_Resource);
     *resource = rd->m_Resource;
     return RESULT_OK;
 }
 
 Result InsertResource(HFactory factory, const char* path, uint64_t canonical_path_hash, ResourceDescriptor* descriptor)
 {
-    if (factory->m_Resources->Full())
+    dmMutex::ScopedLock lk(factory->m_LoadMutex);
+
+    if (factory->m_FreeDescriptors.Empty())
     {
-        dmLogError("The max number of resources (%d) has been passed, tweak \"%s\" in the config file.", factory->m_Resources->Capacity(), MAX_RESOURCES_KEY);
+        dmLogError("The max number of resources (%d) has been passed, tweak \"%s\" in the config file.", factory->m_MaxResources, MAX_RESOURCES_KEY);
         return RESULT_OUT_OF_RESOURCES;
     }
 
     assert(descriptor->m_Resource);
     assert(descriptor->m_ReferenceCount == 1);
+    assert(FindDescriptor(factory, canonical_path_hash) == 0);
 
-    factory->m_Resources->Put(canonical_path_hash, *descriptor);
-    factory->m_ResourceToHash->Put((uintptr_t) descriptor->m_Resource, canonical_path_hash);
+    uint32_t index = factory->m_FreeDescriptors.Back();
+    factory->m_FreeDescriptors.Pop();
+    factory->m_Descriptors[index] = *descriptor;
+    factory->m_Descriptors[index].m_NameHash = canonical_path_hash;
+    {
+        ResourceShard* shard = GetShard(factory, (uintptr_t) descriptor->m_Resource);
+        DM_SPINLOCK_SCOPED_LOCK(shard->m_Lock);
+        PutDescriptorIndex(&shard->m_ResourceToDescriptor, (uintptr_t) descriptor->m_Resource, index);
+    }
+    {
+        // Inserted last, as it's what makes the resource visible to Get()
+        ResourceShard* shard = GetShard(factory, canonical_path_hash);
+        DM_SPINLOCK_SCOPED_LOCK(shard->m_Lock);
+        PutDescriptorIndex(&shard->m_PathToDescriptor, canonical_path_hash, index);
+    }
     if (factory->m_ResourceHashToFilename)
     {
         char canonical_path[RESOURCE_PATH_MAX];
@@ -1003,7 +1200,7 @@ static Result DoReloadResource(HFactory factory, const char* name, HResourceDesc
 
     uint64_t canonical_path_hash = dmHashBuffer64(canonical_path, strlen(canonical_path));
 
-    ResourceDescriptor* rd = factory->m_Resources->Get(canonical_path_hash);
+    ResourceDescriptor* rd = FindDescriptor(factory, canonical_path_hash);
 
     if (out_descriptor)
         *out_descriptor = rd;
@@ -1114,7 +1311,7 @@ Result SetResource(HFactory factory, uint64_t hashed_name, void* data, uint32_t
 
     assert(data);
 
-    ResourceDescriptor* rd = factory->m_Resources->Get(hashed_name);
+    ResourceDescriptor* rd = FindDescriptor(factory, hashed_name);
     if (!rd) {
         return RESULT_RESOURCE_NOT_FOUND;
     }
@@ -1171,7 +1368,7 @@ Result SetResource(HFactory factory, uint64_t hashed_name, void* message)
 
     assert(message);
 
-    ResourceDescriptor* rd = factory->m_Resources->Get(hashed_name);
+    ResourceDescriptor* rd = FindDescriptor(factory, hashed_name);
     if (!rd) {
         return RESULT_RESOURCE_NOT_FOUND;
     }
@@ -1220,15 +1417,12 @@ Result GetType(HFactory factory, void* resource, HResourceType* type)
 {
     assert(type);
 
-    uint64_t* resource_hash = factory->m_ResourceToHash->Get((uintptr_t) resource);
-    if (!resource_hash)
+    ResourceDescriptor* rd = FindDescriptorByResource(factory, resource);
+    if (!rd)
     {
         return RESULT_NOT_LOADED;
     }
 
-    ResourceDescriptor* rd = factory->m_Resources->Get(*resource_hash);
-    assert(rd);
-    assert(rd->m_ReferenceCount > 0);
     *type = rd->m_ResourceType;
 
     return RESULT_OK;
@@ -1275,7 +1469,7 @@ Result GetExtensionFromType(HFactory factory, HResourceType type, const char** e
 
 Result GetDescriptorByHash(HFactory factory, dmhash_t path_hash, HResourceDescriptor* descriptor)
 {
-    ResourceDescriptor* tmp_descriptor = factory->m_Resources->Get(path_hash);
+    ResourceDescriptor* tmp_descriptor = FindDescriptor(factory, path_hash);
     if (tmp_descriptor)
     {
         *descriptor = tmp_descriptor;
@@ -1295,7 +1489,7 @@ Result GetDescriptor(HFactory factory, const char* name, HResourceDescriptor* de
 
 Result GetDescriptorWithExt(HFactory factory, uint64_t hashed_name, const uint64_t* exts, uint32_t ext_count, HResourceDescriptor* descriptor)
 {
-    ResourceDescriptor* tmp_descriptor = factory->m_Resources->Get(hashed_name);
+    ResourceDescriptor* tmp_descriptor = FindDescriptor(factory, hashed_name);
     if (!tmp_descriptor) {
         return RESULT_NOT_LOADED;
     }
@@ -1320,27 +1514,23 @@ Result GetDescriptorWithExt(HFactory factory, uint64_t hashed_name, const uint64
 
 void IncRef(HFactory factory, HResourceDescriptor rd)
 {
-    (void)factory;
     assert(rd);
+    ResourceShard* shard = GetShard(factory, rd->m_NameHash);
+    DM_SPINLOCK_SCOPED_LOCK(shard->m_Lock);
     assert(rd->m_ReferenceCount > 0);
     ++rd->m_ReferenceCount;
 }
 
 void IncRef(HFactory factory, void* resource)
 {
-    uint64_t* resource_hash = factory->m_ResourceToHash->Get((uintptr_t) resource);
-    assert(resource_hash);
-
-    ResourceDescriptor* rd = factory->m_Resources->Get(*resource_hash);
+    ResourceDescriptor* rd = FindDescriptorByResource(factory, resource);
+    assert(rd);
     IncRef(factory, rd);
 }
 
 uint16_t GetVersion(HFactory factory, void* resource)
 {
-    uint64_t* resource_hash = factory->m_ResourceToHash->Get((uintptr_t) resource);
-    assert(resource_hash);
-
-    ResourceDescriptor* rd = factory->m_Resources->Get(*resource_hash);
+    ResourceDescriptor* rd = FindDescriptorByResource(factory, resource);
     assert(rd);
     return rd->m_Version;
 }
@@ -1348,38 +1538,41 @@ uint16_t GetVersion(HFactory factory, void* resource)
 // For unit testing
 uint32_t GetRefCount(HFactory factory, void* resource)
 {
-    uint64_t* resource_hash = factory->m_ResourceToHash->Get((uintptr_t) resource);
-    if(!resource_hash)
+    ResourceDescriptor* rd = FindDescriptorByResource(factory, resource);
+    if(!rd)
         return 0;
-    ResourceDescriptor* rd = factory->m_Resources->Get(*resource_hash);
-    assert(rd);
     return rd->m_ReferenceCount;
 }
 
 uint32_t GetRefCount(HFactory factory, dmhash_t identifier)
 {
-    ResourceDescriptor* rd = factory->m_Resources->Get(identifier);
+    ResourceDescriptor* rd = FindDescriptor(factory, identifier);
     if(!rd)
         return 0;
     return rd->m_ReferenceCount;
 }
 
-void Release(HFactory factory, void* resource)
+// Destroys the resource if it's still unreferenced. The reference count has to be checked again,
+// since other threads may have revived (and released) the resource before we got the load mutex.
+//
+// The destroy function is called without m_LoadMutex held, as destroy functions release the resources
+// they reference and may wait on other threads. Lock order: m_LoadMutex, then the shard spinlocks.
+// Nothing may wait for m_LoadMutex while holding a shard spinlock.
+static void DestroyIfUnreferenced(HFactory factory, uint64_t canonical_path_hash)
 {
-    DM_PROFILE(__FUNCTION__);
+    ResourceDescriptor* rd;
+    {
+        dmMutex::ScopedLock lk(factory->m_LoadMutex);
 
-    uint64_t* resource_hash = factory->m_ResourceToHash->Get((uintptr_t) resource);
-    assert(resource_hash);
+        rd = FindDescriptor(factory, canonical_path_hash);
+        if (!rd || !UnlinkDescriptorPath(factory, rd))
+            return;
+    }
 
-    ResourceDescriptor* rd = factory->m_Resources->Get(*resource_hash);
-    assert(rd);
-    assert(rd->m_ReferenceCount > 0);
-    rd->m_ReferenceCount--;
+    // The descriptor can't be found by path anymore, so nothing else can revive or destroy it
+    ResourceType* resource_type = (ResourceType*) rd->m_ResourceType;
 
-    if (rd->m_ReferenceCount == 0)
     {
-        ResourceType* resource_type = (ResourceType*) rd->m_ResourceType;
-
         DM_PROFILE_DYN(resource_type->m_Extension, 0);
 
         ResourceDestroyParams params;
@@ -1388,16 +1581,31 @@ void Release(HFactory factory, void* resource)
         params.m_Context    = resource_type->m_Context;
         params.m_Resource   = rd;
         resource_type->m_DestroyFunction(&params);
+    }
 
-        factory->m_ResourceToHash->Erase((uintptr_t) resource);
-        factory->m_Resources->Erase(*resource_hash);
-        if (factory->m_ResourceHashToFilename)
-        {
-            const char** s = factory->m_ResourceHashToFilename->Get(*resource_hash);
-            factory->m_ResourceHashToFilename->Erase(*resource_hash);
-            assert(s);
-            free((void*) *s);
-        }
+    dmMutex::ScopedLock lk(factory->m_LoadMutex);
+    RemoveDescriptor(factory, rd);
+}
+
+void Release(HFactory factory, void* resource)
+{
+    DM_PROFILE(__FUNCTION__);
+
+    ResourceDescriptor* rd = FindDescriptorByResource(factory, resource);
+    assert(rd);
+
+    uint64_t canonical_path_hash = rd->m_NameHash;
+    bool unreferenced;
+    {
+        ResourceShard* shard = GetShard(factory, canonical_path_hash);
+        DM_SPINLOCK_SCOPED_LOCK(shard->m_Lock);
+        assert(rd->m_ReferenceCount > 0);
+        unreferenced = --rd->m_ReferenceCount == 0;
+    }
+
+    if (unreferenced)
+    {
+        DestroyIfUnreferenced(factory, canonical_path_hash);
     }
 }
 
@@ -1440,9 +1648,9 @@ void UnregisterResourceReloadedCallback(HFactory factory, FResourceReloadedCallb
 
 Result GetPath(HFactory factory, const void* resource, uint64_t* hash)
 {
-    uint64_t* resource_hash = factory->m_ResourceToHash->Get((uintptr_t)resource);
-    if( resource_hash ) {
-        *hash = *resource_hash;
+    ResourceDescriptor* rd = FindDescriptorByResource(factory, resource);
+    if( rd ) {
+        *hash = rd->m_NameHash;
         return RESULT_OK;
     }
     *hash = 0;
@@ -1488,7 +1696,7 @@ struct ResourceIteratorCallbackInfo
     bool                m_ShouldContinue;
 };
 
-static void ResourceIteratorCallback(ResourceIteratorCallbackInfo* callback, const dmhash_t* id, ResourceDescriptor* resource)
+static void ResourceIteratorCallback(ResourceIteratorCallbackInfo* callback, ResourceDescriptor* resource)
 {
     IteratorResource info;
     info.m_Id           = resource->m_NameHash;
@@ -1506,7 +1714,14 @@ void IterateResources(HFactory factory, FResourceIterator callback, void* user_c
 {
     DM_MUTEX_SCOPED_LOCK(factory->m_LoadMutex);
     ResourceIteratorCallbackInfo callback_info = {callback, user_ctx, true};
-    factory->m_Resources->Iterate<>(&ResourceIteratorCallback, &callback_info);
+    for (uint32_t i = 0; i < factory->m_MaxResources; ++i)
+    {
+        ResourceDescriptor* rd = &factory->m_Descriptors[i];
+        if (rd->m_Resource)
+        {
+            ResourceIteratorCallback(&callback_info, rd);
+        }
+    }
 }
 
 const char* ResultToString(Result r)
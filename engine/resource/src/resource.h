@@ -350,6 +350,7 @@ namespace dmResource
     struct SGetDependenciesResult
     {
         dmhash_t m_UrlHash;
+        const char* m_Url;          // May be 0 if the manifest has no entry for the url
         uint8_t* m_HashDigest;
         uint32_t m_HashDigestLength;
         bool     m_Missing;
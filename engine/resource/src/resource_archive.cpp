@@ -22,6 +22,7 @@
 #include "resource_private.h"
 #include "resource_util.h"
 #include "resource_archive_private.h"
+#include "resource_trace.h"
 #include <dlib/crypt.h>
 #include <dlib/dstrings.h>
 #include <dlib/endian.h>
@@ -602,7 +603,9 @@ namespace dmResourceArchive
         if (compressed)
         {
             int decompressed_size;
+            dmResourceTrace::Write(dmResourceTrace::EVENT_DECOMPRESS_BEGIN, 0, source_data_size);
             dmLZ4::Result r = dmLZ4::DecompressBuffer(source_data, source_data_size, buffer, size, &decompressed_size);
+            dmResourceTrace::Write(dmResourceTrace::EVENT_DECOMPRESS_END, 0, size);
             if (dmLZ4::RESULT_OK != r)
             {
                 delete[] temp_data;
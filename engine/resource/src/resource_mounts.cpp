@@ -423,6 +423,26 @@ dmResource::Result GetResourceSize(HContext ctx, dmhash_t path_hash, const char*
     return dmResource::RESULT_RESOURCE_NOT_FOUND;
 }
 
+dmResource::Result GetResourceDataOffset(HContext ctx, dmhash_t path_hash, const char* path, uint32_t* offset)
+{
+    DM_MUTEX_SCOPED_LOCK(ctx->m_Mutex);
+
+    // The first mount that has the file is the one it is read from
+    uint32_t size = ctx->m_Mounts.Size();
+    for (uint32_t i = 0; i < size; ++i)
+    {
+        ArchiveMount& mount = ctx->m_Mounts[i];
+        uint32_t file_size;
+        dmResourceProvider::Result result = dmResourceProvider::GetFileSize(mount.m_Archive, path_hash, path, &file_size);
+        if (dmResourceProvider::RESULT_NOT_FOUND == result)
+            continue;
+        if (dmResourceProvider::RESULT_OK == result)
+            result = dmResourceProvider::GetFileOffset(mount.m_Archive, path_hash, path, offset);
+        return ProviderResultToResult(result);
+    }
+    return dmResource::RESULT_RESOURCE_NOT_FOUND;
+}
+
 dmResource::Result ResourceExists(HContext ctx, dmhash_t path_hash)
 {
     uint32_t resource_size;
@@ -633,6 +653,7 @@ static dmResource::Result GetDependenciesInternal(DependencyIterContext* ctx, co
                 continue;
             }
 
+            result.m_Url               = entry->m_Url;
             result.m_HashDigest        = entry->m_Hash.m_Data.m_Data;
             result.m_HashDigestLength  = hash_len;
 
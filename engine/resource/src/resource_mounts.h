@@ -49,6 +49,8 @@ namespace dmResourceMounts
 
     dmResource::Result ResourceExists(HContext ctx, dmhash_t path_hash);
     dmResource::Result GetResourceSize(HContext ctx, dmhash_t path_hash, const char* path, uint32_t* resource_size);
+    // Gets the offset of the resource data in the archive it is read from. Fails if that mount isn't an archive
+    dmResource::Result GetResourceDataOffset(HContext ctx, dmhash_t path_hash, const char* path, uint32_t* offset);
     dmResource::Result ReadResource(HContext ctx, dmhash_t path_hash, const char* path, uint8_t* buffer, uint32_t buffer_size);
     dmResource::Result ReadResource(HContext ctx, dmhash_t path_hash, const char* path, dmArray<char>* buffer);
 
@@ -80,6 +82,7 @@ namespace dmResourceMounts
     struct SGetDependenciesResult
     {
         dmhash_t m_UrlHash;
+        const char* m_Url;
         uint8_t* m_HashDigest;
         uint32_t m_HashDigestLength;
         bool     m_Missing;
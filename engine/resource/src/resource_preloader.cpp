@@ -13,6 +13,7 @@
 // specific language governing permissions and limitations under the License.
 
 #include <stdio.h>
+#include <stdlib.h>
 #include <assert.h>
 #include <string.h>
 #include <time.h>
@@ -29,6 +30,8 @@
 #include "block_allocator.h"
 #include "resource.h"
 #include "resource_private.h"
+#include "resource_mounts.h"
+#include "resource_trace.h"
 #include "resource_util.h"
 #include "async/load_queue.h"
 
@@ -110,6 +113,7 @@ struct ResourcePostCreateParamsInternal
 {
     ResourcePostCreateParams m_Params;
     ResourceDescriptor m_ResourceDesc;
+    const char* m_CanonicalPath; // Internalized, for the load trace
     bool m_Destroy;
 };
 
@@ -181,6 +185,7 @@ struct ResourcePreloader
     // post create state
     bool m_LoadQueueFull;
     bool m_CreateComplete;
+    bool m_Complete; // The final result has been returned by UpdatePreloader
     uint32_t m_PostCreateCallbackIndex;
     dmArray<ResourcePostCreateParamsInternal> m_PostCreateCallbacks;
 
@@ -445,6 +450,87 @@ namespace dmResource
         assert(req->m_PendingChildCount == 0);
     }
 
+    struct PrefetchEntry
+    {
+        char*    m_Path;
+        uint32_t m_Offset;
+    };
+
+    struct PrefetchContext
+    {
+        HFactory                   m_Factory;
+        dmResourceMounts::HContext m_Mounts;
+        dmArray<PrefetchEntry>     m_Entries;
+    };
+
+    static void PrefetchDependencyCallback(void* _ctx, const SGetDependenciesResult* result)
+    {
+        PrefetchContext* ctx = (PrefetchContext*)_ctx;
+
+        // Already loaded resources are never loaded by the preloader
+        if (result->m_Url == 0x0 || FindByHash(ctx->m_Factory, result->m_UrlHash))
+        {
+            return;
+        }
+
+        char canonical_path[RESOURCE_PATH_MAX];
+        dmResource::GetCanonicalPath(result->m_Url, canonical_path);
+
+        PrefetchEntry entry;
+        entry.m_Path = strdup(canonical_path);
+        // Resources that aren't read from an archive have no offset, and are read last
+        if (dmResource::RESULT_OK != dmResourceMounts::GetResourceDataOffset(ctx->m_Mounts, result->m_UrlHash, entry.m_Path, &entry.m_Offset))
+        {
+            entry.m_Offset = 0xFFFFFFFF;
+        }
+
+        if (ctx->m_Entries.Full())
+        {
+            ctx->m_Entries.OffsetCapacity(256);
+        }
+        ctx->m_Entries.Push(entry);
+    }
+
+    static int CompareDataOffset(const void* _a, const void* _b)
+    {
+        const PrefetchEntry* a = (const PrefetchEntry*)_a;
+        const PrefetchEntry* b = (const PrefetchEntry*)_b;
+        if (a->m_Offset != b->m_Offset)
+        {
+            return a->m_Offset < b->m_Offset ? -1 : 1;
+        }
+        return strcmp(a->m_Path, b->m_Path);
+    }
+
+    // The children of a resource are only known once the resource has been loaded and its preload function
+    // has run, which serializes the reads over the depth of the tree. If the manifest lists the dependencies of
+    // the root (it does for the collections of excluded collection proxies), they are all read ahead of time
+    // instead. They are still added to the tree by the PreloadHint calls, which then pick up the read data.
+    static void PrefetchDependencies(HPreloader preloader, dmhash_t canonical_path_hash)
+    {
+        DM_PROFILE(__FUNCTION__);
+
+        PrefetchContext ctx;
+        ctx.m_Factory = preloader->m_Factory;
+        ctx.m_Mounts  = dmResource::GetMountsContext(preloader->m_Factory);
+
+        SGetDependenciesParams params;
+        params.m_UrlHash             = canonical_path_hash;
+        params.m_OnlyMissing         = false;
+        params.m_Recursive           = true;
+        params.m_IncludeRequestedUrl = false;
+        GetDependencies(preloader->m_Factory, &params, PrefetchDependencyCallback, &ctx);
+
+        // Read in the order the data is stored in the archive, so that the reads are sequential
+        qsort(ctx.m_Entries.Begin(), ctx.m_Entries.Size(), sizeof(PrefetchEntry), CompareDataOffset);
+
+        for (uint32_t i = 0; i < ctx.m_Entries.Size(); ++i)
+        {
+            dmLoadQueue::Prefetch(preloader->m_LoadQueue, ctx.m_Entries[i].m_Path);
+            free(ctx.m_Entries[i].m_Path);
+        }
+    }
+
     HPreloader NewPreloader(HFactory factory, const dmArray<const char*>& names)
     {
         ResourcePreloader* preloader = new ResourcePreloader();
@@ -477,13 +563,17 @@ namespace dmResource
         preloader->m_PostCreateCallbacks.SetCapacity(MAX_PRELOADER_REQUESTS / 8);
         preloader->m_LoadQueueFull           = false;
         preloader->m_CreateComplete          = false;
+        preloader->m_Complete                = false;
         preloader->m_PostCreateCallbackIndex = 0;
 
         preloader->m_BlockAllocator = dmBlockAllocator::CreateContext();
 
+        dmResourceTrace::Write(dmResourceTrace::EVENT_GROUP_BEGIN, root->m_PathDescriptor.m_InternalizedCanonicalPath, 0);
+
         if (root->m_LoadResult == RESULT_OK)
         {
             root->m_LoadResult = RESULT_PENDING;
+            PrefetchDependencies(preloader, root->m_PathDescriptor.m_CanonicalPathHash);
         }
 
         // Add remaining items as children of root (first item).
@@ -544,7 +634,9 @@ namespace dmResource
             tmp_resource.m_ResourceSizeOnDisc = req->m_BufferSize;
             params.m_Buffer                   = req->m_Buffer;
             params.m_BufferSize               = req->m_BufferSize;
+            dmResourceTrace::Write(dmResourceTrace::EVENT_CREATE_BEGIN, req->m_PathDescriptor.m_InternalizedCanonicalPath, params.m_BufferSize);
             req->m_LoadResult                 = (Result)resource_type->m_CreateFunction(&params);
+            dmResourceTrace::Write(dmResourceTrace::EVENT_CREATE_END, req->m_PathDescriptor.m_InternalizedCanonicalPath, params.m_BufferSize);
 
             dmBlockAllocator::Free(preloader->m_BlockAllocator, req->m_Buffer, req->m_BufferSize);
 
@@ -555,7 +647,9 @@ namespace dmResource
             tmp_resource.m_ResourceSizeOnDisc = buffer_size;
             params.m_Buffer                   = buffer;
             params.m_BufferSize               = buffer_size;
+            dmResourceTrace::Write(dmResourceTrace::EVENT_CREATE_BEGIN, req->m_PathDescriptor.m_InternalizedCanonicalPath, buffer_size);
             req->m_LoadResult                 = (Result)resource_type->m_CreateFunction(&params);
+            dmResourceTrace::Write(dmResourceTrace::EVENT_CREATE_END, req->m_PathDescriptor.m_InternalizedCanonicalPath, buffer_size);
         }
 
         if (req->m_LoadResult == RESULT_OK)
@@ -569,6 +663,7 @@ namespace dmResource
                 preloader->m_PostCreateCallbacks.SetSize(preloader->m_PostCreateCallbacks.Size() + 1);
                 ResourcePostCreateParamsInternal& ip = preloader->m_PostCreateCallbacks.Back();
                 ip.m_Destroy                         = false;
+                ip.m_CanonicalPath                   = req->m_PathDescriptor.m_InternalizedCanonicalPath;
                 ip.m_Params.m_Factory                = preloader->m_Factory;
                 ip.m_Params.m_Type                   = resource_type;
                 ip.m_Params.m_Context                = resource_type->m_Context;
@@ -599,12 +694,14 @@ namespace dmResource
         // Only two options from now on is to either destroy the resource or have it inserted
         bool destroy = false;
 
+        // Held so that no other thread inserts the same resource between the lookup and the insertion
+        DM_MUTEX_SCOPED_LOCK(GetLoadMutex(preloader->m_Factory));
+
         // If someone else has loaded the resource already, use that one and mark our loaded resource for destruction
-        ResourceDescriptor* rd = FindByHash(preloader->m_Factory, req->m_PathDescriptor.m_CanonicalPathHash);
+        ResourceDescriptor* rd = AcquireByHash(preloader->m_Factory, req->m_PathDescriptor.m_CanonicalPathHash);
         if (rd)
         {
             // Use already loaded resource
-            rd->m_ReferenceCount++;
             req->m_Resource = rd->m_Resource;
             destroy         = true;
         }
@@ -833,10 +930,9 @@ namespace dmResource
         }
 
         // It might have been loaded by unhinted resource Gets or loaded by a different preloader, just grab & bump refcount
-        ResourceDescriptor* rd = FindByHash(preloader->m_Factory, req->m_PathDescriptor.m_CanonicalPathHash);
+        ResourceDescriptor* rd = AcquireByHash(preloader->m_Factory, req->m_PathDescriptor.m_CanonicalPathHash);
         if (rd)
         {
-            rd->m_ReferenceCount++;
             req->m_Resource   = rd->m_Resource;
             req->m_LoadResult = RESULT_OK;
             RemoveChildren(preloader, req);
@@ -886,7 +982,9 @@ namespace dmResource
         ResourcePostCreateParams& params     = ip.m_Params;
         params.m_Resource                    = &ip.m_ResourceDesc;
         ResourceType* resource_type          = params.m_Resource->m_ResourceType;
+        dmResourceTrace::Write(dmResourceTrace::EVENT_POST_CREATE_BEGIN, ip.m_CanonicalPath, 0);
         Result ret                           = (Result)resource_type->m_PostCreateFunction(&params);
+        dmResourceTrace::Write(dmResourceTrace::EVENT_POST_CREATE_END, ip.m_CanonicalPath, 0);
 
         if (ret == RESULT_PENDING)
         {
@@ -968,6 +1066,10 @@ namespace dmResource
                     // call the post-create function (if given) and then post-create
                     // of all created items
                     preloader->m_CreateComplete = true;
+
+                    // Nothing more will be loaded, so any prefetched data is either from a failed
+                    // load or for a resource that was never hinted
+                    dmLoadQueue::CancelPrefetch(preloader->m_LoadQueue);
                     if (root_result == RESULT_OK && complete_callback)
                     {
                         if (!complete_callback(complete_callback_params))
@@ -983,6 +1085,11 @@ namespace dmResource
                 if (post_create_result != RESULT_PENDING)
                 {
                     // All done!
+                    if (!preloader->m_Complete)
+                    {
+                        preloader->m_Complete = true;
+                        dmResourceTrace::Write(dmResourceTrace::EVENT_GROUP_END, preloader->m_Request[0].m_PathDescriptor.m_InternalizedCanonicalPath, 0);
+                    }
                     return root_result;
                 }
             }
@@ -1030,6 +1137,8 @@ namespace dmResource
         // This is not a super-important use-case, the only way to trigger this is to start a load and
         // then do unload before it completes or if you destroy the collection while loading.
         // The normal operation is to issue a load and progress once complete.
+        // Stop reading ahead first, the remaining requests are only loaded to be able to release them.
+        dmLoadQueue::CancelPrefetch(preloader->m_LoadQueue);
         while (UpdatePreloader(preloader, 0, 0, 1000000) == RESULT_PENDING)
         {
             dmLogWarning("Waiting for preloader to complete.");
@@ -98,7 +98,10 @@ namespace dmResource
     // load with default internal buffer and its management, returns buffer ptr in 'buffer'
     Result LoadResource(HFactory factory, const char* path, const char* original_name, void** buffer, uint32_t* resource_size);
 
+    // Takes the load mutex. The resource must not already be loaded
     Result InsertResource(HFactory factory, const char* path, uint64_t canonical_path_hash, HResourceDescriptor descriptor);
+    // Adds a reference to an already loaded resource. Returns 0 if it isn't loaded
+    HResourceDescriptor AcquireByHash(HFactory factory, uint64_t canonical_path_hash);
     uint32_t GetCanonicalPathFromBase(const char* base_dir, const char* relative_dir, char* buf);
 
     HResourceType FindResourceType(HFactory factory, const char* extension);
@@ -0,0 +1,128 @@
+// Copyright 2020-2024 The Defold Foundation
+// Copyright 2014-2020 King
+// Copyright 2009-2014 Ragnar Svensson, Christian Murray
+// Licensed under the Defold License version 1.0 (the "License"); you may not use
+// this file except in compliance with the License.
+//
+// You may obtain a copy of the License, together with FAQs at
+// https://www.defold.com/license
+//
+// Unless required by applicable law or agreed to in writing, software distributed
+// under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+// CONDITIONS OF ANY KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations under the License.
+
+#include "resource_trace.h"
+
+#include <stdio.h>
+#include <dlib/atomic.h>
+#include <dlib/log.h>
+#include <dlib/mutex.h>
+#include <dlib/thread.h>
+#include <dlib/time.h>
+
+namespace dmResourceTrace
+{
+    static const char* EVENT_NAMES[] =
+    {
+        "group_begin",
+        "group_end",
+        "queued",
+        "read_begin",
+        "read_end",
+        "decompress_begin",
+        "decompress_end",
+        "preload_begin",
+        "preload_end",
+        "create_begin",
+        "create_end",
+        "post_create_begin",
+        "post_create_end",
+    };
+
+    struct Trace
+    {
+        dmMutex::HMutex  m_Mutex;
+        FILE*            m_File;
+        uint64_t         m_StartTime;
+        // Threads are written as small numbers, in the order they first wrote an event
+        dmThread::TlsKey m_ThreadIndexKey;
+        uint32_t         m_ThreadCount;
+    };
+
+    static Trace          g_Trace = {0};
+    static int32_atomic_t g_Enabled = 0;
+
+    // Assumes the mutex is held
+    static uint32_t GetThreadIndex()
+    {
+        // Stored as index + 1, so that 0 means that the thread has no index yet
+        uintptr_t index = (uintptr_t)dmThread::GetTlsValue(g_Trace.m_ThreadIndexKey);
+        if (index == 0)
+        {
+            index = ++g_Trace.m_ThreadCount;
+            dmThread::SetTlsValue(g_Trace.m_ThreadIndexKey, (void*)index);
+        }
+        return (uint32_t)index - 1;
+    }
+
+    bool Open(const char* path)
+    {
+        Close();
+
+        FILE* file = fopen(path, "wb");
+        if (!file)
+        {
+            dmLogError("Failed to open resource load trace '%s'", path);
+            return false;
+        }
+
+        if (!g_Trace.m_Mutex)
+        {
+            g_Trace.m_Mutex = dmMutex::New();
+            g_Trace.m_ThreadIndexKey = dmThread::AllocTls();
+        }
+
+        DM_MUTEX_SCOPED_LOCK(g_Trace.m_Mutex);
+        g_Trace.m_File        = file;
+        g_Trace.m_StartTime   = dmTime::GetTime();
+        fprintf(file, "# time_us\tthread\tevent\tbytes\tpath\n");
+        dmAtomicStore32(&g_Enabled, 1);
+        dmLogInfo("Writing resource load trace to '%s'", path);
+        return true;
+    }
+
+    void Close()
+    {
+        if (!g_Trace.m_Mutex)
+            return;
+
+        DM_MUTEX_SCOPED_LOCK(g_Trace.m_Mutex);
+        dmAtomicStore32(&g_Enabled, 0);
+        if (g_Trace.m_File)
+        {
+            fclose(g_Trace.m_File);
+            g_Trace.m_File = 0;
+        }
+    }
+
+    bool IsEnabled()
+    {
+        return dmAtomicGet32(&g_Enabled) != 0;
+    }
+
+    void Write(Event event, const char* path, uint32_t bytes)
+    {
+        if (!IsEnabled())
+            return;
+
+        uint64_t time = dmTime::GetTime();
+
+        DM_MUTEX_SCOPED_LOCK(g_Trace.m_Mutex);
+        if (!g_Trace.m_File)
+            return;
+
+        fprintf(g_Trace.m_File, "%llu\t%u\t%s\t%u\t%s\n", (unsigned long long)(time - g_Trace.m_StartTime), GetThreadIndex(),
+                EVENT_NAMES[event], bytes, path ? path : "-");
+    }
+}
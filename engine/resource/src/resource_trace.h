@@ -0,0 +1,77 @@
+// Copyright 2020-2024 The Defold Foundation
+// Copyright 2014-2020 King
+// Copyright 2009-2014 Ragnar Svensson, Christian Murray
+// Licensed under the Defold License version 1.0 (the "License"); you may not use
+// this file except in compliance with the License.
+//
+// You may obtain a copy of the License, together with FAQs at
+// https://www.defold.com/license
+//
+// Unless required by applicable law or agreed to in writing, software distributed
+// under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+// CONDITIONS OF ANY KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations under the License.
+
+#ifndef DM_RESOURCE_TRACE_H
+#define DM_RESOURCE_TRACE_H
+
+#include <stdint.h>
+
+/*
+ * Resource load trace
+ *
+ * Records when each step of loading a resource starts and ends, the number of bytes
+ * involved and the thread it ran on. The trace is written as text, one event per line:
+ *
+ *     <time us> <thread> <event> <bytes> <path>
+ *
+ * The fields are separated by tabs. The path is "-" for events that aren't tied to a resource
+ * path, e.g. decompression, which is attributed to the read that surrounds it on the same thread.
+ * Use resource_trace.py to summarize a trace.
+ */
+namespace dmResourceTrace
+{
+    enum Event
+    {
+        EVENT_GROUP_BEGIN,          // A group of loads, e.g. a collection proxy load. The path is the name of the group
+        EVENT_GROUP_END,
+        EVENT_QUEUED,               // The resource was added to the load queue
+        EVENT_READ_BEGIN,
+        EVENT_READ_END,
+        EVENT_DECOMPRESS_BEGIN,
+        EVENT_DECOMPRESS_END,
+        EVENT_PRELOAD_BEGIN,
+        EVENT_PRELOAD_END,
+        EVENT_CREATE_BEGIN,
+        EVENT_CREATE_END,
+        EVENT_POST_CREATE_BEGIN,
+        EVENT_POST_CREATE_END,
+    };
+
+    /*#
+     * Starts writing a trace to a file. Replaces any trace that is already open
+     * @param path [type: const char*] Path of the trace file
+     * @return result [type: bool] true if the file could be opened
+     */
+    bool Open(const char* path);
+
+    /*#
+     * Flushes and closes the trace, if one is open
+     */
+    void Close();
+
+    /*#
+     * @return enabled [type: bool] true if a trace is open
+     */
+    bool IsEnabled();
+
+    /*#
+     * Writes an event to the trace, if one is open. Thread safe.
+     * @param event [type: Event] The event
+     * @param path [type: const char*] The resource path, or the group name. May be 0
+     * @param bytes [type: uint32_t] The number of bytes involved, or 0
+     */
+    void Write(Event event, const char* path, uint32_t bytes);
+}
+
+#endif // DM_RESOURCE_TRACE_H
@@ -0,0 +1,218 @@
+#! /usr/bin/env python
+# Copyright 2020-2024 The Defold Foundation
+# Copyright 2014-2020 King
+# Copyright 2009-2014 Ragnar Svensson, Christian Murray
+# Licensed under the Defold License version 1.0 (the "License"); you may not use
+# this file except in compliance with the License.
+# 
+# You may obtain a copy of the License, together with FAQs at
+# https://www.defold.com/license
+# 
+# Unless required by applicable law or agreed to in writing, software distributed
+# under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+# CONDITIONS OF ANY KIND, either express or implied. See the License for the
+# specific language governing permissions and limitations under the License.
+
+# Summarizes a resource load trace, written by the engine when "resource.load_trace" is set.
+#
+# For each group (LoadBootstrapContent, the main collection and each collection proxy load) the time
+# is attributed to the resources that were on the critical path:
+#  * While the thread that started the group is busy with a resource (e.g. creating it), the time is
+#    attributed to that resource, as nothing else can make the group finish sooner
+#  * Otherwise, the time is split between the resources other threads are busy with (e.g. the load
+#    thread reading or preloading), as the group is waiting for them
+#  * Time when no thread is busy with a resource is reported as idle (e.g. waiting for the next frame)
+#
+# Usage: resource_trace.py trace.txt [--top N] [--load-order load_order.txt]
+#
+# The --load-order file lists the resources in the order they were first read, and can be
+# passed to bob with --archive-load-order to store the archive data in that order.
+
+import os, sys, bisect
+from argparse import ArgumentParser
+
+STEPS = ["read", "decompress", "preload", "create", "post_create"]
+IDLE = "(idle)"
+
+class Segment(object):
+    def __init__(self, start, end, path, step, size):
+        self.start = start
+        self.end = end
+        self.path = path
+        self.step = step
+        self.size = size
+
+class Group(object):
+    def __init__(self, name, thread, start):
+        self.name = name
+        self.thread = thread
+        self.start = start
+        self.end = None
+
+class Trace(object):
+    def __init__(self):
+        self.segments = {}      # thread -> list of exclusive segments, sorted on time
+        self.groups = []
+        self.bytes = {}         # (path, step) -> bytes
+        self.load_order = []
+
+def parse(lines):
+    trace = Trace()
+    stacks = {}         # thread -> [[path, step, start, size]], the innermost step last
+    open_groups = {}    # name -> [Group]
+    read = set()
+    end_time = 0
+
+    def add_segment(thread, start, end, path, step, size):
+        if end > start:
+            trace.segments.setdefault(thread, []).append(Segment(start, end, path, step, size))
+
+    for line in lines:
+        line = line.rstrip('\n')
+        if not line or line.startswith('#'):
+            continue
+        fields = line.split('\t', 4)
+        if len(fields) != 5:
+            continue
+        time, thread, event, size, path = int(fields[0]), int(fields[1]), fields[2], int(fields[3]), fields[4]
+        end_time = max(end_time, time)
+        stack = stacks.setdefault(thread, [])
+
+        if event == "group_begin":
+            group = Group(path, thread, time)
+            trace.groups.append(group)
+            open_groups.setdefault(path, []).append(group)
+            continue
+        if event == "group_end":
+            if open_groups.get(path):
+                open_groups[path].pop().end = time
+            continue
+        if event == "queued":
+            continue
+
+        step, kind = event.rsplit('_', 1)
+        if step not in STEPS:
+            continue
+
+        if kind == "begin":
+            if path == '-':
+                # Attributed to the step it runs within, e.g. decompression within a read
+                path = stack[-1][0] if stack else '-'
+            if step == "read" and path not in read:
+                read.add(path)
+                trace.load_order.append(path)
+            if stack:
+                # The enclosing step is paused while this one runs
+                parent = stack[-1]
+                add_segment(thread, parent[2], time, parent[0], parent[1], 0)
+            stack.append([path, step, time, size])
+        elif kind == "end":
+            if not stack or stack[-1][1] != step:
+                continue # Mismatched event, e.g. the trace was opened while a step was running
+            path, step, start, _ = stack.pop()
+            add_segment(thread, start, time, path, step, size)
+            key = (path, step)
+            trace.bytes[key] = trace.bytes.get(key, 0) + size
+            if stack:
+                stack[-1][2] = time # The enclosing step resumes
+
+    for groups in open_groups.values():
+        for group in groups:
+            group.end = end_time # The trace ended during the load
+
+    for segments in trace.segments.values():
+        segments.sort(key=lambda s: s.start)
+    return trace
+
+def find_segment(segments, starts, time):
+    i = bisect.bisect_right(starts, time) - 1
+    if i >= 0 and segments[i].start <= time < segments[i].end:
+        return segments[i]
+    return None
+
+# Returns a dictionary (path, step) -> microseconds on the critical path of the group
+def critical_path(trace, group):
+    times = set([group.start, group.end])
+    starts = {}
+    for thread, segments in trace.segments.items():
+        starts[thread] = [s.start for s in segments]
+        for s in segments:
+            if s.end > group.start and s.start < group.end:
+                times.add(max(s.start, group.start))
+                times.add(min(s.end, group.end))
+    times = sorted(times)
+
+    main_segments = trace.segments.get(group.thread, [])
+    main_starts = starts.get(group.thread, [])
+    result = {}
+    for a, b in zip(times, times[1:]):
+        s = find_segment(main_segments, main_starts, a)
+        if s:
+            busy = [s]
+        else:
+            busy = []
+            for thread, segments in trace.segments.items():
+                if thread != group.thread:
+                    s = find_segment(segments, starts[thread], a)
+                    if s:
+                        busy.append(s)
+        if not busy:
+            result[(IDLE, IDLE)] = result.get((IDLE, IDLE), 0) + (b - a)
+            continue
+        for s in busy:
+            key = (s.path, s.step)
+            result[key] = result.get(key, 0) + float(b - a) / len(busy)
+    return result
+
+def get_type(path):
+    ext = os.path.splitext(path)[1]
+    return ext if ext else path
+
+def ms(us):
+    return "%9.2f" % (us / 1000.0)
+
+def print_group(trace, group, top):
+    duration = group.end - group.start
+    contribution = critical_path(trace, group)
+
+    resources = {}
+    types = {}
+    for (path, step), t in contribution.items():
+        r = resources.setdefault(path, {})
+        r[step] = r.get(step, 0) + t
+        types[get_type(path)] = types.get(get_type(path), 0) + t
+
+    print("%s: %s ms" % (group.name, ms(duration).strip()))
+    print("")
+    print("  %-60s %9s %9s  %s" % ("Resource", "ms", "KB read", "  ".join(["%9s" % s for s in STEPS])))
+    ranked = sorted(resources.items(), key=lambda kv: -sum(kv[1].values()))
+    for path, steps in ranked[:top]:
+        kb = trace.bytes.get((path, "read"), 0) / 1024.0
+        print("  %-60s %s %9.1f  %s" % (path[-60:], ms(sum(steps.values())), kb, "  ".join([ms(steps.get(s, 0)) for s in STEPS])))
+    print("")
+    print("  %-60s %9s %6s" % ("Type", "ms", "%"))
+    for t, us in sorted(types.items(), key=lambda kv: -kv[1])[:top]:
+        print("  %-60s %s %5.1f%%" % (t, ms(us), 100.0 * us / duration if duration else 0.0))
+    print("")
+
+def main():
+    parser = ArgumentParser(description="Summarizes a resource load trace")
+    parser.add_argument("trace", help="the trace file, written by the engine when resource.load_trace is set")
+    parser.add_argument("--top", type=int, default=20, help="the number of resources and types to list per group")
+    parser.add_argument("--load-order", help="write the resources in the order they were first read to this file, for bob --archive-load-order")
+    args = parser.parse_args()
+
+    with open(args.trace) as f:
+        trace = parse(f)
+
+    for group in trace.groups:
+        print_group(trace, group, args.top)
+
+    if args.load_order:
+        with open(args.load_order, "w") as f:
+            f.write("# Resources in the order they were first read, from %s\n" % os.path.basename(args.trace))
+            for path in trace.load_order:
+                f.write(path + "\n")
+
+if __name__ == "__main__":
+    main()
@@ -158,6 +158,30 @@ TEST_F(ArchiveProviderArchive, GetSize)
     ASSERT_EQ(dmResourceProvider::RESULT_NOT_FOUND, result);
 }
 
+TEST_F(ArchiveProviderArchive, GetOffset)
+{
+    dmResourceProvider::Result result;
+    uint32_t offsets[DM_ARRAY_SIZE(FILE_PATHS)];
+
+    for (uint32_t i = 0; i < DM_ARRAY_SIZE(FILE_PATHS); ++i)
+    {
+        const char* path = FILE_PATHS[i];
+        result = dmResourceProvider::GetFileOffset(m_Archive, dmHashString64(path), path, &offsets[i]);
+        ASSERT_EQ(dmResourceProvider::RESULT_OK, result);
+
+        // The files are stored separately in the data file
+        for (uint32_t j = 0; j < i; ++j)
+        {
+            ASSERT_NE(offsets[j], offsets[i]);
+        }
+    }
+
+    const char* path = "src/test/files/not_exist";
+    uint32_t offset;
+    result = dmResourceProvider::GetFileOffset(m_Archive, dmHashString64(path), path, &offset);
+    ASSERT_EQ(dmResourceProvider::RESULT_NOT_FOUND, result);
+}
+
 // * Test that the files exist
 // * Test that the content is the same as on disc
 TEST_F(ArchiveProviderArchive, ReadFile)
@@ -41,8 +41,10 @@
 #include "../resource_manifest.h"
 #include "../resource_manifest_private.h"
 #include "../resource_private.h"
+#include "../resource_trace.h"
 #include "../resource_util.h"
 #include "../resource_verify.h"
+#include "../async/load_queue.h"
 #include "test/test_resource_ddf.h"
 
 #if defined(DM_TEST_HTTP_SUPPORTED)
@@ -723,6 +725,53 @@ TEST_P(GetResourceTest, PreloadGet)
     dmResource::Release(m_Factory, resource);
 }
 
+TEST_P(GetResourceTest, LoadTrace)
+{
+    char trace_path[512];
+    dmTestUtil::MakeHostPathf(trace_path, sizeof(trace_path), "%s/%s", TMP_DIR, "__loadtrace__.txt");
+    ASSERT_TRUE(dmResourceTrace::Open(trace_path));
+    ASSERT_TRUE(dmResourceTrace::IsEnabled());
+
+    dmResource::HPreloader pr = dmResource::NewPreloader(m_Factory, m_ResourceName);
+    dmResource::Result r;
+    for (uint32_t i=0;i<33;i++)
+    {
+        r = dmResource::UpdatePreloader(pr, 0, 0, 30*1000);
+        if (r == dmResource::RESULT_PENDING)
+            dmTime::Sleep(30000);
+        else
+            break;
+    }
+    ASSERT_EQ(dmResource::RESULT_OK, r);
+    dmResource::DeletePreloader(pr);
+
+    dmResourceTrace::Close();
+    ASSERT_FALSE(dmResourceTrace::IsEnabled());
+
+    // Not written when the trace is closed
+    dmResourceTrace::Write(dmResourceTrace::EVENT_GROUP_BEGIN, "not_written", 0);
+
+    FILE* f = fopen(trace_path, "rb");
+    ASSERT_NE((FILE*) 0, f);
+    char trace[8192];
+    size_t trace_size = fread(trace, 1, sizeof(trace) - 1, f);
+    trace[trace_size] = 0;
+    fclose(f);
+    dmSys::Unlink(trace_path);
+
+    char expected[256];
+    const char* events[] = { "group_begin", "queued", "read_begin", "read_end", "preload_begin", "preload_end", "create_begin", "create_end", "group_end" };
+    for (uint32_t i = 0; i < DM_ARRAY_SIZE(events); ++i)
+    {
+        dmSnPrintf(expected, sizeof(expected), "\t%s\t", events[i]);
+        ASSERT_NE((char*) 0, strstr(trace, expected)) << events[i];
+    }
+    // The children of the container are traced as well
+    ASSERT_NE((char*) 0, strstr(trace, "/test01.foo\n"));
+    ASSERT_NE((char*) 0, strstr(trace, "/test.cont\n"));
+    ASSERT_EQ((char*) 0, strstr(trace, "not_written"));
+}
+
 TEST_P(GetResourceTest, PreloadGetList)
 {
     const char* resource_names_list[] = { m_ResourceName, "/test_ref.cont" };
@@ -883,6 +932,69 @@ TEST_P(GetResourceTest, PreloadGetAbort)
     }
 }
 
+#if !defined(__EMSCRIPTEN__)
+static const char* g_PrefetchPaths[] = { "/test.cont", "/test01.foo", "/test02.foo", "/test_ref.cont", "/many_refs.cont", "/self_referring.cont" };
+
+static void PrefetchAll(dmLoadQueue::HQueue queue)
+{
+    for (uint32_t i = 0; i < DM_ARRAY_SIZE(g_PrefetchPaths); ++i)
+    {
+        dmLoadQueue::Prefetch(queue, g_PrefetchPaths[i]);
+    }
+}
+
+// Cancelled (or deleted) prefetches must release their data, so that a later prefetch isn't blocked by the budget
+TEST(LoadQueue, CancelPrefetch)
+{
+    dmResource::NewFactoryParams params;
+    dmResource::HFactory factory = dmResource::NewFactory(&params, MOUNT_DIR "/build/src/test");
+    ASSERT_NE((void*) 0, factory);
+
+    // Deleted while the files are being read, like a preloader deleted mid-load
+    dmLoadQueue::HQueue queue = dmLoadQueue::CreateQueue(factory);
+    PrefetchAll(queue);
+    dmLoadQueue::DeleteQueue(queue);
+
+    queue = dmLoadQueue::CreateQueue(factory);
+    PrefetchAll(queue);
+    dmLoadQueue::CancelPrefetch(queue);
+    ASSERT_EQ(0u, dmLoadQueue::GetPrefetchedSize(queue));
+    dmTime::Sleep(20000);
+    ASSERT_EQ(0u, dmLoadQueue::GetPrefetchedSize(queue));
+
+    // Prefetch again, and pick up one of the files with a request
+    PrefetchAll(queue);
+    for (uint32_t i = 0; i < 1000 && dmLoadQueue::GetPrefetchedSize(queue) == 0; ++i)
+    {
+        dmTime::Sleep(1000);
+    }
+    uint64_t prefetched_size = dmLoadQueue::GetPrefetchedSize(queue);
+    ASSERT_LT(0u, prefetched_size);
+
+    dmLoadQueue::PreloadInfo info;
+    memset(&info, 0, sizeof(info));
+    dmLoadQueue::HRequest request = dmLoadQueue::BeginLoad(queue, "/test.cont", "/test.cont", &info);
+    ASSERT_NE((dmLoadQueue::HRequest) 0, request);
+
+    void* buffer = 0;
+    uint32_t buffer_size = 0;
+    dmLoadQueue::LoadResult load_result;
+    while (dmLoadQueue::EndLoad(queue, request, &buffer, &buffer_size, &load_result) == dmLoadQueue::RESULT_PENDING)
+    {
+        dmTime::Sleep(1000);
+    }
+    ASSERT_EQ(dmResource::RESULT_OK, load_result.m_LoadResult);
+    ASSERT_LT(0u, buffer_size);
+    dmLoadQueue::FreeLoad(queue, request);
+
+    // Dropping the files that were never requested frees the rest
+    dmLoadQueue::CancelPrefetch(queue);
+    ASSERT_EQ(0u, dmLoadQueue::GetPrefetchedSize(queue));
+
+    dmLoadQueue::DeleteQueue(queue);
+    dmResource::DeleteFactory(factory);
+}
+#endif
 
 dmResource::Result RecreateResourceCreate(const dmResource::ResourceCreateParams* params)
 {
@@ -1435,6 +1547,103 @@ TEST(OverflowTest, OverflowTest)
     dmResource::DeleteFactory(factory);
 }
 
+struct ConcurrentGetContext
+{
+    dmResource::HFactory m_Factory;
+    int32_atomic_t       m_Created;
+    int32_atomic_t       m_Destroyed;
+    int32_atomic_t       m_Errors;
+    int32_atomic_t       m_ThreadCount;
+};
+
+static dmResource::Result ConcurrentResourceCreate(const dmResource::ResourceCreateParams* params)
+{
+    ConcurrentGetContext* ctx = (ConcurrentGetContext*) params->m_Context;
+    dmAtomicIncrement32(&ctx->m_Created);
+    return RecreateResourceCreate(params);
+}
+
+static dmResource::Result ConcurrentResourceDestroy(const dmResource::ResourceDestroyParams* params)
+{
+    ConcurrentGetContext* ctx = (ConcurrentGetContext*) params->m_Context;
+    dmAtomicIncrement32(&ctx->m_Destroyed);
+    return RecreateResourceDestroy(params);
+}
+
+static void ConcurrentGetThread(void* _ctx)
+{
+    ConcurrentGetContext* ctx = (ConcurrentGetContext*) _ctx;
+    uint32_t thread_index = (uint32_t) dmAtomicIncrement32(&ctx->m_ThreadCount);
+    const char* names[] = {"/test01.foo", "/test02.foo"};
+
+    for (uint32_t i = 0; i < 5000; ++i)
+    {
+        const char* name = names[(i + thread_index) & 1];
+        dmhash_t name_hash = dmHashString64(name);
+
+        int* resource;
+        if (dmResource::Get(ctx->m_Factory, name, (void**) &resource) != dmResource::RESULT_OK)
+        {
+            dmAtomicIncrement32(&ctx->m_Errors);
+            continue;
+        }
+
+        dmResource::IncRef(ctx->m_Factory, resource);
+        dmResource::Release(ctx->m_Factory, resource);
+
+        int* resource_by_hash;
+        if (dmResource::Get(ctx->m_Factory, name_hash, (void**) &resource_by_hash) != dmResource::RESULT_OK || resource_by_hash != resource)
+            dmAtomicIncrement32(&ctx->m_Errors);
+        else
+            dmResource::Release(ctx->m_Factory, resource_by_hash);
+
+        dmhash_t path_hash;
+        if (dmResource::GetPath(ctx->m_Factory, resource, &path_hash) != dmResource::RESULT_OK || path_hash != name_hash)
+            dmAtomicIncrement32(&ctx->m_Errors);
+
+        dmResource::Release(ctx->m_Factory, resource);
+    }
+}
+
+// Gets and releases the same resources from several threads, so that they are
+// also destroyed and recreated while other threads are getting them
+TEST(ConcurrentGetTest, GetRelease)
+{
+    const char* test_dir = MOUNT_DIR "/build/src/test";
+
+    dmResource::NewFactoryParams params;
+    params.m_MaxResources = 16;
+    dmResource::HFactory factory = dmResource::NewFactory(&params, test_dir);
+    ASSERT_NE((void*) 0, factory);
+
+    ConcurrentGetContext ctx;
+    memset(&ctx, 0, sizeof(ctx));
+    ctx.m_Factory = factory;
+
+    dmResource::Result e;
+    e = dmResource::RegisterType(factory, "foo", &ctx, 0, &ConcurrentResourceCreate, 0, &ConcurrentResourceDestroy, 0);
+    ASSERT_EQ(dmResource::RESULT_OK, e);
+
+    const uint32_t thread_count = 8;
+    dmThread::Thread threads[thread_count];
+    for (uint32_t i = 0; i < thread_count; ++i)
+    {
+        threads[i] = dmThread::New(&ConcurrentGetThread, 0x8000, &ctx, "get");
+    }
+    for (uint32_t i = 0; i < thread_count; ++i)
+    {
+        dmThread::Join(threads[i]);
+    }
+
+    ASSERT_EQ(0, dmAtomicGet32(&ctx.m_Errors));
+    ASSERT_LT(0, dmAtomicGet32(&ctx.m_Created));
+    ASSERT_EQ(dmAtomicGet32(&ctx.m_Created), dmAtomicGet32(&ctx.m_Destroyed));
+    ASSERT_EQ(0u, dmResource::GetRefCount(factory, dmHashString64("/test01.foo")));
+    ASSERT_EQ(0u, dmResource::GetRefCount(factory, dmHashString64("/test02.foo")));
+
+    dmResource::DeleteFactory(factory);
+}
+
 TEST_P(GetResourceTest, OverflowTestRecursive)
 {
     // Needs to be GetResourceTest or cannot use ResourceContainer resource here which is needed for the test.
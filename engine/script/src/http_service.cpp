@@ -45,6 +45,18 @@ namespace dmHttpService
 
     struct HttpService;
 
+    // A GET-request queued by Dispatch, to be sent pipelined with other requests to the same host
+    struct PendingRequest
+    {
+        dmMessage::URL          m_Requester;
+        uintptr_t               m_UserData2;
+        // Copy of the message data
+        dmHttpDDF::HttpRequest* m_Request;
+        dmURI::Parts            m_URL;
+        // Set when the pipelined response failed, the request is then resent on its own
+        bool                    m_Failed;
+    };
+
     struct Worker
     {
         dmThread::Thread      m_Thread;
@@ -64,6 +76,11 @@ namespace dmHttpService
         volatile bool         m_Run;
         int                   m_Canceled;
         bool                  m_ReportProgress;
+        dmArray<PendingRequest*> m_Pending;
+        // The requests currently being sent with dmHttpClient::GetPipelined(), or 0
+        PendingRequest**      m_Batch;
+        // Set when a pipelined request failed. The remaining queued requests are sent one at a time
+        bool                  m_PipelineFailed;
     };
 
     struct HttpService
@@ -75,6 +92,7 @@ namespace dmHttpService
             m_HttpCache = 0;
             m_LoadBalanceCount = 0;
             m_Run = false;
+            m_Pipelining = false;
         }
         dmArray<Worker*>          m_Workers;
         dmThread::Thread          m_Balancer;
@@ -83,6 +101,7 @@ namespace dmHttpService
         ReportProgressCallback    m_ReportProgressCallback;
         int                       m_LoadBalanceCount;
         volatile bool             m_Run;
+        bool                      m_Pipelining;
     };
 
     void HttpHeader(dmHttpClient::HResponse response, void* user_data, int status_code, const char* key, const char* value)
@@ -159,14 +178,18 @@ namespace dmHttpService
     dmHttpClient::Result HttpWriteHeaders(dmHttpClient::HResponse response, void* user_data)
     {
         Worker* worker = (Worker*) user_data;
+        const dmHttpDDF::HttpRequest* request = worker->m_Request;
+        if (worker->m_Batch) {
+            request = worker->m_Batch[dmHttpClient::GetRequestIndex(response)]->m_Request;
+        }
         char* headers = 0;
-        if (worker->m_Request->m_HeadersLength > 0) {
-            headers = (char*) malloc(worker->m_Request->m_HeadersLength);
+        if (request->m_HeadersLength > 0) {
+            headers = (char*) malloc(request->m_HeadersLength);
             // NOTE: We must copy the buffer as retry might happen
             // and dmStrTok is destructive
             // We don't know the actual size inadvance, hence the malloc()
-            memcpy(headers, (char*) worker->m_Request->m_Headers, worker->m_Request->m_HeadersLength);
-            headers[worker->m_Request->m_HeadersLength-1] = '\0';
+            memcpy(headers, (char*) request->m_Headers, request->m_HeadersLength);
+            headers[request->m_HeadersLength-1] = '\0';
 
             char* s, *last;
             s = dmStrTok(headers, "\n", &last);
@@ -219,26 +242,37 @@ namespace dmHttpService
         }
     }
 
-    void HandleRequest(Worker* worker, const dmMessage::URL* requester, uintptr_t userdata1, uintptr_t userdata2, dmHttpDDF::HttpRequest* request)
+    // Converts the string offsets in the message data to pointers
+    static void ResolveRequest(dmHttpDDF::HttpRequest* request)
     {
-        dmURI::Parts url;
         request->m_Method = (const char*) ((uintptr_t) request + (uintptr_t) request->m_Method);
         request->m_Url = (const char*) ((uintptr_t) request + (uintptr_t) request->m_Url);
-        dmURI::Result ur =  dmURI::Parse(request->m_Url, &url);
-        if (ur != dmURI::RESULT_OK)
+    }
+
+    static bool ParseURL(const dmHttpDDF::HttpRequest* request, dmURI::Parts* url)
+    {
+        if (dmURI::Parse(request->m_Url, url) != dmURI::RESULT_OK)
         {
-            SendResponse(requester, 0, 0, 0, 0, 0, 0, 0, 0);
-            return;
+            return false;
         }
-        if (url.m_Path[0] == '\0') {
+        if (url->m_Path[0] == '\0') {
             // NOTE: Default to / for empty path
-            url.m_Path[0] = '/';
-            url.m_Path[1] = '\0';
+            url->m_Path[0] = '/';
+            url->m_Path[1] = '\0';
         }
+        return true;
+    }
+
+    static bool IsSameHost(const dmURI::Parts* a, const dmURI::Parts* b)
+    {
+        return strcmp(a->m_Hostname, b->m_Hostname) == 0 &&
+               strcmp(a->m_Scheme, b->m_Scheme) == 0 &&
+               a->m_Port == b->m_Port;
+    }
 
-        if (worker->m_Client == 0 || !(strcmp(url.m_Hostname, worker->m_CurrentURL.m_Hostname) == 0 &&
-                                       strcmp(url.m_Scheme, worker->m_CurrentURL.m_Scheme) == 0 &&
-                                       url.m_Port == worker->m_CurrentURL.m_Port)) {
+    static void SetupClient(Worker* worker, const dmURI::Parts& url, const dmHttpDDF::HttpRequest* request)
+    {
+        if (worker->m_Client == 0 || !IsSameHost(&url, &worker->m_CurrentURL)) {
             if (worker->m_Client) {
                 dmHttpClient::Delete(worker->m_Client);
             }
@@ -257,6 +291,18 @@ namespace dmHttpService
 
             memcpy(&worker->m_CurrentURL, &url, sizeof(url));
         }
+    }
+
+    void HandleRequest(Worker* worker, const dmMessage::URL* requester, uintptr_t userdata1, uintptr_t userdata2, dmHttpDDF::HttpRequest* request)
+    {
+        dmURI::Parts url;
+        if (!ParseURL(request, &url))
+        {
+            SendResponse(requester, 0, 0, 0, 0, 0, 0, 0, 0);
+            return;
+        }
+
+        SetupClient(worker, url, request);
 
         worker->m_Response.SetSize(0);
         worker->m_Response.SetCapacity(DEFAULT_RESPONSE_BUFFER_SIZE);
@@ -294,6 +340,106 @@ namespace dmHttpService
         }
     }
 
+    static void HttpPipelinedResponse(dmHttpClient::HClient client, void* user_data, uint32_t index, dmHttpClient::Result r)
+    {
+        Worker* worker = (Worker*) user_data;
+        PendingRequest* pending = worker->m_Batch[index];
+
+        if (r == dmHttpClient::RESULT_OK || r == dmHttpClient::RESULT_NOT_200_OK) {
+            SendResponse(&pending->m_Requester, 0, pending->m_UserData2, worker->m_Status, worker->m_Headers.Begin(), worker->m_Headers.Size(), worker->m_Response.Begin(), worker->m_Response.Size(), pending->m_Request->m_Path);
+        } else {
+            // Resent as a regular request by HandleRequests(), which reports any error
+            pending->m_Failed = true;
+        }
+
+        worker->m_Status = 0;
+        worker->m_Response.SetSize(0);
+        worker->m_Headers.SetSize(0);
+    }
+
+    // Sends GET-requests to the same host pipelined on one connection
+    static void HandleRequests(Worker* worker, PendingRequest** batch, uint32_t count)
+    {
+        const dmHttpDDF::HttpRequest* first = batch[0]->m_Request;
+        SetupClient(worker, batch[0]->m_URL, first);
+        if (!worker->m_Client) {
+            for (uint32_t i = 0; i < count; ++i) {
+                HandleRequest(worker, &batch[i]->m_Requester, 0, batch[i]->m_UserData2, batch[i]->m_Request);
+            }
+            return;
+        }
+
+        worker->m_Response.SetSize(0);
+        worker->m_Response.SetCapacity(DEFAULT_RESPONSE_BUFFER_SIZE);
+        worker->m_Headers.SetSize(0);
+        worker->m_Headers.SetCapacity(DEFAULT_HEADER_BUFFER_SIZE);
+        worker->m_ReportProgress = false;
+
+        dmHttpClient::SetOptionInt(worker->m_Client, dmHttpClient::OPTION_REQUEST_TIMEOUT, first->m_Timeout);
+        dmHttpClient::SetOptionInt(worker->m_Client, dmHttpClient::OPTION_REQUEST_IGNORE_CACHE, first->m_IgnoreCache);
+
+        const char** paths = (const char**) malloc(count * sizeof(const char*));
+        for (uint32_t i = 0; i < count; ++i) {
+            paths[i] = batch[i]->m_URL.m_Path;
+        }
+
+        worker->m_Batch = batch;
+        dmHttpClient::GetPipelined(worker->m_Client, paths, count, HttpPipelinedResponse);
+        worker->m_Batch = 0;
+        free(paths);
+
+        // Fall back to sequential requests for the ones that failed on the pipelined connection
+        for (uint32_t i = 0; i < count; ++i) {
+            if (batch[i]->m_Failed) {
+                dmLogWarning("Pipelined HTTP request to '%s' failed, retrying it on its own", batch[i]->m_Request->m_Url);
+                worker->m_PipelineFailed = true;
+                HandleRequest(worker, &batch[i]->m_Requester, 0, batch[i]->m_UserData2, batch[i]->m_Request);
+            }
+        }
+    }
+
+    static bool CanPipeline(const PendingRequest* a, const PendingRequest* b)
+    {
+        return IsSameHost(&a->m_URL, &b->m_URL) &&
+               a->m_Request->m_Timeout == b->m_Request->m_Timeout &&
+               a->m_Request->m_IgnoreCache == b->m_Request->m_IgnoreCache;
+    }
+
+    static void FreePendingRequest(PendingRequest* pending)
+    {
+        free((void*) pending->m_Request->m_Headers);
+        free((void*) pending->m_Request->m_Request);
+        free(pending->m_Request);
+        delete pending;
+    }
+
+    // Handles the requests queued by Dispatch. Consecutive requests to the same host are pipelined.
+    static void HandlePendingRequests(Worker* worker)
+    {
+        dmArray<PendingRequest*>& pending = worker->m_Pending;
+        uint32_t i = 0;
+        while (i < pending.Size())
+        {
+            uint32_t end = i + 1;
+            while (!worker->m_PipelineFailed && end < pending.Size() && CanPipeline(pending[i], pending[end])) {
+                ++end;
+            }
+
+            if (end - i == 1) {
+                HandleRequest(worker, &pending[i]->m_Requester, 0, pending[i]->m_UserData2, pending[i]->m_Request);
+            } else {
+                HandleRequests(worker, &pending[i], end - i);
+            }
+            i = end;
+        }
+
+        for (uint32_t j = 0; j < pending.Size(); ++j) {
+            FreePendingRequest(pending[j]);
+        }
+        pending.SetSize(0);
+        worker->m_PipelineFailed = false;
+    }
+
     void Dispatch(dmMessage::Message *message, void* user_ptr)
     {
         Worker* worker = (Worker*) user_ptr;
@@ -308,12 +454,40 @@ namespace dmHttpService
             if (message->m_Descriptor == (uintptr_t) dmHttpDDF::HttpRequest::m_DDFDescriptor)
             {
                 dmHttpDDF::HttpRequest* request = (dmHttpDDF::HttpRequest*) &message->m_Data[0];
+                ResolveRequest(request);
+
+                // With pipelining enabled, GET-requests without progress reports are queued, and sent
+                // pipelined after all messages have been dispatched
+                dmURI::Parts url;
+                if (worker->m_Service->m_Pipelining && strcmp(request->m_Method, "GET") == 0 && !request->m_ReportProgress && ParseURL(request, &url))
+                {
+                    PendingRequest* pending = new PendingRequest;
+                    pending->m_Requester = message->m_Sender;
+                    pending->m_UserData2 = message->m_UserData2;
+                    pending->m_Request = (dmHttpDDF::HttpRequest*) malloc(message->m_DataSize);
+                    memcpy(pending->m_Request, request, message->m_DataSize);
+                    // The strings are stored after the request in the message data
+                    pending->m_Request->m_Method = (const char*) ((uintptr_t) pending->m_Request + ((uintptr_t) request->m_Method - (uintptr_t) request));
+                    pending->m_Request->m_Url = (const char*) ((uintptr_t) pending->m_Request + ((uintptr_t) request->m_Url - (uintptr_t) request));
+                    memcpy(&pending->m_URL, &url, sizeof(url));
+                    pending->m_Failed = false;
+                    if (worker->m_Pending.Full()) {
+                        worker->m_Pending.OffsetCapacity(16);
+                    }
+                    worker->m_Pending.Push(pending);
+                    return;
+                }
+
+                // Keep the order of the requests
+                HandlePendingRequests(worker);
                 HandleRequest(worker, &message->m_Sender, 0, message->m_UserData2, request);
                 free((void*) request->m_Headers);
                 free((void*) request->m_Request);
             }
             else if (message->m_Descriptor == (uintptr_t) dmHttpDDF::StopHttp::m_DDFDescriptor)
             {
+                // The requests that were queued before the stop message are still sent
+                HandlePendingRequests(worker);
                 worker->m_Run = false;
             }
             else
@@ -370,6 +544,8 @@ namespace dmHttpService
             if (!worker->m_Run)
                 break;
 
+            HandlePendingRequests(worker);
+
             if (worker->m_CacheFlusher && dmTime::GetTime() > next_flush) {
                 dmHttpCache::Flush(worker->m_Service->m_HttpCache);
                 next_flush = dmTime::GetTime() + flush_period;
@@ -422,6 +598,7 @@ namespace dmHttpService
 #endif
 
         service->m_Run = true;
+        service->m_Pipelining = params->m_Pipelining != 0;
         dmMessage::NewSocket(HTTP_SOCKET_NAME, &service->m_Socket);
         service->m_Workers.SetCapacity(threadcount);
         for (uint32_t i = 0; i < threadcount; ++i)
@@ -438,6 +615,8 @@ namespace dmHttpService
             worker->m_CacheFlusher = i == 0 && worker->m_Service->m_HttpCache != 0;
             worker->m_Run = true;
             worker->m_Canceled = 0;
+            worker->m_Batch = 0;
+            worker->m_PipelineFailed = false;
             service->m_Workers.Push(worker);
 
             dmThread::Thread t = dmThread::New(&Loop, THREAD_STACK_SIZE, worker, "http");
@@ -489,6 +668,12 @@ namespace dmHttpService
                 dmThread::Join(worker->m_Thread);
             }
 
+            // Requests that were queued when the service was stopped
+            for (uint32_t j = 0; j < worker->m_Pending.Size(); ++j)
+            {
+                FreePendingRequest(worker->m_Pending[j]);
+            }
+
             dmMessage::DeleteSocket(worker->m_Socket);
             if (worker->m_Client)
             {
@@ -29,11 +29,14 @@ namespace dmHttpService
         : m_ReportProgressCallback(0)
         , m_ThreadCount(4)
         , m_UseHttpCache(1)
+        , m_Pipelining(0)
     	{}
 
         ReportProgressCallback m_ReportProgressCallback;
     	uint32_t               m_ThreadCount  : 4;
         uint32_t               m_UseHttpCache : 1;
+        // Send consecutive GET-requests to the same host pipelined on one connection
+        uint32_t               m_Pipelining   : 1;
     };
 
     HHttpService New(const Params* params);
@@ -19,6 +19,7 @@
 #include <dlib/math.h>
 #include <dlib/pprint.h>
 #include <dlib/profile.h>
+#include <dlib/sys.h>
 
 #include "script_private.h"
 #include "script_hash.h"
@@ -34,6 +35,7 @@
 #include "script_bitop.h"
 #include "script_timer.h"
 #include "script_extensions.h"
+#include "script_alloc.h"
 
 extern "C"
 {
@@ -72,6 +74,12 @@ namespace dmScript
     // A debug value for profiling lua references
     int g_LuaReferenceCount = 0;
 
+    static int LuaPanic(lua_State* L)
+    {
+        dmLogFatal("PANIC: unprotected error in call to Lua API (%s)", lua_tostring(L, -1));
+        return 0;
+    }
+
     HContext NewContext(const ContextParams& params)
     {
         Context* context = new Context();
@@ -82,8 +90,45 @@ namespace dmScript
         context->m_ConfigFile = params.m_ConfigFile;
         context->m_ResourceFactory = params.m_Factory;
         context->m_GraphicsContext = params.m_GraphicsContext;
-        context->m_LuaState = lua_open();
+        context->m_LuaAllocator = 0;
+        context->m_LuaState = 0;
+        if (IsLuaAllocatorSupported())
+        {
+            context->m_LuaAllocator = NewLuaAllocator();
+            context->m_LuaState = lua_newstate(LuaAllocatorAlloc, context->m_LuaAllocator);
+            if (context->m_LuaState)
+            {
+                lua_atpanic(context->m_LuaState, LuaPanic);
+            }
+            else
+            {
+                DeleteLuaAllocator(context->m_LuaAllocator);
+                context->m_LuaAllocator = 0;
+            }
+        }
+        if (!context->m_LuaState)
+        {
+            context->m_LuaState = lua_open();
+        }
         context->m_ContextTableRef = LUA_NOREF;
+        context->m_BytecodeCachePath = 0;
+        context->m_BytecodeCacheHits = 0;
+        context->m_BytecodeCacheMisses = 0;
+        const char* cache_path = params.m_EnableBytecodeCache && params.m_ConfigFile ? dmConfigFile::GetString(params.m_ConfigFile, "script.bytecode_cache", 0) : 0;
+        if (cache_path != 0 && cache_path[0] != 0)
+        {
+            dmSys::Result r = dmSys::Mkdir(cache_path, 0755);
+            if (r == dmSys::RESULT_OK || r == dmSys::RESULT_EXIST)
+            {
+                context->m_BytecodeCachePath = strdup(cache_path);
+                uint32_t max_size_mb = (uint32_t)dmConfigFile::GetInt(params.m_ConfigFile, "script.bytecode_cache_max_size", 64);
+                TrimBytecodeCache(cache_path, (uint64_t)max_size_mb * 1024 * 1024);
+            }
+            else
+            {
+                dmLogWarning("Unable to create lua bytecode cache directory '%s' (%d)", cache_path, r);
+            }
+        }
         return context;
     }
 
@@ -91,6 +136,11 @@ namespace dmScript
     {
         ClearModules(context);
         lua_close(context->m_LuaState);
+        if (context->m_LuaAllocator)
+        {
+            DeleteLuaAllocator(context->m_LuaAllocator);
+        }
+        free(context->m_BytecodeCachePath);
         delete context;
     }
 
@@ -229,6 +279,10 @@ namespace dmScript
 
     void Update(HContext context)
     {
+        if (context->m_LuaAllocator)
+        {
+            UpdateLuaAllocatorProfile(context->m_LuaAllocator);
+        }
         for (HScriptExtension* l = context->m_ScriptExtensions.Begin(); l != context->m_ScriptExtensions.End(); ++l)
         {
             if ((*l)->Update != 0x0)
@@ -87,6 +87,8 @@ namespace dmScript
         dmConfigFile::HConfig m_ConfigFile;
         dmResource::HFactory  m_Factory;
         dmGraphics::HContext  m_GraphicsContext;
+        /// Honour the "script.bytecode_cache" setting. Only set by development builds of the engine
+        uint8_t               m_EnableBytecodeCache:1;
     };
 
     /**
@@ -0,0 +1,298 @@
+// Copyright 2020-2024 The Defold Foundation
+// Copyright 2014-2020 King
+// Copyright 2009-2014 Ragnar Svensson, Christian Murray
+// Licensed under the Defold License version 1.0 (the "License"); you may not use
+// this file except in compliance with the License.
+//
+// You may obtain a copy of the License, together with FAQs at
+// https://www.defold.com/license
+//
+// Unless required by applicable law or agreed to in writing, software distributed
+// under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+// CONDITIONS OF ANY KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations under the License.
+
+#include "script_alloc.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <dlib/math.h>
+#include <dlib/memory.h>
+#include <dlib/profile.h>
+
+extern "C"
+{
+#include <lua/lua.h>
+#include <lua/lauxlib.h>
+}
+
+DM_PROPERTY_EXTERN(rmtp_Script);
+DM_PROPERTY_U32(rmtp_ScriptAllocations, 0, FrameReset, "# lua allocations", &rmtp_Script);
+DM_PROPERTY_U32(rmtp_ScriptPooledAllocations, 0, FrameReset, "# lua allocations from the small block pool", &rmtp_Script);
+DM_PROPERTY_U32(rmtp_ScriptFrees, 0, FrameReset, "# lua blocks freed", &rmtp_Script);
+DM_PROPERTY_U32(rmtp_ScriptPoolSize, 0, FrameReset, "lua small block pool size (bytes)", &rmtp_Script);
+
+namespace dmScript
+{
+    // Blocks up to LUA_POOL_MAX_BLOCK_SIZE are rounded up to a multiple of LUA_POOL_GRANULARITY
+    // and served from pages that hold blocks of a single size class. A page is found from a block
+    // address, since pages are aligned to their size. Pages with unused blocks are kept in a list per
+    // size class, and a page is returned to the system when all its blocks are freed, unless it's the
+    // last page with unused blocks of its class.
+    static const uint32_t LUA_POOL_GRANULARITY = 16;
+    static const uint32_t LUA_POOL_MAX_BLOCK_SIZE = 128;
+    static const uint32_t LUA_POOL_CLASS_COUNT = LUA_POOL_MAX_BLOCK_SIZE / LUA_POOL_GRANULARITY;
+    static const uint32_t LUA_POOL_PAGE_SIZE = 16 * 1024;
+    static const uint32_t LUA_POOL_NO_CLASS = 0xffffffff;
+
+    struct LuaPoolBlock
+    {
+        LuaPoolBlock* m_Next;
+    };
+
+    struct LuaPoolPage
+    {
+        LuaPoolBlock*   m_FreeList;     // Freed blocks
+        LuaPoolPage*    m_Prev;         // Pages of the size class with unused blocks
+        LuaPoolPage*    m_Next;
+        uint16_t        m_Used;         // Number of allocated blocks
+        uint16_t        m_Bumped;       // Number of blocks taken from the unused tail of the page
+        uint16_t        m_BlockCount;
+        uint16_t        m_SizeClass;
+    };
+
+    // The blocks start after the header, and keep the 16 byte alignment of the page
+    static const uint32_t LUA_POOL_PAGE_HEADER_SIZE = (sizeof(LuaPoolPage) + LUA_POOL_GRANULARITY - 1) & ~(LUA_POOL_GRANULARITY - 1);
+
+    struct LuaAllocator
+    {
+        LuaPoolPage*        m_Pages[LUA_POOL_CLASS_COUNT]; // Pages with unused blocks
+        LuaAllocatorStats   m_Stats;
+        LuaAllocatorStats   m_ProfiledStats;
+    };
+
+    static inline uint32_t GetSizeClass(size_t size)
+    {
+        return size <= LUA_POOL_MAX_BLOCK_SIZE ? (uint32_t)((size - 1) / LUA_POOL_GRANULARITY) : LUA_POOL_NO_CLASS;
+    }
+
+    static inline LuaPoolPage* GetPage(void* ptr)
+    {
+        return (LuaPoolPage*)((uintptr_t)ptr & ~(uintptr_t)(LUA_POOL_PAGE_SIZE - 1));
+    }
+
+    static void LinkPage(LuaAllocator* allocator, LuaPoolPage* page)
+    {
+        LuaPoolPage*& head = allocator->m_Pages[page->m_SizeClass];
+        page->m_Prev = 0;
+        page->m_Next = head;
+        if (head)
+            head->m_Prev = page;
+        head = page;
+    }
+
+    static void UnlinkPage(LuaAllocator* allocator, LuaPoolPage* page)
+    {
+        if (page->m_Prev)
+            page->m_Prev->m_Next = page->m_Next;
+        else
+            allocator->m_Pages[page->m_SizeClass] = page->m_Next;
+        if (page->m_Next)
+            page->m_Next->m_Prev = page->m_Prev;
+        page->m_Prev = 0;
+        page->m_Next = 0;
+    }
+
+    static LuaPoolPage* NewPage(LuaAllocator* allocator, uint32_t size_class)
+    {
+        void* memory = 0;
+        if (dmMemory::AlignedMalloc(&memory, LUA_POOL_PAGE_SIZE, LUA_POOL_PAGE_SIZE) != dmMemory::RESULT_OK)
+            return 0;
+        LuaPoolPage* page = (LuaPoolPage*)memory;
+        page->m_FreeList = 0;
+        page->m_Used = 0;
+        page->m_Bumped = 0;
+        page->m_BlockCount = (uint16_t)((LUA_POOL_PAGE_SIZE - LUA_POOL_PAGE_HEADER_SIZE) / ((size_class + 1) * LUA_POOL_GRANULARITY));
+        page->m_SizeClass = (uint16_t)size_class;
+        LinkPage(allocator, page);
+        allocator->m_Stats.m_PoolSize += LUA_POOL_PAGE_SIZE;
+        return page;
+    }
+
+    static void DeletePage(LuaAllocator* allocator, LuaPoolPage* page)
+    {
+        UnlinkPage(allocator, page);
+        allocator->m_Stats.m_PoolSize -= LUA_POOL_PAGE_SIZE;
+        dmMemory::AlignedFree(page);
+    }
+
+    static void* AllocPooled(LuaAllocator* allocator, uint32_t size_class)
+    {
+        LuaPoolPage* page = allocator->m_Pages[size_class];
+        if (!page)
+        {
+            page = NewPage(allocator, size_class);
+            if (!page)
+                return 0;
+        }
+
+        void* p;
+        if (page->m_FreeList)
+        {
+            p = page->m_FreeList;
+            page->m_FreeList = page->m_FreeList->m_Next;
+        }
+        else
+        {
+            p = (uint8_t*)page + LUA_POOL_PAGE_HEADER_SIZE + page->m_Bumped * (size_class + 1) * LUA_POOL_GRANULARITY;
+            page->m_Bumped++;
+        }
+
+        if (++page->m_Used == page->m_BlockCount)
+            UnlinkPage(allocator, page);
+        return p;
+    }
+
+    static inline void FreePooled(LuaAllocator* allocator, void* ptr)
+    {
+        LuaPoolPage* page = GetPage(ptr);
+        LuaPoolBlock* block = (LuaPoolBlock*)ptr;
+        block->m_Next = page->m_FreeList;
+        page->m_FreeList = block;
+
+        if (page->m_Used-- == page->m_BlockCount)
+        {
+            LinkPage(allocator, page);
+        }
+        else if (page->m_Used == 0 && (page->m_Prev != 0 || page->m_Next != 0))
+        {
+            DeletePage(allocator, page);
+        }
+    }
+
+    static void* Alloc(LuaAllocator* allocator, size_t size)
+    {
+        allocator->m_Stats.m_Allocations++;
+        uint32_t size_class = GetSizeClass(size);
+        if (size_class != LUA_POOL_NO_CLASS)
+        {
+            allocator->m_Stats.m_PooledAllocations++;
+            return AllocPooled(allocator, size_class);
+        }
+        return malloc(size);
+    }
+
+    static void Free(LuaAllocator* allocator, void* ptr, size_t size)
+    {
+        allocator->m_Stats.m_Frees++;
+        if (GetSizeClass(size) != LUA_POOL_NO_CLASS)
+            FreePooled(allocator, ptr);
+        else
+            free(ptr);
+    }
+
+    static int WriteChunkHeader(lua_State* L, const void* p, size_t size, void* ud)
+    {
+        uint8_t* header = (uint8_t*)ud;
+        if (header[0] == 0)
+            memcpy(header, p, dmMath::Min(size, (size_t)8));
+        return 0;
+    }
+
+    bool IsLuaAllocatorSupported()
+    {
+        // LuaJIT on 64 bit targets without GC64 only supports its internal allocator, and lua_newstate()
+        // prints an error and fails. The mode isn't visible in the headers, but LuaJIT marks GC64 bytecode
+        // with the BCDUMP_F_FR2 flag, so the support is checked once with a dummy chunk.
+        static int supported = -1;
+        if (supported == -1)
+        {
+            uint8_t header[8] = {0};
+            if (sizeof(void*) == 8)
+            {
+                lua_State* L = luaL_newstate();
+                if (L)
+                {
+                    if (luaL_loadstring(L, "return") == 0)
+                        lua_dump(L, WriteChunkHeader, header);
+                    lua_close(L);
+                }
+            }
+            bool luajit = header[0] == 0x1b && header[1] == 'L' && header[2] == 'J';
+            supported = (luajit && (header[4] & 0x08) == 0) ? 0 : 1;
+        }
+        return supported == 1;
+    }
+
+    HLuaAllocator NewLuaAllocator()
+    {
+        LuaAllocator* allocator = new LuaAllocator;
+        memset(allocator->m_Pages, 0, sizeof(allocator->m_Pages));
+        memset(&allocator->m_Stats, 0, sizeof(allocator->m_Stats));
+        memset(&allocator->m_ProfiledStats, 0, sizeof(allocator->m_ProfiledStats));
+        return allocator;
+    }
+
+    void DeleteLuaAllocator(HLuaAllocator allocator)
+    {
+        // All blocks are freed when the lua state is closed, so every remaining page has unused blocks
+        for (uint32_t i = 0; i < LUA_POOL_CLASS_COUNT; ++i)
+        {
+            while (allocator->m_Pages[i])
+            {
+                DeletePage(allocator, allocator->m_Pages[i]);
+            }
+        }
+        delete allocator;
+    }
+
+    void* LuaAllocatorAlloc(void* ud, void* ptr, size_t osize, size_t nsize)
+    {
+        LuaAllocator* allocator = (LuaAllocator*)ud;
+        if (nsize == 0)
+        {
+            if (ptr)
+                Free(allocator, ptr, osize);
+            return 0;
+        }
+        if (ptr == 0)
+        {
+            return Alloc(allocator, nsize);
+        }
+
+        uint32_t old_class = GetSizeClass(osize);
+        uint32_t new_class = GetSizeClass(nsize);
+        if (old_class == LUA_POOL_NO_CLASS && new_class == LUA_POOL_NO_CLASS)
+        {
+            // On failure, the old block is left untouched which is what lua expects
+            return realloc(ptr, nsize);
+        }
+        if (old_class == new_class)
+        {
+            return ptr;
+        }
+
+        void* new_ptr = Alloc(allocator, nsize);
+        if (!new_ptr)
+            return 0;
+        memcpy(new_ptr, ptr, dmMath::Min(osize, nsize));
+        Free(allocator, ptr, osize);
+        return new_ptr;
+    }
+
+    void GetLuaAllocatorStats(HLuaAllocator allocator, LuaAllocatorStats* stats)
+    {
+        *stats = allocator->m_Stats;
+    }
+
+    void UpdateLuaAllocatorProfile(HLuaAllocator allocator)
+    {
+        const LuaAllocatorStats& stats = allocator->m_Stats;
+        LuaAllocatorStats& profiled = allocator->m_ProfiledStats;
+        DM_PROPERTY_ADD_U32(rmtp_ScriptAllocations, stats.m_Allocations - profiled.m_Allocations);
+        DM_PROPERTY_ADD_U32(rmtp_ScriptPooledAllocations, stats.m_PooledAllocations - profiled.m_PooledAllocations);
+        DM_PROPERTY_ADD_U32(rmtp_ScriptFrees, stats.m_Frees - profiled.m_Frees);
+        DM_PROPERTY_ADD_U32(rmtp_ScriptPoolSize, stats.m_PoolSize);
+        profiled = stats;
+    }
+}
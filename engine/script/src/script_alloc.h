@@ -0,0 +1,62 @@
+// Copyright 2020-2024 The Defold Foundation
+// Copyright 2014-2020 King
+// Copyright 2009-2014 Ragnar Svensson, Christian Murray
+// Licensed under the Defold License version 1.0 (the "License"); you may not use
+// this file except in compliance with the License.
+//
+// You may obtain a copy of the License, together with FAQs at
+// https://www.defold.com/license
+//
+// Unless required by applicable law or agreed to in writing, software distributed
+// under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+// CONDITIONS OF ANY KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations under the License.
+
+#ifndef DM_SCRIPT_ALLOC_H
+#define DM_SCRIPT_ALLOC_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+namespace dmScript
+{
+    typedef struct LuaAllocator* HLuaAllocator;
+
+    struct LuaAllocatorStats
+    {
+        uint32_t m_Allocations;         // Total number of blocks allocated
+        uint32_t m_PooledAllocations;   // Number of allocations served by the small block pool
+        uint32_t m_Frees;               // Total number of blocks freed
+        uint32_t m_PoolSize;            // Memory reserved by the small block pool (bytes)
+    };
+
+    /**
+     * Check if the lua runtime accepts a custom allocator in lua_newstate(). LuaJIT on 64 bit
+     * targets without GC64 doesn't.
+     */
+    bool IsLuaAllocatorSupported();
+
+    /**
+     * Create an allocator for a lua state. Small blocks, e.g. vmath userdata and short strings,
+     * are served from size class pages so that short lived objects are recycled
+     * without a round trip to the system allocator. Larger blocks use realloc/free.
+     * Pages are returned to the system when all their blocks are freed.
+     * The allocator must outlive the lua state using it.
+     */
+    HLuaAllocator NewLuaAllocator();
+    void DeleteLuaAllocator(HLuaAllocator allocator);
+
+    /**
+     * The lua_Alloc function, pass the allocator as user data to lua_newstate
+     */
+    void* LuaAllocatorAlloc(void* ud, void* ptr, size_t osize, size_t nsize);
+
+    void GetLuaAllocatorStats(HLuaAllocator allocator, LuaAllocatorStats* stats);
+
+    /**
+     * Add the allocations made since the last call to the profiler properties
+     */
+    void UpdateLuaAllocatorProfile(HLuaAllocator allocator);
+}
+
+#endif // DM_SCRIPT_ALLOC_H
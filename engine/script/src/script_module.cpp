@@ -17,13 +17,26 @@
 #include "script_private.h"
 
 #include <stdint.h>
+#include <stdio.h>
 #include <string.h>
+#include <algorithm>
+#if defined(_WIN32)
+#include <process.h>
+#include <sys/utime.h>
+#else
+#include <unistd.h>
+#include <utime.h>
+#endif
 
 #include <dlib/dstrings.h>
+#include <dlib/hash.h>
 #include <dlib/math.h>
 #include <dlib/message.h>
 #include <dlib/log.h>
 #include <dlib/path.h>
+#include <dlib/profile.h>
+#include <dlib/sys.h>
+#include <dlib/time.h>
 
 #include <ddf/ddf.h>
 
@@ -35,6 +48,12 @@ extern "C"
 #include <lua/lualib.h>
 }
 
+DM_PROPERTY_EXTERN(rmtp_Script);
+DM_PROPERTY_U32(rmtp_ScriptChunksLoaded, 0, FrameReset, "# lua chunks loaded", &rmtp_Script);
+DM_PROPERTY_U32(rmtp_ScriptLoadTime, 0, NoFlags, "total lua chunk load time (us)", &rmtp_Script);
+DM_PROPERTY_U32(rmtp_ScriptBytecodeCacheHits, 0, NoFlags, "# lua bytecode cache hits", &rmtp_Script);
+DM_PROPERTY_U32(rmtp_ScriptBytecodeCacheMisses, 0, NoFlags, "# lua bytecode cache misses", &rmtp_Script);
+
 namespace dmScript
 {
 
@@ -55,12 +74,219 @@ namespace dmScript
         *size = source->m_Script.m_Count;
     }
 
+    // Persistent on-disk cache of compiled chunks, used in development builds where the
+    // content is built without bytecode. The cache is keyed by the content hash of the
+    // source together with the chunk name (which is stored in the bytecode debug info).
+
+    static void GetBytecodeCachePath(HContext context, const char* buf, uint32_t size, const char* chunkname, char* path, uint32_t path_size)
+    {
+        // The key is never stored in the content, so the faster hash version can be used
+        uint64_t source_hash = dmHashBufferVersion64(DMHASH_VERSION_FAST, buf, size);
+        uint64_t chunkname_hash = dmHashBufferVersion64(DMHASH_VERSION_FAST, chunkname, strlen(chunkname));
+        uint64_t hash = source_hash ^ (chunkname_hash + 0x9E3779B97F4A7C15ULL + (source_hash << 6) + (source_hash >> 2));
+        dmSnPrintf(path, path_size, "%s/%016llx.luac", context->m_BytecodeCachePath, (unsigned long long)hash);
+    }
+
+    static int LoadCachedBytecode(lua_State* L, const char* path, const char* chunkname)
+    {
+        uint32_t file_size = 0;
+        if (dmSys::ResourceSize(path, &file_size) != dmSys::RESULT_OK || file_size == 0)
+            return -1;
+
+        char* bytecode = (char*) malloc(file_size);
+        uint32_t bytecode_size = 0;
+        int ret = -1;
+        if (dmSys::LoadResource(path, bytecode, file_size, &bytecode_size) == dmSys::RESULT_OK && bytecode[0] == LUA_SIGNATURE[0])
+        {
+            ret = luaL_loadbuffer(L, bytecode, bytecode_size, chunkname);
+            if (ret != 0)
+            {
+                // A stale or corrupt cache entry, e.g. written by a different Lua runtime. Recompile from source.
+                lua_pop(L, 1);
+            }
+        }
+        free(bytecode);
+
+        if (ret == 0)
+        {
+            // Refresh the modification time, which TrimBytecodeCache uses as the last use time
+#if defined(_WIN32)
+            _utime(path, 0);
+#else
+            utime(path, 0);
+#endif
+        }
+        return ret;
+    }
+
+    static uint32_t GetProcessId()
+    {
+#if defined(_WIN32)
+        return (uint32_t)_getpid();
+#else
+        return (uint32_t)getpid();
+#endif
+    }
+
+    static int WriteBytecode(lua_State* L, const void* p, size_t size, void* ud)
+    {
+        dmArray<char>* buffer = (dmArray<char>*) ud;
+        if (buffer->Remaining() < size)
+        {
+            buffer->OffsetCapacity(dmMath::Max((uint32_t) size, buffer->Capacity()));
+        }
+        buffer->PushArray((const char*) p, (uint32_t) size);
+        return 0;
+    }
+
+    static void StoreCachedBytecode(lua_State* L, const char* path)
+    {
+        dmArray<char> buffer;
+        buffer.SetCapacity(16 * 1024);
+        if (lua_dump(L, WriteBytecode, &buffer) != 0 || buffer.Empty())
+            return;
+
+        // Write to a temporary file and rename it, so that a concurrent engine instance never reads a partial file.
+        // The temporary name is unique per process, since instances sharing the cache may store the same chunk
+        char tmp_path[DMPATH_MAX_PATH];
+        dmSnPrintf(tmp_path, sizeof(tmp_path), "%s.%u.%llx.tmp", path, GetProcessId(), (unsigned long long)dmTime::GetTime());
+        FILE* file = fopen(tmp_path, "wb");
+        if (!file)
+            return;
+        bool ok = fwrite(buffer.Begin(), 1, buffer.Size(), file) == buffer.Size();
+        fclose(file);
+        if (!ok || dmSys::Rename(path, tmp_path) != dmSys::RESULT_OK)
+        {
+            dmSys::Unlink(tmp_path);
+        }
+    }
+
+    struct BytecodeCacheEntry
+    {
+        char*    m_Path;
+        uint64_t m_Size;
+        uint64_t m_ModifiedTime;
+    };
+
+    struct BytecodeCacheEntries
+    {
+        dmArray<BytecodeCacheEntry> m_Entries;
+        uint64_t                    m_TotalSize;
+        uint64_t                    m_Now;
+    };
+
+    static bool HasSuffix(const char* path, const char* suffix)
+    {
+        size_t path_len = strlen(path);
+        size_t suffix_len = strlen(suffix);
+        return path_len >= suffix_len && strcmp(path + path_len - suffix_len, suffix) == 0;
+    }
+
+    static void CollectBytecodeCacheEntry(void* ctx, const char* path, bool isdir)
+    {
+        if (isdir)
+            return;
+        BytecodeCacheEntries* entries = (BytecodeCacheEntries*) ctx;
+        dmSys::StatInfo info;
+        if (dmSys::Stat(path, &info) != dmSys::RESULT_OK)
+            return;
+
+        if (HasSuffix(path, ".tmp"))
+        {
+            // Left behind by an engine that exited while storing a chunk
+            if (entries->m_Now > info.m_ModifiedTime + 60 * 60)
+                dmSys::Unlink(path);
+            return;
+        }
+        if (!HasSuffix(path, ".luac"))
+            return;
+
+        BytecodeCacheEntry entry;
+        entry.m_Path = strdup(path);
+        entry.m_Size = info.m_Size;
+        entry.m_ModifiedTime = info.m_ModifiedTime;
+        if (entries->m_Entries.Full())
+            entries->m_Entries.OffsetCapacity(dmMath::Max(64u, entries->m_Entries.Capacity()));
+        entries->m_Entries.Push(entry);
+        entries->m_TotalSize += entry.m_Size;
+    }
+
+    static bool CompareLastUsed(const BytecodeCacheEntry& a, const BytecodeCacheEntry& b)
+    {
+        return a.m_ModifiedTime < b.m_ModifiedTime;
+    }
+
+    void TrimBytecodeCache(const char* cache_path, uint64_t max_size)
+    {
+        BytecodeCacheEntries entries;
+        entries.m_TotalSize = 0;
+        entries.m_Now = dmTime::GetTime() / 1000000;
+        dmSys::IterateTree(cache_path, false, false, &entries, CollectBytecodeCacheEntry);
+
+        if (entries.m_TotalSize > max_size)
+        {
+            // Remove the least recently used entries. Entries of edited scripts are never loaded again and end up first.
+            // Trim to below the limit, so that the cache isn't trimmed again on the next start.
+            uint64_t target_size = max_size - max_size / 4;
+            std::sort(entries.m_Entries.Begin(), entries.m_Entries.End(), CompareLastUsed);
+            for (uint32_t i = 0; i < entries.m_Entries.Size() && entries.m_TotalSize > target_size; ++i)
+            {
+                if (dmSys::Unlink(entries.m_Entries[i].m_Path) == dmSys::RESULT_OK)
+                    entries.m_TotalSize -= entries.m_Entries[i].m_Size;
+            }
+        }
+
+        for (uint32_t i = 0; i < entries.m_Entries.Size(); ++i)
+        {
+            free(entries.m_Entries[i].m_Path);
+        }
+    }
+
+    // Loads (but doesn't run) a chunk, and reports the load time to the profiler
+    static int LoadBuffer(lua_State* L, const char* buf, uint32_t size, const char* chunkname)
+    {
+        DM_PROFILE("LoadChunk");
+        uint64_t start = dmTime::GetTime();
+        int ret;
+
+        HContext context = GetScriptContext(L);
+        if (context != 0x0 && context->m_BytecodeCachePath != 0x0 && size > 0 && buf[0] != LUA_SIGNATURE[0])
+        {
+            char path[DMPATH_MAX_PATH];
+            GetBytecodeCachePath(context, buf, size, chunkname, path, sizeof(path));
+            ret = LoadCachedBytecode(L, path, chunkname);
+            if (ret == 0)
+            {
+                context->m_BytecodeCacheHits++;
+                DM_PROPERTY_ADD_U32(rmtp_ScriptBytecodeCacheHits, 1);
+            }
+            else
+            {
+                context->m_BytecodeCacheMisses++;
+                DM_PROPERTY_ADD_U32(rmtp_ScriptBytecodeCacheMisses, 1);
+                ret = luaL_loadbuffer(L, buf, size, chunkname);
+                if (ret == 0)
+                {
+                    StoreCachedBytecode(L, path);
+                }
+            }
+        }
+        else
+        {
+            ret = luaL_loadbuffer(L, buf, size, chunkname);
+        }
+
+        DM_PROPERTY_ADD_U32(rmtp_ScriptChunksLoaded, 1);
+        DM_PROPERTY_ADD_U32(rmtp_ScriptLoadTime, (uint32_t)(dmTime::GetTime() - start));
+        return ret;
+    }
+
     int LuaLoad(lua_State *L, dmLuaDDF::LuaSource *source)
     {
         const char *buf;
         uint32_t size;
         GetLuaSource(source, &buf, &size);
-        return luaL_loadbuffer(L, buf, size, source->m_Filename);
+        return LoadBuffer(L, buf, size, source->m_Filename);
     }
 
     static bool LuaLoadModule(lua_State *L, const char *buf, uint32_t size, const char *filename)
@@ -68,7 +294,7 @@ namespace dmScript
         int top = lua_gettop(L);
         (void) top;
 
-        int ret = luaL_loadbuffer(L, buf, size, filename);
+        int ret = LoadBuffer(L, buf, size, filename);
         if (ret == 0)
         {
             assert(top + 1 == lua_gettop(L));
@@ -536,7 +536,7 @@ namespace dmScript
         {
             if (!lua_isnil(L, 3))
             {
-                data_size = dmScript::CheckTable(L, data, MAX_MESSAGE_DATA_SIZE, 3);
+                data_size = dmScript::CheckTableVersion(L, data, MAX_MESSAGE_DATA_SIZE, 3, dmScript::TABLE_VERSION_KEY_REFERENCES);
             }
         }
 
@@ -77,7 +77,11 @@ namespace dmScript
         dmHashTable64<int>          m_HashInstances;
         dmArray<HScriptExtension>   m_ScriptExtensions;
         lua_State*                  m_LuaState;
+        struct LuaAllocator*        m_LuaAllocator; // Small block pool used by m_LuaState, or 0 if lua uses its own allocator
         int                         m_ContextTableRef;
+        char*                       m_BytecodeCachePath; // Directory of the compiled chunk cache (development only), or 0
+        uint32_t                    m_BytecodeCacheHits;
+        uint32_t                    m_BytecodeCacheMisses;
     };
 
     HContext GetScriptContext(lua_State* L);
@@ -88,6 +92,23 @@ namespace dmScript
 
     bool IsValidInstance(lua_State* L);
 
+    /// Table format version with references to repeated string keys. Not readable by older engines,
+    /// so it's only used for messages, which are never stored.
+    const uint32_t TABLE_VERSION_KEY_REFERENCES = 5;
+
+    /**
+     * Serialize a table to a buffer using a specific version of the table format, see CheckTable()
+     * @param version table format version, 3 or later
+     */
+    uint32_t CheckTableVersion(lua_State* L, char* buffer, uint32_t buffer_size, int index, uint32_t version);
+
+    /**
+     * Remove the least recently used entries of the bytecode cache, when its total size is above the limit.
+     * @param cache_path bytecode cache directory
+     * @param max_size maximum total size of the cache entries, in bytes
+     */
+    void TrimBytecodeCache(const char* cache_path, uint64_t max_size);
+
     /**
      * Remove all modules.
      * @param context script context
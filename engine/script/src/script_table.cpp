@@ -13,6 +13,7 @@
 // specific language governing permissions and limitations under the License.
 
 #include <stdint.h>
+#include <stdlib.h>
 #include <string.h>
 #include <dlib/array.h>
 #include <dlib/log.h>
@@ -31,11 +32,20 @@ extern "C"
 // the rest of the types used when serializing a table come from lua.h
 // make sure this type has a value quite a bit higher than the types in lua.h
 #define LUA_TNEGATIVENUMBER 64
+// custom type when writing a string key that has already been written earlier in the same table data
+#define LUA_TSTRINGKEYREF 65
 
 namespace dmScript
 {
     const int TABLE_MAGIC = 0x42544448;
-    const uint32_t TABLE_VERSION_CURRENT = 4;
+    const uint32_t TABLE_VERSION_CURRENT = 5;
+    // Version written by CheckTable(), see the version 5 notes below
+    const uint32_t TABLE_VERSION_PERSISTENT = 4;
+
+    // Max number of string keys per serialized table that can be referenced by index (version 5)
+    const uint32_t TABLE_KEY_DICTIONARY_CAPACITY = 64;
+    // Nesting depth handled without heap allocations when checking for cyclic tables
+    const uint32_t TABLE_STACK_INLINE_CAPACITY = 16;
 
     /*
      * Original table serialization format:
@@ -85,6 +95,14 @@ namespace dmScript
      *
      *    Version 4:
      *    Adds support for more than 65535 keys in a table.
+     *
+     *    Version 5:
+     *    String keys that have already been written earlier in the data (e.g. the same fields in an array of tables)
+     *    are written as key type LUA_TSTRINGKEYREF followed by a MSB encoded index into the list of previously written
+     *    string keys. Only the first TABLE_KEY_DICTIONARY_CAPACITY unique string keys are added to the list, the decoder
+     *    builds the same list as it reads the data.
+     *    Engines before version 5 can't read it. CheckTable() writes version 4, since sys.save() files and sys.serialize()
+     *    buffers may be read by an older engine, e.g. after a rollback. Version 5 is only written for messages.
      */
 
     struct TableHeader
@@ -183,6 +201,7 @@ namespace dmScript
         case 2:
         case 3:
         case 4:
+        case 5:
             supported = true;
             break;
         default:
@@ -215,7 +234,7 @@ namespace dmScript
                 luaL_error(L, "table too large");
             }
         }
-        else if ((3 == header.m_Version) || (4 == header.m_Version))
+        else if (3 <= header.m_Version && header.m_Version <= 5)
         {
             if (buffer_end - buffer < 4)
                 luaL_error(L, "table too large");
@@ -289,32 +308,93 @@ namespace dmScript
         return total_size;
     }
 
-    static void StackPush(dmArray<const void*>& table_stack, const void* p)
+    // Stack of the tables currently being serialized, used to detect cyclic tables.
+    // Typical nesting depths fit in the inline storage, and deeper tables spill to the heap.
+    struct TableStack
     {
-        if (table_stack.Full())
-            table_stack.OffsetCapacity(8);
-        table_stack.Push(p);
+        const void*  m_Inline[TABLE_STACK_INLINE_CAPACITY];
+        const void** m_Data;
+        uint32_t     m_Size;
+        uint32_t     m_Capacity;
+
+        TableStack() : m_Data(m_Inline), m_Size(0), m_Capacity(TABLE_STACK_INLINE_CAPACITY) {}
+        ~TableStack()
+        {
+            if (m_Data != m_Inline)
+                free(m_Data);
+        }
+    };
+
+    static void StackPush(TableStack& table_stack, const void* p)
+    {
+        if (table_stack.m_Size == table_stack.m_Capacity)
+        {
+            uint32_t capacity = table_stack.m_Capacity * 2;
+            const void** data = (const void**) malloc(sizeof(const void*) * capacity);
+            memcpy(data, table_stack.m_Data, sizeof(const void*) * table_stack.m_Size);
+            if (table_stack.m_Data != table_stack.m_Inline)
+                free(table_stack.m_Data);
+            table_stack.m_Data = data;
+            table_stack.m_Capacity = capacity;
+        }
+        table_stack.m_Data[table_stack.m_Size++] = p;
     }
 
-    static const void* StackPop(dmArray<const void*>& table_stack)
+    static const void* StackPop(TableStack& table_stack)
     {
-        const void* p = table_stack.Back();
-        table_stack.Pop();
-        return p;
+        return table_stack.m_Data[--table_stack.m_Size];
     }
 
-    static bool StackContains(dmArray<const void*>& table_stack, const void* p)
+    static bool StackContains(TableStack& table_stack, const void* p)
     {
-        uint32_t size = table_stack.Size();
+        uint32_t size = table_stack.m_Size;
         for (uint32_t i = 0; i < size; ++i)
         {
-            if (table_stack[i] == p)
+            if (table_stack.m_Data[i] == p)
                 return true;
         }
         return false;
     }
 
-    uint32_t DoCheckTableSize(lua_State* L, int index, int parent_offset, dmArray<const void*>& table_stack)
+    // The string keys written so far. Lua strings are interned, so the same key always has the same pointer.
+    struct TableKeyDictionary
+    {
+        const char* m_Keys[TABLE_KEY_DICTIONARY_CAPACITY];
+        uint32_t    m_Lengths[TABLE_KEY_DICTIONARY_CAPACITY];
+        uint32_t    m_Count;
+
+        TableKeyDictionary() : m_Count(0) {}
+    };
+
+    static int FindKey(const TableKeyDictionary& keys, const char* key)
+    {
+        for (uint32_t i = 0; i < keys.m_Count; ++i)
+        {
+            if (keys.m_Keys[i] == key)
+                return (int)i;
+        }
+        return -1;
+    }
+
+    static void AddKey(TableKeyDictionary& keys, const char* key, uint32_t key_len)
+    {
+        if (keys.m_Count < TABLE_KEY_DICTIONARY_CAPACITY)
+        {
+            keys.m_Keys[keys.m_Count] = key;
+            keys.m_Lengths[keys.m_Count] = key_len;
+            keys.m_Count++;
+        }
+    }
+
+    struct CheckTableContext
+    {
+        TableHeader         m_Header;
+        const char*         m_OriginalBuffer;
+        TableStack          m_TableStack;
+        TableKeyDictionary  m_Keys;
+    };
+
+    static uint32_t DoCheckTableSize(lua_State* L, int index, int parent_offset, TableStack& table_stack)
     {
         int top = lua_gettop(L);
         (void)top;
@@ -443,16 +523,20 @@ namespace dmScript
 
     uint32_t CheckTableSize(lua_State* L, int index)
     {
-        dmArray<const void*> table_stack;
+        TableStack table_stack;
         uint32_t size = sizeof(TableHeader) + DoCheckTableSize(L, index, 0, table_stack);
         return size;
     }
 
-    uint32_t DoCheckTable(lua_State* L, const TableHeader& header, const char* original_buffer, char* buffer, uint32_t buffer_size, int index, dmArray<const void*>& table_stack)
+    static uint32_t DoCheckTable(lua_State* L, CheckTableContext& ctx, char* buffer, uint32_t buffer_size, int index)
     {
         int top = lua_gettop(L);
         (void)top;
 
+        const TableHeader& header = ctx.m_Header;
+        const char* original_buffer = ctx.m_OriginalBuffer;
+        TableStack& table_stack = ctx.m_TableStack;
+
         char* buffer_start = buffer;
         char* buffer_end = buffer + buffer_size;
         luaL_checktype(L, index, LUA_TTABLE);
@@ -499,9 +583,25 @@ namespace dmScript
 
             if (key_type == LUA_TSTRING)
             {
-                (*buffer++) = (char) LUA_TSTRING;
-                (*buffer++) = (char) value_type;
-                buffer += SaveTSTRING(L, -2, buffer, buffer_size, buffer_end, count);
+                size_t key_len = 0;
+                const char* key = lua_tolstring(L, -2, &key_len);
+                int key_index = header.m_Version >= 5 ? FindKey(ctx.m_Keys, key) : -1;
+                if (key_index >= 0)
+                {
+                    (*buffer++) = (char) LUA_TSTRINGKEYREF;
+                    (*buffer++) = (char) value_type;
+                    if (!EncodeMSB((uint32_t) key_index, buffer, buffer_end))
+                    {
+                        luaL_error(L, "buffer (%d bytes) too small for table, exceeded at key for element #%d", buffer_size, count);
+                    }
+                }
+                else
+                {
+                    (*buffer++) = (char) LUA_TSTRING;
+                    (*buffer++) = (char) value_type;
+                    buffer += SaveTSTRING(L, -2, buffer, buffer_size, buffer_end, count);
+                    AddKey(ctx.m_Keys, key, (uint32_t) key_len);
+                }
             }
             else if (key_type == LUA_TNUMBER)
             {
@@ -689,7 +789,7 @@ namespace dmScript
 
                 case LUA_TTABLE:
                 {
-                    uint32_t n_used = DoCheckTable(L, header, original_buffer, buffer, buffer_end - buffer, -1, table_stack);
+                    uint32_t n_used = DoCheckTable(L, ctx, buffer, buffer_end - buffer, -1);
                     buffer += n_used;
                 }
                 break;
@@ -712,26 +812,34 @@ namespace dmScript
         return buffer - buffer_start;
     }
 
-    uint32_t CheckTable(lua_State* L, char* buffer, uint32_t buffer_size, int index)
+    uint32_t CheckTableVersion(lua_State* L, char* buffer, uint32_t buffer_size, int index, uint32_t version)
     {
         assert((intptr_t)buffer % 16 == 0);
+        assert(3 <= version && version <= TABLE_VERSION_CURRENT);
         if (buffer_size > sizeof(TableHeader)) {
             char* original_buffer = buffer;
 
             TableHeader* header = (TableHeader*)buffer;
             header->m_Magic = TABLE_MAGIC;
-            header->m_Version = TABLE_VERSION_CURRENT;
+            header->m_Version = version;
             buffer += sizeof(TableHeader);
             buffer_size -= (buffer - original_buffer);
 
-            dmArray<const void*> table_stack;
-            return sizeof(TableHeader) + DoCheckTable(L, *header, original_buffer, buffer, buffer_size, index, table_stack);
+            CheckTableContext ctx;
+            ctx.m_Header = *header;
+            ctx.m_OriginalBuffer = original_buffer;
+            return sizeof(TableHeader) + DoCheckTable(L, ctx, buffer, buffer_size, index);
         } else {
             luaL_error(L, "buffer (%d bytes) too small for header (%zu bytes)", buffer_size, sizeof(TableHeader));
             return 0;
         }
     }
 
+    uint32_t CheckTable(lua_State* L, char* buffer, uint32_t buffer_size, int index)
+    {
+        return CheckTableVersion(L, buffer, buffer_size, index, TABLE_VERSION_PERSISTENT);
+    }
+
     static const char* ReadHeader(const char* buffer, TableHeader& header)
     {
         TableHeader* buffered_header = (TableHeader*)buffer;
@@ -771,7 +879,7 @@ namespace dmScript
                 luaL_error(L, "Invalid number encoding");
             }
         }
-        else if ((3 == header.m_Version) || (4 == header.m_Version))
+        else if (3 <= header.m_Version && header.m_Version <= 5)
         {
             if (key_type != LUA_TNUMBER && key_type != LUA_TNEGATIVENUMBER)
             {
@@ -857,7 +965,7 @@ namespace dmScript
         return luaL_error(L, "%s", str); \
     }
 
-    int DoPushTable(lua_State*L, PushTableLogger& logger, const TableHeader& header, const char* original_buffer, const char* buffer, uint32_t buffer_size, uint32_t depth)
+    static int DoPushTable(lua_State*L, PushTableLogger& logger, const TableHeader& header, TableKeyDictionary& keys, const char* original_buffer, const char* buffer, uint32_t buffer_size, uint32_t depth)
     {
         int top = lua_gettop(L);
         (void)top;
@@ -907,6 +1015,25 @@ namespace dmScript
                     buffer += LoadTSTRING(L, buffer, buffer_end, count, logger);
 
                 CHECK_PUSHTABLE_OOB("key string", logger, buffer, buffer_end, count, depth);
+
+                if (header.m_Version >= 5)
+                {
+                    size_t key_len = 0;
+                    const char* key = lua_tolstring(L, -1, &key_len);
+                    AddKey(keys, key, (uint32_t) key_len);
+                }
+            }
+            else if (key_type == LUA_TSTRINGKEYREF && header.m_Version >= 5)
+            {
+                PushTableLogString(logger, "KR");
+
+                uint32_t key_index = 0;
+                if (!DecodeMSB(key_index, buffer) || key_index >= keys.m_Count)
+                {
+                    return luaL_error(L, "Table contains invalid key reference (%d) at element #%d", key_index, i);
+                }
+                lua_pushlstring(L, keys.m_Keys[key_index], keys.m_Lengths[key_index]);
+                CHECK_PUSHTABLE_OOB("key reference", logger, buffer, buffer_end, count, depth);
             }
             else if (key_type == LUA_TNUMBER || key_type == LUA_TNEGATIVENUMBER)
             {
@@ -1049,7 +1176,7 @@ namespace dmScript
                 break;
                 case LUA_TTABLE:
                 {
-                    int n_consumed = DoPushTable(L, logger, header, original_buffer, buffer, buffer_size, depth+1);
+                    int n_consumed = DoPushTable(L, logger, header, keys, original_buffer, buffer, buffer_size, depth+1);
                     buffer += n_consumed;
                     CHECK_PUSHTABLE_OOB("table", logger, buffer, buffer_end, count, depth);
                 }
@@ -1091,7 +1218,8 @@ namespace dmScript
             PushTableLogger logger;
             logger.m_BufferStart = buffer;
             logger.m_BufferSize = buffer_size;
-            DoPushTable(L, logger, header, original_buffer, buffer, buffer_size, 0);
+            TableKeyDictionary keys;
+            DoPushTable(L, logger, header, keys, original_buffer, buffer, buffer_size, 0);
         }
         else
         {
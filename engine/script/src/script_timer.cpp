@@ -16,15 +16,17 @@
 #include "script_timer_private.h"
 
 #include <string.h>
+#include <dlib/hashtable.h>
+#include <dlib/math.h>
 #include <dlib/object_pool.h>
 #include <dlib/profile.h>
-#include <dlib/set.h>
 
 #include "script.h"
 #include "script_private.h"
 
 DM_PROPERTY_EXTERN(rmtp_Script);
 DM_PROPERTY_U32(rmtp_TimerCount, 0, FrameReset, "# timers", &rmtp_Script);
+DM_PROPERTY_U32(rmtp_TimerTriggerCount, 0, FrameReset, "# timers triggered", &rmtp_Script);
 
 namespace dmScript
 {
@@ -60,44 +62,285 @@ namespace dmScript
         uintptr_t       m_Owner;
         uintptr_t       m_UserData;
 
+        // The world time when the timer fires
+        double          m_Deadline;
+
         // Store complete timer handle with generation here to identify stale timer handles
         HTimer          m_Handle;
 
-        // How much time remaining until the timer fires
-        float           m_Remaining;
-
         // The timer delay, we need to keep this for repeating timers
         float           m_Delay;
 
+        // Links in the wheel slot (or pending) list, as pool indices
+        uint32_t        m_Prev;
+        uint32_t        m_Next;
+
+        // Links in the list of timers with the same owner, as pool indices
+        uint32_t        m_OwnerPrev;
+        uint32_t        m_OwnerNext;
+
+        // The list the timer is linked into, TIMER_LIST_NONE if not scheduled
+        uint16_t        m_List;
+
         // Flag if the timer should repeat
-        uint32_t        m_Repeat : 1;
+        uint16_t        m_Repeat : 1;
         // Flag if the timer is alive
-        uint32_t        m_IsAlive : 1;
+        uint16_t        m_IsAlive : 1;
     };
 
+    /*
+        The timers are scheduled in a hierarchical timing wheel, so that an update only visits
+        the timers that fire. The world time is quantized into ticks of TIMER_TICKS_PER_SECOND,
+        and each level has TIMER_WHEEL_SLOTS slots, each covering TIMER_WHEEL_SLOTS times the range
+        of a slot in the level below. When the current tick wraps around a level, the timers of the
+        next slot in the level above are cascaded down.
+
+        Timers that are due within the current tick are kept in the pending list, and are checked
+        against the exact world time each update.
+    */
+
     #define INITIAL_TIMER_CAPACITY      8u
     #define TIMER_CAPACITY_GROWTH       16u
 
+    static const uint32_t TIMER_TICKS_PER_SECOND = 1000;
+    static const uint32_t TIMER_WHEEL_BITS = 8;
+    static const uint32_t TIMER_WHEEL_SLOTS = 1 << TIMER_WHEEL_BITS;
+    static const uint32_t TIMER_WHEEL_MASK = TIMER_WHEEL_SLOTS - 1;
+    static const uint32_t TIMER_WHEEL_LEVELS = 4;
+    static const uint16_t TIMER_LIST_PENDING = TIMER_WHEEL_LEVELS * TIMER_WHEEL_SLOTS;
+    static const uint16_t TIMER_LIST_COUNT = TIMER_LIST_PENDING + 1;
+    static const uint16_t TIMER_LIST_NONE = 0xffff;
+    static const uint32_t TIMER_INDEX_BITS = 17;
+    static const uint32_t TIMER_INDEX_MASK = (1 << TIMER_INDEX_BITS) - 1;
+    static const uint32_t TIMER_VERSION_MASK = (1 << (32 - TIMER_INDEX_BITS)) - 1;
+    static const uint32_t INVALID_TIMER_INDEX = 0xffffffffu;
+
     struct TimerWorld
     {
-        dmObjectPool<Timer> m_Timers;
-        dmSet<uint16_t>     m_Instances; // the pool indices
-        dmArray<uint16_t>   m_ScratchBuffer; // When doing operations on the timer instances, we need a copy to avoid self modification of m_Instances
-        uint16_t            m_Version;   // Incremented to avoid collisions each time we push timer indexes back to the m_IndexPool
-        uint16_t            m_InUpdate : 1;
-        uint16_t            m_IsDirty : 1;
+        dmObjectPool<Timer>             m_Timers;
+        dmArray<HTimer>                 m_Handles;      // The handle of each pool index, INVALID_TIMER_HANDLE if free
+        dmHashTable<uintptr_t, uint32_t> m_Owners;      // First timer of each owner
+        uint32_t                        m_Lists[TIMER_LIST_COUNT]; // First timer in each wheel slot, and the pending list
+        uint32_t                        m_LevelCounts[TIMER_WHEEL_LEVELS];
+        dmArray<HTimer>                 m_Expired;      // Timers that fire in the current update
+        dmArray<HTimer>                 m_Dead;         // Timers to free at the end of the current update
+        double                          m_Time;         // Accumulated world time
+        uint64_t                        m_NextTick;     // The next tick to process
+        uint16_t                        m_Version;      // Incremented to avoid collisions each time we push timer indexes back to the m_IndexPool
+        uint16_t                        m_InUpdate : 1;
     };
 
     dmArray<TimerWorld*> g_Worlds;
 
-    static uint16_t GetIndexFromHandle(HTimer handle)
+    static uint32_t GetIndexFromHandle(HTimer handle)
+    {
+        return handle & TIMER_INDEX_MASK;
+    }
+
+    static HTimer MakeHandle(uint16_t generation, uint32_t lookup_index)
+    {
+        return (((uint32_t)generation & TIMER_VERSION_MASK) << TIMER_INDEX_BITS) | lookup_index;
+    }
+
+    static inline uint64_t GetTick(double time)
+    {
+        return (uint64_t)(time * TIMER_TICKS_PER_SECOND);
+    }
+
+    static void LinkTimer(HTimerWorld timer_world, Timer* timer, uint16_t list)
+    {
+        uint32_t index = GetIndexFromHandle(timer->m_Handle);
+        uint32_t first = timer_world->m_Lists[list];
+        timer->m_List = list;
+        timer->m_Prev = INVALID_TIMER_INDEX;
+        timer->m_Next = first;
+        if (first != INVALID_TIMER_INDEX)
+        {
+            timer_world->m_Timers.Get(first).m_Prev = index;
+        }
+        timer_world->m_Lists[list] = index;
+        if (list != TIMER_LIST_PENDING)
+        {
+            ++timer_world->m_LevelCounts[list >> TIMER_WHEEL_BITS];
+        }
+    }
+
+    static void UnlinkTimer(HTimerWorld timer_world, Timer* timer)
+    {
+        if (timer->m_List == TIMER_LIST_NONE)
+        {
+            return;
+        }
+        if (timer->m_Prev != INVALID_TIMER_INDEX)
+        {
+            timer_world->m_Timers.Get(timer->m_Prev).m_Next = timer->m_Next;
+        }
+        else
+        {
+            timer_world->m_Lists[timer->m_List] = timer->m_Next;
+        }
+        if (timer->m_Next != INVALID_TIMER_INDEX)
+        {
+            timer_world->m_Timers.Get(timer->m_Next).m_Prev = timer->m_Prev;
+        }
+        if (timer->m_List != TIMER_LIST_PENDING)
+        {
+            --timer_world->m_LevelCounts[timer->m_List >> TIMER_WHEEL_BITS];
+        }
+        timer->m_List = TIMER_LIST_NONE;
+    }
+
+    // Detaches all timers of a list, and returns the first one
+    static uint32_t DetachList(HTimerWorld timer_world, uint16_t list)
+    {
+        uint32_t first = timer_world->m_Lists[list];
+        timer_world->m_Lists[list] = INVALID_TIMER_INDEX;
+        if (list != TIMER_LIST_PENDING)
+        {
+            uint32_t count = 0;
+            for (uint32_t index = first; index != INVALID_TIMER_INDEX; index = timer_world->m_Timers.Get(index).m_Next)
+            {
+                ++count;
+            }
+            timer_world->m_LevelCounts[list >> TIMER_WHEEL_BITS] -= count;
+        }
+        return first;
+    }
+
+    static void ScheduleTimer(HTimerWorld timer_world, Timer* timer)
+    {
+        uint64_t base = timer_world->m_NextTick;
+        uint64_t tick = GetTick(timer->m_Deadline);
+        if (tick < base)
+        {
+            LinkTimer(timer_world, timer, TIMER_LIST_PENDING);
+            return;
+        }
+
+        uint64_t delta = tick - base;
+        uint32_t level = 0;
+        while (level < TIMER_WHEEL_LEVELS - 1 && delta >= ((uint64_t)1 << (TIMER_WHEEL_BITS * (level + 1))))
+        {
+            ++level;
+        }
+        const uint64_t max_delta = ((uint64_t)1 << (TIMER_WHEEL_BITS * TIMER_WHEEL_LEVELS)) - 1;
+        if (delta > max_delta)
+        {
+            // Beyond the range of the wheel, the timer is rescheduled when the top level wraps
+            tick = base + max_delta;
+        }
+        uint32_t slot = (uint32_t)(tick >> (TIMER_WHEEL_BITS * level)) & TIMER_WHEEL_MASK;
+        LinkTimer(timer_world, timer, (uint16_t)(level * TIMER_WHEEL_SLOTS + slot));
+    }
+
+    static void CascadeTimers(HTimerWorld timer_world, uint32_t level, uint32_t slot)
     {
-        return (uint16_t)(handle & 0xffffu);
+        uint32_t index = DetachList(timer_world, (uint16_t)(level * TIMER_WHEEL_SLOTS + slot));
+        while (index != INVALID_TIMER_INDEX)
+        {
+            Timer* timer = &timer_world->m_Timers.Get(index);
+            index = timer->m_Next;
+            timer->m_List = TIMER_LIST_NONE;
+            ScheduleTimer(timer_world, timer);
+        }
+    }
+
+    // Moves the timers of a list that are due to the expired list, and the rest to the pending list
+    static void CollectExpiredTimers(HTimerWorld timer_world, uint16_t list)
+    {
+        uint32_t index = DetachList(timer_world, list);
+        while (index != INVALID_TIMER_INDEX)
+        {
+            Timer* timer = &timer_world->m_Timers.Get(index);
+            index = timer->m_Next;
+            timer->m_List = TIMER_LIST_NONE;
+            if (timer->m_Deadline <= timer_world->m_Time)
+            {
+                if (timer_world->m_Expired.Full())
+                {
+                    timer_world->m_Expired.OffsetCapacity(dmMath::Max(TIMER_CAPACITY_GROWTH, timer_world->m_Expired.Capacity()));
+                }
+                timer_world->m_Expired.Push(timer->m_Handle);
+            }
+            else
+            {
+                LinkTimer(timer_world, timer, TIMER_LIST_PENDING);
+            }
+        }
+    }
+
+    static void AdvanceWheel(HTimerWorld timer_world, uint64_t target_tick)
+    {
+        while (timer_world->m_NextTick <= target_tick)
+        {
+            uint64_t tick = timer_world->m_NextTick;
+            if ((tick & TIMER_WHEEL_MASK) == 0)
+            {
+                for (uint32_t level = 1; level < TIMER_WHEEL_LEVELS; ++level)
+                {
+                    uint32_t slot = (uint32_t)(tick >> (TIMER_WHEEL_BITS * level)) & TIMER_WHEEL_MASK;
+                    CascadeTimers(timer_world, level, slot);
+                    if (slot != 0)
+                        break;
+                }
+            }
+
+            if (timer_world->m_LevelCounts[0] == 0)
+            {
+                // Skip ahead to the next cascade, or to the end if the wheel is empty
+                bool empty = true;
+                for (uint32_t level = 1; level < TIMER_WHEEL_LEVELS; ++level)
+                {
+                    empty &= timer_world->m_LevelCounts[level] == 0;
+                }
+                uint64_t next_cascade = (tick | TIMER_WHEEL_MASK) + 1;
+                timer_world->m_NextTick = empty ? target_tick + 1 : dmMath::Min(next_cascade, target_tick + 1);
+                continue;
+            }
+
+            CollectExpiredTimers(timer_world, (uint16_t)(tick & TIMER_WHEEL_MASK));
+            timer_world->m_NextTick = tick + 1;
+        }
+    }
+
+    static void LinkOwner(HTimerWorld timer_world, Timer* timer)
+    {
+        uint32_t index = GetIndexFromHandle(timer->m_Handle);
+        uint32_t* first = timer_world->m_Owners.Get(timer->m_Owner);
+        timer->m_OwnerPrev = INVALID_TIMER_INDEX;
+        timer->m_OwnerNext = first ? *first : INVALID_TIMER_INDEX;
+        if (first)
+        {
+            timer_world->m_Timers.Get(*first).m_OwnerPrev = index;
+            *first = index;
+            return;
+        }
+        if (timer_world->m_Owners.Full())
+        {
+            uint32_t capacity = timer_world->m_Owners.Capacity() + TIMER_CAPACITY_GROWTH + timer_world->m_Owners.Capacity() / 2;
+            timer_world->m_Owners.SetCapacity(capacity / 2 + 1, capacity);
+        }
+        timer_world->m_Owners.Put(timer->m_Owner, index);
     }
 
-    static HTimer MakeHandle(uint16_t generation, uint16_t lookup_index)
+    static void UnlinkOwner(HTimerWorld timer_world, Timer* timer)
     {
-        return (((uint32_t)generation) << 16) | (lookup_index);
+        if (timer->m_OwnerPrev != INVALID_TIMER_INDEX)
+        {
+            timer_world->m_Timers.Get(timer->m_OwnerPrev).m_OwnerNext = timer->m_OwnerNext;
+        }
+        else if (timer->m_OwnerNext != INVALID_TIMER_INDEX)
+        {
+            *timer_world->m_Owners.Get(timer->m_Owner) = timer->m_OwnerNext;
+        }
+        else
+        {
+            timer_world->m_Owners.Erase(timer->m_Owner);
+        }
+        if (timer->m_OwnerNext != INVALID_TIMER_INDEX)
+        {
+            timer_world->m_Timers.Get(timer->m_OwnerNext).m_OwnerPrev = timer->m_OwnerPrev;
+        }
     }
 
     static Timer* AllocateTimer(HTimerWorld timer_world, uintptr_t owner)
@@ -112,34 +355,31 @@ namespace dmScript
 
         if (timer_world->m_Timers.Full())
         {
-            uint32_t cap = timer_world->m_Timers.Capacity() + TIMER_CAPACITY_GROWTH;
+            uint32_t capacity = timer_world->m_Timers.Capacity();
+            uint32_t cap = capacity + dmMath::Max(TIMER_CAPACITY_GROWTH, capacity / 2);
             if (cap > MAX_TIMER_CAPACITY)
                 cap = MAX_TIMER_CAPACITY;
             timer_world->m_Timers.SetCapacity(cap);
-            timer_world->m_Instances.SetCapacity(cap);
+            timer_world->m_Handles.SetCapacity(cap);
+            timer_world->m_Handles.SetSize(cap);
+            for (uint32_t i = capacity; i < cap; ++i)
+            {
+                timer_world->m_Handles[i] = INVALID_TIMER_HANDLE;
+            }
         }
 
-        uint16_t timer_index = (uint16_t)timer_world->m_Timers.Alloc();
+        uint32_t timer_index = timer_world->m_Timers.Alloc();
         Timer* timer = &timer_world->m_Timers.Get(timer_index);
-        timer_world->m_Instances.Add(timer_index);
 
         memset(timer, 0, sizeof(Timer));
         timer->m_Handle = MakeHandle(timer_world->m_Version, timer_index);
         timer->m_Owner = owner;
-
-        timer_world->m_IsDirty = 1;
+        timer->m_List = TIMER_LIST_NONE;
+        timer_world->m_Handles[timer_index] = timer->m_Handle;
+        LinkOwner(timer_world, timer);
         return timer;
     }
 
-    static void DeallocateTimer(HTimerWorld timer_world, uint16_t timer_index)
-    {
-        assert(timer_world != 0x0);
-
-        timer_world->m_Instances.Remove(timer_index);
-        timer_world->m_Timers.Free(timer_index, true);
-        timer_world->m_IsDirty = 1;
-    }
-
     static void FreeTimer(HTimerWorld timer_world, Timer* timer)
     {
         assert(timer_world != 0x0);
@@ -152,19 +392,52 @@ namespace dmScript
             DestroyCallback(callback);
         }
 
-        uint16_t index = GetIndexFromHandle(timer->m_Handle);
-        DeallocateTimer(timer_world, index);
+        UnlinkTimer(timer_world, timer);
+        UnlinkOwner(timer_world, timer);
+
+        uint32_t index = GetIndexFromHandle(timer->m_Handle);
+        timer_world->m_Handles[index] = INVALID_TIMER_HANDLE;
+        timer_world->m_Timers.Free(index, true);
+        ++timer_world->m_Version;
+    }
+
+    // Frees the timer now, or at the end of the update if we're inside one
+    static void RetireTimer(HTimerWorld timer_world, Timer* timer)
+    {
+        UnlinkTimer(timer_world, timer);
+        if (timer_world->m_InUpdate == 0)
+        {
+            FreeTimer(timer_world, timer);
+            return;
+        }
+        if (timer_world->m_Dead.Full())
+        {
+            timer_world->m_Dead.OffsetCapacity(dmMath::Max(TIMER_CAPACITY_GROWTH, timer_world->m_Dead.Capacity()));
+        }
+        timer_world->m_Dead.Push(timer->m_Handle);
     }
 
     HTimerWorld NewTimerWorld()
     {
         TimerWorld* timer_world = new TimerWorld();
         timer_world->m_Timers.SetCapacity(INITIAL_TIMER_CAPACITY);
-        timer_world->m_Instances.SetCapacity(INITIAL_TIMER_CAPACITY);
+        timer_world->m_Handles.SetCapacity(INITIAL_TIMER_CAPACITY);
+        timer_world->m_Handles.SetSize(INITIAL_TIMER_CAPACITY);
+        for (uint32_t i = 0; i < INITIAL_TIMER_CAPACITY; ++i)
+        {
+            timer_world->m_Handles[i] = INVALID_TIMER_HANDLE;
+        }
+        timer_world->m_Owners.SetCapacity(INITIAL_TIMER_CAPACITY / 2 + 1, INITIAL_TIMER_CAPACITY);
+        for (uint32_t i = 0; i < TIMER_LIST_COUNT; ++i)
+        {
+            timer_world->m_Lists[i] = INVALID_TIMER_INDEX;
+        }
+        memset(timer_world->m_LevelCounts, 0, sizeof(timer_world->m_LevelCounts));
 
+        timer_world->m_Time = 0.0;
+        timer_world->m_NextTick = 0;
         timer_world->m_Version = 0;
         timer_world->m_InUpdate = 0;
-        timer_world->m_IsDirty = 0;
         return timer_world;
     }
 
@@ -174,40 +447,20 @@ namespace dmScript
         delete timer_world;
     }
 
-    static Timer* GetTimerFromIndex(HTimerWorld timer_world, uint16_t index)
-    {
-        assert(timer_world != 0x0);
-        if (!timer_world->m_Instances.Contains(index))
-        {
-            return 0;
-        }
-        return &timer_world->m_Timers.Get(index);
-    }
-
     static Timer* GetTimerFromHandle(HTimerWorld timer_world, HTimer handle)
     {
-        uint16_t index = GetIndexFromHandle(handle);
-        Timer* timer = GetTimerFromIndex(timer_world, index);
-        if (!timer)
+        assert(timer_world != 0x0);
+        uint32_t index = GetIndexFromHandle(handle);
+        if (index >= timer_world->m_Handles.Size())
             return 0;
-        if (timer->m_Handle != handle)
+        if (timer_world->m_Handles[index] != handle)
             return 0; // Stale handle
-        return timer;
+        return &timer_world->m_Timers.Get(index);
     }
 
-    static uint32_t CopyIndices(dmSet<uint16_t>& src, dmArray<uint16_t>& tgt)
+    static float GetTimeRemaining(HTimerWorld timer_world, Timer* timer)
     {
-        uint32_t size = src.Size();
-        if (size > tgt.Capacity())
-        {
-            tgt.SetCapacity(size);
-        }
-        tgt.SetSize(size);
-        for (uint32_t i = 0; i < size; ++i)
-        {
-            tgt[i] = src[i];
-        }
-        return size;
+        return (float)(timer->m_Deadline - timer_world->m_Time);
     }
 
     void UpdateTimers(HTimerWorld timer_world, float dt)
@@ -216,44 +469,35 @@ namespace dmScript
         DM_PROFILE("Update");
 
         timer_world->m_InUpdate = 1;
+        timer_world->m_Time += dt;
 
-        // We make a copy of the indices, as it's possible the m_Instances may be altered
+        DM_PROPERTY_ADD_U32(rmtp_TimerCount, timer_world->m_Timers.Size());
+
+        // Gather the timers that fire before calling any callbacks
         // Any timers added during this update call, will be updated the next frame
-        uint32_t size = CopyIndices(timer_world->m_Instances, timer_world->m_ScratchBuffer);
+        timer_world->m_Expired.SetSize(0);
+        AdvanceWheel(timer_world, GetTick(timer_world->m_Time));
+        CollectExpiredTimers(timer_world, TIMER_LIST_PENDING);
 
-        DM_PROPERTY_ADD_U32(rmtp_TimerCount, size);
+        DM_PROPERTY_ADD_U32(rmtp_TimerTriggerCount, timer_world->m_Expired.Size());
 
-        for (uint32_t i = 0; i < size; ++i)
+        for (uint32_t i = 0; i < timer_world->m_Expired.Size(); ++i)
         {
-            uint16_t index = timer_world->m_ScratchBuffer[i];
-            Timer* timer = GetTimerFromIndex(timer_world, index);
-            if (!timer)
-            {
-                continue;
-            }
-
-            if (timer->m_IsAlive == 0)
-            {
-                continue;
-            }
-
-            timer->m_Remaining -= dt;
-            if (timer->m_Remaining > 0.0f)
+            HTimer handle = timer_world->m_Expired[i];
+            Timer* timer = GetTimerFromHandle(timer_world, handle);
+            if (!timer || timer->m_IsAlive == 0)
             {
                 continue;
             }
 
-            float elapsed_time = timer->m_Delay - timer->m_Remaining;
+            float elapsed_time = (float)(timer_world->m_Time - (timer->m_Deadline - timer->m_Delay));
 
             TimerEventType eventType = timer->m_Repeat == 0 ? TIMER_EVENT_TRIGGER_WILL_DIE : TIMER_EVENT_TRIGGER_WILL_REPEAT;
             timer->m_Callback(timer_world, eventType, timer->m_Handle, elapsed_time, timer->m_Owner, timer->m_UserData);
 
-            if (timer_world->m_IsDirty)
-            {
-                // If the containers were reallocated, the current timer pointer needs to get fetched again
-                timer = GetTimerFromIndex(timer_world, index);
-                assert(timer);
-            }
+            // The callback may have added timers and reallocated the pool
+            timer = GetTimerFromHandle(timer_world, handle);
+            assert(timer);
 
             if (timer->m_IsAlive == 0)
             {
@@ -263,41 +507,39 @@ namespace dmScript
             if (timer->m_Repeat == 0)
             {
                 timer->m_IsAlive = 0;
+                RetireTimer(timer_world, timer);
                 continue;
             }
 
-            if (timer->m_Delay == 0.0f)
+            if (timer->m_Delay != 0.0f)
             {
-                timer->m_Remaining = 0.0f;
-                continue;
+                // Skip the periods that were missed, we only trigger once per update
+                double remaining = timer->m_Deadline - timer_world->m_Time;
+                double wrapped_count = ((-remaining) / timer->m_Delay) + 1.0;
+                timer->m_Deadline += floor(wrapped_count) * timer->m_Delay;
+                if (timer->m_Deadline < timer_world->m_Time) // If the delay is very small, the floating point precision might produce issues
+                    timer->m_Deadline = timer_world->m_Time + timer->m_Delay; // reset the timer
             }
-
-            float wrapped_count = ((-timer->m_Remaining) / timer->m_Delay) + 1.f;
-            float offset_to_next_trigger  = floor(wrapped_count) * timer->m_Delay;
-            timer->m_Remaining += offset_to_next_trigger;
-            if (timer->m_Remaining < 0) // If the delay is very small, the floating point precision might produce issues
-                timer->m_Remaining = timer->m_Delay; // reset the timer
+            else
+            {
+                timer->m_Deadline = timer_world->m_Time;
+            }
+            ScheduleTimer(timer_world, timer);
         }
 
         timer_world->m_InUpdate = 0;
 
-        // We need to do the deletes in a separate pass, as the
-        // callbacks may remove/add indices from the pool, thus messing up the current set of indices
-        for (uint32_t i = 0; i < size; ++i)
+        // We need to do the deletes in a separate pass, as the callbacks
+        // may still refer to the timers that died during the update
+        for (uint32_t i = 0; i < timer_world->m_Dead.Size(); ++i)
         {
-            uint16_t index = timer_world->m_ScratchBuffer[i];
-            Timer* timer = GetTimerFromIndex(timer_world, index);
+            Timer* timer = GetTimerFromHandle(timer_world, timer_world->m_Dead[i]);
             if (timer && timer->m_IsAlive == 0)
             {
                 FreeTimer(timer_world, timer);
             }
         }
-
-        if (timer_world->m_IsDirty)
-        {
-            ++timer_world->m_Version;
-        }
-        timer_world->m_IsDirty = 0;
+        timer_world->m_Dead.SetSize(0);
     }
 
     HTimer AddTimer(HTimerWorld timer_world,
@@ -318,11 +560,12 @@ namespace dmScript
         }
 
         timer->m_Delay = delay;
-        timer->m_Remaining = delay;
+        timer->m_Deadline = timer_world->m_Time + delay;
         timer->m_UserData = userdata;
         timer->m_Callback = timer_callback;
         timer->m_Repeat = repeat;
         timer->m_IsAlive = 1;
+        ScheduleTimer(timer_world, timer);
 
         return timer->m_Handle;
     }
@@ -340,14 +583,12 @@ namespace dmScript
         }
 
         timer->m_IsAlive = 0;
+        UnlinkTimer(timer_world, timer);
         timer->m_Callback(timer_world, TIMER_EVENT_CANCELLED, timer->m_Handle, 0.f, timer->m_Owner, timer->m_UserData);
 
-        if (timer_world->m_InUpdate == 0)
-        {
-            FreeTimer(timer_world, timer);
-            ++timer_world->m_Version;
-        }
-
+        // The callback may have added timers and reallocated the pool
+        timer = GetTimerFromHandle(timer_world, handle);
+        RetireTimer(timer_world, timer);
         return true;
     }
 
@@ -355,32 +596,20 @@ namespace dmScript
     {
         assert(timer_world != 0x0);
 
-        uint32_t size = CopyIndices(timer_world->m_Instances, timer_world->m_ScratchBuffer);
+        uint32_t* first = timer_world->m_Owners.Get(owner);
+        uint32_t index = first ? *first : INVALID_TIMER_INDEX;
         uint32_t cancelled_count = 0;
-        for (uint32_t i = 0; i < size; ++i)
+        while (index != INVALID_TIMER_INDEX)
         {
-            uint16_t index = timer_world->m_ScratchBuffer[i];
-            Timer* timer = GetTimerFromIndex(timer_world, index);
-
-            if (!timer)
-            {
-                continue;
-            }
-
-            if (timer->m_Owner != owner)
-            {
-                continue;
-            }
+            Timer* timer = &timer_world->m_Timers.Get(index);
+            index = timer->m_OwnerNext;
 
+            // Timers that are already dead are freed at the end of the current update
             if (timer->m_IsAlive == 1)
             {
                 timer->m_IsAlive = 0;
                 ++cancelled_count;
-            }
-
-            if (timer_world->m_InUpdate == 0)
-            {
-                FreeTimer(timer_world, timer);
+                RetireTimer(timer_world, timer);
             }
         }
 
@@ -393,13 +622,10 @@ namespace dmScript
         assert(timer_world != 0x0);
 
         uint32_t alive_timers = 0u;
-        uint32_t size = timer_world->m_Instances.Size();
-        for (uint32_t i = 0; i < size; ++i)
+        dmArray<Timer>& timers = timer_world->m_Timers.GetRawObjects();
+        for (uint32_t i = 0; i < timers.Size(); ++i)
         {
-            uint16_t index = timer_world->m_Instances[i]; // the pool indices
-            Timer* timer = GetTimerFromIndex(timer_world, index);
-
-            alive_timers += timer->m_IsAlive != 0 ? 1 : 0;
+            alive_timers += timers[i].m_IsAlive != 0 ? 1 : 0;
         }
         return alive_timers;
     }
@@ -704,7 +930,7 @@ namespace dmScript
             return 1;
         }
 
-        LuaTimerCallbackArgs args = { timer->m_Handle, timer->m_Delay - timer->m_Remaining };
+        LuaTimerCallbackArgs args = { timer->m_Handle, timer->m_Delay - GetTimeRemaining(timer_world, timer) };
         InvokeCallback(callback, LuaTimerCallbackArgsCB, &args);
 
         lua_pushboolean(L, 1);
@@ -757,7 +983,7 @@ namespace dmScript
         }
 
         lua_newtable(L);
-        lua_pushnumber(L,timer->m_Remaining);
+        lua_pushnumber(L, GetTimeRemaining(timer_world, timer));
         lua_setfield(L, -2, "time_remaining");
         lua_pushnumber(L,timer->m_Delay);
         lua_setfield(L, -2, "delay");
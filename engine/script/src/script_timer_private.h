@@ -37,7 +37,7 @@ namespace dmScript
 
     const HTimer INVALID_TIMER_HANDLE = 0xffffffffu;
 
-    const uint32_t MAX_TIMER_CAPACITY = 8000;  // Needs to be less that 65535 since 65535 is reserved for invalid index
+    const uint32_t MAX_TIMER_CAPACITY = 128000;  // Needs to be less that 131071 (17 bits) since 131071 is reserved for invalid index
 
     /**
      * Update the all the timers in the world. Any timers whose time is elapsed will be triggered
@@ -2646,6 +2646,162 @@ namespace dmScript
         return 1;
     }
 
+    static int AddSubTo(lua_State* L, const char* name, bool subtract)
+    {
+        void* out = 0;
+        void* argument1 = 0;
+        void* argument2 = 0;
+        const ScriptUserType type = CheckUserData(L, 1, &out);
+        if (type != SCRIPT_TYPE_VECTOR3 && type != SCRIPT_TYPE_VECTOR4)
+        {
+            return luaL_error(L, "%s.%s accepts (%s|%s) as arguments.", SCRIPT_LIB_NAME, name, SCRIPT_TYPE_NAME_VECTOR3, SCRIPT_TYPE_NAME_VECTOR4);
+        }
+        if (CheckUserData(L, 2, &argument1) != type || CheckUserData(L, 3, &argument2) != type)
+        {
+            return luaL_error(L, "%s.%s Arguments needs to be of same type!", SCRIPT_LIB_NAME, name);
+        }
+        if (type == SCRIPT_TYPE_VECTOR3)
+        {
+            Vector3* v1 = (Vector3*)argument1;
+            Vector3* v2 = (Vector3*)argument2;
+            *(Vector3*)out = subtract ? *v1 - *v2 : *v1 + *v2;
+        }
+        else
+        {
+            Vector4* v1 = (Vector4*)argument1;
+            Vector4* v2 = (Vector4*)argument2;
+            *(Vector4*)out = subtract ? *v1 - *v2 : *v1 + *v2;
+        }
+        lua_pushvalue(L, 1);
+        return 1;
+    }
+
+    /*# adds two vectors and stores the result in an existing vector
+     *
+     * Adds two vectors of the same type and writes the result to `out`, without creating a new vector.
+     * This is useful in performance critical code to avoid creating temporary objects that
+     * need to be garbage collected. `out` may be the same vector as one of the arguments.
+     *
+     * <code>vmath.add_to(out, v1, v2)</code> is equivalent to <code>out = v1 + v2</code>
+     *
+     * @name vmath.add_to
+     * @param out [type:vector3|vector4] vector to store the result in
+     * @param v1 [type:vector3|vector4] first vector
+     * @param v2 [type:vector3|vector4] second vector
+     * @return out [type:vector3|vector4] the `out` vector
+     * @examples
+     *
+     * ```lua
+     * function update(self, dt)
+     *     vmath.add_to(self.position, self.position, self.velocity)
+     * end
+     * ```
+     */
+    static int AddTo(lua_State* L)
+    {
+        return AddSubTo(L, "add_to", false);
+    }
+
+    /*# subtracts two vectors and stores the result in an existing vector
+     *
+     * Subtracts the second vector from the first and writes the result to `out`, without creating a new vector.
+     * `out` may be the same vector as one of the arguments.
+     *
+     * <code>vmath.sub_to(out, v1, v2)</code> is equivalent to <code>out = v1 - v2</code>
+     *
+     * @name vmath.sub_to
+     * @param out [type:vector3|vector4] vector to store the result in
+     * @param v1 [type:vector3|vector4] first vector
+     * @param v2 [type:vector3|vector4] second vector
+     * @return out [type:vector3|vector4] the `out` vector
+     * @examples
+     *
+     * ```lua
+     * vmath.sub_to(self.direction, target, self.position)
+     * ```
+     */
+    static int SubTo(lua_State* L)
+    {
+        return AddSubTo(L, "sub_to", true);
+    }
+
+    /*# multiplies two values and stores the result in an existing value
+     *
+     * Multiplies two values and writes the result to `out`, without creating a new object.
+     * `out` may be the same object as one of the arguments. The following combinations are supported:
+     *
+     * - `vector3` = `vector3` * `number`
+     * - `vector4` = `vector4` * `number`
+     * - `vector4` = `matrix4` * `vector4`
+     * - `quat` = `quat` * `quat`
+     * - `matrix4` = `matrix4` * `matrix4`
+     * - `matrix4` = `matrix4` * `number`
+     *
+     * @name vmath.mul_to
+     * @param out [type:vector3|vector4|quat|matrix4] object to store the result in
+     * @param v1 [type:vector3|vector4|quat|matrix4] first value
+     * @param v2 [type:number|vector4|quat|matrix4] second value
+     * @return out [type:vector3|vector4|quat|matrix4] the `out` object
+     * @examples
+     *
+     * ```lua
+     * vmath.mul_to(self.velocity, self.velocity, 0.98)
+     * vmath.mul_to(self.rotation, self.rotation, spin)
+     * ```
+     */
+    static int MulTo(lua_State* L)
+    {
+        void* out = 0;
+        const ScriptUserType type = CheckUserData(L, 1, &out);
+        if (type == SCRIPT_TYPE_VECTOR3)
+        {
+            Vector3* v = CheckVector3(L, 2);
+            float s = (float) luaL_checknumber(L, 3);
+            *(Vector3*)out = *v * s;
+        }
+        else if (type == SCRIPT_TYPE_VECTOR4)
+        {
+            Matrix4* m = ToMatrix4(L, 2);
+            if (m != 0)
+            {
+                Vector4 v = *m * *CheckVector4(L, 3);
+                *(Vector4*)out = v;
+            }
+            else
+            {
+                Vector4* v = CheckVector4(L, 2);
+                float s = (float) luaL_checknumber(L, 3);
+                *(Vector4*)out = *v * s;
+            }
+        }
+        else if (type == SCRIPT_TYPE_QUAT)
+        {
+            Quat* q1 = CheckQuat(L, 2);
+            Quat* q2 = CheckQuat(L, 3);
+            *(Quat*)out = *q1 * *q2;
+        }
+        else if (type == SCRIPT_TYPE_MATRIX4)
+        {
+            Matrix4* m1 = CheckMatrix4(L, 2);
+            if (lua_isnumber(L, 3))
+            {
+                *(Matrix4*)out = *m1 * (float) lua_tonumber(L, 3);
+            }
+            else
+            {
+                Matrix4 m = *m1 * *CheckMatrix4(L, 3);
+                *(Matrix4*)out = m;
+            }
+        }
+        else
+        {
+            return luaL_error(L, "%s.%s accepts (%s|%s|%s|%s) as first argument.", SCRIPT_LIB_NAME, "mul_to",
+                            SCRIPT_TYPE_NAME_VECTOR3, SCRIPT_TYPE_NAME_VECTOR4, SCRIPT_TYPE_NAME_QUAT, SCRIPT_TYPE_NAME_MATRIX4);
+        }
+        lua_pushvalue(L, 1);
+        return 1;
+    }
+
     static const luaL_reg methods[] =
     {
         {SCRIPT_TYPE_NAME_VECTOR, Vector_new},
@@ -2687,6 +2843,9 @@ namespace dmScript
         {"matrix4_compose", Matrix4_Compose},
         {"matrix4_scale", Matrix4_Scale},
         {"clamp", Vector_Clamp},
+        {"add_to", AddTo},
+        {"sub_to", SubTo},
+        {"mul_to", MulTo},
         {0, 0}
     };
 
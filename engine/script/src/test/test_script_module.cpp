@@ -19,8 +19,18 @@
 #include <script/lua_source_ddf.h>
 
 #include <testmain/testmain.h>
+#include <dlib/dstrings.h>
 #include <dlib/hash.h>
 #include <dlib/log.h>
+#include <dlib/sys.h>
+#include <dlib/time.h>
+
+#include <stdio.h>
+#if defined(_WIN32)
+#include <sys/utime.h>
+#else
+#include <utime.h>
+#endif
 
 class ScriptModuleTest : public dmScriptTest::ScriptTest
 {
@@ -135,6 +145,101 @@ TEST_F(ScriptModuleTest, TestReloadNotLoaded)
     ASSERT_EQ(top, lua_gettop(L));
 }
 
+static void CountFilesCallback(void* ctx, const char* path, bool isdir)
+{
+    if (!isdir)
+        *(uint32_t*)ctx += 1;
+}
+
+TEST_F(ScriptModuleTest, TestBytecodeCache)
+{
+    const char* cache_path = "build/src/test/bytecode_cache";
+    dmSys::RmTree(cache_path);
+    ASSERT_EQ(dmSys::RESULT_OK, dmSys::Mkdir(cache_path, 0755));
+    m_Context->m_BytecodeCachePath = strdup(cache_path);
+
+    int top = lua_gettop(L);
+    const char* script = "module(..., package.seeall)\n function f1()\n return 123\n end\n";
+    const char* script_file_name = "cached_mod";
+    dmScript::Result ret = dmScript::AddModule(m_Context, LuaSourceFromText(script), script_file_name, 0, dmHashString64(script_file_name));
+    ASSERT_EQ(dmScript::RESULT_OK, ret);
+
+    // First require compiles the source and stores the chunk in the cache
+    ASSERT_TRUE(RunString(L, "require('cached_mod'); assert(cached_mod.f1() == 123)"));
+    uint32_t file_count = 0;
+    dmSys::IterateTree(cache_path, false, false, &file_count, CountFilesCallback);
+    ASSERT_EQ(1u, file_count);
+    ASSERT_EQ(0u, m_Context->m_BytecodeCacheHits);
+    ASSERT_EQ(1u, m_Context->m_BytecodeCacheMisses);
+
+    // Second require loads the chunk from the cache
+    ASSERT_TRUE(RunString(L, "package.loaded['cached_mod'] = nil; cached_mod = nil; require('cached_mod'); assert(cached_mod.f1() == 123)"));
+    file_count = 0;
+    dmSys::IterateTree(cache_path, false, false, &file_count, CountFilesCallback);
+    ASSERT_EQ(1u, file_count);
+    ASSERT_EQ(1u, m_Context->m_BytecodeCacheHits);
+    ASSERT_EQ(1u, m_Context->m_BytecodeCacheMisses);
+    ASSERT_EQ(top, lua_gettop(L));
+
+    free(m_Context->m_BytecodeCachePath);
+    m_Context->m_BytecodeCachePath = 0;
+    dmSys::RmTree(cache_path);
+}
+
+static void WriteCacheFile(const char* cache_path, const char* name, uint32_t size, uint64_t modified_time)
+{
+    char path[512];
+    dmSnPrintf(path, sizeof(path), "%s/%s", cache_path, name);
+    FILE* file = fopen(path, "wb");
+    ASSERT_NE((FILE*)0, file);
+    for (uint32_t i = 0; i < size; ++i)
+        fputc(0, file);
+    fclose(file);
+    struct utimbuf times;
+    times.actime = (time_t)modified_time;
+    times.modtime = (time_t)modified_time;
+    ASSERT_EQ(0, utime(path, &times));
+}
+
+static bool CacheFileExists(const char* cache_path, const char* name)
+{
+    char path[512];
+    dmSnPrintf(path, sizeof(path), "%s/%s", cache_path, name);
+    return dmSys::Exists(path);
+}
+
+TEST_F(ScriptModuleTest, TestBytecodeCacheTrim)
+{
+    const char* cache_path = "build/src/test/bytecode_cache_trim";
+    dmSys::RmTree(cache_path);
+    ASSERT_EQ(dmSys::RESULT_OK, dmSys::Mkdir(cache_path, 0755));
+
+    uint64_t now = dmTime::GetTime() / 1000000;
+    WriteCacheFile(cache_path, "0000000000000001.luac", 1024, now - 400);
+    WriteCacheFile(cache_path, "0000000000000002.luac", 1024, now - 300);
+    WriteCacheFile(cache_path, "0000000000000003.luac", 1024, now - 200);
+    WriteCacheFile(cache_path, "0000000000000004.luac", 1024, now - 100);
+    WriteCacheFile(cache_path, "0000000000000005.luac.1.1.tmp", 1024, now - 2 * 60 * 60);
+    WriteCacheFile(cache_path, "0000000000000006.luac.1.2.tmp", 1024, now);
+
+    // Below the limit, only the old temporary file is removed
+    dmScript::TrimBytecodeCache(cache_path, 4 * 1024);
+    uint32_t file_count = 0;
+    dmSys::IterateTree(cache_path, false, false, &file_count, CountFilesCallback);
+    ASSERT_EQ(5u, file_count);
+    ASSERT_FALSE(CacheFileExists(cache_path, "0000000000000005.luac.1.1.tmp"));
+
+    // The least recently used entries are removed until the cache is below 3/4 of the limit
+    dmScript::TrimBytecodeCache(cache_path, 3 * 1024);
+    ASSERT_FALSE(CacheFileExists(cache_path, "0000000000000001.luac"));
+    ASSERT_FALSE(CacheFileExists(cache_path, "0000000000000002.luac"));
+    ASSERT_TRUE(CacheFileExists(cache_path, "0000000000000003.luac"));
+    ASSERT_TRUE(CacheFileExists(cache_path, "0000000000000004.luac"));
+    ASSERT_TRUE(CacheFileExists(cache_path, "0000000000000006.luac.1.2.tmp"));
+
+    dmSys::RmTree(cache_path);
+}
+
 extern "C" void dmExportedSymbols();
 
 int main(int argc, char **argv)
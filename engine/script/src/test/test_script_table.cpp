@@ -20,8 +20,10 @@
 #include <dlib/log.h>
 #include <dlib/math.h>
 #include <dlib/memory.h>
+#include <dlib/time.h>
 
 #include "../script.h"
+#include "../script_private.h"
 #include "test_script.h"
 #include "test_script_private.h"
 #include "test/test_ddf.h"
@@ -115,7 +117,7 @@ TEST_F(LuaTableTest, AttemptReadUnsupportedVersion)
     int result = lua_cpcall(L, ReadUnsupportedVersion, 0x0);
     ASSERT_NE(0, result);
     char str[256];
-    dmSnPrintf(str, sizeof(str), "Unsupported serialized table data: version = 0x%x (current = 0x%x)", 818192, 4);
+    dmSnPrintf(str, sizeof(str), "Unsupported serialized table data: version = 0x%x (current = 0x%x)", 818192, 5);
     ASSERT_STREQ(str, lua_tostring(L, -1));
     // pop error message
     lua_pop(L, 1);
@@ -1042,6 +1044,158 @@ TEST_F(LuaTableTest, Stress)
     }
 }
 
+// Creates an array of tables with the same keys, e.g. a list of positions in a message
+static void PushArrayOfRecords(lua_State* L, int count, int field_count)
+{
+    static const char* field_names[] = {"id", "x", "y", "z", "health", "speed", "name", "flags"};
+    lua_newtable(L);
+    for (int i = 0; i < count; ++i)
+    {
+        lua_newtable(L);
+        for (int f = 0; f < field_count; ++f)
+        {
+            lua_pushnumber(L, i * 10 + f);
+            lua_setfield(L, -2, field_names[f % 8]);
+        }
+        lua_rawseti(L, -2, i + 1);
+    }
+}
+
+TEST_F(LuaTableTest, RepeatedStringKeys)
+{
+    int top = lua_gettop(L);
+    const uint32_t buffer_size = 8 * 1024;
+    char* buf_v4;
+    char* buf_v5;
+    dmMemory::AlignedMalloc((void**)&buf_v4, 16, buffer_size);
+    dmMemory::AlignedMalloc((void**)&buf_v5, 16, buffer_size);
+
+    PushArrayOfRecords(L, 50, 6);
+    uint32_t size_estimate = dmScript::CheckTableSize(L, -1);
+    uint32_t size_v4 = dmScript::CheckTableVersion(L, buf_v4, buffer_size, -1, 4);
+    uint32_t size_v5 = dmScript::CheckTableVersion(L, buf_v5, buffer_size, -1, 5);
+    lua_pop(L, 1);
+
+    // The repeated keys are written as references in version 5
+    ASSERT_EQ(size_estimate, size_v4);
+    ASSERT_LT(size_v5, size_v4);
+
+    const char* bufs[] = {buf_v4, buf_v5};
+    for (int b = 0; b < 2; ++b)
+    {
+        dmScript::PushTable(L, bufs[b], buffer_size);
+        ASSERT_EQ(50, (int)lua_objlen(L, -1));
+        for (int i = 0; i < 50; ++i)
+        {
+            lua_rawgeti(L, -1, i + 1);
+            lua_getfield(L, -1, "id");
+            ASSERT_EQ(i * 10 + 0, lua_tonumber(L, -1));
+            lua_pop(L, 1);
+            lua_getfield(L, -1, "speed");
+            ASSERT_EQ(i * 10 + 5, lua_tonumber(L, -1));
+            lua_pop(L, 1);
+            lua_pop(L, 1);
+        }
+        lua_pop(L, 1);
+    }
+
+    dmMemory::AlignedFree(buf_v4);
+    dmMemory::AlignedFree(buf_v5);
+    ASSERT_EQ(top, lua_gettop(L));
+}
+
+// Data from sys.save() and sys.serialize() must stay readable by engines without version 5 support
+TEST_F(LuaTableTest, CheckTableWritesVersion4)
+{
+    int top = lua_gettop(L);
+    PushArrayOfRecords(L, 4, 2);
+    uint32_t size_v4 = dmScript::CheckTableSize(L, -1);
+    uint32_t buffer_used = dmScript::CheckTable(L, g_Buf, sizeof(g_Buf), -1);
+    lua_pop(L, 1);
+
+    uint32_t header[2];
+    memcpy(header, g_Buf, sizeof(header));
+    ASSERT_EQ(0x42544448u, header[0]);
+    ASSERT_EQ(4u, header[1]);
+    // No key references
+    ASSERT_EQ(size_v4, buffer_used);
+
+    dmScript::PushTable(L, g_Buf, buffer_used);
+    ASSERT_EQ(4, (int)lua_objlen(L, -1));
+    lua_pop(L, 1);
+    ASSERT_EQ(top, lua_gettop(L));
+}
+
+TEST_F(LuaTableTest, CorruptedKeyReference)
+{
+    int top = lua_gettop(L);
+    PushArrayOfRecords(L, 2, 1);
+    uint32_t buffer_used = dmScript::CheckTableVersion(L, g_Buf, sizeof(g_Buf), -1, 5);
+    lua_pop(L, 1);
+
+    // Point the key reference in the second record outside of the key list
+    bool found = false;
+    for (uint32_t i = 0; i < buffer_used; ++i)
+    {
+        if (g_Buf[i] == 65 && g_Buf[i + 1] == LUA_TNUMBER && g_Buf[i + 2] == 0)
+        {
+            g_Buf[i + 2] = 10;
+            found = true;
+            break;
+        }
+    }
+    ASSERT_TRUE(found);
+
+    lua_pushcfunction(L, ParseTruncatedTable);
+    lua_pushlstring(L, g_Buf, sizeof(g_Buf));
+    lua_pushnumber(L, buffer_used);
+    ASSERT_EQ(LUA_ERRRUN, lua_pcall(L, 2, 0, 0x0));
+    lua_pop(L, 1);
+    ASSERT_EQ(top, lua_gettop(L));
+}
+
+// Benchmarks are not run by default, build with DM_TEST_BENCHMARKS defined to run them
+#if defined(DM_TEST_BENCHMARKS)
+// Compares the encoding and decoding of the version 4 and 5 table formats, for typical message sizes
+TEST_F(LuaTableTest, Benchmark)
+{
+    const uint32_t iterations = 10000;
+    const uint32_t buffer_size = 8 * 1024;
+    char* buf;
+    dmMemory::AlignedMalloc((void**)&buf, 16, buffer_size);
+
+    struct Case { const char* m_Name; int m_Count; int m_FieldCount; };
+    Case cases[] = { {"small (1x2)", 1, 2}, {"medium (4x8)", 4, 8}, {"large (64x4)", 64, 4} };
+    for (uint32_t c = 0; c < DM_ARRAY_SIZE(cases); ++c)
+    {
+        PushArrayOfRecords(L, cases[c].m_Count, cases[c].m_FieldCount);
+        for (uint32_t version = 4; version <= 5; ++version)
+        {
+            uint32_t size = 0;
+            uint64_t start = dmTime::GetTime();
+            for (uint32_t i = 0; i < iterations; ++i)
+            {
+                size = dmScript::CheckTableVersion(L, buf, buffer_size, -1, version);
+            }
+            uint64_t encode_time = dmTime::GetTime() - start;
+
+            start = dmTime::GetTime();
+            for (uint32_t i = 0; i < iterations; ++i)
+            {
+                dmScript::PushTable(L, buf, size);
+                lua_pop(L, 1);
+            }
+            uint64_t decode_time = dmTime::GetTime() - start;
+            printf("%-14s v%u: %5u bytes, encode %.3f us, decode %.3f us\n", cases[c].m_Name, version, size,
+                    encode_time / (double)iterations, decode_time / (double)iterations);
+        }
+        lua_pop(L, 1);
+    }
+
+    dmMemory::AlignedFree(buf);
+}
+#endif
+
 extern "C" void dmExportedSymbols();
 
 int main(int argc, char **argv)
@@ -17,6 +17,7 @@
 #include "test_script.h"
 
 #include <testmain/testmain.h>
+#include <dlib/time.h>
 
 struct TimerTestCallback
 {
@@ -706,6 +707,84 @@ TEST_F(ScriptTimerTest, TestKillTimers)
     dmScript::DeleteTimerWorld(timer_world);
 }
 
+struct ManyTimersCallback
+{
+    static uint32_t die_count;
+    static uint32_t repeat_count;
+
+    static void cb(dmScript::HTimerWorld timer_world, dmScript::TimerEventType event_type, dmScript::HTimer timer_handle, float time_elapsed, uintptr_t owner, uintptr_t userdata)
+    {
+        if (event_type == dmScript::TIMER_EVENT_TRIGGER_WILL_DIE)
+            ++die_count;
+        else if (event_type == dmScript::TIMER_EVENT_TRIGGER_WILL_REPEAT)
+            ++repeat_count;
+    }
+};
+
+uint32_t ManyTimersCallback::die_count = 0;
+uint32_t ManyTimersCallback::repeat_count = 0;
+
+// Benchmark with many concurrent timers where only a few of them fire each frame
+TEST_F(ScriptTimerTest, TestManyTimers)
+{
+    dmScript::HTimerWorld timer_world = dmScript::NewTimerWorld();
+
+    const uint32_t timer_count = 100000;
+    const uint32_t owner_count = 64;
+    const uint32_t frame_count = 600;
+    const float dt = 1.0f / 60.0f;
+
+    ManyTimersCallback::die_count = 0;
+    ManyTimersCallback::repeat_count = 0;
+
+    uint64_t start = dmTime::GetTime();
+    for (uint32_t i = 0; i < timer_count; ++i)
+    {
+        // Spread the timers over 20 seconds, and let every tenth timer repeat
+        float delay = 20.0f * (float)i / (float)timer_count;
+        bool repeat = (i % 10) == 0;
+        dmScript::HTimer handle = dmScript::AddTimer(timer_world, delay, repeat, ManyTimersCallback::cb, i % owner_count, 0x0);
+        ASSERT_NE(dmScript::INVALID_TIMER_HANDLE, handle);
+    }
+    uint64_t add_time = dmTime::GetTime() - start;
+    ASSERT_EQ(timer_count, GetAliveTimers(timer_world));
+
+    double time = 0.0;
+    start = dmTime::GetTime();
+    for (uint32_t i = 0; i < frame_count; ++i)
+    {
+        dmScript::UpdateTimers(timer_world, dt);
+        time += dt;
+    }
+    uint64_t update_time = dmTime::GetTime() - start;
+
+    // Every one-shot timer that has passed its delay has fired exactly once
+    uint32_t expected_die_count = 0;
+    for (uint32_t i = 0; i < timer_count; ++i)
+    {
+        float delay = 20.0f * (float)i / (float)timer_count;
+        if ((i % 10) != 0 && delay <= time)
+            ++expected_die_count;
+    }
+    ASSERT_EQ(expected_die_count, ManyTimersCallback::die_count);
+    ASSERT_LT(0u, ManyTimersCallback::repeat_count);
+
+    start = dmTime::GetTime();
+    uint32_t kill_count = 0;
+    for (uint32_t i = 0; i < owner_count; ++i)
+    {
+        kill_count += dmScript::KillTimers(timer_world, i);
+    }
+    uint64_t kill_time = dmTime::GetTime() - start;
+    ASSERT_EQ(timer_count - expected_die_count, kill_count);
+    ASSERT_EQ(0u, GetAliveTimers(timer_world));
+
+    printf("%u timers: add %.3f ms, update %.3f us/frame, kill %.3f ms\n", timer_count,
+            add_time / 1000.0, update_time / (double)frame_count, kill_time / 1000.0);
+
+    dmScript::DeleteTimerWorld(timer_world);
+}
+
 static dmScript::HTimer cb_callback_handle = dmScript::INVALID_TIMER_HANDLE;
 static uint32_t cb_callback_counter = 0u;
 static float cb_elapsed_time = 0.0f;
@@ -18,6 +18,8 @@
 #include "script.h"
 #include "script_vmath.h"
 #include "test_script.h"
+#include "../script_alloc.h"
+#include "../script_private.h"
 
 #include <testmain/testmain.h>
 #include <dlib/log.h>
@@ -373,6 +375,107 @@ TEST_F(ScriptVmathTest, TestVMathClamp)
     ASSERT_TRUE(RunFile(L, "test_script_vmath.luac"));
 }
 
+TEST_F(ScriptVmathTest, TestInPlace)
+{
+    ASSERT_TRUE(RunString(L,
+        "local a = vmath.vector3(1, 2, 3)\n"
+        "local b = vmath.vector3(4, 5, 6)\n"
+        "assert(vmath.add_to(a, a, b) == a)\n"
+        "assert(a == vmath.vector3(5, 7, 9))\n"
+        "assert(vmath.sub_to(a, a, b) == a)\n"
+        "assert(a == vmath.vector3(1, 2, 3))\n"
+        "assert(vmath.mul_to(a, b, 2) == a)\n"
+        "assert(a == vmath.vector3(8, 10, 12))\n"
+        "local v4 = vmath.vector4(1, 2, 3, 4)\n"
+        "vmath.add_to(v4, v4, vmath.vector4(1, 1, 1, 1))\n"
+        "assert(v4 == vmath.vector4(2, 3, 4, 5))\n"
+        "vmath.mul_to(v4, vmath.matrix4_translation(vmath.vector3(1, 2, 3)), vmath.vector4(0, 0, 0, 1))\n"
+        "assert(v4 == vmath.vector4(1, 2, 3, 1))\n"
+        "local q = vmath.quat()\n"
+        "local r = vmath.quat_rotation_z(1)\n"
+        "vmath.mul_to(q, q, r)\n"
+        "assert(q == r)\n"
+        "local m = vmath.matrix4()\n"
+        "vmath.mul_to(m, m, 2)\n"
+        "assert(m.m00 == 2 and m.m33 == 2)\n"
+        "assert(not pcall(vmath.add_to, a, a, v4))\n"
+        "assert(not pcall(vmath.mul_to, q, a, 2))\n"));
+
+    ASSERT_TRUE(RunString(L,
+        "function test_temporaries(n)\n"
+        "    local a = vmath.vector3(0, 0, 0)\n"
+        "    local b = vmath.vector3(1, 1, 1)\n"
+        "    for i = 1, n do a = a + b end\n"
+        "end\n"
+        "function test_in_place(n)\n"
+        "    local a = vmath.vector3(0, 0, 0)\n"
+        "    local b = vmath.vector3(1, 1, 1)\n"
+        "    for i = 1, n do vmath.add_to(a, a, b) end\n"
+        "end\n"));
+
+    dmScript::HLuaAllocator allocator = m_Context->m_LuaAllocator;
+    if (allocator == 0)
+    {
+        dmLogWarning("The lua state doesn't use the engine allocator, skipping allocation checks");
+        return;
+    }
+
+    const uint32_t n = 10000;
+    dmScript::LuaAllocatorStats before, after;
+
+    dmScript::GetLuaAllocatorStats(allocator, &before);
+    lua_getglobal(L, "test_temporaries");
+    lua_pushinteger(L, n);
+    ASSERT_EQ(0, dmScript::PCall(L, 1, 0));
+    dmScript::GetLuaAllocatorStats(allocator, &after);
+    // Every intermediate vector is a pooled allocation
+    ASSERT_LE(n, after.m_PooledAllocations - before.m_PooledAllocations);
+
+    dmScript::GetLuaAllocatorStats(allocator, &before);
+    lua_getglobal(L, "test_in_place");
+    lua_pushinteger(L, n);
+    ASSERT_EQ(0, dmScript::PCall(L, 1, 0));
+    dmScript::GetLuaAllocatorStats(allocator, &after);
+    // Only a few allocations, e.g. when the loop is compiled by the jit
+    ASSERT_GT(n / 100, after.m_Allocations - before.m_Allocations);
+}
+
+// Pages of the small block pool are returned to the system when their blocks are freed
+TEST(LuaAllocator, ReleasePages)
+{
+    if (!dmScript::IsLuaAllocatorSupported())
+    {
+        dmLogWarning("The lua runtime doesn't support the engine allocator, skipping test");
+        return;
+    }
+
+    dmScript::HLuaAllocator allocator = dmScript::NewLuaAllocator();
+    lua_State* L = lua_newstate(dmScript::LuaAllocatorAlloc, allocator);
+    ASSERT_NE((lua_State*)0, L);
+    luaL_openlibs(L);
+
+    dmScript::LuaAllocatorStats initial, peak, after;
+    lua_gc(L, LUA_GCCOLLECT, 0);
+    dmScript::GetLuaAllocatorStats(allocator, &initial);
+
+    ASSERT_EQ(0, luaL_dostring(L,
+        "objects = {}\n"
+        "for i = 1, 50000 do objects[i] = { i } end\n"));
+    dmScript::GetLuaAllocatorStats(allocator, &peak);
+    ASSERT_LT(initial.m_PoolSize + 1024 * 1024, peak.m_PoolSize);
+
+    ASSERT_EQ(0, luaL_dostring(L, "objects = nil"));
+    lua_gc(L, LUA_GCCOLLECT, 0);
+    dmScript::GetLuaAllocatorStats(allocator, &after);
+    // At most one page with unused blocks is kept per size class
+    ASSERT_GE(initial.m_PoolSize + 8 * 16 * 1024, after.m_PoolSize);
+
+    lua_close(L);
+    dmScript::GetLuaAllocatorStats(allocator, &after);
+    ASSERT_GE(8u * 16 * 1024, after.m_PoolSize);
+    dmScript::DeleteLuaAllocator(allocator);
+}
+
 extern "C" void dmExportedSymbols();
 
 int main(int argc, char **argv)
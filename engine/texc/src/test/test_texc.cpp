@@ -15,6 +15,7 @@
 #define JC_TEST_IMPLEMENTATION
 #include <jc_test/jc_test.h>
 #include <dlib/image.h>
+#include <dlib/time.h>
 #include <string.h> // memcmp
 
 #define STB_IMAGE_IMPLEMENTATION
@@ -498,6 +499,69 @@ TEST_P(TexcCompileTest, Encode)
 INSTANTIATE_TEST_CASE_P(TexcCompileTest, TexcCompileTest, jc_test_values_in(compile_info));
 
 
+// Only built when DM_TEST_BENCHMARKS is defined, the timings are too slow and noisy for the regular test run
+#if defined(DM_TEST_BENCHMARKS)
+struct BenchmarkInfo
+{
+    const char*             m_Name;
+    dmTexc::CompressionType m_CompressionType;
+    dmTexc::PixelFormat     m_OutputFormat;
+    uint32_t                m_Size;
+};
+
+// Reports the throughput of the full pipeline (premultiply, flip, mipmaps and encode), in megapixels of the base level per second
+TEST(TexcBenchmark, Throughput)
+{
+    const BenchmarkInfo infos[] =
+    {
+        {"DEFAULT RGBA8888", dmTexc::CT_DEFAULT, dmTexc::PF_R8G8B8A8, 2048},
+        {"DEFAULT RGB565", dmTexc::CT_DEFAULT, dmTexc::PF_R5G6B5, 2048},
+        {"BASIS_UASTC", dmTexc::CT_BASIS_UASTC, dmTexc::PF_RGBA_ASTC_4x4, 256},
+        {"BASIS_ETC1S", dmTexc::CT_BASIS_ETC1S, dmTexc::PF_RGBA_ETC2, 256},
+    };
+    const int thread_counts[] = {1, 4};
+
+    for (uint32_t i = 0; i < DM_ARRAY_SIZE(infos); ++i)
+    {
+        const BenchmarkInfo& info = infos[i];
+        uint32_t size = info.m_Size;
+        uint8_t* image = new uint8_t[size * size * 4];
+        for (uint32_t p = 0; p < size * size; ++p)
+        {
+            uint32_t x = p % size;
+            uint32_t y = p / size;
+            image[p*4+0] = (uint8_t)(x ^ y);
+            image[p*4+1] = (uint8_t)(x + y);
+            image[p*4+2] = (uint8_t)(x * y);
+            image[p*4+3] = (uint8_t)(255 - x);
+        }
+
+        for (uint32_t t = 0; t < DM_ARRAY_SIZE(thread_counts); ++t)
+        {
+            int num_threads = thread_counts[t];
+            dmTexc::HTexture texture = dmTexc::Create(info.m_Name, size, size, dmTexc::PF_R8G8B8A8, dmTexc::CS_SRGB, info.m_CompressionType, image);
+            ASSERT_NE(dmTexc::INVALID_TEXTURE, texture);
+            dmTexc::SetMaxThreads(texture, num_threads);
+
+            uint64_t start = dmTime::GetTime();
+            ASSERT_TRUE(dmTexc::PreMultiplyAlpha(texture));
+            ASSERT_TRUE(dmTexc::Flip(texture, dmTexc::FLIP_AXIS_Y));
+            ASSERT_TRUE(dmTexc::GenMipMaps(texture));
+            ASSERT_TRUE(dmTexc::Encode(texture, info.m_OutputFormat, dmTexc::CS_SRGB, dmTexc::CL_FAST, info.m_CompressionType, true, num_threads));
+            uint64_t end = dmTime::GetTime();
+
+            float seconds = (end - start) / 1000000.0f;
+            float megapixels = (size * size) / 1000000.0f;
+            printf("%-18s %4u x %-4u  threads: %d  %8.2f ms  %8.2f MP/s\n", info.m_Name, size, size, num_threads, seconds * 1000.0f, megapixels / seconds);
+
+            dmTexc::Destroy(texture);
+        }
+
+        delete[] image;
+    }
+}
+#endif
+
 int main(int argc, char **argv)
 {
     jc_test_init(&argc, argv);
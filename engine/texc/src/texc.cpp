@@ -49,6 +49,8 @@ namespace dmTexc
         }
 
         t->m_CompressionType = compression_type;
+        t->m_JobPool = 0;
+        t->m_NumThreads = 1;
         if (!t->m_Encoder.m_FnCreate(t, width, height, pixel_format, color_space, compression_type, data))
         {
             delete t;
@@ -73,6 +75,7 @@ namespace dmTexc
         Texture* t = (Texture *) texture;
         free((void*)t->m_Name);
         t->m_Encoder.m_FnDestroy(t);
+        delete t->m_JobPool;
         delete t;
     }
 
@@ -143,18 +146,10 @@ namespace dmTexc
         return t->m_Encoder.m_FnFlip(t, flip_axis);
     }
 
-    static uint32_t GetNumThreads(int max_threads)
+    void SetMaxThreads(HTexture texture, int max_threads)
     {
-        uint32_t num_threads = max_threads;
-        if (max_threads > 1)
-        {
-            num_threads = std::thread::hardware_concurrency();
-            if (num_threads < 1)
-                num_threads = 1;
-            if (num_threads > max_threads)
-                num_threads = max_threads;
-        }
-        return num_threads;
+        Texture* t = (Texture*) texture;
+        SetNumThreads(t, GetNumThreads(max_threads));
     }
 
     bool Encode(HTexture texture, PixelFormat pixel_format, ColorSpace color_space,
@@ -163,6 +158,7 @@ namespace dmTexc
         Texture* t = (Texture*) texture;
 
         uint32_t num_threads = GetNumThreads(max_threads);
+        SetNumThreads(t, num_threads);
         return t->m_Encoder.m_FnEncode(t, num_threads, pixel_format, compression_type, compression_level);
     }
 
@@ -225,6 +221,7 @@ namespace dmTexc
     DM_TEXC_TRAMPOLINE1(bool, PreMultiplyAlpha, HTexture);
     DM_TEXC_TRAMPOLINE1(bool, GenMipMaps, HTexture);
     DM_TEXC_TRAMPOLINE2(bool, Flip, HTexture, FlipAxis);
+    DM_TEXC_TRAMPOLINE2(void, SetMaxThreads, HTexture, int);
     DM_TEXC_TRAMPOLINE7(bool, Encode, HTexture, PixelFormat, ColorSpace, CompressionLevel, CompressionType, bool, int);
     DM_TEXC_TRAMPOLINE2(HBuffer, CompressBuffer, void*, uint32_t);
     DM_TEXC_TRAMPOLINE1(uint32_t, GetTotalBufferDataSize, HBuffer);
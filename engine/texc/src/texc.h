@@ -186,6 +186,11 @@ namespace dmTexc
      * Flips a texture vertically
      */
     DM_TEXC_PROTO(bool, Flip, HTexture texture, FlipAxis flip_axis);
+    /**
+     * Set the max number of threads used by PreMultiplyAlpha, GenMipMaps and Flip (default 1).
+     * Encode uses its own max_threads argument.
+     */
+    DM_TEXC_PROTO(void, SetMaxThreads, HTexture texture, int max_threads);
     /**
      * Encode a texture into basis format.
      */
@@ -278,26 +278,14 @@ namespace dmTexc
         uint32_t h = texture->m_BasisImage.get_height();
         basisu::color_rgba* pixels = texture->m_BasisImage.get_ptr();
 
-        PreMultiplyAlpha((uint8_t*)pixels, w, h);
+        PreMultiplyAlpha(texture, (uint8_t*)pixels, w, h);
         return true;
     }
 
     bool FlipBasis(Texture* texture, FlipAxis flip_axis)
     {
         basisu::color_rgba* pixels = texture->m_BasisImage.get_ptr();
-        switch(flip_axis)
-        {
-        case FLIP_AXIS_Y:   FlipImageY_RGBA8888((uint32_t*)pixels, texture->m_Width, texture->m_Height);
-                            return true;
-        case FLIP_AXIS_X:   FlipImageX_RGBA8888((uint32_t*)pixels, texture->m_Width, texture->m_Height);
-                            return true;
-        default:
-            dmLogError("Unexpected flip direction: %d", flip_axis);
-            return false;
-        }
-
-        dmLogError("Unexpected flip direction: %d", flip_axis);
-        return false;
+        return FlipImage_RGBA8888(texture, (uint32_t*)pixels, texture->m_Width, texture->m_Height, flip_axis);
     }
 
 
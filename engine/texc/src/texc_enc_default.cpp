@@ -30,10 +30,33 @@
 
 namespace dmTexc
 {
+    struct EncodeJobContext
+    {
+        TextureData* m_MipLevel;
+        uint8_t*     m_PackedData;
+        PixelFormat  m_PixelFormat;
+    };
+
+    static void EncodeRows(void* _ctx, uint32_t begin, uint32_t end)
+    {
+        EncodeJobContext* ctx = (EncodeJobContext*)_ctx;
+        TextureData* mip_level = ctx->m_MipLevel;
+        uint32_t width = mip_level->m_Width;
+
+        if (ctx->m_PixelFormat == PF_R4G4B4A4) {
+            DitherRowsRGBA4444(mip_level->m_Data, width, begin, end);
+        }
+        else if(ctx->m_PixelFormat == PF_R5G6B5) {
+            DitherRowsRGBx565(mip_level->m_Data, width, begin, end);
+        }
+
+        ConvertRGBA8888ToPf(mip_level->m_Data + begin * width * 4, width, end - begin, ctx->m_PixelFormat,
+                            ctx->m_PackedData + GetDataSize(ctx->m_PixelFormat, width, begin));
+    }
+
     static bool EncodeDefault(Texture* texture, int num_threads, PixelFormat pixel_format, CompressionType compression_type, CompressionLevel compression_level)
     {
-        // static int image = 0;
-        // ++image;
+        (void)num_threads; // The job pool of the texture is already set up by Encode()
 
         for (uint32_t i = 0; i < texture->m_Mips.Size(); ++i)
         {
@@ -41,25 +64,14 @@ namespace dmTexc
             uint32_t size = GetDataSize(pixel_format, mip_level->m_Width, mip_level->m_Height);
             uint8_t* packed_data = new uint8_t[size];
 
-            if (pixel_format == PF_R4G4B4A4) {
-                DitherRGBA4444(mip_level->m_Data, mip_level->m_Width, mip_level->m_Height);
-            }
-            else if(pixel_format == PF_R5G6B5) {
-                DitherRGBx565(mip_level->m_Data, mip_level->m_Width, mip_level->m_Height);
-            }
-
-            ConvertRGBA8888ToPf(mip_level->m_Data, mip_level->m_Width, mip_level->m_Height, pixel_format, packed_data);
+            // Each row is dithered and converted independently, so the larger levels are split into bands of rows
+            EncodeJobContext ctx = { mip_level, packed_data, pixel_format };
+            ParallelFor(texture, mip_level->m_Height, dmMath::Max(1U, MIN_JOB_PIXELS / mip_level->m_Width), EncodeRows, &ctx);
 
             uint8_t* old_data = mip_level->m_Data;
             mip_level->m_Data = packed_data;
             mip_level->m_ByteSize = size;
 
-            // char name[256];
-            // // dmSnPrintf(name, sizeof(name), "../mipimages_enc_default_stb/image%d_mip%02u.png", image, i);
-            // dmSnPrintf(name, sizeof(name), "../mipimages_enc_default_basis/image%d_mip%02u.png", image, i);
-            // int result = stbi_write_png(name, mip_level->m_Width, mip_level->m_Height, 4, (void*)mip_level->m_Data, mip_level->m_Width*4);
-            // printf("Wrote %s\n", name);
-
             delete[] old_data;
         }
 
@@ -102,32 +114,30 @@ namespace dmTexc
         }
     }
 
-    static uint8_t* GenMipMapDefault(Texture* texture, int miplevel, const basisu::image& origimage, uint32_t mip_width, uint32_t mip_height, ColorSpace color_space)
+    static void GenMipMapDefault(const basisu::image& origimage, TextureData* mip_level)
     {
-        (void)texture;
-        (void)miplevel;
-        uint32_t num_channels = 4;
-        uint32_t size = mip_width * mip_height * num_channels;
-        uint8_t* mip_data = new uint8_t[mip_width * mip_height * num_channels];
-
-        basisu::image mipimage(mip_width, mip_height);
+        basisu::image mipimage(mip_level->m_Width, mip_level->m_Height);
 
         bool srgb = false;
         const char* filter = "tent";
         basisu::image_resample(origimage, mipimage, srgb, filter);
 
-        basisu::color_rgba* basisimage = mipimage.get_ptr();
-        memcpy(mip_data, basisimage, size);
-
-        // char name[256];
-        // stbi_flip_vertically_on_write(true);
-        // dmSnPrintf(name, sizeof(name), "/Users/mawe/work/projects/users/mawe/TextureCompression/mipmaps/%s_mip%02d_%s.png", texture->m_Name?texture->m_Name:"unknown", miplevel, filter);
-        // int result = stbi_write_png(name, mip_width, mip_height, 4, (void*)mip_data, mip_width*4);
+        memcpy(mip_level->m_Data, mipimage.get_ptr(), mip_level->m_ByteSize);
+    }
 
-        // stbi_flip_vertically_on_write(false);
-        // printf("Wrote %s\n", name);
+    struct MipMapJobContext
+    {
+        basisu::image* m_OrigImage;
+        TextureData*   m_MipLevels;
+    };
 
-        return mip_data;
+    static void GenMipMapRange(void* _ctx, uint32_t begin, uint32_t end)
+    {
+        MipMapJobContext* ctx = (MipMapJobContext*)_ctx;
+        for (uint32_t i = begin; i < end; ++i)
+        {
+            GenMipMapDefault(*ctx->m_OrigImage, &ctx->m_MipLevels[i]);
+        }
     }
 
     static bool GenMipMapsDefault(Texture* texture)
@@ -141,7 +151,8 @@ namespace dmTexc
         basisu::image origimage;
         origimage.init(mip0, width, height, 4);
 
-        int level = 0;
+        // Allocate all levels up front. Each level is resampled from the original image,
+        // so the levels don't depend on each other and are generated in parallel
         while (width * height != 1)
         {
             width /= 2;
@@ -149,17 +160,17 @@ namespace dmTexc
             width = dmMath::Max(1U, width);
             height = dmMath::Max(1U, height);
 
-            uint8_t* mipmap = GenMipMapDefault(texture, level, origimage, width, height, texture->m_ColorSpace);
-            level++;
-
             TextureData mip_level;
             mip_level.m_Width = width;
             mip_level.m_Height = height;
-            mip_level.m_Data = mipmap;
             mip_level.m_ByteSize = width * height * 4;
+            mip_level.m_Data = new uint8_t[mip_level.m_ByteSize];
             mip_level.m_IsCompressed = false;
             texture->m_Mips.Push(mip_level);
         }
+
+        MipMapJobContext ctx = { &origimage, texture->m_Mips.Begin() + 1 };
+        ParallelFor(texture, texture->m_Mips.Size() - 1, 1, GenMipMapRange, &ctx);
         return true;
     }
 
@@ -220,23 +231,14 @@ namespace dmTexc
     {
         // Do we need to check for alpha?
         TextureData* mip_level = &texture->m_Mips[0];
-        PreMultiplyAlpha(mip_level->m_Data, texture->m_Width, texture->m_Height);
+        PreMultiplyAlpha(texture, mip_level->m_Data, texture->m_Width, texture->m_Height);
         return true;
     }
 
     static bool FlipDefault(Texture* texture, FlipAxis flip_axis)
     {
         TextureData* mip_level = &texture->m_Mips[0];
-        switch(flip_axis)
-        {
-        case FLIP_AXIS_Y:   FlipImageY_RGBA8888((uint32_t*)mip_level->m_Data, texture->m_Width, texture->m_Height);
-                            return true;
-        case FLIP_AXIS_X:   FlipImageX_RGBA8888((uint32_t*)mip_level->m_Data, texture->m_Width, texture->m_Height);
-                            return true;
-        default:
-            dmLogError("Unexpected flip direction: %d", flip_axis);
-            return false;
-        }
+        return FlipImage_RGBA8888(texture, (uint32_t*)mip_level->m_Data, texture->m_Width, texture->m_Height, flip_axis);
     }
 
     static bool GetHeaderDefault(Texture* texture, Header* out_header)
@@ -18,6 +18,12 @@
 #include "texc.h"
 #include "texc_private.h"
 #include <dlib/log.h>
+#include <dlib/math.h>
+#include <string.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
 
 namespace dmTexc
 {
@@ -206,17 +212,48 @@ namespace dmTexc
         }
     }
 
+    // Exact for v in [0, 255*255], and doesn't need a division
+    static inline uint32_t DivideBy255(uint32_t v)
+    {
+        return (v + 1 + (v >> 8)) >> 8;
+    }
+
     void PreMultiplyAlpha(uint8_t* data, const uint32_t width, const uint32_t height)
     {
-        // If this is an issue, we could simd it
-        // e.g (v6) https://github.com/Wizermil/premultiply_alpha/blob/master/premultiply_alpha/premultiply_alpha.hpp
+        uint32_t count = width*height;
+        uint32_t i = 0;
+
+#if defined(__SSE2__)
+        // Four pixels at a time, with the pixels widened to 16 bits per channel.
+        // The alpha channel is multiplied with 255 to keep its value.
+        const __m128i zero = _mm_setzero_si128();
+        const __m128i one = _mm_set1_epi16(1);
+        const __m128i alpha_mask = _mm_set_epi16(255, 0, 0, 0, 255, 0, 0, 0);
+        for (; i + 4 <= count; i += 4)
+        {
+            __m128i pixels = _mm_loadu_si128((const __m128i*)data);
+            __m128i lo = _mm_unpacklo_epi8(pixels, zero);
+            __m128i hi = _mm_unpackhi_epi8(pixels, zero);
+
+            __m128i alpha_lo = _mm_or_si128(_mm_shufflehi_epi16(_mm_shufflelo_epi16(lo, _MM_SHUFFLE(3,3,3,3)), _MM_SHUFFLE(3,3,3,3)), alpha_mask);
+            __m128i alpha_hi = _mm_or_si128(_mm_shufflehi_epi16(_mm_shufflelo_epi16(hi, _MM_SHUFFLE(3,3,3,3)), _MM_SHUFFLE(3,3,3,3)), alpha_mask);
+
+            lo = _mm_mullo_epi16(lo, alpha_lo);
+            hi = _mm_mullo_epi16(hi, alpha_hi);
+            lo = _mm_srli_epi16(_mm_add_epi16(_mm_add_epi16(lo, one), _mm_srli_epi16(lo, 8)), 8);
+            hi = _mm_srli_epi16(_mm_add_epi16(_mm_add_epi16(hi, one), _mm_srli_epi16(hi, 8)), 8);
+
+            _mm_storeu_si128((__m128i*)data, _mm_packus_epi16(lo, hi));
+            data += 16;
+        }
+#endif
 
-        for (uint32_t i = 0; i < width*height; ++i)
+        for (; i < count; ++i)
         {
             uint32_t a = data[3];
-            data[0] = (uint8_t)( (data[0] * a) / 255 );
-            data[1] = (uint8_t)( (data[1] * a) / 255 );
-            data[2] = (uint8_t)( (data[2] * a) / 255 );
+            data[0] = (uint8_t)DivideBy255(data[0] * a);
+            data[1] = (uint8_t)DivideBy255(data[1] * a);
+            data[2] = (uint8_t)DivideBy255(data[2] * a);
             data += 4;
         }
     }
@@ -225,30 +262,157 @@ namespace dmTexc
     {
         for (uint32_t y = 0; y < height; ++y)
         {
-            for (uint32_t x = 0; x < width/2; ++x)
+            uint32_t* left = data + y * width;
+            uint32_t* right = left + width;
+            uint32_t x = 0;
+
+#if defined(__SSE2__)
+            // Swap four pixels from each end at a time
+            for (; 2 * x + 8 <= width; x += 4)
             {
-                uint32_t x2 = width - x - 1;
-                uint32_t rgba = data[x + y * width];
-                data[x + y * width] = data[x2 + y * width];
-                data[x2 + y * width] = rgba;
+                right -= 4;
+                __m128i l = _mm_loadu_si128((const __m128i*)left);
+                __m128i r = _mm_loadu_si128((const __m128i*)right);
+                _mm_storeu_si128((__m128i*)left, _mm_shuffle_epi32(r, _MM_SHUFFLE(0,1,2,3)));
+                _mm_storeu_si128((__m128i*)right, _mm_shuffle_epi32(l, _MM_SHUFFLE(0,1,2,3)));
+                left += 4;
+            }
+#endif
+
+            for (; x < width/2; ++x)
+            {
+                --right;
+                uint32_t rgba = *left;
+                *left = *right;
+                *right = rgba;
+                ++left;
             }
         }
     }
 
-    void FlipImageY_RGBA8888(uint32_t* data, const uint32_t width, const uint32_t height)
+    void FlipImageYRows_RGBA8888(uint32_t* data, const uint32_t width, const uint32_t height, uint32_t y_begin, uint32_t y_end)
     {
-        for (uint32_t y = 0; y < height/2; ++y)
+        uint32_t tmp[256];
+        for (uint32_t y = y_begin; y < y_end; ++y)
         {
-            uint32_t y2 = height - y - 1;
-            for (uint32_t x = 0; x < width; ++x)
+            uint32_t* row1 = data + y * width;
+            uint32_t* row2 = data + (height - y - 1) * width;
+            // Swap the rows through a small buffer, to let memcpy do the wide loads and stores
+            for (uint32_t x = 0; x < width; x += DM_ARRAY_SIZE(tmp))
             {
-                uint32_t rgba = data[x + y * width];
-                data[x + y * width] = data[x + y2 * width];
-                data[x + y2 * width] = rgba;
+                uint32_t size = dmMath::Min(width - x, (uint32_t)DM_ARRAY_SIZE(tmp)) * sizeof(uint32_t);
+                memcpy(tmp, row1 + x, size);
+                memcpy(row1 + x, row2 + x, size);
+                memcpy(row2 + x, tmp, size);
             }
         }
     }
 
+    void FlipImageY_RGBA8888(uint32_t* data, const uint32_t width, const uint32_t height)
+    {
+        FlipImageYRows_RGBA8888(data, width, height, 0, height/2);
+    }
+
+    uint32_t GetNumThreads(int max_threads)
+    {
+        uint32_t num_threads = max_threads;
+        if (max_threads > 1)
+        {
+            num_threads = std::thread::hardware_concurrency();
+            if (num_threads < 1)
+                num_threads = 1;
+            if (num_threads > max_threads)
+                num_threads = max_threads;
+        }
+        return num_threads;
+    }
+
+    void SetNumThreads(Texture* texture, uint32_t num_threads)
+    {
+        if (texture->m_NumThreads == num_threads)
+            return;
+        delete texture->m_JobPool;
+        texture->m_JobPool = 0;
+        texture->m_NumThreads = num_threads;
+    }
+
+    void ParallelFor(Texture* texture, uint32_t count, uint32_t min_range, RangeFn fn, void* ctx)
+    {
+        if (count == 0)
+            return;
+
+        uint32_t num_ranges = 1;
+        if (texture->m_NumThreads > 1)
+        {
+            // A few ranges per thread, to even out the work when the ranges aren't equally expensive
+            num_ranges = dmMath::Min(texture->m_NumThreads * 4, (count + min_range - 1) / dmMath::Max(min_range, 1U));
+        }
+
+        if (num_ranges <= 1)
+        {
+            fn(ctx, 0, count);
+            return;
+        }
+
+        if (!texture->m_JobPool)
+            texture->m_JobPool = new basisu::job_pool(texture->m_NumThreads);
+
+        uint32_t range = (count + num_ranges - 1) / num_ranges;
+        for (uint32_t begin = 0; begin < count; begin += range)
+        {
+            uint32_t end = dmMath::Min(begin + range, count);
+            texture->m_JobPool->add_job([fn, ctx, begin, end]() { fn(ctx, begin, end); });
+        }
+        texture->m_JobPool->wait_for_all();
+    }
+
+    struct ImageJobContext
+    {
+        uint8_t* m_Data;
+        uint32_t m_Width;
+        uint32_t m_Height;
+    };
+
+    static void PreMultiplyAlphaRange(void* _ctx, uint32_t begin, uint32_t end)
+    {
+        ImageJobContext* ctx = (ImageJobContext*)_ctx;
+        PreMultiplyAlpha(ctx->m_Data + begin * 4, end - begin, 1);
+    }
+
+    static void FlipImageXRange(void* _ctx, uint32_t begin, uint32_t end)
+    {
+        ImageJobContext* ctx = (ImageJobContext*)_ctx;
+        FlipImageX_RGBA8888((uint32_t*)ctx->m_Data + begin * ctx->m_Width, ctx->m_Width, end - begin);
+    }
+
+    static void FlipImageYRange(void* _ctx, uint32_t begin, uint32_t end)
+    {
+        ImageJobContext* ctx = (ImageJobContext*)_ctx;
+        FlipImageYRows_RGBA8888((uint32_t*)ctx->m_Data, ctx->m_Width, ctx->m_Height, begin, end);
+    }
+
+    void PreMultiplyAlpha(Texture* texture, uint8_t* data, const uint32_t width, const uint32_t height)
+    {
+        ImageJobContext ctx = { data, width, height };
+        ParallelFor(texture, width * height, MIN_JOB_PIXELS, PreMultiplyAlphaRange, &ctx);
+    }
+
+    bool FlipImage_RGBA8888(Texture* texture, uint32_t* data, const uint32_t width, const uint32_t height, FlipAxis flip_axis)
+    {
+        ImageJobContext ctx = { (uint8_t*)data, width, height };
+        uint32_t min_rows = dmMath::Max(1U, MIN_JOB_PIXELS / dmMath::Max(width, 1U));
+        switch(flip_axis)
+        {
+        case FLIP_AXIS_Y:   ParallelFor(texture, height/2, min_rows, FlipImageYRange, &ctx);
+                            return true;
+        case FLIP_AXIS_X:   ParallelFor(texture, height, min_rows, FlipImageXRange, &ctx);
+                            return true;
+        default:
+            dmLogError("Unexpected flip direction: %d", flip_axis);
+            return false;
+        }
+    }
+
     bool HasAlpha(PixelFormat pf)
     {
         switch(pf)
@@ -362,13 +526,19 @@ namespace dmTexc
     }
 
     void DitherRGBA4444(uint8_t* data, uint32_t width, uint32_t height)
+    {
+        DitherRowsRGBA4444(data, width, 0, height);
+    }
+
+    void DitherRowsRGBA4444(uint8_t* data, uint32_t width, uint32_t y_begin, uint32_t y_end)
     {
         // Since we are going to convert this data to rgba4444 we the minimal value for a
         // color change is 2^8 / 2^4 = 16
         uint8_t bpp_mul = 16;
         uint8_t bpp_bias = bpp_mul / 2;
 
-        for (uint32_t y = 0; y < height; ++y)
+        data += y_begin * width * 4;
+        for (uint32_t y = y_begin; y < y_end; ++y)
         {
             for (uint32_t x = 0; x < width; ++x)
             {
@@ -383,6 +553,11 @@ namespace dmTexc
     }
 
     void DitherRGBx565(uint8_t* data, uint32_t width, uint32_t height)
+    {
+        DitherRowsRGBx565(data, width, 0, height);
+    }
+
+    void DitherRowsRGBx565(uint8_t* data, uint32_t width, uint32_t y_begin, uint32_t y_end)
     {
         // Since we are going to convert this data to rgba4444 we the minimal value for a color change is
         uint8_t bpp_mul_5 = 8; // (1<<8)/(1<<5)
@@ -390,7 +565,8 @@ namespace dmTexc
         uint8_t bpp_mul_6 = 4; // (1<<8)/(1<<6)
         uint8_t bpp_bias_6 = bpp_mul_6 / 2;
 
-        for (uint32_t y = 0; y < height; ++y)
+        data += y_begin * width * 4;
+        for (uint32_t y = y_begin; y < y_end; ++y)
         {
             for (uint32_t x = 0; x < width; ++x)
             {
@@ -28,6 +28,7 @@
 namespace dmTexc
 {
     static const uint32_t COMPRESSION_ENABLED_PIXELCOUNT_THRESHOLD = 64; // do not compress mips with less than this pixelcount
+    static const uint32_t MIN_JOB_PIXELS = 64 * 1024; // do not split the processing of an image into jobs smaller than this pixelcount
 
     struct Texture;
 
@@ -71,8 +72,22 @@ namespace dmTexc
         basisu::image m_BasisImage; // Original image
         dmArray<uint8_t> m_BasisFile;
         bool m_BasisGenMipmaps;
+
+        // Used by the processing steps to split the work into jobs. Created on demand when m_NumThreads > 1
+        basisu::job_pool* m_JobPool;
+        uint32_t m_NumThreads;
     };
 
+    // Called with a range [begin, end) of the items passed to ParallelFor
+    typedef void (*RangeFn)(void* ctx, uint32_t begin, uint32_t end);
+
+    uint32_t GetNumThreads(int max_threads);
+    void     SetNumThreads(Texture* texture, uint32_t num_threads);
+
+    // Splits [0, count) into ranges of at least min_range items and processes them on the job pool of the texture.
+    // Returns when all ranges are processed. Must not be called from within a range function.
+    void     ParallelFor(Texture* texture, uint32_t count, uint32_t min_range, RangeFn fn, void* ctx);
+
 
     uint16_t RGB888ToRGB565(uint8_t red, uint8_t green, uint8_t blue);
     uint16_t RGBA8888ToRGBA4444(uint8_t red, uint8_t green, uint8_t blue, uint8_t alpha);
@@ -88,6 +103,12 @@ namespace dmTexc
     void PreMultiplyAlpha(uint8_t* data, const uint32_t width, const uint32_t height);
     void FlipImageX_RGBA8888(uint32_t* data, const uint32_t width, const uint32_t height);
     void FlipImageY_RGBA8888(uint32_t* data, const uint32_t width, const uint32_t height);
+    // Swaps the rows [y_begin, y_end) with their mirrored rows. The range must be within the upper half of the image
+    void FlipImageYRows_RGBA8888(uint32_t* data, const uint32_t width, const uint32_t height, uint32_t y_begin, uint32_t y_end);
+
+    // The processing steps above, split into jobs on the job pool of the texture
+    void PreMultiplyAlpha(Texture* texture, uint8_t* data, const uint32_t width, const uint32_t height);
+    bool FlipImage_RGBA8888(Texture* texture, uint32_t* data, const uint32_t width, const uint32_t height, FlipAxis flip_axis);
 
     uint32_t    GetDataSize(PixelFormat pf, uint32_t width, uint32_t height);
     bool        ConvertToRGBA8888(const uint8_t* data, const uint32_t width, const uint32_t height, PixelFormat pf, uint8_t* out);
@@ -99,6 +120,9 @@ namespace dmTexc
     // Dithers an image where the target format is RGB565
     // Input/output image is RGBA8888
     void        DitherRGBx565(uint8_t* data, uint32_t width, uint32_t height);
+    // Dithers the rows [y_begin, y_end) of an image, `data` points to the first row of the image
+    void        DitherRowsRGBA4444(uint8_t* data, uint32_t width, uint32_t y_begin, uint32_t y_end);
+    void        DitherRowsRGBx565(uint8_t* data, uint32_t width, uint32_t y_begin, uint32_t y_end);
 
     void        DebugPrint(uint8_t* p, uint32_t width, uint32_t height, uint32_t num_channels);
 }